@@ -74,6 +74,9 @@ typedef struct SSmlSqlInsertBatch {
 
 #define MAX_SML_SQL_INSERT_BATCHES 512
 
+// put the points into the submit blocks directly instead of the sql statements if the meta is in the local cache
+extern bool gSmlNativeSubmit;
+
 typedef struct {
   uint64_t id;
   SMLProtocolType protocol;
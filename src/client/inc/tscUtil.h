@@ -91,6 +91,8 @@ typedef struct SJoinSupporter {
   int32_t         totalLen;
   int32_t         num;
   SArray*         pVgroupTables;
+  SArray*         pJoinVgroupTables;  // tables of the other side, if the join is done in the vnodes
+  uint64_t        localJoinId;
 
   int16_t          fillType;      // final result fill type
   int64_t *        fillVal;       // default value for fill
@@ -439,6 +439,8 @@ void tscInitMsgsFp();
 
 void *tscAcquireClusterInfo(const char *clusterId);
 void tscReleaseClusterInfo(const char *clusterId);
+void tscLoadMetaCache(SClusterInfo *pObj, const char *clusterId);
+void tscSaveMetaCache(SClusterInfo *pObj, const char *clusterId);
 
 int tsParseSql(SSqlObj *pSql, bool initial);
 
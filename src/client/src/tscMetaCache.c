@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "hash.h"
+#include "tchecksum.h"
+#include "tglobal.h"
+#include "tscLog.h"
+#include "tscUtil.h"
+#include "tsclient.h"
+
+/*
+ * Snapshot of the table meta and vgroup info cached for a cluster, so that a restarted client does not fetch them from
+ * mnode again. The file is dropped as a whole if it is not written by the same client version for the same cluster.
+ * The entries themselves may be out of date, they are refreshed the same way as the cached ones when the vnode
+ * reports a version mismatch.
+ *
+ * layout: SMetaCacheHead | SNewVgroupInfo * numOfVgroups | (keyLen, valLen, key, val) * numOfMetas | checksum
+ */
+
+#define TSC_META_CACHE_MAGIC 0x434d4454  // "TDMC"
+#define TSC_META_CACHE_VER   1
+
+typedef struct {
+  int32_t  magic;
+  int32_t  ver;
+  uint32_t clientVer;
+  int32_t  numOfVgroups;
+  int32_t  numOfMetas;
+  int32_t  reserved;
+  char     clusterId[TSDB_CLUSTER_ID_LEN];
+} SMetaCacheHead;
+
+static void tscGetMetaCacheFile(const char *clusterId, char *fname, int32_t len) {
+  snprintf(fname, len, "%s/meta-%s.cache", tsMetaCacheDir, clusterId);
+}
+
+static int32_t tscGetCachedMetaSize(STableMeta *pTableMeta) {
+  if (pTableMeta->tableType == TSDB_CHILD_TABLE) {
+    return sizeof(CChildTableMeta);
+  }
+
+  return tscGetTableMetaSize(pTableMeta);
+}
+
+static bool tscWriteMetaCache(FILE *fp, TSCKSUM *cksum, void *buf, size_t len) {
+  *cksum = taosCalcChecksum(*cksum, buf, (uint32_t)len);
+  return fwrite(buf, 1, len, fp) == len;
+}
+
+void tscSaveMetaCache(SClusterInfo *pObj, const char *clusterId) {
+  if (tsMetaCacheDir[0] == 0 || pObj == NULL) return;
+
+  char fname[PATH_MAX] = {0};
+  char tname[PATH_MAX + 32] = {0};
+  tscGetMetaCacheFile(clusterId, fname, sizeof(fname));
+  snprintf(tname, sizeof(tname), "%s.%" PRId64, fname, taosGetSelfPthreadId());
+
+  FILE *fp = fopen(tname, "wb");
+  if (fp == NULL) {
+    tscError("failed to open meta cache file:%s for write, reason:%s", tname, strerror(errno));
+    return;
+  }
+
+  int64_t        st = taosGetTimestampMs();
+  TSCKSUM        cksum = 0;
+  bool           ok = true;
+  SMetaCacheHead head = {.magic = TSC_META_CACHE_MAGIC, .ver = TSC_META_CACHE_VER, .clientVer = tsVersion};
+  tstrncpy(head.clusterId, clusterId, sizeof(head.clusterId));
+
+  // the counts are filled in after the entries are written, the maps may be changed by other threads in between
+  ok = ok && fwrite(&head, sizeof(head), 1, fp) == 1;
+
+  SNewVgroupInfo *pVgroup = taosHashIterate(pObj->vgroupMap, NULL);
+  while (ok && pVgroup != NULL) {
+    ok = tscWriteMetaCache(fp, &cksum, pVgroup, sizeof(SNewVgroupInfo));
+    head.numOfVgroups++;
+    pVgroup = taosHashIterate(pObj->vgroupMap, pVgroup);
+  }
+  taosHashCancelIterate(pObj->vgroupMap, pVgroup);
+
+  STableMeta *pMeta = taosHashIterate(pObj->tableMetaMap, NULL);
+  while (ok && pMeta != NULL) {
+    int32_t lens[2] = {(int32_t)taosHashGetDataKeyLen(pObj->tableMetaMap, pMeta), tscGetCachedMetaSize(pMeta)};
+    ok = tscWriteMetaCache(fp, &cksum, lens, sizeof(lens)) &&
+         tscWriteMetaCache(fp, &cksum, taosHashGetDataKey(pObj->tableMetaMap, pMeta), lens[0]) &&
+         tscWriteMetaCache(fp, &cksum, pMeta, lens[1]);
+    head.numOfMetas++;
+    pMeta = taosHashIterate(pObj->tableMetaMap, pMeta);
+  }
+  taosHashCancelIterate(pObj->tableMetaMap, pMeta);
+
+  cksum = taosCalcChecksum(cksum, (uint8_t *)&head, sizeof(head));
+  ok = ok && fwrite(&cksum, sizeof(cksum), 1, fp) == 1;
+  ok = ok && fseek(fp, 0, SEEK_SET) == 0 && fwrite(&head, sizeof(head), 1, fp) == 1;
+  ok = (fclose(fp) == 0) && ok;
+
+  if (!ok || taosRename(tname, fname) != 0) {
+    tscError("failed to save meta cache file:%s, reason:%s", fname, strerror(errno));
+    remove(tname);
+    return;
+  }
+
+  tscDebug("meta cache saved into %s, vgroups:%d tables:%d, elapsed time:%" PRId64 "ms", fname, head.numOfVgroups,
+           head.numOfMetas, taosGetTimestampMs() - st);
+}
+
+static int32_t tscRestoreMetaCache(SClusterInfo *pObj, const char *clusterId, char *buf, int64_t size) {
+  if (size < (int64_t)(sizeof(SMetaCacheHead) + sizeof(TSCKSUM))) return -1;
+
+  SMetaCacheHead *pHead = (SMetaCacheHead *)buf;
+  if (pHead->magic != TSC_META_CACHE_MAGIC || pHead->ver != TSC_META_CACHE_VER || pHead->clientVer != tsVersion ||
+      strncmp(pHead->clusterId, clusterId, sizeof(pHead->clusterId)) != 0) {
+    return -1;
+  }
+
+  // the head is put at the end of the checksum since it is written last
+  char   *pCont = buf + sizeof(SMetaCacheHead);
+  int64_t contLen = size - sizeof(SMetaCacheHead) - sizeof(TSCKSUM);
+  TSCKSUM cksum = taosCalcChecksum(0, (uint8_t *)pCont, (uint32_t)contLen);
+  cksum = taosCalcChecksum(cksum, (uint8_t *)pHead, sizeof(SMetaCacheHead));
+  if (cksum != *(TSCKSUM *)(pCont + contLen)) return -1;
+
+  char *p = pCont;
+  char *end = pCont + contLen;
+  if ((int64_t)pHead->numOfVgroups * sizeof(SNewVgroupInfo) > contLen) return -1;
+
+  for (int32_t i = 0; i < pHead->numOfVgroups; ++i) {
+    SNewVgroupInfo *pVgroup = (SNewVgroupInfo *)p;
+    taosHashPut(pObj->vgroupMap, &pVgroup->vgId, sizeof(pVgroup->vgId), pVgroup, sizeof(SNewVgroupInfo));
+    p += sizeof(SNewVgroupInfo);
+  }
+
+  for (int32_t i = 0; i < pHead->numOfMetas; ++i) {
+    int32_t lens[2];
+    if (end - p < (int64_t)sizeof(lens)) return -1;
+    memcpy(lens, p, sizeof(lens));
+    p += sizeof(lens);
+
+    if (lens[0] <= 0 || lens[0] > TSDB_TABLE_FNAME_LEN || lens[1] < (int32_t)sizeof(CChildTableMeta) ||
+        lens[1] > (int32_t)tscGetTableMetaMaxSize() || end - p < lens[0] + lens[1]) {
+      return -1;
+    }
+
+    taosHashPut(pObj->tableMetaMap, p, lens[0], p + lens[0], lens[1]);
+    p += lens[0] + lens[1];
+  }
+
+  return pHead->numOfMetas;
+}
+
+void tscLoadMetaCache(SClusterInfo *pObj, const char *clusterId) {
+  if (tsMetaCacheDir[0] == 0) return;
+
+  char fname[PATH_MAX] = {0};
+  tscGetMetaCacheFile(clusterId, fname, sizeof(fname));
+
+  struct stat fileStat;
+  if (stat(fname, &fileStat) != 0) {
+    tscDebug("meta cache file:%s not there", fname);
+    return;
+  }
+
+  int64_t size = fileStat.st_size;
+
+  char *buf = malloc((size_t)size);
+  FILE *fp = fopen(fname, "rb");
+  if (buf == NULL || fp == NULL || fread(buf, 1, (size_t)size, fp) != (size_t)size) {
+    tscError("failed to read meta cache file:%s, reason:%s", fname, strerror(errno));
+    if (fp != NULL) fclose(fp);
+    tfree(buf);
+    return;
+  }
+  fclose(fp);
+
+  int64_t st = taosGetTimestampMs();
+  int32_t num = tscRestoreMetaCache(pObj, clusterId, buf, size);
+  if (num < 0) {
+    // the entries restored before the broken one are dropped as well
+    tscWarn("meta cache file:%s is invalid or out of date, discard it", fname);
+    taosHashClear(pObj->vgroupMap);
+    taosHashClear(pObj->tableMetaMap);
+    remove(fname);
+  } else {
+    tscDebug("meta cache loaded from %s, tables:%d, elapsed time:%" PRId64 "ms", fname, num,
+             taosGetTimestampMs() - st);
+  }
+
+  free(buf);
+}
@@ -12,6 +12,7 @@
 #include "hash.h"
 #include "tskiplist.h"
 
+#include "tscSubquery.h"
 #include "tscUtil.h"
 #include "tsclient.h"
 #include "tscLog.h"
@@ -979,12 +980,9 @@ static void insertCallback(void *param, TAOS_RES *res, int32_t notUsedCode) {
   tsem_post(&batch->sem);
 }
 
-static int32_t applyDataPointsWithSqlInsert(TAOS* taos, TAOS_SML_DATA_POINT* points, int32_t numPoints, SArray* stableSchemas, SSmlLinesInfo* info) {
+static int32_t applyDataPointsWithSqlInsert(TAOS* taos, SHashObj* cname2points, SArray* stableSchemas, SSmlLinesInfo* info) {
   int32_t code = TSDB_CODE_SUCCESS;
 
-  SHashObj* cname2points = taosHashInit(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, false);
-  arrangePointsByChildTableName(points, numPoints, cname2points, stableSchemas, info);
-
   for (int i = 0; i < MAX_SML_SQL_INSERT_BATCHES; ++i) {
     info->batches[i].id = info->id;
     info->batches[i].index = i;
@@ -1113,13 +1111,513 @@ cleanup:
     tsem_destroy(&info->batches[i].sem);
   }
 
-  pCTablePoints = taosHashIterate(cname2points, NULL);
+  return code;
+}
+
+//=================================================================================================
+// The rows of the child tables whose meta is in the local cache are put into the submit blocks directly, without
+// rendering and parsing the sql statements. The other child tables, and the failed submit batches that may succeed by
+// retrying, are left to the sql statements, which create the child tables and refresh the meta if needed.
+
+#define SML_SUBMIT_MAX_TABLE_ROWS (INT16_MAX - 1)
+
+bool gSmlNativeSubmit = true;
+
+typedef struct {
+  SArray* cTablePoints;
+  int32_t fromIndex;
+  int32_t toIndex;
+} SSmlPointRange;
+
+typedef struct {
+  uint64_t id;
+  int32_t  index;
+  SSqlObj* pSql;
+  SArray*  ranges;  // SArray<SSmlPointRange>
+  int32_t  size;    // bytes of the rows in the submit blocks
+  int32_t  code;
+  int32_t  affectedRows;
+  tsem_t   sem;
+} SSmlSubmitBatch;
+
+static int32_t smlSetTableFullName(SSqlObj* pSql, char* tableName, SName* pName) {
+  char tableNameBuf[TSDB_TABLE_NAME_LEN + TS_BACKQUOTE_CHAR_SIZE] = {0};
+  memcpy(tableNameBuf, tableName, strlen(tableName));
+  SStrToken tableToken = {.z = tableNameBuf, .n = (uint32_t)strlen(tableName), .type = TK_ID};
+  tGetToken(tableNameBuf, &tableToken.type);
+  bool dbIncluded = false;
+  // Check if the table name available or not
+  if (tscValidateName(&tableToken, true, &dbIncluded) != TSDB_CODE_SUCCESS) {
+    return TSDB_CODE_TSC_INVALID_TABLE_ID_LENGTH;
+  }
+
+  return tscSetTableFullName(pName, &tableToken, pSql, dbIncluded);
+}
+
+// the meta of a child table along with the schema of its super table, NULL if any of them is not in the local cache
+static STableMeta* smlGetChildTableMetaFromLocalCache(SSqlObj* pSql, SName* pName) {
+  char fullTableName[TSDB_TABLE_FNAME_LEN] = {0};
+  tNameExtractFullName(pName, fullTableName);
+
+  STableMeta* pTableMeta = NULL;
+  size_t      size = 0;
+  taosHashGetCloneExt(UTIL_GET_TABLEMETA(pSql), fullTableName, strlen(fullTableName), NULL, (void**)&pTableMeta, &size);
+  if (pTableMeta == NULL || pTableMeta->id.uid == 0 || pTableMeta->tableType != TSDB_CHILD_TABLE) {
+    tfree(pTableMeta);
+    return NULL;
+  }
+
+  STableMeta* pSTableMeta = NULL;
+  int32_t     code = tscCreateTableMetaFromSTableMeta(pSql, &pTableMeta, fullTableName, &size, &pSTableMeta);
+  tfree(pSTableMeta);
+
+  if (code != TSDB_CODE_SUCCESS ||
+      taosHashGet(UTIL_GET_VGROUPMAP(pSql), &pTableMeta->vgId, sizeof(pTableMeta->vgId)) == NULL) {
+    tfree(pTableMeta);
+    return NULL;
+  }
+
+  return pTableMeta;
+}
+
+/*
+ * Map the fields of the points to the columns of the table by name. Return false if any field is not a column of the
+ * table with the same type and enough bytes, the local meta may be older than the schema changes of the points then.
+ */
+static bool smlBuildColumnIndex(SSmlSTableSchema* sTableSchema, STableMeta* pTableMeta, int32_t* colIndex) {
+  SSchema* pSchema = tscGetTableSchema(pTableMeta);
+  int32_t  numOfCols = tscGetNumOfColumns(pTableMeta);
+  size_t   numOfFields = taosArrayGetSize(sTableSchema->fields);
+
+  for (int32_t i = 0; i < numOfFields; ++i) {
+    SSchema* pField = taosArrayGet(sTableSchema->fields, i);
+
+    // the names in the schema of the points are escaped by backquotes
+    const char* name = pField->name;
+    size_t      len = strlen(name);
+    if (len >= TS_BACKQUOTE_CHAR_SIZE && name[0] == TS_BACKQUOTE_CHAR && name[len - 1] == TS_BACKQUOTE_CHAR) {
+      name += 1;
+      len -= TS_BACKQUOTE_CHAR_SIZE;
+    }
+
+    colIndex[i] = -1;
+    for (int32_t j = 0; j < numOfCols; ++j) {
+      if (strlen(pSchema[j].name) == len && strncmp(pSchema[j].name, name, len) == 0) {
+        colIndex[i] = j;
+        break;
+      }
+    }
+
+    if (colIndex[i] < 0 || pSchema[colIndex[i]].type != pField->type || pSchema[colIndex[i]].bytes < pField->bytes) {
+      return false;
+    }
+  }
+
+  return colIndex[0] == PRIMARYKEY_TIMESTAMP_COL_INDEX;
+}
+
+static int32_t smlAppendColVal(SMemRow row, SSchema* pSchema, TAOS_SML_KV* kv, int32_t toffset, int16_t colId) {
+  if (kv == NULL) {
+    tdAppendMemRowColVal(row, getNullValue(pSchema->type), true, colId, pSchema->type, toffset);
+    return TSDB_CODE_SUCCESS;
+  }
+
+  switch (pSchema->type) {
+    case TSDB_DATA_TYPE_BOOL:
+      tdAppendMemRowColVal(row, (*(int8_t*)kv->value) ? &TRUE_VALUE : &FALSE_VALUE, true, colId, pSchema->type,
+                           toffset);
+      break;
+
+    case TSDB_DATA_TYPE_BINARY: {
+      if (kv->length + VARSTR_HEADER_SIZE > pSchema->bytes) {
+        return TSDB_CODE_TSC_INVALID_VALUE;
+      }
+
+      char* rowEnd = memRowEnd(row);
+      STR_WITH_SIZE_TO_VARSTR(rowEnd, kv->value, kv->length);
+      tdAppendMemRowColVal(row, rowEnd, false, colId, pSchema->type, toffset);
+      break;
+    }
+
+    case TSDB_DATA_TYPE_NCHAR: {
+      int32_t output = 0;
+      char*   rowEnd = memRowEnd(row);
+      if (!taosMbsToUcs4(kv->value, kv->length, varDataVal(rowEnd), pSchema->bytes - VARSTR_HEADER_SIZE, &output)) {
+        return TSDB_CODE_TSC_INVALID_VALUE;
+      }
+
+      varDataSetLen(rowEnd, output);
+      tdAppendMemRowColVal(row, rowEnd, false, colId, pSchema->type, toffset);
+      break;
+    }
+
+    default:
+      tdAppendMemRowColVal(row, kv->value, true, colId, pSchema->type, toffset);
+      break;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+// append the points [fromIndex, toIndex) of a child table to its data block, the same way tsParseValues does
+static int32_t smlAppendDataPointRows(STableDataBlocks* pBlock, SArray* cTablePoints, int32_t fromIndex,
+                                      int32_t toIndex, int32_t* colIndex, TAOS_SML_KV** colKVs) {
+  STableMeta*         pTableMeta = pBlock->pTableMeta;
+  SSchema*            pSchema = tscGetTableSchema(pTableMeta);
+  SParsedDataColInfo* spd = &pBlock->boundColumnInfo;
+  SMemRowBuilder*     pBuilder = &pBlock->rowBuilder;
+
+  int32_t extendedRowSize = getExtendedRowSize(pBlock);
+  int32_t code = initMemRowBuilder(pBuilder, 0, spd);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+  pBuilder->rowSize = extendedRowSize;
+
+  uint32_t allocSize = pBlock->size + (toIndex - fromIndex) * extendedRowSize;
+  if (pBlock->nAllocSize < allocSize) {
+    char* tmp = realloc(pBlock->pData, allocSize);
+    if (tmp == NULL) {
+      return TSDB_CODE_TSC_OUT_OF_MEMORY;
+    }
+
+    pBlock->pData = tmp;
+    pBlock->nAllocSize = allocSize;
+  }
+
+  for (int32_t r = fromIndex; r < toIndex; ++r) {
+    TAOS_SML_DATA_POINT* point = taosArrayGetP(cTablePoints, r);
+
+    memset(colKVs, 0, spd->numOfCols * POINTER_BYTES);
+    for (int32_t i = 0; i < point->fieldNum; ++i) {
+      TAOS_SML_KV* kv = point->fields + i;
+      colKVs[colIndex[kv->fieldSchemaIdx]] = kv;
+    }
+
+    char* row = pBlock->pData + pBlock->size;
+    memset(row, 0, extendedRowSize);
+    initSMemRow(row, pBuilder->memRowType, pBlock, spd->numOfBound);
+
+    for (int32_t i = 0; i < spd->numOfBound; ++i) {
+      int32_t schemaIdx = spd->boundedColumns[i];
+      int32_t toffset = -1;
+      int16_t colId = -1;
+      tscGetMemRowAppendInfo(pSchema, pBuilder->memRowType, spd, i, &toffset, &colId);
+
+      code = smlAppendColVal(row, &pSchema[schemaIdx], colKVs[schemaIdx], toffset, colId);
+      if (code != TSDB_CODE_SUCCESS) {
+        return code;
+      }
+    }
+
+    // the rows are sorted and deduplicated when merging the blocks if they are not in order
+    TSKEY tsKey = memRowKey(row);
+    if (tsKey <= pBlock->prevTS) {
+      pBlock->ordered = false;
+    }
+    pBlock->prevTS = tsKey;
+    pBlock->size += extendedRowSize;
+  }
+
+  pBlock->numOfTables = 1;
+  return tsSetBlockInfo((SSubmitBlk*)pBlock->pData, pTableMeta, toIndex - fromIndex);
+}
+
+static void smlAddPointsToSqlInsert(SHashObj* sqlPoints, SArray* cTablePoints, int32_t fromIndex, int32_t toIndex) {
+  TAOS_SML_DATA_POINT* point = taosArrayGetP(cTablePoints, fromIndex);
+
+  SArray*  pPoints = NULL;
+  SArray** ppPoints = taosHashGet(sqlPoints, point->childTableName, strlen(point->childTableName));
+  if (ppPoints != NULL) {
+    pPoints = *ppPoints;
+  } else {
+    pPoints = taosArrayInit(toIndex - fromIndex, POINTER_BYTES);
+    taosHashPut(sqlPoints, point->childTableName, strlen(point->childTableName), &pPoints, POINTER_BYTES);
+  }
+
+  taosArrayAddBatch(pPoints, taosArrayGet(cTablePoints, fromIndex), toIndex - fromIndex);
+}
+
+static void smlSubmitCallback(void* param, TAOS_RES* res, int32_t numOfRows) {
+  SSmlSubmitBatch* batch = (SSmlSubmitBatch*)param;
+  batch->code = taos_errno(res);
+
+  if (batch->code != 0) {
+    tscError("SML:0x%" PRIx64 " submit batch %d failed, code:%s", batch->id, batch->index, tstrerror(batch->code));
+  }
+  tscDebug("SML:0x%" PRIx64 " submit batch %d, inserted %d rows", batch->id, batch->index, taos_affected_rows(res));
+  batch->affectedRows = taos_affected_rows(res);
+  taos_free_result(res);
+
+  tsem_post(&batch->sem);
+}
+
+static SSmlSubmitBatch* smlNewSubmitBatch(TAOS* taos, SArray* batches, SSmlLinesInfo* info) {
+  SSmlSubmitBatch* batch = calloc(1, sizeof(SSmlSubmitBatch));
+  SSqlObj*         pSql = calloc(1, sizeof(SSqlObj));
+  if (batch == NULL || pSql == NULL) {
+    free(batch);
+    free(pSql);
+    return NULL;
+  }
+
+  batch->id = info->id;
+  batch->index = (int32_t)taosArrayGetSize(batches);
+  batch->pSql = pSql;
+  batch->ranges = taosArrayInit(16, sizeof(SSmlPointRange));
+  tsem_init(&batch->sem, 0, 0);
+  taosArrayPush(batches, &batch);
+
+  pSql->signature = pSql;
+  pSql->pTscObj = taos;
+  pSql->rootObj = pSql;
+  pSql->param = batch;
+  pSql->fp = smlSubmitCallback;
+  pSql->fetchFp = smlSubmitCallback;
+  pSql->maxRetry = TSDB_MAX_REPLICA;
+  pSql->retry = pSql->maxRetry + 1;  // the failed points are retried by the sql statements, not by the submit blocks
+  tsem_init(&pSql->rspSem, 0, 0);
+  registerSqlObj(pSql);
+
+  SSqlCmd* pCmd = &pSql->cmd;
+  pCmd->command = TSDB_SQL_INSERT;
+  pCmd->insertParam.objectId = pSql->self;
+  pCmd->insertParam.pTableBlockHashList = taosHashInit(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT), true, false);
+
+  SQueryInfo* pQueryInfo = tscGetQueryInfoS(pCmd);
+  if (tscAllocPayload(pCmd, TSDB_DEFAULT_PAYLOAD_SIZE) != TSDB_CODE_SUCCESS || pQueryInfo == NULL ||
+      tscAddEmptyMetaInfo(pQueryInfo) == NULL || batch->ranges == NULL ||
+      pCmd->insertParam.pTableBlockHashList == NULL) {
+    return NULL;
+  }
+
+  TSDB_QUERY_SET_TYPE(pQueryInfo->type, TSDB_QUERY_TYPE_INSERT);
+  return batch;
+}
+
+static void smlDestroySubmitBatch(SSmlSubmitBatch* batch) {
+  if (batch->pSql != NULL) {
+    taos_free_result(batch->pSql);
+  }
+
+  taosArrayDestroy(&batch->ranges);
+  tsem_destroy(&batch->sem);
+  free(batch);
+}
+
+// merge the data blocks by vgroup and send them, the callback is always invoked if it returns success
+static int32_t smlLaunchSubmitBatch(SSmlSubmitBatch* batch) {
+  SSqlObj* pSql = batch->pSql;
+
+  int32_t code = tscMergeTableDataBlocks(pSql, &pSql->cmd.insertParam, true);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  tscDebug("SML:0x%" PRIx64 " submit batch %d, tables:%d, size:%d", batch->id, batch->index,
+           pSql->cmd.insertParam.numOfTables, batch->size);
+
+  batch->pSql = NULL;
+  code = tscHandleMultivnodeInsert(pSql);
+  if (code != TSDB_CODE_SUCCESS) {
+    batch->pSql = pSql;
+  }
+
+  return code;
+}
+
+static int32_t applyDataPointsWithSubmitBlocks(TAOS* taos, SHashObj* cname2points, SArray* stableSchemas,
+                                               SHashObj* sqlPoints, bool* resetQueryCache, SSmlLinesInfo* info) {
+  int32_t code = TSDB_CODE_SUCCESS;
+
+  if (!((STscObj*)taos)->writeAuth) {
+    return TSDB_CODE_TSC_NO_WRITE_AUTH;
+  }
+
+  int32_t       colIndex[TSDB_MAX_COLUMNS] = {0};
+  TAOS_SML_KV** colKVs = calloc(TSDB_MAX_COLUMNS, POINTER_BYTES);
+  SArray*       batches = taosArrayInit(4, POINTER_BYTES);
+  if (colKVs == NULL || batches == NULL) {
+    code = TSDB_CODE_TSC_OUT_OF_MEMORY;
+    goto cleanup;
+  }
+
+  SSmlSubmitBatch* batch = smlNewSubmitBatch(taos, batches, info);
+  if (batch == NULL) {
+    code = TSDB_CODE_TSC_OUT_OF_MEMORY;
+    goto cleanup;
+  }
+
+  SArray** pCTablePoints = taosHashIterate(cname2points, NULL);
+  while (pCTablePoints) {
+    SArray* cTablePoints = *pCTablePoints;
+    int32_t numOfRows = (int32_t)taosArrayGetSize(cTablePoints);
+
+    TAOS_SML_DATA_POINT* point = taosArrayGetP(cTablePoints, 0);
+    SSmlSTableSchema*    sTableSchema = taosArrayGet(stableSchemas, point->schemaIdx);
+
+    SName       name = {0};
+    STableMeta* pTableMeta = NULL;
+    if (smlSetTableFullName(batch->pSql, point->childTableName, &name) == TSDB_CODE_SUCCESS) {
+      pTableMeta = smlGetChildTableMetaFromLocalCache(batch->pSql, &name);
+    }
+
+    if (pTableMeta == NULL || !smlBuildColumnIndex(sTableSchema, pTableMeta, colIndex)) {
+      tscDebug("SML:0x%" PRIx64 " no meta of child table %s in local cache, insert by sql", info->id,
+               point->childTableName);
+      smlAddPointsToSqlInsert(sqlPoints, cTablePoints, 0, numOfRows);
+      tfree(pTableMeta);
+      pCTablePoints = taosHashIterate(cname2points, pCTablePoints);
+      continue;
+    }
+
+    int32_t fromIndex = 0;
+    while (fromIndex < numOfRows) {
+      STableDataBlocks* pBlock = NULL;
+      code = tscGetDataBlockFromList(batch->pSql->cmd.insertParam.pTableBlockHashList, pTableMeta->id.uid,
+                                     TSDB_DEFAULT_PAYLOAD_SIZE, sizeof(SSubmitBlk), pTableMeta->tableInfo.rowSize,
+                                     &name, pTableMeta, &pBlock, NULL);
+      if (code != TSDB_CODE_SUCCESS) {
+        tfree(pTableMeta);
+        taosHashCancelIterate(cname2points, pCTablePoints);
+        goto cleanup;
+      }
+
+      // a batch is bounded by the same size as the sql statements, so that the submit message of a vgroup fits the wal
+      int32_t extendedRowSize = getExtendedRowSize(pBlock);
+      int32_t num = MIN(numOfRows - fromIndex, SML_SUBMIT_MAX_TABLE_ROWS);
+      num = MIN(num, (tsMaxSQLStringLen - batch->size) / extendedRowSize);
+
+      if (num <= 0 && batch->size > 0) {
+        batch = smlNewSubmitBatch(taos, batches, info);
+        if (batch == NULL) {
+          code = TSDB_CODE_TSC_OUT_OF_MEMORY;
+          tfree(pTableMeta);
+          taosHashCancelIterate(cname2points, pCTablePoints);
+          goto cleanup;
+        }
+        continue;
+      }
+
+      num = MAX(num, 1);
+      code = smlAppendDataPointRows(pBlock, cTablePoints, fromIndex, fromIndex + num, colIndex, colKVs);
+      if (code != TSDB_CODE_SUCCESS) {
+        tscError("SML:0x%" PRIx64 " failed to build the rows of child table %s, code:%s", info->id,
+                 point->childTableName, tstrerror(code));
+        tfree(pTableMeta);
+        taosHashCancelIterate(cname2points, pCTablePoints);
+        goto cleanup;
+      }
+
+      SSmlPointRange range = {.cTablePoints = cTablePoints, .fromIndex = fromIndex, .toIndex = fromIndex + num};
+      taosArrayPush(batch->ranges, &range);
+      batch->size += num * extendedRowSize;
+      fromIndex += num;
+    }
+
+    tfree(pTableMeta);
+    pCTablePoints = taosHashIterate(cname2points, pCTablePoints);
+  }
+
+  // all batches are in flight together, like the sql statements
+  size_t numOfBatches = taosArrayGetSize(batches);
+  for (int32_t i = 0; i < numOfBatches; ++i) {
+    SSmlSubmitBatch* b = taosArrayGetP(batches, i);
+    if (b->size == 0) {
+      continue;
+    }
+
+    b->code = smlLaunchSubmitBatch(b);
+    if (b->code != TSDB_CODE_SUCCESS) {
+      tscError("SML:0x%" PRIx64 " failed to launch submit batch %d, code:%s", info->id, i, tstrerror(b->code));
+    }
+  }
+
+  for (int32_t i = 0; i < numOfBatches; ++i) {
+    SSmlSubmitBatch* b = taosArrayGetP(batches, i);
+    if (b->size == 0) {
+      continue;
+    }
+
+    if (b->pSql == NULL) {
+      tsem_wait(&b->sem);
+    }
+
+    int32_t bcode = b->code;
+    if (bcode == TSDB_CODE_SUCCESS) {
+      info->affectedRows += b->affectedRows;
+    } else if (bcode == TSDB_CODE_TDB_INVALID_TABLE_ID || bcode == TSDB_CODE_VND_INVALID_VGROUP_ID ||
+               bcode == TSDB_CODE_TDB_TABLE_RECONFIGURE || bcode == TSDB_CODE_APP_NOT_READY ||
+               bcode == TSDB_CODE_RPC_NETWORK_UNAVAIL) {
+      if (bcode == TSDB_CODE_TDB_INVALID_TABLE_ID || bcode == TSDB_CODE_VND_INVALID_VGROUP_ID) {
+        *resetQueryCache = true;
+      }
+
+      // the rows are submitted again by the sql statements, the duplicated timestamps are harmless
+      size_t numOfRanges = taosArrayGetSize(b->ranges);
+      for (int32_t j = 0; j < numOfRanges; ++j) {
+        SSmlPointRange* range = taosArrayGet(b->ranges, j);
+        smlAddPointsToSqlInsert(sqlPoints, range->cTablePoints, range->fromIndex, range->toIndex);
+      }
+    } else {
+      code = bcode;
+    }
+  }
+
+cleanup:
+  if (batches != NULL) {
+    for (int32_t i = 0; i < taosArrayGetSize(batches); ++i) {
+      smlDestroySubmitBatch(taosArrayGetP(batches, i));
+    }
+    taosArrayDestroy(&batches);
+  }
+
+  tfree(colKVs);
+  return code;
+}
+
+static void destroyChildTablePoints(SHashObj* cname2points) {
+  SArray** pCTablePoints = taosHashIterate(cname2points, NULL);
   while (pCTablePoints) {
     SArray* pPoints = *pCTablePoints;
     taosArrayDestroy(&pPoints);
     pCTablePoints = taosHashIterate(cname2points, pCTablePoints);
   }
   taosHashCleanup(cname2points);
+}
+
+static int32_t applyDataPoints(TAOS* taos, TAOS_SML_DATA_POINT* points, int32_t numPoints, SArray* stableSchemas,
+                               SSmlLinesInfo* info) {
+  int32_t code = TSDB_CODE_SUCCESS;
+
+  SHashObj* cname2points = taosHashInit(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, false);
+  arrangePointsByChildTableName(points, numPoints, cname2points, stableSchemas, info);
+
+  SHashObj* sqlPoints = cname2points;
+  if (gSmlNativeSubmit) {
+    sqlPoints = taosHashInit(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, false);
+
+    bool resetQueryCache = false;
+    code = applyDataPointsWithSubmitBlocks(taos, cname2points, stableSchemas, sqlPoints, &resetQueryCache, info);
+    if (resetQueryCache) {
+      TAOS_RES* res = taos_query(taos, "RESET QUERY CACHE");
+      taos_free_result(res);
+    }
+    tscDebug("SML:0x%" PRIx64 " %d of %d child tables left to sql insert", info->id, taosHashGetSize(sqlPoints),
+             taosHashGetSize(cname2points));
+  }
+
+  if (taosHashGetSize(sqlPoints) > 0) {
+    int32_t ret = applyDataPointsWithSqlInsert(taos, sqlPoints, stableSchemas, info);
+    if (code == TSDB_CODE_SUCCESS) {
+      code = ret;
+    }
+  }
+
+  if (sqlPoints != cname2points) {
+    destroyChildTablePoints(sqlPoints);
+  }
+  destroyChildTablePoints(cname2points);
   return code;
 }
 
@@ -1208,7 +1706,7 @@ int tscSmlInsert(TAOS* taos, TAOS_SML_DATA_POINT* points, int numPoint, SSmlLine
   }
 
   tscDebug("SML:0x%"PRIx64" apply data points", info->id);
-  code = applyDataPointsWithSqlInsert(taos, points, numPoint, stableSchemas, info);
+  code = applyDataPoints(taos, points, numPoint, stableSchemas, info);
   if (code != 0) {
     tscError("SML:0x%"PRIx64" error apply data points : %s", info->id, tstrerror(code));
   }
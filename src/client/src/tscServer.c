@@ -728,6 +728,16 @@ static int32_t tscEstimateQueryMsgSize(SSqlObj *pSql) {
     tableSerialize = totalTables * sizeof(STableIdInfo);
   }
 
+  if (pQueryInfo->pJoinVgroupTables != NULL) {
+    size_t numOfGroups = taosArrayGetSize(pQueryInfo->pJoinVgroupTables);
+    for (int32_t i = 0; i < numOfGroups; ++i) {
+      SVgroupTableInfo *pTableInfo = taosArrayGet(pQueryInfo->pJoinVgroupTables, i);
+      tableSerialize += (int32_t)(taosArrayGetSize(pTableInfo->itemList) * sizeof(STableIdInfo));
+    }
+
+    tableSerialize += sizeof(STLV) + sizeof(SLocalJoinMsg);
+  }
+
   if (pQueryInfo->colCond && taosArrayGetSize(pQueryInfo->colCond) > 0) {
     STblCond *pCond = tsGetTableFilter(pQueryInfo->colCond, pTableMeta->id.uid, 0);
     if (pCond != NULL && pCond->cond != NULL) {
@@ -821,6 +831,44 @@ static char *doSerializeTableInfo(SQueryTableMsg *pQueryMsg, SSqlObj *pSql, STab
   return pMsg;
 }
 
+// the tables of the other side of the join in the vnode queried, in the TLV of TLV_TYPE_LOCAL_JOIN
+static char *doSerializeLocalJoinInfo(SSqlObj *pSql, SQueryInfo *pQueryInfo, STableMetaInfo *pTableMetaInfo, char *pMsg) {
+  SVgroupTableInfo *pVgroupTables = taosArrayGet(pTableMetaInfo->pVgroupTables, pTableMetaInfo->vgroupIndex);
+  SArray           *pJoinTables = NULL;
+
+  size_t numOfGroups = taosArrayGetSize(pQueryInfo->pJoinVgroupTables);
+  for (int32_t i = 0; i < numOfGroups; ++i) {
+    SVgroupTableInfo *p = taosArrayGet(pQueryInfo->pJoinVgroupTables, i);
+    if (p->vgInfo.vgId == pVgroupTables->vgInfo.vgId) {
+      pJoinTables = p->itemList;
+      break;
+    }
+  }
+
+  assert(pJoinTables != NULL && taosArrayGetSize(pJoinTables) == taosArrayGetSize(pVgroupTables->itemList));
+  int32_t numOfTables = (int32_t)taosArrayGetSize(pJoinTables);
+
+  STLV *tlv = (STLV *)pMsg;
+  tlv->type = htons(TLV_TYPE_LOCAL_JOIN);
+  tlv->len  = htonl((int32_t)(sizeof(SLocalJoinMsg) + numOfTables * sizeof(STableIdInfo)));
+
+  SLocalJoinMsg *pJoinMsg = (SLocalJoinMsg *)tlv->value;
+  pJoinMsg->joinId      = htobe64(pQueryInfo->localJoinId);
+  pJoinMsg->numOfSides  = htonl(pQueryInfo->localJoinSides);
+  pJoinMsg->numOfTables = htonl(numOfTables);
+
+  for (int32_t i = 0; i < numOfTables; ++i) {
+    STableIdInfo *pItem = taosArrayGet(pJoinTables, i);
+    pJoinMsg->tables[i].tid = htonl(pItem->tid);
+    pJoinMsg->tables[i].uid = htobe64(pItem->uid);
+    pJoinMsg->tables[i].key = htobe64(pItem->key);
+  }
+
+  tscDebug("0x%"PRIx64" vgId:%d, join %d tables in the vnode, joinId:0x%"PRIx64, pSql->self, pVgroupTables->vgInfo.vgId,
+           numOfTables, pQueryInfo->localJoinId);
+  return pMsg + sizeof(*tlv) + sizeof(SLocalJoinMsg) + numOfTables * sizeof(STableIdInfo);
+}
+
 // TODO refactor
 static int32_t serializeColFilterInfo(SColumnFilterInfo* pColFilters, int16_t numOfFilters, char** pMsg) {
   // append the filter information after the basic column information
@@ -1189,6 +1237,10 @@ int tscBuildQueryMsg(SSqlObj *pSql, SSqlInfo *pInfo) {
   *(int16_t*)(tlv->value+sizeof(int16_t)) = htons(pTableMeta->tversion);
   pMsg += sizeof(*tlv) + sizeof(int16_t) * 2;
 
+  if (pQueryInfo->localJoinId != 0 && pTableMetaInfo->pVgroupTables != NULL) {
+    pMsg = doSerializeLocalJoinInfo(pSql, pQueryInfo, pTableMetaInfo, pMsg);
+  }
+
   tlv = (STLV *)pMsg;
   tlv->type = htons(TLV_TYPE_END_MARK);
   tlv->len = 0;
@@ -1198,6 +1198,85 @@ int taos_load_table_info(TAOS *taos, const char *tableNameList) {
   }
 
   tsem_wait(&pSql->rspSem);
+  code = pSql->res.code;
   tscFreeRegisteredSqlObj(pSql);
   return code;
 }
+
+int taos_load_stable_info(TAOS *taos, const char *stableName) {
+  const int32_t TABLES_PER_LOAD = 1000;
+
+  STscObj *pObj = (STscObj *)taos;
+  if (pObj == NULL || pObj->signature != pObj) {
+    terrno = TSDB_CODE_TSC_DISCONNECTED;
+    return TSDB_CODE_TSC_DISCONNECTED;
+  }
+
+  if (stableName == NULL || strlen(stableName) == 0 || strlen(stableName) >= TSDB_TABLE_FNAME_LEN) {
+    return TSDB_CODE_TSC_INVALID_OPERATION;
+  }
+
+  // the child tables are in the db of the super table
+  char        db[TSDB_DB_NAME_LEN] = {0};
+  const char *p = strchr(stableName, '.');
+  if (p != NULL) {
+    tstrncpy(db, stableName, MIN(p - stableName + 1, sizeof(db)));
+  }
+
+  char sql[TSDB_TABLE_FNAME_LEN + 32] = {0};
+  snprintf(sql, sizeof(sql), "select tbname from %s", stableName);
+
+  TAOS_RES *pRes = taos_query(taos, sql);
+  int32_t   code = taos_errno(pRes);
+  if (code != TSDB_CODE_SUCCESS) {
+    tscError("failed to get the child tables of %s, reason:%s", stableName, tstrerror(code));
+    taos_free_result(pRes);
+    return code;
+  }
+
+  int32_t listLen = TABLES_PER_LOAD * (TSDB_DB_NAME_LEN + TSDB_TABLE_NAME_LEN + 1);
+  char   *list = malloc(listLen + 1);
+  if (list == NULL) {
+    taos_free_result(pRes);
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  int64_t  st = taosGetTimestampMs();
+  int32_t  len = 0;
+  int32_t  numOfTables = 0;
+  TAOS_ROW row = NULL;
+
+  // the metas are loaded from mnode in batches, instead of one request for each table on its first insertion
+  while (code == TSDB_CODE_SUCCESS && (row = taos_fetch_row(pRes)) != NULL) {
+    int32_t *lengths = taos_fetch_lengths(pRes);
+    len += (db[0] != 0) ? sprintf(list + len, "%s.", db) : 0;
+    len += sprintf(list + len, "%.*s,", MIN(lengths[0], TSDB_TABLE_NAME_LEN), (char *)row[0]);
+
+    if (++numOfTables % TABLES_PER_LOAD == 0) {
+      list[len - 1] = 0;
+      code = taos_load_table_info(taos, list);
+      len = 0;
+    }
+  }
+
+  if (code == TSDB_CODE_SUCCESS) code = taos_errno(pRes);
+  if (code == TSDB_CODE_SUCCESS && len > 0) {
+    list[len - 1] = 0;
+    code = taos_load_table_info(taos, list);
+  }
+
+  free(list);
+  taos_free_result(pRes);
+
+  if (code != TSDB_CODE_SUCCESS) {
+    tscError("failed to load the table meta of %s, reason:%s", stableName, tstrerror(code));
+    return code;
+  }
+
+  tscDebug("table meta of %d child tables of %s loaded, elapsed time:%" PRId64 "ms", numOfTables, stableName,
+           taosGetTimestampMs() - st);
+
+  // keep them for the next run of the process
+  tscSaveMetaCache(pObj->pClusterInfo, pObj->clusterId);
+  return TSDB_CODE_SUCCESS;
+}
@@ -451,6 +451,9 @@ static void tscDestroyJoinSupporter(SJoinSupporter* pSupporter) {
     pSupporter->pVgroupTables = NULL;
   }
 
+  tscFreeVgroupTableInfo(pSupporter->pJoinVgroupTables);
+  pSupporter->pJoinVgroupTables = NULL;
+
   tfree(pSupporter->pIdTagList);
   tscTagCondRelease(&pSupporter->tagCond);
   free(pSupporter);
@@ -561,7 +564,8 @@ static int32_t tscLaunchRealSubqueries(SSqlObj* pSql) {
     pSubQueryInfo->tsBuf = NULL;
   
     // free result for async object will also free sqlObj
-    assert(tscNumOfExprs(pSubQueryInfo) == 1); // ts_comp query only requires one result columns
+    // ts_comp query only requires one result columns, it is the tid_tag query if joined in the vnodes
+    assert(pSupporter->localJoinId != 0 || tscNumOfExprs(pSubQueryInfo) == 1);
     taos_free_result(pPrevSub);
   
     SSqlObj *pNew = createSubqueryObj(pSql, (int16_t) i, tscJoinQueryCallback, pSupporter, TSDB_SQL_SELECT, NULL);
@@ -603,9 +607,14 @@ static int32_t tscLaunchRealSubqueries(SSqlObj* pSql) {
     STableMetaInfo *pTableMetaInfo = tscGetMetaInfo(pQueryInfo, 0);
     pTableMetaInfo->pVgroupTables = pSupporter->pVgroupTables;
 
+    pQueryInfo->localJoinId       = pSupporter->localJoinId;
+    pQueryInfo->localJoinSides    = numOfSub;
+    pQueryInfo->pJoinVgroupTables = pSupporter->pJoinVgroupTables;
+
     pSupporter->exprList = NULL;
     pSupporter->colList  = NULL;
     pSupporter->pVgroupTables = NULL;
+    pSupporter->pJoinVgroupTables = NULL;
     memset(&pSupporter->fieldsInfo, 0, sizeof(SFieldInfo));
     memset(&pSupporter->groupInfo, 0, sizeof(SGroupbyExpr));
 
@@ -655,7 +664,10 @@ static int32_t tscLaunchRealSubqueries(SSqlObj* pSql) {
 
     if (UTIL_TABLE_IS_SUPER_TABLE(pTableMetaInfo)) {
       assert(pTableMetaInfo->pVgroupTables != NULL);
-      if (tscNonOrderedProjectionQueryOnSTable(pQueryInfo, 0)) {
+      if (pQueryInfo->localJoinId != 0) {
+        // all the vnodes with tables matched are queried, the ones with no timestamp joined return nothing
+        TSDB_QUERY_SET_TYPE(pQueryInfo->type, TSDB_QUERY_TYPE_MULTITABLE_QUERY);
+      } else if (tscNonOrderedProjectionQueryOnSTable(pQueryInfo, 0)) {
         SArray* p = buildVgroupTableByResult(pQueryInfo, pTableMetaInfo->pVgroupTables);
         tscFreeVgroupTableInfo(pTableMetaInfo->pVgroupTables);
         pTableMetaInfo->pVgroupTables = p;
@@ -1244,6 +1256,66 @@ bool emptyTagList(SArray* resList, int32_t size) {
   return false;
 }
 
+/*
+ * The timestamps are joined in the vnodes instead of by the ts_comp queries, if each pair of tables matched on tags are
+ * in the same vnode. Only the join of two super tables on a tag other than a json one, with no filter on the columns,
+ * is done this way, since the rows of the two sides are merged by position and shall have the same timestamps.
+ */
+static bool tscLocalJoinable(SSqlObj* pParentSql, SArray* resList) {
+  if (!tsLocalJoin || pParentSql->subState.numOfSub != 2) {
+    return false;
+  }
+
+  SQueryInfo* pQueryInfo = tscGetQueryInfo(&pParentSql->cmd);
+  if (pQueryInfo->limit.offset > 0 && pQueryInfo->interval.interval == 0 && !QUERY_IS_STABLE_QUERY(pQueryInfo->type)) {
+    return false;
+  }
+
+  for (int32_t i = 0; i < pParentSql->subState.numOfSub; ++i) {
+    SJoinSupporter* p = pParentSql->pSubs[i]->param;
+    STableMetaInfo* pTableMetaInfo = tscGetMetaInfo(tscGetQueryInfo(&pParentSql->pSubs[i]->cmd), 0);
+
+    if (!UTIL_TABLE_IS_SUPER_TABLE(pTableMetaInfo) || p->pVgroupTables == NULL) {
+      return false;
+    }
+
+    if (p->tagCond.joinInfo.joinTables[0]->tagJsonKeyName[0] != 0 ||
+        tscGetJoinTagColIdByUid(&p->tagCond, pTableMetaInfo->pTableMeta->id.uid) == TSDB_TBNAME_COLUMN_INDEX) {
+      return false;
+    }
+
+    if (p->colCond != NULL && taosArrayGetSize(p->colCond) > 0) {
+      return false;
+    }
+
+    size_t numOfCols = (p->colList != NULL) ? taosArrayGetSize(p->colList) : 0;
+    for (int32_t j = 0; j < numOfCols; ++j) {
+      SColumn* pCol = taosArrayGetP(p->colList, j);
+      if (pCol->info.flist.numOfFilters > 0) {
+        return false;
+      }
+    }
+  }
+
+  // the tables matched have the same index in the lists
+  SArray* s0 = *(SArray**)taosArrayGet(resList, 0);
+  SArray* s1 = *(SArray**)taosArrayGet(resList, 1);
+  if (taosArrayGetSize(s0) != taosArrayGetSize(s1)) {
+    return false;
+  }
+
+  size_t numOfTables = taosArrayGetSize(s0);
+  for (int32_t i = 0; i < numOfTables; ++i) {
+    STidTags* t0 = taosArrayGet(s0, i);
+    STidTags* t1 = taosArrayGet(s1, i);
+    if (t0->vgId != t1->vgId) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 static void tidTagRetrieveCallback(void* param, TAOS_RES* tres, int32_t numOfRows) {
   SJoinSupporter* pSupporter = (SJoinSupporter*)param;
 
@@ -1381,7 +1453,6 @@ static void tidTagRetrieveCallback(void* param, TAOS_RES* tres, int32_t numOfRow
     (*pParentSql->fp)(pParentSql->param, pParentSql, 0);
   } else {
     for (int32_t m = 0; m < pParentSql->subState.numOfSub; ++m) {
-      // proceed to for ts_comp query
       SSqlCmd* pSubCmd = &pParentSql->pSubs[m]->cmd;
       SArray** s = taosArrayGet(resList, m);
 
@@ -1391,11 +1462,31 @@ static void tidTagRetrieveCallback(void* param, TAOS_RES* tres, int32_t numOfRow
 
       SSqlObj* psub = pParentSql->pSubs[m];
       ((SJoinSupporter*)psub->param)->pVgroupTables =  tscVgroupTableInfoDup(pTableMetaInfo->pVgroupTables);
+    }
+
+    if (tscLocalJoinable(pParentSql, resList)) {
+      // the timestamps are joined in the vnodes, proceed to the real queries
+      uint64_t joinId = ((uint64_t)taosRand() << 32u) | (uint32_t)pParentSql->self;
+      for (int32_t m = 0; m < pParentSql->subState.numOfSub; ++m) {
+        SJoinSupporter* p = pParentSql->pSubs[m]->param;
+        SJoinSupporter* pOther = pParentSql->pSubs[1 - m]->param;
+
+        p->pJoinVgroupTables = tscVgroupTableInfoDup(pOther->pVgroupTables);
+        p->localJoinId = joinId;
+      }
 
+      tscDebug("0x%"PRIx64" tables joined are in the same vnodes, join them there, joinId:0x%"PRIx64, pParentSql->self,
+               joinId);
+      tscLaunchRealSubqueries(pParentSql);
+    } else {
       memset(pParentSql->subState.states, 0, sizeof(pParentSql->subState.states[0]) * pParentSql->subState.numOfSub);
       tscDebug("0x%"PRIx64" reset all sub states to 0", pParentSql->self);
-      
-      issueTsCompQuery(psub, psub->param, pParentSql);
+
+      for (int32_t m = 0; m < pParentSql->subState.numOfSub; ++m) {
+        // proceed to for ts_comp query
+        SSqlObj* psub = pParentSql->pSubs[m];
+        issueTsCompQuery(psub, psub->param, pParentSql);
+      }
     }
   }
 
@@ -2822,6 +2913,13 @@ int32_t tscHandleMasterSTableQuery(SSqlObj *pSql) {
       pNewQueryInfo->tsBuf = tsBufClone(pQueryInfo->tsBuf);
       assert(pNewQueryInfo->tsBuf != NULL);
     }
+
+    if (pQueryInfo->localJoinId != 0) {
+      SQueryInfo *pNewQueryInfo = tscGetQueryInfo(&pNew->cmd);
+      pNewQueryInfo->localJoinId = pQueryInfo->localJoinId;
+      pNewQueryInfo->localJoinSides = pQueryInfo->localJoinSides;
+      pNewQueryInfo->pJoinVgroupTables = tscVgroupTableInfoDup(pQueryInfo->pJoinVgroupTables);
+    }
     
     tscDebug("0x%"PRIx64" sub:0x%"PRIx64" create subquery success. orderOfSub:%d", pSql->self, pNew->self,
         trs->subqueryIndex);
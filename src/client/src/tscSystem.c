@@ -19,6 +19,7 @@
 #include "trpc.h"
 #include "tnote.h"
 #include "ttimer.h"
+#include "tcrc32c.h"
 #include "tsched.h"
 #include "tscLog.h"
 #include "tsclient.h"
@@ -147,6 +148,7 @@ void *tscAcquireClusterInfo(const char *clusterId) {
         tscClusterInfoDestroy(pObj);
         pObj = NULL;
       } else {
+        tscLoadMetaCache(pObj, clusterId);
         taosHashPut(tscClusterMap, clusterId, len, &pObj, POINTER_BYTES);
       } 
     }
@@ -170,6 +172,7 @@ void tscReleaseClusterInfo(const char *clusterId) {
   }
   if (pObj && --pObj->ref == 0) {
     taosHashRemove(tscClusterMap, clusterId, len);
+    tscSaveMetaCache(pObj, clusterId);
     tscClusterInfoDestroy(pObj); 
   }
   pthread_mutex_unlock(&clusterMutex);
@@ -218,6 +221,7 @@ void taos_init_imp(void) {
   }
 
   taosSetCoreDump();
+  taosResolveCRC();  // the meta cache snapshot is checksummed
   tscInitMsgsFp();
 
   double factor = (tscEmbedded == 0)? 2.0:4.0;
@@ -281,6 +285,16 @@ void taos_cleanup(void) {
     #endif
   }
 
+  // the connections not closed yet still hold the cluster info, keep the table meta of them
+  SClusterInfo **ppCluster = tscClusterMap ? taosHashIterate(tscClusterMap, NULL) : NULL;
+  while (ppCluster != NULL) {
+    char   clusterId[TSDB_CLUSTER_ID_LEN] = {0};
+    size_t len = taosHashGetDataKeyLen(tscClusterMap, ppCluster);
+    memcpy(clusterId, taosHashGetDataKey(tscClusterMap, ppCluster), MIN(len, sizeof(clusterId) - 1));
+    tscSaveMetaCache(*ppCluster, clusterId);
+    ppCluster = taosHashIterate(tscClusterMap, ppCluster);
+  }
+
   int32_t id = tscObjRef;
   tscObjRef = -1;
   taosCloseRef(id);
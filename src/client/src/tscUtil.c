@@ -1292,7 +1292,8 @@ SOperatorInfo* createDummyInputOperator(SSqlObj* pSql, SSchema* pSchema, int32_t
   assert(numOfCols > 0);
   STimeWindow win = {.skey = INT64_MIN, .ekey = INT64_MAX};
 
-  SDummyInputInfo* pInfo = calloc(1, sizeof(SDummyInputInfo));
+  // no arena on the client side, yet the operator tree is released by taosArenaFree as the one in the vnode
+  SDummyInputInfo* pInfo = taosArenaCalloc(NULL, 1, sizeof(SDummyInputInfo));
 
   pInfo->pSql            = pSql;
   pInfo->pFilterInfo     = pFilters;
@@ -1311,7 +1312,7 @@ SOperatorInfo* createDummyInputOperator(SSqlObj* pSql, SSchema* pSchema, int32_t
     taosArrayPush(pInfo->block->pDataBlock, &colData);
   }
 
-  SOperatorInfo* pOptr = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOptr = taosArenaCalloc(NULL, 1, sizeof(SOperatorInfo));
   pOptr->name          = "DummyInputOperator";
   pOptr->operatorType  = OP_DummyInput;
   pOptr->numOfOutput   = numOfCols;
@@ -1330,7 +1331,7 @@ static void destroyJoinOperator(void* param, int32_t numOfOutput) {
 }
 
 SOperatorInfo* createJoinOperatorInfo(SOperatorInfo** pUpstream, int32_t numOfUpstream, SSchema* pSchema, int32_t numOfOutput) {
-  SJoinOperatorInfo* pInfo = calloc(1, sizeof(SJoinOperatorInfo));
+  SJoinOperatorInfo* pInfo = taosArenaCalloc(NULL, 1, sizeof(SJoinOperatorInfo));
 
   pInfo->numOfUpstream = numOfUpstream;
   pInfo->status = calloc(numOfUpstream, sizeof(SJoinStatus));
@@ -1352,7 +1353,7 @@ SOperatorInfo* createJoinOperatorInfo(SOperatorInfo** pUpstream, int32_t numOfUp
     taosArrayPush(pInfo->pRes->pDataBlock, &colData);
   }
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(NULL, 1, sizeof(SOperatorInfo));
   pOperator->name          = "JoinOperator";
   pOperator->operatorType  = OP_Join;
   pOperator->numOfOutput   = numOfOutput;
@@ -3464,6 +3465,11 @@ static void freeQueryInfoImpl(SQueryInfo* pQueryInfo) {
   pQueryInfo->tsBuf = tsBufDestroy(pQueryInfo->tsBuf);
   pQueryInfo->fillType = 0;
 
+  tscFreeVgroupTableInfo(pQueryInfo->pJoinVgroupTables);
+  pQueryInfo->pJoinVgroupTables = NULL;
+  pQueryInfo->localJoinId = 0;
+  pQueryInfo->localJoinSides = 0;
+
   tfree(pQueryInfo->fillVal);
   pQueryInfo->fillType = 0;
   tfree(pQueryInfo->buf);
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include <iostream>
+
+#include "os.h"
+#include "hash.h"
+#include "tchecksum.h"
+#include "tglobal.h"
+#include "tsclient.h"
+
+namespace {
+
+const char *metaCacheTestDir = "/tmp/metaCacheTest";
+const char *clusterId = "metaCacheTest";
+
+class MetaCacheTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() {
+    taosRemoveDir((char *)metaCacheTestDir);
+    ASSERT_EQ(taosMkDir(metaCacheTestDir, 0755), 0);
+    tstrncpy(tsMetaCacheDir, metaCacheTestDir, PATH_MAX);
+  }
+
+  static void TearDownTestCase() {
+    tsMetaCacheDir[0] = 0;
+    taosRemoveDir((char *)metaCacheTestDir);
+  }
+};
+
+std::string metaCacheFile() { return std::string(metaCacheTestDir) + "/meta-" + clusterId + ".cache"; }
+
+// the maps of the cluster as tscAcquireClusterInfo creates them, with no vgroup list buffer
+SClusterInfo *newClusterInfo() {
+  SClusterInfo *pObj = (SClusterInfo *)calloc(1, sizeof(SClusterInfo));
+  pObj->vgroupMap = taosHashInit(256, taosGetDefaultHashFunction(TSDB_DATA_TYPE_INT), true, HASH_ENTRY_LOCK);
+  pObj->tableMetaMap = taosHashInit(1024, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, HASH_ENTRY_LOCK);
+  return pObj;
+}
+
+void freeClusterInfo(SClusterInfo *pObj) {
+  taosHashCleanup((SHashObj *)pObj->vgroupMap);
+  taosHashCleanup((SHashObj *)pObj->tableMetaMap);
+  free(pObj);
+}
+
+// three vgroups, the meta of a normal table of three columns and the one of a child table
+void putMetas(SClusterInfo *pObj) {
+  for (int32_t vgId = 2; vgId < 5; ++vgId) {
+    SNewVgroupInfo vgroup = {0};
+    vgroup.vgId = vgId;
+    vgroup.numOfEps = 1;
+    vgroup.ep[0].port = 6030;
+    snprintf(vgroup.ep[0].fqdn, sizeof(vgroup.ep[0].fqdn), "dnode%d", vgId);
+    taosHashPut((SHashObj *)pObj->vgroupMap, &vgroup.vgId, sizeof(vgroup.vgId), &vgroup, sizeof(vgroup));
+  }
+
+  size_t      size = sizeof(STableMeta) + 3 * sizeof(SSchema);
+  STableMeta *pMeta = (STableMeta *)calloc(1, size);
+  pMeta->vgId = 2;
+  pMeta->id.uid = 1001;
+  pMeta->id.tid = 1;
+  pMeta->tableType = TSDB_NORMAL_TABLE;
+  pMeta->sversion = 1;
+  pMeta->tableInfo.numOfColumns = 3;
+  for (int16_t i = 0; i < 3; ++i) {
+    pMeta->schema[i].type = (i == 0) ? TSDB_DATA_TYPE_TIMESTAMP : TSDB_DATA_TYPE_INT;
+    pMeta->schema[i].bytes = tDataTypes[pMeta->schema[i].type].bytes;
+    pMeta->schema[i].colId = i;
+    snprintf(pMeta->schema[i].name, sizeof(pMeta->schema[i].name), "c%d", i);
+  }
+  taosHashPut((SHashObj *)pObj->tableMetaMap, "db.t1", 5, pMeta, size);
+  free(pMeta);
+
+  CChildTableMeta cMeta = {0};
+  cMeta.vgId = 3;
+  cMeta.id.uid = 1002;
+  cMeta.id.tid = 2;
+  cMeta.tableType = TSDB_CHILD_TABLE;
+  cMeta.suid = 1000;
+  tstrncpy(cMeta.sTableName, "db.st", sizeof(cMeta.sTableName));
+  taosHashPut((SHashObj *)pObj->tableMetaMap, "db.c1", 5, &cMeta, sizeof(cMeta));
+}
+
+// the entries of both maps are the same
+void checkMetas(SClusterInfo *pObj, SClusterInfo *pLoaded) {
+  ASSERT_EQ(taosHashGetSize((SHashObj *)pLoaded->vgroupMap), taosHashGetSize((SHashObj *)pObj->vgroupMap));
+  ASSERT_EQ(taosHashGetSize((SHashObj *)pLoaded->tableMetaMap), taosHashGetSize((SHashObj *)pObj->tableMetaMap));
+
+  for (int32_t vgId = 2; vgId < 5; ++vgId) {
+    void *p1 = taosHashGet((SHashObj *)pObj->vgroupMap, &vgId, sizeof(vgId));
+    void *p2 = taosHashGet((SHashObj *)pLoaded->vgroupMap, &vgId, sizeof(vgId));
+    ASSERT_NE(p2, nullptr);
+    ASSERT_EQ(memcmp(p1, p2, sizeof(SNewVgroupInfo)), 0);
+  }
+
+  STableMeta *p1 = (STableMeta *)taosHashGet((SHashObj *)pObj->tableMetaMap, "db.t1", 5);
+  STableMeta *p2 = (STableMeta *)taosHashGet((SHashObj *)pLoaded->tableMetaMap, "db.t1", 5);
+  ASSERT_NE(p2, nullptr);
+  ASSERT_EQ(memcmp(p1, p2, sizeof(STableMeta) + 3 * sizeof(SSchema)), 0);
+
+  CChildTableMeta *c1 = (CChildTableMeta *)taosHashGet((SHashObj *)pObj->tableMetaMap, "db.c1", 5);
+  CChildTableMeta *c2 = (CChildTableMeta *)taosHashGet((SHashObj *)pLoaded->tableMetaMap, "db.c1", 5);
+  ASSERT_NE(c2, nullptr);
+  ASSERT_EQ(memcmp(c1, c2, sizeof(CChildTableMeta)), 0);
+}
+
+// save the metas of a cluster into the file
+void saveMetas() {
+  SClusterInfo *pObj = newClusterInfo();
+  putMetas(pObj);
+  tscSaveMetaCache(pObj, clusterId);
+  freeClusterInfo(pObj);
+}
+
+// overwrite a byte of the file at offset from the end
+void corruptFile(long offset) {
+  FILE *fp = fopen(metaCacheFile().c_str(), "r+b");
+  ASSERT_NE(fp, nullptr);
+  ASSERT_EQ(fseek(fp, -offset, SEEK_END), 0);
+  int c = fgetc(fp);
+  ASSERT_EQ(fseek(fp, -offset, SEEK_END), 0);
+  fputc(c ^ 0xff, fp);
+  fclose(fp);
+}
+
+// load the file into an empty cluster, it is expected to be discarded
+void checkDiscarded() {
+  SClusterInfo *pLoaded = newClusterInfo();
+  tscLoadMetaCache(pLoaded, clusterId);
+  ASSERT_EQ(taosHashGetSize((SHashObj *)pLoaded->vgroupMap), 0);
+  ASSERT_EQ(taosHashGetSize((SHashObj *)pLoaded->tableMetaMap), 0);
+  ASSERT_NE(access(metaCacheFile().c_str(), F_OK), 0);
+  freeClusterInfo(pLoaded);
+}
+
+}  // namespace
+
+// the metas saved are loaded back as they are, the file is kept for the next client
+TEST_F(MetaCacheTest, saveLoad) {
+  SClusterInfo *pObj = newClusterInfo();
+  putMetas(pObj);
+  tscSaveMetaCache(pObj, clusterId);
+
+  SClusterInfo *pLoaded = newClusterInfo();
+  tscLoadMetaCache(pLoaded, clusterId);
+  checkMetas(pObj, pLoaded);
+  ASSERT_EQ(access(metaCacheFile().c_str(), F_OK), 0);
+
+  freeClusterInfo(pLoaded);
+  freeClusterInfo(pObj);
+}
+
+// a file failing the checksum is discarded as a whole, for a byte changed in the entries or in the checksum
+TEST_F(MetaCacheTest, discardCorrupted) {
+  saveMetas();
+  corruptFile(sizeof(TSCKSUM) + 1);
+  checkDiscarded();
+
+  saveMetas();
+  corruptFile(sizeof(TSCKSUM));
+  checkDiscarded();
+}
+
+// a file written by another client version is discarded
+TEST_F(MetaCacheTest, discardOtherVersion) {
+  saveMetas();
+
+  uint32_t clientVer = tsVersion;
+  tsVersion = clientVer + 1;
+  checkDiscarded();
+  tsVersion = clientVer;
+
+  // and the one of the same version is loaded again
+  saveMetas();
+  SClusterInfo *pLoaded = newClusterInfo();
+  tscLoadMetaCache(pLoaded, clusterId);
+  ASSERT_EQ(taosHashGetSize((SHashObj *)pLoaded->tableMetaMap), 2);
+  freeClusterInfo(pLoaded);
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "hash.h"
+#include "taos.h"
+#include "taoserror.h"
+#include "tscParseLine.h"
+
+/*
+ * Report the rows/sec of ingesting the influxdb line protocol by taos_schemaless_insert, with the data points put into
+ * the submit blocks directly or rendered into the sql statements. The child tables are created before timing, so the
+ * steady state ingestion is measured. A running server is required.
+ *
+ * usage: smlBench [tables] [rows per table] [lines per call] [config dir]
+ */
+
+#define BENCH_DB       "sml_bench"
+#define BENCH_LINE_LEN 160
+
+static int32_t execSql(TAOS *taos, const char *sql) {
+  TAOS_RES *res = taos_query(taos, sql);
+  int32_t   code = taos_errno(res);
+  if (code != 0) {
+    printf("failed to execute %s, reason:%s\n", sql, taos_errstr(res));
+  }
+
+  taos_free_result(res);
+  return code;
+}
+
+static int64_t countRows(TAOS *taos) {
+  TAOS_RES *res = taos_query(taos, "select count(*) from st");
+  int64_t   num = -1;
+
+  TAOS_ROW row = (taos_errno(res) == 0) ? taos_fetch_row(res) : NULL;
+  if (row != NULL && row[0] != NULL) {
+    num = *(int64_t *)row[0];
+  }
+
+  taos_free_result(res);
+  return num;
+}
+
+// the rows are in time order, each group of lines carries one row of every table
+static void genLines(char **lines, int32_t numOfTables, int32_t rows) {
+  int64_t ts = 1600000000000L;
+
+  for (int32_t r = 0; r < rows; ++r) {
+    for (int32_t t = 0; t < numOfTables; ++t) {
+      snprintf(lines[(int64_t)r * numOfTables + t], BENCH_LINE_LEN,
+               "st,t0=dev%d,t1=%di64 c0=%di64,c1=%d.5f64,c2=\"s%d\",c3=%s %" PRId64, t, t % 10, r, r, r % 100,
+               (r % 2) ? "true" : "false", ts + (int64_t)r * 1000);
+    }
+  }
+}
+
+static int32_t insertLines(TAOS *taos, char **lines, int32_t numOfLines, int32_t batch) {
+  for (int32_t i = 0; i < numOfLines; i += batch) {
+    TAOS_RES *res = taos_schemaless_insert(taos, lines + i, MIN(batch, numOfLines - i), TSDB_SML_LINE_PROTOCOL,
+                                           TSDB_SML_TIMESTAMP_MILLI_SECONDS);
+    int32_t code = taos_errno(res);
+    if (code != 0) {
+      printf("failed to insert lines, reason:%s\n", taos_errstr(res));
+      taos_free_result(res);
+      return code;
+    }
+
+    taos_free_result(res);
+  }
+
+  return 0;
+}
+
+/*
+ * return the rows/sec, or -1 if failed or the table does not have the expected rows
+ */
+static double doBench(TAOS *taos, char **lines, int32_t numOfTables, int32_t rows, int32_t batch) {
+  if (execSql(taos, "drop database if exists " BENCH_DB) != 0 || execSql(taos, "create database " BENCH_DB) != 0 ||
+      execSql(taos, "use " BENCH_DB) != 0) {
+    return -1;
+  }
+
+  // create the super table and the child tables by the first row of each table
+  if (insertLines(taos, lines, numOfTables, batch) != 0) {
+    return -1;
+  }
+
+  int64_t st = taosGetTimestampUs();
+  if (insertLines(taos, lines + numOfTables, numOfTables * (rows - 1), batch) != 0) {
+    return -1;
+  }
+  int64_t el = taosGetTimestampUs() - st;
+
+  if (countRows(taos) != (int64_t)numOfTables * rows) {
+    printf("unexpected number of rows:%" PRId64 "\n", countRows(taos));
+    return -1;
+  }
+
+  return (double)numOfTables * (rows - 1) / (el / 1000000.0);
+}
+
+int main(int argc, char *argv[]) {
+  int32_t numOfTables = (argc > 1) ? atoi(argv[1]) : 100;
+  int32_t rows = (argc > 2) ? atoi(argv[2]) : 2000;
+  int32_t batch = (argc > 3) ? atoi(argv[3]) : 1000;
+
+  if (numOfTables <= 0 || rows <= 1 || batch <= 0) {
+    printf("usage: %s [tables] [rows per table] [lines per call] [config dir]\n", argv[0]);
+    return 1;
+  }
+
+  if (argc > 4) {
+    taos_options(TSDB_OPTION_CONFIGDIR, argv[4]);
+  }
+
+  TAOS *taos = taos_connect(NULL, "root", "taosdata", NULL, 0);
+  if (taos == NULL) {
+    printf("failed to connect to server, reason:%s\n", tstrerror(terrno));
+    return 1;
+  }
+
+  int32_t numOfLines = numOfTables * rows;
+  char  **lines = malloc(POINTER_BYTES * numOfLines);
+  char   *buf = malloc((size_t)BENCH_LINE_LEN * numOfLines);
+  for (int32_t i = 0; i < numOfLines; ++i) {
+    lines[i] = buf + (int64_t)i * BENCH_LINE_LEN;
+  }
+  genLines(lines, numOfTables, rows);
+
+  printf("tables:%d, rows per table:%d, lines per call:%d\n", numOfTables, rows, batch);
+  for (int32_t m = 0; m < 2; ++m) {
+    gSmlNativeSubmit = (m == 1);
+
+    // take the best of several runs to reduce the noise
+    double best = 0;
+    for (int32_t r = 0; r < 3; ++r) {
+      double v = doBench(taos, lines, numOfTables, rows, batch);
+      if (v < 0) {
+        free(buf);
+        free(lines);
+        taos_close(taos);
+        return 1;
+      }
+      best = MAX(best, v);
+    }
+
+    printf("%-6s %12.0f rows/sec\n", (m == 0) ? "sql" : "submit", best);
+  }
+
+  execSql(taos, "drop database if exists " BENCH_DB);
+
+  free(buf);
+  free(lines);
+  taos_close(taos);
+  return 0;
+}
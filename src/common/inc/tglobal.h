@@ -50,22 +50,32 @@ extern int32_t  tsSyncCheckInterval;
 extern int      tsRpcTimer;
 extern int      tsRpcMaxTime;
 extern int      tsRpcForceTcp;  // all commands go to tcp protocol if this is enabled
+extern int32_t  tsRpcReusePort;
 extern int32_t  tsMaxConnections;
 extern int32_t  tsMaxShellConns;
 extern int32_t  tsShellActivityTimer;
 extern uint32_t tsMaxTmrCtrl;
 extern float    tsNumOfThreadsPerCore;
 extern int32_t  tsNumOfCommitThreads;
+extern int32_t  tsNumOfCommitCompressThreads;
+extern int32_t  tsNumOfOpenVnodeThreads;
+extern int8_t   tsWorkStealing;
 extern float    tsRatioOfQueryCores;
+extern int32_t  tsQuerySliceTime;
+extern int32_t  tsMaxBatchQueries;
+extern char     tsBatchQueryUsers[];
 extern int8_t   tsDaylight;
 extern char     tsTimezone[];
 extern char     tsLocale[];
 extern char     tsCharset[];  // default encode string
 extern int8_t   tsEnableCoreFile;
 extern int32_t  tsCompressMsgSize;
+extern int32_t  tsCompressMsgCodec;
+extern int32_t  tsCompressMsgLevel;
 extern int32_t  tsCompressColData;
 extern int32_t  tsMaxNumOfDistinctResults;
 extern char     tsTempDir[];
+extern char     tsMetaCacheDir[];
 extern int32_t  tsShortcutFlag;
 
 // query buffer management
@@ -73,6 +83,12 @@ extern int32_t tsQueryBufferSize;  // maximum allowed usage buffer size in MB fo
 extern int64_t
     tsQueryBufferSizeBytes;  // maximum allowed usage buffer size in byte for each data node during query processing
 extern int32_t tsRetrieveBlockingModel;  // retrieve threads will be blocked
+extern int32_t tsQueryArena;             // allocate the runtime state of each query from an arena
+extern int32_t tsParallelScanThreads;    // threads of the dnode to scan the tables of a vnode for the super table queries
+extern int32_t tsBlockAggCacheSize;      // maximum memory in MB of each vnode to cache the partial aggregates of blocks
+extern int32_t tsReadAheadThreads;       // threads shared by the queries to read the file blocks ahead
+extern int32_t tsReadAheadBlocks;        // maximum file blocks each query reads ahead
+extern int32_t tsReadAheadBufferSize;    // maximum memory in MB of the blocks each query reads ahead
 
 extern int8_t tsKeepOriginalColumnName;
 
@@ -81,6 +97,7 @@ extern int32_t tsMaxSQLStringLen;
 extern int32_t tsMaxWildCardsLen;
 extern int32_t tsMaxRegexStringLen;
 extern int8_t  tsTscEnableRecordSql;
+extern int8_t  tsLocalJoin;  // join the super tables co-located in the vnodes there
 extern int32_t tsMaxNumOfOrderedResults;
 extern int32_t tsMinSlidingTime;
 extern int32_t tsMinIntervalTime;
@@ -117,6 +134,10 @@ extern int8_t  tsCacheLastRow;
 extern bool    tsdbForceKeepFile;
 extern bool    tsdbForceCompactFile;
 extern int32_t tsdbWalFlushSize;
+extern int32_t tsdbBloomFilterBits;
+extern int8_t  tsdbDeleteTombstone;
+extern int32_t tsCompactInterval;
+extern int32_t tsCompactMBps;
 
 // balance
 extern int8_t  tsEnableBalance;
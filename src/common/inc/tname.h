@@ -31,6 +31,17 @@ typedef struct SDataStatis {
   int16_t numOfNull;
 } SDataStatis;
 
+typedef struct SDataBloom {
+  int16_t  colId;
+  uint8_t  nHash;
+  uint32_t len;   // length of the bloom filter bitmap, 0 means no bloom filter for the column
+  uint8_t *bits;
+} SDataBloom;
+
+// data types that a per block bloom filter is built for
+#define IS_BLOOM_FILTER_TYPE(_t) \
+  (IS_SIGNED_NUMERIC_TYPE(_t) || IS_UNSIGNED_NUMERIC_TYPE(_t) || IS_TIMESTAMP_TYPE(_t) || IS_VAR_DATA_TYPE(_t))
+
 typedef struct SColumnInfoData {
   SColumnInfo info;
   char* pData;    // the corresponding block data in memory
@@ -55,12 +55,19 @@ int32_t  tsSyncCheckInterval = 1500;
 int32_t tsRpcTimer = 300;
 int32_t tsRpcMaxTime = 600;  // seconds;
 int32_t tsRpcForceTcp = 0;   // disable this, means query, show command use udp protocol as default
+int32_t tsRpcReusePort = 0;  // each TCP thread of the server accepts the connections on its own socket by SO_REUSEPORT
 int32_t tsMaxShellConns = 50000;
 int32_t tsMaxConnections = 5000;
 int32_t tsShellActivityTimer = 3;  // second
 float   tsNumOfThreadsPerCore = 1.0f;
 int32_t tsNumOfCommitThreads = 4;
+int32_t tsNumOfCommitCompressThreads = 0;  // threads shared by the commits to compress the columns of a block
+int32_t tsNumOfOpenVnodeThreads = 0;       // threads to open the vnodes and restore their wal at startup, 0 for all cores
+int8_t  tsWorkStealing = 1;  // the idle vwrite/vquery/vfetch workers take the vnode queues of the busy ones
 float   tsRatioOfQueryCores = 1.0f;
+int32_t tsQuerySliceTime = 0;   // ms a query runs before it is scheduled as a batch query, 0 disables the scheduling
+int32_t tsMaxBatchQueries = 0;  // batch queries running or preempted at the same time, 0 for half of the query threads
+char    tsBatchQueryUsers[TSDB_USER_LEN * 16] = {0};  // users whose queries are always batch queries, comma separated
 int8_t  tsDaylight = 0;
 char    tsTimezone[TSDB_TIMEZONE_LEN] = {0};
 char    tsLocale[TSDB_LOCALE_LEN] = {0};
@@ -79,6 +86,12 @@ int32_t tsShortcutFlag = 0;  // shortcut flag to facilitate debugging
  */
 int32_t tsCompressMsgSize = 512 * 1024;
 
+// the algorithm to compress the messages, 1: lz4, 2: zstd. lz4 is used if the peer is not able to decompress zstd
+int32_t tsCompressMsgCodec = 1;
+
+// the zstd compression level of the messages, a higher level costs more time
+int32_t tsCompressMsgLevel = 1;
+
 /* denote if server needs to compress the retrieved column data before adding to the rpc response message body.
  * 0: all data are compressed
  * -1: all data are not compressed
@@ -93,6 +106,10 @@ int32_t tsMaxRegexStringLen = TSDB_REGEX_STRING_DEFAULT_LEN;
 
 int8_t tsTscEnableRecordSql = 0;
 
+// join the super tables on timestamps in the vnodes, if the tables joined are in the same vnodes. It is off by
+// default, since the vnodes of the older versions skip the tables of the other side and return the rows unjoined.
+int8_t tsLocalJoin = 0;
+
 // the maximum number of results for projection query on super table that are returned from
 // one virtual node, to order according to timestamp
 int32_t tsMaxNumOfOrderedResults = 1000000;
@@ -131,6 +148,24 @@ int64_t tsQueryBufferSizeBytes = -1;
 // in retrieve blocking model, the retrieve threads will wait for the completion of the query processing.
 int32_t tsRetrieveBlockingModel = 0;
 
+// allocate the operators, function contexts and row buffers of each query from an arena freed with the query,
+// instead of malloc'ing and freeing them one by one.
+int32_t tsQueryArena = 1;
+
+// the threads of the dnode shared by the super table aggregation queries to scan the tables of a vnode in parallel, a
+// query scans the partitions left by them in its own thread. 0 or 1 disables the parallel scan
+int32_t tsParallelScanThreads = 0;
+
+// the maximum memory in MB of each vnode to cache the partial aggregates of the file blocks for repeated queries.
+// 0 disables the cache
+int32_t tsBlockAggCacheSize = 0;
+
+// the threads shared by the queries to read the file blocks ahead of them, 0 disables the read-ahead. Each query reads
+// at most tsReadAheadBlocks blocks ahead, which take at most tsReadAheadBufferSize MB.
+int32_t tsReadAheadThreads = 0;
+int32_t tsReadAheadBlocks = 4;
+int32_t tsReadAheadBufferSize = 16;
+
 // last_row(*), first(*), last_row(ts, col1, col2) query, the result fields will be the original column name
 int8_t tsKeepOriginalColumnName = 0;
 
@@ -162,6 +197,10 @@ int32_t tsTsdbMetaCompactRatio = TSDB_META_COMPACT_RATIO;
 bool    tsdbForceKeepFile = false;
 bool    tsdbForceCompactFile = false;                    // compact TSDB fileset forcibly
 int32_t tsdbWalFlushSize = TSDB_DEFAULT_WAL_FLUSH_SIZE;  // MB
+int32_t tsdbBloomFilterBits = TSDB_DEFAULT_BLOOM_FILTER_BITS;  // bits per row of the block bloom filter
+int8_t  tsdbDeleteTombstone = 1;  // record the deleted ranges as tombstones instead of rewriting the file blocks
+int32_t tsCompactInterval = 0;    // seconds between two rounds of the background compaction, 0 to disable it
+int32_t tsCompactMBps = 64;       // MB/s read by the background compaction of a vnode, 0 for no limit
 
 // balance
 int8_t  tsEnableBalance = 1;
@@ -210,6 +249,9 @@ char   tsMnodeBakDir[PATH_MAX] = {0};
 char   tsDataDir[PATH_MAX] = {0};
 char   tsScriptDir[PATH_MAX] = {0};
 char   tsTempDir[PATH_MAX] = "/tmp/";
+
+// directory of the client table meta cache snapshot, not saved if empty
+char   tsMetaCacheDir[PATH_MAX] = {0};
 int32_t tsKeepTimeOffset = 0;
 
 int32_t tsDiskCfgNum = 0;
@@ -567,6 +609,36 @@ static void doInitGlobalConfig(void) {
   cfg.unitType = TAOS_CFG_UTYPE_NONE;
   taosInitConfigOption(cfg);
 
+  cfg.option = "numOfCommitCompressThreads";
+  cfg.ptr = &tsNumOfCommitCompressThreads;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG;
+  cfg.minValue = 0;
+  cfg.maxValue = 100;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "numOfOpenVnodeThreads";
+  cfg.ptr = &tsNumOfOpenVnodeThreads;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG;
+  cfg.minValue = 0;
+  cfg.maxValue = 1024;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "workStealing";
+  cfg.ptr = &tsWorkStealing;
+  cfg.valType = TAOS_CFG_VTYPE_INT8;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 1;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
   cfg.option = "ratioOfQueryCores";
   cfg.ptr = &tsRatioOfQueryCores;
   cfg.valType = TAOS_CFG_VTYPE_FLOAT;
@@ -577,6 +649,36 @@ static void doInitGlobalConfig(void) {
   cfg.unitType = TAOS_CFG_UTYPE_NONE;
   taosInitConfigOption(cfg);
 
+  cfg.option = "querySliceTime";
+  cfg.ptr = &tsQuerySliceTime;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 3600000;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_MS;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "maxBatchQueries";
+  cfg.ptr = &tsMaxBatchQueries;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 1024;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "batchQueryUsers";
+  cfg.ptr = tsBatchQueryUsers;
+  cfg.valType = TAOS_CFG_VTYPE_STRING;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG;
+  cfg.minValue = 0;
+  cfg.maxValue = 0;
+  cfg.ptrLength = tListLen(tsBatchQueryUsers);
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
   cfg.option = "maxNumOfDistinctRes";
   cfg.ptr = &tsMaxNumOfDistinctResults;
   cfg.valType = TAOS_CFG_VTYPE_INT32;
@@ -769,6 +871,16 @@ static void doInitGlobalConfig(void) {
   cfg.unitType = TAOS_CFG_UTYPE_NONE;
   taosInitConfigOption(cfg);
 
+  cfg.option = "rpcReusePort";
+  cfg.ptr = &tsRpcReusePort;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 1;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
   cfg.option = "statusInterval";
   cfg.ptr = &tsStatusInterval;
   cfg.valType = TAOS_CFG_VTYPE_INT32;
@@ -1050,6 +1162,26 @@ static void doInitGlobalConfig(void) {
   cfg.unitType = TAOS_CFG_UTYPE_NONE;
   taosInitConfigOption(cfg);
 
+  cfg.option = "compressMsgCodec";
+  cfg.ptr = &tsCompressMsgCodec;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_CLIENT | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 1;
+  cfg.maxValue = 2;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "compressMsgLevel";
+  cfg.ptr = &tsCompressMsgLevel;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_CLIENT | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 1;
+  cfg.maxValue = 19;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
   cfg.option = "compressColData";
   cfg.ptr = &tsCompressColData;
   cfg.valType = TAOS_CFG_VTYPE_INT32;
@@ -1090,6 +1222,16 @@ static void doInitGlobalConfig(void) {
   cfg.unitType = TAOS_CFG_UTYPE_BYTE;
   taosInitConfigOption(cfg);
 
+  cfg.option = "localJoin";
+  cfg.ptr = &tsLocalJoin;
+  cfg.valType = TAOS_CFG_VTYPE_INT8;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_CLIENT | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 1;
+  cfg.ptrLength = 1;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
   cfg.option = "maxNumOfOrderedRes";
   cfg.ptr = &tsMaxNumOfOrderedResults;
   cfg.valType = TAOS_CFG_VTYPE_INT32;
@@ -1120,6 +1262,66 @@ static void doInitGlobalConfig(void) {
   cfg.unitType = TAOS_CFG_UTYPE_NONE;
   taosInitConfigOption(cfg);
 
+  cfg.option = "queryArena";
+  cfg.ptr = &tsQueryArena;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 1;
+  cfg.ptrLength = 1;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "parallelScanThreads";
+  cfg.ptr = &tsParallelScanThreads;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 256;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "blockAggCacheSize";
+  cfg.ptr = &tsBlockAggCacheSize;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 65536;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_MB;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "readAheadThreads";
+  cfg.ptr = &tsReadAheadThreads;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 256;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "readAheadBlocks";
+  cfg.ptr = &tsReadAheadBlocks;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 1;
+  cfg.maxValue = 256;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "readAheadBufferSize";
+  cfg.ptr = &tsReadAheadBufferSize;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 1;
+  cfg.maxValue = 4096;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_MB;
+  taosInitConfigOption(cfg);
+
   cfg.option = "keepColumnName";
   cfg.ptr = &tsKeepOriginalColumnName;
   cfg.valType = TAOS_CFG_VTYPE_INT8;
@@ -1647,6 +1849,16 @@ static void doInitGlobalConfig(void) {
   cfg.unitType = TAOS_CFG_UTYPE_NONE;
   taosInitConfigOption(cfg);
 
+  cfg.option = "metaCacheDir";
+  cfg.ptr = tsMetaCacheDir;
+  cfg.valType = TAOS_CFG_VTYPE_STRING;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_CLIENT;
+  cfg.minValue = 0;
+  cfg.maxValue = 0;
+  cfg.ptrLength = tListLen(tsMetaCacheDir);
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
   cfg.option = "tsdbMetaCompactRatio";
   cfg.ptr = &tsTsdbMetaCompactRatio;
   cfg.valType = TAOS_CFG_VTYPE_INT32;
@@ -1722,6 +1934,49 @@ static void doInitGlobalConfig(void) {
   cfg.unitType = TAOS_CFG_UTYPE_MB;
   taosInitConfigOption(cfg);
 
+  // bits per row of the bloom filter written for each file block column, 0 to disable
+  cfg.option = "blockBloomFilterBits";
+  cfg.ptr = &tsdbBloomFilterBits;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = TSDB_MIN_BLOOM_FILTER_BITS;
+  cfg.maxValue = TSDB_MAX_BLOOM_FILTER_BITS;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  // the deleted rows are filtered by the queries, and dropped from the files by the next commit or compaction
+  cfg.option = "deleteTombstone";
+  cfg.ptr = &tsdbDeleteTombstone;
+  cfg.valType = TAOS_CFG_VTYPE_INT8;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 1;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  // each round compacts the most fragmented file set of every vnode
+  cfg.option = "compactInterval";
+  cfg.ptr = &tsCompactInterval;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 86400;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_SECOND;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "compactMBps";
+  cfg.ptr = &tsCompactMBps;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 10240;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
   // shortcut flag to facilitate debugging
   cfg.option = "shortcutFlag";
   cfg.ptr = &tsShortcutFlag;
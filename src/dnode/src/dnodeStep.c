@@ -55,15 +55,21 @@ int32_t dnodeStepInit(SStep *pSteps, int32_t stepSize) {
 
     dnodeReportStep(pStep->name, "Start initialization", 0);
 
+    int64_t st = taosGetTimestampMs();
     int32_t code = (*pStep->initFp)();
     if (code != 0) {
       dDebug("step:%s will cleanup", pStep->name);
       taosStepCleanupImp(pSteps, step);
       return code;
     }
-    dInfo("step:%s is initialized", pStep->name);
 
-    dnodeReportStep(pStep->name, "Initialization complete", 0);
+    // the time of each step tells where the startup time goes, e.g. the wal replay of open-vnodes
+    char stepDesc[TSDB_STEP_DESC_LEN] = {0};
+    int64_t elapsed = taosGetTimestampMs() - st;
+    snprintf(stepDesc, TSDB_STEP_DESC_LEN, "Initialization complete in %" PRId64 " ms", elapsed);
+    dInfo("step:%s is initialized in %" PRId64 " ms", pStep->name, elapsed);
+
+    dnodeReportStep(pStep->name, stepDesc, 0);
   }
 
   return 0;
@@ -15,8 +15,10 @@
 
 #define _DEFAULT_SOURCE
 #include "os.h"
+#include "taosmsg.h"
 #include "tqueue.h"
 #include "tworker.h"
+#include "query.h"
 #include "dnodeVRead.h"
 
 static void *dnodeProcessReadQueue(void *pWorker);
@@ -31,16 +33,23 @@ int32_t dnodeInitVRead() {
   // calculate the available query thread
   float threadsForQuery = MAX(tsNumOfCores * tsRatioOfQueryCores, 1);
 
+  // the preempted batch queries hold their threads, so the scheduler asks for more threads than slots
+  if (qInitScheduler((int32_t) threadsForQuery) != 0) return -1;
+  if (qInitLocalJoin() != 0) return -1;
+  if (qInitParallelScan() != 0) return -1;
+
   tsVQueryWP.name = "vquery";
   tsVQueryWP.workerFp = dnodeProcessReadQueue;
-  tsVQueryWP.min = (int32_t) threadsForQuery;
+  tsVQueryWP.min = MAX((int32_t) threadsForQuery, qGetSchedulerThreads());
   tsVQueryWP.max = tsVQueryWP.min;
+  tsVQueryWP.stealing = tsWorkStealing;
   if (tWorkerInit(&tsVQueryWP) != 0) return -1;
 
   tsVFetchWP.name = "vfetch";
   tsVFetchWP.workerFp = dnodeProcessReadQueue;
   tsVFetchWP.min = MIN(maxFetchThreads, tsNumOfCores);
   tsVFetchWP.max = tsVFetchWP.min;
+  tsVFetchWP.stealing = tsWorkStealing;
   if (tWorkerInit(&tsVFetchWP) != 0) return -1;
 
   return 0;
@@ -49,6 +58,9 @@ int32_t dnodeInitVRead() {
 void dnodeCleanupVRead() {
   tWorkerCleanup(&tsVFetchWP);
   tWorkerCleanup(&tsVQueryWP);
+  qCleanupScheduler();
+  qCleanupLocalJoin();
+  qCleanupParallelScan();
 }
 
 void dnodeDispatchToVReadQueue(SRpcMsg *pMsg) {
@@ -126,7 +138,7 @@ static void *dnodeProcessReadQueue(void *wparam) {
   setThreadName(name);
 
   while (1) {
-    if (taosReadQitemFromQset(pPool->qset, &qtype, (void **)&pRead, &pVnode) == 0) {
+    if (taosReadQitemFromWorkerQset(pPool->qset, pWorker->id, &qtype, (void **)&pRead, &pVnode) == 0) {
       dDebug("dnode vquery got no message from qset:%p, exiting", pPool->qset);
       break;
     }
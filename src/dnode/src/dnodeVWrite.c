@@ -29,6 +29,7 @@ typedef struct {
 typedef struct {
   int32_t max;     // max number of workers
   int32_t nextId;  // from 0 to max-1, cyclic
+  taos_qset qset;  // shared by the workers if work stealing is enabled
   SVWriteWorker * worker;
   pthread_mutex_t mutex;
 } SVWriteWorkerPool;
@@ -36,6 +37,11 @@ typedef struct {
 static SVWriteWorkerPool tsVWriteWP;
 static void *dnodeProcessVWriteQueue(void *pWorker);
 
+static void dnodeCloseVWriteQset(SVWriteWorker *pWorker) {
+  if (pWorker->qset != tsVWriteWP.qset) taosCloseQset(pWorker->qset);
+  pWorker->qset = NULL;
+}
+
 int32_t dnodeInitVWrite() {
   tsVWriteWP.max = tsNumOfCores;
   tsVWriteWP.worker = tcalloc(sizeof(SVWriteWorker), tsVWriteWP.max);
@@ -46,7 +52,13 @@ int32_t dnodeInitVWrite() {
     tsVWriteWP.worker[i].workerId = i;
   }
 
-  dInfo("dnode vwrite is initialized, max worker %d", tsVWriteWP.max);
+  // the writes of a vnode are still processed by one worker at a time, but not always the same one
+  if (tsWorkStealing) {
+    tsVWriteWP.qset = taosOpenWorkerQset(tsVWriteWP.max);
+    if (tsVWriteWP.qset == NULL) return -1;
+  }
+
+  dInfo("dnode vwrite is initialized, max worker %d, work stealing:%d", tsVWriteWP.max, tsWorkStealing);
   return 0;
 }
 
@@ -63,10 +75,19 @@ void dnodeCleanupVWrite() {
     if (taosCheckPthreadValid(pWorker->thread)) {
       pthread_join(pWorker->thread, NULL);
       taosFreeQall(pWorker->qall);
-      taosCloseQset(pWorker->qset);
+      dnodeCloseVWriteQset(pWorker);
     }
   }
 
+  if (tsVWriteWP.qset != NULL) {
+    SQsetStat stat;
+    taosGetQsetStat(tsVWriteWP.qset, &stat);
+    dInfo("dnode vwrite reads:%" PRId64 " steals:%" PRId64 " contentions:%" PRId64, stat.numOfReads, stat.numOfSteals,
+          stat.numOfContentions);
+    taosCloseQset(tsVWriteWP.qset);
+    tsVWriteWP.qset = NULL;
+  }
+
   pthread_mutex_destroy(&tsVWriteWP.mutex);
   tfree(tsVWriteWP.worker);
   dInfo("dnode vwrite is closed");
@@ -116,7 +137,7 @@ void *dnodeAllocVWriteQueue(void *pVnode) {
   }
 
   if (pWorker->qset == NULL) {
-    pWorker->qset = taosOpenQset();
+    pWorker->qset = (tsVWriteWP.qset != NULL) ? tsVWriteWP.qset : taosOpenQset();
     if (pWorker->qset == NULL) {
       taosCloseQueue(queue);
       pthread_mutex_unlock(&tsVWriteWP.mutex);
@@ -126,7 +147,7 @@ void *dnodeAllocVWriteQueue(void *pVnode) {
     taosAddIntoQset(pWorker->qset, queue, pVnode);
     pWorker->qall = taosAllocateQall();
     if (pWorker->qall == NULL) {
-      taosCloseQset(pWorker->qset);
+      dnodeCloseVWriteQset(pWorker);
       taosCloseQueue(queue);
       pthread_mutex_unlock(&tsVWriteWP.mutex);
       return NULL;
@@ -138,7 +159,7 @@ void *dnodeAllocVWriteQueue(void *pVnode) {
     if (pthread_create(&pWorker->thread, &thAttr, dnodeProcessVWriteQueue, pWorker) != 0) {
       dError("failed to create thread to process vwrite queue since %s", strerror(errno));
       taosFreeQall(pWorker->qall);
-      taosCloseQset(pWorker->qset);
+      dnodeCloseVWriteQset(pWorker);
       taosCloseQueue(queue);
       queue = NULL;
     } else {
@@ -248,28 +269,49 @@ static void *dnodeProcessVWriteQueue(void *wparam) {
   setThreadName("dnodeWriteQ");
 
   while (1) {
-    numOfMsgs = taosReadAllQitemsFromQset(pWorker->qset, pWorker->qall, &pVnode);
+    numOfMsgs = taosReadAllQitemsFromWorkerQset(pWorker->qset, pWorker->workerId, pWorker->qall, &pVnode);
     if (numOfMsgs == 0) {
       dDebug("qset:%p, dnode vwrite got no message from qset, exiting", pWorker->qset);
       break;
     }
 
+    // the wal records of the msgs are written with one write, before the msgs are applied
+    void *pWal = vnodeGetWal(pVnode);
+    vnodeBeginWriteBatch(pVnode);
+
     bool forceFsync = false;
     for (int32_t i = 0; i < numOfMsgs; ++i) {
       taosGetQitem(pWorker->qall, &qtype, (void **)&pWrite);
       dTrace("msg:%p, app:%p type:%s will be processed in vwrite queue, qtype:%s hver:%" PRIu64, pWrite,
              pWrite->rpcMsg.ahandle, taosMsg[pWrite->walHead.msgType], qtypeStr[qtype], pWrite->walHead.version);
 
-      pWrite->code = vnodeProcessWrite(pVnode, &pWrite->walHead, qtype, pWrite);
+      pWrite->code = vnodeWriteToWal(pVnode, &pWrite->walHead, qtype, pWrite);
+      if (pWrite->code >= 0 && pWrite->walHead.msgType != TSDB_MSG_TYPE_SUBMIT) forceFsync = true;
+    }
+
+    int32_t walCode = vnodeEndWriteBatch(pVnode);
+    if (walCode == 0) walFsync(pWal, forceFsync);
+
+    taosResetQitems(pWorker->qall);
+    for (int32_t i = 0; i < numOfMsgs; ++i) {
+      taosGetQitem(pWorker->qall, &qtype, (void **)&pWrite);
+
+      if (pWrite->code >= 0) {
+        if (walCode != 0) {
+          // the wal record is not in the file, so the msg is not applied
+          if (pWrite->code > 0) atomic_sub_fetch_32(&pWrite->processedCount, 1);
+          pWrite->code = walCode;
+        } else {
+          pWrite->code = vnodeApplyWrite(pVnode, &pWrite->walHead, qtype, pWrite, pWrite->code);
+        }
+      }
+
       if (pWrite->code <= 0) atomic_add_fetch_32(&pWrite->processedCount, 1);
       if (pWrite->code > 0) pWrite->code = 0;
-      if (pWrite->code == 0 && pWrite->walHead.msgType != TSDB_MSG_TYPE_SUBMIT) forceFsync = true;
 
       dTrace("msg:%p is processed in vwrite queue, code:0x%x", pWrite, pWrite->code);
     }
 
-    walFsync(vnodeGetWal(pVnode), forceFsync);
-
     // browse all items, and process them one by one
     taosResetQitems(pWorker->qall);
     for (int32_t i = 0; i < numOfMsgs; ++i) {
@@ -27,7 +27,8 @@ typedef struct {
   int32_t   failed;
   int32_t   opened;
   int32_t   vnodeNum;
-  int32_t * vnodeList;
+  int32_t * vnodeList;  // shared by the threads, each takes the next vnode once it is free
+  int32_t * nextVnode;
 } SOpenVnodeThread;
 
 extern bool     dnodeExit;
@@ -90,27 +91,32 @@ static void *dnodeOpenVnode(void *param) {
   SOpenVnodeThread *pThread = param;
   char stepDesc[TSDB_STEP_DESC_LEN] = {0};
 
-  dDebug("thread:%d, start to open %d vnodes", pThread->threadIndex, pThread->vnodeNum);
+  dDebug("thread:%d, start to open vnodes", pThread->threadIndex);
   setThreadName("dnodeOpenVnode");
 
-  for (int32_t v = 0; v < pThread->vnodeNum; ++v) {
+  // the vnodes are taken one by one, so that a vnode with a long wal does not hold up the ones behind it
+  while (1) {
+    int32_t v = atomic_fetch_add_32(pThread->nextVnode, 1);
+    if (v >= pThread->vnodeNum) break;
+
     int32_t vgId = pThread->vnodeList[v];
     snprintf(stepDesc, TSDB_STEP_DESC_LEN, "vgId:%d, start to restore, %d of %d have been opened", vgId, tsOpenVnodes, tsTotalVnodes);
     dnodeReportStep("open-vnodes", stepDesc, 0);
 
+    int64_t st = taosGetTimestampMs();
     if (vnodeOpen(vgId) < 0) {
       dError("vgId:%d, failed to open vnode by thread:%d", vgId, pThread->threadIndex);
       pThread->failed++;
     } else {
-      dDebug("vgId:%d, is opened by thread:%d", vgId, pThread->threadIndex);
+      dDebug("vgId:%d, is opened by thread:%d in %" PRId64 " ms", vgId, pThread->threadIndex,
+             taosGetTimestampMs() - st);
       pThread->opened++;
     }
 
     atomic_add_fetch_32(&tsOpenVnodes, 1);
   }
 
-  dDebug("thread:%d, total vnodes:%d, opened:%d failed:%d", pThread->threadIndex, pThread->vnodeNum, pThread->opened,
-         pThread->failed);
+  dDebug("thread:%d, opened:%d failed:%d", pThread->threadIndex, pThread->opened, pThread->failed);
   return NULL;
 }
 
@@ -125,36 +131,25 @@ int32_t dnodeInitVnodes() {
     return status;
   }
 
-  int32_t threadNum = tsNumOfCores;
-  int32_t vnodesPerThread = numOfVnodes / threadNum + 1;
+  int32_t threadNum = (tsNumOfOpenVnodeThreads > 0) ? tsNumOfOpenVnodeThreads : tsNumOfCores;
+  if (threadNum > numOfVnodes) threadNum = MAX(numOfVnodes, 1);
+  int32_t nextVnode = 0;
   SOpenVnodeThread *threads = calloc(threadNum, sizeof(SOpenVnodeThread));
 
   if (threads == NULL) {
     return TSDB_CODE_DND_OUT_OF_MEMORY;
   }
 
-  for (int32_t t = 0; t < threadNum; ++t) {
-    threads[t].threadIndex = t;
-    threads[t].vnodeList = calloc(vnodesPerThread, sizeof(int32_t));
-
-    if (threads[t].vnodeList == NULL) {
-      dError("vnodeList allocation failed");
-      status = TSDB_CODE_DND_OUT_OF_MEMORY;
-      goto DNODE_INIT_VNODES_OUT;
-    }
-  }
-
-  for (int32_t v = 0; v < numOfVnodes; ++v) {
-    int32_t t = v % threadNum;
-    SOpenVnodeThread *pThread = &threads[t];
-    pThread->vnodeList[pThread->vnodeNum++] = vnodeList[v];
-  }
-
   dInfo("start %d threads to open %d vnodes", threadNum, numOfVnodes);
+  int64_t st = taosGetTimestampMs();
 
   for (int32_t t = 0; t < threadNum; ++t) {
     SOpenVnodeThread *pThread = &threads[t];
-    if (pThread->vnodeNum == 0) continue;
+    pThread->threadIndex = t;
+    pThread->vnodeNum = numOfVnodes;
+    pThread->vnodeList = vnodeList;
+    pThread->nextVnode = &nextVnode;
+    if (numOfVnodes == 0) continue;
 
     pthread_attr_t thAttr;
     pthread_attr_init(&thAttr);
@@ -177,19 +172,13 @@ int32_t dnodeInitVnodes() {
     failedVnodes += pThread->failed;
   }
 
-  dInfo("there are total vnodes:%d, opened:%d", numOfVnodes, openVnodes);
+  dInfo("there are total vnodes:%d, opened:%d in %" PRId64 " ms", numOfVnodes, openVnodes, taosGetTimestampMs() - st);
 
   if (failedVnodes != 0) {
     dError("there are total vnodes:%d, failed:%d", numOfVnodes, failedVnodes);
     status = TSDB_CODE_DND_VNODE_OPEN_FAILED;
   }
 
-DNODE_INIT_VNODES_OUT:
-
-  for (int32_t t = 0; t < threadNum; ++t) {
-    SOpenVnodeThread *pThread = &threads[t];
-    free(pThread->vnodeList);
-  }
   free(threads);
 
   return status;
@@ -99,6 +99,42 @@ void** qReleaseQInfo(void* pMgmt, void* pQInfo, bool freeHandle);
 bool checkQIdEqual(void *qHandle, uint64_t qId);
 int64_t genQueryId(void);
 
+/*
+ * the query scheduler of vnodes, the interactive queries are executed before the batch ones, which are the queries
+ * of the batch users and the ones that have run longer than the query slice time.
+ */
+#define QUERY_CLASS_INTERACTIVE 0
+#define QUERY_CLASS_BATCH       1
+#define QUERY_CLASS_MAX         2
+
+typedef struct SQueryClassStat {
+  int32_t running;         // queries being executed
+  int32_t waiting;         // queries waiting for a slot, the preempted ones included
+  int64_t numOfSlices;     // execution slices started since the last call
+  int64_t numOfPreempted;  // preempted between data blocks since the last call
+  int64_t waitUs;          // total time waiting for a slot since the last call
+  int64_t maxWaitUs;
+} SQueryClassStat;
+
+// put the qhandle kept by the scheduler back into the query queue, once a slot is reserved for it
+typedef void (*FQueryResume)(void *param, void **qhandle);
+
+int32_t qInitScheduler(int32_t slots);
+void    qCleanupScheduler(void);
+int32_t qGetSchedulerThreads(void);
+void    qSetQueryUser(qinfo_t qinfo, const char *user);
+bool    qAcquireExecSlot(void **qhandle, FQueryResume fp, void *param);
+void    qReleaseExecSlot(qinfo_t qinfo);
+void    qGetQueryClassStat(int32_t qclass, SQueryClassStat *pStat);
+
+// keep the timestamps joined in the vnodes for the other side of the joins
+int32_t qInitLocalJoin(void);
+void    qCleanupLocalJoin(void);
+
+// the threads scanning the partitions of the super table queries in parallel, shared by all queries
+int32_t qInitParallelScan(void);
+void    qCleanupParallelScan(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -298,6 +298,10 @@ do { \
 #define TSDB_MAX_WAL_FLUSH_SIZE         10000000 // MB
 #define TSDB_DEFAULT_WAL_FLUSH_SIZE     1024 // MB
 
+#define TSDB_MIN_BLOOM_FILTER_BITS      0       // 0 means no bloom filter is written for file blocks
+#define TSDB_MAX_BLOOM_FILTER_BITS      32
+#define TSDB_DEFAULT_BLOOM_FILTER_BITS  0
+
 #define TSDB_MIN_TABLES                 4
 #define TSDB_MAX_TABLES                 10000000
 #define TSDB_DEFAULT_TABLES             1000000
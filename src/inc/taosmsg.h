@@ -496,6 +496,14 @@ typedef struct {
   int32_t     tsOrder;          // ts comp block order
 } STsBufInfo;
 
+// the tables of the other side of a join in the same vnode, the i-th one is joined with the i-th table of the query
+typedef struct {
+  uint64_t     joinId;      // the same for all the sides of a join
+  int32_t      numOfSides;  // the sides of the join sent to the vnode
+  int32_t      numOfTables;
+  STableIdInfo tables[];
+} SLocalJoinMsg;
+
 typedef struct {
   SMsgHead    head;
   int8_t      extend;
@@ -1021,6 +1029,7 @@ enum {
   TLV_TYPE_END_MARK = -1,
   //TLV_TYPE_DUMMY = 1,
   TLV_TYPE_META_VERSION = 1,
+  TLV_TYPE_LOCAL_JOIN = 2,
 };
 
 #pragma pack(pop)
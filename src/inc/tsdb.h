@@ -338,6 +338,52 @@ void tsdbRetrieveDataBlockInfo(TsdbQueryHandleT *pQueryHandle, SDataBlockInfo *p
  */
 int32_t tsdbRetrieveDataBlockStatisInfo(TsdbQueryHandleT *pQueryHandle, SDataStatis **pBlockStatis);
 
+/**
+ *
+ * Get the bloom filters of the columns w.r.t. current data block.
+ *
+ * The pBlockBloom will be NULL if current data block has no bloom filter, which is the same case as pBlockStatis.
+ *
+ * @pBlockBloom the bloom filter of each column for current data block, in the same order as the statistics
+ * @return
+ */
+int32_t tsdbRetrieveDataBlockBloomInfo(TsdbQueryHandleT *pQueryHandle, SDataBloom **pBlockBloom);
+
+/**
+ *
+ * Check if the partial aggregates of current data block can be cached, which is true only for the completed data
+ * blocks in the files. The cache is dropped once the file system version changes by commit, compact or delete.
+ *
+ * @param pQueryHandle      query handle
+ * @return
+ */
+bool tsdbIsDataBlockAggCacheable(TsdbQueryHandleT *pQueryHandle);
+
+/**
+ *
+ * Get the partial aggregates of current data block cached by a previous query with the same signature.
+ *
+ * @param pQueryHandle      query handle
+ * @param sig               signature of the aggregates, e.g. the time windows and columns of the query
+ * @param sigLen            length of the signature
+ * @param len               length of the returned aggregates
+ * @return a copy of the cached aggregates that should be freed by the caller, or NULL if absent
+ */
+void *tsdbGetDataBlockAggCache(TsdbQueryHandleT *pQueryHandle, const void *sig, int32_t sigLen, int32_t *len);
+
+/**
+ *
+ * Put the partial aggregates of current data block into the cache, ignored if the block is not cacheable.
+ *
+ * @param pQueryHandle      query handle
+ * @param sig               signature of the aggregates
+ * @param sigLen            length of the signature
+ * @param pAgg              the aggregates to cache
+ * @param len               length of the aggregates
+ */
+void tsdbPutDataBlockAggCache(TsdbQueryHandleT *pQueryHandle, const void *sig, int32_t sigLen, const void *pAgg,
+                              int32_t len);
+
 /**
  *
  * The query condition with primary timestamp is passed to iterator during its constructor function,
@@ -398,6 +444,15 @@ int32_t tsdbGetFileBlocksDistInfo(TsdbQueryHandleT* queryHandle, STableBlockDist
 // obtain queryHandle attribute
 int64_t tsdbSkipOffset(TsdbQueryHandleT queryHandle);
 
+/**
+ * get the reads of the file blocks served by the read-ahead of the query handle, all zero if it is disabled
+ * @param queryHandle
+ * @param hits. reads served by the blocks read ahead
+ * @param misses. reads from the files
+ * @param wastes. blocks read ahead but dropped without being read by the query
+ */
+void tsdbGetReadAheadStat(TsdbQueryHandleT queryHandle, int64_t *hits, int64_t *misses, int64_t *wastes);
+
 /**
  * get the statistics of repo usage
  * @param repo. point to the tsdbrepo
@@ -409,17 +464,32 @@ void tsdbReportStat(void *repo, int64_t *totalPoints, int64_t *totalStorage, int
 
 int  tsdbInitCommitQueue();
 void tsdbDestroyCommitQueue();
+int  tsdbInitReadAhead();
+void tsdbDestroyReadAhead();
 int  tsdbSyncCommit(STsdbRepo *repo);
 void tsdbIncCommitRef(int vgId);
 void tsdbDecCommitRef(int vgId);
 void tsdbSwitchTable(TsdbQueryHandleT pQueryHandle);
 
 // For TSDB file sync
-int tsdbSyncSend(void *pRepo, SOCKET socketFd);
-int tsdbSyncRecv(void *pRepo, SOCKET socketFd);
+int tsdbSyncSend(void *pRepo, SOCKET socketFd, int64_t *bytes);
+int tsdbSyncRecv(void *pRepo, SOCKET socketFd, int64_t *bytes);
 
 // For TSDB Compact
-int tsdbCompact(STsdbRepo *pRepo);
+typedef struct {
+  int8_t  state;           // TSDB_NO_COMPACT, TSDB_IN_COMPACT or TSDB_WAITING_COMPACT
+  int32_t numOfFSets;      // file sets scored by the last background compaction
+  int32_t numOfDebtFSets;  // file sets scored high enough to be compacted
+  int64_t debtBytes;       // size of the data and last files of them
+  float   maxScore;
+  int64_t compactedFSets;  // file sets compacted in the background since the repo is opened
+  int64_t compactedBytes;
+  int64_t numOfPaused;     // background compactions put off or given up for the memory pressure
+} STsdbCompactStat;
+
+int  tsdbCompact(STsdbRepo *pRepo);
+int  tsdbAutoCompact(STsdbRepo *pRepo);
+void tsdbGetCompactStat(STsdbRepo *pRepo, STsdbCompactStat *pStat);
 
 // For TSDB delete data
 int tsdbDeleteData(STsdbRepo *pRepo, void *param);
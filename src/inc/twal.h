@@ -61,6 +61,8 @@ int32_t  walRenew(twalh);
 void     walRemoveOneOldFile(twalh);
 void     walRemoveAllOldFiles(twalh);
 int32_t  walWrite(twalh, SWalHead *);
+void     walBeginBatch(twalh);
+int32_t  walEndBatch(twalh);
 void     walFsync(twalh, bool forceFsync);
 int32_t  walRestore(twalh, void *pVnode, FWalWrite writeFp);
 int32_t  walGetWalFile(twalh, char *fileName, int64_t *fileId);
@@ -21,6 +21,7 @@ extern "C" {
 #endif
 #include "trpc.h"
 #include "twal.h"
+#include "tsdb.h"
 
 typedef struct {
   int64_t submitReqSucNum;
@@ -86,6 +87,7 @@ void    vnodeRelease(void *pVnode);
 void*   vnodeAcquireNotClose(int32_t vgId);
 void*   vnodeGetWal(void *pVnode);
 int32_t vnodeGetVnodeList(int32_t vnodeList[], int32_t *numOfVnodes);
+int32_t vnodeGetCompactStat(int32_t vgId, STsdbCompactStat *pStat);
 void    vnodeBuildStatusMsg(void *pStatus);
 void    vnodeSetAccess(SVgroupAccess *pAccess, int32_t numOfVnodes);
 
@@ -93,6 +95,10 @@ void    vnodeSetAccess(SVgroupAccess *pAccess, int32_t numOfVnodes);
 int32_t vnodeWriteToWQueue(void *pVnode, void *pHead, int32_t qtype, void *pRpcMsg);
 void    vnodeFreeFromWQueue(void *pVnode, SVWriteMsg *pWrite);
 int32_t vnodeProcessWrite(void *pVnode, void *pHead, int32_t qtype, void *pRspRet);
+void    vnodeBeginWriteBatch(void *pVnode);
+int32_t vnodeEndWriteBatch(void *pVnode);
+int32_t vnodeWriteToWal(void *pVnode, void *pHead, int32_t qtype, void *pRspRet);
+int32_t vnodeApplyWrite(void *pVnode, void *pHead, int32_t qtype, void *pRspRet, int32_t syncCode);
 
 SVnodeStatisInfo vnodeGetStatisInfo();
 
@@ -165,6 +165,8 @@ extern "C" {
     #define atomic_xor_fetch_ptr atomic_xor_fetch_32
     #define atomic_fetch_xor_ptr atomic_fetch_xor_32
   #endif
+
+  #define atomic_load_barrier() MemoryBarrier()
 #elif defined(_TD_NINGSI_60)
   /*
   * type __sync_fetch_and_add (type *ptr, type value);
@@ -274,6 +276,7 @@ extern "C" {
   #define atomic_fetch_xor_64(ptr, val) __sync_fetch_and_xor((ptr), (val))
   #define atomic_fetch_xor_ptr(ptr, val) __sync_fetch_and_xor((ptr), (val))
 
+  #define atomic_load_barrier() __sync_synchronize()
 #else
   #define atomic_load_8(ptr) __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
   #define atomic_load_16(ptr) __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
@@ -358,6 +361,8 @@ extern "C" {
   #define atomic_fetch_xor_32(ptr, val) __atomic_fetch_xor((ptr), (val), __ATOMIC_SEQ_CST)
   #define atomic_fetch_xor_64(ptr, val) __atomic_fetch_xor((ptr), (val), __ATOMIC_SEQ_CST)
   #define atomic_fetch_xor_ptr(ptr, val) __atomic_fetch_xor((ptr), (val), __ATOMIC_SEQ_CST)
+
+  #define atomic_load_barrier() __atomic_thread_fence(__ATOMIC_ACQUIRE)
 #endif
 
 #ifdef __cplusplus
@@ -104,6 +104,41 @@ int64_t taosRead(FileFd fd, void *buf, int64_t count) {
   return count;
 }
 
+#if defined(_TD_WINDOWS_64) || defined(_TD_WINDOWS_32)
+
+int64_t taosPRead(FileFd fd, void *buf, int64_t count, int64_t offset) {
+  errno = ENOTSUP;
+  return -1;
+}
+
+#else
+
+int64_t taosPRead(FileFd fd, void *buf, int64_t count, int64_t offset) {
+  int64_t leftbytes = count;
+  int64_t readbytes;
+  char *  tbuf = (char *)buf;
+
+  while (leftbytes > 0) {
+    readbytes = pread(fd, (void *)tbuf, (size_t)leftbytes, (off_t)(offset + count - leftbytes));
+    if (readbytes < 0) {
+      if (errno == EINTR) {
+        continue;
+      } else {
+        return -1;
+      }
+    } else if (readbytes == 0) {
+      return (int64_t)(count - leftbytes);
+    }
+
+    leftbytes -= readbytes;
+    tbuf += readbytes;
+  }
+
+  return count;
+}
+
+#endif
+
 int64_t taosWrite(FileFd fd, void *buf, int64_t n) {
   int64_t nleft = n;
   int64_t nwritten = 0;
@@ -24,6 +24,7 @@
 #include "tsclient.h"
 #include "dnode.h"
 #include "vnode.h"
+#include "query.h"
 #include "monitor.h"
 #include "taoserror.h"
 
@@ -130,6 +131,8 @@ typedef enum {
   MON_CMD_CREATE_TB_GRANTS,
   MON_CMD_CREATE_MT_RESTFUL,
   MON_CMD_CREATE_TB_RESTFUL,
+  MON_CMD_CREATE_MT_QUERY_CLASS,
+  MON_CMD_CREATE_MT_COMPACT,
   MON_CMD_MAX
 } EMonCmd;
 
@@ -174,6 +177,8 @@ static void  monSaveVgroupsInfo();
 static void  monSaveDisksInfo();
 static void  monSaveGrantsInfo();
 static void  monSaveHttpReqInfo();
+static void  monSaveQueryClassInfo();
+static void  monSaveCompactInfo();
 static void  monGetSysStats();
 static void *monThreadFunc(void *param);
 static void  monBuildMonitorSql(char *sql, int32_t cmd);
@@ -323,6 +328,8 @@ static void *monThreadFunc(void *param) {
         monSaveDisksInfo();
         monSaveGrantsInfo();
         monSaveHttpReqInfo();
+        monSaveQueryClassInfo();
+        monSaveCompactInfo();
         monSaveSystemInfo();
       }
     }
@@ -475,6 +482,19 @@ static void monBuildMonitorSql(char *sql, int32_t cmd) {
   } else if (cmd == MON_CMD_CREATE_TB_RESTFUL) {
     snprintf(sql, SQL_LENGTH, "create table if not exists %s.restful_%d using %s.restful_info tags(%d, '%s')", tsMonitorDbName,
              dnodeGetDnodeId(), tsMonitorDbName, dnodeGetDnodeId(), tsLocalEp);
+  } else if (cmd == MON_CMD_CREATE_MT_QUERY_CLASS) {
+    snprintf(sql, SQL_LENGTH,
+             "create table if not exists %s.query_class_info(ts timestamp"
+             ", running int, waiting int, slices bigint, preempted bigint, wait_us bigint, max_wait_us bigint"
+             ") tags (dnode_id int, dnode_ep binary(%d), class binary(16))",
+             tsMonitorDbName, TSDB_EP_LEN);
+  } else if (cmd == MON_CMD_CREATE_MT_COMPACT) {
+    snprintf(sql, SQL_LENGTH,
+             "create table if not exists %s.compact_info(ts timestamp"
+             ", compact_state tinyint, fsets int, debt_fsets int, debt_bytes bigint, max_score float"
+             ", compacted_fsets bigint, compacted_bytes bigint, paused bigint"
+             ") tags (dnode_id int, dnode_ep binary(%d), vgroup_id int)",
+             tsMonitorDbName, TSDB_EP_LEN);
   }
 
   sql[SQL_LENGTH] = 0;
@@ -1310,6 +1330,97 @@ static void monSaveHttpReqInfo() {
   }
 }
 
+static void monSaveQueryClassInfo() {
+  static const char *className[QUERY_CLASS_MAX] = {"interactive", "batch"};
+
+  // the query scheduler is not enabled
+  if (tsQuerySliceTime <= 0) return;
+
+  int64_t ts = taosGetTimestampUs();
+  char *  sql = tsMonitor.sql;
+  int32_t pos = snprintf(sql, SQL_LENGTH, "insert into");
+
+  for (int32_t i = 0; i < QUERY_CLASS_MAX; ++i) {
+    SQueryClassStat stat;
+    qGetQueryClassStat(i, &stat);
+    pos += snprintf(sql + pos, SQL_LENGTH - pos,
+                    " %s.query_class_%d_%s using %s.query_class_info tags(%d, '%s', '%s') values(%" PRId64
+                    ", %d, %d, %" PRId64 ", %" PRId64 ", %" PRId64 ", %" PRId64 ")",
+                    tsMonitorDbName, dnodeGetDnodeId(), className[i], tsMonitorDbName, dnodeGetDnodeId(), tsLocalEp,
+                    className[i], ts, stat.running, stat.waiting, stat.numOfSlices, stat.numOfPreempted, stat.waitUs,
+                    stat.maxWaitUs);
+  }
+
+  monDebug("save query class, sql:%s", sql);
+
+  void *res = taos_query(tsMonitor.conn, tsMonitor.sql);
+  int32_t code = taos_errno(res);
+  taos_free_result(res);
+
+  if (code != 0) {
+    monError("failed to save query class info, reason:%s, sql:%s", tstrerror(code), tsMonitor.sql);
+  } else {
+    monIncSubmitReqCnt();
+    monDebug("successfully to save query class info, sql:%s", tsMonitor.sql);
+  }
+}
+
+static void monExecCompactSql(int32_t numOfVnodes) {
+  monDebug("save compact, sql:%s", tsMonitor.sql);
+
+  void *res = taos_query(tsMonitor.conn, tsMonitor.sql);
+  int32_t code = taos_errno(res);
+  taos_free_result(res);
+
+  if (code != 0) {
+    monError("failed to save compact info of %d vnodes, reason:%s, sql:%s", numOfVnodes, tstrerror(code),
+             tsMonitor.sql);
+  } else {
+    monIncSubmitReqCnt();
+    monDebug("successfully to save compact info of %d vnodes, sql:%s", numOfVnodes, tsMonitor.sql);
+  }
+}
+
+static void monSaveCompactInfo() {
+  // the background compaction is not enabled
+  if (tsCompactInterval <= 0) return;
+
+  int32_t *vgIds = calloc(TSDB_MAX_VNODES, sizeof(int32_t));
+  int32_t  numOfVnodes = 0;
+  if (vgIds == NULL) return;
+
+  vnodeGetVnodeList(vgIds, &numOfVnodes);
+  numOfVnodes = MIN(numOfVnodes, TSDB_MAX_VNODES);
+
+  int64_t ts = taosGetTimestampUs();
+  char *  sql = tsMonitor.sql;
+  int32_t pos = 0;
+  int32_t num = 0;
+
+  for (int32_t i = 0; i < numOfVnodes; ++i) {
+    STsdbCompactStat stat;
+    if (vnodeGetCompactStat(vgIds[i], &stat) != TSDB_CODE_SUCCESS) continue;
+
+    if (num == 0) pos = snprintf(sql, SQL_LENGTH, "insert into");
+    pos += snprintf(sql + pos, SQL_LENGTH - pos,
+                    " %s.compact_%d_%d using %s.compact_info tags(%d, '%s', %d) values(%" PRId64
+                    ", %d, %d, %d, %" PRId64 ", %f, %" PRId64 ", %" PRId64 ", %" PRId64 ")",
+                    tsMonitorDbName, dnodeGetDnodeId(), vgIds[i], tsMonitorDbName, dnodeGetDnodeId(), tsLocalEp,
+                    vgIds[i], ts, stat.state, stat.numOfFSets, stat.numOfDebtFSets, stat.debtBytes, stat.maxScore,
+                    stat.compactedFSets, stat.compactedBytes, stat.numOfPaused);
+    num++;
+
+    // the sql is sent once it can not hold one more vnode
+    if (pos > SQL_LENGTH - 512) {
+      monExecCompactSql(num);
+      num = 0;
+    }
+  }
+
+  if (num > 0) monExecCompactSql(num);
+  free(vgIds);
+}
+
 static void monExecSqlCb(void *param, TAOS_RES *result, int32_t code) {
   int32_t c = taos_errno(result);
   if (c != TSDB_CODE_SUCCESS) {
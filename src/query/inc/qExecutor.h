@@ -28,6 +28,7 @@
 #include "taosdef.h"
 #include "tarray.h"
 #include "tlockfree.h"
+#include "tmempool.h"
 #include "tsdb.h"
 #include "qUdf.h"
 
@@ -187,6 +188,7 @@ typedef struct SQueryCostInfo {
   uint32_t totalBlocks;
   uint32_t loadBlocks;
   uint32_t loadBlockStatis;
+  uint32_t loadBlockBloom;
   uint32_t discardBlocks;
   uint64_t elapsedTime;
   uint64_t firstStageMergeTime;
@@ -194,6 +196,16 @@ typedef struct SQueryCostInfo {
   uint64_t tableInfoSize;
   uint64_t hashSize;
   uint64_t numOfTimeWindows;
+  uint32_t spillPages;     // pages of the result buffer flushed to disk
+  uint32_t reloadPages;
+  uint32_t colCompPages;   // spilled pages compressed column by column
+  uint64_t spillBytes;
+  uint64_t reloadBytes;
+  uint32_t aggCacheHits;   // data blocks whose time window aggregates are found in the vnode cache
+  uint32_t aggCacheMisses;
+  uint64_t readAheadHits;   // reads of the file blocks served by the read-ahead of tsdb
+  uint64_t readAheadMisses;
+  uint64_t readAheadWastes; // blocks read ahead but not read by the query
 
   SArray*   queryProfEvents;  //SArray<SQueryProfEvent>
   SHashObj* operatorProfResults; //map<operator_type, SQueryProfEvent>
@@ -331,6 +343,7 @@ typedef struct SQueryRuntimeEnv {
   bool                  udfIsCopy;
   SHashObj             *pTablesRead;    // record child tables already read rows by tid hash
   int32_t              cntTableReadOver; // read table over count  
+  SMemArena            *pArena;          // operators, function contexts and row buffers of the query, freed as a whole
 } SQueryRuntimeEnv;
 
 enum {
@@ -365,6 +378,7 @@ enum OPERATOR_TYPE_E {
   OP_TimeEvery         = 23,
   OP_AllMultiTableTimeInterval = 24,
   OP_Order             = 25,
+  OP_ParallelAggregate = 26,   // aggregate the partitions of one table group in parallel
 };
 
 typedef struct SOperatorInfo {
@@ -413,6 +427,16 @@ typedef struct SQInfo {
   int64_t          lastRetrieveTs; // last retrieve timestamp  
   char*            sql;         // query sql string
   SQueryCostInfo   summary;
+
+  struct SQInfo*   pParent;     // the query this partition belongs to, if it is a partition of a parallel scan
+  char*            colCond;     // column condition to create the filters of the parallel scan partitions
+  int32_t          colCondLen;
+
+  int8_t           qclass;      // class of the query in the vnode query scheduler
+  int8_t           schedState;  // if it holds or waits for a slot of the scheduler
+  int64_t          execUs;      // time of the execution slices done
+  int64_t          sliceTs;     // start time of the current slice
+  int64_t          queuedTs;    // the time it starts to wait for a slot
 } SQInfo;
 
 typedef struct SQueryParam {
@@ -436,6 +460,10 @@ typedef struct SQueryParam {
   SUdfInfo        *pUdfInfo;
   int16_t         schemaVersion;
   int16_t         tagVersion;
+  uint64_t        localJoinId;
+  int32_t         localJoinSides;
+  SArray          *pJoinTableIdList;  // tables of the other side of the join done in the vnode
+  STSBuf          *pJoinTsBuf;        // timestamps joined in the vnode
 } SQueryParam;
 
 typedef struct SColumnDataParam{
@@ -465,6 +493,12 @@ typedef struct STableScanInfo {
 
   int32_t         tableIndex;
   int32_t         prevGroupId;     // previous table group id
+
+  char           *aggCacheSig;     // signature of the cached time window aggregates, NULL if not cacheable
+  int32_t         aggCacheSigLen;
+  char           *pAggWin;         // cached time windows of current data block, each followed by its statistics
+  int32_t         numOfAggWin;
+  int32_t         aggWinIndex;     // the next time window to return
 } STableScanInfo;
 
 typedef struct STagScanInfo {
@@ -488,6 +522,12 @@ typedef struct SAggOperatorInfo {
   uint32_t       seed;
 } SAggOperatorInfo;
 
+typedef struct SParallelAggOperatorInfo {
+  SSDataBlock   *pRes;
+  int32_t        numOfParts;
+  SQInfo       **pParts;      // each partition scans and aggregates a subset of the tables in its own thread
+} SParallelAggOperatorInfo;
+
 typedef struct SProjectOperatorInfo {
   SOptrBasicInfo binfo;
   int32_t        bufCapacity;
@@ -642,6 +682,7 @@ SOperatorInfo* createSWindowOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperato
 SOperatorInfo* createFillOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput, bool multigroupResult);
 SOperatorInfo* createGroupbyOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput);
 SOperatorInfo* createMultiTableAggOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput);
+SOperatorInfo* createParallelAggOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput);
 SOperatorInfo* createMultiTableTimeIntervalOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput);
 SOperatorInfo* createTimeEveryOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput);
 SOperatorInfo* createTagScanOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SExprInfo* pExpr, int32_t numOfOutput);
@@ -696,6 +737,8 @@ SQInfo *createQInfoImpl(SQueryTableMsg *pQueryMsg, SGroupbyExpr *pGroupbyExpr, S
 
 int32_t initQInfo(STsBufInfo* pTsBufInfo, void* tsdb, void* sourceOptr, SQInfo* pQInfo, SQueryParam* param, char* start,
                   int32_t prevResultLen, void* merger);
+int32_t qLocalJoin(void* tsdb, int32_t vgId, SQueryTableMsg* pQueryMsg, SQueryParam* param, uint64_t qId);
+void doSetTagValueInParam(void* pTable, char* param, int32_t paramLen, int32_t tagColId, tVariant *tag, int16_t type, int16_t bytes);
 
 int32_t createFilterInfo(SQueryAttr* pQueryAttr, uint64_t qId);
 void freeColumnFilterInfo(SColumnFilterInfo* pFilter, int32_t numOfFilters);
@@ -720,6 +763,7 @@ int32_t doDumpQueryResult(SQInfo *pQInfo, char *data, int8_t compressed, int32_t
 
 size_t getResultSize(SQInfo *pQInfo, int64_t *numOfRows);
 void setQueryKilled(SQInfo *pQInfo);
+void qYieldExecSlot(SQInfo *pQInfo);
 
 void publishOperatorProfEvent(SOperatorInfo* operatorInfo, EQueryProfEventType eventType);
 void publishQueryAbortEvent(SQInfo* pQInfo, int32_t code);
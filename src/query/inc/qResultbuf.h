@@ -46,12 +46,20 @@ typedef struct SFreeListItem {
   int32_t len;
 } SFreeListItem;
 
+typedef struct SPageColInfo {
+  int16_t type;
+  int32_t offset;  // offset of the column in a row
+  int32_t bytes;
+} SPageColInfo;
+
 typedef struct SResultBufStatis {
   int32_t flushBytes;
   int32_t loadBytes;
   int32_t getPages;
   int32_t releasePages;
   int32_t flushPages;
+  int32_t loadPages;
+  int32_t colCompPages;  // pages compressed column by column when flushed
 } SResultBufStatis;
 
 typedef struct SDiskbasedResultBuf {
@@ -72,6 +80,11 @@ typedef struct SDiskbasedResultBuf {
   bool      comp;                // compressed before flushed to disk
   int32_t   nextPos;             // next page flush position
 
+  int32_t       rowSize;         // size of the rows in a page, 0 if the layout of the rows is not set
+  int32_t       numOfCols;
+  SPageColInfo* pCols;           // columns covering a row with no gaps, to compress the pages column by column
+  void*         colBuf;          // buffer to gather the values of a column
+
   uint64_t  qId;                 // for debug purpose
   SResultBufStatis statis;
 } SDiskbasedResultBuf;
@@ -93,6 +106,17 @@ typedef struct SDiskbasedResultBuf {
  */
 int32_t createDiskbasedResultBuffer(SDiskbasedResultBuf** pResultBuf, int32_t pagesize, int32_t inMemBufSize, uint64_t qId);
 
+/**
+ * set the layout of the fixed size rows that fill the pages, so that the pages are compressed column by column with
+ * the codec of each column type before flushed to disk
+ * @param pResultBuf
+ * @param rowSize
+ * @param pCols      columns in the row, sorted by the offset
+ * @param numOfCols
+ * @return
+ */
+int32_t setResultBufPageLayout(SDiskbasedResultBuf* pResultBuf, int32_t rowSize, const SPageColInfo* pCols, int32_t numOfCols);
+
 /**
  *
  * @param pResultBuf
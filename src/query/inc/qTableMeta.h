@@ -124,6 +124,9 @@ typedef struct SQueryInfo {
   int16_t          curTableIdx;
   STableMetaInfo **pTableMetaInfo;
   struct STSBuf   *tsBuf;
+  uint64_t         localJoinId;       // join done on timestamps in the vnodes if not 0
+  int32_t          localJoinSides;    // the sides of the join sent to the vnodes
+  SArray          *pJoinVgroupTables; // SArray<SVgroupTableInfo>, tables of the other side of the join
 
   int16_t          fillType;      // final result fill type
   int64_t *        fillVal;       // default value for fill
@@ -33,6 +33,7 @@
 #include "cJSON.h"
 #include "tsdbMeta.h"
 #include "tscUtil.h"
+#include "tsched.h"
 
 #define IS_MASTER_SCAN(runtime)        ((runtime)->scanFlag == MASTER_SCAN)
 #define IS_REVERSE_SCAN(runtime)       ((runtime)->scanFlag == REVERSE_SCAN)
@@ -47,6 +48,15 @@
 
 #define MULTI_KEY_DELIM  "-"
 
+// the minimum number of tables scanned by each partition of a parallel scan
+#define PARALLEL_SCAN_MIN_TABLES  100
+
+// the partitions queued for the threads of the parallel scan at most, per thread
+#define PARALLEL_SCAN_QUEUE_RATIO 4
+
+// the size of the blocks the per-query runtime state is carved out of
+#define QUERY_ARENA_BLOCK_SIZE    (16 * 1024)
+
 enum {
   TS_JOIN_TS_EQUAL       = 0,
   TS_JOIN_TS_NOT_EQUALS  = 1,
@@ -229,12 +239,15 @@ static void destroyBasicOperatorInfo(void* param, int32_t numOfOutput);
 static void destroySFillOperatorInfo(void* param, int32_t numOfOutput);
 static void destroyGroupbyOperatorInfo(void* param, int32_t numOfOutput);
 static void destroyProjectOperatorInfo(void* param, int32_t numOfOutput);
+static void destroyTableScanOperatorInfo(void* param, int32_t numOfOutput);
 static void destroyTagScanOperatorInfo(void* param, int32_t numOfOutput);
 static void destroyOrderOperatorInfo(void* param, int32_t numOfOutput);
 static void destroySWindowOperatorInfo(void* param, int32_t numOfOutput);
 static void destroyStateWindowOperatorInfo(void* param, int32_t numOfOutput);
 static void destroyAggOperatorInfo(void* param, int32_t numOfOutput);
+static void destroyParallelAggOperatorInfo(void* param, int32_t numOfOutput);
 static void destroyOperatorInfo(SOperatorInfo* pOperator);
+static bool isParallelScanQuery(SQInfo* pQInfo, int32_t tbScanner, SArray* pOperator);
 
 static void doSetOperatorCompleted(SOperatorInfo* pOperator) {
   pOperator->status = OP_EXEC_DONE;
@@ -1972,14 +1985,14 @@ static SQLFunctionCtx* createSQLFunctionCtx(SQueryRuntimeEnv* pRuntimeEnv, SExpr
                                             int32_t** rowCellInfoOffset, int32_t numOfRows) {
   SQueryAttr* pQueryAttr = pRuntimeEnv->pQueryAttr;
 
-  SQLFunctionCtx * pFuncCtx = (SQLFunctionCtx *)calloc(numOfOutput, sizeof(SQLFunctionCtx));
+  SQLFunctionCtx * pFuncCtx = (SQLFunctionCtx *)taosArenaCalloc(pRuntimeEnv->pArena, numOfOutput, sizeof(SQLFunctionCtx));
   if (pFuncCtx == NULL) {
     return NULL;
   }
 
-  *rowCellInfoOffset = calloc(numOfOutput, sizeof(int32_t));
+  *rowCellInfoOffset = taosArenaCalloc(pRuntimeEnv->pArena, numOfOutput, sizeof(int32_t));
   if (*rowCellInfoOffset == 0) {
-    tfree(pFuncCtx);
+    taosArenaFree(pFuncCtx);
     return NULL;
   }
 
@@ -2097,7 +2110,7 @@ static void* destroySQLFunctionCtx(SQLFunctionCtx* pCtx, int32_t numOfOutput) {
     tfree(pCtx[i].tagInfo.pTagCtxList);
   }
 
-  tfree(pCtx);
+  taosArenaFree(pCtx);
   return NULL;
 }
 
@@ -2113,8 +2126,8 @@ static int32_t setupQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv, int32_t numOf
   pRuntimeEnv->keyBuf  = malloc(pQueryAttr->maxTableColumnWidth + sizeof(int64_t) + POINTER_BYTES);
   pRuntimeEnv->pool    = initResultRowPool(getResultRowSize(pRuntimeEnv));
 
-  pRuntimeEnv->prevRow = malloc(POINTER_BYTES * pQueryAttr->numOfCols + pQueryAttr->srcRowSize);
-  pRuntimeEnv->tagVal  = malloc(pQueryAttr->tagLen);
+  pRuntimeEnv->prevRow = taosArenaMalloc(pRuntimeEnv->pArena, POINTER_BYTES * pQueryAttr->numOfCols + pQueryAttr->srcRowSize);
+  pRuntimeEnv->tagVal  = taosArenaMalloc(pRuntimeEnv->pArena, pQueryAttr->tagLen);
 
   // malloc pTablesRead value if super table  && project query and && has order by && limit is true
   if( pRuntimeEnv->pQueryHandle &&  // client merge no tsdb query, so pQueryHandle is NULL, except client merge case in here 
@@ -2135,7 +2148,7 @@ static int32_t setupQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv, int32_t numOf
   // NOTE: pTableCheckInfo need to update the query time range and the lastKey info
   pRuntimeEnv->pTableRetrieveTsMap = taosHashInit(numOfTables, taosGetDefaultHashFunction(TSDB_DATA_TYPE_INT), false, HASH_NO_LOCK);
 
-  pRuntimeEnv->sasArray = calloc(pQueryAttr->numOfOutput, sizeof(SScalarExprSupport));
+  pRuntimeEnv->sasArray = taosArenaCalloc(pRuntimeEnv->pArena, pQueryAttr->numOfOutput, sizeof(SScalarExprSupport));
 
   if (pRuntimeEnv->sasArray == NULL || pRuntimeEnv->pResultRowHashTable == NULL || pRuntimeEnv->keyBuf == NULL ||
       pRuntimeEnv->prevRow == NULL  || pRuntimeEnv->tagVal == NULL || pRuntimeEnv->pool == NULL) {
@@ -2386,11 +2399,14 @@ static int32_t setupQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv, int32_t numOf
   return TSDB_CODE_SUCCESS;
 
 _clean:
-  tfree(pRuntimeEnv->sasArray);
+  taosArenaFree(pRuntimeEnv->sasArray);
+  pRuntimeEnv->sasArray = NULL;
   tfree(pRuntimeEnv->pResultRowHashTable);
   tfree(pRuntimeEnv->keyBuf);
-  tfree(pRuntimeEnv->prevRow);
-  tfree(pRuntimeEnv->tagVal);
+  taosArenaFree(pRuntimeEnv->prevRow);
+  pRuntimeEnv->prevRow = NULL;
+  taosArenaFree(pRuntimeEnv->tagVal);
+  pRuntimeEnv->tagVal = NULL;
 
   return TSDB_CODE_QRY_OUT_OF_MEMORY;
 }
@@ -2430,7 +2446,8 @@ static void teardownQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv) {
       tfree(pRuntimeEnv->sasArray[i].colList);
     }
 
-    tfree(pRuntimeEnv->sasArray);
+    taosArenaFree(pRuntimeEnv->sasArray);
+    pRuntimeEnv->sasArray = NULL;
   }
 
   if (!pRuntimeEnv->udfIsCopy) {
@@ -2445,8 +2462,10 @@ static void teardownQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv) {
   pRuntimeEnv->pTsBuf = tsBufDestroy(pRuntimeEnv->pTsBuf);
 
   tfree(pRuntimeEnv->keyBuf);
-  tfree(pRuntimeEnv->prevRow);
-  tfree(pRuntimeEnv->tagVal);
+  taosArenaFree(pRuntimeEnv->prevRow);
+  pRuntimeEnv->prevRow = NULL;
+  taosArenaFree(pRuntimeEnv->tagVal);
+  pRuntimeEnv->tagVal = NULL;
 
   taosHashCleanup(pRuntimeEnv->pResultRowHashTable);
   pRuntimeEnv->pResultRowHashTable = NULL;
@@ -2477,6 +2496,11 @@ bool isQueryKilled(SQInfo *pQInfo) {
     return true;
   }
 
+  // the partition of a parallel scan is killed along with the query it belongs to
+  if (pQInfo->pParent != NULL) {
+    return isQueryKilled(pQInfo->pParent);
+  }
+
   // query has been executed more than tsShellActivityTimer, and the retrieve has not arrived
   // abort current query execution.
   if (pQInfo->owner != 0 && ((taosGetTimestampSec() - pQInfo->lastRetrieveTs/1000) > getMaximumIdleDurationSec()) &&
@@ -2847,6 +2871,23 @@ static FORCE_INLINE bool doFilterByBlockStatistics(SQueryRuntimeEnv* pRuntimeEnv
   return filterRangeExecute(pQueryAttr->pFilters, pDataStatis, pQueryAttr->numOfCols, numOfRows);
 }
 
+static bool doFilterByBlockBloom(SQueryRuntimeEnv* pRuntimeEnv, STableScanInfo* pTableScanInfo, SQueryCostInfo* pCost) {
+  SQueryAttr* pQueryAttr = pRuntimeEnv->pQueryAttr;
+
+  if (!filterHasBloomUnit(pQueryAttr->pFilters)) {
+    return true;
+  }
+
+  SDataBloom* pDataBloom = NULL;
+  if (tsdbRetrieveDataBlockBloomInfo(pTableScanInfo->pQueryHandle, &pDataBloom) != TSDB_CODE_SUCCESS ||
+      pDataBloom == NULL) {
+    return true;
+  }
+
+  pCost->loadBlockBloom += 1;
+  return filterBloomExecute(pQueryAttr->pFilters, pDataBloom, pQueryAttr->numOfCols);
+}
+
 static bool overlapWithTimeWindow(SQueryAttr* pQueryAttr, SDataBlockInfo* pBlockInfo) {
   STimeWindow w = {0};
 
@@ -3121,7 +3162,6 @@ void filterColRowsInDataBlock(SQueryRuntimeEnv* pRuntimeEnv, SSDataBlock* pBlock
 
 
 static SColumnInfo* doGetTagColumnInfoById(SColumnInfo* pTagColList, int32_t numOfTags, int16_t colId);
-static void doSetTagValueInParam(void* pTable, char* param, int32_t paraLen, int32_t tagColId,  tVariant *tag, int16_t type, int16_t bytes);
 
 static uint32_t doFilterByBlockTimeWindow(STableScanInfo* pTableScanInfo, SSDataBlock* pBlock) {
   SQLFunctionCtx* pCtx = pTableScanInfo->pCtx;
@@ -3177,6 +3217,130 @@ FORCE_INLINE int32_t getColumnDataFromId(void *param, int32_t id, void **data) {
 }
 
 
+// a time window of the file block in the aggregate cache, followed by the statistics of all columns in the window
+typedef struct SAggCacheWin {
+  STimeWindow win;   // timestamps of the first and the last rows in the time window
+  int32_t     rows;
+  int32_t     reserved;
+} SAggCacheWin;
+
+#define AGG_CACHE_WIN_SIZE(_numOfCols) (sizeof(SAggCacheWin) + sizeof(SDataStatis) * (_numOfCols))
+
+static bool isAggCacheDataBlock(SQueryRuntimeEnv* pRuntimeEnv, STableScanInfo* pTableScanInfo, SSDataBlock* pBlock) {
+  SQueryAttr* pQueryAttr = pRuntimeEnv->pQueryAttr;
+
+  // the data block should be a whole file block in the query time range
+  return pTableScanInfo->aggCacheSig != NULL && IS_MASTER_SCAN(pRuntimeEnv) && pRuntimeEnv->pTsBuf == NULL &&
+         pBlock->info.window.skey >= pQueryAttr->window.skey && pBlock->info.window.ekey <= pQueryAttr->window.ekey &&
+         tsdbIsDataBlockAggCacheable(pTableScanInfo->pQueryHandle);
+}
+
+// take the next cached time window as the data block, so that the statistics of the window are used by the functions
+static void setAggCacheWinDataBlock(STableScanInfo* pTableScanInfo, SSDataBlock* pBlock) {
+  assert(pTableScanInfo->aggWinIndex < pTableScanInfo->numOfAggWin);
+
+  size_t        size = AGG_CACHE_WIN_SIZE(pBlock->info.numOfCols);
+  SAggCacheWin* pWin = (SAggCacheWin*)(pTableScanInfo->pAggWin + size * pTableScanInfo->aggWinIndex);
+  pTableScanInfo->aggWinIndex += 1;
+
+  pBlock->info.window = pWin->win;
+  pBlock->info.rows   = pWin->rows;
+  pBlock->pBlockStatis = (SDataStatis*)((char*)pWin + sizeof(SAggCacheWin));
+  pBlock->pDataBlock   = NULL;
+}
+
+static bool loadDataBlockFromAggCache(STableScanInfo* pTableScanInfo, SSDataBlock* pBlock) {
+  int32_t len = 0;
+  char*   pAggWin = tsdbGetDataBlockAggCache(pTableScanInfo->pQueryHandle, pTableScanInfo->aggCacheSig,
+                                             pTableScanInfo->aggCacheSigLen, &len);
+  if (pAggWin == NULL) {
+    return false;
+  }
+
+  size_t size = AGG_CACHE_WIN_SIZE(pBlock->info.numOfCols);
+  if (len <= 0 || len % size != 0) {
+    free(pAggWin);
+    return false;
+  }
+
+  pTableScanInfo->pAggWin = pAggWin;
+  pTableScanInfo->numOfAggWin = (int32_t)(len / size);
+  pTableScanInfo->aggWinIndex = 0;
+
+  setAggCacheWinDataBlock(pTableScanInfo, pBlock);
+  return true;
+}
+
+// split the loaded data block by the time windows, and cache the statistics of each window in the vnode
+static void putDataBlockToAggCache(SQueryRuntimeEnv* pRuntimeEnv, STableScanInfo* pTableScanInfo, SSDataBlock* pBlock) {
+  SQueryAttr* pQueryAttr = pRuntimeEnv->pQueryAttr;
+
+  int32_t numOfCols = pBlock->info.numOfCols;
+  int32_t rows = pBlock->info.rows;
+  size_t  size = AGG_CACHE_WIN_SIZE(numOfCols);
+
+  SColumnInfoData* pColInfoData = taosArrayGet(pBlock->pDataBlock, 0);
+  TSKEY*           tsCols = (TSKEY*)pColInfoData->pData;
+
+  int32_t capacity = 8;
+  int32_t numOfWin = 0;
+  char*   pAggWin = malloc(size * capacity);
+  if (pAggWin == NULL) {
+    return;
+  }
+
+  for (int32_t pos = 0; pos < rows;) {
+    STimeWindow w = {0};
+    getAlignQueryTimeWindow(pQueryAttr, tsCols[pos], tsCols[pos], tsCols[pos], &w);
+
+    int32_t num = (w.ekey >= tsCols[rows - 1])
+                      ? rows - pos
+                      : getForwardStepsInBlock(rows, binarySearchForKey, w.ekey, pos, TSDB_ORDER_ASC, tsCols);
+    assert(num > 0);
+
+    if (numOfWin >= capacity) {
+      char* p = realloc(pAggWin, size * capacity * 2);
+      if (p == NULL) {
+        free(pAggWin);
+        return;
+      }
+
+      pAggWin = p;
+      capacity *= 2;
+    }
+
+    SAggCacheWin* pWin = (SAggCacheWin*)(pAggWin + size * numOfWin);
+    memset(pWin, 0, size);
+
+    pWin->win.skey = tsCols[pos];
+    pWin->win.ekey = tsCols[pos + num - 1];
+    pWin->rows = num;
+
+    SDataStatis* pStatis = (SDataStatis*)((char*)pWin + sizeof(SAggCacheWin));
+    for (int32_t i = 0; i < numOfCols; ++i) {
+      SColumnInfoData* pColData = taosArrayGet(pBlock->pDataBlock, i);
+      pStatis[i].colId = pColData->info.colId;
+
+      // the var type columns are not used by the cacheable functions
+      int16_t type = pColData->info.type;
+      if (IS_VAR_DATA_TYPE(type) || tDataTypes[type].statisFunc == NULL) {
+        continue;
+      }
+
+      tDataTypes[type].statisFunc(pColData->pData + pColData->info.bytes * pos, num, &pStatis[i].min,
+                                  &pStatis[i].max, &pStatis[i].sum, &pStatis[i].minIndex, &pStatis[i].maxIndex,
+                                  &pStatis[i].numOfNull);
+    }
+
+    pos += num;
+    numOfWin += 1;
+  }
+
+  tsdbPutDataBlockAggCache(pTableScanInfo->pQueryHandle, pTableScanInfo->aggCacheSig, pTableScanInfo->aggCacheSigLen,
+                           pAggWin, (int32_t)(size * numOfWin));
+  free(pAggWin);
+}
+
 int32_t loadDataBlockOnDemand(SQueryRuntimeEnv* pRuntimeEnv, STableScanInfo* pTableScanInfo, SSDataBlock* pBlock,
                               uint32_t* status) {
   *status = BLK_DATA_NO_NEEDED;
@@ -3314,6 +3478,22 @@ int32_t loadDataBlockOnDemand(SQueryRuntimeEnv* pRuntimeEnv, STableScanInfo* pTa
       return TSDB_CODE_SUCCESS;
     }
 
+    // current block has been discard since the equal/in conditions are absent from the bloom filters
+    if (pBlock->pBlockStatis != NULL && !doFilterByBlockBloom(pRuntimeEnv, pTableScanInfo, pCost)) {
+      pCost->discardBlocks += 1;
+      qDebug("QInfo:0x%"PRIx64" data block discard by bloom filter, brange:%" PRId64 "-%" PRId64 ", rows:%d", pQInfo->qId,
+             pBlockInfo->window.skey, pBlockInfo->window.ekey, pBlockInfo->rows);
+      (*status) = BLK_DATA_DISCARD;
+      return TSDB_CODE_SUCCESS;
+    }
+
+    // the time window aggregates of the file block may have been cached by a previous query
+    bool aggCache = isAggCacheDataBlock(pRuntimeEnv, pTableScanInfo, pBlock);
+    if (aggCache && loadDataBlockFromAggCache(pTableScanInfo, pBlock)) {
+      pCost->aggCacheHits += 1;
+      return TSDB_CODE_SUCCESS;
+    }
+
     pCost->totalCheckedRows += pBlockInfo->rows;
     pCost->loadBlocks += 1;
     pBlock->pDataBlock = tsdbRetrieveDataBlock(pTableScanInfo->pQueryHandle, NULL);
@@ -3321,6 +3501,11 @@ int32_t loadDataBlockOnDemand(SQueryRuntimeEnv* pRuntimeEnv, STableScanInfo* pTa
       return terrno;
     }
 
+    if (aggCache) {
+      pCost->aggCacheMisses += 1;
+      putDataBlockToAggCache(pRuntimeEnv, pTableScanInfo, pBlock);
+    }
+
     if (pQueryAttr->pFilters != NULL) {
       SColumnDataParam param = {.numOfCols = pBlock->info.numOfCols, .pDataBlock = pBlock->pDataBlock};
       filterSetColFieldData(pQueryAttr->pFilters, &param, getColumnDataFromId);
@@ -3401,7 +3586,7 @@ int32_t binarySearchForKey(char *pValue, int num, TSKEY key, int order) {
  * set tag value in SQLFunctionCtx
  * e.g.,tag information into input buffer
  */
-static void doSetTagValueInParam(void* pTable, char* param, int32_t paramLen, int32_t tagColId, tVariant *tag, int16_t type, int16_t bytes) {
+void doSetTagValueInParam(void* pTable, char* param, int32_t paramLen, int32_t tagColId, tVariant *tag, int16_t type, int16_t bytes) {
   tVariantDestroy(tag);
 
   char* val = NULL;
@@ -4659,6 +4844,16 @@ void calculateOperatorProfResults(SQInfo* pQInfo) {
   taosArrayDestroy(&opStack);
 }
 
+// the read-ahead counters are kept by the query handle of tsdb, taken before it is cleaned up
+static void addReadAheadCost(SQueryCostInfo* pSummary, TsdbQueryHandleT pQueryHandle) {
+  int64_t hits = 0, misses = 0, wastes = 0;
+  tsdbGetReadAheadStat(pQueryHandle, &hits, &misses, &wastes);
+
+  pSummary->readAheadHits   += hits;
+  pSummary->readAheadMisses += misses;
+  pSummary->readAheadWastes += wastes;
+}
+
 void queryCostStatis(SQInfo *pQInfo) {
   SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
   SQueryCostInfo *pSummary = &pQInfo->summary;
@@ -4679,16 +4874,45 @@ void queryCostStatis(SQInfo *pQInfo) {
     pSummary->numOfTimeWindows = 0;
   }
 
+  SDiskbasedResultBuf* pResultBuf = pRuntimeEnv->pResultBuf;
+  if (pResultBuf != NULL) {
+    pSummary->spillPages = pResultBuf->statis.flushPages;
+    pSummary->spillBytes = pResultBuf->statis.flushBytes;
+    pSummary->reloadPages = pResultBuf->statis.loadPages;
+    pSummary->reloadBytes = pResultBuf->statis.loadBytes;
+    pSummary->colCompPages = pResultBuf->statis.colCompPages;
+  }
+
+  addReadAheadCost(pSummary, pRuntimeEnv->pQueryHandle);
+
   calculateOperatorProfResults(pQInfo);
 
   qDebug("QInfo:0x%"PRIx64" :cost summary: elapsed time:%"PRId64" us, first merge:%"PRId64" us, total blocks:%d, "
-         "load block statis:%d, load data block:%d, total rows:%"PRId64 ", check rows:%"PRId64,
+         "load block statis:%d, load block bloom:%d, load data block:%d, total rows:%"PRId64 ", check rows:%"PRId64,
          pQInfo->qId, pSummary->elapsedTime, pSummary->firstStageMergeTime, pSummary->totalBlocks, pSummary->loadBlockStatis,
-         pSummary->loadBlocks, pSummary->totalRows, pSummary->totalCheckedRows);
+         pSummary->loadBlockBloom, pSummary->loadBlocks, pSummary->totalRows, pSummary->totalCheckedRows);
 
   qDebug("QInfo:0x%"PRIx64" :cost summary: winResPool size:%.2f Kb, numOfWin:%"PRId64", tableInfoSize:%.2f Kb, hashTable:%.2f Kb", pQInfo->qId, pSummary->winInfoSize/1024.0,
       pSummary->numOfTimeWindows, pSummary->tableInfoSize/1024.0, pSummary->hashSize/1024.0);
 
+  if (pSummary->aggCacheHits > 0 || pSummary->aggCacheMisses > 0) {
+    qDebug("QInfo:0x%"PRIx64" :cost summary: block aggregate cache hits:%d, misses:%d", pQInfo->qId,
+           pSummary->aggCacheHits, pSummary->aggCacheMisses);
+  }
+
+  if (pSummary->readAheadHits > 0 || pSummary->readAheadMisses > 0) {
+    qDebug("QInfo:0x%"PRIx64" :cost summary: read-ahead hits:%"PRIu64", misses:%"PRIu64", hit rate:%.2f%%, "
+           "wasted blocks:%"PRIu64, pQInfo->qId, pSummary->readAheadHits, pSummary->readAheadMisses,
+           pSummary->readAheadHits * 100.0 / (pSummary->readAheadHits + pSummary->readAheadMisses),
+           pSummary->readAheadWastes);
+  }
+
+  if (pSummary->spillPages > 0) {
+    qDebug("QInfo:0x%"PRIx64" :cost summary: result buffer spill pages:%d, spill size:%.2f Kb, column compressed pages:%d, "
+           "reload pages:%d, reload size:%.2f Kb", pQInfo->qId, pSummary->spillPages, pSummary->spillBytes/1024.0,
+           pSummary->colCompPages, pSummary->reloadPages, pSummary->reloadBytes/1024.0);
+  }
+
   if (pSummary->operatorProfResults) {
     SOperatorProfResult* opRes = taosHashIterate(pSummary->operatorProfResults, NULL);
     while (opRes != NULL) {
@@ -4998,7 +5222,10 @@ static int32_t setupQueryHandle(void* tsdb, SQueryRuntimeEnv* pRuntimeEnv, int64
   } else if (pQueryAttr->pointInterpQuery) {
     pRuntimeEnv->pQueryHandle = tsdbQueryRowsInExternalWindow(tsdb, &cond, &pQueryAttr->tableGroupInfo, qId, &pQueryAttr->memRef);
   } else {
-    pRuntimeEnv->pQueryHandle = tsdbQueryTables(tsdb, &cond, &pQueryAttr->tableGroupInfo, qId, &pQueryAttr->memRef);
+    // the partitions of a parallel scan read the snapshot of the query they belong to, so they see the same rows
+    SQInfo*  pParent = ((SQInfo*)pRuntimeEnv->qinfo)->pParent;
+    SMemRef* pMemRef = (pParent != NULL) ? &pParent->query.memRef : &pQueryAttr->memRef;
+    pRuntimeEnv->pQueryHandle = tsdbQueryTables(tsdb, &cond, &pQueryAttr->tableGroupInfo, qId, pMemRef);
   }
 
   return terrno;
@@ -5030,6 +5257,31 @@ static SFillColInfo* createFillColInfo(SExprInfo* pExpr, int32_t numOfOutput, in
   return pFillCol;
 }
 
+// let the result rows be compressed column by column when the pages of the result buffer are flushed to disk
+static void setResultBufLayout(SQueryRuntimeEnv* pRuntimeEnv) {
+  SQueryAttr* pQueryAttr = pRuntimeEnv->pQueryAttr;
+  if (pRuntimeEnv->pResultBuf == NULL || pQueryAttr->numOfOutput <= 0) {
+    return;
+  }
+
+  SPageColInfo* pCols = calloc(pQueryAttr->numOfOutput, sizeof(SPageColInfo));
+  if (pCols == NULL) {
+    return;
+  }
+
+  int32_t multi = getRowNumForMultioutput(pQueryAttr, pQueryAttr->topBotQuery, pQueryAttr->stableQuery);
+  int32_t offset = 0;
+  for (int32_t i = 0; i < pQueryAttr->numOfOutput; ++i) {
+    SSqlExpr* pExpr = &pQueryAttr->pExpr1[i].base;
+    pCols[i] = (SPageColInfo) {.type = pExpr->resType, .offset = offset * multi, .bytes = pExpr->resBytes * multi};
+    offset += pExpr->resBytes;
+  }
+
+  // the layout is ignored if it does not match the result row, the pages are compressed as a whole then
+  setResultBufPageLayout(pRuntimeEnv->pResultBuf, pQueryAttr->resultRowSize, pCols, pQueryAttr->numOfOutput);
+  tfree(pCols);
+}
+
 int32_t doInitQInfo(SQInfo* pQInfo, STSBuf* pTsBuf, void* tsdb, void* sourceOptr, int32_t tbScanner, SArray* pOperator,
     void* param) {
   SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
@@ -5129,6 +5381,17 @@ int32_t doInitQInfo(SQInfo* pQInfo, STSBuf* pTsBuf, void* tsdb, void* sourceOptr
     return code;
   }
 
+  setResultBufLayout(pRuntimeEnv);
+
+  // the serial operators are kept as the upstream, in case of the partitions can not be created
+  if (isParallelScanQuery(pQInfo, tbScanner, pOperator)) {
+    SOperatorInfo* pParallel =
+        createParallelAggOperatorInfo(pRuntimeEnv, pRuntimeEnv->proot, pQueryAttr->pExpr1, pQueryAttr->numOfOutput);
+    if (pParallel != NULL) {
+      pRuntimeEnv->proot = pParallel;
+    }
+  }
+
   setQueryStatus(pRuntimeEnv, QUERY_NOT_COMPLETED);
   return TSDB_CODE_SUCCESS;
 }
@@ -5228,11 +5491,24 @@ static SSDataBlock* doTableScanImpl(void* param, bool* newgroup) {
 
   *newgroup = false;
 
+  // the remaining time windows of the data block found in the aggregate cache
+  if (pTableScanInfo->aggWinIndex < pTableScanInfo->numOfAggWin) {
+    setAggCacheWinDataBlock(pTableScanInfo, pBlock);
+    return pBlock;
+  }
+
+  tfree(pTableScanInfo->pAggWin);
+  pTableScanInfo->numOfAggWin = 0;
+  pTableScanInfo->aggWinIndex = 0;
+
   while (tsdbNextDataBlock(pTableScanInfo->pQueryHandle)) {
     if (isQueryKilled(pOperator->pRuntimeEnv->qinfo)) {
       longjmp(pOperator->pRuntimeEnv->env, TSDB_CODE_TSC_QUERY_CANCELLED);
     }
 
+    // give the slot to the interactive queries if it is a batch query
+    qYieldExecSlot(pOperator->pRuntimeEnv->qinfo);
+
     pTableScanInfo->numOfBlocks += 1;
     tsdbRetrieveDataBlockInfo(pTableScanInfo->pQueryHandle, &pBlock->info);
 
@@ -5393,7 +5669,7 @@ static SSDataBlock* doBlockInfoScan(void* param, bool* newgroup) {
 SOperatorInfo* createTableScanOperator(void* pTsdbQueryHandle, SQueryRuntimeEnv* pRuntimeEnv, int32_t repeatTime) {
   assert(repeatTime > 0);
 
-  STableScanInfo* pInfo = calloc(1, sizeof(STableScanInfo));
+  STableScanInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(STableScanInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -5404,9 +5680,9 @@ SOperatorInfo* createTableScanOperator(void* pTsdbQueryHandle, SQueryRuntimeEnv*
   pInfo->order        = pRuntimeEnv->pQueryAttr->order.order;
   pInfo->current      = 0;
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
-    tfree(pInfo);
+    taosArenaFree(pInfo);
     return NULL;
   }
 
@@ -5418,12 +5694,13 @@ SOperatorInfo* createTableScanOperator(void* pTsdbQueryHandle, SQueryRuntimeEnv*
   pOperator->numOfOutput  = pRuntimeEnv->pQueryAttr->numOfCols;
   pOperator->pRuntimeEnv  = pRuntimeEnv;
   pOperator->exec         = doTableScan;
+  pOperator->cleanup      = destroyTableScanOperatorInfo;
 
   return pOperator;
 }
 
 SOperatorInfo* createTableSeqScanOperator(void* pTsdbQueryHandle, SQueryRuntimeEnv* pRuntimeEnv) {
-  STableScanInfo* pInfo = calloc(1, sizeof(STableScanInfo));
+  STableScanInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(STableScanInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -5436,9 +5713,9 @@ SOperatorInfo* createTableSeqScanOperator(void* pTsdbQueryHandle, SQueryRuntimeE
   pInfo->prevGroupId      = -1;
   pRuntimeEnv->enableGroupData = true;
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
-    tfree(pInfo);
+    taosArenaFree(pInfo);
     return NULL;
   }
 
@@ -5450,12 +5727,13 @@ SOperatorInfo* createTableSeqScanOperator(void* pTsdbQueryHandle, SQueryRuntimeE
   pOperator->numOfOutput  = pRuntimeEnv->pQueryAttr->numOfCols;
   pOperator->pRuntimeEnv  = pRuntimeEnv;
   pOperator->exec         = doTableScanImpl;
+  pOperator->cleanup      = destroyTableScanOperatorInfo;
 
   return pOperator;
 }
 
 SOperatorInfo* createTableBlockInfoScanOperator(void* pTsdbQueryHandle, SQueryRuntimeEnv* pRuntimeEnv) {
-  STableScanInfo* pInfo = calloc(1, sizeof(STableScanInfo));
+  STableScanInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(STableScanInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -5472,7 +5750,7 @@ SOperatorInfo* createTableBlockInfoScanOperator(void* pTsdbQueryHandle, SQueryRu
   infoData.info.colId = 0;
   taosArrayPush(pInfo->block.pDataBlock, &infoData);
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
     taosArrayDestroy(&pInfo->block.pDataBlock);
     goto _clean;
@@ -5490,11 +5768,84 @@ SOperatorInfo* createTableBlockInfoScanOperator(void* pTsdbQueryHandle, SQueryRu
   return pOperator;
 
 _clean:
-  tfree(pInfo);
+  taosArenaFree(pInfo);
 
   return NULL;
 }
 
+typedef struct SAggCacheSig {
+  SInterval interval;
+  int32_t   precision;
+  int32_t   numOfCols;
+  int16_t   colIds[];
+} SAggCacheSig;
+
+/*
+ * The time window aggregates of the file blocks are cached in the vnode only for the tumbling time windows in the
+ * ascending order, with the functions that are computed from the statistics of each window. The signature identifies
+ * the windows and the columns of the statistics, NULL is returned if the query is not the case.
+ */
+static char* createAggCacheSig(SOperatorInfo* pDownstream, int32_t* len) {
+  SQueryRuntimeEnv* pRuntimeEnv = pDownstream->pRuntimeEnv;
+  SQueryAttr*       pQueryAttr = pRuntimeEnv->pQueryAttr;
+  SInterval*        pInterval = &pQueryAttr->interval;
+
+  if (tsBlockAggCacheSize <= 0 ||
+      (pDownstream->operatorType != OP_TimeWindow && pDownstream->operatorType != OP_MultiTableTimeInterval)) {
+    return NULL;
+  }
+
+  if (!QUERY_IS_ASC_QUERY(pQueryAttr) || pInterval->interval <= 0 || pInterval->sliding != pInterval->interval ||
+      pInterval->slidingUnit != pInterval->intervalUnit || pQueryAttr->pFilters != NULL || pQueryAttr->groupbyColumn ||
+      pQueryAttr->timeWindowInterpo || pQueryAttr->pointInterpQuery || pQueryAttr->topBotQuery ||
+      pQueryAttr->tsCompQuery || pRuntimeEnv->pUdfInfo != NULL) {
+    return NULL;
+  }
+
+  for (int32_t i = 0; i < pDownstream->numOfOutput; ++i) {
+    SSqlExpr* pExpr = &pDownstream->pExpr[i].base;
+    int32_t   functionId = pExpr->functionId;
+
+    if (functionId == TSDB_FUNC_TS || functionId == TSDB_FUNC_TAG) {
+      continue;
+    }
+
+    if (functionId != TSDB_FUNC_COUNT && functionId != TSDB_FUNC_SUM && functionId != TSDB_FUNC_AVG &&
+        functionId != TSDB_FUNC_MIN && functionId != TSDB_FUNC_MAX) {
+      return NULL;
+    }
+
+    if (!TSDB_COL_IS_NORMAL_COL(pExpr->colInfo.flag) || TSDB_COL_IS_TSWIN_COL(pExpr->colInfo.colId) ||
+        IS_VAR_DATA_TYPE(pExpr->colType)) {
+      return NULL;
+    }
+  }
+
+  *len = (int32_t)(sizeof(SAggCacheSig) + sizeof(int16_t) * pQueryAttr->numOfCols);
+
+  SAggCacheSig* pSig = calloc(1, *len);
+  if (pSig == NULL) {
+    return NULL;
+  }
+
+  // the padding bytes are part of the signature, so do not copy the struct as a whole
+  pSig->interval.tz           = pInterval->tz;
+  pSig->interval.intervalUnit = pInterval->intervalUnit;
+  pSig->interval.slidingUnit  = pInterval->slidingUnit;
+  pSig->interval.offsetUnit   = pInterval->offsetUnit;
+  pSig->interval.interval     = pInterval->interval;
+  pSig->interval.sliding      = pInterval->sliding;
+  pSig->interval.offset       = pInterval->offset;
+  pSig->precision             = pQueryAttr->precision;
+  pSig->numOfCols             = pQueryAttr->numOfCols;
+
+  for (int32_t i = 0; i < pQueryAttr->numOfCols; ++i) {
+    pSig->colIds[i] = pQueryAttr->tableCols[i].colId;
+  }
+
+  return (char*)pSig;
+}
+
 void setTableScanFilterOperatorInfo(STableScanInfo* pTableScanInfo, SOperatorInfo* pDownstream) {
   assert(pTableScanInfo != NULL && pDownstream != NULL);
 
@@ -5554,12 +5905,15 @@ void setTableScanFilterOperatorInfo(STableScanInfo* pTableScanInfo, SOperatorInf
   } else {
     assert(0);
   }
+
+  tfree(pTableScanInfo->aggCacheSig);
+  pTableScanInfo->aggCacheSig = createAggCacheSig(pDownstream, &pTableScanInfo->aggCacheSigLen);
 }
 
 SOperatorInfo* createDataBlocksOptScanInfo(void* pTsdbQueryHandle, SQueryRuntimeEnv* pRuntimeEnv, int32_t repeatTime, int32_t reverseTime) {
   assert(repeatTime > 0);
 
-  STableScanInfo* pInfo = calloc(1, sizeof(STableScanInfo));
+  STableScanInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(STableScanInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -5574,9 +5928,9 @@ SOperatorInfo* createDataBlocksOptScanInfo(void* pTsdbQueryHandle, SQueryRuntime
     pRuntimeEnv->enableGroupData = true;
   }
 
-  SOperatorInfo* pOptr = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOptr = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOptr == NULL) {
-    tfree(pInfo);
+    taosArenaFree(pInfo);
     return NULL;
   }
 
@@ -5587,6 +5941,7 @@ SOperatorInfo* createDataBlocksOptScanInfo(void* pTsdbQueryHandle, SQueryRuntime
   pOptr->info          = pInfo;
   pOptr->exec          = doTableScan;
   pOptr->notify        = notifyTableScan;
+  pOptr->cleanup       = destroyTableScanOperatorInfo;
 
   return pOptr;
 }
@@ -5707,7 +6062,7 @@ static void destroySlimitOperatorInfo(void* param, int32_t numOfOutput) {
 
 SOperatorInfo* createGlobalAggregateOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream,
                                                  SExprInfo* pExpr, int32_t numOfOutput, void* param, SArray* pUdfInfo, bool groupResultMixedUp) {
-  SMultiwayMergeInfo* pInfo = calloc(1, sizeof(SMultiwayMergeInfo));
+  SMultiwayMergeInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SMultiwayMergeInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -5771,7 +6126,7 @@ SOperatorInfo* createGlobalAggregateOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv,
   pInfo->seed = rand();
   setDefaultOutputBuf(pRuntimeEnv, &pInfo->binfo, pInfo->seed, MERGE_STAGE);
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
     return NULL;
   }
@@ -5793,14 +6148,14 @@ SOperatorInfo* createGlobalAggregateOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv,
 
 _clean:
     destroyGlobalAggOperatorInfo((void *) pInfo, numOfOutput);
-    tfree(pInfo);
+    taosArenaFree(pInfo);
 
     return NULL;
 }
 
 SOperatorInfo *createMultiwaySortOperatorInfo(SQueryRuntimeEnv *pRuntimeEnv, SExprInfo *pExpr, int32_t numOfOutput,
                                               int32_t numOfRows, void *merger) {
-  SMultiwayMergeInfo* pInfo = calloc(1, sizeof(SMultiwayMergeInfo));
+  SMultiwayMergeInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SMultiwayMergeInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -5832,7 +6187,7 @@ SOperatorInfo *createMultiwaySortOperatorInfo(SQueryRuntimeEnv *pRuntimeEnv, SEx
     }
   }
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
     goto _clean;
   }
@@ -5851,7 +6206,7 @@ SOperatorInfo *createMultiwaySortOperatorInfo(SQueryRuntimeEnv *pRuntimeEnv, SEx
 
 _clean:
   destroyGlobalAggOperatorInfo((void *)pInfo, numOfOutput);
-  tfree(pInfo);
+  taosArenaFree(pInfo);
 
   return NULL;
 }
@@ -5929,7 +6284,7 @@ static SSDataBlock* doSort(void* param, bool* newgroup) {
 }
 
 SOperatorInfo *createOrderOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput, SOrderVal* pOrderVal) {
-  SOrderOperatorInfo* pInfo = calloc(1, sizeof(SOrderOperatorInfo));
+  SOrderOperatorInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOrderOperatorInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -5962,7 +6317,7 @@ SOperatorInfo *createOrderOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorI
       pInfo->pDataBlock = pDataBlock;
   }
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
     goto _clean;
   }
@@ -5981,7 +6336,7 @@ SOperatorInfo *createOrderOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorI
 
 _clean:
   destroyOrderOperatorInfo((void *)pInfo, numOfOutput);
-  tfree(pInfo);
+  taosArenaFree(pInfo);
 
   return NULL;
 }
@@ -7355,12 +7710,12 @@ static void destroyOperatorInfo(SOperatorInfo* pOperator) {
     pOperator->numOfUpstream = 0;
   }
 
-  tfree(pOperator->info);
-  tfree(pOperator);
+  taosArenaFree(pOperator->info);
+  taosArenaFree(pOperator);
 }
 
 SOperatorInfo* createAggregateOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput) {
-  SAggOperatorInfo* pInfo = calloc(1, sizeof(SAggOperatorInfo));
+  SAggOperatorInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SAggOperatorInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -7380,7 +7735,7 @@ SOperatorInfo* createAggregateOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOpera
   pInfo->seed = rand();
   setDefaultOutputBuf(pRuntimeEnv, &pInfo->binfo, pInfo->seed, MASTER_SCAN);
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
     goto _clean;
   }
@@ -7402,7 +7757,7 @@ SOperatorInfo* createAggregateOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOpera
 
 _clean:
   destroyAggOperatorInfo((void *)pInfo, numOfOutput);
-  tfree(pInfo);
+  taosArenaFree(pInfo);
 
   return NULL;
 }
@@ -7415,7 +7770,8 @@ static void doDestroyBasicInfo(SOptrBasicInfo* pInfo, int32_t numOfOutput) {
   }
 
   if (pInfo->rowCellInfoOffset) {
-    tfree(pInfo->rowCellInfoOffset);
+    taosArenaFree(pInfo->rowCellInfoOffset);
+    pInfo->rowCellInfoOffset = NULL;
   }
 
   if (pInfo->resultRowInfo.pResult) {
@@ -7492,6 +7848,13 @@ static void destroyTimeEveryOperatorInfo(void* param, int32_t numOfOutput) {
 }
 
 
+static void destroyTableScanOperatorInfo(void* param, int32_t numOfOutput) {
+  STableScanInfo* pInfo = (STableScanInfo*) param;
+
+  tfree(pInfo->aggCacheSig);
+  tfree(pInfo->pAggWin);
+}
+
 static void destroyTagScanOperatorInfo(void* param, int32_t numOfOutput) {
   STagScanInfo* pInfo = (STagScanInfo*) param;
 
@@ -7534,7 +7897,7 @@ static void destroyDistinctOperatorInfo(void* param, int32_t numOfOutput) {
 }
 
 SOperatorInfo* createMultiTableAggOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput) {
-  SAggOperatorInfo* pInfo = calloc(1, sizeof(SAggOperatorInfo));
+  SAggOperatorInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SAggOperatorInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -7549,7 +7912,7 @@ SOperatorInfo* createMultiTableAggOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SO
     goto _clean;
   }
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
     goto _clean;
   }
@@ -7571,13 +7934,496 @@ SOperatorInfo* createMultiTableAggOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SO
 
 _clean:
   destroyAggOperatorInfo((void *)pInfo, numOfOutput);
-  tfree(pInfo);
+  taosArenaFree(pInfo);
 
   return NULL;
 }
 
+static bool isParallelScanQuery(SQInfo* pQInfo, int32_t tbScanner, SArray* pOperator) {
+  SQueryRuntimeEnv* pRuntimeEnv = &pQInfo->runtimeEnv;
+  SQueryAttr*       pQueryAttr = pRuntimeEnv->pQueryAttr;
+
+  // the partitions of a query are never scanned in parallel again
+  if (tsParallelScanThreads <= 1 || pQInfo->pParent != NULL || pRuntimeEnv->pQueryHandle == NULL) {
+    return false;
+  }
+
+  if (!pQueryAttr->stableQuery || !pQueryAttr->simpleAgg || tbScanner != OP_TableScan) {
+    return false;
+  }
+
+  if (pRuntimeEnv->pTsBuf != NULL || pRuntimeEnv->prevResult != NULL || pRuntimeEnv->pUdfInfo != NULL) {
+    return false;
+  }
+
+  // the filter keeps the execution states, each partition needs its own one
+  if (pQueryAttr->pFilters != NULL && pQInfo->colCond == NULL) {
+    return false;
+  }
+
+  if (taosArrayGetSize(pOperator) != 1 || *(int32_t*)taosArrayGet(pOperator, 0) != OP_MultiTableAggregate) {
+    return false;
+  }
+
+  // the partial results of the partitions are merged by the client, like the results from different vnodes, which
+  // requires the results of different groups not to be interleaved
+  if (GET_NUM_OF_TABLEGROUP(pRuntimeEnv) != 1 ||
+      pRuntimeEnv->tableqinfoGroupInfo.numOfTables < PARALLEL_SCAN_MIN_TABLES * 2) {
+    return false;
+  }
+
+  for (int32_t i = 0; i < pQueryAttr->numOfOutput; ++i) {
+    int32_t functionId = pQueryAttr->pExpr1[i].base.functionId;
+    if (functionId != TSDB_FUNC_COUNT && functionId != TSDB_FUNC_SUM && functionId != TSDB_FUNC_AVG &&
+        functionId != TSDB_FUNC_MIN && functionId != TSDB_FUNC_MAX && functionId != TSDB_FUNC_SPREAD &&
+        functionId != TSDB_FUNC_FIRST_DST && functionId != TSDB_FUNC_LAST_DST) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static void destroyParallelScanPart(SQInfo* pPart) {
+  if (pPart == NULL) {
+    return;
+  }
+
+  SQueryRuntimeEnv* pRuntimeEnv = &pPart->runtimeEnv;
+  teardownQueryRuntimeEnv(pRuntimeEnv);
+
+  // the table query info objects are owned by the query that the partition belongs to
+  STableGroupInfo* pTableqinfoGroupInfo = &pRuntimeEnv->tableqinfoGroupInfo;
+  for (int32_t i = 0; i < taosArrayGetSize(pTableqinfoGroupInfo->pGroupList); ++i) {
+    SArray* p = taosArrayGetP(pTableqinfoGroupInfo->pGroupList, i);
+    taosArrayDestroy(&p);
+  }
+
+  taosArrayDestroy(&pTableqinfoGroupInfo->pGroupList);
+  taosHashCleanup(pTableqinfoGroupInfo->map);
+
+  // so do the references of the tables
+  STableGroupInfo* pTableGroupInfo = &pPart->query.tableGroupInfo;
+  for (int32_t i = 0; i < taosArrayGetSize(pTableGroupInfo->pGroupList); ++i) {
+    SArray* p = taosArrayGetP(pTableGroupInfo->pGroupList, i);
+    taosArrayDestroy(&p);
+  }
+
+  taosArrayDestroy(&pTableGroupInfo->pGroupList);
+  filterFreeInfo(pPart->query.pFilters);
+
+  taosArrayDestroy(&pPart->summary.queryProfEvents);
+  taosHashCleanup(pPart->summary.operatorProfResults);
+  taosArrayDestroy(&pRuntimeEnv->groupResInfo.pRows);
+  taosArenaDestroy(pRuntimeEnv->pArena);
+
+  pPart->signature = 0;
+  tfree(pPart);
+}
+
+/*
+ * The partition shares the query attributes and the snapshot of the mem tables with the query it belongs to, except
+ * the table list and the filters, and it owns the runtime environment to scan and aggregate the index-th of every
+ * numOfParts tables.
+ */
+static SQInfo* createParallelScanPart(SQInfo* pQInfo, int32_t index, int32_t numOfParts) {
+  SQueryRuntimeEnv* pRuntimeEnv = &pQInfo->runtimeEnv;
+  SQueryAttr*       pQueryAttr = pRuntimeEnv->pQueryAttr;
+
+  SArray* pKeyList   = taosArrayGetP(pQueryAttr->tableGroupInfo.pGroupList, 0);
+  SArray* pTableList = GET_TABLEGROUP(pRuntimeEnv, 0);
+  int32_t numOfTables = (int32_t)taosArrayGetSize(pTableList);
+  int32_t capacity = numOfTables / numOfParts + 1;
+
+  SQInfo* pPart = calloc(1, sizeof(SQInfo));
+  if (pPart == NULL) {
+    return NULL;
+  }
+
+  pPart->signature = pPart;
+  pPart->qId       = pQInfo->qId;
+  pPart->pParent   = pQInfo;
+  pPart->query     = *pQueryAttr;
+
+  SQueryAttr* pPartAttr = &pPart->query;
+  pPartAttr->pFilters = NULL;
+  pPartAttr->tableGroupInfo.pGroupList = NULL;
+  pPartAttr->tableGroupInfo.numOfTables = 0;
+  memset(&pPartAttr->memRef, 0, sizeof(SMemRef));
+
+  SQueryRuntimeEnv* pPartEnv = &pPart->runtimeEnv;
+  pPartEnv->pQueryAttr    = pPartAttr;
+  pPartEnv->qinfo         = pPart;
+  pPartEnv->currentOffset = pRuntimeEnv->currentOffset;
+
+  // the partitions run in threads of their own, so each one carves its runtime state out of an arena of its own
+  pPartEnv->pArena = taosArenaInit(QUERY_ARENA_BLOCK_SIZE, tsQueryArena == 0);
+
+  SArray* pKeys   = taosArrayInit(capacity, sizeof(STableKeyInfo));
+  SArray* pTables = taosArrayInit(capacity, POINTER_BYTES);
+
+  pPartAttr->tableGroupInfo.pGroupList = taosArrayInit(1, POINTER_BYTES);
+  pPartEnv->tableqinfoGroupInfo.pGroupList = taosArrayInit(1, POINTER_BYTES);
+  pPartEnv->tableqinfoGroupInfo.map = taosHashInit(capacity, taosGetDefaultHashFunction(TSDB_DATA_TYPE_INT), true, HASH_NO_LOCK);
+
+  if (pKeys == NULL || pTables == NULL || pPartAttr->tableGroupInfo.pGroupList == NULL || pPartEnv->pArena == NULL ||
+      pPartEnv->tableqinfoGroupInfo.pGroupList == NULL || pPartEnv->tableqinfoGroupInfo.map == NULL) {
+    taosArrayDestroy(&pKeys);
+    taosArrayDestroy(&pTables);
+    goto _error;
+  }
+
+  taosArrayPush(pPartAttr->tableGroupInfo.pGroupList, &pKeys);
+  taosArrayPush(pPartEnv->tableqinfoGroupInfo.pGroupList, &pTables);
+
+  // tables are dealt to the partitions in turn, so that they are likely to have similar amount of data to scan
+  for (int32_t i = index; i < numOfTables; i += numOfParts) {
+    STableQueryInfo* pTableQueryInfo = taosArrayGetP(pTableList, i);
+
+    taosArrayPush(pKeys, taosArrayGet(pKeyList, i));
+    taosArrayPush(pTables, &pTableQueryInfo);
+
+    STableId* id = TSDB_TABLEID(pTableQueryInfo->pTable);
+    taosHashPut(pPartEnv->tableqinfoGroupInfo.map, &id->tid, sizeof(id->tid), &pTableQueryInfo, POINTER_BYTES);
+  }
+
+  pPartAttr->tableGroupInfo.numOfTables = (uint32_t)taosArrayGetSize(pKeys);
+  pPartEnv->tableqinfoGroupInfo.numOfTables = (uint32_t)taosArrayGetSize(pTables);
+
+  if (pQInfo->colCond != NULL &&
+      createQueryFilter(pQInfo->colCond, pQInfo->colCondLen, &pPartAttr->pFilters) != TSDB_CODE_SUCCESS) {
+    goto _error;
+  }
+
+  SArray* pOperator = taosArrayInit(1, sizeof(int32_t));
+  if (pOperator == NULL) {
+    goto _error;
+  }
+
+  int32_t op = OP_MultiTableAggregate;
+  taosArrayPush(pOperator, &op);
+
+  int32_t code = doInitQInfo(pPart, NULL, pQueryAttr->tsdb, NULL, OP_TableScan, pOperator, NULL);
+  taosArrayDestroy(&pOperator);
+
+  if (code != TSDB_CODE_SUCCESS) {
+    goto _error;
+  }
+
+  return pPart;
+
+_error:
+  destroyParallelScanPart(pPart);
+  return NULL;
+}
+
+/*
+ * The partitions of the parallel scans of all queries are executed by one pool of parallelScanThreads threads, and by
+ * the threads of the queries themselves: a query claims the partitions not taken by the pool yet, so it never waits
+ * for a thread of the pool, and the partitions are never queued beyond the capacity of the pool.
+ */
+typedef struct SParallelScanJob {
+  SQInfo        **pParts;
+  int32_t         numOfParts;
+  int32_t         next;       // the next partition to claim
+  int32_t         ref;
+  int32_t         nfinished;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+} SParallelScanJob;
+
+static void*   tsParallelScanPool = NULL;
+static int32_t tsParallelScanQueued = 0;  // the tasks queued in the pool and not started yet
+
+int32_t qInitParallelScan(void) {
+  if (tsParallelScanThreads <= 1) return 0;
+
+  // the partitions are all executed by the threads of the queries if the pool fails to start
+  tsParallelScanPool = taosInitScheduler(tsParallelScanThreads * PARALLEL_SCAN_QUEUE_RATIO, tsParallelScanThreads,
+                                         "qParallelScan");
+  if (tsParallelScanPool == NULL) {
+    qWarn("failed to start %d threads to scan the tables in parallel", tsParallelScanThreads);
+  }
+
+  return 0;
+}
+
+void qCleanupParallelScan(void) {
+  if (tsParallelScanPool != NULL) {
+    taosCleanUpScheduler(tsParallelScanPool);
+    tsParallelScanPool = NULL;
+  }
+}
+
+static void* doParallelScanPart(void* param);
+
+static void unrefParallelScanJob(SParallelScanJob* pJob) {
+  if (atomic_sub_fetch_32(&pJob->ref, 1) > 0) {
+    return;
+  }
+
+  pthread_cond_destroy(&pJob->cond);
+  pthread_mutex_destroy(&pJob->mutex);
+  free(pJob);
+}
+
+static void doParallelScanNextParts(SParallelScanJob* pJob) {
+  int32_t nfinished = 0;
+  int32_t idx;
+
+  while ((idx = atomic_fetch_add_32(&pJob->next, 1)) < pJob->numOfParts) {
+    doParallelScanPart(pJob->pParts[idx]);
+    nfinished++;
+  }
+
+  if (nfinished > 0) {
+    pthread_mutex_lock(&pJob->mutex);
+    pJob->nfinished += nfinished;
+    if (pJob->nfinished == pJob->numOfParts) {
+      pthread_cond_signal(&pJob->cond);
+    }
+    pthread_mutex_unlock(&pJob->mutex);
+  }
+}
+
+static void doParallelScanWork(SSchedMsg* pMsg) {
+  SParallelScanJob* pJob = (SParallelScanJob*)pMsg->ahandle;
+
+  atomic_sub_fetch_32(&tsParallelScanQueued, 1);
+  doParallelScanNextParts(pJob);
+  unrefParallelScanJob(pJob);
+}
+
+// Return false if the job cannot be created, the partitions are not executed then
+static bool doParallelScanParts(SQInfo** pParts, int32_t numOfParts) {
+  SParallelScanJob* pJob = calloc(1, sizeof(SParallelScanJob));
+  if (pJob == NULL) {
+    return false;
+  }
+
+  pJob->pParts = pParts;
+  pJob->numOfParts = numOfParts;
+  pJob->ref = 1;
+  pthread_mutex_init(&pJob->mutex, NULL);
+  pthread_cond_init(&pJob->cond, NULL);
+
+  int32_t capacity = tsParallelScanThreads * PARALLEL_SCAN_QUEUE_RATIO;
+  for (int32_t i = 1; i < numOfParts && tsParallelScanPool != NULL; ++i) {
+    if (atomic_add_fetch_32(&tsParallelScanQueued, 1) > capacity) {
+      atomic_sub_fetch_32(&tsParallelScanQueued, 1);
+      break;
+    }
+
+    SSchedMsg msg = {0};
+    msg.fp = doParallelScanWork;
+    msg.ahandle = pJob;
+
+    atomic_add_fetch_32(&pJob->ref, 1);
+    taosScheduleTask(tsParallelScanPool, &msg);
+  }
+
+  doParallelScanNextParts(pJob);
+
+  pthread_mutex_lock(&pJob->mutex);
+  while (pJob->nfinished < pJob->numOfParts) {
+    pthread_cond_wait(&pJob->cond, &pJob->mutex);
+  }
+  pthread_mutex_unlock(&pJob->mutex);
+
+  unrefParallelScanJob(pJob);
+  return true;
+}
+
+static void* doParallelScanPart(void* param) {
+  SQInfo*           pPart = (SQInfo*)param;
+  SQueryRuntimeEnv* pRuntimeEnv = &pPart->runtimeEnv;
+
+  int32_t ret = setjmp(pRuntimeEnv->env);
+  if (ret != TSDB_CODE_SUCCESS) {
+    pPart->code = ret;
+    qDebug("QInfo:0x%"PRIx64" partition of parallel scan abort, code:%s", pPart->qId, tstrerror(ret));
+    return NULL;
+  }
+
+  // there is only one table group, so all results are returned at once
+  bool newgroup = false;
+  pRuntimeEnv->outputBuf = pRuntimeEnv->proot->exec(pRuntimeEnv->proot, &newgroup);
+  return NULL;
+}
+
+static void addParallelScanPartCost(SQueryCostInfo* pSummary, SQueryCostInfo* pPartSummary) {
+  pSummary->loadStatisTime      += pPartSummary->loadStatisTime;
+  pSummary->loadFileBlockTime   += pPartSummary->loadFileBlockTime;
+  pSummary->loadDataInCacheTime += pPartSummary->loadDataInCacheTime;
+  pSummary->loadStatisSize      += pPartSummary->loadStatisSize;
+  pSummary->loadFileBlockSize   += pPartSummary->loadFileBlockSize;
+  pSummary->loadDataInCacheSize += pPartSummary->loadDataInCacheSize;
+  pSummary->loadDataTime        += pPartSummary->loadDataTime;
+  pSummary->totalRows           += pPartSummary->totalRows;
+  pSummary->totalCheckedRows    += pPartSummary->totalCheckedRows;
+  pSummary->totalBlocks         += pPartSummary->totalBlocks;
+  pSummary->loadBlocks          += pPartSummary->loadBlocks;
+  pSummary->loadBlockStatis     += pPartSummary->loadBlockStatis;
+  pSummary->loadBlockBloom      += pPartSummary->loadBlockBloom;
+  pSummary->discardBlocks       += pPartSummary->discardBlocks;
+  pSummary->aggCacheHits        += pPartSummary->aggCacheHits;
+  pSummary->aggCacheMisses      += pPartSummary->aggCacheMisses;
+  pSummary->readAheadHits       += pPartSummary->readAheadHits;
+  pSummary->readAheadMisses     += pPartSummary->readAheadMisses;
+  pSummary->readAheadWastes     += pPartSummary->readAheadWastes;
+}
+
+static SSDataBlock* doParallelAggregate(void* param, bool* newgroup) {
+  SOperatorInfo* pOperator = (SOperatorInfo*) param;
+  if (pOperator->status == OP_EXEC_DONE) {
+    return NULL;
+  }
+
+  SParallelAggOperatorInfo* pInfo = pOperator->info;
+  SQueryRuntimeEnv* pRuntimeEnv = pOperator->pRuntimeEnv;
+  SQInfo*           pQInfo = pRuntimeEnv->qinfo;
+
+  if (pOperator->status == OP_RES_TO_RETURN) {  // fall back to the serial operators
+    SOperatorInfo* upstream = pOperator->upstream[0];
+    return upstream->exec(upstream, newgroup);
+  }
+
+  int32_t numOfTables = pRuntimeEnv->tableqinfoGroupInfo.numOfTables;
+  int32_t numOfParts = MIN(tsParallelScanThreads, numOfTables / PARALLEL_SCAN_MIN_TABLES);
+
+  pInfo->pParts = calloc(numOfParts, POINTER_BYTES);
+  if (pInfo->pParts == NULL) {
+    longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+  }
+
+  for (int32_t i = 0; i < numOfParts; ++i) {
+    SQInfo* pPart = createParallelScanPart(pQInfo, i, numOfParts);
+    if (pPart == NULL) {
+      break;
+    }
+
+    pInfo->pParts[pInfo->numOfParts++] = pPart;
+  }
+
+  if (pInfo->numOfParts < numOfParts) {
+    qWarn("QInfo:0x%"PRIx64" failed to create partitions of parallel scan, scan %d tables serially", pQInfo->qId,
+          numOfTables);
+
+    for (int32_t i = 0; i < pInfo->numOfParts; ++i) {
+      destroyParallelScanPart(pInfo->pParts[i]);
+      pInfo->pParts[i] = NULL;
+    }
+
+    pInfo->numOfParts = 0;
+    pOperator->status = OP_RES_TO_RETURN;
+
+    SOperatorInfo* upstream = pOperator->upstream[0];
+    return upstream->exec(upstream, newgroup);
+  }
+
+  qDebug("QInfo:0x%"PRIx64" scan %d tables in %d partitions in parallel", pQInfo->qId, numOfTables, numOfParts);
+
+  if (!doParallelScanParts(pInfo->pParts, numOfParts)) {
+    for (int32_t i = 0; i < numOfParts; ++i) {
+      doParallelScanPart(pInfo->pParts[i]);
+    }
+  }
+
+  // the partitions read the mem snapshot of the query, they let it go before the query does
+  for (int32_t i = 0; i < numOfParts; ++i) {
+    SQueryRuntimeEnv* pPartEnv = &pInfo->pParts[i]->runtimeEnv;
+    addReadAheadCost(&pInfo->pParts[i]->summary, pPartEnv->pQueryHandle);
+    tsdbCleanupQueryHandle(pPartEnv->pQueryHandle);
+    pPartEnv->pQueryHandle = NULL;
+  }
+
+  int32_t code = TSDB_CODE_SUCCESS;
+  SSDataBlock* pRes = pInfo->pRes;
+  pRes->info.rows = 0;
+
+  for (int32_t i = 0; i < numOfParts; ++i) {
+    SQInfo* pPart = pInfo->pParts[i];
+    addParallelScanPartCost(&pQInfo->summary, &pPart->summary);
+
+    if (pPart->code != TSDB_CODE_SUCCESS) {
+      code = pPart->code;
+      continue;
+    }
+
+    SSDataBlock* pBlock = pPart->runtimeEnv.outputBuf;
+    if (pBlock == NULL || pBlock->info.rows == 0) {
+      continue;
+    }
+
+    assert(pRes->info.rows + pBlock->info.rows <= numOfParts);
+    for (int32_t j = 0; j < pOperator->numOfOutput; ++j) {
+      SColumnInfoData* pDst = taosArrayGet(pRes->pDataBlock, j);
+      SColumnInfoData* pSrc = taosArrayGet(pBlock->pDataBlock, j);
+
+      int32_t bytes = pDst->info.bytes;
+      memcpy(pDst->pData + pRes->info.rows * bytes, pSrc->pData, pBlock->info.rows * bytes);
+    }
+
+    pRes->info.rows += pBlock->info.rows;
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    longjmp(pRuntimeEnv->env, code);
+  }
+
+  doSetOperatorCompleted(pOperator);
+  return pRes;
+}
+
+static void destroyParallelAggOperatorInfo(void* param, int32_t numOfOutput) {
+  SParallelAggOperatorInfo* pInfo = (SParallelAggOperatorInfo*) param;
+
+  for (int32_t i = 0; i < pInfo->numOfParts; ++i) {
+    destroyParallelScanPart(pInfo->pParts[i]);
+  }
+
+  tfree(pInfo->pParts);
+  pInfo->pRes = destroyOutputBuf(pInfo->pRes);
+}
+
+SOperatorInfo* createParallelAggOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput) {
+  SParallelAggOperatorInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SParallelAggOperatorInfo));
+  if (pInfo == NULL) {
+    return NULL;
+  }
+
+  // each partition returns at most one row for the only table group
+  pInfo->pRes = createOutputBuf(pExpr, numOfOutput, tsParallelScanThreads);
+  if (pInfo->pRes == NULL) {
+    taosArenaFree(pInfo);
+    return NULL;
+  }
+
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
+  if (pOperator == NULL) {
+    destroyParallelAggOperatorInfo(pInfo, numOfOutput);
+    taosArenaFree(pInfo);
+    return NULL;
+  }
+
+  pOperator->name         = "ParallelAggregate";
+  pOperator->operatorType = OP_ParallelAggregate;
+  pOperator->blockingOptr = true;
+  pOperator->status       = OP_IN_EXECUTING;
+  pOperator->info         = pInfo;
+  pOperator->pExpr        = pExpr;
+  pOperator->numOfOutput  = numOfOutput;
+  pOperator->pRuntimeEnv  = pRuntimeEnv;
+
+  pOperator->exec         = doParallelAggregate;
+  pOperator->cleanup      = destroyParallelAggOperatorInfo;
+  appendUpstream(pOperator, upstream);
+
+  return pOperator;
+}
+
 SOperatorInfo* createProjectOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput) {
-  SProjectOperatorInfo* pInfo = calloc(1, sizeof(SProjectOperatorInfo));
+  SProjectOperatorInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SProjectOperatorInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -7597,7 +8443,7 @@ SOperatorInfo* createProjectOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperato
 
   setDefaultOutputBuf(pRuntimeEnv, pBInfo, pInfo->seed, MASTER_SCAN);
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
     goto _clean;
   }
@@ -7619,7 +8465,7 @@ SOperatorInfo* createProjectOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperato
 
 _clean:
   destroyProjectOperatorInfo((void *)pInfo, numOfOutput);
-  tfree(pInfo);
+  taosArenaFree(pInfo);
 
   return NULL;
 }
@@ -7655,7 +8501,7 @@ SColumnInfo* extractColumnFilterInfo(SExprInfo* pExpr, int32_t numOfOutput, int3
 
 SOperatorInfo* createFilterOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr,
                                         int32_t numOfOutput, SColumnInfo* pCols, int32_t numOfFilter) {
-  SFilterOperatorInfo* pInfo = calloc(1, sizeof(SFilterOperatorInfo));
+  SFilterOperatorInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SFilterOperatorInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -7664,7 +8510,7 @@ SOperatorInfo* createFilterOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperator
   doCreateFilterInfo(pCols, numOfOutput, numOfFilter, &pInfo->pFilterInfo, 0);
   pInfo->numOfFilterCols = numOfFilter;
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
     goto _clean;
   }
@@ -7685,22 +8531,22 @@ SOperatorInfo* createFilterOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperator
 
 _clean:
   destroyConditionOperatorInfo((void *)pInfo, numOfOutput);
-  tfree(pInfo);
+  taosArenaFree(pInfo);
 
   return NULL;
 }
 
 SOperatorInfo* createLimitOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream) {
-  SLimitOperatorInfo* pInfo = calloc(1, sizeof(SLimitOperatorInfo));
+  SLimitOperatorInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SLimitOperatorInfo));
   if (pInfo == NULL) {
     return NULL;
   }
 
   pInfo->limit = pRuntimeEnv->pQueryAttr->limit.limit;
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
-    tfree(pInfo);
+    taosArenaFree(pInfo);
     return NULL;
   }
 
@@ -7717,7 +8563,7 @@ SOperatorInfo* createLimitOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorI
 }
 
 SOperatorInfo* createTimeIntervalOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput) {
-  STableIntervalOperatorInfo* pInfo = calloc(1, sizeof(STableIntervalOperatorInfo));
+  STableIntervalOperatorInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(STableIntervalOperatorInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -7730,7 +8576,7 @@ SOperatorInfo* createTimeIntervalOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOp
     goto _clean;
   }
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
     goto _clean;
   }
@@ -7751,14 +8597,14 @@ SOperatorInfo* createTimeIntervalOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOp
 
 _clean:
   destroyBasicOperatorInfo((void *)pInfo, numOfOutput);
-  tfree(pInfo);
+  taosArenaFree(pInfo);
 
   return NULL;
 }
 
 
 SOperatorInfo* createTimeEveryOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput) {
-  STimeEveryOperatorInfo* pInfo = calloc(1, sizeof(STimeEveryOperatorInfo));
+  STimeEveryOperatorInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(STimeEveryOperatorInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -7788,7 +8634,7 @@ SOperatorInfo* createTimeEveryOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOpera
 
   setDefaultOutputBuf(pRuntimeEnv, pBInfo, pInfo->seed, MASTER_SCAN);
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
     goto _clean;
   }
@@ -7810,14 +8656,14 @@ SOperatorInfo* createTimeEveryOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOpera
 
 _clean:
   destroyTimeEveryOperatorInfo((void *)pInfo, numOfOutput);
-  tfree(pInfo);
+  taosArenaFree(pInfo);
 
   return NULL;
 }
 
 
 SOperatorInfo* createStatewindowOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput) {
-  SStateWindowOperatorInfo* pInfo = calloc(1, sizeof(SStateWindowOperatorInfo));
+  SStateWindowOperatorInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SStateWindowOperatorInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -7833,7 +8679,7 @@ SOperatorInfo* createStatewindowOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOpe
     goto _clean;
   }
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
     goto _clean;
   }
@@ -7854,13 +8700,13 @@ SOperatorInfo* createStatewindowOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOpe
 
 _clean:
   destroyStateWindowOperatorInfo((void *)pInfo, numOfOutput);
-  tfree(pInfo);
+  taosArenaFree(pInfo);
 
   return NULL;
 }
 
 SOperatorInfo* createSWindowOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput) {
-  SSWindowOperatorInfo* pInfo = calloc(1, sizeof(SSWindowOperatorInfo));
+  SSWindowOperatorInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SSWindowOperatorInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -7876,7 +8722,7 @@ SOperatorInfo* createSWindowOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperato
 
   pInfo->prevTs   = INT64_MIN;
   pInfo->reptScan = false;
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
     goto _clean;
   }
@@ -7897,13 +8743,13 @@ SOperatorInfo* createSWindowOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperato
 
 _clean:
   destroyStateWindowOperatorInfo((void *)pInfo, numOfOutput);
-  tfree(pInfo);
+  taosArenaFree(pInfo);
 
   return NULL;
 }
 
 SOperatorInfo* createMultiTableTimeIntervalOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput) {
-  STableIntervalOperatorInfo* pInfo = calloc(1, sizeof(STableIntervalOperatorInfo));
+  STableIntervalOperatorInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(STableIntervalOperatorInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -7916,7 +8762,7 @@ SOperatorInfo* createMultiTableTimeIntervalOperatorInfo(SQueryRuntimeEnv* pRunti
     goto _clean;
   }
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
     goto _clean;
   }
@@ -7938,14 +8784,14 @@ SOperatorInfo* createMultiTableTimeIntervalOperatorInfo(SQueryRuntimeEnv* pRunti
 
 _clean:
   destroyBasicOperatorInfo((void *)pInfo, numOfOutput);
-  tfree(pInfo);
+  taosArenaFree(pInfo);
 
   return NULL;
 }
 
 
 SOperatorInfo* createGroupbyOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput) {
-  SGroupbyOperatorInfo* pInfo = calloc(1, sizeof(SGroupbyOperatorInfo));
+  SGroupbyOperatorInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SGroupbyOperatorInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -7973,7 +8819,7 @@ SOperatorInfo* createGroupbyOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperato
     goto _clean;
   }
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
     goto _clean;
   }
@@ -7994,13 +8840,13 @@ SOperatorInfo* createGroupbyOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperato
 
 _clean:
   destroyGroupbyOperatorInfo((void *)pInfo, numOfOutput);
-  tfree(pInfo);
+  taosArenaFree(pInfo);
 
   return NULL;
 }
 
 SOperatorInfo* createFillOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput, bool multigroupResult) {
-  SFillOperatorInfo* pInfo = calloc(1, sizeof(SFillOperatorInfo));
+  SFillOperatorInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SFillOperatorInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -8039,7 +8885,7 @@ SOperatorInfo* createFillOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorIn
     }
   }
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
     goto _clean;
   }
@@ -8060,13 +8906,13 @@ SOperatorInfo* createFillOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorIn
 
 _clean:
   destroySFillOperatorInfo((void *)pInfo, numOfOutput);
-  tfree(pInfo);
+  taosArenaFree(pInfo);
 
   return NULL;
 }
 
 SOperatorInfo* createSLimitOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput, void* pMerger, bool multigroupResult) {
-  SSLimitOperatorInfo* pInfo = calloc(1, sizeof(SSLimitOperatorInfo));
+  SSLimitOperatorInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SSLimitOperatorInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -8108,7 +8954,7 @@ SOperatorInfo* createSLimitOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperator
 
   pInfo->pRes = createOutputBuf(pExpr, numOfOutput, pRuntimeEnv->resultInfo.capacity);
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
 
   if (pInfo->pRes == NULL || pOperator == NULL) {
     goto _clean;
@@ -8128,7 +8974,7 @@ SOperatorInfo* createSLimitOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperator
 
 _clean:
   destroySlimitOperatorInfo((void *)pInfo, numOfOutput);
-  tfree(pInfo);
+  taosArenaFree(pInfo);
 
   return NULL;
 }
@@ -8280,7 +9126,7 @@ static SSDataBlock* doTagScan(void* param, bool* newgroup) {
 }
 
 SOperatorInfo* createTagScanOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SExprInfo* pExpr, int32_t numOfOutput) {
-  STagScanInfo* pInfo = calloc(1, sizeof(STagScanInfo));
+  STagScanInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(STagScanInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -8296,7 +9142,7 @@ SOperatorInfo* createTagScanOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SExprInf
   pInfo->totalTables = pRuntimeEnv->tableqinfoGroupInfo.numOfTables;
   pInfo->curPos = 0;
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
     goto _clean;
   }
@@ -8316,7 +9162,7 @@ SOperatorInfo* createTagScanOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SExprInf
 
 _clean:
   destroyTagScanOperatorInfo((void *)pInfo, numOfOutput);
-  tfree(pInfo);
+  taosArenaFree(pInfo);
 
   return NULL;
 }
@@ -8436,7 +9282,7 @@ static SSDataBlock* hashDistinct(void* param, bool* newgroup) {
 }
 
 SOperatorInfo* createDistinctOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput) {
-  SDistinctOperatorInfo* pInfo = calloc(1, sizeof(SDistinctOperatorInfo));
+  SDistinctOperatorInfo* pInfo = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SDistinctOperatorInfo));
   if (pInfo == NULL) {
     return NULL;
   }
@@ -8453,7 +9299,7 @@ SOperatorInfo* createDistinctOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperat
     goto _clean;
   }
 
-  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  SOperatorInfo* pOperator = taosArenaCalloc(pRuntimeEnv->pArena, 1, sizeof(SOperatorInfo));
   if (pOperator == NULL) {
     goto _clean;
   }
@@ -8475,7 +9321,7 @@ SOperatorInfo* createDistinctOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperat
 
 _clean:
   destroyDistinctOperatorInfo((void *)pInfo, numOfOutput);
-  tfree(pInfo);
+  taosArenaFree(pInfo);
 
   return NULL;
 }
@@ -8984,6 +9830,37 @@ int32_t convertQueryMsg(SQueryTableMsg *pQueryMsg, SQueryParam* param) {
           pMsg += sizeof(*tlv) + tlv->len;
           break;
         }
+        case TLV_TYPE_LOCAL_JOIN: {
+          SLocalJoinMsg *pJoinMsg = (SLocalJoinMsg *)tlv->value;
+          int32_t        numOfTables = ntohl(pJoinMsg->numOfTables);
+          if (numOfTables != pQueryMsg->numOfTables ||
+              tlv->len != (int32_t)(sizeof(SLocalJoinMsg) + numOfTables * sizeof(STableIdInfo))) {
+            code = TSDB_CODE_QRY_INVALID_MSG;
+            goto _cleanup;
+          }
+
+          param->localJoinId = htobe64(pJoinMsg->joinId);
+          param->localJoinSides = ntohl(pJoinMsg->numOfSides);
+          param->pJoinTableIdList = taosArrayInit(numOfTables, sizeof(STableIdInfo));
+          if (param->pJoinTableIdList == NULL) {
+            code = TSDB_CODE_QRY_OUT_OF_MEMORY;
+            goto _cleanup;
+          }
+
+          for (int32_t i = 0; i < numOfTables; ++i) {
+            STableIdInfo *pTableIdInfo = &pJoinMsg->tables[i];
+            pTableIdInfo->tid = htonl(pTableIdInfo->tid);
+            pTableIdInfo->uid = htobe64(pTableIdInfo->uid);
+            pTableIdInfo->key = htobe64(pTableIdInfo->key);
+            if (taosArrayPush(param->pJoinTableIdList, pTableIdInfo) == NULL) {
+              code = TSDB_CODE_QRY_OUT_OF_MEMORY;
+              goto _cleanup;
+            }
+          }
+
+          pMsg += sizeof(*tlv) + tlv->len;
+          break;
+        }
         default: {
           pMsg += sizeof(*tlv) + tlv->len;
           break;
@@ -9626,6 +10503,12 @@ SQInfo* createQInfoImpl(SQueryTableMsg* pQueryMsg, SGroupbyExpr* pGroupbyExpr, S
   SQueryAttr* pQueryAttr = &pQInfo->query;
   pQInfo->runtimeEnv.pQueryAttr = pQueryAttr;
 
+  // with the arena off, the pieces are still malloc'ed one by one, as the allocation baseline
+  pQInfo->runtimeEnv.pArena = taosArenaInit(QUERY_ARENA_BLOCK_SIZE, tsQueryArena == 0);
+  if (pQInfo->runtimeEnv.pArena == NULL) {
+    goto _cleanup;
+  }
+
   pQueryAttr->tableGroupInfo  = *pTableGroupInfo;
   pQueryAttr->numOfCols       = numOfCols;
   pQueryAttr->numOfOutput     = numOfOutput;
@@ -9859,6 +10742,13 @@ int32_t initQInfo(STsBufInfo* pTsBufInfo, void* tsdb, void* sourceOptr, SQInfo*
       code = TSDB_CODE_QRY_NO_DISKSPACE;
       goto _error;
     }
+    tsBufResetPos(pTsBuf);
+    bool ret = tsBufNextPos(pTsBuf);
+    UNUSED(ret);
+  } else if (param->pJoinTsBuf != NULL) {  // the timestamps joined in the vnode
+    pTsBuf = param->pJoinTsBuf;
+    param->pJoinTsBuf = NULL;
+
     tsBufResetPos(pTsBuf);
     bool ret = tsBufNextPos(pTsBuf);
     UNUSED(ret);
@@ -9881,6 +10771,7 @@ int32_t initQInfo(STsBufInfo* pTsBufInfo, void* tsdb, void* sourceOptr, SQInfo*
            pQueryAttr->window.ekey, pQueryAttr->order.order);
     setQueryStatus(pRuntimeEnv, QUERY_COMPLETED);
     pRuntimeEnv->tableqinfoGroupInfo.numOfTables = 0;
+    tsBufDestroy(pTsBuf);
     // todo free memory
     return TSDB_CODE_SUCCESS;
   }
@@ -9888,6 +10779,7 @@ int32_t initQInfo(STsBufInfo* pTsBufInfo, void* tsdb, void* sourceOptr, SQInfo*
   if (pRuntimeEnv->tableqinfoGroupInfo.numOfTables == 0) {
     qDebug("QInfo:0x%"PRIx64" no table qualified for tag filter, abort query", pQInfo->qId);
     setQueryStatus(pRuntimeEnv, QUERY_COMPLETED);
+    tsBufDestroy(pTsBuf);
     return TSDB_CODE_SUCCESS;
   }
 
@@ -10001,6 +10893,7 @@ void freeQInfo(SQInfo *pQInfo) {
 
   tfree(pQInfo->pBuf);
   tfree(pQInfo->sql);
+  tfree(pQInfo->colCond);
 
   taosArrayDestroy(&pQInfo->summary.queryProfEvents);
   taosHashCleanup(pQInfo->summary.operatorProfResults);
@@ -10008,7 +10901,9 @@ void freeQInfo(SQInfo *pQInfo) {
   taosArrayDestroy(&pRuntimeEnv->groupResInfo.pRows);
   pQInfo->signature = 0;
 
-  qDebug("QInfo:0x%"PRIx64" QInfo is freed", pQInfo->qId);
+  qDebug("QInfo:0x%"PRIx64" QInfo is freed, arena:%"PRIzu" bytes", pQInfo->qId, taosArenaGetMemSize(pRuntimeEnv->pArena));
+  taosArenaDestroy(pRuntimeEnv->pArena);
+  pRuntimeEnv->pArena = NULL;
 
   tfree(pQInfo);
 }
@@ -19,6 +19,7 @@
 #include "hash.h"
 #include "tscUtil.h"
 #include "tsdbMeta.h"
+#include "tbloomfilter.h"
 
 OptrStr gOptrStr[] = {
   {TSDB_RELATION_INVALID,                  "invalid"},
@@ -3073,6 +3074,279 @@ static void doJsonCompare(SFilterComUnit *cunit, int8_t *result, void* colData){
   }
 }
 
+// the maximum number of values in the set of IN, for which the unit is evaluated in batch
+#define FILTER_BATCH_IN_MAX_SIZE 16
+
+bool gFilterBatchExec = true;
+
+// lower bound/upper bound of the range of each range compare function, 0: none, 1: include, 2: exclude
+static const int8_t gRangeBoundFlags[][2] = {{2, 2}, {2, 1}, {1, 2}, {1, 1}, {2, 0}, {1, 0}, {0, 2}, {0, 1}};
+
+static FORCE_INLINE int32_t filterCompareFloat(float p1, float p2) {
+  if (isnan(p1) || isnan(p2)) {
+    return (isnan(p2) != 0) - (isnan(p1) != 0);
+  }
+
+  return FLT_EQUAL(p1, p2) ? 0 : (p1 > p2 ? 1 : -1);
+}
+
+static FORCE_INLINE int32_t filterCompareDouble(double p1, double p2) {
+  if (isnan(p1) || isnan(p2)) {
+    return (isnan(p2) != 0) - (isnan(p1) != 0);
+  }
+
+  return FLT_EQUAL(p1, p2) ? 0 : (p1 > p2 ? 1 : -1);
+}
+
+// whether the unit can be evaluated on the whole column at once by filterExecuteUnitBatch
+static bool filterIsBatchUnit(SFilterComUnit *cunit) {
+  switch (cunit->dataType) {
+    case TSDB_DATA_TYPE_TINYINT:
+    case TSDB_DATA_TYPE_SMALLINT:
+    case TSDB_DATA_TYPE_INT:
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP:
+    case TSDB_DATA_TYPE_UTINYINT:
+    case TSDB_DATA_TYPE_USMALLINT:
+    case TSDB_DATA_TYPE_UINT:
+    case TSDB_DATA_TYPE_UBIGINT:
+    case TSDB_DATA_TYPE_FLOAT:
+    case TSDB_DATA_TYPE_DOUBLE:
+      break;
+    default:
+      return false;
+  }
+
+  switch (cunit->optr) {
+    case TSDB_RELATION_ISNULL:
+    case TSDB_RELATION_NOTNULL:
+    case TSDB_RELATION_EQUAL:
+    case TSDB_RELATION_NOT_EQUAL:
+      return true;
+    case TSDB_RELATION_IN:
+      return taosHashGetSize(cunit->valData) <= FILTER_BATCH_IN_MAX_SIZE;
+    default:
+      return cunit->rfunc >= 0;
+  }
+}
+
+// the values of the set of IN, which are kept as the keys of the hash
+static int32_t filterGetUnitSetVals(SFilterComUnit *cunit, void *vals, int32_t bytes) {
+  int32_t num = 0;
+
+  void *pIter = taosHashIterate(cunit->valData, NULL);
+  while (pIter != NULL) {
+    memcpy((char *)vals + num * bytes, taosHashGetDataKey(cunit->valData, pIter), bytes);
+    ++num;
+    pIter = taosHashIterate(cunit->valData, pIter);
+  }
+
+  return num;
+}
+
+/*
+ * The value compared with the rows, and the null value of the column are in the type of the column, so the rows
+ * are compared with them without any function call. The conditions are evaluated for all rows without any branch,
+ * which can be vectorized by the compiler. Exclusive bounds are converted to inclusive ones of integers.
+ */
+#define FILTER_BATCH_INT_UNIT(_t, _null, _min, _max)                                         \
+  do {                                                                                       \
+    const _t *v = (const _t *)cunit->colData;                                                \
+    _t        lo = (_min), hi = (_max);                                                      \
+                                                                                             \
+    if (cunit->optr == TSDB_RELATION_ISNULL || cunit->optr == TSDB_RELATION_NOTNULL) {       \
+      int8_t isnull = (cunit->optr == TSDB_RELATION_ISNULL);                                 \
+      for (int32_t i = 0; i < numOfRows; ++i) {                                              \
+        res[i] = (int8_t)((v[i] == (_t)(_null)) == isnull);                                  \
+      }                                                                                      \
+      return;                                                                                \
+    }                                                                                        \
+                                                                                             \
+    if (cunit->optr == TSDB_RELATION_IN) {                                                   \
+      _t      set[FILTER_BATCH_IN_MAX_SIZE];                                                 \
+      int32_t num = filterGetUnitSetVals(cunit, set, sizeof(_t));                            \
+      memset(res, 0, numOfRows);                                                             \
+      for (int32_t j = 0; j < num; ++j) {                                                    \
+        for (int32_t i = 0; i < numOfRows; ++i) {                                            \
+          res[i] |= (int8_t)(v[i] == set[j]);                                                \
+        }                                                                                    \
+      }                                                                                      \
+      for (int32_t i = 0; i < numOfRows; ++i) {                                              \
+        res[i] &= (int8_t)(v[i] != (_t)(_null));                                             \
+      }                                                                                      \
+      return;                                                                                \
+    }                                                                                        \
+                                                                                             \
+    if (cunit->optr == TSDB_RELATION_NOT_EQUAL) {                                            \
+      _t val = *(_t *)cunit->valData;                                                        \
+      for (int32_t i = 0; i < numOfRows; ++i) {                                              \
+        res[i] = (int8_t)((v[i] != (_t)(_null)) & (v[i] != val));                            \
+      }                                                                                      \
+      return;                                                                                \
+    }                                                                                        \
+                                                                                             \
+    if (cunit->optr == TSDB_RELATION_EQUAL) {                                                \
+      lo = hi = *(_t *)cunit->valData;                                                       \
+    } else {                                                                                 \
+      const int8_t *flags = gRangeBoundFlags[cunit->rfunc];                                  \
+      if (flags[0] != 0) {                                                                   \
+        lo = *(_t *)cunit->valData;                                                          \
+        if (flags[0] == 2 && lo++ == (_max)) {                                               \
+          memset(res, 0, numOfRows);                                                         \
+          return;                                                                            \
+        }                                                                                    \
+      }                                                                                      \
+      if (flags[1] != 0) {                                                                   \
+        hi = *(_t *)cunit->valData2;                                                         \
+        if (flags[1] == 2 && hi-- == (_min)) {                                               \
+          memset(res, 0, numOfRows);                                                         \
+          return;                                                                            \
+        }                                                                                    \
+      }                                                                                      \
+    }                                                                                        \
+                                                                                             \
+    for (int32_t i = 0; i < numOfRows; ++i) {                                                \
+      res[i] = (int8_t)((v[i] != (_t)(_null)) & (v[i] >= lo) & (v[i] <= hi));                \
+    }                                                                                        \
+  } while (0)
+
+// the null value of float/double is a NaN, the rows are checked with the bits of the null value
+#define FILTER_BATCH_FLOAT_UNIT(_t, _ut, _null, _cmp)                                        \
+  do {                                                                                       \
+    const _t  *v = (const _t *)cunit->colData;                                               \
+    const _ut *bits = (const _ut *)cunit->colData;                                           \
+                                                                                             \
+    if (cunit->optr == TSDB_RELATION_ISNULL || cunit->optr == TSDB_RELATION_NOTNULL) {       \
+      int8_t isnull = (cunit->optr == TSDB_RELATION_ISNULL);                                 \
+      for (int32_t i = 0; i < numOfRows; ++i) {                                              \
+        res[i] = (int8_t)((bits[i] == (_ut)(_null)) == isnull);                              \
+      }                                                                                      \
+      return;                                                                                \
+    }                                                                                        \
+                                                                                             \
+    if (cunit->optr == TSDB_RELATION_IN) {                                                   \
+      _ut     set[FILTER_BATCH_IN_MAX_SIZE];                                                 \
+      int32_t num = filterGetUnitSetVals(cunit, set, sizeof(_ut));                           \
+      memset(res, 0, numOfRows);                                                             \
+      for (int32_t j = 0; j < num; ++j) {                                                    \
+        for (int32_t i = 0; i < numOfRows; ++i) {                                            \
+          res[i] |= (int8_t)(bits[i] == set[j]);                                             \
+        }                                                                                    \
+      }                                                                                      \
+      for (int32_t i = 0; i < numOfRows; ++i) {                                              \
+        res[i] &= (int8_t)(bits[i] != (_ut)(_null));                                         \
+      }                                                                                      \
+      return;                                                                                \
+    }                                                                                        \
+                                                                                             \
+    if (cunit->optr == TSDB_RELATION_EQUAL || cunit->optr == TSDB_RELATION_NOT_EQUAL) {      \
+      _t     val = *(_t *)cunit->valData;                                                    \
+      int8_t eq = (cunit->optr == TSDB_RELATION_EQUAL);                                      \
+      for (int32_t i = 0; i < numOfRows; ++i) {                                              \
+        res[i] = (int8_t)((bits[i] != (_ut)(_null)) & ((_cmp(v[i], val) == 0) == eq));       \
+      }                                                                                      \
+      return;                                                                                \
+    }                                                                                        \
+                                                                                             \
+    const int8_t *flags = gRangeBoundFlags[cunit->rfunc];                                    \
+    _t            lo = (flags[0] != 0) ? *(_t *)cunit->valData : 0;                          \
+    _t            hi = (flags[1] != 0) ? *(_t *)cunit->valData2 : 0;                         \
+    int32_t       lmin = (flags[0] == 0) ? INT32_MIN : (flags[0] == 1 ? 0 : 1);              \
+    int32_t       hmax = (flags[1] == 0) ? INT32_MAX : (flags[1] == 1 ? 0 : -1);             \
+    for (int32_t i = 0; i < numOfRows; ++i) {                                                \
+      res[i] = (int8_t)((bits[i] != (_ut)(_null)) & (_cmp(v[i], lo) >= lmin) & (_cmp(v[i], hi) <= hmax)); \
+    }                                                                                        \
+  } while (0)
+
+// evaluate the unit for all rows of the column, the unit must be checked by filterIsBatchUnit
+static void filterExecuteUnitBatch(SFilterComUnit *cunit, int32_t numOfRows, int8_t *res) {
+  if (cunit->colData == NULL) {
+    memset(res, 0, numOfRows);
+    return;
+  }
+
+  switch (cunit->dataType) {
+    case TSDB_DATA_TYPE_TINYINT:
+      FILTER_BATCH_INT_UNIT(int8_t, TSDB_DATA_TINYINT_NULL, INT8_MIN, INT8_MAX);
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+      FILTER_BATCH_INT_UNIT(int16_t, TSDB_DATA_SMALLINT_NULL, INT16_MIN, INT16_MAX);
+      break;
+    case TSDB_DATA_TYPE_INT:
+      FILTER_BATCH_INT_UNIT(int32_t, TSDB_DATA_INT_NULL, INT32_MIN, INT32_MAX);
+      break;
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP:
+      FILTER_BATCH_INT_UNIT(int64_t, TSDB_DATA_BIGINT_NULL, INT64_MIN, INT64_MAX);
+      break;
+    case TSDB_DATA_TYPE_UTINYINT:
+      FILTER_BATCH_INT_UNIT(uint8_t, TSDB_DATA_UTINYINT_NULL, 0, UINT8_MAX);
+      break;
+    case TSDB_DATA_TYPE_USMALLINT:
+      FILTER_BATCH_INT_UNIT(uint16_t, TSDB_DATA_USMALLINT_NULL, 0, UINT16_MAX);
+      break;
+    case TSDB_DATA_TYPE_UINT:
+      FILTER_BATCH_INT_UNIT(uint32_t, TSDB_DATA_UINT_NULL, 0, UINT32_MAX);
+      break;
+    case TSDB_DATA_TYPE_UBIGINT:
+      FILTER_BATCH_INT_UNIT(uint64_t, TSDB_DATA_UBIGINT_NULL, 0, UINT64_MAX);
+      break;
+    case TSDB_DATA_TYPE_FLOAT:
+      FILTER_BATCH_FLOAT_UNIT(float, uint32_t, TSDB_DATA_FLOAT_NULL, filterCompareFloat);
+      break;
+    case TSDB_DATA_TYPE_DOUBLE:
+      FILTER_BATCH_FLOAT_UNIT(double, uint64_t, TSDB_DATA_DOUBLE_NULL, filterCompareDouble);
+      break;
+    default:
+      assert(0);
+  }
+}
+
+static FORCE_INLINE bool filterAllRowsQualified(int8_t *res, int32_t numOfRows) {
+  int8_t all = 1;
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    all &= res[i];
+  }
+
+  return all != 0;
+}
+
+// the groups are evaluated column by column, and the result of each group is merged to the final one
+static bool filterExecuteImplBatch(SFilterInfo *info, int32_t numOfRows, int8_t *p) {
+  for (uint32_t u = 0; u < info->unitNum; ++u) {
+    if (!filterIsBatchUnit(&info->cunits[u])) {
+      return false;
+    }
+  }
+
+  int8_t *ures = malloc(numOfRows * 2);
+  if (ures == NULL) {
+    return false;
+  }
+
+  int8_t *gres = ures + numOfRows;
+
+  memset(p, 0, numOfRows);
+  for (uint32_t g = 0; g < info->groupNum; ++g) {
+    SFilterGroup *group = &info->groups[g];
+
+    memset(gres, 1, numOfRows);
+    for (uint32_t u = 0; u < group->unitNum; ++u) {
+      filterExecuteUnitBatch(&info->cunits[group->unitIdxs[u]], numOfRows, ures);
+      for (int32_t i = 0; i < numOfRows; ++i) {
+        gres[i] &= ures[i];
+      }
+    }
+
+    for (int32_t i = 0; i < numOfRows; ++i) {
+      p[i] |= gres[i];
+    }
+  }
+
+  free(ures);
+  return true;
+}
+
 bool filterExecuteImplRange(void *pinfo, int32_t numOfRows, int8_t** p, SDataStatis *statis, int16_t numOfCols) {
   SFilterInfo *info = (SFilterInfo *)pinfo;
   bool all = true;
@@ -3090,6 +3364,11 @@ bool filterExecuteImplRange(void *pinfo, int32_t numOfRows, int8_t** p, SDataSta
   if (*p == NULL) {
     *p = calloc(numOfRows, sizeof(int8_t));
   }
+
+  if (gFilterBatchExec && filterIsBatchUnit(&info->cunits[0])) {
+    filterExecuteUnitBatch(&info->cunits[0], numOfRows, *p);
+    return filterAllRowsQualified(*p, numOfRows);
+  }
   
   for (int32_t i = 0; i < numOfRows; ++i) {
     if (colData == NULL || isNull(colData, info->cunits[0].dataType)) {
@@ -3121,6 +3400,12 @@ bool filterExecuteImplMisc(void *pinfo, int32_t numOfRows, int8_t** p, SDataStat
   if (*p == NULL) {
     *p = calloc(numOfRows, sizeof(int8_t));
   }
+
+  SFilterComUnit *cunit = &info->cunits[info->groups[0].unitIdxs[0]];
+  if (gFilterBatchExec && filterIsBatchUnit(cunit)) {
+    filterExecuteUnitBatch(cunit, numOfRows, *p);
+    return filterAllRowsQualified(*p, numOfRows);
+  }
   
   for (int32_t i = 0; i < numOfRows; ++i) {
     uint32_t uidx = info->groups[0].unitIdxs[0];
@@ -3167,6 +3452,10 @@ bool filterExecuteImpl(void *pinfo, int32_t numOfRows, int8_t** p, SDataStatis *
   if (*p == NULL) {
     *p = calloc(numOfRows, sizeof(int8_t));
   }
+
+  if (gFilterBatchExec && filterExecuteImplBatch(info, numOfRows, *p)) {
+    return filterAllRowsQualified(*p, numOfRows);
+  }
   
   for (int32_t i = 0; i < numOfRows; ++i) {
     //FILTER_UNIT_CLR_F(info);
@@ -3499,6 +3788,95 @@ bool filterRangeExecute(SFilterInfo *info, SDataStatis *pDataStatis, int32_t num
 
 
 
+static FORCE_INLINE bool filterIsBloomUnit(SFilterComUnit *cunit) {
+  return (cunit->optr == TSDB_RELATION_EQUAL || cunit->optr == TSDB_RELATION_IN) && cunit->valData != NULL &&
+         IS_BLOOM_FILTER_TYPE(cunit->dataType);
+}
+
+bool filterHasBloomUnit(SFilterInfo *info) {
+  if (info == NULL || FILTER_EMPTY_RES(info) || FILTER_ALL_RES(info) || info->cunits == NULL) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < info->unitNum; ++i) {
+    if (filterIsBloomUnit(&info->cunits[i])) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static bool filterBloomMayContain(SDataBloom *pBloom, SFilterComUnit *cunit) {
+  if (cunit->optr == TSDB_RELATION_EQUAL) {
+    if (IS_VAR_DATA_TYPE(cunit->dataType)) {
+      return taosBloomFilterMayContain(pBloom->bits, pBloom->len, pBloom->nHash, varDataVal(cunit->valData),
+                                       varDataLen(cunit->valData));
+    }
+
+    return taosBloomFilterMayContain(pBloom->bits, pBloom->len, pBloom->nHash, cunit->valData,
+                                     tDataTypes[cunit->dataType].bytes);
+  }
+
+  // the keys in the hash set of fixed length types are 8 bytes, with the value in the leading bytes
+  SHashObj *pSet = (SHashObj *)cunit->valData;
+  void *    p = taosHashIterate(pSet, NULL);
+  while (p != NULL) {
+    void *   key = taosHashGetDataKey(pSet, p);
+    uint32_t len = IS_VAR_DATA_TYPE(cunit->dataType) ? taosHashGetDataKeyLen(pSet, p) : tDataTypes[cunit->dataType].bytes;
+
+    if (taosBloomFilterMayContain(pBloom->bits, pBloom->len, pBloom->nHash, key, len)) {
+      taosHashCancelIterate(pSet, p);
+      return true;
+    }
+
+    p = taosHashIterate(pSet, p);
+  }
+
+  return false;
+}
+
+/*
+ * Check if a data block may contain qualified rows with the bloom filters of its columns. The block could be
+ * discarded only if each group has an equal/in unit whose values are absent from the bloom filter of the column.
+ */
+bool filterBloomExecute(SFilterInfo *info, SDataBloom *pDataBloom, int32_t numOfCols) {
+  if (FILTER_EMPTY_RES(info)) {
+    return false;
+  }
+
+  if (FILTER_ALL_RES(info) || pDataBloom == NULL) {
+    return true;
+  }
+
+  for (uint32_t g = 0; g < info->groupNum; ++g) {
+    SFilterGroup *group = &info->groups[g];
+    bool          mayMatch = true;
+
+    for (uint32_t u = 0; u < group->unitNum && mayMatch; ++u) {
+      SFilterComUnit *cunit = &info->cunits[group->unitIdxs[u]];
+      if (!filterIsBloomUnit(cunit)) {
+        continue;
+      }
+
+      for (int32_t i = 0; i < numOfCols; ++i) {
+        if (pDataBloom[i].colId == cunit->colId) {
+          if (pDataBloom[i].len > 0 && !filterBloomMayContain(&pDataBloom[i], cunit)) {
+            mayMatch = false;
+          }
+          break;
+        }
+      }
+    }
+
+    if (mayMatch) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 int32_t filterGetTimeRange(SFilterInfo *info, STimeWindow       *win) {
   SFilterRange ra = {0};
   SFilterRangeCtx *prev = filterInitRangeCtx(TSDB_DATA_TYPE_TIMESTAMP, FI_OPTION_TIMESTAMP);
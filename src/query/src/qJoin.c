@@ -0,0 +1,396 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "taosmsg.h"
+#include "tcache.h"
+#include "tsdb.h"
+#include "qExecutor.h"
+#include "qTsbuf.h"
+#include "query.h"
+#include "queryLog.h"
+
+/*
+ * The timestamps of a super table join are joined in the vnode holding the tables of both sides, instead of being sent
+ * to the client by the ts_comp queries. The query of each side carries the tables of the other side, and the i-th
+ * table of one side is joined with the i-th table of the other side. The side arriving first merges the timestamps of
+ * each pair of tables and keeps them in the cache until the other side takes them, so that both sides get the same
+ * timestamps and return the rows in the same order.
+ */
+
+#define LOCAL_JOIN_LOCKS        16
+#define LOCAL_JOIN_REFRESH_SEC  10
+#define LOCAL_JOIN_KEEP_MS      60000  // dropped if the other side does not come in time
+
+// appended to the STSBuf in pieces dividing MEM_BUF_SIZE, so that a ts block never exceeds it
+#define LOCAL_JOIN_APPEND_ROWS  1024
+
+typedef struct {
+  uint64_t joinId;
+  int32_t  vgId;
+} SLocalJoinKey;
+
+typedef struct {
+  uint64_t uid[2];  // the tables joined, the first one is of the side doing the join
+  int64_t  offset;  // of the first timestamp
+  int32_t  rows;
+} SLocalJoinPair;
+
+typedef struct {
+  int32_t remain;  // the sides not taken it yet
+  int32_t numOfPairs;
+  int64_t numOfRows;
+  char    data[];  // SLocalJoinPair[numOfPairs], then TSKEY[numOfRows]
+} SLocalJoinRes;
+
+typedef struct {
+  TsdbQueryHandleT pHandle;
+  SMemRef          memRef;  // the snapshot holds the tables of the query only, so it is not shared by the cursors
+  STableGroupInfo  group;
+  SDataBlockInfo   info;
+  TSKEY           *ts;  // NULL until the block is loaded
+  int32_t          pos;
+  bool             done;
+} SLocalJoinCursor;
+
+static SCacheObj      *tsLocalJoinCache = NULL;
+static pthread_mutex_t tsLocalJoinLocks[LOCAL_JOIN_LOCKS];
+
+#define LOCAL_JOIN_PAIRS(_r) ((SLocalJoinPair *)(_r)->data)
+#define LOCAL_JOIN_TS(_r)    ((TSKEY *)((_r)->data + sizeof(SLocalJoinPair) * (_r)->numOfPairs))
+
+int32_t qInitLocalJoin(void) {
+  tsLocalJoinCache = taosCacheInit(TSDB_DATA_TYPE_BINARY, LOCAL_JOIN_REFRESH_SEC, false, NULL, "localJoin");
+  if (tsLocalJoinCache == NULL) return -1;
+
+  for (int32_t i = 0; i < LOCAL_JOIN_LOCKS; ++i) {
+    pthread_mutex_init(&tsLocalJoinLocks[i], NULL);
+  }
+
+  return 0;
+}
+
+void qCleanupLocalJoin(void) {
+  if (tsLocalJoinCache == NULL) return;
+
+  taosCacheCleanup(tsLocalJoinCache);
+  tsLocalJoinCache = NULL;
+
+  for (int32_t i = 0; i < LOCAL_JOIN_LOCKS; ++i) {
+    pthread_mutex_destroy(&tsLocalJoinLocks[i]);
+  }
+}
+
+static void localJoinNextBlock(SLocalJoinCursor *pCursor) {
+  pCursor->ts = NULL;
+  pCursor->pos = 0;
+  pCursor->done = !tsdbNextDataBlock(pCursor->pHandle);
+  if (!pCursor->done) {
+    tsdbRetrieveDataBlockInfo(pCursor->pHandle, &pCursor->info);
+  }
+}
+
+// the block failing to load fails the join, the timestamps in it would be lost otherwise
+static int32_t localJoinLoadBlock(SLocalJoinCursor *pCursor) {
+  if (pCursor->ts != NULL) return TSDB_CODE_SUCCESS;
+
+  SArray *pCols = tsdbRetrieveDataBlock(pCursor->pHandle, NULL);
+  if (pCols == NULL) {
+    return terrno;
+  }
+
+  SColumnInfoData *pColData = taosArrayGet(pCols, 0);
+  assert(pColData->info.colId == PRIMARYKEY_TIMESTAMP_COL_INDEX);
+
+  pCursor->ts = (TSKEY *)pColData->pData;
+  tsdbRetrieveDataBlockInfo(pCursor->pHandle, &pCursor->info);
+  return TSDB_CODE_SUCCESS;
+}
+
+static int32_t localJoinOpenCursor(SLocalJoinCursor *pCursor, void *tsdb, uint64_t uid, STsdbQueryCond *pCond,
+                                   uint64_t qId) {
+  int32_t code = tsdbGetOneTableGroup(tsdb, uid, pCond->twindow.skey, &pCursor->group);
+  if (code != TSDB_CODE_SUCCESS) return code;
+
+  pCursor->pHandle = tsdbQueryTables(tsdb, pCond, &pCursor->group, qId, &pCursor->memRef);
+  if (pCursor->pHandle == NULL) return terrno;
+
+  localJoinNextBlock(pCursor);
+  return TSDB_CODE_SUCCESS;
+}
+
+static void localJoinCloseCursor(SLocalJoinCursor *pCursor) {
+  if (pCursor->pHandle != NULL) {
+    tsdbCleanupQueryHandle(pCursor->pHandle);
+    pCursor->pHandle = NULL;
+  }
+
+  tsdbDestroyTableGroup(&pCursor->group);
+}
+
+// merge the timestamps of two tables in ascending order, the blocks not overlapping the other side are not loaded
+static int32_t localJoinPair(void *tsdb, STsdbQueryCond *pCond, uint64_t uid1, uint64_t uid2, uint64_t qId,
+                             SArray *pTs) {
+  SLocalJoinCursor c1 = {0}, c2 = {0};
+  STimeWindow     *w = &pCond->twindow;
+
+  int32_t code = localJoinOpenCursor(&c1, tsdb, uid1, pCond, qId);
+  if (code == TSDB_CODE_SUCCESS) {
+    code = localJoinOpenCursor(&c2, tsdb, uid2, pCond, qId);
+  }
+
+  while (code == TSDB_CODE_SUCCESS && !c1.done && !c2.done) {
+    if (c1.info.window.ekey < c2.info.window.skey) {
+      localJoinNextBlock(&c1);
+      continue;
+    }
+
+    if (c2.info.window.ekey < c1.info.window.skey) {
+      localJoinNextBlock(&c2);
+      continue;
+    }
+
+    if ((code = localJoinLoadBlock(&c1)) != TSDB_CODE_SUCCESS || (code = localJoinLoadBlock(&c2)) != TSDB_CODE_SUCCESS) {
+      break;
+    }
+
+    while (c1.pos < c1.info.rows && c2.pos < c2.info.rows) {
+      TSKEY k1 = c1.ts[c1.pos], k2 = c2.ts[c2.pos];
+      if (k1 < k2) {
+        c1.pos += 1;
+      } else if (k1 > k2) {
+        c2.pos += 1;
+      } else {
+        if (k1 >= w->skey && k1 <= w->ekey && taosArrayPush(pTs, &k1) == NULL) {
+          code = TSDB_CODE_QRY_OUT_OF_MEMORY;
+          break;
+        }
+
+        c1.pos += 1;
+        c2.pos += 1;
+      }
+    }
+
+    if (c1.pos >= c1.info.rows) localJoinNextBlock(&c1);
+    if (c2.pos >= c2.info.rows) localJoinNextBlock(&c2);
+  }
+
+  localJoinCloseCursor(&c1);
+  localJoinCloseCursor(&c2);
+  return code;
+}
+
+static int32_t localJoinTables(void *tsdb, STimeWindow *pWindow, SArray *pTables, SArray *pJoinTables, uint64_t qId,
+                               SLocalJoinRes **pRes) {
+  SColumnInfo    col = {.colId = PRIMARYKEY_TIMESTAMP_COL_INDEX, .type = TSDB_DATA_TYPE_TIMESTAMP, .bytes = TSDB_KEYSIZE};
+  STsdbQueryCond cond = {
+      .twindow = *pWindow,
+      .order = TSDB_ORDER_ASC,
+      .numOfCols = 1,
+      .colList = &col,
+      .type = BLOCK_LOAD_OFFSET_SEQ_ORDER,
+  };
+
+  int32_t numOfPairs = (int32_t)taosArrayGetSize(pTables);
+  SArray *pPairs = taosArrayInit(numOfPairs, sizeof(SLocalJoinPair));
+  SArray *pTs = taosArrayInit(4096, sizeof(TSKEY));
+  int32_t code = (pPairs == NULL || pTs == NULL) ? TSDB_CODE_QRY_OUT_OF_MEMORY : TSDB_CODE_SUCCESS;
+
+  for (int32_t i = 0; i < numOfPairs && code == TSDB_CODE_SUCCESS; ++i) {
+    STableIdInfo *t1 = taosArrayGet(pTables, i);
+    STableIdInfo *t2 = taosArrayGet(pJoinTables, i);
+
+    SLocalJoinPair pair = {.uid = {t1->uid, t2->uid}, .offset = taosArrayGetSize(pTs)};
+    if ((code = localJoinPair(tsdb, &cond, t1->uid, t2->uid, qId, pTs)) != TSDB_CODE_SUCCESS) {
+      break;
+    }
+
+    pair.rows = (int32_t)(taosArrayGetSize(pTs) - pair.offset);
+    if (taosArrayPush(pPairs, &pair) == NULL) {
+      code = TSDB_CODE_QRY_OUT_OF_MEMORY;
+    }
+  }
+
+  if (code == TSDB_CODE_SUCCESS) {
+    int64_t        numOfRows = taosArrayGetSize(pTs);
+    SLocalJoinRes *p = malloc(sizeof(SLocalJoinRes) + sizeof(SLocalJoinPair) * numOfPairs + sizeof(TSKEY) * numOfRows);
+    if (p == NULL) {
+      code = TSDB_CODE_QRY_OUT_OF_MEMORY;
+    } else {
+      p->numOfPairs = numOfPairs;
+      p->numOfRows = numOfRows;
+      memcpy(LOCAL_JOIN_PAIRS(p), pPairs->pData, sizeof(SLocalJoinPair) * numOfPairs);
+      memcpy(LOCAL_JOIN_TS(p), pTs->pData, sizeof(TSKEY) * numOfRows);
+      *pRes = p;
+    }
+  }
+
+  taosArrayDestroy(&pPairs);
+  taosArrayDestroy(&pTs);
+  return code;
+}
+
+static size_t localJoinResSize(SLocalJoinRes *pRes) {
+  return sizeof(SLocalJoinRes) + sizeof(SLocalJoinPair) * pRes->numOfPairs + sizeof(TSKEY) * pRes->numOfRows;
+}
+
+// the timestamps are joined for the same tables, by this side or the other one
+static bool localJoinResMatch(SLocalJoinRes *pRes, SArray *pTables, SArray *pJoinTables) {
+  if (pRes->numOfPairs != taosArrayGetSize(pTables)) return false;
+
+  for (int32_t i = 0; i < pRes->numOfPairs; ++i) {
+    SLocalJoinPair *pPair = &LOCAL_JOIN_PAIRS(pRes)[i];
+    uint64_t        uid1 = ((STableIdInfo *)taosArrayGet(pTables, i))->uid;
+    uint64_t        uid2 = ((STableIdInfo *)taosArrayGet(pJoinTables, i))->uid;
+
+    if (!(pPair->uid[0] == uid1 && pPair->uid[1] == uid2) && !(pPair->uid[0] == uid2 && pPair->uid[1] == uid1)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// the timestamps of the tables of this side, with the tables of no timestamp joined removed from the query
+static int32_t localJoinBuildTsBuf(void *tsdb, int32_t vgId, SLocalJoinRes *pRes, SQueryParam *param,
+                                   SColumnInfo *pTagCol) {
+  STSBuf *pTsBuf = tsBufCreate(true, TSDB_ORDER_ASC);
+  if (pTsBuf == NULL) return TSDB_CODE_QRY_OUT_OF_MEMORY;
+
+  SArray *pTables = taosArrayInit(pRes->numOfPairs, sizeof(STableIdInfo));
+  int32_t code = (pTables == NULL) ? TSDB_CODE_QRY_OUT_OF_MEMORY : TSDB_CODE_SUCCESS;
+
+  for (int32_t i = 0; i < pRes->numOfPairs && code == TSDB_CODE_SUCCESS; ++i) {
+    SLocalJoinPair *pPair = &LOCAL_JOIN_PAIRS(pRes)[i];
+    STableIdInfo   *pTableId = taosArrayGet(param->pTableIdList, i);
+    if (pPair->rows == 0) continue;
+
+    STableGroupInfo group = {0};
+    if ((code = tsdbGetOneTableGroup(tsdb, pTableId->uid, 0, &group)) != TSDB_CODE_SUCCESS) {
+      break;
+    }
+
+    STableKeyInfo *pKeyInfo = taosArrayGet(taosArrayGetP(group.pGroupList, 0), 0);
+    tVariant       tag = {0};
+    doSetTagValueInParam(pKeyInfo->pTable, NULL, 0, pTagCol->colId, &tag, pTagCol->type, pTagCol->bytes);
+    tsdbDestroyTableGroup(&group);
+
+    TSKEY *ts = LOCAL_JOIN_TS(pRes) + pPair->offset;
+    for (int32_t j = 0; j < pPair->rows; j += LOCAL_JOIN_APPEND_ROWS) {
+      int32_t rows = MIN(pPair->rows - j, LOCAL_JOIN_APPEND_ROWS);
+      tsBufAppend(pTsBuf, vgId, &tag, (const char *)(ts + j), rows * TSDB_KEYSIZE);
+    }
+
+    tVariantDestroy(&tag);
+    if (taosArrayPush(pTables, pTableId) == NULL) {
+      code = TSDB_CODE_QRY_OUT_OF_MEMORY;
+    }
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    tsBufDestroy(pTsBuf);
+    taosArrayDestroy(&pTables);
+    return code;
+  }
+
+  tsBufFlush(pTsBuf);
+
+  taosArrayDestroy(&param->pTableIdList);
+  param->pTableIdList = pTables;
+
+  if (taosArrayGetSize(pTables) > 0) {
+    param->pJoinTsBuf = pTsBuf;
+  } else {
+    tsBufDestroy(pTsBuf);
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+int32_t qLocalJoin(void *tsdb, int32_t vgId, SQueryTableMsg *pQueryMsg, SQueryParam *param, uint64_t qId) {
+  SSqlExpr *pExpr = param->pExpr[0];
+  if (pExpr->numOfParams != 2) return TSDB_CODE_QRY_INVALID_MSG;
+
+  SColumnInfo *pTagCol = NULL;
+  for (int32_t i = 0; i < pQueryMsg->numOfTags; ++i) {
+    if (param->pTagColumnInfo[i].colId == pExpr->param[1].i64) {
+      pTagCol = &param->pTagColumnInfo[i];
+      break;
+    }
+  }
+
+  if (pTagCol == NULL) return TSDB_CODE_QRY_INVALID_MSG;
+
+  STimeWindow   w = {.skey = MIN(pQueryMsg->window.skey, pQueryMsg->window.ekey),
+                     .ekey = MAX(pQueryMsg->window.skey, pQueryMsg->window.ekey)};
+  SLocalJoinKey key = {.joinId = param->localJoinId, .vgId = vgId};
+  int64_t       st = taosGetTimestampUs();
+
+  SLocalJoinRes *pRes = NULL;
+  bool           cached = (param->localJoinSides > 1 && tsLocalJoinCache != NULL);
+  int32_t        code = TSDB_CODE_SUCCESS;
+
+  if (cached) {
+    pthread_mutex_t *pLock = &tsLocalJoinLocks[param->localJoinId % LOCAL_JOIN_LOCKS];
+    pthread_mutex_lock(pLock);
+
+    pRes = taosCacheAcquireByKey(tsLocalJoinCache, &key, sizeof(key));
+    if (pRes == NULL) {
+      SLocalJoinRes *p = NULL;
+      code = localJoinTables(tsdb, &w, param->pTableIdList, param->pJoinTableIdList, qId, &p);
+      if (code == TSDB_CODE_SUCCESS) {
+        p->remain = param->localJoinSides;
+        pRes = taosCachePut(tsLocalJoinCache, &key, sizeof(key), p, localJoinResSize(p), LOCAL_JOIN_KEEP_MS);
+        free(p);
+        if (pRes == NULL) code = TSDB_CODE_QRY_OUT_OF_MEMORY;
+      }
+    }
+
+    pthread_mutex_unlock(pLock);
+
+    // it shall not happen, unless the join id of two joins are the same
+    if (pRes != NULL && !localJoinResMatch(pRes, param->pTableIdList, param->pJoinTableIdList)) {
+      qWarn("qmsg:%p vgId:%d, tables of joinId:0x%" PRIx64 " mismatch, join them again", pQueryMsg, vgId,
+            param->localJoinId);
+      taosCacheRelease(tsLocalJoinCache, (void **)&pRes, false);
+      cached = false;
+    }
+  }
+
+  if (code == TSDB_CODE_SUCCESS && !cached) {
+    code = localJoinTables(tsdb, &w, param->pTableIdList, param->pJoinTableIdList, qId, &pRes);
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    qError("qmsg:%p vgId:%d, failed to join the tables of joinId:0x%" PRIx64 ", reason:%s", pQueryMsg, vgId,
+           param->localJoinId, tstrerror(code));
+    return code;
+  }
+
+  code = localJoinBuildTsBuf(tsdb, vgId, pRes, param, pTagCol);
+
+  qDebug("qmsg:%p vgId:%d, joinId:0x%" PRIx64 " %d pairs of tables joined, %" PRId64 " rows, %d tables to query, "
+         "elapsed time:%" PRId64 "us", pQueryMsg, vgId, param->localJoinId, pRes->numOfPairs, pRes->numOfRows,
+         (int32_t)taosArrayGetSize(param->pTableIdList), taosGetTimestampUs() - st);
+
+  if (cached) {
+    bool remove = (atomic_sub_fetch_32(&pRes->remain, 1) <= 0);
+    taosCacheRelease(tsLocalJoinCache, (void **)&pRes, remove);
+  } else {
+    free(pRes);
+  }
+
+  return code;
+}
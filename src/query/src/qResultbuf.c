@@ -9,6 +9,12 @@
 #define GET_DATA_PAYLOAD(_p) ((char *)(_p)->pData + POINTER_BYTES)
 #define NO_IN_MEM_AVAILABLE_PAGES(_b) (listNEles((_b)->lruList) >= (_b)->inMemPages)
 
+// the first byte of a compressed page tells how it is compressed
+#define PAGE_COMP_STRING  0
+#define PAGE_COMP_COLUMN  1
+
+#define PAGE_COMP_EXTRA_BYTES 64
+
 int32_t createDiskbasedResultBuffer(SDiskbasedResultBuf** pResultBuf, int32_t pagesize, int32_t inMemBufSize, uint64_t qId) {
   *pResultBuf = calloc(1, sizeof(SDiskbasedResultBuf));
 
@@ -34,7 +40,7 @@ int32_t createDiskbasedResultBuffer(SDiskbasedResultBuf** pResultBuf, int32_t pa
 
   // init id hash table
   pResBuf->groupSet  = taosHashInit(10, taosGetDefaultHashFunction(TSDB_DATA_TYPE_INT), true, false);
-  pResBuf->assistBuf = malloc(pResBuf->pageSize + 2); // EXTRA BYTES
+  pResBuf->assistBuf = malloc(pResBuf->pageSize + PAGE_COMP_EXTRA_BYTES); // EXTRA BYTES
   pResBuf->all = taosHashInit(10, taosGetDefaultHashFunction(TSDB_DATA_TYPE_INT), true, false);
 
   char path[PATH_MAX] = {0};
@@ -42,6 +48,7 @@ int32_t createDiskbasedResultBuffer(SDiskbasedResultBuf** pResultBuf, int32_t pa
   pResBuf->path = strdup(path);
 
   pResBuf->emptyDummyIdList = taosArrayInit(1, sizeof(int32_t));
+  pResBuf->pFree = taosArrayInit(4, sizeof(SFreeListItem));
 
   qDebug("QInfo:0x%"PRIx64" create resBuf for output, page size:%d, inmem buf pages:%d, file:%s", qId, pResBuf->pageSize,
          pResBuf->inMemPages, pResBuf->path);
@@ -59,29 +66,243 @@ static int32_t createDiskFile(SDiskbasedResultBuf* pResultBuf) {
   return TSDB_CODE_SUCCESS;
 }
 
-static char* doCompressData(void* data, int32_t srcSize, int32_t *dst, SDiskbasedResultBuf* pResultBuf) { // do nothing
+int32_t setResultBufPageLayout(SDiskbasedResultBuf* pResultBuf, int32_t rowSize, const SPageColInfo* pCols, int32_t numOfCols) {
+  if (rowSize <= 0 || rowSize > pResultBuf->pageSize - (int32_t)sizeof(tFilePage)) {
+    return TSDB_CODE_QRY_INVALID_MSG;
+  }
+
+  // the gaps between the columns are kept as binary columns, so the compressed page can always be restored
+  SPageColInfo* p = calloc(numOfCols * 2 + 1, sizeof(SPageColInfo));
+  void*         colBuf = malloc(pResultBuf->pageSize);
+  if (p == NULL || colBuf == NULL) {
+    tfree(p);
+    tfree(colBuf);
+    return TSDB_CODE_QRY_OUT_OF_MEMORY;
+  }
+
+  int32_t num = 0;
+  int32_t offset = 0;
+  for (int32_t i = 0; i < numOfCols; ++i) {
+    if (pCols[i].offset < offset || pCols[i].bytes <= 0 || pCols[i].offset + pCols[i].bytes > rowSize) {
+      qDebug("QInfo:0x%"PRIx64" invalid page layout, column:%d offset:%d bytes:%d row size:%d", pResultBuf->qId, i,
+             pCols[i].offset, pCols[i].bytes, rowSize);
+      tfree(p);
+      tfree(colBuf);
+      return TSDB_CODE_QRY_INVALID_MSG;
+    }
+
+    if (pCols[i].offset > offset) {
+      p[num++] = (SPageColInfo) {.type = TSDB_DATA_TYPE_BINARY, .offset = offset, .bytes = pCols[i].offset - offset};
+    }
+
+    p[num++] = pCols[i];
+    offset = pCols[i].offset + pCols[i].bytes;
+  }
+
+  if (offset < rowSize) {
+    p[num++] = (SPageColInfo) {.type = TSDB_DATA_TYPE_BINARY, .offset = offset, .bytes = rowSize - offset};
+  }
+
+  tfree(pResultBuf->pCols);
+  tfree(pResultBuf->colBuf);
+
+  pResultBuf->rowSize   = rowSize;
+  pResultBuf->numOfCols = num;
+  pResultBuf->pCols     = p;
+  pResultBuf->colBuf    = colBuf;
+  return TSDB_CODE_SUCCESS;
+}
+
+// number of values of the column type in the column, 0 if it is not compressed by the codec of the column type
+static int32_t getNumOfPageColumnElems(const SPageColInfo* pCol, int32_t rows) {
+  switch(pCol->type) {
+    case TSDB_DATA_TYPE_TINYINT:
+    case TSDB_DATA_TYPE_SMALLINT:
+    case TSDB_DATA_TYPE_INT:
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP:
+    case TSDB_DATA_TYPE_FLOAT:
+    case TSDB_DATA_TYPE_DOUBLE: {
+      int32_t bytes = tDataTypes[pCol->type].bytes;
+      return (pCol->bytes % bytes == 0) ? (pCol->bytes / bytes) * rows : 0;
+    }
+    default:
+      return 0;
+  }
+}
+
+static int32_t doCompressPageColumn(const SPageColInfo* pCol, const char* input, int32_t rows, char* output,
+                                    int32_t outputSize) {
+  int32_t num = getNumOfPageColumnElems(pCol, rows);
+  int16_t type = (num > 0) ? pCol->type : TSDB_DATA_TYPE_BINARY;
+
+  switch(type) {
+    case TSDB_DATA_TYPE_TINYINT:
+    case TSDB_DATA_TYPE_SMALLINT:
+    case TSDB_DATA_TYPE_INT:
+    case TSDB_DATA_TYPE_BIGINT:
+      return tsCompressINTImp(input, num, output, (char)type);
+    case TSDB_DATA_TYPE_TIMESTAMP:
+      return tsCompressTimestampImp(input, num, output);
+    case TSDB_DATA_TYPE_FLOAT:
+      return tsCompressFloatImp(input, num, output);
+    case TSDB_DATA_TYPE_DOUBLE:
+      return tsCompressDoubleImp(input, num, output);
+    default:
+      return tsCompressStringImp(input, pCol->bytes * rows, output, outputSize);
+  }
+}
+
+static int32_t doDecompressPageColumn(const SPageColInfo* pCol, const char* input, int32_t compLen, int32_t rows,
+                                      char* output, int32_t outputSize) {
+  int32_t num = getNumOfPageColumnElems(pCol, rows);
+  int16_t type = (num > 0) ? pCol->type : TSDB_DATA_TYPE_BINARY;
+
+  switch(type) {
+    case TSDB_DATA_TYPE_TINYINT:
+    case TSDB_DATA_TYPE_SMALLINT:
+    case TSDB_DATA_TYPE_INT:
+    case TSDB_DATA_TYPE_BIGINT:
+      return tsDecompressINTImp(input, num, output, (char)type);
+    case TSDB_DATA_TYPE_TIMESTAMP:
+      return tsDecompressTimestampImp(input, num, output);
+    case TSDB_DATA_TYPE_FLOAT:
+      return tsDecompressFloatImp(input, num, output);
+    case TSDB_DATA_TYPE_DOUBLE:
+      return tsDecompressDoubleImp(input, num, output);
+    default:
+      return tsDecompressStringImp(input, compLen, output, outputSize);
+  }
+}
+
+/*
+ * The whole rows in use are compressed column by column, following the number of bytes in use of the page, and the rest
+ * of the page, including a row in use partly, is compressed as a whole. The result is given up if it is not smaller than the page.
+ */
+static int32_t doCompressPageByColumn(SDiskbasedResultBuf* pResultBuf, tFilePage* pPage, char* output) {
+  int32_t dataSize = pResultBuf->pageSize - (int32_t)sizeof(tFilePage);
+  if (pPage->num > (uint64_t)dataSize) {
+    return -1;
+  }
+
+  int32_t rowSize = pResultBuf->rowSize;
+  int32_t rows = (int32_t)(pPage->num / rowSize);
+  char*   colBuf = pResultBuf->colBuf;
+
+  output[0] = PAGE_COMP_COLUMN;
+  memcpy(output + 1, &pPage->num, sizeof(pPage->num));
+  int32_t pos = 1 + sizeof(pPage->num);
+
+  for (int32_t i = 0; i < pResultBuf->numOfCols && rows > 0; ++i) {
+    SPageColInfo* pCol = &pResultBuf->pCols[i];
+    int32_t       len = pCol->bytes * rows;
+
+    if (pos + (int32_t)sizeof(int32_t) + len + PAGE_COMP_EXTRA_BYTES / 2 > pResultBuf->pageSize) {
+      return -1;
+    }
+
+    for (int32_t j = 0; j < rows; ++j) {
+      memcpy(colBuf + j * pCol->bytes, pPage->data + j * rowSize + pCol->offset, pCol->bytes);
+    }
+
+    int32_t compLen = doCompressPageColumn(pCol, colBuf, rows, output + pos + sizeof(int32_t), len + 1);
+    memcpy(output + pos, &compLen, sizeof(int32_t));
+    pos += sizeof(int32_t) + compLen;
+  }
+
+  int32_t len = MAX(dataSize - rows * rowSize, 0);
+  if (pos + (int32_t)sizeof(int32_t) + len + PAGE_COMP_EXTRA_BYTES / 2 > pResultBuf->pageSize) {
+    return -1;
+  }
+
+  int32_t compLen = tsCompressStringImp(pPage->data + rows * rowSize, len, output + pos + sizeof(int32_t), len + 1);
+  memcpy(output + pos, &compLen, sizeof(int32_t));
+  pos += sizeof(int32_t) + compLen;
+
+  return (pos < pResultBuf->pageSize) ? pos : -1;
+}
+
+static int32_t doDecompressPageByColumn(SDiskbasedResultBuf* pResultBuf, const char* input, int32_t srcSize,
+                                        tFilePage* pPage) {
+  int32_t dataSize = pResultBuf->pageSize - (int32_t)sizeof(tFilePage);
+  int32_t rowSize = pResultBuf->rowSize;
+  char*   colBuf = pResultBuf->colBuf;
+
+  memcpy(&pPage->num, input + 1, sizeof(pPage->num));
+  int32_t rows = (int32_t)(pPage->num / rowSize);
+  int32_t pos = 1 + sizeof(pPage->num);
+
+  for (int32_t i = 0; i < pResultBuf->numOfCols && rows > 0; ++i) {
+    SPageColInfo* pCol = &pResultBuf->pCols[i];
+    int32_t       compLen = 0;
+
+    memcpy(&compLen, input + pos, sizeof(int32_t));
+    pos += sizeof(int32_t);
+
+    int32_t len = doDecompressPageColumn(pCol, input + pos, compLen, rows, colBuf, pResultBuf->pageSize);
+    if (len != pCol->bytes * rows) {
+      return -1;
+    }
+
+    for (int32_t j = 0; j < rows; ++j) {
+      memcpy(pPage->data + j * rowSize + pCol->offset, colBuf + j * pCol->bytes, pCol->bytes);
+    }
+
+    pos += compLen;
+  }
+
+  int32_t compLen = 0;
+  memcpy(&compLen, input + pos, sizeof(int32_t));
+  pos += sizeof(int32_t);
+
+  int32_t len = MAX(dataSize - rows * rowSize, 0);
+  if (rows * rowSize > dataSize ||
+      tsDecompressStringImp(input + pos, compLen, pPage->data + rows * rowSize, len) != len ||
+      pos + compLen != srcSize) {
+    return -1;
+  }
+
+  return pResultBuf->pageSize;
+}
+
+// the compressed data is put in the assistant buffer
+static char* doCompressData(void* data, int32_t srcSize, int32_t *dst, SDiskbasedResultBuf* pResultBuf) {
   if (!pResultBuf->comp) {
     *dst = srcSize;
     return data;
   }
 
-  *dst = tsCompressString(data, srcSize, 1, pResultBuf->assistBuf, srcSize, ONE_STAGE_COMP, NULL, 0);
+  char* output = pResultBuf->assistBuf;
+  if (pResultBuf->rowSize > 0) {
+    *dst = doCompressPageByColumn(pResultBuf, (tFilePage*) data, output);
+    if (*dst > 0) {
+      pResultBuf->statis.colCompPages += 1;
+      return output;
+    }
+  }
 
-  memcpy(data, pResultBuf->assistBuf, *dst);
-  return data;
+  output[0] = PAGE_COMP_STRING;
+  *dst = tsCompressString(data, srcSize, 1, output + 1, srcSize + 1, ONE_STAGE_COMP, NULL, 0) + 1;
+  return output;
 }
 
-static char* doDecompressData(void* data, int32_t srcSize, int32_t *dst, SDiskbasedResultBuf* pResultBuf) { // do nothing
+// decompress the data in the assistant buffer to the page
+static int32_t doDecompressData(void* data, int32_t srcSize, int32_t *dst, SDiskbasedResultBuf* pResultBuf) {
   if (!pResultBuf->comp) {
     *dst = srcSize;
-    return data;
+    return TSDB_CODE_SUCCESS;
   }
 
-  *dst = tsDecompressString(data, srcSize, 1, pResultBuf->assistBuf, pResultBuf->pageSize, ONE_STAGE_COMP, NULL, 0);
-  if (*dst > 0) {
-    memcpy(data, pResultBuf->assistBuf, *dst);
+  char* input = pResultBuf->assistBuf;
+  if (input[0] == PAGE_COMP_COLUMN && pResultBuf->rowSize > 0) {
+    *dst = doDecompressPageByColumn(pResultBuf, input, srcSize, (tFilePage*) data);
+  } else if (input[0] == PAGE_COMP_STRING) {
+    *dst = tsDecompressString(input + 1, srcSize - 1, 1, data, pResultBuf->pageSize, ONE_STAGE_COMP, NULL, 0);
+  } else {
+    *dst = -1;
   }
-  return data;
+
+  return (*dst == pResultBuf->pageSize) ? TSDB_CODE_SUCCESS : TSDB_CODE_QRY_SYS_ERROR;
 }
 
 static int32_t allocatePositionInFile(SDiskbasedResultBuf* pResultBuf, size_t size) {
@@ -113,56 +334,35 @@ static char* doFlushPageToDisk(SDiskbasedResultBuf* pResultBuf, SPageInfo* pg) {
   int32_t size = -1;
   char* t = doCompressData(GET_DATA_PAYLOAD(pg), pResultBuf->pageSize, &size, pResultBuf);
 
-  // this page is flushed to disk for the first time
-  if (pg->info.offset == -1) {
-    pg->info.offset = allocatePositionInFile(pResultBuf, size);
-    pResultBuf->nextPos += size;
-
-    int32_t ret = fseek(pResultBuf->file, pg->info.offset, SEEK_SET);
-    assert(ret == 0);
-
-    ret = (int32_t) fwrite(t, 1, size, pResultBuf->file);
-    assert(ret == size);
-
-    if (pResultBuf->fileSize < pg->info.offset + pg->info.length) {
-      pResultBuf->fileSize = pg->info.offset + pg->info.length;
-    }
-  } else {
-    // length becomes greater, current space is not enough, allocate new place, otherwise, do nothing
-    if (pg->info.length < size) {
-      // 1. add current space to free list
+  // this page is flushed to disk for the first time, or the compressed data no longer fits in its place
+  if (pg->info.offset == -1 || pg->info.length < size) {
+    if (pg->info.offset != -1) {
       taosArrayPush(pResultBuf->pFree, &pg->info);
-
-      // 2. allocate new position, and update the info
-      pg->info.offset = allocatePositionInFile(pResultBuf, size);
-      pResultBuf->nextPos += size;
     }
 
-    //3. write to disk.
-    int32_t ret = fseek(pResultBuf->file, pg->info.offset, SEEK_SET);
-    if (ret != 0) {  // todo handle the error case
-
-    }
+    pg->info.offset = allocatePositionInFile(pResultBuf, size);
+    pResultBuf->nextPos += size;
+  }
 
-    ret = (int32_t)fwrite(t, size, 1, pResultBuf->file);
-    if (ret != size) {  // todo handle the error case
+  int32_t ret = fseek(pResultBuf->file, pg->info.offset, SEEK_SET);
+  assert(ret == 0);
 
-    }
+  ret = (int32_t) fwrite(t, 1, size, pResultBuf->file);
+  assert(ret == size);
 
-    if (pResultBuf->fileSize < pg->info.offset + pg->info.length) {
-      pResultBuf->fileSize = pg->info.offset + pg->info.length;
-    }
+  if (pResultBuf->fileSize < pg->info.offset + size) {
+    pResultBuf->fileSize = pg->info.offset + size;
   }
 
-  char* ret = pg->pData;
-  memset(ret, 0, pResultBuf->pageSize);
+  char* pData = pg->pData;
+  memset(pData, 0, pResultBuf->pageSize);
 
   pg->pData = NULL;
   pg->info.length = size;
 
   pResultBuf->statis.flushBytes += pg->info.length;
 
-  return ret;
+  return pData;
 }
 
 static char* flushPageToDisk(SDiskbasedResultBuf* pResultBuf, SPageInfo* pg) {
@@ -181,17 +381,25 @@ static char* flushPageToDisk(SDiskbasedResultBuf* pResultBuf, SPageInfo* pg) {
 
 // load file block data in disk
 static char* loadPageFromDisk(SDiskbasedResultBuf* pResultBuf, SPageInfo* pg) {
+  char* buf = pResultBuf->comp ? pResultBuf->assistBuf : GET_DATA_PAYLOAD(pg);
+
   int32_t ret = fseek(pResultBuf->file, pg->info.offset, SEEK_SET);
-  ret = (int32_t)fread(GET_DATA_PAYLOAD(pg), 1, pg->info.length, pResultBuf->file);
+  ret = (int32_t)fread(buf, 1, pg->info.length, pResultBuf->file);
   if (ret != pg->info.length) {
     terrno = errno;
     return NULL;
   }
 
   pResultBuf->statis.loadBytes += pg->info.length;
+  pResultBuf->statis.loadPages += 1;
 
   int32_t fullSize = 0;
-  doDecompressData(GET_DATA_PAYLOAD(pg), pg->info.length, &fullSize, pResultBuf);
+  if (doDecompressData(GET_DATA_PAYLOAD(pg), pg->info.length, &fullSize, pResultBuf) != TSDB_CODE_SUCCESS) {
+    qError("QInfo:0x%"PRIx64" failed to decompress page:%d, offset:%d, length:%d", pResultBuf->qId, pg->pageId,
+           pg->info.offset, pg->info.length);
+    terrno = TSDB_CODE_QRY_SYS_ERROR;
+    return NULL;
+  }
 
   return (char*)GET_DATA_PAYLOAD(pg);
 }
@@ -439,10 +647,13 @@ void destroyResultBuf(SDiskbasedResultBuf* pResultBuf) {
 
   tdListFree(pResultBuf->lruList);
   taosArrayDestroy(&pResultBuf->emptyDummyIdList);
+  taosArrayDestroy(&pResultBuf->pFree);
   taosHashCleanup(pResultBuf->groupSet);
   taosHashCleanup(pResultBuf->all);
 
   tfree(pResultBuf->assistBuf);
+  tfree(pResultBuf->pCols);
+  tfree(pResultBuf->colBuf);
   tfree(pResultBuf);
 }
 
@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "taosmsg.h"
+#include "tglobal.h"
+#include "tlist.h"
+#include "tutil.h"
+#include "qExecutor.h"
+#include "query.h"
+#include "queryLog.h"
+
+/*
+ * The execution slices of the vnode queries, i.e. the calls of qTableQuery, take one of the slots of the scheduler.
+ * A query that finds no slot is kept in the waiting list of its class without holding a worker thread, and is put
+ * back into its query queue once a slot is reserved for it. The interactive queries are always served first, and a
+ * batch query in execution gives its slot to them between two data blocks, waiting in its worker thread until the
+ * interactive queries are done. So the worker threads are the slots plus the batch queries allowed at the same time,
+ * and the batch queries, the preempted ones included, are never more than that: otherwise the preempted queries could
+ * hold all the threads left by the running ones, while the queries the slots are reserved for wait for a thread.
+ */
+
+enum {
+  QUERY_SCHED_NONE = 0,
+  QUERY_SCHED_WAITING,   // in the waiting list
+  QUERY_SCHED_RESERVED,  // a slot is reserved, on its way back to the query queue
+  QUERY_SCHED_RUNNING,   // holds a slot
+};
+
+typedef struct {
+  void       **qhandle;
+  FQueryResume fp;
+  void        *param;
+} SQueryWaiter;
+
+typedef struct {
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;       // the preempted queries wait on it
+  int32_t         slots;
+  int32_t         maxBatch;
+  int32_t         running[QUERY_CLASS_MAX];
+  int32_t         preempted;
+  int32_t         numOfWaiting;  // interactive queries in the waiting list, read without the lock
+  SList          *waiting[QUERY_CLASS_MAX];
+  SQueryClassStat stat[QUERY_CLASS_MAX];
+  char           *users;
+  char          **batchUsers;
+  int32_t         numOfBatchUsers;
+} SQueryScheduler;
+
+static SQueryScheduler *tsQueryScheduler = NULL;
+
+int32_t qInitScheduler(int32_t slots) {
+  if (tsQuerySliceTime <= 0) return 0;
+
+  SQueryScheduler *pSched = calloc(1, sizeof(SQueryScheduler));
+  if (pSched == NULL) return -1;
+
+  pSched->slots = MAX(slots, 1);
+  pSched->maxBatch = (tsMaxBatchQueries > 0) ? tsMaxBatchQueries : MAX(pSched->slots / 2, 1);
+  for (int32_t i = 0; i < QUERY_CLASS_MAX; ++i) {
+    pSched->waiting[i] = tdListNew(sizeof(SQueryWaiter));
+    if (pSched->waiting[i] == NULL) {
+      tsQueryScheduler = pSched;
+      qCleanupScheduler();
+      return -1;
+    }
+  }
+
+  if (tsBatchQueryUsers[0] != 0) {
+    pSched->users = strdup(tsBatchQueryUsers);
+    pSched->batchUsers = strsplit(pSched->users, ",", &pSched->numOfBatchUsers);
+    for (int32_t i = 0; i < pSched->numOfBatchUsers; ++i) {
+      strtrim(pSched->batchUsers[i]);
+    }
+  }
+
+  pthread_mutex_init(&pSched->mutex, NULL);
+  pthread_cond_init(&pSched->cond, NULL);
+  tsQueryScheduler = pSched;
+
+  qInfo("query scheduler is initialized, slots:%d maxBatchQueries:%d sliceTime:%dms batchUsers:%d", pSched->slots,
+        pSched->maxBatch, tsQuerySliceTime, pSched->numOfBatchUsers);
+  return 0;
+}
+
+void qCleanupScheduler(void) {
+  SQueryScheduler *pSched = tsQueryScheduler;
+  if (pSched == NULL) return;
+
+  // the waiting queries keep their qhandles and params, which are released by resuming them once the scheduler is
+  // gone. The vnodes are closed by then, so they fail to be put back into the query queues and are freed.
+  tsQueryScheduler = NULL;
+  for (int32_t i = 0; i < QUERY_CLASS_MAX; ++i) {
+    SListNode *pNode = NULL;
+    while (pSched->waiting[i] != NULL && (pNode = tdListPopHead(pSched->waiting[i])) != NULL) {
+      SQueryWaiter waiter;
+      tdListNodeGetData(pSched->waiting[i], pNode, &waiter);
+      listNodeFree(pNode);
+
+      SQInfo *pQInfo = *waiter.qhandle;
+      pQInfo->schedState = QUERY_SCHED_NONE;
+      (*waiter.fp)(waiter.param, waiter.qhandle);
+    }
+    tdListFree(pSched->waiting[i]);
+  }
+
+  pthread_mutex_destroy(&pSched->mutex);
+  pthread_cond_destroy(&pSched->cond);
+  tfree(pSched->batchUsers);
+  tfree(pSched->users);
+  free(pSched);
+}
+
+int32_t qGetSchedulerThreads(void) {
+  SQueryScheduler *pSched = tsQueryScheduler;
+  return (pSched == NULL) ? 0 : pSched->slots + pSched->maxBatch;
+}
+
+void qSetQueryUser(qinfo_t qinfo, const char *user) {
+  SQueryScheduler *pSched = tsQueryScheduler;
+  SQInfo          *pQInfo = (SQInfo *)qinfo;
+  if (pSched == NULL || user == NULL) return;
+
+  for (int32_t i = 0; i < pSched->numOfBatchUsers; ++i) {
+    if (strcmp(pSched->batchUsers[i], user) == 0) {
+      pQInfo->qclass = QUERY_CLASS_BATCH;
+      break;
+    }
+  }
+}
+
+// new batch queries are held back when the query buffer is about to be used up by the running ones
+static bool qQueryBufferLow(void) {
+  if (tsQueryBufferSize < 0) return false;
+  return tsQueryBufferSizeBytes < (int64_t)tsQueryBufferSize * 1048576L / 8;
+}
+
+static bool qSlotAvailable(SQueryScheduler *pSched, int8_t qclass) {
+  int32_t running = pSched->running[QUERY_CLASS_INTERACTIVE] + pSched->running[QUERY_CLASS_BATCH];
+  if (running >= pSched->slots) return false;
+  if (qclass == QUERY_CLASS_INTERACTIVE) return true;
+
+  // the preempted queries take the slots before the waiting batch queries
+  if (!isListEmpty(pSched->waiting[QUERY_CLASS_INTERACTIVE]) || pSched->preempted > 0) return false;
+  if (pSched->running[QUERY_CLASS_BATCH] >= pSched->maxBatch) return false;
+  return running == 0 || !qQueryBufferLow();
+}
+
+static void qUpdateWaitStat(SQueryClassStat *pStat, int64_t waitUs) {
+  pStat->waitUs += waitUs;
+  pStat->maxWaitUs = MAX(pStat->maxWaitUs, waitUs);
+}
+
+static void qStartSlice(SQueryScheduler *pSched, SQInfo *pQInfo) {
+  SQueryClassStat *pStat = &pSched->stat[pQInfo->qclass];
+  pQInfo->sliceTs = taosGetTimestampUs();
+  if (pQInfo->queuedTs > 0) {
+    qUpdateWaitStat(pStat, pQInfo->sliceTs - pQInfo->queuedTs);
+    pQInfo->queuedTs = 0;
+  }
+
+  pQInfo->schedState = QUERY_SCHED_RUNNING;
+  pStat->numOfSlices++;
+}
+
+// reserve the free slots for the waiting queries, the interactive ones first
+static int32_t qReserveSlots(SQueryScheduler *pSched, SQueryWaiter *pReady, int32_t size) {
+  int32_t num = 0;
+
+  for (int8_t qclass = QUERY_CLASS_INTERACTIVE; qclass < QUERY_CLASS_MAX; ++qclass) {
+    SList *pList = pSched->waiting[qclass];
+    while (num < size && !isListEmpty(pList) && qSlotAvailable(pSched, qclass)) {
+      SListNode *pNode = tdListPopHead(pList);
+      tdListNodeGetData(pList, pNode, pReady + num);
+      listNodeFree(pNode);
+
+      SQInfo *pQInfo = *pReady[num].qhandle;
+      pQInfo->schedState = QUERY_SCHED_RESERVED;
+      pSched->running[qclass]++;
+      num++;
+    }
+  }
+
+  pSched->numOfWaiting = listNEles(pSched->waiting[QUERY_CLASS_INTERACTIVE]);
+  if (pSched->preempted > 0 && pSched->numOfWaiting == 0) {
+    pthread_cond_broadcast(&pSched->cond);
+  }
+
+  return num;
+}
+
+static void qResumeWaiters(SQueryWaiter *pReady, int32_t num) {
+  for (int32_t i = 0; i < num; ++i) {
+    (*pReady[i].fp)(pReady[i].param, pReady[i].qhandle);
+  }
+}
+
+bool qAcquireExecSlot(void **qhandle, FQueryResume fp, void *param) {
+  SQueryScheduler *pSched = tsQueryScheduler;
+  SQInfo          *pQInfo = *qhandle;
+  if (pSched == NULL) return true;
+
+  pthread_mutex_lock(&pSched->mutex);
+
+  if (pQInfo->schedState == QUERY_SCHED_RESERVED) {
+    qStartSlice(pSched, pQInfo);
+    pthread_mutex_unlock(&pSched->mutex);
+    return true;
+  }
+
+  if (pQInfo->qclass == QUERY_CLASS_INTERACTIVE && pQInfo->execUs >= tsQuerySliceTime * 1000L) {
+    pQInfo->qclass = QUERY_CLASS_BATCH;
+  }
+
+  // the queries already waiting are served first
+  if (isListEmpty(pSched->waiting[pQInfo->qclass]) && qSlotAvailable(pSched, pQInfo->qclass)) {
+    pSched->running[pQInfo->qclass]++;
+    qStartSlice(pSched, pQInfo);
+    pthread_mutex_unlock(&pSched->mutex);
+    return true;
+  }
+
+  SQueryWaiter waiter = {.qhandle = qhandle, .fp = fp, .param = param};
+  if (tdListAppend(pSched->waiting[pQInfo->qclass], &waiter) != 0) {
+    // run it anyway rather than lose it
+    pSched->running[pQInfo->qclass]++;
+    qStartSlice(pSched, pQInfo);
+    pthread_mutex_unlock(&pSched->mutex);
+    return true;
+  }
+
+  pQInfo->schedState = QUERY_SCHED_WAITING;
+  pQInfo->queuedTs = taosGetTimestampUs();
+  pSched->numOfWaiting = listNEles(pSched->waiting[QUERY_CLASS_INTERACTIVE]);
+  pthread_mutex_unlock(&pSched->mutex);
+
+  qDebug("QInfo:0x%" PRIx64 " waits for a query slot, class:%d", pQInfo->qId, pQInfo->qclass);
+  return false;
+}
+
+void qReleaseExecSlot(qinfo_t qinfo) {
+  SQueryScheduler *pSched = tsQueryScheduler;
+  SQInfo          *pQInfo = (SQInfo *)qinfo;
+  if (pSched == NULL) return;
+  if (pQInfo->schedState != QUERY_SCHED_RUNNING && pQInfo->schedState != QUERY_SCHED_RESERVED) return;
+
+  SQueryWaiter ready[QUERY_CLASS_MAX * 4];
+
+  pthread_mutex_lock(&pSched->mutex);
+  pSched->running[pQInfo->qclass]--;
+  if (pQInfo->schedState == QUERY_SCHED_RUNNING) {
+    pQInfo->execUs += taosGetTimestampUs() - pQInfo->sliceTs;
+  }
+  pQInfo->schedState = QUERY_SCHED_NONE;
+  int32_t num = qReserveSlots(pSched, ready, tListLen(ready));
+  pthread_mutex_unlock(&pSched->mutex);
+
+  qResumeWaiters(ready, num);
+}
+
+// called between two data blocks, the batch query gives its slot to the waiting interactive queries
+void qYieldExecSlot(SQInfo *pQInfo) {
+  SQueryScheduler *pSched = tsQueryScheduler;
+  if (pSched == NULL || pQInfo->schedState != QUERY_SCHED_RUNNING) return;
+
+  if (pQInfo->qclass == QUERY_CLASS_INTERACTIVE) {
+    if (pQInfo->execUs + taosGetTimestampUs() - pQInfo->sliceTs < tsQuerySliceTime * 1000L) return;
+
+    // it goes on as an interactive query while the batch queries are full, and is checked again by the next block
+    pthread_mutex_lock(&pSched->mutex);
+    if (pSched->running[QUERY_CLASS_BATCH] + pSched->preempted >= pSched->maxBatch) {
+      pthread_mutex_unlock(&pSched->mutex);
+      return;
+    }
+
+    pSched->running[QUERY_CLASS_INTERACTIVE]--;
+    pSched->running[QUERY_CLASS_BATCH]++;
+    pQInfo->qclass = QUERY_CLASS_BATCH;
+    pthread_mutex_unlock(&pSched->mutex);
+    qDebug("QInfo:0x%" PRIx64 " runs longer than %dms, scheduled as batch query", pQInfo->qId, tsQuerySliceTime);
+  }
+
+  if (atomic_load_32(&pSched->numOfWaiting) == 0) return;
+
+  SQueryWaiter ready[QUERY_CLASS_MAX * 4];
+
+  // no batch query is preempted while they are more than maxBatch, as a query failing to wait is run anyway
+  pthread_mutex_lock(&pSched->mutex);
+  if (isListEmpty(pSched->waiting[QUERY_CLASS_INTERACTIVE]) ||
+      pSched->running[QUERY_CLASS_BATCH] + pSched->preempted > pSched->maxBatch) {
+    pthread_mutex_unlock(&pSched->mutex);
+    return;
+  }
+
+  int64_t st = taosGetTimestampUs();
+  pSched->running[QUERY_CLASS_BATCH]--;
+  pSched->preempted++;
+  pSched->stat[QUERY_CLASS_BATCH].numOfPreempted++;
+  pQInfo->execUs += st - pQInfo->sliceTs;
+  int32_t num = qReserveSlots(pSched, ready, tListLen(ready));
+  pthread_mutex_unlock(&pSched->mutex);
+
+  qDebug("QInfo:0x%" PRIx64 " is preempted, %d interactive queries resumed", pQInfo->qId, num);
+  qResumeWaiters(ready, num);
+
+  // a killed query goes on to be aborted at once, the commit may be waiting for it
+  pthread_mutex_lock(&pSched->mutex);
+  while ((pSched->running[QUERY_CLASS_INTERACTIVE] + pSched->running[QUERY_CLASS_BATCH] >= pSched->slots ||
+          !isListEmpty(pSched->waiting[QUERY_CLASS_INTERACTIVE])) &&
+         !isQueryKilled(pQInfo)) {
+    struct timespec ts = {0};
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += 100 * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+      ts.tv_sec += 1;
+      ts.tv_nsec -= 1000000000L;
+    }
+    pthread_cond_timedwait(&pSched->cond, &pSched->mutex, &ts);
+  }
+
+  pSched->preempted--;
+  pSched->running[QUERY_CLASS_BATCH]++;
+  pQInfo->sliceTs = taosGetTimestampUs();
+  qUpdateWaitStat(&pSched->stat[QUERY_CLASS_BATCH], pQInfo->sliceTs - st);
+  pthread_mutex_unlock(&pSched->mutex);
+
+  qDebug("QInfo:0x%" PRIx64 " continues after preempted for %" PRId64 "us", pQInfo->qId, pQInfo->sliceTs - st);
+}
+
+void qGetQueryClassStat(int32_t qclass, SQueryClassStat *pStat) {
+  SQueryScheduler *pSched = tsQueryScheduler;
+  memset(pStat, 0, sizeof(SQueryClassStat));
+  if (pSched == NULL || qclass < 0 || qclass >= QUERY_CLASS_MAX) return;
+
+  pthread_mutex_lock(&pSched->mutex);
+  *pStat = pSched->stat[qclass];
+  pStat->running = pSched->running[qclass];
+  pStat->waiting = listNEles(pSched->waiting[qclass]) + ((qclass == QUERY_CLASS_BATCH) ? pSched->preempted : 0);
+
+  // the counters are of the interval between two calls
+  memset(&pSched->stat[qclass], 0, sizeof(SQueryClassStat));
+  pthread_mutex_unlock(&pSched->mutex);
+}
@@ -65,6 +65,8 @@ void freeParam(SQueryParam *param) {
   tfree(param->pTagColumnInfo);
   tfree(param->pGroupbyExpr);
   tfree(param->prevResult);
+  taosArrayDestroy(&param->pJoinTableIdList);
+  param->pJoinTsBuf = tsBufDestroy(param->pJoinTsBuf);
 }
 
 int32_t qCreateQueryInfo(void* tsdb, int32_t vgId, SQueryTableMsg* pQueryMsg, qinfo_t* pQInfo, uint64_t qId) {
@@ -148,6 +150,11 @@ int32_t qCreateQueryInfo(void* tsdb, int32_t vgId, SQueryTableMsg* pQueryMsg, qi
         goto _over;
       }
     } else {
+      // the tables with no timestamp joined are not queried
+      if (param.pJoinTableIdList != NULL && (code = qLocalJoin(tsdb, vgId, pQueryMsg, &param, qId)) != TSDB_CODE_SUCCESS) {
+        goto _over;
+      }
+
       code = tsdbGetTableGroupFromIdList(tsdb, param.pTableIdList, &tableGroupInfo);
       if (code != TSDB_CODE_SUCCESS) {
         goto _over;
@@ -194,6 +201,14 @@ int32_t qCreateQueryInfo(void* tsdb, int32_t vgId, SQueryTableMsg* pQueryMsg, qi
   }
   param.pUdfInfo = NULL;
 
+  // keep the column condition to create the filters of the partitions, in case of the tables are scanned in parallel
+  if (tsParallelScanThreads > 1 && param.colCond != NULL) {
+    SQInfo* pInfo = (SQInfo*)(*pQInfo);
+    pInfo->colCond = param.colCond;
+    pInfo->colCondLen = pQueryMsg->colCondLen;
+    param.colCond = NULL;
+  }
+
   code = initQInfo(&pQueryMsg->tsBuf, tsdb, NULL, *pQInfo, &param, (char*)pQueryMsg, pQueryMsg->prevResultLen, NULL);
 
   _over:
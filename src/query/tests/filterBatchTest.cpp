@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <vector>
+
+#include "taos.h"
+#include "taosdef.h"
+#include "tbuffer.h"
+#include "texpr.h"
+#include "qFilter.h"
+
+#pragma GCC diagnostic ignored "-Wunused-function"
+
+namespace {
+
+const int16_t colId = 1;
+const int32_t numOfRows = 1000;
+
+tExprNode *createColNode(uint8_t type) {
+  tExprNode *pNode = (tExprNode *)calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_COL;
+  pNode->pSchema = (SSchema *)calloc(1, sizeof(SSchema));
+
+  snprintf(pNode->pSchema->name, sizeof(pNode->pSchema->name), "c%d", colId);
+  pNode->pSchema->type = type;
+  pNode->pSchema->bytes = tDataTypes[type].bytes;
+  pNode->pSchema->colId = colId;
+
+  return pNode;
+}
+
+tExprNode *createExprNode(uint8_t optr, tExprNode *pLeft, tExprNode *pRight) {
+  tExprNode *pNode = (tExprNode *)calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_EXPR;
+  pNode->_node.optr = optr;
+  pNode->_node.pLeft = pLeft;
+  pNode->_node.pRight = pRight;
+
+  return pNode;
+}
+
+// The value is given in the type the parser gives to the constants compared with a column of the type, and <> is
+// rewritten to < or > as the parser does for the numeric columns.
+tExprNode *createCompNode(uint8_t optr, uint8_t type, int64_t val) {
+  if (optr == TSDB_RELATION_NOT_EQUAL) {
+    return createExprNode(TSDB_RELATION_OR, createCompNode(TSDB_RELATION_LESS, type, val),
+                          createCompNode(TSDB_RELATION_GREATER, type, val));
+  }
+
+  tExprNode *pRight = (tExprNode *)calloc(1, sizeof(tExprNode));
+  pRight->nodeType = TSQL_NODE_VALUE;
+  pRight->pVal = (tVariant *)calloc(1, sizeof(tVariant));
+
+  if (IS_FLOAT_TYPE(type)) {
+    pRight->pVal->nType = TSDB_DATA_TYPE_DOUBLE;
+    pRight->pVal->dKey = val + 0.5;
+  } else {
+    pRight->pVal->nType = TSDB_DATA_TYPE_BIGINT;
+    pRight->pVal->i64 = val;
+  }
+
+  return createExprNode(optr, createColNode(type), pRight);
+}
+
+tExprNode *createNullNode(uint8_t optr, uint8_t type) {
+  tExprNode *pRight = (tExprNode *)calloc(1, sizeof(tExprNode));
+  pRight->nodeType = TSQL_NODE_VALUE;
+  pRight->pVal = (tVariant *)calloc(1, sizeof(tVariant));
+  pRight->pVal->nType = TSDB_DATA_TYPE_NULL;
+
+  return createExprNode(optr, createColNode(type), pRight);
+}
+
+// the values of the in operator are serialized the same way as the parser does
+tExprNode *createInNode(uint8_t type, const std::vector<int64_t> &vals) {
+  SBufferWriter bw = tbufInitWriter(NULL, false);
+  if (IS_FLOAT_TYPE(type)) {
+    tbufWriteUint32(&bw, TSDB_DATA_TYPE_DOUBLE);
+    tbufWriteInt32(&bw, (int32_t)vals.size());
+    for (int64_t v : vals) tbufWriteDouble(&bw, v + 0.5);
+  } else {
+    tbufWriteUint32(&bw, TSDB_DATA_TYPE_BIGINT);
+    tbufWriteInt32(&bw, (int32_t)vals.size());
+    for (int64_t v : vals) tbufWriteInt64(&bw, v);
+  }
+
+  tExprNode *pRight = (tExprNode *)calloc(1, sizeof(tExprNode));
+  pRight->nodeType = TSQL_NODE_VALUE;
+  pRight->pVal = (tVariant *)calloc(1, sizeof(tVariant));
+  tVariantCreateFromBinary(pRight->pVal, tbufGetData(&bw, false), tbufTell(&bw), TSDB_DATA_TYPE_BINARY);
+  tbufCloseWriter(&bw);
+
+  return createExprNode(TSDB_RELATION_IN, createColNode(type), pRight);
+}
+
+// The values around the constants compared with, the bounds of the type and about 10% of nulls. A float value is the
+// integer plus 0.5, so that it equals the constants.
+void genData(uint8_t type, char *data) {
+  int32_t bytes = tDataTypes[type].bytes;
+  srand(1);
+
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    char   *p = data + i * bytes;
+    int64_t v = rand() % 220 - 20;
+
+    if (rand() % 10 == 0) {
+      setNull(p, type, bytes);
+      continue;
+    }
+
+    switch (type) {
+      case TSDB_DATA_TYPE_TINYINT:   *(int8_t *)p = (i % 50 == 1) ? INT8_MAX : (int8_t)MIN(v, INT8_MAX); break;
+      case TSDB_DATA_TYPE_SMALLINT:  *(int16_t *)p = (i % 50 == 1) ? INT16_MAX : (int16_t)v; break;
+      case TSDB_DATA_TYPE_INT:       *(int32_t *)p = (i % 50 == 1) ? INT32_MAX : (int32_t)v; break;
+      case TSDB_DATA_TYPE_BIGINT:
+      case TSDB_DATA_TYPE_TIMESTAMP: *(int64_t *)p = (i % 50 == 1) ? INT64_MAX : v; break;
+      case TSDB_DATA_TYPE_UTINYINT:  *(uint8_t *)p = (i % 50 == 1) ? 0 : (uint8_t)MAX(v, 0); break;
+      case TSDB_DATA_TYPE_USMALLINT: *(uint16_t *)p = (i % 50 == 1) ? 0 : (uint16_t)MAX(v, 0); break;
+      case TSDB_DATA_TYPE_UINT:      *(uint32_t *)p = (i % 50 == 1) ? 0 : (uint32_t)MAX(v, 0); break;
+      case TSDB_DATA_TYPE_UBIGINT:   *(uint64_t *)p = (i % 50 == 1) ? 0 : (uint64_t)MAX(v, 0); break;
+      case TSDB_DATA_TYPE_FLOAT:     *(float *)p = (float)v + 0.5f; break;
+      case TSDB_DATA_TYPE_DOUBLE:    *(double *)p = (double)v + 0.5; break;
+      default:                       assert(0);
+    }
+  }
+}
+
+int32_t getColData(void *param, int32_t id, void **data) {
+  *data = (id == colId) ? param : NULL;
+  return TSDB_CODE_SUCCESS;
+}
+
+// the rows qualified, evaluated in batch or row by row
+std::vector<int8_t> doFilter(tExprNode *pTree, char *data, bool batch) {
+  SFilterInfo *pInfo = NULL;
+  int8_t      *p = NULL;
+
+  if (filterInitFromTree(pTree, (void **)&pInfo, 0) != TSDB_CODE_SUCCESS) {
+    ADD_FAILURE() << "failed to init the filter";
+    return std::vector<int8_t>(numOfRows, 0);
+  }
+
+  gFilterBatchExec = batch;
+  filterSetColFieldData(pInfo, data, getColData);
+
+  bool                all = filterExecute(pInfo, numOfRows, &p, NULL, 0);
+  std::vector<int8_t> res(numOfRows, 1);
+  for (int32_t i = 0; i < numOfRows && !all; ++i) {
+    res[i] = (p != NULL && p[i] != 0);
+  }
+
+  tfree(p);
+  filterFreeInfo(pInfo);
+  gFilterBatchExec = true;
+  return res;
+}
+
+// the conditions on a column of the type, a unit of each operator or combined ones
+std::vector<tExprNode *> createConds(uint8_t type) {
+  std::vector<tExprNode *> conds;
+  const int64_t            vals[] = {-1, 0, 7, 100, 127, 200};
+  const uint8_t optrs[] = {TSDB_RELATION_GREATER, TSDB_RELATION_GREATER_EQUAL, TSDB_RELATION_LESS,
+                           TSDB_RELATION_LESS_EQUAL, TSDB_RELATION_EQUAL, TSDB_RELATION_NOT_EQUAL};
+
+  for (uint8_t optr : optrs) {
+    for (int64_t v : vals) {
+      conds.push_back(createCompNode(optr, type, v));
+    }
+  }
+
+  conds.push_back(createNullNode(TSDB_RELATION_ISNULL, type));
+  conds.push_back(createNullNode(TSDB_RELATION_NOTNULL, type));
+  conds.push_back(createInNode(type, {1, 3, 5, 7, 11, 13, 17, 19}));
+  conds.push_back(createInNode(type, {0, 100, 127}));
+
+  conds.push_back(createExprNode(TSDB_RELATION_AND, createCompNode(TSDB_RELATION_GREATER, type, 10),
+                                 createCompNode(TSDB_RELATION_LESS_EQUAL, type, 100)));
+  conds.push_back(createExprNode(TSDB_RELATION_AND, createCompNode(TSDB_RELATION_GREATER_EQUAL, type, 100),
+                                 createCompNode(TSDB_RELATION_LESS, type, 10)));
+  conds.push_back(createExprNode(TSDB_RELATION_OR, createCompNode(TSDB_RELATION_LESS, type, 10),
+                                 createExprNode(TSDB_RELATION_OR, createCompNode(TSDB_RELATION_EQUAL, type, 50),
+                                                createNullNode(TSDB_RELATION_ISNULL, type))));
+  conds.push_back(createExprNode(TSDB_RELATION_AND, createCompNode(TSDB_RELATION_NOT_EQUAL, type, 7),
+                                 createNullNode(TSDB_RELATION_NOTNULL, type)));
+  return conds;
+}
+
+}  // namespace
+
+// the batch evaluation qualifies the same rows as the row by row one, for each operator on each fixed-width type
+TEST(testCase, filterBatchTest) {
+  const uint8_t types[] = {TSDB_DATA_TYPE_TINYINT,  TSDB_DATA_TYPE_SMALLINT,  TSDB_DATA_TYPE_INT,
+                           TSDB_DATA_TYPE_BIGINT,   TSDB_DATA_TYPE_TIMESTAMP, TSDB_DATA_TYPE_UTINYINT,
+                           TSDB_DATA_TYPE_USMALLINT, TSDB_DATA_TYPE_UINT,     TSDB_DATA_TYPE_UBIGINT,
+                           TSDB_DATA_TYPE_FLOAT,    TSDB_DATA_TYPE_DOUBLE};
+
+  for (uint8_t type : types) {
+    std::vector<char> data(numOfRows * tDataTypes[type].bytes);
+    genData(type, data.data());
+
+    // the trees are changed by the filters built from them
+    std::vector<tExprNode *> rowConds = createConds(type);
+    std::vector<tExprNode *> batchConds = createConds(type);
+    for (size_t c = 0; c < rowConds.size(); ++c) {
+      std::vector<int8_t> row = doFilter(rowConds[c], data.data(), false);
+      std::vector<int8_t> batch = doFilter(batchConds[c], data.data(), true);
+      tExprTreeDestroy(rowConds[c], NULL);
+      tExprTreeDestroy(batchConds[c], NULL);
+
+      for (int32_t i = 0; i < numOfRows; ++i) {
+        ASSERT_EQ(row[i], batch[i]) << "type:" << tDataTypes[type].name << " cond:" << c << " row:" << i;
+      }
+    }
+  }
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "qFilter.h"
+#include "taosdef.h"
+#include "tbuffer.h"
+#include "texpr.h"
+#include "ttype.h"
+
+/*
+ * Report the rows/sec of evaluating the where clause on the column blocks of a table, the way the query engine
+ * filters the blocks loaded from the mem table or the data files: row by row, or unit by unit in batch.
+ *
+ * usage: filterBench [rows] [rows per block]
+ */
+
+#define BENCH_COL_INT    1
+#define BENCH_COL_BIGINT 2
+#define BENCH_COL_DOUBLE 3
+
+typedef struct {
+  int32_t *iData;
+  int64_t *bData;
+  double  *dData;
+} SBenchBlock;
+
+static int32_t benchGetColData(void *param, int32_t colId, void **data) {
+  SBenchBlock *pBlock = (SBenchBlock *)param;
+
+  switch (colId) {
+    case BENCH_COL_INT:    *data = pBlock->iData; break;
+    case BENCH_COL_BIGINT: *data = pBlock->bData; break;
+    case BENCH_COL_DOUBLE: *data = pBlock->dData; break;
+    default:               *data = NULL; break;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static tExprNode *createColNode(int16_t colId, uint8_t type) {
+  tExprNode *pNode = calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_COL;
+  pNode->pSchema = calloc(1, sizeof(SSchema));
+
+  snprintf(pNode->pSchema->name, sizeof(pNode->pSchema->name), "c%d", colId);
+  pNode->pSchema->type = type;
+  pNode->pSchema->bytes = tDataTypes[type].bytes;
+  pNode->pSchema->colId = colId;
+
+  return pNode;
+}
+
+static tExprNode *createExprNode(uint8_t optr, tExprNode *pLeft, tExprNode *pRight) {
+  tExprNode *pNode = calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_EXPR;
+  pNode->_node.optr = optr;
+  pNode->_node.pLeft = pLeft;
+  pNode->_node.pRight = pRight;
+
+  return pNode;
+}
+
+static tExprNode *createCompNode(uint8_t optr, int16_t colId, uint8_t type, double val) {
+  tExprNode *pRight = calloc(1, sizeof(tExprNode));
+  pRight->nodeType = TSQL_NODE_VALUE;
+  pRight->pVal = calloc(1, sizeof(tVariant));
+
+  if (IS_FLOAT_TYPE(type)) {
+    pRight->pVal->nType = TSDB_DATA_TYPE_DOUBLE;
+    pRight->pVal->dKey = val;
+  } else {
+    pRight->pVal->nType = TSDB_DATA_TYPE_BIGINT;
+    pRight->pVal->i64 = (int64_t)val;
+  }
+
+  return createExprNode(optr, createColNode(colId, type), pRight);
+}
+
+static tExprNode *createNullNode(int16_t colId, uint8_t type) {
+  tExprNode *pRight = calloc(1, sizeof(tExprNode));
+  pRight->nodeType = TSQL_NODE_VALUE;
+  pRight->pVal = calloc(1, sizeof(tVariant));
+  pRight->pVal->nType = TSDB_DATA_TYPE_NULL;
+
+  return createExprNode(TSDB_RELATION_ISNULL, createColNode(colId, type), pRight);
+}
+
+// the values of the in operator are serialized the same way as the parser does
+static tExprNode *createInNode(int16_t colId, uint8_t type, int64_t *vals, int32_t num) {
+  SBufferWriter bw = tbufInitWriter(NULL, false);
+  tbufWriteUint32(&bw, TSDB_DATA_TYPE_BIGINT);
+  tbufWriteInt32(&bw, num);
+  for (int32_t i = 0; i < num; ++i) {
+    tbufWriteInt64(&bw, vals[i]);
+  }
+
+  tExprNode *pRight = calloc(1, sizeof(tExprNode));
+  pRight->nodeType = TSQL_NODE_VALUE;
+  pRight->pVal = calloc(1, sizeof(tVariant));
+  tVariantCreateFromBinary(pRight->pVal, tbufGetData(&bw, false), tbufTell(&bw), TSDB_DATA_TYPE_BINARY);
+  tbufCloseWriter(&bw);
+
+  return createExprNode(TSDB_RELATION_IN, createColNode(colId, type), pRight);
+}
+
+static tExprNode *createCond(int32_t idx, const char **desc) {
+  switch (idx) {
+    case 0:
+      *desc = "i > 100 and i < 5000";
+      return createExprNode(TSDB_RELATION_AND, createCompNode(TSDB_RELATION_GREATER, BENCH_COL_INT, TSDB_DATA_TYPE_INT, 100),
+                            createCompNode(TSDB_RELATION_LESS, BENCH_COL_INT, TSDB_DATA_TYPE_INT, 5000));
+    case 1: {
+      int64_t vals[] = {1, 3, 5, 7, 11, 13, 17, 19};
+      *desc = "i in (1, 3, 5, 7, 11, 13, 17, 19)";
+      return createInNode(BENCH_COL_INT, TSDB_DATA_TYPE_INT, vals, tListLen(vals));
+    }
+    case 2:
+      *desc = "d <= 0.5";
+      return createCompNode(TSDB_RELATION_LESS_EQUAL, BENCH_COL_DOUBLE, TSDB_DATA_TYPE_DOUBLE, 0.5);
+    case 3:
+      *desc = "b >= 1000 and d < 0.3";
+      return createExprNode(TSDB_RELATION_AND,
+                            createCompNode(TSDB_RELATION_GREATER_EQUAL, BENCH_COL_BIGINT, TSDB_DATA_TYPE_BIGINT, 1000),
+                            createCompNode(TSDB_RELATION_LESS, BENCH_COL_DOUBLE, TSDB_DATA_TYPE_DOUBLE, 0.3));
+    case 4:
+      *desc = "d < 0.1 or i = 7 or b is null";
+      return createExprNode(
+          TSDB_RELATION_OR, createCompNode(TSDB_RELATION_LESS, BENCH_COL_DOUBLE, TSDB_DATA_TYPE_DOUBLE, 0.1),
+          createExprNode(TSDB_RELATION_OR, createCompNode(TSDB_RELATION_EQUAL, BENCH_COL_INT, TSDB_DATA_TYPE_INT, 7),
+                         createNullNode(BENCH_COL_BIGINT, TSDB_DATA_TYPE_BIGINT)));
+    default:
+      return NULL;
+  }
+}
+
+// about 1% of the values are null
+static void genData(SBenchBlock *pBlock, int32_t rows) {
+  srand(1);
+
+  for (int32_t i = 0; i < rows; ++i) {
+    pBlock->iData[i] = rand() % 10000;
+    pBlock->bData[i] = rand() % 100000;
+    pBlock->dData[i] = rand() / (double)RAND_MAX;
+
+    if (rand() % 100 == 0) setNull((char *)&pBlock->iData[i], TSDB_DATA_TYPE_INT, 0);
+    if (rand() % 100 == 0) setNull((char *)&pBlock->bData[i], TSDB_DATA_TYPE_BIGINT, 0);
+    if (rand() % 100 == 0) setNull((char *)&pBlock->dData[i], TSDB_DATA_TYPE_DOUBLE, 0);
+  }
+}
+
+/*
+ * return the rows/sec, the number of the qualified rows is put into *qualified
+ */
+static double doBench(SFilterInfo *pInfo, SBenchBlock *pData, int32_t rows, int32_t blockRows, int64_t *qualified) {
+  int8_t *p = NULL;
+  int64_t num = 0;
+
+  int64_t st = taosGetTimestampUs();
+  for (int32_t start = 0; start < rows; start += blockRows) {
+    int32_t     numOfRows = MIN(blockRows, rows - start);
+    SBenchBlock block = {pData->iData + start, pData->bData + start, pData->dData + start};
+
+    filterSetColFieldData(pInfo, &block, benchGetColData);
+    if (filterExecute(pInfo, numOfRows, &p, NULL, 0)) {
+      num += numOfRows;
+    } else {
+      for (int32_t i = 0; i < numOfRows; ++i) {
+        num += (p[i] != 0);
+      }
+    }
+
+    tfree(p);
+  }
+  int64_t el = taosGetTimestampUs() - st;
+
+  *qualified = num;
+  return (double)rows / (el / 1000000.0);
+}
+
+int main(int argc, char *argv[]) {
+  int32_t rows = (argc > 1) ? atoi(argv[1]) : 10000000;
+  int32_t blockRows = (argc > 2) ? atoi(argv[2]) : 4096;
+
+  if (rows <= 0 || blockRows <= 0) {
+    printf("usage: %s [rows] [rows per block]\n", argv[0]);
+    return 1;
+  }
+
+  SBenchBlock data = {malloc(sizeof(int32_t) * rows), malloc(sizeof(int64_t) * rows), malloc(sizeof(double) * rows)};
+  genData(&data, rows);
+
+  printf("rows:%d, rows per block:%d\n", rows, blockRows);
+  for (int32_t c = 0;; ++c) {
+    const char *desc = NULL;
+    tExprNode  *pTree = createCond(c, &desc);
+    if (pTree == NULL) {
+      break;
+    }
+
+    SFilterInfo *pInfo = NULL;
+    if (filterInitFromTree(pTree, (void **)&pInfo, 0) != TSDB_CODE_SUCCESS) {
+      printf("failed to init filter: %s\n", desc);
+      return 1;
+    }
+
+    double  speed[2] = {0};
+    int64_t qualified[2] = {0};
+    for (int32_t m = 0; m < 2; ++m) {
+      gFilterBatchExec = (m == 1);
+
+      // take the best of several runs to reduce the noise
+      for (int32_t r = 0; r < 3; ++r) {
+        speed[m] = MAX(speed[m], doBench(pInfo, &data, rows, blockRows, &qualified[m]));
+      }
+    }
+
+    if (qualified[0] != qualified[1]) {
+      printf("result mismatch: %s, row:%" PRId64 ", batch:%" PRId64 "\n", desc, qualified[0], qualified[1]);
+      return 1;
+    }
+
+    printf("%-36s row %12.0f rows/sec, batch %12.0f rows/sec, qualified:%" PRId64 "\n", desc, speed[0], speed[1],
+           qualified[0]);
+
+    filterFreeInfo(pInfo);
+    tExprTreeDestroy(pTree, NULL);
+  }
+
+  free(data.iData);
+  free(data.bData);
+  free(data.dData);
+  return 0;
+}
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <iostream>
+
+#include "taosmsg.h"
+#include "query.h"
+#include "tsdbTestUtil.h"
+
+extern "C" {
+#include "qExecutor.h"
+#include "qTsbuf.h"
+}
+
+#pragma GCC diagnostic ignored "-Wunused-function"
+
+namespace {
+
+const char    *localJoinTestDir = "/tmp/localJoinTest";
+const uint64_t suid = 1000;
+const int32_t  numOfRows = 10000;
+
+// the tables of both sides, the i-th table of one side is joined with the i-th one of the other side
+struct SJoinTable {
+  int32_t  tid;
+  uint64_t uid;
+};
+
+const SJoinTable left[] = {{1, 1001}, {3, 1003}};
+const SJoinTable right[] = {{2, 1002}, {4, 1004}};
+
+SArray *tableIdList(const SJoinTable *pTables, int32_t numOfTables) {
+  SArray *pList = (SArray *)taosArrayInit(numOfTables, sizeof(STableIdInfo));
+  for (int32_t i = 0; i < numOfTables; ++i) {
+    STableIdInfo id = {0};
+    id.uid = pTables[i].uid;
+    id.tid = pTables[i].tid;
+    id.key = INT64_MIN;
+    taosArrayPush(pList, &id);
+  }
+  return pList;
+}
+
+// the query of one side, joined on the tag of the super table
+struct SJoinQuery {
+  SSqlExpr       expr;
+  SSqlExpr      *pExpr;
+  SColumnInfo    tagCol;
+  SQueryParam    param;
+  SQueryTableMsg msg;  // no column follows it
+
+  SJoinQuery(const SJoinTable *pTables, const SJoinTable *pJoinTables, uint64_t joinId, int32_t sides) {
+    memset(&msg, 0, sizeof(msg));
+    msg.numOfTags = 1;
+    msg.window.skey = INT64_MIN;
+    msg.window.ekey = INT64_MAX;
+
+    memset(&expr, 0, sizeof(expr));
+    expr.numOfParams = 2;
+    expr.param[1].nType = TSDB_DATA_TYPE_BIGINT;
+    expr.param[1].i64 = TSDB_TEST_NUM_OF_COLS;
+    pExpr = &expr;
+
+    tagCol = {0};
+    tagCol.colId = TSDB_TEST_NUM_OF_COLS;
+    tagCol.type = TSDB_DATA_TYPE_INT;
+    tagCol.bytes = sizeof(int32_t);
+
+    memset(&param, 0, sizeof(param));
+    param.pExpr = &pExpr;
+    param.pTagColumnInfo = &tagCol;
+    param.pTableIdList = tableIdList(pTables, 2);
+    param.pJoinTableIdList = tableIdList(pJoinTables, 2);
+    param.localJoinId = joinId;
+    param.localJoinSides = sides;
+  }
+
+  ~SJoinQuery() {
+    taosArrayDestroy(&param.pTableIdList);
+    taosArrayDestroy(&param.pJoinTableIdList);
+    tsBufDestroy(param.pJoinTsBuf);
+  }
+
+  int32_t join(STsdbRepo *pRepo) { return qLocalJoin(pRepo, 1, &msg, &param, 0); }
+
+  int64_t numOfJoined() { return (param.pJoinTsBuf == NULL) ? 0 : (int64_t)param.pJoinTsBuf->numOfTotal; }
+};
+
+class LocalJoinTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() {
+    ASSERT_EQ(tsdbTestInitEnv(localJoinTestDir), 0);
+    ASSERT_EQ(qInitLocalJoin(), 0);
+  }
+
+  static void TearDownTestCase() {
+    qCleanupLocalJoin();
+    tsdbTestCleanupEnv(localJoinTestDir);
+  }
+};
+
+// The rows of left[0] of the keys skey + 2k and of right[0] of the keys skey + 3k are joined on skey + 6k, the other
+// pair has no key in common. The rows of the first pair are committed if commit, the others are in the memory.
+STsdbRepo *openRepoWithTables(int32_t vgId, TSKEY *skey, bool commit) {
+  STsdbRepo *pRepo = tsdbTestOpenRepo(vgId);
+  if (pRepo == NULL) return NULL;
+
+  for (int32_t i = 0; i < 2; ++i) {
+    if (tsdbTestCreateChildTable(pRepo, suid, left[i].tid, left[i].uid, i) != 0 ||
+        tsdbTestCreateChildTable(pRepo, suid, right[i].tid, right[i].uid, i) != 0) {
+      tsdbTestCloseRepo(pRepo);
+      return NULL;
+    }
+  }
+
+  *skey = tsdbTestFSetKey(pRepo);
+  if (tsdbTestInsertRows(pRepo, left[0].tid, left[0].uid, *skey, 2, numOfRows) != 0 ||
+      tsdbTestInsertRows(pRepo, right[0].tid, right[0].uid, *skey, 3, numOfRows) != 0 ||
+      (commit && tsdbSyncCommit(pRepo) != 0) ||
+      tsdbTestInsertRows(pRepo, left[1].tid, left[1].uid, *skey, 1, numOfRows) != 0 ||
+      tsdbTestInsertRows(pRepo, right[1].tid, right[1].uid, *skey + numOfRows, 1, numOfRows) != 0) {
+    tsdbTestCloseRepo(pRepo);
+    return NULL;
+  }
+
+  return pRepo;
+}
+
+// the keys in common of the first pair, skey + 6k <= skey + 2 * (numOfRows - 1)
+const int64_t numOfJoined = 2 * (numOfRows - 1) / 6 + 1;
+
+}  // namespace
+
+// the timestamps joined are the ones in common, the tables with none are not queried
+TEST_F(LocalJoinTest, joinTables) {
+  TSKEY      skey = 0;
+  STsdbRepo *pRepo = openRepoWithTables(1, &skey, true);
+  ASSERT_NE(pRepo, nullptr);
+
+  SJoinQuery query(left, right, 1, 1);
+  ASSERT_EQ(query.join(pRepo), TSDB_CODE_SUCCESS);
+  ASSERT_EQ(query.numOfJoined(), numOfJoined);
+  ASSERT_EQ(taosArrayGetSize(query.param.pTableIdList), 1);
+  ASSERT_EQ(((STableIdInfo *)taosArrayGet(query.param.pTableIdList, 0))->uid, left[0].uid);
+
+  STSBuf *pTsBuf = query.param.pJoinTsBuf;
+  tsBufResetPos(pTsBuf);
+  for (int64_t i = 0; i < numOfJoined; ++i) {
+    ASSERT_TRUE(tsBufNextPos(pTsBuf));
+    STSElem elem = tsBufGetElem(pTsBuf);
+    ASSERT_EQ(elem.ts, skey + 6 * i);
+    ASSERT_EQ(elem.tag->i64, 0);
+  }
+  ASSERT_FALSE(tsBufNextPos(pTsBuf));
+
+  tsdbTestCloseRepo(pRepo);
+}
+
+// the side arriving last takes the timestamps joined by the first one, even if rows are inserted in between
+TEST_F(LocalJoinTest, otherSideCached) {
+  TSKEY      skey = 0;
+  STsdbRepo *pRepo = openRepoWithTables(2, &skey, false);
+  ASSERT_NE(pRepo, nullptr);
+
+  SJoinQuery query1(left, right, 2, 2);
+  ASSERT_EQ(query1.join(pRepo), TSDB_CODE_SUCCESS);
+  ASSERT_EQ(query1.numOfJoined(), numOfJoined);
+
+  ASSERT_EQ(tsdbTestInsertRows(pRepo, right[1].tid, right[1].uid, skey, 1, 100), 0);
+
+  SJoinQuery query2(right, left, 2, 2);
+  ASSERT_EQ(query2.join(pRepo), TSDB_CODE_SUCCESS);
+  ASSERT_EQ(query2.numOfJoined(), numOfJoined);
+  ASSERT_EQ(((STableIdInfo *)taosArrayGet(query2.param.pTableIdList, 0))->uid, right[0].uid);
+
+  // taken by both sides, the join is done again
+  SJoinQuery query3(left, right, 2, 2);
+  ASSERT_EQ(query3.join(pRepo), TSDB_CODE_SUCCESS);
+  ASSERT_EQ(query3.numOfJoined(), numOfJoined + 100);
+  ASSERT_EQ(taosArrayGetSize(query3.param.pTableIdList), 2);
+
+  tsdbTestCloseRepo(pRepo);
+}
+
+// a block failing to load fails the join, instead of joining the timestamps before it only
+TEST_F(LocalJoinTest, loadBlockError) {
+  TSKEY      skey = 0;
+  STsdbRepo *pRepo = openRepoWithTables(3, &skey, true);
+  ASSERT_NE(pRepo, nullptr);
+  ASSERT_EQ(tsdbTestCorruptData(pRepo), 0);
+
+  SJoinQuery query(left, right, 3, 1);
+  ASSERT_NE(query.join(pRepo), TSDB_CODE_SUCCESS);
+  ASSERT_EQ(query.param.pJoinTsBuf, nullptr);
+
+  tsdbTestCloseRepo(pRepo);
+}
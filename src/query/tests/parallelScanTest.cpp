@@ -0,0 +1,247 @@
+#include <gtest/gtest.h>
+#include <iostream>
+
+#include "taosmsg.h"
+#include "query.h"
+#include "tglobal.h"
+#include "tsdbTestUtil.h"
+
+extern "C" {
+#include "qExecutor.h"
+}
+
+#pragma GCC diagnostic ignored "-Wunused-function"
+
+namespace {
+
+const char    *parallelScanTestDir = "/tmp/parallelScanTest";
+const uint64_t suid = 2000;
+const int32_t  numOfTables = 400;
+const int32_t  numOfRows = 100;
+
+// the count(ts) and sum(c1) of the child tables of the super table
+struct SScanResult {
+  int32_t rows;
+  int64_t count;
+  int64_t sum;
+};
+
+SSqlExpr newExpr(int16_t functionId, int16_t colId, int16_t type) {
+  SSqlExpr expr;
+  memset(&expr, 0, sizeof(expr));
+  expr.functionId = functionId;
+  expr.colInfo.colId = colId;
+  expr.colInfo.colIndex = colId;
+  expr.colInfo.flag = TSDB_COL_NORMAL;
+  expr.colType = type;
+  expr.colBytes = tDataTypes[type].bytes;
+  return expr;
+}
+
+// Run select count(ts), sum(c1) from the super table as the vnode does, and merge the partial rows of the result as
+// the client does
+int32_t scanTables(STsdbRepo *pRepo, SScanResult *pResult, int32_t *operatorType) {
+  size_t          size = sizeof(SQueryTableMsg) + sizeof(SColumnInfo) * TSDB_TEST_NUM_OF_COLS;
+  SQueryTableMsg *pMsg = (SQueryTableMsg *)calloc(1, size);
+
+  pMsg->stableQuery = true;
+  pMsg->simpleAgg = true;
+  pMsg->window.skey = INT64_MIN;
+  pMsg->window.ekey = INT64_MAX;
+  pMsg->numOfTables = numOfTables;
+  pMsg->order = TSDB_ORDER_ASC;
+  pMsg->numOfCols = TSDB_TEST_NUM_OF_COLS;
+  pMsg->limit = -1;
+  pMsg->queryType = TSDB_QUERY_TYPE_STABLE_QUERY | TSDB_QUERY_TYPE_MULTITABLE_QUERY;
+  pMsg->numOfOutput = 2;
+  for (int16_t i = 0; i < TSDB_TEST_NUM_OF_COLS; ++i) {
+    int16_t type = (i == 0) ? TSDB_DATA_TYPE_TIMESTAMP : TSDB_DATA_TYPE_INT;
+    pMsg->tableCols[i].colId = i;
+    pMsg->tableCols[i].type = type;
+    pMsg->tableCols[i].bytes = tDataTypes[type].bytes;
+  }
+
+  SSqlExpr  exprs[2] = {newExpr(TSDB_FUNC_COUNT, 0, TSDB_DATA_TYPE_TIMESTAMP), newExpr(TSDB_FUNC_SUM, 1, TSDB_DATA_TYPE_INT)};
+  SSqlExpr *pExprs[2] = {&exprs[0], &exprs[1]};
+
+  SQueriedTableInfo info = {0, TSDB_TEST_NUM_OF_COLS, pMsg->tableCols};
+  SExprInfo        *pExprInfo = NULL;
+  int32_t code = createQueryFunc(&info, 2, &pExprInfo, pExprs, NULL, pMsg->queryType, pMsg, NULL);
+  if (code != TSDB_CODE_SUCCESS) {
+    free(pMsg);
+    return code;
+  }
+
+  SArray *pTableIdList = (SArray *)taosArrayInit(numOfTables, sizeof(STableIdInfo));
+  for (int32_t i = 0; i < numOfTables; ++i) {
+    STableIdInfo id = {suid + 1 + i, i + 1, INT64_MIN};
+    taosArrayPush(pTableIdList, &id);
+  }
+
+  STableGroupInfo tableGroupInfo = {0};
+  code = tsdbGetTableGroupFromIdList(pRepo, pTableIdList, &tableGroupInfo);
+  taosArrayDestroy(&pTableIdList);
+  if (code != TSDB_CODE_SUCCESS) {
+    free(pExprInfo);
+    free(pMsg);
+    return code;
+  }
+
+  SQInfo *pQInfo = createQInfoImpl(pMsg, NULL, pExprInfo, NULL, &tableGroupInfo, NULL, NULL, 1, NULL, 1, NULL);
+  if (pQInfo == NULL) {
+    free(pMsg);
+    return TSDB_CODE_QRY_OUT_OF_MEMORY;
+  }
+
+  SQueryParam param;
+  memset(&param, 0, sizeof(param));
+  int32_t op = OP_MultiTableAggregate;
+  param.tableScanOperator = OP_TableScan;
+  param.pOperator = (SArray *)taosArrayInit(1, sizeof(int32_t));
+  taosArrayPush(param.pOperator, &op);
+
+  code = initQInfo(&pMsg->tsBuf, pRepo, NULL, pQInfo, &param, (char *)pMsg, 0, NULL);
+  taosArrayDestroy(&param.pOperator);
+  free(pMsg);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  uint64_t qId = 0;
+  qTableQuery(pQInfo, &qId);
+  *operatorType = pQInfo->runtimeEnv.proot->operatorType;
+
+  memset(pResult, 0, sizeof(SScanResult));
+  SSDataBlock *pBlock = pQInfo->runtimeEnv.outputBuf;
+  code = pQInfo->code;
+  for (int32_t i = 0; code == TSDB_CODE_SUCCESS && pBlock != NULL && i < pBlock->info.rows; ++i) {
+    SColumnInfoData *pCount = (SColumnInfoData *)taosArrayGet(pBlock->pDataBlock, 0);
+    SColumnInfoData *pSum = (SColumnInfoData *)taosArrayGet(pBlock->pDataBlock, 1);
+
+    // the partial sum of a vnode, of which the integer sum comes first
+    pResult->count += ((int64_t *)pCount->pData)[i];
+    pResult->sum += *(int64_t *)(pSum->pData + i * pSum->info.bytes);
+    pResult->rows++;
+  }
+
+  qDestroyQueryInfo(pQInfo);
+  return code;
+}
+
+// The rows of the even tables are committed, the ones of the odd tables are in the memory
+STsdbRepo *openRepoWithTables(int32_t vgId, SScanResult *pExpected) {
+  STsdbRepo *pRepo = tsdbTestOpenRepo(vgId);
+  if (pRepo == NULL) return NULL;
+
+  TSKEY skey = tsdbTestFSetKey(pRepo);
+  memset(pExpected, 0, sizeof(SScanResult));
+
+  for (int32_t pass = 0; pass < 2; ++pass) {
+    for (int32_t i = pass; i < numOfTables; i += 2) {
+      if ((pass == 0 && tsdbTestCreateChildTable(pRepo, suid, i + 1, suid + 1 + i, i) != 0) ||
+          tsdbTestInsertRows(pRepo, i + 1, suid + 1 + i, skey + i, 1, numOfRows) != 0) {
+        tsdbTestCloseRepo(pRepo);
+        return NULL;
+      }
+
+      for (int32_t j = 0; j < numOfRows; ++j) {
+        pExpected->sum += tsdbTestColVal(skey + i + j, 1);
+      }
+      pExpected->count += numOfRows;
+    }
+
+    if (pass == 0 && tsdbSyncCommit(pRepo) != 0) {
+      tsdbTestCloseRepo(pRepo);
+      return NULL;
+    }
+
+    // the odd tables are created after the commit
+    if (pass == 0) {
+      for (int32_t i = 1; i < numOfTables; i += 2) {
+        if (tsdbTestCreateChildTable(pRepo, suid, i + 1, suid + 1 + i, i) != 0) {
+          tsdbTestCloseRepo(pRepo);
+          return NULL;
+        }
+      }
+    }
+  }
+
+  return pRepo;
+}
+
+class ParallelScanTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() { ASSERT_EQ(tsdbTestInitEnv(parallelScanTestDir), 0); }
+
+  static void TearDownTestCase() { tsdbTestCleanupEnv(parallelScanTestDir); }
+
+  void TearDown() override {
+    qCleanupParallelScan();
+    tsParallelScanThreads = 0;
+  }
+};
+
+}  // namespace
+
+// the partitions scanned in parallel return the rows of the serial scan, the ones in the memory included
+TEST_F(ParallelScanTest, sameAsSerial) {
+  SScanResult expected;
+  STsdbRepo  *pRepo = openRepoWithTables(1, &expected);
+  ASSERT_NE(pRepo, nullptr);
+
+  SScanResult serial, parallel;
+  int32_t     operatorType = 0;
+  ASSERT_EQ(scanTables(pRepo, &serial, &operatorType), TSDB_CODE_SUCCESS);
+  ASSERT_EQ(operatorType, OP_MultiTableAggregate);
+  ASSERT_EQ(serial.rows, 1);
+  ASSERT_EQ(serial.count, expected.count);
+  ASSERT_EQ(serial.sum, expected.sum);
+
+  tsParallelScanThreads = 4;
+  ASSERT_EQ(qInitParallelScan(), 0);
+  ASSERT_EQ(scanTables(pRepo, &parallel, &operatorType), TSDB_CODE_SUCCESS);
+  ASSERT_EQ(operatorType, OP_ParallelAggregate);
+  ASSERT_EQ(parallel.rows, 4);
+  ASSERT_EQ(parallel.count, serial.count);
+  ASSERT_EQ(parallel.sum, serial.sum);
+
+  tsdbTestCloseRepo(pRepo);
+}
+
+// the queries scanning in parallel at the same time share the threads of the pool, none of them waits for a thread
+TEST_F(ParallelScanTest, sharedPool) {
+  SScanResult expected;
+  STsdbRepo  *pRepo = openRepoWithTables(2, &expected);
+  ASSERT_NE(pRepo, nullptr);
+
+  tsParallelScanThreads = 2;
+  ASSERT_EQ(qInitParallelScan(), 0);
+
+  const int32_t numOfQueries = 8;
+  struct SQueryThread {
+    STsdbRepo  *pRepo;
+    SScanResult result;
+    int32_t     code;
+    int32_t     operatorType;
+  } queries[numOfQueries];
+  pthread_t threads[numOfQueries];
+
+  for (int32_t i = 0; i < numOfQueries; ++i) {
+    queries[i].pRepo = pRepo;
+    pthread_create(&threads[i], NULL, [](void *param) -> void * {
+      SQueryThread *pQuery = (SQueryThread *)param;
+      pQuery->code = scanTables(pQuery->pRepo, &pQuery->result, &pQuery->operatorType);
+      return NULL;
+    }, &queries[i]);
+  }
+
+  for (int32_t i = 0; i < numOfQueries; ++i) {
+    pthread_join(threads[i], NULL);
+    ASSERT_EQ(queries[i].code, TSDB_CODE_SUCCESS);
+    ASSERT_EQ(queries[i].operatorType, OP_ParallelAggregate);
+    ASSERT_EQ(queries[i].result.count, expected.count);
+    ASSERT_EQ(queries[i].result.sum, expected.sum);
+  }
+
+  tsdbTestCloseRepo(pRepo);
+}
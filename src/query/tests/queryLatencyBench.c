@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "taos.h"
+
+/*
+ * Report the latency of small queries against a running server, where setting up and tearing down the runtime state
+ * of the query is a large part of the work: a projection, an aggregation, an interval and a group by query on a
+ * super table of a few tables. Run it with queryArena 1 and 0 in the cfg of the server to compare the arena with
+ * malloc'ing the pieces one by one.
+ *
+ * usage: queryLatencyBench [host] [port] [times] [tables]
+ */
+
+#define BENCH_DB    "qlbench"
+#define BENCH_ROWS  100
+
+static const char *benchSql[] = {
+    "select * from " BENCH_DB ".t0 limit 10",
+    "select count(*), avg(v), max(v) from " BENCH_DB ".st",
+    "select count(*), last(v) from " BENCH_DB ".st interval(10s)",
+    "select count(*), avg(v) from " BENCH_DB ".st group by g",
+};
+
+static int32_t benchExec(TAOS *taos, const char *sql) {
+  TAOS_RES *pRes = taos_query(taos, sql);
+  int32_t   code = taos_errno(pRes);
+  if (code != 0) {
+    printf("failed to run '%s', reason:%s\n", sql, taos_errstr(pRes));
+  } else {
+    while (taos_fetch_row(pRes) != NULL) {
+    }
+  }
+
+  taos_free_result(pRes);
+  return code;
+}
+
+static int32_t benchPrepare(TAOS *taos, int32_t numOfTables) {
+  char sql[256];
+
+  if (benchExec(taos, "drop database if exists " BENCH_DB) != 0 || benchExec(taos, "create database " BENCH_DB) != 0 ||
+      benchExec(taos, "create table " BENCH_DB ".st (ts timestamp, v int) tags (g int)") != 0) {
+    return -1;
+  }
+
+  int64_t ts = 1600000000000;
+  for (int32_t i = 0; i < numOfTables; ++i) {
+    snprintf(sql, tListLen(sql), "create table " BENCH_DB ".t%d using " BENCH_DB ".st tags (%d)", i, i % 4);
+    if (benchExec(taos, sql) != 0) {
+      return -1;
+    }
+
+    for (int32_t j = 0; j < BENCH_ROWS; ++j) {
+      snprintf(sql, tListLen(sql), "insert into " BENCH_DB ".t%d values (%" PRId64 ", %d)", i, ts + j * 1000, j);
+      if (benchExec(taos, sql) != 0) {
+        return -1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+static int benchCompare(const void *a, const void *b) {
+  int64_t x = *(const int64_t *)a;
+  int64_t y = *(const int64_t *)b;
+  return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+static int32_t doBench(TAOS *taos, const char *sql, int32_t times) {
+  int64_t *elapsed = calloc(times, sizeof(int64_t));
+  int64_t  total = 0;
+
+  // warm up the meta cache of the client and the vnodes
+  if (benchExec(taos, sql) != 0) {
+    free(elapsed);
+    return -1;
+  }
+
+  for (int32_t i = 0; i < times; ++i) {
+    int64_t st = taosGetTimestampUs();
+    if (benchExec(taos, sql) != 0) {
+      free(elapsed);
+      return -1;
+    }
+
+    elapsed[i] = taosGetTimestampUs() - st;
+    total += elapsed[i];
+  }
+
+  qsort(elapsed, times, sizeof(int64_t), benchCompare);
+  printf("avg:%8.1fus p50:%6" PRId64 "us p99:%6" PRId64 "us  %s\n", (double)total / times, elapsed[times / 2],
+         elapsed[(int32_t)(times * 0.99)], sql);
+
+  free(elapsed);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  const char *host = (argc > 1) ? argv[1] : NULL;
+  uint16_t    port = (argc > 2) ? (uint16_t)atoi(argv[2]) : 0;
+  int32_t     times = (argc > 3) ? atoi(argv[3]) : 2000;
+  int32_t     numOfTables = (argc > 4) ? atoi(argv[4]) : 8;
+
+  if (times <= 0 || numOfTables <= 0) {
+    printf("usage: %s [host] [port] [times] [tables]\n", argv[0]);
+    return 1;
+  }
+
+  TAOS *taos = taos_connect(host, "root", "taosdata", NULL, port);
+  if (taos == NULL) {
+    printf("failed to connect to server, reason:%s\n", taos_errstr(NULL));
+    return 1;
+  }
+
+  int32_t code = benchPrepare(taos, numOfTables);
+  for (int32_t i = 0; code == 0 && i < tListLen(benchSql); ++i) {
+    code = doBench(taos, benchSql[i], times);
+  }
+
+  benchExec(taos, "drop database if exists " BENCH_DB);
+  taos_close(taos);
+  taos_cleanup();
+  return (code == 0) ? 0 : 1;
+}
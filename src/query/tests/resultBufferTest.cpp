@@ -152,6 +152,67 @@ void recyclePageTest() {
 
   destroyResultBuf(pResultBuf);
 }
+
+void columnCompressTest() {
+  SDiskbasedResultBuf* pResultBuf = NULL;
+  int32_t ret = createDiskbasedResultBuffer(&pResultBuf, 4096, 4096, 1);
+
+  SPageColInfo cols[] = {
+      {TSDB_DATA_TYPE_INT, 0, 4},        {TSDB_DATA_TYPE_TIMESTAMP, 4, 8}, {TSDB_DATA_TYPE_DOUBLE, 12, 8},
+      {TSDB_DATA_TYPE_BINARY, 20, 10},   {TSDB_DATA_TYPE_BIGINT, 32, 8},
+  };
+
+  const int32_t rowSize = 44;
+  ASSERT_EQ(setResultBufPageLayout(pResultBuf, rowSize, cols, 5), TSDB_CODE_SUCCESS);
+
+  // overlapped columns are not accepted
+  SPageColInfo invalid[] = {{TSDB_DATA_TYPE_INT, 0, 8}, {TSDB_DATA_TYPE_INT, 4, 4}};
+  ASSERT_NE(setResultBufPageLayout(pResultBuf, rowSize, invalid, 2), TSDB_CODE_SUCCESS);
+
+  int32_t pageId = 0;
+  int32_t groupId = 0;
+  // the bytes in use may end in a row partly, up to the end of the page
+  int32_t rows[] = {80, 33, 1, 92};
+  int32_t extra[] = {0, 5, 0, 4096 - (int32_t)sizeof(tFilePage) - 92 * rowSize};
+  int32_t pageIds[4] = {0};
+  char    expect[4][4096] = {{0}};
+
+  for (int32_t i = 0; i < 4; ++i) {
+    tFilePage* pBufPage = getNewDataBuf(pResultBuf, groupId, &pageId);
+    ASSERT_TRUE(pBufPage != NULL);
+
+    for (int32_t j = 0; j < rows[i]; ++j) {
+      char* p = pBufPage->data + j * rowSize;
+      *(int32_t*)p = j * 3;
+      *(int64_t*)(p + 4) = 1600000000000L + j * 1000;
+      *(double*)(p + 12) = j * 0.25;
+      snprintf(p + 20, 10, "str%d", j % 7);
+      *(int64_t*)(p + 32) = -j;
+      *(int32_t*)(p + 40) = 0x5a5a;
+    }
+
+    memset(pBufPage->data + rows[i] * rowSize, 0x3c, extra[i]);
+    pBufPage->num = rows[i] * rowSize + extra[i];
+    memcpy(expect[i], pBufPage, 4096);
+
+    pageIds[i] = pageId;
+    releaseResBufPage(pResultBuf, pBufPage);
+  }
+
+  // the first pages have been flushed to disk, and loaded again
+  for (int32_t i = 0; i < 4; ++i) {
+    tFilePage* t = getResBufPage(pResultBuf, pageIds[i]);
+    ASSERT_TRUE(t != NULL);
+    ASSERT_EQ(memcmp(t, expect[i], 4096), 0);
+    releaseResBufPage(pResultBuf, t);
+  }
+
+  ASSERT_GT(pResultBuf->statis.colCompPages, 0);
+  ASSERT_GT(pResultBuf->statis.loadPages, 0);
+  ASSERT_LT(pResultBuf->statis.flushBytes, pResultBuf->statis.flushPages * 4096);
+
+  destroyResultBuf(pResultBuf);
+}
 } // namespace
 
 
@@ -160,4 +221,5 @@ TEST(testCase, resultBufferTest) {
   simpleTest();
   writeDownTest();
   recyclePageTest();
+  columnCompressTest();
 }
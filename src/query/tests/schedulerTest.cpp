@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <vector>
+
+#include "taosmsg.h"
+#include "tglobal.h"
+
+extern "C" {
+#include "qExecutor.h"
+}
+
+#pragma GCC diagnostic ignored "-Wunused-function"
+
+namespace {
+
+// the queries resumed by the scheduler, in order
+std::vector<void **> resumed;
+
+void resumeQuery(void *param, void **qhandle) { resumed.push_back(qhandle); }
+
+struct SSchedQuery {
+  SQInfo *pQInfo;
+  void   *qhandle;
+};
+
+SSchedQuery *newQuery(int64_t qId, int8_t qclass) {
+  SSchedQuery *pQuery = (SSchedQuery *)calloc(1, sizeof(SSchedQuery));
+  pQuery->pQInfo = (SQInfo *)calloc(1, sizeof(SQInfo));
+  pQuery->pQInfo->qId = qId;
+  pQuery->pQInfo->qclass = qclass;
+  pQuery->qhandle = pQuery->pQInfo;
+  return pQuery;
+}
+
+void freeQuery(SSchedQuery *pQuery) {
+  free(pQuery->pQInfo);
+  free(pQuery);
+}
+
+bool acquire(SSchedQuery *pQuery) { return qAcquireExecSlot(&pQuery->qhandle, resumeQuery, NULL); }
+
+// the query has run longer than the slice time
+void runLong(SSchedQuery *pQuery) { pQuery->pQInfo->execUs = tsQuerySliceTime * 1000L; }
+
+int32_t running(int32_t qclass) {
+  SQueryClassStat stat;
+  qGetQueryClassStat(qclass, &stat);
+  return stat.running;
+}
+
+int32_t waiting(int32_t qclass) {
+  SQueryClassStat stat;
+  qGetQueryClassStat(qclass, &stat);
+  return stat.waiting;
+}
+
+void *yieldFp(void *param) {
+  qYieldExecSlot((SQInfo *)param);
+  return NULL;
+}
+
+class SchedulerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    tsQuerySliceTime = 10;
+    tsMaxBatchQueries = 1;
+    tsBatchQueryUsers[0] = 0;
+    resumed.clear();
+    ASSERT_EQ(qInitScheduler(2), 0);
+    ASSERT_EQ(qGetSchedulerThreads(), 3);
+  }
+
+  void TearDown() override { qCleanupScheduler(); }
+};
+
+}  // namespace
+
+// the interactive queries running long are not scheduled as batch ones beyond maxBatch
+TEST_F(SchedulerTest, reclassifyWithinMaxBatch) {
+  SSchedQuery *q1 = newQuery(1, QUERY_CLASS_INTERACTIVE);
+  SSchedQuery *q2 = newQuery(2, QUERY_CLASS_INTERACTIVE);
+  ASSERT_TRUE(acquire(q1));
+  ASSERT_TRUE(acquire(q2));
+
+  runLong(q1);
+  runLong(q2);
+  qYieldExecSlot(q1->pQInfo);
+  qYieldExecSlot(q2->pQInfo);
+  ASSERT_EQ(q1->pQInfo->qclass, QUERY_CLASS_BATCH);
+  ASSERT_EQ(q2->pQInfo->qclass, QUERY_CLASS_INTERACTIVE);
+  ASSERT_EQ(running(QUERY_CLASS_BATCH), 1);
+  ASSERT_EQ(running(QUERY_CLASS_INTERACTIVE), 1);
+
+  // it is a batch query once the batch one is done
+  qReleaseExecSlot(q1->pQInfo);
+  qYieldExecSlot(q2->pQInfo);
+  ASSERT_EQ(q2->pQInfo->qclass, QUERY_CLASS_BATCH);
+  ASSERT_EQ(running(QUERY_CLASS_BATCH), 1);
+  ASSERT_EQ(running(QUERY_CLASS_INTERACTIVE), 0);
+
+  qReleaseExecSlot(q2->pQInfo);
+  ASSERT_EQ(running(QUERY_CLASS_BATCH), 0);
+  freeQuery(q1);
+  freeQuery(q2);
+}
+
+// a batch query gives its slot to a waiting interactive query, and goes on once the slot is free again
+TEST_F(SchedulerTest, preemptBatch) {
+  SSchedQuery *q1 = newQuery(1, QUERY_CLASS_BATCH);
+  SSchedQuery *q2 = newQuery(2, QUERY_CLASS_INTERACTIVE);
+  SSchedQuery *q3 = newQuery(3, QUERY_CLASS_INTERACTIVE);
+  ASSERT_TRUE(acquire(q1));
+  ASSERT_TRUE(acquire(q2));
+  ASSERT_FALSE(acquire(q3));
+  ASSERT_EQ(waiting(QUERY_CLASS_INTERACTIVE), 1);
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, yieldFp, q1->pQInfo);
+  while (resumed.size() < 1) taosMsleep(1);
+  ASSERT_EQ(resumed[0], &q3->qhandle);
+  ASSERT_EQ(waiting(QUERY_CLASS_BATCH), 1);
+
+  // the slot is reserved for it
+  ASSERT_TRUE(acquire(q3));
+  qReleaseExecSlot(q3->pQInfo);
+  pthread_join(thread, NULL);
+  ASSERT_EQ(running(QUERY_CLASS_BATCH), 1);
+  ASSERT_EQ(waiting(QUERY_CLASS_BATCH), 0);
+
+  qReleaseExecSlot(q1->pQInfo);
+  qReleaseExecSlot(q2->pQInfo);
+  freeQuery(q1);
+  freeQuery(q2);
+  freeQuery(q3);
+}
+
+// a query running long is not preempted while the preempted ones are maxBatch, they would hold all the threads left
+// by the queries running, and the query the slot is reserved for would find no thread
+TEST_F(SchedulerTest, noPreemptBeyondMaxBatch) {
+  SSchedQuery *q1 = newQuery(1, QUERY_CLASS_BATCH);
+  SSchedQuery *q2 = newQuery(2, QUERY_CLASS_INTERACTIVE);
+  SSchedQuery *q3 = newQuery(3, QUERY_CLASS_INTERACTIVE);
+  SSchedQuery *q4 = newQuery(4, QUERY_CLASS_INTERACTIVE);
+  ASSERT_TRUE(acquire(q1));
+  ASSERT_TRUE(acquire(q2));
+  ASSERT_FALSE(acquire(q3));
+
+  pthread_t thread1;
+  pthread_create(&thread1, NULL, yieldFp, q1->pQInfo);
+  while (resumed.size() < 1) taosMsleep(1);
+  ASSERT_EQ(waiting(QUERY_CLASS_BATCH), 1);
+
+  // another interactive query waits, the one running long goes on in its thread
+  ASSERT_FALSE(acquire(q4));
+  runLong(q2);
+  qYieldExecSlot(q2->pQInfo);
+  ASSERT_EQ(q2->pQInfo->qclass, QUERY_CLASS_INTERACTIVE);
+  ASSERT_EQ(waiting(QUERY_CLASS_BATCH), 1);
+
+  ASSERT_TRUE(acquire(q3));
+  qReleaseExecSlot(q2->pQInfo);
+  ASSERT_EQ(resumed.size(), 2);
+  ASSERT_TRUE(acquire(q4));
+  qReleaseExecSlot(q3->pQInfo);
+  qReleaseExecSlot(q4->pQInfo);
+  pthread_join(thread1, NULL);
+  qReleaseExecSlot(q1->pQInfo);
+
+  ASSERT_EQ(running(QUERY_CLASS_BATCH), 0);
+  ASSERT_EQ(running(QUERY_CLASS_INTERACTIVE), 0);
+  freeQuery(q1);
+  freeQuery(q2);
+  freeQuery(q3);
+  freeQuery(q4);
+}
+
+// the waiting queries are resumed by the cleanup, so that they are released
+TEST_F(SchedulerTest, cleanupWaiting) {
+  SSchedQuery *q1 = newQuery(1, QUERY_CLASS_INTERACTIVE);
+  SSchedQuery *q2 = newQuery(2, QUERY_CLASS_INTERACTIVE);
+  SSchedQuery *q3 = newQuery(3, QUERY_CLASS_INTERACTIVE);
+  SSchedQuery *q4 = newQuery(4, QUERY_CLASS_BATCH);
+  ASSERT_TRUE(acquire(q1));
+  ASSERT_TRUE(acquire(q2));
+  ASSERT_FALSE(acquire(q3));
+  ASSERT_FALSE(acquire(q4));
+
+  qCleanupScheduler();
+  ASSERT_EQ(resumed.size(), 2);
+  ASSERT_EQ(resumed[0], &q3->qhandle);
+  ASSERT_EQ(resumed[1], &q4->qhandle);
+
+  ASSERT_EQ(qInitScheduler(2), 0);
+  freeQuery(q1);
+  freeQuery(q2);
+  freeQuery(q3);
+  freeQuery(q4);
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_RPC_COMP_H
+#define TDENGINE_RPC_COMP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The codec is one of RPC_COMP_LZ4 and RPC_COMP_ZSTD, zstd is supported only if built with TSZ
+bool    rpcCompSupported(int8_t codec);
+int32_t rpcCompBound(int8_t codec, int32_t len);
+
+// Return the length of the output, or -1 if the codec is not supported or the output does not fit in dst
+int32_t rpcCompress(int8_t codec, int32_t level, const char *src, int32_t srcLen, char *dst, int32_t dstLen);
+int32_t rpcDecompress(int8_t codec, const char *src, int32_t srcLen, char *dst, int32_t dstLen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_RPC_COMP_H
@@ -22,6 +22,14 @@ extern "C" {
 
 #define RPC_CONN_TCP    2
 
+// compression algorithm of the message content, kept in comp of the head
+#define RPC_COMP_NONE   0
+#define RPC_COMP_LZ4    1
+#define RPC_COMP_ZSTD   2
+
+// kept in resflag of the head, the sender is able to decompress the content compressed by zstd
+#define RPC_FLAG_ZSTD   1
+
 extern int tsRpcOverhead;
 
 typedef struct {
@@ -39,8 +47,8 @@ typedef struct {
 
 typedef struct {
   char     version:4; // RPC version
-  char     comp:4;    // compression algorithm, 0:no compression 1:lz4
-  char     resflag:2; // reserved bits
+  char     comp:4;    // compression algorithm, 0:no compression 1:lz4 2:zstd
+  char     resflag:2; // RPC_FLAG_ZSTD, the other bits are reserved
   char     spi:3;     // security parameter index
   char     encrypt:3; // encrypt algorithm, 0: no encryption
   uint16_t tranId;    // transcation ID
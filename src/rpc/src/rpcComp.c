@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "lz4.h"
+#ifdef TD_TSZ
+#include "zstd.h"
+#endif
+#include "rpcHead.h"
+#include "rpcComp.h"
+
+bool rpcCompSupported(int8_t codec) {
+  if (codec == RPC_COMP_LZ4) return true;
+#ifdef TD_TSZ
+  if (codec == RPC_COMP_ZSTD) return true;
+#endif
+  return false;
+}
+
+int32_t rpcCompBound(int8_t codec, int32_t len) {
+#ifdef TD_TSZ
+  if (codec == RPC_COMP_ZSTD) return (int32_t)ZSTD_compressBound(len);
+#endif
+  return LZ4_compressBound(len);
+}
+
+int32_t rpcCompress(int8_t codec, int32_t level, const char *src, int32_t srcLen, char *dst, int32_t dstLen) {
+  if (srcLen <= 0 || dstLen <= 0) return -1;
+
+  if (codec == RPC_COMP_LZ4) {
+    int32_t len = LZ4_compress_default(src, dst, srcLen, dstLen);
+    return (len <= 0) ? -1 : len;
+  }
+
+#ifdef TD_TSZ
+  if (codec == RPC_COMP_ZSTD) {
+    size_t len = ZSTD_compress(dst, dstLen, src, srcLen, level);
+    return ZSTD_isError(len) ? -1 : (int32_t)len;
+  }
+#endif
+
+  return -1;
+}
+
+int32_t rpcDecompress(int8_t codec, const char *src, int32_t srcLen, char *dst, int32_t dstLen) {
+  if (srcLen <= 0 || dstLen <= 0) return -1;
+
+  if (codec == RPC_COMP_LZ4) {
+    int32_t len = LZ4_decompress_safe(src, dst, srcLen, dstLen);
+    return (len < 0) ? -1 : len;
+  }
+
+#ifdef TD_TSZ
+  if (codec == RPC_COMP_ZSTD) {
+    size_t len = ZSTD_decompress(dst, dstLen, src, srcLen);
+    return ZSTD_isError(len) ? -1 : (int32_t)len;
+  }
+#endif
+
+  return -1;
+}
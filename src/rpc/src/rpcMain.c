@@ -19,7 +19,6 @@
 #include "tmempool.h"
 #include "ttimer.h"
 #include "tutil.h"
-#include "lz4.h"
 #include "tref.h"
 #include "taoserror.h"
 #include "tsocket.h"
@@ -32,6 +31,7 @@
 #include "rpcCache.h"
 #include "rpcTcp.h"
 #include "rpcHead.h"
+#include "rpcComp.h"
 
 #define RPC_MSG_OVERHEAD (sizeof(SRpcReqContext) + sizeof(SRpcHead) + sizeof(SRpcDigest)) 
 #define rpcHeadFromCont(cont) ((SRpcHead *) ((char*)cont - sizeof(SRpcHead)))
@@ -40,6 +40,10 @@
 #define rpcContLenFromMsg(msgLen) (msgLen - sizeof(SRpcHead))
 #define rpcIsReq(type) (type & 1U)
 
+// the connection table is split into shards, each with its own ID pool and hash, so the threads rarely contend
+#define RPC_CONN_SHARDS          8
+#define RPC_MIN_SESSIONS_PER_SHARD 64
+
 typedef struct {
   int      sessions;     // number of sessions allowed
   int      numOfThreads; // number of threads to process incoming messages
@@ -59,9 +63,11 @@ typedef struct {
   int    (*afp)(char *user, char *spi, char *encrypt, char *secret, char *ckey); 
 
   int32_t   refCount;
-  void     *idPool;   // handle to ID pool
+  int       numOfShards;  // number of shards of the connection table
+  int       shardSize;    // number of sessions of each shard, the last one takes the rest
+  void     *idPool[RPC_CONN_SHARDS];  // handle to ID pool
   void     *tmrCtrl;  // handle to timer
-  SHashObj *hash;     // handle returned by hash utility
+  SHashObj *hash[RPC_CONN_SHARDS];    // handle returned by hash utility
   void     *tcphandle;// returned handle from TCP initialization
   void     *udphandle;// returned handle from UDP initialization
   void     *pCache;   // connection cache
@@ -124,6 +130,12 @@ typedef struct SRpcConn {
   int8_t    connType;   // connection type
   int64_t   lockedBy;   // lock for connection
   SRpcReqContext *pContext; // request context
+  int8_t    peerFlag;   // resflag of the last msg from peer, the codecs it is able to decompress
+  int64_t   compBytes;  // bytes of the msgs compressed, before compression
+  int64_t   compLen;    // bytes of the msgs compressed, after compression
+  int64_t   compUs;     // time spent on compression
+  int64_t   decompBytes;  // bytes of the msgs decompressed, after decompression
+  int64_t   decompUs;     // time spent on decompression
 } SRpcConn;
 
 int tsRpcMaxUdpSize = 15000;  // bytes
@@ -192,6 +204,9 @@ static SRpcConn *rpcSetupConnToServer(SRpcReqContext *pContext);
 static SRpcConn *rpcAllocateClientConn(SRpcInfo *pRpc);
 static SRpcConn *rpcAllocateServerConn(SRpcInfo *pRpc, SRecvInfo *pRecv);
 static SRpcConn *rpcGetConnObj(SRpcInfo *pRpc, int sid, SRecvInfo *pRecv);
+static int       rpcGetConnShard(SRpcInfo *pRpc, char *hashstr, size_t size);
+static int       rpcAllocateSid(SRpcInfo *pRpc, int shard);
+static void      rpcFreeSid(SRpcInfo *pRpc, int sid);
 
 static void  rpcSendReqToServer(SRpcInfo *pRpc, SRpcReqContext *pContext);
 static void  rpcSendQuickRsp(SRpcConn *pConn, int32_t code);
@@ -207,8 +222,8 @@ static void  rpcProcessIdleTimer(void *param, void *tmrId);
 static void  rpcProcessProgressTimer(void *param, void *tmrId);
 
 static void  rpcFreeMsg(void *msg);
-static int32_t rpcCompressRpcMsg(char* pCont, int32_t contLen);
-static SRpcHead *rpcDecompressRpcMsg(SRpcHead *pHead);
+static int32_t rpcCompressRpcMsg(SRpcConn *pConn, char* pCont, int32_t contLen);
+static int32_t rpcDecompressRpcMsg(SRpcConn *pConn, SRpcHead **ppHead);
 static int   rpcAddAuthPart(SRpcConn *pConn, char *msg, int msgLen);
 static int   rpcCheckAuthentication(SRpcConn *pConn, char *msg, int msgLen);
 static void  rpcLockConn(SRpcConn *pConn);
@@ -274,11 +289,16 @@ void *rpcOpen(const SRpcInit *pInit) {
     return NULL;
   }
 
-  pRpc->idPool = taosInitIdPool(pRpc->sessions-1);
-  if (pRpc->idPool == NULL) {
-    tError("%s failed to init ID pool", pRpc->label);
-    rpcClose(pRpc);
-    return NULL;
+  pRpc->numOfShards = (pRpc->sessions - 1 >= RPC_CONN_SHARDS * RPC_MIN_SESSIONS_PER_SHARD) ? RPC_CONN_SHARDS : 1;
+  pRpc->shardSize = (pRpc->sessions - 1) / pRpc->numOfShards;
+  for (int i = 0; i < pRpc->numOfShards; ++i) {
+    int maxId = (i == pRpc->numOfShards - 1) ? (pRpc->sessions - 1 - i * pRpc->shardSize) : pRpc->shardSize;
+    pRpc->idPool[i] = taosInitIdPool(maxId);
+    if (pRpc->idPool[i] == NULL) {
+      tError("%s failed to init ID pool", pRpc->label);
+      rpcClose(pRpc);
+      return NULL;
+    }
   }
 
   pRpc->tmrCtrl = taosTmrInit(pRpc->sessions*2 + 1, 50, 10000, pRpc->label);
@@ -289,11 +309,13 @@ void *rpcOpen(const SRpcInit *pInit) {
   }
 
   if (pRpc->connType == TAOS_CONN_SERVER) {
-    pRpc->hash = taosHashInit(pRpc->sessions, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, true);
-    if (pRpc->hash == NULL) {
-      tError("%s failed to init string hash", pRpc->label);
-      rpcClose(pRpc);
-      return NULL;
+    for (int i = 0; i < pRpc->numOfShards; ++i) {
+      pRpc->hash[i] = taosHashInit(pRpc->shardSize, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, true);
+      if (pRpc->hash[i] == NULL) {
+        tError("%s failed to init string hash", pRpc->label);
+        rpcClose(pRpc);
+        return NULL;
+      }
     }
   } else {
     pRpc->pCache = rpcOpenConnCache(pRpc->sessions, rpcCloseConn, pRpc->tmrCtrl, pRpc->idleTime * 20); 
@@ -389,7 +411,8 @@ void rpcSendRequest(void *shandle, const SRpcEpSet *pEpSet, SRpcMsg *pMsg, int64
   SRpcInfo       *pRpc = (SRpcInfo *)shandle;
   SRpcReqContext *pContext;
 
-  int contLen = rpcCompressRpcMsg(pMsg->pCont, pMsg->contLen);
+  // the msg is compressed once the connection is set up, since the codec depends on the peer
+  int contLen = pMsg->contLen;
   pContext = (SRpcReqContext *) ((char*)pMsg->pCont-sizeof(SRpcHead)-sizeof(SRpcReqContext));
   pContext->ahandle = pMsg->ahandle;
   pContext->pRpc = (SRpcInfo *)shandle;
@@ -433,7 +456,7 @@ void rpcSendResponse(const SRpcMsg *pRsp) {
   SRpcHead  *pHead = rpcHeadFromCont(pMsg->pCont);
   char      *msg = (char *)pHead;
 
-  pMsg->contLen = rpcCompressRpcMsg(pMsg->pCont, pMsg->contLen);
+  pMsg->contLen = rpcCompressRpcMsg(pConn, pMsg->pCont, pMsg->contLen);
   msgLen = rpcMsgLenFromCont(pMsg->contLen);
 
   rpcLockConn(pConn);
@@ -626,7 +649,7 @@ static void rpcReleaseConn(SRpcConn *pConn) {
   if ( pRpc->connType == TAOS_CONN_SERVER) {
     char hashstr[40] = {0};
     size_t size = snprintf(hashstr, sizeof(hashstr), "%x:%x:%x:%d", pConn->peerIp, pConn->linkUid, pConn->peerId, pConn->connType);
-    taosHashRemove(pRpc->hash, hashstr, size);
+    taosHashRemove(pRpc->hash[rpcGetConnShard(pRpc, hashstr, size)], hashstr, size);
     rpcFreeMsg(pConn->pRspMsg); // it may have a response msg saved, but not request msg
     pConn->pRspMsg = NULL;
   
@@ -666,7 +689,19 @@ static void rpcReleaseConn(SRpcConn *pConn) {
   pConn->pContext = NULL;
   pConn->chandle = NULL;
 
-  taosFreeId(pRpc->idPool, pConn->sid);
+  if (pConn->compBytes > 0 || pConn->decompBytes > 0) {
+    tDebug("%s, compressed %" PRId64 " bytes to %" PRId64 " in %" PRId64 "us, decompressed %" PRId64 " bytes in %" PRId64
+           "us", pConn->info, pConn->compBytes, pConn->compLen, pConn->compUs, pConn->decompBytes, pConn->decompUs);
+  }
+
+  pConn->peerFlag = 0;
+  pConn->compBytes = 0;
+  pConn->compLen = 0;
+  pConn->compUs = 0;
+  pConn->decompBytes = 0;
+  pConn->decompUs = 0;
+
+  rpcFreeSid(pRpc, pConn->sid);
   tDebug("%s, rpc connection is released", pConn->info);
 }
 
@@ -685,7 +720,7 @@ static void rpcCloseConn(void *thandle) {
 static SRpcConn *rpcAllocateClientConn(SRpcInfo *pRpc) {
   SRpcConn *pConn = NULL;
 
-  int sid = taosAllocateId(pRpc->idPool);
+  int sid = rpcAllocateSid(pRpc, (int)(taosGetSelfPthreadId() % pRpc->numOfShards));
   if (sid <= 0) {
     tError("%s maximum number of sessions:%d is reached", pRpc->label, pRpc->sessions);
     terrno = TSDB_CODE_RPC_MAX_SESSIONS;
@@ -706,15 +741,36 @@ static SRpcConn *rpcAllocateClientConn(SRpcInfo *pRpc) {
   return pConn;
 }
 
+static int rpcGetConnShard(SRpcInfo *pRpc, char *hashstr, size_t size) {
+  return (int)(MurmurHash3_32(hashstr, (uint32_t)size) % pRpc->numOfShards);
+}
+
+// allocate the sid from the given shard, or from the others if it is used up. Return 0 if all are used up
+static int rpcAllocateSid(SRpcInfo *pRpc, int shard) {
+  for (int i = 0; i < pRpc->numOfShards; ++i) {
+    int s = (shard + i) % pRpc->numOfShards;
+    int id = taosAllocateId(pRpc->idPool[s]);
+    if (id > 0) return s * pRpc->shardSize + id;
+  }
+
+  return 0;
+}
+
+static void rpcFreeSid(SRpcInfo *pRpc, int sid) {
+  int shard = MIN((sid - 1) / pRpc->shardSize, pRpc->numOfShards - 1);
+  taosFreeId(pRpc->idPool[shard], sid - shard * pRpc->shardSize);
+}
+
 static SRpcConn *rpcAllocateServerConn(SRpcInfo *pRpc, SRecvInfo *pRecv) {
   SRpcConn *pConn = NULL;
   char      hashstr[40] = {0};
   SRpcHead *pHead = (SRpcHead *)pRecv->msg;
 
   size_t size = snprintf(hashstr, sizeof(hashstr), "%x:%x:%x:%d", pRecv->ip, pHead->linkUid, pHead->sourceId, pRecv->connType);
+  int    shard = rpcGetConnShard(pRpc, hashstr, size);
  
   // check if it is already allocated
-  SRpcConn **ppConn = (SRpcConn **)(taosHashGet(pRpc->hash, hashstr, size));
+  SRpcConn **ppConn = (SRpcConn **)(taosHashGet(pRpc->hash[shard], hashstr, size));
   if (ppConn) pConn = *ppConn;
   if (pConn) {
     pConn->secured = 0;
@@ -727,7 +783,7 @@ static SRpcConn *rpcAllocateServerConn(SRpcInfo *pRpc, SRecvInfo *pRecv) {
     return NULL;
   }
 
-  int sid = taosAllocateId(pRpc->idPool);
+  int sid = rpcAllocateSid(pRpc, shard);
   if (sid <= 0) {
     tError("%s maximum number of sessions:%d is reached", pRpc->label, pRpc->sessions);
     terrno = TSDB_CODE_RPC_MAX_SESSIONS;
@@ -747,7 +803,7 @@ static SRpcConn *rpcAllocateServerConn(SRpcInfo *pRpc, SRecvInfo *pRecv) {
       }
 
       if (terrno != 0) {
-        taosFreeId(pRpc->idPool, sid);  // sid shall be released
+        rpcFreeSid(pRpc, sid);  // sid shall be released
         pConn = NULL;
       }
     }
@@ -760,7 +816,7 @@ static SRpcConn *rpcAllocateServerConn(SRpcInfo *pRpc, SRecvInfo *pRecv) {
       pConn->localPort = (pRpc->localPort + pRpc->index);
     }
 
-    taosHashPut(pRpc->hash, hashstr, size, (char *)&pConn, POINTER_BYTES);
+    taosHashPut(pRpc->hash[shard], hashstr, size, (char *)&pConn, POINTER_BYTES);
     tDebug("%s %p server connection is allocated, uid:0x%x sid:%d key:%s", pRpc->label, pConn, pConn->linkUid, sid, hashstr);
   }
 
@@ -1003,6 +1059,8 @@ static SRpcConn *rpcProcessMsgHead(SRpcInfo *pRpc, SRecvInfo *pRecv, SRpcReqCont
       // decrypt here
     }
 
+    pConn->peerFlag = pHead->resflag;
+
     if ( rpcIsReq(pHead->msgType) ) {
       pConn->connType = pRecv->connType;
       terrno = rpcProcessReqHead(pConn, pHead);
@@ -1155,7 +1213,21 @@ static void rpcProcessIncomingMsg(SRpcConn *pConn, SRpcHead *pHead, SRpcReqConte
   SRpcInfo *pRpc = pConn->pRpc;
   SRpcMsg   rpcMsg;
 
-  pHead = rpcDecompressRpcMsg(pHead);
+  int32_t code = rpcDecompressRpcMsg(pConn, &pHead);
+  if (code != TSDB_CODE_SUCCESS) {
+    // the content is dropped, the request is rejected and the response is passed on as the error
+    pHead->code = code;
+    pHead->msgLen = rpcMsgLenFromCont(0);
+
+    if (rpcIsReq(pHead->msgType)) {
+      SRpcMsg rMsg = {.handle = pConn, .pCont = NULL, .contLen = 0, .code = code};
+      rpcAddRef(pRpc);  // released by the response
+      rpcSendResponse(&rMsg);
+      rpcFreeMsg(pHead);
+      return;
+    }
+  }
+
   rpcMsg.contLen = rpcContLenFromMsg(pHead->msgLen);
   rpcMsg.pCont = pHead->content;
   rpcMsg.msgType = pHead->msgType;
@@ -1320,6 +1392,12 @@ static void rpcSendReqToServer(SRpcInfo *pRpc, SRpcReqContext *pContext) {
   pConn->ahandle = pContext->ahandle;
   rpcLockConn(pConn);
 
+  // a msg sent to another server again is compressed already
+  if (pHead->comp == RPC_COMP_NONE) {
+    pContext->contLen = rpcCompressRpcMsg(pConn, (char *)pContext->pCont, pContext->contLen);
+    msgLen = rpcMsgLenFromCont(pContext->contLen);
+  }
+
   // set the message header  
   pHead->version = 1;
   pHead->msgVer = htonl(tsVersion >> 8);
@@ -1353,6 +1431,9 @@ static void rpcSendMsgToPeer(SRpcConn *pConn, void *msg, int msgLen) {
   int        writtenLen = 0;
   SRpcHead  *pHead = (SRpcHead *)msg;
 
+#ifdef TD_TSZ
+  pHead->resflag = RPC_FLAG_ZSTD;
+#endif
   msgLen = rpcAddAuthPart(pConn, msg, msgLen);
 
   if ( rpcIsReq(pHead->msgType)) {
@@ -1469,76 +1550,105 @@ static void rpcProcessProgressTimer(void *param, void *tmrId) {
   rpcUnlockConn(pConn);
 }
 
-static int32_t rpcCompressRpcMsg(char* pCont, int32_t contLen) {
+// zstd is used only if the peer has told it is able to decompress it, otherwise lz4 is used
+static int8_t rpcGetCompCodec(SRpcConn *pConn) {
+#ifdef TD_TSZ
+  if (tsCompressMsgCodec == RPC_COMP_ZSTD && (pConn->peerFlag & RPC_FLAG_ZSTD)) return RPC_COMP_ZSTD;
+#endif
+  return RPC_COMP_LZ4;
+}
+
+static int32_t rpcCompressRpcMsg(SRpcConn *pConn, char* pCont, int32_t contLen) {
   SRpcHead  *pHead = rpcHeadFromCont(pCont);
   int32_t    finalLen = 0;
   int        overhead = sizeof(SRpcComp);
-  
+
   if (!NEEDTO_COMPRESSS_MSG(contLen)) {
     return contLen;
   }
-  
-  char *buf = malloc (contLen + overhead + 8);  // 8 extra bytes
+
+  int8_t  codec = rpcGetCompCodec(pConn);
+  int32_t bufLen = rpcCompBound(codec, contLen);
+
+  char *buf = malloc (bufLen + 8);  // 8 extra bytes
   if (buf == NULL) {
     tError("failed to allocate memory for rpc msg compression, contLen:%d", contLen);
     return contLen;
   }
-  
-  int32_t compLen = LZ4_compress_default(pCont, buf, contLen, contLen + overhead);
-  tDebug("compress rpc msg, before:%d, after:%d, overhead:%d", contLen, compLen, overhead);
-  
+
+  int64_t st = taosGetTimestampUs();
+  int32_t compLen = rpcCompress(codec, tsCompressMsgLevel, pCont, contLen, buf, bufLen);
+  tDebug("compress rpc msg, codec:%d before:%d, after:%d, overhead:%d", codec, contLen, compLen, overhead);
+
   /*
    * only the compressed size is less than the value of contLen - overhead, the compression is applied
    * The first four bytes is set to 0, the second four bytes are utilized to keep the original length of message
    */
   if (compLen > 0 && compLen < contLen - overhead) {
     SRpcComp *pComp = (SRpcComp *)pCont;
-    pComp->reserved = 0; 
-    pComp->contLen = htonl(contLen); 
+    pComp->reserved = 0;
+    pComp->contLen = htonl(contLen);
     memcpy(pCont + overhead, buf, compLen);
-    
-    pHead->comp = 1;
+
+    pHead->comp = codec;
     tDebug("compress rpc msg, before:%d, after:%d", contLen, compLen);
     finalLen = compLen + overhead;
   } else {
     finalLen = contLen;
   }
 
+  pConn->compBytes += contLen;
+  pConn->compLen += finalLen;
+  pConn->compUs += taosGetTimestampUs() - st;
+
   free(buf);
   return finalLen;
 }
 
-static SRpcHead *rpcDecompressRpcMsg(SRpcHead *pHead) {
-  int overhead = sizeof(SRpcComp);
-  SRpcHead   *pNewHead = NULL;  
+// The message is replaced by the one decompressed. It is kept as it is if the codec is unknown or the content is
+// broken, the content shall not be passed on then.
+static int32_t rpcDecompressRpcMsg(SRpcConn *pConn, SRpcHead **ppHead) {
+  SRpcHead   *pHead = *ppHead;
+  int         overhead = sizeof(SRpcComp);
   uint8_t    *pCont = pHead->content;
   SRpcComp   *pComp = (SRpcComp *)pHead->content;
 
-  if (pHead->comp) {
-    // decompress the content
-    assert(pComp->reserved == 0);
-    int contLen = htonl(pComp->contLen);
-  
-    // prepare the temporary buffer to decompress message
-    char *temp = (char *)malloc(contLen + RPC_MSG_OVERHEAD);
-    pNewHead = (SRpcHead *)(temp + sizeof(SRpcReqContext)); // reserve SRpcReqContext
-  
-    if (pNewHead) {
-      int compLen = rpcContLenFromMsg(pHead->msgLen) - overhead;
-      int origLen = LZ4_decompress_safe((char*)(pCont + overhead), (char *)pNewHead->content, compLen, contLen);
-      assert(origLen == contLen);
-    
-      memcpy(pNewHead, pHead, sizeof(SRpcHead));
-      pNewHead->msgLen = rpcMsgLenFromCont(origLen);
-      rpcFreeMsg(pHead); // free the compressed message buffer
-      pHead = pNewHead; 
-      tTrace("decomp malloc mem:%p", temp);
-    } else {
-      tError("failed to allocate memory to decompress msg, contLen:%d", contLen);
-    }
+  if (pHead->comp == RPC_COMP_NONE) return TSDB_CODE_SUCCESS;
+
+  int compLen = (int)rpcContLenFromMsg(pHead->msgLen) - overhead;
+  int contLen = (compLen > 0) ? (int)htonl(pComp->contLen) : 0;
+  if (!rpcCompSupported(pHead->comp) || compLen <= 0 || pComp->reserved != 0 || contLen <= 0) {
+    tError("%s, invalid compressed msg, codec:%d compLen:%d contLen:%d", pConn->info, pHead->comp, compLen, contLen);
+    return TSDB_CODE_RPC_INVALID_VALUE;
   }
 
-  return pHead;
+  // prepare the temporary buffer to decompress message
+  char *temp = (char *)malloc(contLen + RPC_MSG_OVERHEAD);
+  if (temp == NULL) {
+    tError("%s, failed to allocate memory to decompress msg, contLen:%d", pConn->info, contLen);
+    return TSDB_CODE_RPC_APP_ERROR;
+  }
+
+  SRpcHead *pNewHead = (SRpcHead *)(temp + sizeof(SRpcReqContext)); // reserve SRpcReqContext
+  int64_t   st = taosGetTimestampUs();
+  int       origLen = rpcDecompress(pHead->comp, (char *)(pCont + overhead), compLen, (char *)pNewHead->content, contLen);
+  if (origLen != contLen) {
+    tError("%s, failed to decompress msg, codec:%d compLen:%d contLen:%d origLen:%d", pConn->info, pHead->comp,
+           compLen, contLen, origLen);
+    free(temp);
+    return TSDB_CODE_RPC_INVALID_VALUE;
+  }
+
+  pConn->decompBytes += origLen;
+  pConn->decompUs += taosGetTimestampUs() - st;
+
+  memcpy(pNewHead, pHead, sizeof(SRpcHead));
+  pNewHead->msgLen = rpcMsgLenFromCont(origLen);
+  rpcFreeMsg(pHead); // free the compressed message buffer
+  *ppHead = pNewHead;
+  tTrace("decomp malloc mem:%p", temp);
+
+  return TSDB_CODE_SUCCESS;
 }
 
 static int rpcAuthenticateMsg(void *pMsg, int msgLen, void *pAuth, void *pKey) {
@@ -1665,9 +1775,11 @@ static void rpcDecRef(SRpcInfo *pRpc)
 { 
   if (atomic_sub_fetch_32(&pRpc->refCount, 1) == 0) {
     rpcCloseConnCache(pRpc->pCache);
-    taosHashCleanup(pRpc->hash);
     taosTmrCleanUp(pRpc->tmrCtrl);
-    taosIdPoolCleanUp(pRpc->idPool);
+    for (int i = 0; i < pRpc->numOfShards; ++i) {
+      taosHashCleanup(pRpc->hash[i]);
+      taosIdPoolCleanUp(pRpc->idPool[i]);
+    }
 
     tfree(pRpc->connList);
     pthread_mutex_destroy(&pRpc->mutex);
@@ -1682,5 +1794,9 @@ int32_t rpcUnusedSession(void * rpcInfo, bool bLock) {
   SRpcInfo *info = (SRpcInfo *)rpcInfo;
   if(info == NULL)
      return 0;
-  return taosIdPoolNumOfFree(info->idPool, bLock);
+  int32_t num = 0;
+  for (int i = 0; i < info->numOfShards; ++i) {
+    num += taosIdPoolNumOfFree(info->idPool[i], bLock);
+  }
+  return num;
 }
\ No newline at end of file
@@ -18,6 +18,7 @@
 #include "tutil.h"
 #include "taosdef.h"
 #include "taoserror.h"
+#include "tglobal.h"
 #include "rpcLog.h"
 #include "rpcHead.h"
 #include "rpcTcp.h"
@@ -41,6 +42,7 @@ typedef struct SThreadObj {
   uint32_t        ip;
   bool            stop;
   EpollFd         pollFd;
+  SOCKET          listenFd;  // own listening socket if rpcReusePort is set, otherwise -1
   int             numOfFds;
   int             threadId;
   char            label[TSDB_LABEL_LEN];
@@ -73,6 +75,32 @@ static SFdObj *taosMallocFdObj(SThreadObj *pThreadObj, SOCKET fd);
 static void    taosFreeFdObj(SFdObj *pFdObj);
 static void    taosReportBrokenLink(SFdObj *pFdObj);
 static void   *taosAcceptTcpConnection(void *arg);
+static void    taosAcceptReusePortConnections(SThreadObj *pThreadObj);
+static void    taosAddAcceptedConnection(SThreadObj *pThreadObj, SOCKET connFd, struct sockaddr_in *caddr);
+
+static int taosOpenTcpListenFd(SThreadObj *pThreadObj, uint32_t ip, uint16_t port) {
+  pThreadObj->listenFd = taosOpenTcpReusePortSocket(ip, port);
+  if (pThreadObj->listenFd < 0) {
+    tError("%s failed to open TCP listening socket with SO_REUSEPORT", pThreadObj->label);
+    return -1;
+  }
+
+  // the connections are accepted in batch until EAGAIN, the thread is not blocked on accept
+  taosSetNonblocking(pThreadObj->listenFd, 1);
+
+  // the thread object itself is the data of the listening socket, to be told apart from the SFdObj
+  struct epoll_event event;
+  event.events = EPOLLIN;
+  event.data.ptr = pThreadObj;
+  if (epoll_ctl(pThreadObj->pollFd, EPOLL_CTL_ADD, pThreadObj->listenFd, &event) < 0) {
+    tError("%s failed to add TCP listening socket into epoll(%s)", pThreadObj->label, strerror(errno));
+    taosCloseSocket(pThreadObj->listenFd);
+    pThreadObj->listenFd = -1;
+    return -1;
+  }
+
+  return 0;
+}
 
 void *taosInitTcpServer(uint32_t ip, uint16_t port, char *label, int numOfThreads, void *fp, void *shandle) {
   SServerObj *pServerObj;
@@ -119,6 +147,7 @@ void *taosInitTcpServer(uint32_t ip, uint16_t port, char *label, int numOfThread
 
     pServerObj->pThreadObj[i] = pThreadObj;
     pThreadObj->pollFd = -1;
+    pThreadObj->listenFd = -1;
     taosResetPthread(&pThreadObj->thread);
     pThreadObj->processData = fp;
     tstrncpy(pThreadObj->label, label, sizeof(pThreadObj->label));
@@ -142,6 +171,11 @@ void *taosInitTcpServer(uint32_t ip, uint16_t port, char *label, int numOfThread
       break;
     }
 
+    if (tsRpcReusePort) {
+      code = taosOpenTcpListenFd(pThreadObj, ip, port);
+      if (code != 0) break;
+    }
+
     code = pthread_create(&(pThreadObj->thread), &thattr, taosProcessTcpData, (void *)(pThreadObj));
     if (code != 0) {
       tError("%s failed to create TCP process data thread(%s)", label, strerror(errno));
@@ -151,10 +185,13 @@ void *taosInitTcpServer(uint32_t ip, uint16_t port, char *label, int numOfThread
     pThreadObj->threadId = i;
   }
 
-  pServerObj->fd = taosOpenTcpServerSocket(pServerObj->ip, pServerObj->port);
-  if (pServerObj->fd < 0) code = -1;
+  // the threads accept the connections by themselves with rpcReusePort, no accept thread is needed
+  if (code == 0 && !tsRpcReusePort) {
+    pServerObj->fd = taosOpenTcpServerSocket(pServerObj->ip, pServerObj->port);
+    if (pServerObj->fd < 0) code = -1;
+  }
 
-  if (code == 0) {
+  if (code == 0 && !tsRpcReusePort) {
     code = pthread_create(&pServerObj->thread, &thattr, taosAcceptTcpConnection, (void *)pServerObj);
     if (code != 0) {
       tError("%s failed to create TCP accept thread(%s)", label, strerror(code));
@@ -166,7 +203,8 @@ void *taosInitTcpServer(uint32_t ip, uint16_t port, char *label, int numOfThread
     taosCleanUpTcpServer(pServerObj);
     pServerObj = NULL;
   } else {
-    tDebug("%s TCP server is initialized, ip:0x%x port:%hu numOfThreads:%d", label, ip, port, numOfThreads);
+    tDebug("%s TCP server is initialized, ip:0x%x port:%hu numOfThreads:%d reusePort:%d", label, ip, port, numOfThreads,
+           tsRpcReusePort);
   }
 
   pthread_attr_destroy(&thattr);
@@ -206,6 +244,12 @@ void taosStopTcpServer(void *handle) {
     shutdown(pServerObj->fd, SHUT_RD);
 #endif
   }
+
+  // the thread closes its listening socket once accept fails with EINVAL
+  for (int i = 0; i < pServerObj->numOfThreads; ++i) {
+    SThreadObj *pThreadObj = pServerObj->pThreadObj[i];
+    if (pThreadObj != NULL && pThreadObj->listenFd >= 0) shutdown(pThreadObj->listenFd, SHUT_RD);
+  }
   if (taosCheckPthreadValid(pServerObj->thread)) {
     if (taosComparePthread(pServerObj->thread, pthread_self())) {
       pthread_detach(pthread_self());
@@ -262,31 +306,9 @@ static void *taosAcceptTcpConnection(void *arg) {
       continue;
     }
 
-    taosKeepTcpAlive(connFd);
-    struct timeval to={5, 0};
-    int32_t ret = taosSetSockOpt(connFd, SOL_SOCKET, SO_RCVTIMEO, &to, sizeof(to));
-    if (ret != 0) {
-      taosCloseSocket(connFd);
-      tError("%s failed to set recv timeout fd(%s)for connection from:%s:%hu", pServerObj->label, strerror(errno),
-             taosInetNtoa(caddr.sin_addr), htons(caddr.sin_port));
-      continue;
-    }
-
-
     // pick up the thread to handle this connection
     pThreadObj = pServerObj->pThreadObj[threadId];
-
-    SFdObj *pFdObj = taosMallocFdObj(pThreadObj, connFd);
-    if (pFdObj) {
-      pFdObj->ip = caddr.sin_addr.s_addr;
-      pFdObj->port = htons(caddr.sin_port);
-      tDebug("%s new TCP connection from %s:%hu, fd:%d FD:%p numOfFds:%d", pServerObj->label,
-              taosInetNtoa(caddr.sin_addr), pFdObj->port, connFd, pFdObj, pThreadObj->numOfFds);
-    } else {
-      taosCloseSocket(connFd);
-      tError("%s failed to malloc FdObj(%s) for connection from:%s:%hu", pServerObj->label, strerror(errno),
-             taosInetNtoa(caddr.sin_addr), htons(caddr.sin_port));
-    }
+    taosAddAcceptedConnection(pThreadObj, connFd, &caddr);
 
     // pick up next thread for next connection
     threadId++;
@@ -297,6 +319,55 @@ static void *taosAcceptTcpConnection(void *arg) {
   return NULL;
 }
 
+static void taosAcceptReusePortConnections(SThreadObj *pThreadObj) {
+  struct sockaddr_in caddr;
+
+  while (1) {
+    socklen_t addrlen = sizeof(caddr);
+    SOCKET    connFd = accept(pThreadObj->listenFd, (struct sockaddr *)&caddr, &addrlen);
+    if (connFd == -1) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+
+      if (errno == EINVAL) {
+        tDebug("%s TCP thread:%d stop accepting new connections", pThreadObj->label, pThreadObj->threadId);
+        epoll_ctl(pThreadObj->pollFd, EPOLL_CTL_DEL, pThreadObj->listenFd, NULL);
+        taosCloseSocket(pThreadObj->listenFd);
+        pThreadObj->listenFd = -1;
+      } else {
+        tError("%s TCP accept failure(%s)", pThreadObj->label, strerror(errno));
+      }
+      break;
+    }
+
+    taosAddAcceptedConnection(pThreadObj, connFd, &caddr);
+  }
+}
+
+static void taosAddAcceptedConnection(SThreadObj *pThreadObj, SOCKET connFd, struct sockaddr_in *caddr) {
+  taosKeepTcpAlive(connFd);
+  struct timeval to={5, 0};
+  int32_t ret = taosSetSockOpt(connFd, SOL_SOCKET, SO_RCVTIMEO, &to, sizeof(to));
+  if (ret != 0) {
+    taosCloseSocket(connFd);
+    tError("%s failed to set recv timeout fd(%s)for connection from:%s:%hu", pThreadObj->label, strerror(errno),
+           taosInetNtoa(caddr->sin_addr), htons(caddr->sin_port));
+    return;
+  }
+
+  SFdObj *pFdObj = taosMallocFdObj(pThreadObj, connFd);
+  if (pFdObj) {
+    pFdObj->ip = caddr->sin_addr.s_addr;
+    pFdObj->port = htons(caddr->sin_port);
+    tDebug("%s new TCP connection from %s:%hu, fd:%d FD:%p numOfFds:%d", pThreadObj->label,
+            taosInetNtoa(caddr->sin_addr), pFdObj->port, connFd, pFdObj, pThreadObj->numOfFds);
+  } else {
+    taosCloseSocket(connFd);
+    tError("%s failed to malloc FdObj(%s) for connection from:%s:%hu", pThreadObj->label, strerror(errno),
+           taosInetNtoa(caddr->sin_addr), htons(caddr->sin_port));
+  }
+}
+
 void *taosInitTcpClient(uint32_t ip, uint16_t port, char *label, int numOfThreads, void *fp, void *shandle) {
   SClientObj *pClientObj = (SClientObj *)calloc(1, sizeof(SClientObj));
   if (pClientObj == NULL) {
@@ -330,6 +401,7 @@ void *taosInitTcpClient(uint32_t ip, uint16_t port, char *label, int numOfThread
       return NULL;
     }
     pClientObj->pThreadObj[i] = pThreadObj;
+    pThreadObj->listenFd = -1;
     taosResetPthread(&pThreadObj->thread);
     pThreadObj->ip      = ip;
     pThreadObj->stop    = false;
@@ -532,7 +604,8 @@ static int taosReadTcpData(SFdObj *pFdObj, SRecvInfo *pInfo) {
   return 0;
 }
 
-#define maxEvents 10
+// the events are handled in batch, a busy thread takes more of them in one epoll_wait
+#define maxEvents 64
 
 static void *taosProcessTcpData(void *param) {
   SThreadObj        *pThreadObj = param;
@@ -553,6 +626,11 @@ static void *taosProcessTcpData(void *param) {
     if (fdNum < 0) continue;
 
     for (int i = 0; i < fdNum; ++i) {
+      if (events[i].data.ptr == pThreadObj) {
+        taosAcceptReusePortConnections(pThreadObj);
+        continue;
+      }
+
       pFdObj = events[i].data.ptr;
 
       if (events[i].events & EPOLLERR) {
@@ -590,6 +668,11 @@ static void *taosProcessTcpData(void *param) {
     pThreadObj->pollFd = -1;
   }
 
+  if (pThreadObj->listenFd >= 0) {
+    taosCloseSocket(pThreadObj->listenFd);
+    pThreadObj->listenFd = -1;
+  }
+
   while (pThreadObj->pHead) {
     pFdObj = pThreadObj->pHead;
     pThreadObj->pHead = pFdObj->next;
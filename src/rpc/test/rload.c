@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Load generator for rserver over TCP. Each app thread has its own rpc client and sends the requests one by one, the
+ * client is closed and opened again after every few requests if asked, so that the server sees many short-lived
+ * connections. The requests/sec and the latency percentiles are reported at the end.
+ */
+
+#include "os.h"
+#include "tutil.h"
+#include "ttimer.h"
+#include "tglobal.h"
+#include "rpcLog.h"
+#include "trpc.h"
+#include "taoserror.h"
+
+typedef struct {
+  int       index;
+  SRpcEpSet epSet;
+  SRpcInit  init;
+  int       numOfReqs;
+  int       reqsPerConn;
+  int       msgSize;
+  int       failed;
+  int64_t  *latency;  // in us, of each request
+  pthread_t thread;
+} SInfo;
+
+static void *sendRequest(void *param) {
+  SInfo  *pInfo = (SInfo *)param;
+  void   *pRpc = NULL;
+  SRpcMsg rpcMsg = {0};
+  SRpcMsg rspMsg = {0};
+
+  for (int i = 0; i < pInfo->numOfReqs; ++i) {
+    if (pRpc == NULL) {
+      pRpc = rpcOpen(&pInfo->init);
+      if (pRpc == NULL) {
+        tError("thread:%d, failed to initialize RPC", pInfo->index);
+        pInfo->failed += pInfo->numOfReqs - i;
+        break;
+      }
+    }
+
+    rpcMsg.pCont = rpcMallocCont(pInfo->msgSize);
+    rpcMsg.contLen = pInfo->msgSize;
+    rpcMsg.ahandle = pInfo;
+    rpcMsg.msgType = 1;
+
+    int64_t st = taosGetTimestampUs();
+    rpcSendRecv(pRpc, &pInfo->epSet, &rpcMsg, &rspMsg);
+    pInfo->latency[i] = taosGetTimestampUs() - st;
+
+    if (rspMsg.code != 0) pInfo->failed++;
+    rpcFreeCont(rspMsg.pCont);
+
+    // the connections of the client are closed with it
+    if (pInfo->reqsPerConn > 0 && (i + 1) % pInfo->reqsPerConn == 0) {
+      rpcClose(pRpc);
+      pRpc = NULL;
+    }
+  }
+
+  if (pRpc != NULL) rpcClose(pRpc);
+  return NULL;
+}
+
+static int compareLatency(const void *p1, const void *p2) {
+  int64_t v1 = *(int64_t *)p1;
+  int64_t v2 = *(int64_t *)p2;
+  return (v1 == v2) ? 0 : ((v1 < v2) ? -1 : 1);
+}
+
+int main(int argc, char *argv[]) {
+  SRpcInit  init;
+  SRpcEpSet epSet;
+  int       msgSize = 128;
+  int       numOfReqs = 10000;
+  int       reqsPerConn = 0;
+  int       appThreads = 8;
+  char      serverIp[40] = "127.0.0.1";
+  char      secret[TSDB_KEY_LEN] = "mypassword";
+
+  // server info
+  memset(&epSet, 0, sizeof(epSet));
+  epSet.numOfEps = 1;
+  epSet.inUse = 0;
+  epSet.port[0] = 7000;
+  strcpy(epSet.fqdn[0], serverIp);
+
+  // client info
+  memset(&init, 0, sizeof(init));
+  init.localPort    = 0;
+  init.label        = "APP";
+  init.numOfThreads = 1;
+  init.sessions     = 10;
+  init.idleTime     = tsShellActivityTimer*1000;
+  init.user         = "michael";
+  init.secret       = secret;
+  init.ckey         = "key";
+  init.spi          = 1;
+  init.connType     = TAOS_CONN_CLIENT;
+
+  for (int i=1; i<argc; ++i) {
+    if (strcmp(argv[i], "-p")==0 && i < argc-1) {
+      epSet.port[0] = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-i") ==0 && i < argc-1) {
+      tstrncpy(epSet.fqdn[0], argv[++i], sizeof(epSet.fqdn[0]));
+    } else if (strcmp(argv[i], "-m")==0 && i < argc-1) {
+      msgSize = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-n")==0 && i < argc-1) {
+      numOfReqs = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-a")==0 && i < argc-1) {
+      appThreads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-c")==0 && i < argc-1) {
+      reqsPerConn = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-d")==0 && i < argc-1) {
+      rpcDebugFlag = atoi(argv[++i]);
+    } else {
+      printf("\nusage: %s [options] \n", argv[0]);
+      printf("  [-i ip]: server IP address, default is:%s\n", serverIp);
+      printf("  [-p port]: server port number, default is:%d\n", epSet.port[0]);
+      printf("  [-m msgSize]: message body size, default is:%d\n", msgSize);
+      printf("  [-a threads]: number of app threads, default is:%d\n", appThreads);
+      printf("  [-n requests]: number of requests per thread, default is:%d\n", numOfReqs);
+      printf("  [-c requests]: number of requests per connection, 0 to keep it, default is:%d\n", reqsPerConn);
+      printf("  [-d debugFlag]: debug flag, default:%d\n", rpcDebugFlag);
+      printf("  [-h help]: print out this help\n\n");
+      exit(0);
+    }
+  }
+
+  if (numOfReqs <= 0 || appThreads <= 0) {
+    printf("number of requests and threads shall be positive\n");
+    exit(-1);
+  }
+
+  // the server is tested on its TCP path
+  tsRpcForceTcp = 1;
+  tsAsyncLog = 0;
+  taosInitLog("load.log", 100000, 10);
+  tsVersion = 0x02040000;  // the server rejects the clients older than 2.4
+  rpcInit();
+
+  // the timer module is cleaned up with the last timer controller, keep one for the clients opened again
+  void *tmrCtrl = taosTmrInit(8, 100, 1000, "LOAD");
+
+  SInfo *pInfo = (SInfo *)calloc(appThreads, sizeof(SInfo));
+  int64_t *latency = (int64_t *)calloc((size_t)numOfReqs * appThreads, sizeof(int64_t));
+  if (pInfo == NULL || latency == NULL) {
+    printf("failed to allocate memory\n");
+    exit(-1);
+  }
+
+  pthread_attr_t thattr;
+  pthread_attr_init(&thattr);
+  pthread_attr_setdetachstate(&thattr, PTHREAD_CREATE_JOINABLE);
+
+  int64_t st = taosGetTimestampUs();
+
+  for (int i=0; i<appThreads; ++i) {
+    pInfo[i].index = i;
+    pInfo[i].epSet = epSet;
+    pInfo[i].init = init;
+    pInfo[i].numOfReqs = numOfReqs;
+    pInfo[i].reqsPerConn = reqsPerConn;
+    pInfo[i].msgSize = msgSize;
+    pInfo[i].latency = latency + (int64_t)i * numOfReqs;
+    pthread_create(&pInfo[i].thread, &thattr, sendRequest, pInfo + i);
+  }
+
+  int failed = 0;
+  for (int i=0; i<appThreads; ++i) {
+    pthread_join(pInfo[i].thread, NULL);
+    failed += pInfo[i].failed;
+  }
+
+  int64_t el = taosGetTimestampUs() - st;
+  int64_t total = (int64_t)numOfReqs * appThreads;
+
+  qsort(latency, (size_t)total, sizeof(int64_t), compareLatency);
+
+  printf("%d threads, %d requests per thread, %d requests per connection, msgSize:%d\n", appThreads, numOfReqs,
+         reqsPerConn, msgSize);
+  printf("%.0f requests/sec, failed:%d\n", total * 1000000.0 / MAX(el, 1), failed);
+  printf("latency p50:%" PRId64 "us p99:%" PRId64 "us max:%" PRId64 "us\n", latency[total / 2], latency[total * 99 / 100],
+         latency[total - 1]);
+
+  pthread_attr_destroy(&thattr);
+  free(latency);
+  free(pInfo);
+  taosTmrCleanUp(tmrCtrl);
+  rpcCleanup();
+  taosCloseLog();
+
+  return 0;
+}
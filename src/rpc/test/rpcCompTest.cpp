@@ -0,0 +1,83 @@
+#include "os.h"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <vector>
+
+#include "rpcComp.h"
+#include "rpcHead.h"
+
+namespace {
+
+// a message of rows alike, as the submit and retrieve messages are
+std::vector<char> newMsg(int32_t len) {
+  std::vector<char> msg(len);
+  for (int32_t i = 0; i < len; ++i) {
+    msg[i] = (char)((i % 64 < 8) ? (i / 64) * 7 : i % 13);
+  }
+  return msg;
+}
+
+void roundTrip(int8_t codec) {
+  std::vector<char> msg = newMsg(65536);
+  std::vector<char> comp(rpcCompBound(codec, (int32_t)msg.size()));
+  std::vector<char> decomp(msg.size());
+
+  int32_t compLen = rpcCompress(codec, 1, msg.data(), (int32_t)msg.size(), comp.data(), (int32_t)comp.size());
+  ASSERT_GT(compLen, 0);
+  ASSERT_LT(compLen, msg.size() / 2);
+
+  ASSERT_EQ(rpcDecompress(codec, comp.data(), compLen, decomp.data(), (int32_t)decomp.size()), msg.size());
+  ASSERT_EQ(decomp, msg);
+}
+
+}  // namespace
+
+TEST(RpcCompTest, roundTripLz4) {
+  ASSERT_TRUE(rpcCompSupported(RPC_COMP_LZ4));
+  roundTrip(RPC_COMP_LZ4);
+}
+
+TEST(RpcCompTest, roundTripZstd) {
+#ifdef TD_TSZ
+  ASSERT_TRUE(rpcCompSupported(RPC_COMP_ZSTD));
+  roundTrip(RPC_COMP_ZSTD);
+#else
+  ASSERT_FALSE(rpcCompSupported(RPC_COMP_ZSTD));
+#endif
+}
+
+// the codecs unknown are rejected, not taken as no compression
+TEST(RpcCompTest, unknownCodec) {
+  std::vector<char> msg = newMsg(4096);
+  std::vector<char> buf(8192);
+
+  for (int8_t codec : {(int8_t)RPC_COMP_NONE, (int8_t)3, (int8_t)-1}) {
+    ASSERT_FALSE(rpcCompSupported(codec));
+    ASSERT_EQ(rpcCompress(codec, 1, msg.data(), (int32_t)msg.size(), buf.data(), (int32_t)buf.size()), -1);
+    ASSERT_EQ(rpcDecompress(codec, msg.data(), (int32_t)msg.size(), buf.data(), (int32_t)buf.size()), -1);
+  }
+}
+
+// the content broken or larger than told by the message fails, instead of overrunning the buffer
+TEST(RpcCompTest, brokenContent) {
+  std::vector<int8_t> codecs = {RPC_COMP_LZ4};
+#ifdef TD_TSZ
+  codecs.push_back(RPC_COMP_ZSTD);
+#endif
+
+  for (int8_t codec : codecs) {
+    std::vector<char> msg = newMsg(65536);
+    std::vector<char> comp(rpcCompBound(codec, (int32_t)msg.size()));
+    std::vector<char> decomp(msg.size());
+
+    int32_t compLen = rpcCompress(codec, 1, msg.data(), (int32_t)msg.size(), comp.data(), (int32_t)comp.size());
+    ASSERT_GT(compLen, 0);
+
+    ASSERT_EQ(rpcDecompress(codec, comp.data(), compLen, decomp.data(), (int32_t)msg.size() - 1), -1);
+    ASSERT_NE(rpcDecompress(codec, comp.data(), compLen / 2, decomp.data(), (int32_t)decomp.size()), msg.size());
+    ASSERT_EQ(rpcDecompress(codec, comp.data(), 0, decomp.data(), (int32_t)decomp.size()), -1);
+
+    std::vector<char> garbage(compLen, (char)0xff);
+    ASSERT_NE(rpcDecompress(codec, garbage.data(), compLen, decomp.data(), (int32_t)decomp.size()), msg.size());
+  }
+}
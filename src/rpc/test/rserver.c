@@ -114,31 +114,33 @@ void processRequestMsg(SRpcMsg *pMsg, SRpcEpSet *pEpSet) {
 }
 
 int main(int argc, char *argv[]) {
-  SRpcInit rpcInit;
+  SRpcInit init;
   char     dataName[20] = "server.data";
 
   taosBlockSIGPIPE();
 
-  memset(&rpcInit, 0, sizeof(rpcInit));
-  rpcInit.localPort    = 7000;
-  rpcInit.label        = "SER";
-  rpcInit.numOfThreads = 1;
-  rpcInit.cfp          = processRequestMsg;
-  rpcInit.sessions     = 1000;
-  rpcInit.idleTime     = tsShellActivityTimer*1500; 
-  rpcInit.afp          = retrieveAuthInfo;
+  memset(&init, 0, sizeof(init));
+  init.localPort    = 7000;
+  init.label        = "SER";
+  init.numOfThreads = 1;
+  init.cfp          = processRequestMsg;
+  init.sessions     = 1000;
+  init.idleTime     = tsShellActivityTimer*1500; 
+  init.afp          = retrieveAuthInfo;
 
   for (int i=1; i<argc; ++i) {
     if (strcmp(argv[i], "-p")==0 && i < argc-1) {
-      rpcInit.localPort = atoi(argv[++i]);
+      init.localPort = atoi(argv[++i]);
     } else if (strcmp(argv[i], "-t")==0 && i < argc-1) {
-      rpcInit.numOfThreads = atoi(argv[++i]);
+      init.numOfThreads = atoi(argv[++i]);
     } else if (strcmp(argv[i], "-m")==0 && i < argc-1) {
       msgSize = atoi(argv[++i]);
     } else if (strcmp(argv[i], "-s")==0 && i < argc-1) {
-      rpcInit.sessions = atoi(argv[++i]);
+      init.sessions = atoi(argv[++i]);
     } else if (strcmp(argv[i], "-o")==0 && i < argc-1) {
       tsCompressMsgSize = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-r")==0 && i < argc-1) {
+      tsRpcReusePort = atoi(argv[++i]);
     } else if (strcmp(argv[i], "-w")==0 && i < argc-1) {
       commit = atoi(argv[++i]);
     } else if (strcmp(argv[i], "-d")==0 && i < argc-1) {
@@ -147,11 +149,12 @@ int main(int argc, char *argv[]) {
       uDebugFlag = rpcDebugFlag;
     } else {
       printf("\nusage: %s [options] \n", argv[0]);
-      printf("  [-p port]: server port number, default is:%d\n", rpcInit.localPort);
-      printf("  [-t threads]: number of rpc threads, default is:%d\n", rpcInit.numOfThreads);
-      printf("  [-s sessions]: number of sessions, default is:%d\n", rpcInit.sessions);
+      printf("  [-p port]: server port number, default is:%d\n", init.localPort);
+      printf("  [-t threads]: number of rpc threads, default is:%d\n", init.numOfThreads);
+      printf("  [-s sessions]: number of sessions, default is:%d\n", init.sessions);
       printf("  [-m msgSize]: message body size, default is:%d\n", msgSize);
       printf("  [-o compSize]: compression message size, default is:%d\n", tsCompressMsgSize);
+      printf("  [-r reusePort]: each TCP thread listens on its own socket(0, 1), default is:%d\n", tsRpcReusePort);
       printf("  [-w write]: write received data to file(0, 1, 2), default is:%d\n", commit);
       printf("  [-d debugFlag]: debug flag, default:%d\n", rpcDebugFlag);
       printf("  [-h help]: print out this help\n\n");
@@ -160,10 +163,12 @@ int main(int argc, char *argv[]) {
   } 
 
   tsAsyncLog = 0;
-  rpcInit.connType = TAOS_CONN_SERVER;
+  init.connType = TAOS_CONN_SERVER;
   taosInitLog("server.log", 100000, 10);
+  tsVersion = 0x02040000;  // the server rejects the clients older than 2.4
+  rpcInit();
 
-  void *pRpc = rpcOpen(&rpcInit);
+  void *pRpc = rpcOpen(&init);
   if (pRpc == NULL) {
     tError("failed to start RPC server");
     return -1;
@@ -86,6 +86,10 @@ typedef struct SsyncPeer {
   SOCKET   peerFd;          // forward FD
   int32_t  numOfRetrieves;  // number of retrieves tried
   int32_t  fileChanged;     // a flag to indicate file is changed during retrieving process
+  int64_t  fileBytes;       // bytes of the files transferred with the peer
+  int64_t  fileUs;          // time spent on transferring the files
+  int64_t  walBytes;        // bytes of the wal transferred with the peer
+  int64_t  walUs;           // time spent on transferring the wal
   int32_t  refCount;
   int8_t   isArb;
   int64_t  rid;
@@ -131,6 +135,7 @@ void *     syncRetrieveData(void *param);
 void *     syncRestoreData(void *param);
 int32_t    syncSaveIntoBuffer(SSyncPeer *pPeer, SWalHead *pHead);
 void       syncRestartConnection(SSyncPeer *pPeer);
+void       syncAddTransferStat(SSyncPeer *pPeer, bool isWal, int64_t bytes, int64_t us);
 void       syncBroadcastStatus(SSyncNode *pNode);
 uint32_t   syncResolvePeerFqdn(SSyncPeer *pPeer);
 SSyncPeer *syncAcquirePeer(int64_t rid);
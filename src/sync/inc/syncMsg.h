@@ -115,7 +115,16 @@ typedef struct {
 
 #pragma pack(pop)
 
-#define SYNC_PROTOCOL_VERSION 1
+/*
+ * The peers of different protocol versions are rejected, so the version is bumped once the messages or the data
+ * transferred by the file sync are changed.
+ * 1. The files are sent whole.
+ * 2. The files are sent in checksummed chunks, from the offsets received by the last failed sync.
+ * 3. The digests of the local file of the receiver are no more than the blocks of the file sent, the sender rejects
+ *    more.
+ * 4. The tombstones of the sender are sent after the file sets, and replace the ones of the receiver.
+ */
+#define SYNC_PROTOCOL_VERSION 4
 #define SYNC_SIGNATURE ((uint16_t)(0xCDEF))
 
 extern char *statusType[];
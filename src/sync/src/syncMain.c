@@ -886,6 +886,19 @@ void syncRestartConnection(SSyncPeer *pPeer) {
   syncReleasePeer(pPeer);
 }
 
+// Account the bytes of files or wal transferred with the peer, and report the throughput of this time and in total
+void syncAddTransferStat(SSyncPeer *pPeer, bool isWal, int64_t bytes, int64_t us) {
+  int64_t *pBytes = isWal ? &pPeer->walBytes : &pPeer->fileBytes;
+  int64_t *pUs = isWal ? &pPeer->walUs : &pPeer->fileUs;
+
+  *pBytes += bytes;
+  *pUs += us;
+
+  sInfo("%s, %" PRId64 " bytes of %s are transferred in %" PRId64 " ms, %.2f MB/s, total %" PRId64 " bytes %.2f MB/s",
+        pPeer->id, bytes, isWal ? "wal" : "files", us / 1000, bytes / 1048576.0 * 1000000 / MAX(us, 1), *pBytes,
+        *pBytes / 1048576.0 * 1000000 / MAX(*pUs, 1));
+}
+
 static void syncProcessSyncRequest(char *msg, SSyncPeer *pPeer) {
   SSyncNode *pNode = pPeer->pSyncNode;
   sInfo("%s, sync-req is received", pPeer->id);
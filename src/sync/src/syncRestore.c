@@ -52,7 +52,12 @@ static int32_t syncRecvFileVersion(SSyncPeer *pPeer, uint64_t *fversion) {
 static int32_t syncRestoreFile(SSyncPeer *pPeer, uint64_t *fversion) {
   SSyncNode *pNode = pPeer->pSyncNode;
 
-  if (pNode->recvFileFp && (*pNode->recvFileFp)(pNode->pTsdb, pPeer->syncFd) != 0) {
+  int64_t bytes = 0;
+  int64_t st = taosGetTimestampUs();
+  int32_t code = pNode->recvFileFp ? (*pNode->recvFileFp)(pNode->pTsdb, pPeer->syncFd, &bytes) : 0;
+  syncAddTransferStat(pPeer, false, bytes, taosGetTimestampUs() - st);
+
+  if (code != 0) {
     sError("%s, failed to restore file", pPeer->id);
     return -1;
   }
@@ -69,6 +74,8 @@ static int32_t syncRestoreWal(SSyncPeer *pPeer, uint64_t *wver) {
   SSyncNode *pNode = pPeer->pSyncNode;
   int32_t    ret, code = -1;
   uint64_t   lastVer = 0;
+  int64_t    bytes = 0;
+  int64_t    st = taosGetTimestampUs();
 
   SWalHead *pHead = calloc(SYNC_MAX_SIZE, 1);  // size for one record
   if (pHead == NULL) return -1;
@@ -99,6 +106,7 @@ static int32_t syncRestoreWal(SSyncPeer *pPeer, uint64_t *wver) {
       break;
     }
     lastVer = pHead->version;
+    bytes += sizeof(SWalHead) + pHead->len;
 
     ret = (*pNode->writeToCacheFp)(pNode->vgId, pHead, TAOS_QTYPE_WAL, NULL);
     if (ret != 0) {
@@ -111,6 +119,8 @@ static int32_t syncRestoreWal(SSyncPeer *pPeer, uint64_t *wver) {
     sError("%s, failed to restore wal from syncFd:%d since %s", pPeer->id, pPeer->syncFd, strerror(errno));
   }
 
+  syncAddTransferStat(pPeer, true, bytes, taosGetTimestampUs() - st);
+
   free(pHead);
   *wver = lastVer;
   return code;
@@ -121,7 +121,12 @@ static int32_t syncRetrieveFile(SSyncPeer *pPeer) {
     return -1;
   }
 
-  if (pNode->sendFileFp && (*pNode->sendFileFp)(pNode->pTsdb, pPeer->syncFd) != 0) {
+  int64_t bytes = 0;
+  int64_t st = taosGetTimestampUs();
+  int32_t code = pNode->sendFileFp ? (*pNode->sendFileFp)(pNode->pTsdb, pPeer->syncFd, &bytes) : 0;
+  syncAddTransferStat(pPeer, false, bytes, taosGetTimestampUs() - st);
+
+  if (code != 0) {
     sError("%s, failed to retrieve file", pPeer->id);
     return -1;
   }
@@ -228,7 +233,7 @@ static int64_t syncRetrieveLastWal(SSyncPeer *pPeer, char *name, uint64_t fversi
   return code;
 }
 
-static int64_t syncProcessLastWal(SSyncPeer *pPeer, char *wname, int64_t index) {
+static int64_t syncProcessLastWal(SSyncPeer *pPeer, char *wname, int64_t index, int64_t *sent) {
   SSyncNode *pNode = pPeer->pSyncNode;
   int32_t    once = 0;  // last WAL has once ever been processed
   int64_t    offset = 0;
@@ -248,6 +253,7 @@ static int64_t syncProcessLastWal(SSyncPeer *pPeer, char *wname, int64_t index)
       sInfo("%s, failed to retrieve last wal, bytes:%" PRId64, pPeer->id, bytes);
       return bytes;
     }
+    *sent += bytes;
 
     // check file changes
     bool walModified = syncIsWalModified(pNode, pPeer);
@@ -284,7 +290,7 @@ static int64_t syncProcessLastWal(SSyncPeer *pPeer, char *wname, int64_t index)
   return -1;
 }
 
-static int64_t syncRetrieveWal(SSyncPeer *pPeer) {
+static int64_t syncRetrieveWal(SSyncPeer *pPeer, int64_t *sent) {
   SSyncNode * pNode = pPeer->pSyncNode;
   char        fname[TSDB_FILENAME_LEN * 3];
   char        wname[TSDB_FILENAME_LEN * 2];
@@ -308,7 +314,7 @@ static int64_t syncRetrieveWal(SSyncPeer *pPeer) {
     }
 
     if (code == 0) {  // last wal
-      code = syncProcessLastWal(pPeer, wname, index);
+      code = syncProcessLastWal(pPeer, wname, index, sent);
       sInfo("%s, last wal processed, code:%" PRId64, pPeer->id, code);
       break;
     }
@@ -340,6 +346,7 @@ static int64_t syncRetrieveWal(SSyncPeer *pPeer) {
       sError("%s, failed to send wal:%s for retrieve since %s, code:0x%" PRIx64, pPeer->id, fname, strerror(errno), code);
       break;
     }
+    *sent += code;
 
     if (syncAreFilesModified(pNode, pPeer)) {
       code = -1;
@@ -405,7 +412,10 @@ static int32_t syncRetrieveDataStepByStep(SSyncPeer *pPeer) {
   if (pPeer->sversion == 0) pPeer->sversion = 1;
 
   sInfo("%s, start to retrieve wals", pPeer->id);
-  int64_t code = syncRetrieveWal(pPeer);
+  int64_t bytes = 0;
+  int64_t st = taosGetTimestampUs();
+  int64_t code = syncRetrieveWal(pPeer, &bytes);
+  syncAddTransferStat(pPeer, true, bytes, taosGetTimestampUs() - st);
   if (code < 0) {
     sError("%s, failed to retrieve wals, code:0x%" PRIx64, pPeer->id, code);
     return -1;
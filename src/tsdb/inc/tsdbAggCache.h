@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_AGG_CACHE_H_
+#define _TD_TSDB_AGG_CACHE_H_
+
+// The partial aggregates of the file blocks computed by the queries, in LRU order. The content of a file block never
+// changes in a file system version, so all entries are dropped once the version changes.
+typedef struct {
+  pthread_mutex_t mutex;
+  SHashObj*       pHash;     // key -> SListNode* in lru
+  SList*          lru;       // the least recently used entry is the head
+  uint64_t        version;   // file system version of the entries
+  int64_t         capacity;  // in bytes
+  int64_t         size;      // in bytes
+  int64_t         hits;
+  int64_t         misses;
+  int64_t         evicts;
+} STsdbAggCache;
+
+STsdbAggCache* tsdbNewAggCache(int64_t capacity);
+void           tsdbFreeAggCache(STsdbAggCache* pCache);
+void           tsdbResetAggCache(STsdbAggCache* pCache, uint64_t fsVersion);
+void*          tsdbGetAggCache(STsdbAggCache* pCache, uint64_t fsVersion, const void* key, int32_t keyLen, int32_t* len);
+void tsdbPutAggCache(STsdbAggCache* pCache, uint64_t fsVersion, const void* key, int32_t keyLen, const void* pData,
+                     int32_t len);
+
+#endif /* _TD_TSDB_AGG_CACHE_H_ */
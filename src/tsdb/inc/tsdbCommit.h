@@ -29,6 +29,14 @@ typedef struct {
   int64_t  size;
 } SKVRecord;
 
+typedef struct {
+  int64_t startTime;     // us
+  int64_t nBlocks;       // number of blocks written
+  int64_t loadTime;      // us spent on loading the blocks and block infos from the file set
+  int64_t compressTime;  // us spent on compressing the columns of the blocks written
+  int64_t writeTime;     // us spent on writing the blocks to the files
+} STsdbCommitStat;
+
 #define TSDB_DEFAULT_BLOCK_ROWS(maxRows) ((maxRows)*4 / 5)
 
 void  tsdbGetRtnSnap(STsdbRepo *pRepo, SRtn *pRtn);
@@ -22,8 +22,14 @@ typedef enum {
   COMPACT_REQ,
   CONTROL_REQ,
   COMMIT_CONFIG_REQ,
+  AUTO_COMPACT_REQ,
 } TSDB_REQ_T;
 
 int tsdbScheduleCommit(STsdbRepo *pRepo, void* param, TSDB_REQ_T req);
 
+// the thread pool shared by the commits to compress the columns of the blocks in parallel
+struct SSchedMsg;
+int  tsdbNumOfCompressWorkers();
+void tsdbScheduleCompressWork(struct SSchedMsg *pMsg);
+
 #endif /* _TD_TSDB_COMMIT_QUEUE_H_ */
\ No newline at end of file
@@ -20,6 +20,7 @@ extern "C" {
 #endif
 
 void *tsdbCompactImpl(STsdbRepo *pRepo);
+void *tsdbAutoCompactImpl(STsdbRepo *pRepo);
 
 #ifdef __cplusplus
 }
@@ -21,15 +21,17 @@
  * 2. .head fver is 1 when extract aggregate block data from .data/.last file and save to separate .smad/.smal file
  * since 2021.10.10
  * // TODO update date and add release version.
+ * 3. 'current' file version is 2 when the delete tombstones are saved after the file set array.
  */
 typedef enum {
   TSDB_FS_VER_0 = 0,
   TSDB_FS_VER_1,
+  TSDB_FS_VER_2,
 } ETsdbFsVer;
 
 #define TSDB_FVER_TYPE uint32_t
 #define TSDB_LATEST_FVER TSDB_FS_VER_1     // latest version for DFile
-#define TSDB_LATEST_SFS_VER TSDB_FS_VER_1  // latest version for 'current' file
+#define TSDB_LATEST_SFS_VER TSDB_FS_VER_2  // latest version for 'current' file
 
 static FORCE_INLINE uint32_t tsdbGetDFSVersion(TSDB_FILE_T fType) {  // latest version for DFile
   switch (fType) {
@@ -62,6 +64,7 @@ typedef struct {
   SMFile*     pmf;   // meta file pointer
   SMFile      mf;    // meta file
   SArray*     df;    // data file array
+  SArray*     tombs; // STsdbTomb array of the deletes not applied to the data files
 } SFSStatus;
 
 typedef struct {
@@ -72,6 +75,7 @@ typedef struct {
   SHashObj*  metaCacheComp;   // meta cache for compact
   bool       intxn;
   SFSStatus* nstatus;  // new status
+  uint64_t   version;  // increased by each transaction, unlike meta.version it changes without a meta file either
 } STsdbFS;
 
 #define FS_CURRENT_STATUS(pfs) ((pfs)->cstatus)
@@ -82,7 +86,7 @@ typedef struct {
 
 typedef struct {
   int        direction;
-  uint64_t   version;  // current FS version
+  uint64_t   version;  // current FS version, the version of STsdbFS
   STsdbFS*   pfs;
   int        index;  // used to position next fset when version the same
   int        fid;    // used to seek when version is changed
@@ -102,6 +106,7 @@ int      tsdbEndFSTxnWithError(STsdbFS *pfs);
 void     tsdbUpdateFSTxnMeta(STsdbFS *pfs, STsdbFSMeta *pMeta);
 void     tsdbUpdateMFile(STsdbFS *pfs, const SMFile *pMFile);
 int      tsdbUpdateDFileSet(STsdbFS *pfs, const SDFileSet *pSet);
+void     tsdbExcludeDFileSet(STsdbFS *pfs, int fid);
 
 void       tsdbFSIterInit(SFSIter *pIter, STsdbFS *pfs, int direction);
 void       tsdbFSIterSeek(SFSIter *pIter, int fid);
@@ -21,5 +21,6 @@ int32_t tsdbInsertNewBlock(STsdbRepo* pRepo);
 
 bool tsdbIdleMemEnough();
 bool tsdbAllowNewBlock(STsdbRepo* pRepo);
+bool tsdbMemPressure(STsdbRepo* pRepo);
 
 #endif /* _TD_TSDB_BUFFER_H_ */
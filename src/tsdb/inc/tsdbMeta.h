@@ -16,6 +16,8 @@
 #ifndef _TD_TSDB_META_H_
 #define _TD_TSDB_META_H_
 
+#include "tshardhash.h"
+
 #define TSDB_MAX_TABLE_SCHEMAS 16
 
 #pragma  pack (push,1)
@@ -60,13 +62,14 @@ typedef struct {
   int32_t   nTables;
   int32_t   maxTables;
   STable**  tables;
-  SList*    superList;
-  SHashObj* uidMap;
-  int       maxRowBytes;
-  int       maxCols;
+  SList*      superList;
+  SShardHash* uidMap;
+  int         maxRowBytes;
+  int         maxCols;
 } STsdbMeta;
 
 #define TSDB_INIT_NTABLES 1024
+#define TSDB_UID_MAP_SHARDS 16
 #define TABLE_TYPE(t) (t)->type
 #define TABLE_NAME(t) (t)->name
 #define TABLE_CHAR_NAME(t) TABLE_NAME(t)->data
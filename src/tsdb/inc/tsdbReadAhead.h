@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_READ_AHEAD_H_
+#define _TD_TSDB_READ_AHEAD_H_
+
+// The file blocks a query is going to load, read by the shared thread pool ahead of the query. The blocks are consumed
+// in the order they are put, a block is dropped once a later one is read by the query.
+typedef struct STsdbReadAhead {
+  pthread_mutex_t mutex;
+  pthread_cond_t  notBusy;
+  SArray*         blocks;   // SReadAheadBlock*, in the order to be read by the query
+  int64_t         budget;   // in bytes
+  int64_t         size;     // in bytes, of the blocks put
+  int32_t         nBusy;    // number of the blocks being read
+  int64_t         hits;     // reads of the query served by the blocks read ahead
+  int64_t         misses;   // reads of the query from the files
+  int64_t         wastes;   // blocks dropped without being read by the query
+} STsdbReadAhead;
+
+STsdbReadAhead* tsdbNewReadAhead(int64_t budget);
+void            tsdbFreeReadAhead(STsdbReadAhead* pReadAhead);
+void            tsdbResetReadAhead(STsdbReadAhead* pReadAhead);
+bool            tsdbPutReadAhead(STsdbReadAhead* pReadAhead, SDFile* pDFile, SBlock* pBlock, int16_t* colIds,
+                                 int32_t numOfColIds);
+bool            tsdbGetReadAhead(STsdbReadAhead* pReadAhead, SDFile* pDFile, int64_t offset, void* buf, int64_t size);
+
+#endif /* _TD_TSDB_READ_AHEAD_H_ */
@@ -85,9 +85,14 @@ typedef struct {
   SBlockFieldsP1;
 } SBlockV1;
 
+/**
+ * TSDB_SBLK_VER_2 shares the SBlock/SBlockCol/SAggrBlkCol definition with TSDB_SBLK_VER_1, the only difference is
+ * that the aggr part in .smad/.smal is followed by a bloom filter part(SBloomBlkData).
+ */
 typedef enum {
   TSDB_SBLK_VER_0 = 0,
   TSDB_SBLK_VER_1,
+  TSDB_SBLK_VER_2,
 } ESBlockVer;
 
 #define SBlockVerLatest TSDB_SBLK_VER_1
@@ -140,6 +145,25 @@ typedef struct {
 
 #define SAggrBlkCol SAggrBlkColV1  // latest SAggrBlkCol definition
 
+typedef struct {
+  int16_t  colId;
+  uint8_t  nHash;
+  uint8_t  reserved;  // reserved field, not used
+  uint32_t len;       // length of the bloom filter bitmap, 0 means no bloom filter for the column
+} SBloomBlkColV2;
+
+#define SBloomBlkCol SBloomBlkColV2  // latest SBloomBlkCol definition
+
+/**
+ * len;        // length of the whole bloom filter part, including the checksum
+ * numOfCols;  // number of SBloomBlkCol, the bitmaps of the columns follow the cols in order, then the TSCKSUM
+ */
+typedef struct {
+  uint32_t     len;
+  int32_t      numOfCols;
+  SBloomBlkCol cols[];
+} SBloomBlkData;
+
 // Code here just for back-ward compatibility
 static FORCE_INLINE void tsdbSetBlockColOffset(SBlockCol *pBlockCol, uint32_t offset) {
   pBlockCol->offset = offset & ((((uint32_t)1) << 24) - 1);
@@ -171,10 +195,12 @@ struct SReadH {
   SBlockInfo *  pBlkInfo;  // SBlockInfoV#
   SBlockData *pBlkData;  // Block info
   SAggrBlkData *pAggrBlkData;  // Aggregate Block info
+  SBloomBlkData *pBloomBlkData;  // Bloom filter Block info
   SDataCols * pDCols[2];
   void *      pBuf;   // buffer
   void *      pCBuf;  // compression buffer
   void *      pExBuf;  // extra buffer
+  struct STsdbReadAhead *pReadAhead;  // NULL if the blocks are not read ahead
 };
 
 #define TSDB_READ_REPO(rh) ((rh)->pRepo)
@@ -226,10 +252,12 @@ int   tsdbLoadBlockInfo(SReadH *pReadh, void **pTarget, uint32_t *extendedLen);
 int   tsdbLoadBlockData(SReadH *pReadh, SBlock *pBlock, SBlockInfo *pBlockInfo);
 int   tsdbLoadBlockDataCols(SReadH *pReadh, SBlock *pBlock, SBlockInfo *pBlkInfo, int16_t *colIds, int numOfColsIds);
 int   tsdbLoadBlockStatis(SReadH *pReadh, SBlock *pBlock);
+int   tsdbLoadBlockBloom(SReadH *pReadh, SBlock *pBlock);
 int   tsdbLoadBlockOffset(SReadH *pReadh, SBlock *pBlock);
 int   tsdbEncodeSBlockIdx(void **buf, SBlockIdx *pIdx);
 void *tsdbDecodeSBlockIdx(void *buf, SBlockIdx *pIdx);
 void  tsdbGetBlockStatis(SReadH *pReadh, SDataStatis *pStatis, int numOfCols, SBlock *pBlock);
+void  tsdbGetBlockBloom(SReadH *pReadh, SDataBloom *pBloom, int numOfCols);
 
 static FORCE_INLINE int tsdbMakeRoom(void **ppBuf, size_t size) {
   void * pBuf = *ppBuf;
@@ -254,7 +282,7 @@ static FORCE_INLINE int tsdbMakeRoom(void **ppBuf, size_t size) {
 
 static FORCE_INLINE SBlockCol *tsdbGetSBlockCol(SBlock *pBlock, SBlockCol **pDestBlkCol, SBlockCol *pBlkCols,
                                                 int colIdx) {
-  if (pBlock->blkVer == SBlockVerLatest) {
+  if (pBlock->blkVer >= TSDB_SBLK_VER_1) {
     *pDestBlkCol = pBlkCols + colIdx;
     return *pDestBlkCol;
   }
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_SYNC_H_
+#define _TD_TSDB_SYNC_H_
+
+// The files are transferred in chunks, each one is checksummed by the receiver before being written
+#define TSDB_SYNC_CHUNK_SIZE (4 * 1024 * 1024)
+#define TSDB_SYNC_CHUNK_HEAD_SIZE (sizeof(int64_t) + sizeof(int32_t) + sizeof(TSCKSUM))
+
+// The receiver sends the digests of the blocks of its local file of the same fid, the blocks same in the file of the
+// sender are not sent. Commits append the new blocks to the data file, so only the part appended since the last sync
+// is sent usually.
+#define TSDB_SYNC_BLOCK_SIZE (64 * 1024)
+#define TSDB_SYNC_DIGEST_SIZE 16  // MD5
+
+// A file set received from the remote by a failed sync. The next sync goes on from the received offsets if the remote
+// file set is not changed, otherwise the local copy is removed. Only kept in memory, the files left are removed as
+// orphans once the vnode is opened again.
+typedef struct {
+  uint32_t  fsVer;                  // file system version of the sync, the files are named after the next version
+  bool      used;                   // added to the file system by the current sync
+  SDFileSet rset;                   // the file set of the remote
+  SDFileSet lset;                   // the local copy
+  int64_t   offset[TSDB_FILE_MAX];  // bytes received of each file
+} STsdbSyncFSet;
+
+void tsdbFreeSyncFSets(SArray* pSyncFSets);
+
+#endif /* _TD_TSDB_SYNC_H_ */
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _TD_TSDB_TOMB_H_
+#define _TD_TSDB_TOMB_H_
+
+/**
+ * The rows of a table deleted from the data files but not removed from them yet. A tombstone never spans two file
+ * sets, so that it is dropped once the rows of the table in its file set are rewritten by a commit or compaction.
+ * The tombstones are kept in the FS status ordered by uid and skey, and saved with it into the 'current' file.
+ */
+typedef struct {
+  uint64_t uid;
+  TSKEY    skey;
+  TSKEY    ekey;
+  uint32_t version;  // FS version of the delete
+} STsdbTomb;
+
+int   tsdbEncodeTombArray(void **buf, SArray *pArray);
+void *tsdbDecodeTombArray(void *buf, SArray *pArray);
+
+int        tsdbAddTomb(SArray *pArray, const STsdbTomb *pTomb);
+STsdbTomb *tsdbGetTableTombs(SArray *pArray, uint64_t uid, int32_t *num);
+void       tsdbDropTableTombs(SArray *pArray, uint64_t uid, TSKEY minKey, TSKEY maxKey);
+void       tsdbDropTombs(SArray *pArray, TSKEY minKey, TSKEY maxKey);
+bool       tsdbTombsOverlap(const STsdbTomb *pTombs, int32_t num, TSKEY skey, TSKEY ekey);
+bool       tsdbTombsCover(const STsdbTomb *pTombs, int32_t num, TSKEY skey, TSKEY ekey);
+int        tsdbFilterTombRows(const STsdbTomb *pTombs, int32_t num, SDataCols **ppCols, SDataCols **ppBuf);
+
+#endif /* _TD_TSDB_TOMB_H_ */
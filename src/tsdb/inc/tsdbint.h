@@ -58,10 +58,14 @@ extern "C" {
 #include "tsdbMemTable.h"
 // File
 #include "tsdbFile.h"
+// Tombstone
+#include "tsdbTomb.h"
 // FS
 #include "tsdbFS.h"
 // ReadImpl
 #include "tsdbReadImpl.h"
+// Read ahead
+#include "tsdbReadAhead.h"
 // Commit
 #include "tsdbCommit.h"
 // Compact
@@ -72,6 +76,10 @@ extern "C" {
 #include "tsdbCommitQueue.h"
 
 #include "tsdbRowMergeBuf.h"
+// Partial aggregates of file blocks
+#include "tsdbAggCache.h"
+// Sync
+#include "tsdbSync.h"
 // Main definitions
 struct STsdbRepo {
   uint8_t state;
@@ -86,11 +94,14 @@ struct STsdbRepo {
 
   STsdbAppH       appH;
   STsdbStat       stat;
+  STsdbCommitStat commitStat;  // statistics of the commit in progress
   STsdbMeta*      tsdbMeta;
   STsdbBufPool*   pPool;
   SMemTable*      mem;
   SMemTable*      imem;
   STsdbFS*        fs;
+  STsdbAggCache*  pAggCache;  // NULL if the cache is disabled
+  SArray*         syncFSets;  // STsdbSyncFSet, the file sets received by the last failed sync
   SRtn            rtn;
   tsem_t          readyToCommit;
   pthread_mutex_t mutex;
@@ -99,6 +110,10 @@ struct STsdbRepo {
 
   SMergeBuf       mergeBuf;  //used when update=2
   int8_t          compactState;  // compact state: inCompact/noCompact/waitingCompact?
+  STsdbCompactStat compactStat;
+  SArray*         compactScores;  // SCompactScore, the scores of the file sets kept while they are not changed
+  uint32_t        compactVersion;  // FS version found with no file set to compact
+  int64_t         compactNextTime;  // us, the background compaction is put off until then for the read budget
   int8_t          deleteState;  // truncate state: inTruncate/noTruncate/waitingTruncate
 
   pthread_t*      pthread;
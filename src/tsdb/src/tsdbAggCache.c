@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tsdbint.h"
+
+// an entry larger than this fraction of the capacity is not cached, so that one query can not flush the whole cache
+#define TSDB_AGG_CACHE_MAX_ENTRY_RATIO 8
+
+typedef struct {
+  int32_t keyLen;
+  int32_t len;
+  char    data[];  // key, followed by the cached content
+} SAggCacheEntry;
+
+#define AGG_CACHE_NODE_ENTRY(n) ((SAggCacheEntry *)((n)->data))
+#define AGG_CACHE_NODE_SIZE(e) (sizeof(SListNode) + sizeof(SAggCacheEntry) + (e)->keyLen * 2 + (e)->len)
+
+static void tsdbClearAggCache(STsdbAggCache *pCache);
+static void tsdbEvictAggCache(STsdbAggCache *pCache, int64_t size);
+static bool tsdbCheckAggCacheVersion(STsdbAggCache *pCache, uint64_t fsVersion);
+
+STsdbAggCache *tsdbNewAggCache(int64_t capacity) {
+  STsdbAggCache *pCache = (STsdbAggCache *)calloc(1, sizeof(*pCache));
+  if (pCache == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  int code = pthread_mutex_init(&pCache->mutex, NULL);
+  if (code != 0) {
+    terrno = TAOS_SYSTEM_ERROR(code);
+    free(pCache);
+    return NULL;
+  }
+
+  pCache->capacity = capacity;
+  pCache->pHash = taosHashInit(1024, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), false, HASH_NO_LOCK);
+  pCache->lru = tdListNew(0);
+  if (pCache->pHash == NULL || pCache->lru == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    tsdbFreeAggCache(pCache);
+    return NULL;
+  }
+
+  return pCache;
+}
+
+void tsdbFreeAggCache(STsdbAggCache *pCache) {
+  if (pCache == NULL) {
+    return;
+  }
+
+  tsdbDebug("agg cache freed, entries:%d size:%" PRId64 " hits:%" PRId64 " misses:%" PRId64 " evicts:%" PRId64,
+            pCache->lru ? listNEles(pCache->lru) : 0, pCache->size, pCache->hits, pCache->misses, pCache->evicts);
+
+  taosHashCleanup(pCache->pHash);
+  tdListFree(pCache->lru);
+  pthread_mutex_destroy(&pCache->mutex);
+  free(pCache);
+}
+
+// Called once the file system version changes, all entries are stale then.
+void tsdbResetAggCache(STsdbAggCache *pCache, uint64_t fsVersion) {
+  if (pCache == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&pCache->mutex);
+  tsdbCheckAggCacheVersion(pCache, fsVersion);
+  pthread_mutex_unlock(&pCache->mutex);
+}
+
+/*
+ * Return a copy of the cached content that should be freed by the caller, or NULL if the key is absent. The entries
+ * of a different file system version are never returned.
+ */
+void *tsdbGetAggCache(STsdbAggCache *pCache, uint64_t fsVersion, const void *key, int32_t keyLen, int32_t *len) {
+  void *pData = NULL;
+
+  pthread_mutex_lock(&pCache->mutex);
+
+  if (tsdbCheckAggCacheVersion(pCache, fsVersion)) {
+    SListNode **ppNode = taosHashGet(pCache->pHash, key, keyLen);
+    if (ppNode != NULL) {
+      SAggCacheEntry *pEntry = AGG_CACHE_NODE_ENTRY(*ppNode);
+
+      pData = malloc(pEntry->len);
+      if (pData != NULL) {
+        memcpy(pData, pEntry->data + pEntry->keyLen, pEntry->len);
+        *len = pEntry->len;
+
+        // move to the tail as the most recently used one
+        tdListPopNode(pCache->lru, *ppNode);
+        tdListAppendNode(pCache->lru, *ppNode);
+      }
+    }
+  }
+
+  if (pData != NULL) {
+    pCache->hits += 1;
+  } else {
+    pCache->misses += 1;
+  }
+
+  pthread_mutex_unlock(&pCache->mutex);
+  return pData;
+}
+
+void tsdbPutAggCache(STsdbAggCache *pCache, uint64_t fsVersion, const void *key, int32_t keyLen, const void *pData,
+                     int32_t len) {
+  SListNode *pNode = malloc(sizeof(SListNode) + sizeof(SAggCacheEntry) + keyLen + len);
+  if (pNode == NULL) {
+    return;
+  }
+
+  pNode->next = pNode->prev = NULL;
+
+  SAggCacheEntry *pEntry = AGG_CACHE_NODE_ENTRY(pNode);
+  pEntry->keyLen = keyLen;
+  pEntry->len = len;
+  memcpy(pEntry->data, key, keyLen);
+  memcpy(pEntry->data + keyLen, pData, len);
+
+  int64_t size = AGG_CACHE_NODE_SIZE(pEntry);
+  if (size > pCache->capacity / TSDB_AGG_CACHE_MAX_ENTRY_RATIO) {
+    free(pNode);
+    return;
+  }
+
+  pthread_mutex_lock(&pCache->mutex);
+
+  // the entries of an older version should not be put, and another query may have put the same one
+  if (!tsdbCheckAggCacheVersion(pCache, fsVersion) || taosHashGet(pCache->pHash, key, keyLen) != NULL) {
+    pthread_mutex_unlock(&pCache->mutex);
+    free(pNode);
+    return;
+  }
+
+  tsdbEvictAggCache(pCache, size);
+
+  if (taosHashPut(pCache->pHash, key, keyLen, &pNode, POINTER_BYTES) != 0) {
+    pthread_mutex_unlock(&pCache->mutex);
+    free(pNode);
+    return;
+  }
+
+  tdListAppendNode(pCache->lru, pNode);
+  pCache->size += size;
+
+  pthread_mutex_unlock(&pCache->mutex);
+}
+
+// Drop the entries of the previous version if the version is newer, return false if the version is an older one.
+static bool tsdbCheckAggCacheVersion(STsdbAggCache *pCache, uint64_t fsVersion) {
+  if (fsVersion == pCache->version) {
+    return true;
+  }
+
+  if (fsVersion < pCache->version) {
+    return false;
+  }
+
+  tsdbDebug("agg cache reset, version:%" PRIu64 " -> %" PRIu64 ", entries:%d size:%" PRId64 " hits:%" PRId64
+            " misses:%" PRId64 " evicts:%" PRId64,
+            pCache->version, fsVersion, listNEles(pCache->lru), pCache->size, pCache->hits, pCache->misses,
+            pCache->evicts);
+
+  tsdbClearAggCache(pCache);
+  pCache->version = fsVersion;
+  return true;
+}
+
+static void tsdbClearAggCache(STsdbAggCache *pCache) {
+  taosHashClear(pCache->pHash);
+  tdListEmpty(pCache->lru);
+  pCache->size = 0;
+}
+
+// evict the least recently used entries until there is enough room for the new one
+static void tsdbEvictAggCache(STsdbAggCache *pCache, int64_t size) {
+  while (pCache->size + size > pCache->capacity && !isListEmpty(pCache->lru)) {
+    SListNode      *pNode = tdListPopNode(pCache->lru, listHead(pCache->lru));
+    SAggCacheEntry *pEntry = AGG_CACHE_NODE_ENTRY(pNode);
+
+    taosHashRemove(pCache->pHash, pEntry->data, pEntry->keyLen);
+    pCache->size -= AGG_CACHE_NODE_SIZE(pEntry);
+    pCache->evicts += 1;
+
+    listNodeFree(pNode);
+  }
+}
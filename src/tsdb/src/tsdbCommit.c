@@ -13,10 +13,14 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 #include "tsdbint.h"
+#include "tbloomfilter.h"
+#include "tsched.h"
 
 extern int32_t tsTsdbMetaCompactRatio;
+extern int32_t tsdbBloomFilterBits;
 
 #define TSDB_MAX_SUBBLOCKS 8
+#define TSDB_MIN_PARALLEL_COMPRESS_BYTES (64 * 1024)
 
 typedef struct {
   SRtn         rtn;     // retention snapshot
@@ -35,6 +39,8 @@ typedef struct {
   SArray *     aSupBlk;  // Table super-block array
   SArray *     aSubBlk;  // table sub-block array
   SDataCols *  pDataCols;
+  STsdbTomb *  pTombs;  // tombstones of the commit table
+  int32_t      numOfTombs;
 } SCommitH;
 
 /*
@@ -79,6 +85,9 @@ static int  tsdbCommitToTable(SCommitH *pCommith, int tid);
 static int  tsdbSetCommitTable(SCommitH *pCommith, STable *pTable);
 static int  tsdbComparKeyBlock(const void *arg1, const void *arg2);
 static int  tsdbWriteBlockInfo(SCommitH *pCommih);
+static int  tsdbCommitLoadBlockInfo(SCommitH *pCommith);
+static int  tsdbCommitLoadBlockData(SCommitH *pCommith, SBlock *pBlock);
+static int  tsdbCommitLoadBlockKeys(SCommitH *pCommith, SBlock *pBlock);
 static int  tsdbCommitMemData(SCommitH *pCommith, SCommitIter *pIter, TSKEY keyLimit, bool toData);
 static int  tsdbMergeMemData(SCommitH *pCommith, SCommitIter *pIter, int bidx);
 static int  tsdbMoveBlock(SCommitH *pCommith, int bidx);
@@ -641,6 +650,12 @@ static int tsdbCommitTSData(STsdbRepo *pRepo) {
     }
   }
 
+  // The tombstones of the expired FSETs go with them
+  TSKEY minFidKey, maxFidKey;
+  tsdbGetFidKeyRange(REPO_CFG(pRepo)->daysPerFile, REPO_CFG(pRepo)->precision, commith.rtn.minFid, &minFidKey,
+                     &maxFidKey);
+  tsdbDropTombs(REPO_FS(pRepo)->nstatus->tombs, INT64_MIN, minFidKey - 1);
+
   // Loop to commit to each file
   fid = tsdbNextCommitFid(&(commith));
   while (true) {
@@ -695,6 +710,9 @@ static void tsdbStartCommit(STsdbRepo *pRepo) {
 
   tsdbStartFSTxn(pRepo, pMem->pointsAdd, pMem->storageAdd);
 
+  memset(&pRepo->commitStat, 0, sizeof(pRepo->commitStat));
+  pRepo->commitStat.startTime = taosGetTimestampUs();
+
   pRepo->code = TSDB_CODE_SUCCESS;
 }
 
@@ -705,7 +723,11 @@ static void tsdbEndCommit(STsdbRepo *pRepo, int eno, bool end) {
     tsdbEndFSTxn(pRepo);
   }
 
-  tsdbInfo("vgId:%d commit over, %s", REPO_ID(pRepo), (eno == TSDB_CODE_SUCCESS) ? "succeed" : "failed");
+  STsdbCommitStat *pStat = &pRepo->commitStat;
+  int64_t          elapsed = taosGetTimestampUs() - pStat->startTime;
+  tsdbInfo("vgId:%d commit over, %s, elapsed time:%.2fms, blocks:%" PRId64 ", load:%.2fms, compress:%.2fms, write:%.2fms",
+           REPO_ID(pRepo), (eno == TSDB_CODE_SUCCESS) ? "succeed" : "failed", elapsed / 1000.0, pStat->nBlocks,
+           pStat->loadTime / 1000.0, pStat->compressTime / 1000.0, pStat->writeTime / 1000.0);
 
   // notify
   if (end && pRepo->appH.notifyStatus) {
@@ -786,6 +808,9 @@ static int tsdbCommitToFile(SCommitH *pCommith, SDFileSet *pSet, int fid) {
     return -1;
   }
 
+  // All the tables are rewritten with the deleted rows filtered out, the tombstones of the FSET are done
+  tsdbDropTombs(REPO_FS(pRepo)->nstatus->tombs, pCommith->minKey, pCommith->maxKey);
+
   return 0;
 }
 
@@ -964,7 +989,7 @@ static int tsdbCommitToTable(SCommitH *pCommith, int tid) {
   SBlock *pBlock;
 
   if (pCommith->readh.pBlkIdx) {
-    if (tsdbLoadBlockInfo(&(pCommith->readh), NULL, NULL) < 0) {
+    if (tsdbCommitLoadBlockInfo(pCommith) < 0) {
       TSDB_RUNLOCK_TABLE(pIter->pTable);
       return -1;
     }
@@ -1042,6 +1067,8 @@ static int tsdbSetCommitTable(SCommitH *pCommith, STable *pTable) {
   STSchema *pSchema = tsdbGetTableSchemaImpl(pTable, false, false, -1, -1);
 
   pCommith->pTable = pTable;
+  pCommith->pTombs =
+      tsdbGetTableTombs(REPO_FS(TSDB_COMMIT_REPO(pCommith))->cstatus->tombs, TABLE_UID(pTable), &pCommith->numOfTombs);
 
   if (tdInitDataCols(pCommith->pDataCols, pSchema) < 0) {
     terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
@@ -1071,6 +1098,219 @@ static int tsdbComparKeyBlock(const void *arg1, const void *arg2) {
   }
 }
 
+/**
+ * Build the bloom filter part of a block at the offset of *ppBuf, *pLen is set to 0 if no column needs a bloom filter.
+ */
+static int tsdbBuildBlockBloom(SDataCols *pDataCols, int rowsToWrite, void **ppBuf, uint32_t offset, uint32_t *pLen) {
+  uint32_t nBytes = taosBloomFilterBytes(rowsToWrite, tsdbBloomFilterBits);
+  uint8_t  nHash = taosBloomFilterNumOfHash(tsdbBloomFilterBits);
+  int      nCols = 0;
+
+  *pLen = 0;
+
+  for (int ncol = 1; ncol < pDataCols->numOfCols; ncol++) {
+    SDataCol *pDataCol = pDataCols->cols + ncol;
+    if (!isAllRowsNull(pDataCol) && IS_BLOOM_FILTER_TYPE(pDataCol->type)) {
+      nCols++;
+    }
+  }
+
+  if (nCols == 0 || nBytes == 0) {
+    return 0;
+  }
+
+  uint32_t tsize = (uint32_t)(sizeof(SBloomBlkData) + (sizeof(SBloomBlkCol) + nBytes) * nCols + sizeof(TSCKSUM));
+  if (tsdbMakeRoom(ppBuf, offset + tsize) < 0) {
+    return -1;
+  }
+
+  SBloomBlkData *pBloomBlkData = (SBloomBlkData *)POINTER_SHIFT(*ppBuf, offset);
+  uint8_t *      bits = (uint8_t *)POINTER_SHIFT(pBloomBlkData, sizeof(SBloomBlkData) + sizeof(SBloomBlkCol) * nCols);
+
+  memset(pBloomBlkData, 0, tsize);
+  pBloomBlkData->len = tsize;
+  pBloomBlkData->numOfCols = nCols;
+
+  int tcol = 0;
+  for (int ncol = 1; ncol < pDataCols->numOfCols; ncol++) {
+    SDataCol *pDataCol = pDataCols->cols + ncol;
+    if (isAllRowsNull(pDataCol) || !IS_BLOOM_FILTER_TYPE(pDataCol->type)) {
+      continue;
+    }
+
+    SBloomBlkCol *pBloomBlkCol = pBloomBlkData->cols + tcol;
+    pBloomBlkCol->colId = pDataCol->colId;
+    pBloomBlkCol->nHash = nHash;
+    pBloomBlkCol->len = nBytes;
+
+    for (int row = 0; row < rowsToWrite; row++) {
+      const void *val = tdGetColDataOfRow(pDataCol, row);
+      if (isNull(val, pDataCol->type)) {
+        continue;
+      }
+
+      if (IS_VAR_DATA_TYPE(pDataCol->type)) {
+        taosBloomFilterPut(bits, nBytes, nHash, varDataVal(val), varDataLen(val));
+      } else {
+        taosBloomFilterPut(bits, nBytes, nHash, val, TYPE_BYTES[pDataCol->type]);
+      }
+    }
+
+    bits += nBytes;
+    tcol++;
+  }
+
+  *pLen = tsize;
+  return 0;
+}
+
+typedef struct {
+  SDataCol *pDataCol;
+  int32_t   tlen;     // length of the column data to compress
+  int32_t   offset;   // offset of the area in the block buffer to compress the column to
+  int32_t   coffset;  // offset of the area in the buffer of the two stage compression
+  int32_t   flen;     // length of the compressed column, including the checksum
+} SCompressCol;
+
+/*
+ * The columns of a block are compressed by the commit thread and the compress workers together, each one takes the
+ * next column not compressed yet until all are done. A worker may start after the block has been written, so the job
+ * is reference counted and the workers never touch anything but the job once all columns are taken.
+ */
+typedef struct {
+  int32_t         ref;
+  int32_t         next;       // index of the next column to compress
+  int32_t         nfinished;  // number of the columns compressed
+  int32_t         ncols;
+  int32_t         rows;
+  int8_t          comp;
+  int32_t         size;   // size of the block buffer needed
+  int32_t         csize;  // size of the two stage compression buffer needed
+  int64_t         bytes;  // total length of the column data
+  char *          pBuf;
+  char *          pCBuf;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  SCompressCol    cols[];
+} SCompressJob;
+
+static SCompressJob *tsdbNewCompressJob(int maxCols, int rows, int8_t comp) {
+  SCompressJob *pJob = (SCompressJob *)calloc(1, sizeof(SCompressJob) + sizeof(SCompressCol) * maxCols);
+  if (pJob == NULL) {
+    return NULL;
+  }
+
+  pJob->ref = 1;
+  pJob->rows = rows;
+  pJob->comp = comp;
+  pthread_mutex_init(&pJob->mutex, NULL);
+  pthread_cond_init(&pJob->cond, NULL);
+
+  return pJob;
+}
+
+static void tsdbUnrefCompressJob(SCompressJob *pJob) {
+  if (atomic_sub_fetch_32(&pJob->ref, 1) > 0) {
+    return;
+  }
+
+  pthread_cond_destroy(&pJob->cond);
+  pthread_mutex_destroy(&pJob->mutex);
+  free(pJob);
+}
+
+static void tsdbAddCompressCol(SCompressJob *pJob, SDataCol *pDataCol, int32_t tlen, int32_t offset) {
+  SCompressCol *pCol = pJob->cols + pJob->ncols;
+
+  pCol->pDataCol = pDataCol;
+  pCol->tlen = tlen;
+  pCol->offset = (pJob->ncols == 0) ? offset : pJob->size;
+  pCol->coffset = pJob->csize;
+
+  pJob->size = pCol->offset + tlen + COMP_OVERFLOW_BYTES + sizeof(TSCKSUM);
+  pJob->csize = pCol->coffset + tlen + COMP_OVERFLOW_BYTES;
+  pJob->bytes += tlen;
+  pJob->ncols++;
+}
+
+static void tsdbCompressCol(SCompressJob *pJob, SCompressCol *pCol) {
+  SDataCol *pDataCol = pCol->pDataCol;
+  char *    tptr = pJob->pBuf + pCol->offset;
+  int32_t   flen;
+
+  if (pJob->comp) {
+    flen = (*(tDataTypes[pDataCol->type].compFunc))((char *)pDataCol->pData, pCol->tlen, pJob->rows, tptr,
+                                                    pCol->tlen + COMP_OVERFLOW_BYTES, pJob->comp,
+                                                    (pJob->pCBuf == NULL) ? NULL : pJob->pCBuf + pCol->coffset,
+                                                    pCol->tlen + COMP_OVERFLOW_BYTES);
+  } else {
+    flen = pCol->tlen;
+    memcpy(tptr, pDataCol->pData, flen);
+  }
+
+  // Add checksum
+  ASSERT(flen > 0);
+  flen += sizeof(TSCKSUM);
+  taosCalcChecksumAppend(0, (uint8_t *)tptr, flen);
+  pCol->flen = flen;
+}
+
+static void tsdbCompressNextCols(SCompressJob *pJob) {
+  int32_t nfinished = 0;
+  int32_t idx;
+
+  while ((idx = atomic_fetch_add_32(&pJob->next, 1)) < pJob->ncols) {
+    tsdbCompressCol(pJob, pJob->cols + idx);
+    nfinished++;
+  }
+
+  if (nfinished > 0) {
+    pthread_mutex_lock(&pJob->mutex);
+    pJob->nfinished += nfinished;
+    if (pJob->nfinished == pJob->ncols) {
+      pthread_cond_signal(&pJob->cond);
+    }
+    pthread_mutex_unlock(&pJob->mutex);
+  }
+}
+
+static void tsdbCompressWork(SSchedMsg *pMsg) {
+  SCompressJob *pJob = (SCompressJob *)pMsg->ahandle;
+
+  tsdbCompressNextCols(pJob);
+  tsdbUnrefCompressJob(pJob);
+}
+
+static void tsdbCompressCols(SCompressJob *pJob, void *pBuf, void *pCBuf) {
+  pJob->pBuf = (char *)pBuf;
+  pJob->pCBuf = (char *)pCBuf;
+
+  // small blocks are not worth the hand-off to the workers
+  int nworkers = tsdbNumOfCompressWorkers();
+  if (pJob->bytes >= TSDB_MIN_PARALLEL_COMPRESS_BYTES) {
+    nworkers = MIN(nworkers, pJob->ncols - 1);
+  } else {
+    nworkers = 0;
+  }
+
+  for (int i = 0; i < nworkers; i++) {
+    SSchedMsg msg = {0};
+    msg.fp = tsdbCompressWork;
+    msg.ahandle = pJob;
+
+    atomic_add_fetch_32(&pJob->ref, 1);
+    tsdbScheduleCompressWork(&msg);
+  }
+
+  tsdbCompressNextCols(pJob);
+
+  pthread_mutex_lock(&pJob->mutex);
+  while (pJob->nfinished < pJob->ncols) {
+    pthread_cond_wait(&pJob->cond, &pJob->mutex);
+  }
+  pthread_mutex_unlock(&pJob->mutex);
+}
+
 int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile *pDFileAggr, SDataCols *pDataCols,
                        SBlock *pBlock, bool isLast, bool isSuper, void **ppBuf, void **ppCBuf, void **ppExBuf) {
   STsdbCfg *  pCfg = REPO_CFG(pRepo);
@@ -1132,9 +1372,16 @@ int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile
   int32_t  tsize = (int32_t)tsdbBlockStatisSize(nColsNotAllNull, SBlockVerLatest);
   int32_t  lsize = tsize;
   int32_t  keyLen = 0;
+  int64_t  stime = taosGetTimestampUs();
 
   uint32_t tsizeAggr = (uint32_t)tsdbBlockAggrSize(nColsNotAllNull, SBlockVerLatest);
 
+  SCompressJob *pJob = tsdbNewCompressJob(nColsNotAllNull + 1, rowsToWrite, pCfg->compression);
+  if (pJob == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
   for (int ncol = 0; ncol < pDataCols->numOfCols; ncol++) {
     // All not NULL columns finish
     if (ncol != 0 && tcol >= nColsNotAllNull) break;
@@ -1144,43 +1391,37 @@ int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile
 
     if (ncol != 0 && (pDataCol->colId != pBlockCol->colId)) continue;
 
-    int32_t flen;  // final length
-    int32_t tlen = dataColGetNEleLen(pDataCol, rowsToWrite);
-    void *  tptr;
-
-    // Make room
-    if (tsdbMakeRoom(ppBuf, lsize + tlen + COMP_OVERFLOW_BYTES + sizeof(TSCKSUM)) < 0) {
-      return -1;
+    tsdbAddCompressCol(pJob, pDataCol, dataColGetNEleLen(pDataCol, rowsToWrite), lsize);
+    if (ncol != 0) {
+      tcol++;
     }
-    pBlockData = (SBlockData *)(*ppBuf);
-    pBlockCol = pBlockData->cols + tcol;
-    tptr = POINTER_SHIFT(pBlockData, lsize);
+  }
 
-    if (pCfg->compression == TWO_STAGE_COMP &&
-        tsdbMakeRoom(ppCBuf, tlen + COMP_OVERFLOW_BYTES) < 0) {
-      return -1;
-    }
+  // Make room, every column is compressed to its own area of the buffer, so they can be done in parallel
+  if (tsdbMakeRoom(ppBuf, pJob->size) < 0 ||
+      (pCfg->compression == TWO_STAGE_COMP && tsdbMakeRoom(ppCBuf, pJob->csize) < 0)) {
+    tsdbUnrefCompressJob(pJob);
+    return -1;
+  }
+  pBlockData = (SBlockData *)(*ppBuf);
 
-    // Compress or just copy
-    if (pCfg->compression) {
-      flen = (*(tDataTypes[pDataCol->type].compFunc))((char *)pDataCol->pData, tlen, rowsToWrite, tptr,
-                                                      tlen + COMP_OVERFLOW_BYTES, pCfg->compression, *ppCBuf,
-                                                      tlen + COMP_OVERFLOW_BYTES);
-    } else {
-      flen = tlen;
-      memcpy(tptr, pDataCol->pData, flen);
-    }
+  tsdbCompressCols(pJob, *ppBuf, (pCfg->compression == TWO_STAGE_COMP) ? *ppCBuf : NULL);
+
+  // Pack the compressed columns in order
+  for (tcol = 0; tcol < pJob->ncols; tcol++) {
+    SCompressCol *pCol = pJob->cols + tcol;
+    int32_t       flen = pCol->flen;
+    void *        tptr = POINTER_SHIFT(pBlockData, lsize);
 
-    // Add checksum
-    ASSERT(flen > 0);
-    flen += sizeof(TSCKSUM);
-    taosCalcChecksumAppend(0, (uint8_t *)tptr, flen);
+    if (pCol->offset != lsize) {
+      memmove(tptr, POINTER_SHIFT(pBlockData, pCol->offset), flen);
+    }
     tsdbUpdateDFileMagic(pDFile, POINTER_SHIFT(tptr, flen - sizeof(TSCKSUM)));
 
-    if (ncol != 0) {
+    if (tcol != 0) {
+      SBlockCol *pBlockCol = pBlockData->cols + tcol - 1;
       tsdbSetBlockColOffset(pBlockCol, toffset);
       pBlockCol->len = flen;
-      tcol++;
     } else {
       keyLen = flen;
     }
@@ -1189,6 +1430,8 @@ int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile
     lsize += flen;
   }
 
+  tsdbUnrefCompressJob(pJob);
+
   pBlockData->delimiter = TSDB_FILE_DELIMITER;
   pBlockData->uid = TABLE_UID(pTable);
   pBlockData->numOfCols = nColsNotAllNull;
@@ -1196,23 +1439,44 @@ int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile
   taosCalcChecksumAppend(0, (uint8_t *)pBlockData, tsize);
   tsdbUpdateDFileMagic(pDFile, POINTER_SHIFT(pBlockData, tsize - sizeof(TSCKSUM)));
 
+  int64_t wtime = taosGetTimestampUs();
+  pRepo->commitStat.compressTime += wtime - stime;
+
   // Write the whole block to file
   if (tsdbAppendDFile(pDFile, (void *)pBlockData, lsize, &offset) < lsize) {
     return -1;
   }
+  pRepo->commitStat.writeTime += taosGetTimestampUs() - wtime;
 
   uint32_t aggrStatus = nColsNotAllNull > 0 ? 1 : 0;
+  uint32_t tsizeBloom = 0;
   if (aggrStatus > 0) {
+    // The bloom filter part is appended right behind the aggr part
+    if (tsdbBloomFilterBits > 0 && tsdbBuildBlockBloom(pDataCols, rowsToWrite, ppExBuf, tsizeAggr, &tsizeBloom) < 0) {
+      return -1;
+    }
+    pAggrBlkData = (SAggrBlkData *)(*ppExBuf);
 
     taosCalcChecksumAppend(0, (uint8_t *)pAggrBlkData, tsizeAggr);
     tsdbUpdateDFileMagic(pDFileAggr, POINTER_SHIFT(pAggrBlkData, tsizeAggr - sizeof(TSCKSUM)));
 
+    if (tsizeBloom > 0) {
+      void *pBloomBlkData = POINTER_SHIFT(pAggrBlkData, tsizeAggr);
+      taosCalcChecksumAppend(0, (uint8_t *)pBloomBlkData, tsizeBloom);
+      tsdbUpdateDFileMagic(pDFileAggr, POINTER_SHIFT(pBloomBlkData, tsizeBloom - sizeof(TSCKSUM)));
+    }
+
     // Write the whole block to file
-    if (tsdbAppendDFile(pDFileAggr, (void *)pAggrBlkData, tsizeAggr, &offsetAggr) < tsizeAggr) {
+    wtime = taosGetTimestampUs();
+    if (tsdbAppendDFile(pDFileAggr, (void *)pAggrBlkData, tsizeAggr + tsizeBloom, &offsetAggr) <
+        tsizeAggr + tsizeBloom) {
       return -1;
     }
+    pRepo->commitStat.writeTime += taosGetTimestampUs() - wtime;
   }
 
+  pRepo->commitStat.nBlocks++;
+
   // Update pBlock membership variables
   pBlock->last = isLast;
   pBlock->offset = offset;
@@ -1226,7 +1490,7 @@ int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile
   pBlock->keyLast = dataColsKeyLast(pDataCols);
   // since blkVer1
   pBlock->aggrStat = aggrStatus;
-  pBlock->blkVer = SBlockVerLatest;
+  pBlock->blkVer = (tsizeBloom > 0) ? TSDB_SBLK_VER_2 : SBlockVerLatest;
   pBlock->aggrOffset = (uint64_t)offsetAggr;
 
   tsdbDebug("vgId:%d tid:%d a block of data is written to file %s, offset %" PRId64
@@ -1267,6 +1531,34 @@ static int tsdbWriteBlockInfo(SCommitH *pCommih) {
   return 0;
 }
 
+static int tsdbCommitLoadBlockInfo(SCommitH *pCommith) {
+  STsdbRepo *pRepo = TSDB_COMMIT_REPO(pCommith);
+  int64_t    stime = taosGetTimestampUs();
+  int        code = tsdbLoadBlockInfo(&(pCommith->readh), NULL, NULL);
+
+  pRepo->commitStat.loadTime += taosGetTimestampUs() - stime;
+  return code;
+}
+
+static int tsdbCommitLoadBlockData(SCommitH *pCommith, SBlock *pBlock) {
+  STsdbRepo *pRepo = TSDB_COMMIT_REPO(pCommith);
+  int64_t    stime = taosGetTimestampUs();
+  int        code = tsdbLoadBlockData(&(pCommith->readh), pBlock, NULL);
+
+  pRepo->commitStat.loadTime += taosGetTimestampUs() - stime;
+  return code;
+}
+
+static int tsdbCommitLoadBlockKeys(SCommitH *pCommith, SBlock *pBlock) {
+  STsdbRepo *pRepo = TSDB_COMMIT_REPO(pCommith);
+  int16_t    colId = 0;
+  int64_t    stime = taosGetTimestampUs();
+  int        code = tsdbLoadBlockDataCols(&(pCommith->readh), pBlock, NULL, &colId, 1);
+
+  pRepo->commitStat.loadTime += taosGetTimestampUs() - stime;
+  return code;
+}
+
 static int tsdbCommitMemData(SCommitH *pCommith, SCommitIter *pIter, TSKEY keyLimit, bool toData) {
   STsdbRepo *pRepo = TSDB_COMMIT_REPO(pCommith);
   STsdbCfg * pCfg = REPO_CFG(pRepo);
@@ -1306,7 +1598,6 @@ static int tsdbMergeMemData(SCommitH *pCommith, SCommitIter *pIter, int bidx) {
   int        nBlocks = pCommith->readh.pBlkIdx->numOfBlocks;
   SBlock *   pBlock = pCommith->readh.pBlkInfo->blocks + bidx;
   TSKEY      keyLimit;
-  int16_t    colId = 0;
   SMergeInfo mInfo;
   SBlock     subBlocks[TSDB_MAX_SUBBLOCKS];
   SBlock     block, supBlock;
@@ -1318,8 +1609,16 @@ static int tsdbMergeMemData(SCommitH *pCommith, SCommitIter *pIter, int bidx) {
     keyLimit = pBlock[1].keyFirst - 1;
   }
 
+  if (tsdbTombsOverlap(pCommith->pTombs, pCommith->numOfTombs, pBlock->keyFirst, pBlock->keyLast)) {
+    // Merge the rows left after the delete with the memory data
+    if (tsdbCommitLoadBlockData(pCommith, pBlock) < 0) return -1;
+    tsdbFilterTombRows(pCommith->pTombs, pCommith->numOfTombs, &(pCommith->readh.pDCols[0]),
+                       &(pCommith->readh.pDCols[1]));
+    return tsdbMergeBlockData(pCommith, pIter, pCommith->readh.pDCols[0], keyLimit, bidx == (nBlocks - 1));
+  }
+
   SSkipListIterator titer = *(pIter->pIter);
-  if (tsdbLoadBlockDataCols(&(pCommith->readh), pBlock, NULL, &colId, 1) < 0) return -1;
+  if (tsdbCommitLoadBlockKeys(pCommith, pBlock) < 0) return -1;
 
   tsdbLoadDataFromCache(pIter->pTable, &titer, keyLimit, INT32_MAX, NULL, pCommith->readh.pDCols[0]->cols[0].pData,
                         pCommith->readh.pDCols[0]->numOfRows, pCfg->update, &mInfo);
@@ -1364,7 +1663,7 @@ static int tsdbMergeMemData(SCommitH *pCommith, SCommitIter *pIter, int bidx) {
 
     if (tsdbCommitAddBlock(pCommith, &supBlock, subBlocks, supBlock.numOfSubBlocks) < 0) return -1;
   } else {
-    if (tsdbLoadBlockData(&(pCommith->readh), pBlock, NULL) < 0) return -1;
+    if (tsdbCommitLoadBlockData(pCommith, pBlock) < 0) return -1;
     if (tsdbMergeBlockData(pCommith, pIter, pCommith->readh.pDCols[0], keyLimit, bidx == (nBlocks - 1)) < 0) return -1;
   }
 
@@ -1387,6 +1686,20 @@ static int tsdbMoveBlock(SCommitH *pCommith, int bidx) {
     isSameFile = pCommith->isDFileSame;
   }
 
+  if (tsdbTombsOverlap(pCommith->pTombs, pCommith->numOfTombs, pBlock->keyFirst, pBlock->keyLast)) {
+    // Rewrite the rows left after the delete, the block is dropped if all of them are deleted
+    if (tsdbTombsCover(pCommith->pTombs, pCommith->numOfTombs, pBlock->keyFirst, pBlock->keyLast)) return 0;
+
+    if (tsdbCommitLoadBlockData(pCommith, pBlock) < 0) return -1;
+    tsdbFilterTombRows(pCommith->pTombs, pCommith->numOfTombs, &(pCommith->readh.pDCols[0]),
+                       &(pCommith->readh.pDCols[1]));
+    if (pCommith->readh.pDCols[0]->numOfRows == 0) return 0;
+
+    if (tsdbWriteBlock(pCommith, pDFile, pCommith->readh.pDCols[0], &block, pBlock->last, true) < 0) return -1;
+    if (tsdbCommitAddBlock(pCommith, &block, NULL, 0) < 0) return -1;
+    return 0;
+  }
+
   if (isSameFile) {
     if (pBlock->numOfSubBlocks == 1) {
       if (tsdbCommitAddBlock(pCommith, pBlock, NULL, 0) < 0) {
@@ -1402,7 +1715,7 @@ static int tsdbMoveBlock(SCommitH *pCommith, int bidx) {
       }
     }
   } else {
-    if (tsdbLoadBlockData(&(pCommith->readh), pBlock, NULL) < 0) return -1;
+    if (tsdbCommitLoadBlockData(pCommith, pBlock) < 0) return -1;
     if (tsdbWriteBlock(pCommith, pDFile, pCommith->readh.pDCols[0], &block, pBlock->last, true) < 0) return -1;
     if (tsdbCommitAddBlock(pCommith, &block, NULL, 0) < 0) return -1;
   }
@@ -14,6 +14,7 @@
  */
 
 #include "tsdbint.h"
+#include "tsched.h"
 
 typedef struct {
   bool            stop;
@@ -34,6 +35,7 @@ typedef struct {
 static void *tsdbLoopCommit(void *arg);
 
 static SCommitQueue tsCommitQueue = {0};
+static void *       tsCommitCompressPool = NULL;
 
 int tsdbInitCommitQueue() {
   int nthreads = tsNumOfCommitThreads;
@@ -64,6 +66,15 @@ int tsdbInitCommitQueue() {
     pthread_create(pQueue->threads + i, NULL, tsdbLoopCommit, NULL);
   }
 
+  // the commit threads compress the columns by themselves if the pool fails to start
+  if (tsNumOfCommitCompressThreads > 0) {
+    tsCommitCompressPool =
+        taosInitScheduler(tsNumOfCommitCompressThreads * nthreads, tsNumOfCommitCompressThreads, "tsdbCompress");
+    if (tsCommitCompressPool == NULL) {
+      tsdbWarn("failed to start %d threads to compress the committed blocks", tsNumOfCommitCompressThreads);
+    }
+  }
+
   return 0;
 }
 
@@ -86,6 +97,11 @@ void tsdbDestroyCommitQueue() {
     pthread_join(pQueue->threads[i], NULL);
   }
 
+  if (tsCommitCompressPool != NULL) {
+    taosCleanUpScheduler(tsCommitCompressPool);
+    tsCommitCompressPool = NULL;
+  }
+
   free(pQueue->threads);
   tdListFree(pQueue->queue);
   pthread_cond_destroy(&(pQueue->queueNotEmpty));
@@ -116,6 +132,10 @@ int tsdbScheduleCommit(STsdbRepo *pRepo, void *param, TSDB_REQ_T req) {
   return 0;
 }
 
+int tsdbNumOfCompressWorkers() { return (tsCommitCompressPool == NULL) ? 0 : tsNumOfCommitCompressThreads; }
+
+void tsdbScheduleCompressWork(SSchedMsg *pMsg) { taosScheduleTask(tsCommitCompressPool, pMsg); }
+
 static void tsdbApplyRepoConfig(STsdbRepo *pRepo) {
   pthread_mutex_lock(&pRepo->save_mutex);
 
@@ -192,6 +212,8 @@ static void *tsdbLoopCommit(void *arg) {
       tsdbCommitData(pRepo, true);
     } else if (req == COMPACT_REQ) {
       tsdbCompactImpl(pRepo);
+    } else if (req == AUTO_COMPACT_REQ) {
+      tsdbAutoCompactImpl(pRepo);
     } else if (req == COMMIT_BOTH_REQ) {
       SControlDataInfo* pCtlDataInfo = (SControlDataInfo* )param;
       if(!pCtlDataInfo->memNull) {
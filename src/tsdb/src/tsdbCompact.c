@@ -13,6 +13,7 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 #include "tsdbint.h"
+#include "tsdbHealth.h"
 
 typedef struct {
   STable *    pTable;
@@ -30,8 +31,34 @@ typedef struct {
   SArray *   aBlkIdx;
   SArray *   aSupBlk;
   SDataCols *pDataCols;
+  TSKEY      minKey;  // key range of the FSET
+  TSKEY      maxKey;
+  bool       hasTombs;  // the FSET has deleted rows to remove
+  bool       background;
+  bool       paused;     // the background compaction of the FSET is given up for the memory pressure
+  int64_t    startTime;  // us, when the compaction of the FSET starts
+  int64_t    bytesRead;
 } SCompactH;
 
+typedef struct {
+  int      fid;
+  uint32_t magic;  // of the head file, the FSET is changed if it is not the same
+  uint64_t size;
+  float    score;
+} SCompactScore;
+
+/*
+ * A FSET scored 1 or more is to compact, each ratio reaching its limit scores 1:
+ *   sub-blocks:   blocks with sub-blocks out of all the blocks
+ *   small blocks: blocks with less than the default rows out of all the blocks
+ *   last file:    size of the last file not referred by the blocks in it out of the last file
+ *   garbage:      size of the data and last files not referred by any block
+ */
+#define TSDB_COMPACT_SUB_BLOCK_RATIO 0.33
+#define TSDB_COMPACT_SMALL_BLOCK_RATIO 0.33
+#define TSDB_COMPACT_LAST_FILE_RATIO 0.33
+#define TSDB_COMPACT_GARBAGE_RATIO 0.15
+
 #define TSDB_COMPACT_WSET(pComph) (&((pComph)->wSet))
 #define TSDB_COMPACT_REPO(pComph) TSDB_READ_REPO(&((pComph)->readh))
 #define TSDB_COMPACT_HEAD_FILE(pComph) TSDB_DFILE_IN_SET(TSDB_COMPACT_WSET(pComph), TSDB_FILE_HEAD)
@@ -43,13 +70,20 @@ typedef struct {
 #define TSDB_COMPACT_COMP_BUF(pComph) TSDB_READ_COMP_BUF(&((pComph)->readh))
 #define TSDB_COMPACT_EXBUF(pComph) TSDB_READ_EXBUF(&((pComph)->readh))
 
-static int  tsdbAsyncCompact(STsdbRepo *pRepo);
-static void tsdbStartCompact(STsdbRepo *pRepo);
-static void tsdbEndCompact(STsdbRepo *pRepo, int eno);
-static int  tsdbCompactMeta(STsdbRepo *pRepo);
-static int  tsdbCompactTSData(STsdbRepo *pRepo);
-static int  tsdbCompactFSet(SCompactH *pComph, SDFileSet *pSet);
-static bool tsdbShouldCompact(SCompactH *pComph);
+static int   tsdbAsyncCompact(STsdbRepo *pRepo, TSDB_REQ_T req);
+static void *tsdbCompactRepo(STsdbRepo *pRepo, bool background);
+static void  tsdbStartCompact(STsdbRepo *pRepo);
+static void  tsdbEndCompact(STsdbRepo *pRepo, int eno);
+static int   tsdbCompactMeta(STsdbRepo *pRepo);
+static int   tsdbCompactTSData(STsdbRepo *pRepo, bool background);
+static int   tsdbCompactFSet(SCompactH *pComph, SDFileSet *pSet);
+static bool  tsdbShouldCompact(SCompactH *pComph);
+static float tsdbCompactScore(SCompactH *pComph);
+static int   tsdbPickFSetToCompact(SCompactH *pComph, int *fid);
+static void  tsdbResetCompactScore(STsdbRepo *pRepo, SDFileSet *pSet);
+static bool  tsdbCompactGoOn(SCompactH *pComph, int64_t bytes);
+static void  tsdbPaceCompact(SCompactH *pComph);
+static bool  tsdbFSetHasTombs(STsdbRepo *pRepo, TSKEY minKey, TSKEY maxKey);
 static int  tsdbInitCompactH(SCompactH *pComph, STsdbRepo *pRepo);
 static void tsdbDestroyCompactH(SCompactH *pComph);
 static int  tsdbInitCompTbArray(SCompactH *pComph);
@@ -62,9 +96,47 @@ static int  tsdbWriteBlockToRightFile(SCompactH *pComph, STable *pTable, SDataCo
                                       void **ppCBuf, void **ppExBuf);
 
 enum { TSDB_NO_COMPACT, TSDB_IN_COMPACT, TSDB_WAITING_COMPACT};
-int tsdbCompact(STsdbRepo *pRepo) { return tsdbAsyncCompact(pRepo); }
+int tsdbCompact(STsdbRepo *pRepo) { return tsdbAsyncCompact(pRepo, COMPACT_REQ); }
+
+// compact the most fragmented FSET in the background, put off if a commit is due
+int tsdbAutoCompact(STsdbRepo *pRepo) {
+  if (pRepo->compactState != TSDB_NO_COMPACT) {
+    return 0;
+  }
+
+  // Nothing to compact since the FSETs are scored
+  if (pRepo->compactScores != NULL && pRepo->compactStat.numOfDebtFSets == 0 &&
+      pRepo->compactVersion == FS_VERSION(REPO_FS(pRepo))) {
+    return 0;
+  }
+
+  if (tsdbMemPressure(pRepo)) {
+    pRepo->compactStat.numOfPaused++;
+    tsdbDebug("vgId:%d background compaction is put off for the memory pressure", REPO_ID(pRepo));
+    return 0;
+  }
+
+  // The read budget is kept here, out of the commit slot
+  int64_t now = taosGetTimestampUs();
+  if (tsCompactMBps > 0 && now < pRepo->compactNextTime) {
+    tsdbDebug("vgId:%d background compaction is put off for %" PRId64 " us for the read budget", REPO_ID(pRepo),
+              pRepo->compactNextTime - now);
+    return 0;
+  }
+
+  return tsdbAsyncCompact(pRepo, AUTO_COMPACT_REQ);
+}
+
+void tsdbGetCompactStat(STsdbRepo *pRepo, STsdbCompactStat *pStat) {
+  *pStat = pRepo->compactStat;
+  pStat->state = pRepo->compactState;
+}
+
+void *tsdbCompactImpl(STsdbRepo *pRepo) { return tsdbCompactRepo(pRepo, false); }
 
-void *tsdbCompactImpl(STsdbRepo *pRepo) {
+void *tsdbAutoCompactImpl(STsdbRepo *pRepo) { return tsdbCompactRepo(pRepo, true); }
+
+static void *tsdbCompactRepo(STsdbRepo *pRepo, bool background) {
   // Check if there are files in TSDB FS to compact
   if (REPO_FS(pRepo)->cstatus->pmf == NULL) {
     pRepo->compactState = TSDB_NO_COMPACT;
@@ -80,7 +152,7 @@ void *tsdbCompactImpl(STsdbRepo *pRepo) {
     goto _err;
   }
 
-  if (tsdbCompactTSData(pRepo) < 0) {
+  if (tsdbCompactTSData(pRepo, background) < 0) {
     tsdbError("vgId:%d failed to compact TS data since %s", REPO_ID(pRepo), tstrerror(terrno));
     goto _err;
   }
@@ -94,15 +166,16 @@ _err:
   return NULL;
 }
 
-static int tsdbAsyncCompact(STsdbRepo *pRepo) {
-  if (pRepo->compactState != TSDB_NO_COMPACT) {
+static int tsdbAsyncCompact(STsdbRepo *pRepo, TSDB_REQ_T req) {
+  // the background compaction may be scheduled at the same time
+  if (atomic_val_compare_exchange_8(&pRepo->compactState, TSDB_NO_COMPACT, TSDB_WAITING_COMPACT) != TSDB_NO_COMPACT) {
     tsdbInfo("vgId:%d not compact tsdb again ", REPO_ID(pRepo));
     return 0;
   }
-  pRepo->compactState = TSDB_WAITING_COMPACT;
   tsem_wait(&(pRepo->readyToCommit));
-  int code = tsdbScheduleCommit(pRepo, NULL, COMPACT_REQ);
+  int code = tsdbScheduleCommit(pRepo, NULL, req);
   if (code != 0) {
+    pRepo->compactState = TSDB_NO_COMPACT;
     tsem_post(&(pRepo->readyToCommit));
   }
   return code;
@@ -121,6 +194,8 @@ static void tsdbEndCompact(STsdbRepo *pRepo, int eno) {
     tsdbEndFSTxnWithError(REPO_FS(pRepo));
   } else {
     tsdbEndFSTxn(pRepo);
+    // The background compaction is not scheduled until the FS is changed again
+    if (pRepo->compactStat.numOfDebtFSets == 0) pRepo->compactVersion = FS_VERSION(REPO_FS(pRepo));
   }
   pRepo->compactState = TSDB_NO_COMPACT;
   tsdbInfo("vgId:%d compact over, %s", REPO_ID(pRepo), (eno == TSDB_CODE_SUCCESS) ? "succeed" : "failed");
@@ -133,9 +208,10 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
   return 0;
 }
 
-  static int tsdbCompactTSData(STsdbRepo *pRepo) {
+  static int tsdbCompactTSData(STsdbRepo *pRepo, bool background) {
     SCompactH  compactH;
     SDFileSet *pSet = NULL;
+    int        fid = TSDB_IVLD_FID;
 
     tsdbDebug("vgId:%d start to compact TS data", REPO_ID(pRepo));
 
@@ -149,11 +225,21 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
       return -1;
     }
 
+    // Only the FSET scored the highest is compacted in the background, the others are kept
+    compactH.background = background;
+    if (background && tsdbPickFSetToCompact(&compactH, &fid) < 0) {
+      tsdbDestroyCompactH(&compactH);
+      return -1;
+    }
+
     while ((pSet = tsdbFSIterNext(&(compactH.fsIter)))) {
       // Remove those expired files
       if (pSet->fid < compactH.rtn.minFid) {
         tsdbInfo("vgId:%d FSET %d on level %d disk id %d expires, remove it", REPO_ID(pRepo), pSet->fid,
                 TSDB_FSET_LEVEL(pSet), TSDB_FSET_ID(pSet));
+        tsdbGetFidKeyRange(REPO_CFG(pRepo)->daysPerFile, REPO_CFG(pRepo)->precision, pSet->fid, &compactH.minKey,
+                           &compactH.maxKey);
+        tsdbDropTombs(REPO_FS(pRepo)->nstatus->tombs, compactH.minKey, compactH.maxKey);
         continue;
       }
 
@@ -163,6 +249,14 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
         continue;
       }
 
+      if (background && pSet->fid != fid) {
+        if (tsdbApplyRtnOnFSet(pRepo, pSet, &(compactH.rtn)) < 0) {
+          tsdbDestroyCompactH(&compactH);
+          return -1;
+        }
+        continue;
+      }
+
       if (tsdbCompactFSet(&compactH, pSet) < 0) {
         tsdbDestroyCompactH(&compactH);
         tsdbError("vgId:%d failed to compact FSET %d since %s", REPO_ID(pRepo), pSet->fid, tstrerror(terrno));
@@ -186,7 +280,7 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
       return -1;
     }
 
-    if (!tsdbShouldCompact(pComph)) {
+    if (!pComph->background && !tsdbShouldCompact(pComph)) {
       tsdbDebug("vgId:%d no need to compact FSET %d", REPO_ID(pRepo), pSet->fid);
       if (tsdbApplyRtnOnFSet(TSDB_COMPACT_REPO(pComph), pSet, &(pComph->rtn)) < 0) {
         tsdbCompactFSetEnd(pComph);
@@ -218,8 +312,26 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
       }
 
       tsdbCloseDFileSet(TSDB_COMPACT_WSET(pComph));
-      tsdbUpdateDFileSet(REPO_FS(pRepo), TSDB_COMPACT_WSET(pComph));
-      tsdbDebug("vgId:%d FSET %d compact over", REPO_ID(pRepo), pSet->fid);
+      if (pComph->background) tsdbPaceCompact(pComph);
+
+      if (pComph->paused) {
+        // Keep the FSET as it is, it is to compact in the next round
+        tsdbRemoveDFileSet(TSDB_COMPACT_WSET(pComph));
+        tsdbUpdateDFileSet(REPO_FS(pRepo), pSet);
+        pRepo->compactStat.numOfPaused++;
+        tsdbInfo("vgId:%d FSET %d compaction is given up for the memory pressure after %" PRId64 " bytes read",
+                 REPO_ID(pRepo), pSet->fid, pComph->bytesRead);
+      } else {
+        tsdbUpdateDFileSet(REPO_FS(pRepo), TSDB_COMPACT_WSET(pComph));
+        tsdbDropTombs(REPO_FS(pRepo)->nstatus->tombs, pComph->minKey, pComph->maxKey);
+        if (pComph->background) {
+          pRepo->compactStat.compactedFSets++;
+          pRepo->compactStat.compactedBytes += pComph->bytesRead;
+          tsdbResetCompactScore(pRepo, TSDB_COMPACT_WSET(pComph));
+        }
+        tsdbDebug("vgId:%d FSET %d compact over, %" PRId64 " bytes read in %" PRId64 " us", REPO_ID(pRepo), pSet->fid,
+                  pComph->bytesRead, taosGetTimestampUs() - pComph->startTime);
+      }
     }
 
     tsdbCompactFSetEnd(pComph);
@@ -227,9 +339,14 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
   }
 
   static bool tsdbShouldCompact(SCompactH *pComph) {
-    if (tsdbForceCompactFile) {
+    if (tsdbForceCompactFile || pComph->hasTombs) {
       return true;
     }
+
+    return tsdbCompactScore(pComph) >= 1.0;
+  }
+
+  static float tsdbCompactScore(SCompactH *pComph) {
     STsdbRepo *     pRepo = TSDB_COMPACT_REPO(pComph);
     STsdbCfg *      pCfg = REPO_CFG(pRepo);
     SReadH *        pReadh = &(pComph->readh);
@@ -241,8 +358,10 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
 
     int     tblocks = 0;       // total blocks
     int     nSubBlocks = 0;    // # of blocks with sub-blocks
-    int     nSmallBlocks = 0;  // # of blocks with rows < defaultRows
+    int     nSmallBlocks = 0;  // # of blocks with rows < defaultRows, except the tail block of each table
     int64_t tsize = 0;
+    int64_t lsize = 0;         // size of the blocks in the last file
+    float   score = 0;
 
     for (size_t i = 0; i < taosArrayGetSize(pComph->tbArray); i++) {
       pTh = (STableCompactH *)taosArrayGet(pComph->tbArray, i);
@@ -253,7 +372,7 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
         tblocks++;
         pBlock = pTh->pInfo->blocks + bidx;
 
-        if (pBlock->numOfRows < defaultRows) {
+        if (pBlock->numOfRows < defaultRows && bidx + 1 < pTh->pBlkIdx->numOfBlocks) {
           nSmallBlocks++;
         }
 
@@ -262,17 +381,171 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
           for (int k = 0; k < pBlock->numOfSubBlocks; k++) {
             SBlock *iBlock = ((SBlock *)POINTER_SHIFT(pTh->pInfo, pBlock->offset)) + k;
             tsize = tsize + iBlock->len;
+            if (iBlock->last) lsize += iBlock->len;
           }
         } else if (pBlock->numOfSubBlocks == 1) {
           tsize += pBlock->len;
+          if (pBlock->last) lsize += pBlock->len;
         } else {
           ASSERT(0);
         }
       }
     }
 
-    return (((nSubBlocks * 1.0 / tblocks) > 0.33) || ((nSmallBlocks * 1.0 / tblocks) > 0.33) ||
-            (tsize * 1.0 / (pDataF->info.size + pLastF->info.size - 2 * TSDB_FILE_HEAD_SIZE) < 0.85));
+    if (tblocks > 0) {
+      score = MAX(score, (float)(nSubBlocks * 1.0 / tblocks / TSDB_COMPACT_SUB_BLOCK_RATIO));
+      score = MAX(score, (float)(nSmallBlocks * 1.0 / tblocks / TSDB_COMPACT_SMALL_BLOCK_RATIO));
+    }
+
+    // The last file is appended by each commit, the blocks replaced are left in it
+    int64_t lfsize = pLastF->info.size - TSDB_FILE_HEAD_SIZE;
+    if (lfsize > 0) {
+      score = MAX(score, (float)((1.0 - lsize * 1.0 / lfsize) / TSDB_COMPACT_LAST_FILE_RATIO));
+    }
+
+    int64_t fsize = pDataF->info.size + lfsize - TSDB_FILE_HEAD_SIZE;
+    if (fsize > 0) {
+      score = MAX(score, (float)((1.0 - tsize * 1.0 / fsize) / TSDB_COMPACT_GARBAGE_RATIO));
+    }
+
+    return score;
+  }
+
+  // Score the FSETs not scored yet or changed since, and pick the one scored the highest if it is to compact
+  static int tsdbPickFSetToCompact(SCompactH *pComph, int *fid) {
+    STsdbRepo *       pRepo = TSDB_COMPACT_REPO(pComph);
+    STsdbCompactStat *pStat = &(pRepo->compactStat);
+    SArray *          aScores = pRepo->compactScores;
+    SArray *          nScores;
+    SFSIter           fsIter;
+    SDFileSet *       pSet;
+    size_t            idx = 0;
+    float             maxScore = 0;
+
+    *fid = TSDB_IVLD_FID;
+
+    nScores = taosArrayInit(taosArrayGetSize(REPO_FS(pRepo)->cstatus->df), sizeof(SCompactScore));
+    if (nScores == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+
+    pStat->numOfFSets = 0;
+    pStat->numOfDebtFSets = 0;
+    pStat->debtBytes = 0;
+
+    tsdbFSIterInit(&fsIter, REPO_FS(pRepo), TSDB_FS_ITER_FORWARD);
+    while ((pSet = tsdbFSIterNext(&fsIter))) {
+      if (pSet->fid < pComph->rtn.minFid || TSDB_FSET_LEVEL(pSet) == TFS_MAX_LEVEL) continue;
+
+      SDFile *      pHeadF = TSDB_DFILE_IN_SET(pSet, TSDB_FILE_HEAD);
+      SCompactScore score = {.fid = pSet->fid, .magic = pHeadF->info.magic, .size = pHeadF->info.size};
+
+      // Both arrays are in the order of fid
+      while (aScores != NULL && idx < taosArrayGetSize(aScores) &&
+             ((SCompactScore *)taosArrayGet(aScores, idx))->fid < pSet->fid) {
+        idx++;
+      }
+
+      SCompactScore *pOld = (aScores != NULL && idx < taosArrayGetSize(aScores)) ? taosArrayGet(aScores, idx) : NULL;
+      if (pOld != NULL && pOld->fid == score.fid && pOld->magic == score.magic && pOld->size == score.size) {
+        score.score = pOld->score;
+      } else {
+        if (tsdbCompactFSetInit(pComph, pSet) < 0) {
+          taosArrayDestroy(&nScores);
+          return -1;
+        }
+        score.score = tsdbCompactScore(pComph);
+        tsdbCompactFSetEnd(pComph);
+      }
+
+      if (taosArrayPush(nScores, &score) == NULL) {
+        terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+        taosArrayDestroy(&nScores);
+        return -1;
+      }
+
+      // The FSET with rows deleted is always to compact
+      float fscore = score.score;
+      TSKEY minKey, maxKey;
+      tsdbGetFidKeyRange(REPO_CFG(pRepo)->daysPerFile, REPO_CFG(pRepo)->precision, pSet->fid, &minKey, &maxKey);
+      if (tsdbFSetHasTombs(pRepo, minKey, maxKey)) fscore = MAX(fscore, 1.0f);
+
+      pStat->numOfFSets++;
+      if (fscore >= 1.0) {
+        pStat->numOfDebtFSets++;
+        pStat->debtBytes += TSDB_DFILE_IN_SET(pSet, TSDB_FILE_DATA)->info.size +
+                            TSDB_DFILE_IN_SET(pSet, TSDB_FILE_LAST)->info.size;
+        if (fscore > maxScore) {
+          maxScore = fscore;
+          *fid = pSet->fid;
+        }
+      }
+    }
+
+    taosArrayDestroy(&(pRepo->compactScores));
+    pRepo->compactScores = nScores;
+    pStat->maxScore = maxScore;
+
+    if (*fid == TSDB_IVLD_FID) {
+      tsdbDebug("vgId:%d none of %d FSETs to compact", REPO_ID(pRepo), pStat->numOfFSets);
+    } else {
+      tsdbDebug("vgId:%d %d of %d FSETs to compact, %" PRId64 " bytes, FSET %d scored %f is picked", REPO_ID(pRepo),
+                pStat->numOfDebtFSets, pStat->numOfFSets, pStat->debtBytes, *fid, maxScore);
+    }
+    return 0;
+  }
+
+  // The FSET just compacted is not to compact again until it is changed by a commit
+  static void tsdbResetCompactScore(STsdbRepo *pRepo, SDFileSet *pSet) {
+    SDFile *pHeadF = TSDB_DFILE_IN_SET(pSet, TSDB_FILE_HEAD);
+
+    for (size_t i = 0; i < taosArrayGetSize(pRepo->compactScores); i++) {
+      SCompactScore *pScore = taosArrayGet(pRepo->compactScores, i);
+      if (pScore->fid == pSet->fid) {
+        pScore->magic = pHeadF->info.magic;
+        pScore->size = pHeadF->info.size;
+        pScore->score = 0;
+        break;
+      }
+    }
+  }
+
+  // The background compaction is given up if a commit is to wait for it. It is not slowed down here, it holds the
+  // commit slot
+  static bool tsdbCompactGoOn(SCompactH *pComph, int64_t bytes) {
+    pComph->bytesRead += bytes;
+    if (!pComph->background) {
+      return true;
+    }
+
+    if (tsdbMemPressure(TSDB_COMPACT_REPO(pComph))) {
+      pComph->paused = true;
+      return false;
+    }
+
+    return true;
+  }
+
+  // The next background compaction is put off until the bytes read by this one fit in the read budget
+  static void tsdbPaceCompact(SCompactH *pComph) {
+    STsdbRepo *pRepo = TSDB_COMPACT_REPO(pComph);
+
+    if (tsCompactMBps <= 0) return;
+    pRepo->compactNextTime = pComph->startTime + pComph->bytesRead * 1000000 / ((int64_t)tsCompactMBps * 1024 * 1024);
+  }
+
+  static bool tsdbFSetHasTombs(STsdbRepo *pRepo, TSKEY minKey, TSKEY maxKey) {
+    SArray *pTombs = REPO_FS(pRepo)->cstatus->tombs;
+
+    for (size_t i = 0; i < taosArrayGetSize(pTombs); i++) {
+      STsdbTomb *pTomb = (STsdbTomb *)taosArrayGet(pTombs, i);
+      if (pTomb->skey >= minKey && pTomb->skey <= maxKey) {
+        return true;
+      }
+    }
+
+    return false;
   }
 
   static int tsdbInitCompactH(SCompactH *pComph, STsdbRepo *pRepo) {
@@ -407,9 +680,18 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
   }
 
   static int tsdbCompactFSetInit(SCompactH *pComph, SDFileSet *pSet) {
+    STsdbRepo *pRepo = TSDB_COMPACT_REPO(pComph);
+
     taosArrayClear(pComph->aBlkIdx);
     taosArrayClear(pComph->aSupBlk);
 
+    tsdbGetFidKeyRange(REPO_CFG(pRepo)->daysPerFile, REPO_CFG(pRepo)->precision, pSet->fid, &(pComph->minKey),
+                       &(pComph->maxKey));
+    pComph->hasTombs = tsdbFSetHasTombs(pRepo, pComph->minKey, pComph->maxKey);
+    pComph->paused = false;
+    pComph->startTime = taosGetTimestampUs();
+    pComph->bytesRead = 0;
+
     if (tsdbSetAndOpenReadFSet(&(pComph->readh), pSet) < 0) {
       return -1;
     }
@@ -439,9 +721,13 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
     for (int tid = 1; tid < taosArrayGetSize(pComph->tbArray); tid++) {
       STableCompactH *pTh = (STableCompactH *)taosArrayGet(pComph->tbArray, tid);
       STSchema *      pSchema;
+      STsdbTomb *     pTombs;
+      int32_t         numOfTombs;
 
       if (pTh->pTable == NULL || pTh->pBlkIdx == NULL) continue;
 
+      pTombs = tsdbGetTableTombs(REPO_FS(pRepo)->cstatus->tombs, TABLE_UID(pTh->pTable), &numOfTombs);
+
       pSchema = tsdbGetTableSchemaImpl(pTh->pTable, true, true, -1, -1);
       taosArrayClear(pComph->aSupBlk);
       if ((tdInitDataCols(pComph->pDataCols, pSchema) < 0) || (tdInitDataCols(pReadh->pDCols[0], pSchema) < 0) ||
@@ -456,13 +742,30 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
       for (int i = 0; i < pTh->pBlkIdx->numOfBlocks; i++) {
         SBlock *pBlock = pTh->pInfo->blocks + i;
 
+        // Skip the block all deleted
+        if (tsdbTombsCover(pTombs, numOfTombs, pBlock->keyFirst, pBlock->keyLast)) continue;
+
         // Load the block data
         if (tsdbLoadBlockData(pReadh, pBlock, pTh->pInfo) < 0) {
           return -1;
         }
 
+        int64_t bytes = pBlock->len;
+        if (pBlock->numOfSubBlocks > 1) {
+          bytes = 0;
+          for (int k = 0; k < pBlock->numOfSubBlocks; k++) {
+            bytes += (((SBlock *)POINTER_SHIFT(pTh->pInfo, pBlock->offset)) + k)->len;
+          }
+        }
+        if (!tsdbCompactGoOn(pComph, bytes)) {
+          return 0;
+        }
+
+        // Remove the deleted rows
+        tsdbFilterTombRows(pTombs, numOfTombs, &(pReadh->pDCols[0]), &(pReadh->pDCols[1]));
+
         // Merge pComph->pDataCols and pReadh->pDCols[0] and write data to file
-        if (pComph->pDataCols->numOfRows == 0 && pBlock->numOfRows >= defaultRows) {
+        if (pComph->pDataCols->numOfRows == 0 && pReadh->pDCols[0]->numOfRows >= defaultRows) {
           if (tsdbWriteBlockToRightFile(pComph, pTh->pTable, pReadh->pDCols[0], ppBuf, ppCBuf, ppExBuf) < 0) {
             return -1;
           }
@@ -49,6 +49,9 @@ typedef struct {
   SControlDataInfo* pCtlInfo;
   SArray *   aUpdates;
   SArray *   aAffectTables;
+  SArray *   aTombs;      // STsdbTomb, the tombstones before the delete
+  STsdbTomb *pTombs;      // tombstones of the table being rewritten
+  int32_t    numOfTombs;
 } SDeleteH;
 
 
@@ -80,6 +83,10 @@ static int   tsdbBlockSolve(SDeleteH *pdh, SBlock *pBlock);
 static int   tsdbWriteBlockToFile(SDeleteH *pdh, STable *pTable, SDataCols *pDCols, void **ppBuf,
                                        void **ppCBuf, void **ppExBuf, SBlock * pBlock);
 static int   tsdbDeleteImplCommon(STsdbRepo *pRepo, SControlDataInfo* pCtlInfo);
+static int32_t tsdbSortDelTables(SDeleteH *pdh);
+static bool  tsdbRewriteHasTombs(SDeleteH *pdh, int fid, int32_t nRewrite);
+static void  tsdbDropRewriteTombs(SDeleteH *pdh, int fid, int32_t nRewrite);
+static int   tsdbFSetAddTombs(SDeleteH *pdh, SDFileSet *pSet, int32_t nRewrite);
 
 
 // delete
@@ -213,6 +220,10 @@ static int tsdbDeleteTSData(STsdbRepo *pRepo, SControlDataInfo* pCtlInfo, SArray
     return -1;
   }
 
+  // the tables in front of tids are rewritten, the others get tombstones
+  int32_t tnum = pCtlInfo->tnum;
+  int32_t nRewrite = tsdbSortDelTables(&deleteH);
+
   while ((pSet = tsdbFSIterNext(&(deleteH.fsIter)))) {
     // remove expired files
     if (pSet->fid < deleteH.rtn.minFid) {
@@ -221,22 +232,38 @@ static int tsdbDeleteTSData(STsdbRepo *pRepo, SControlDataInfo* pCtlInfo, SArray
       continue;
     }
 
-    if ((pSet->fid < sFid) || (pSet->fid > eFid)) {
-      tsdbDebug("vgId:%d :SDEL no need to delete FSET %d, sFid %d, eFid %d", REPO_ID(pRepo), pSet->fid, sFid, eFid);
-      if (tsdbApplyRtnOnFSet(pRepo, pSet, &(deleteH.rtn)) < 0) {
+    bool inDel = (pSet->fid >= sFid) && (pSet->fid <= eFid) && (pCtlInfo->command & CMD_DELETE_DATA);
+    if (inDel && nRewrite < tnum) {
+      if (tsdbFSetAddTombs(&deleteH, pSet, nRewrite) < 0) {
+        tsdbDestroyDeleteH(&deleteH);
+        tsdbError("vgId:%d :SDEL failed to add tombstones in FSET %d since %s", REPO_ID(pRepo), pSet->fid,
+                  tstrerror(terrno));
         return -1;
       }
-      continue;
+      numSet++;
     }
-    
-    if (pCtlInfo->command & CMD_DELETE_DATA) {
-      if (tsdbFSetDelete(&deleteH, pSet) < 0) {
+
+    // the file set is rewritten to delete the rows of the window, and the rows of the rewritten tables under
+    // tombstones, so that no tombstone of the tables is left
+    if (nRewrite == 0 || !(inDel || tsdbRewriteHasTombs(&deleteH, pSet->fid, nRewrite))) {
+      tsdbDebug("vgId:%d :SDEL no need to delete FSET %d, sFid %d, eFid %d", REPO_ID(pRepo), pSet->fid, sFid, eFid);
+      if (tsdbApplyRtnOnFSet(pRepo, pSet, &(deleteH.rtn)) < 0) {
         tsdbDestroyDeleteH(&deleteH);
-        tsdbError("vgId:%d :SDEL failed to delete data in FSET %d since %s", REPO_ID(pRepo), pSet->fid, tstrerror(terrno));
         return -1;
       }
-      numSet++;
+      continue;
     }
+
+    pCtlInfo->tnum = nRewrite;
+    int ret = tsdbFSetDelete(&deleteH, pSet);
+    pCtlInfo->tnum = tnum;
+    if (ret < 0) {
+      tsdbDestroyDeleteH(&deleteH);
+      tsdbError("vgId:%d :SDEL failed to delete data in FSET %d since %s", REPO_ID(pRepo), pSet->fid, tstrerror(terrno));
+      return -1;
+    }
+    tsdbDropRewriteTombs(&deleteH, pSet->fid, nRewrite);
+    numSet++;
   }
 
   tsdbDestroyDeleteH(&deleteH);
@@ -396,6 +423,13 @@ static int tsdbInitDeleteH(SDeleteH *pdh, STsdbRepo *pRepo) {
     return -1;
   }
 
+  pdh->aTombs = taosArrayDup(REPO_FS(pRepo)->cstatus->tombs);
+  if (pdh->aTombs == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    tsdbDestroyDeleteH(pdh);
+    return -1;
+  }
+
   return 0;
 }
 
@@ -404,6 +438,7 @@ static void tsdbDestroyDeleteH(SDeleteH *pdh) {
   pdh->aSupBlk = taosArrayDestroy(&pdh->aSupBlk);
   pdh->aSubBlk = taosArrayDestroy(&pdh->aSubBlk);
   pdh->aBlkIdx = taosArrayDestroy(&pdh->aBlkIdx);
+  pdh->aTombs = taosArrayDestroy(&pdh->aTombs);
   tsdbDestroyDeleteTblArray(pdh);
   tsdbDestroyReadH(&(pdh->readh));
   tsdbCloseDFileSet(TSDB_DELETE_WSET(pdh));
@@ -547,9 +582,13 @@ static int32_t tsdbFilterDataCols(SDeleteH *pdh, SDataCols *pSrcDCols) {
 
   for (int i = 0; i < pSrcDCols->numOfRows; ++i) {
     int64_t tsKey = *(int64_t *)tdGetColDataOfRow(pSrcDCols->cols, i);
+    bool    inTomb = tsdbTombsCover(pdh->pTombs, pdh->numOfTombs, tsKey, tsKey);
     if ((tsKey >= pdh->pCtlInfo->win.skey) && (tsKey <= pdh->pCtlInfo->win.ekey)) {
-      // delete row
-      delRows ++;
+      // delete row, the rows under tombstones were deleted before
+      if (!inTomb) delRows ++;
+      continue;
+    }
+    if (inTomb) {
       continue;
     }
     for (int j = 0; j < pSrcDCols->numOfCols; ++j) {
@@ -580,9 +619,14 @@ static int tsdbBlockSolve(SDeleteH *pdh, SBlock *pBlock) {
   STimeWindow* pdel = &pdh->pCtlInfo->win;
 
   // do nothing for no delete
-  if(pBlock->keyFirst > pdel->ekey || pBlock->keyLast < pdel->skey)
+  if ((pBlock->keyFirst > pdel->ekey || pBlock->keyLast < pdel->skey) &&
+      !tsdbTombsOverlap(pdh->pTombs, pdh->numOfTombs, pBlock->keyFirst, pBlock->keyLast))
     return BLOCK_READ;
 
+  // need del
+  if (tsdbTombsCover(pdh->pTombs, pdh->numOfTombs, pBlock->keyFirst, pBlock->keyLast))
+    return BLOCK_DELETE;
+
   // border block
   if(pBlock->keyFirst <= pdel->skey || pBlock->keyLast >= pdel->ekey)
     return BLOCK_MODIFY;
@@ -604,7 +648,9 @@ int tsdbRemoveDelBlocks(SDeleteH *pdh, STableDeleteH * pItem) {
     if (solve == BLOCK_DELETE) {
       if (from == -1)
          from = i;
-      delRows += pBlock->numOfRows;   
+      // the rows under a tombstone were counted by the delete adding it
+      if (!tsdbTombsCover(pdh->pTombs, pdh->numOfTombs, pBlock->keyFirst, pBlock->keyLast))
+        delRows += pBlock->numOfRows;
     } else {
       if(from != -1) {
         // do del
@@ -667,6 +713,8 @@ static int tsdbModifyBlocks(SDeleteH *pdh, STableDeleteH *pItem) {
     tsdbAddUpdates(pdh->aUpdates, pItem->pTable);
   }
 
+  pdh->pTombs = tsdbGetTableTombs(pdh->aTombs, TABLE_UID(pItem->pTable), &(pdh->numOfTombs));
+
   // get pSchema for del table
   if ((pSchema = tsdbGetTableSchemaImpl(pItem->pTable, true, true, -1, -1)) == NULL) {
     tsdbError("vgId:%d :SDEL tsdbGetTableSchemaImpl return NULL tid=%d. errno=%d (%s)", REPO_ID(pdh->pRepo),
@@ -837,4 +885,155 @@ static int tsdbWriteBlockToFile(SDeleteH *pdh, STable *pTable, SDataCols *pDCols
   }
 
   return 0;
-}
\ No newline at end of file
+}
+static STable *tsdbGetDelTable(SDeleteH *pdh, int32_t tid) {
+  if (tid <= 0 || tid >= taosArrayGetSize(pdh->tblArray)) return NULL;
+  return ((STableDeleteH *)taosArrayGet(pdh->tblArray, tid))->pTable;
+}
+
+// Move the tables to rewrite to the front of tids and return the number of them. Without tombstones all of them are
+// rewritten. Otherwise a table is rewritten only if its last row is deleted, so that the last row and the last
+// columns are restored from the data files holding no deleted row.
+static int32_t tsdbSortDelTables(SDeleteH *pdh) {
+  SControlDataInfo *pCtlInfo = pdh->pCtlInfo;
+  int32_t           nRewrite = 0;
+
+  if (!tsdbDeleteTombstone) {
+    return pCtlInfo->tnum;
+  }
+
+  for (int32_t i = 0; i < pCtlInfo->tnum; i++) {
+    int32_t tid = pCtlInfo->tids[i];
+    STable *pTable = tsdbGetDelTable(pdh, tid);
+    TSKEY   lastKey = (pTable == NULL) ? TSKEY_INITIAL_VAL : pTable->lastKey;
+    if (pTable == NULL || (lastKey >= pCtlInfo->win.skey && lastKey <= pCtlInfo->win.ekey)) {
+      pCtlInfo->tids[i] = pCtlInfo->tids[nRewrite];
+      pCtlInfo->tids[nRewrite++] = tid;
+    }
+  }
+
+  return nRewrite;
+}
+
+static bool tsdbRewriteHasTombs(SDeleteH *pdh, int fid, int32_t nRewrite) {
+  STsdbCfg *pCfg = REPO_CFG(pdh->pRepo);
+  TSKEY     minKey, maxKey;
+
+  tsdbGetFidKeyRange(pCfg->daysPerFile, pCfg->precision, fid, &minKey, &maxKey);
+
+  for (int32_t i = 0; i < nRewrite; i++) {
+    STable *pTable = tsdbGetDelTable(pdh, pdh->pCtlInfo->tids[i]);
+    if (pTable == NULL) continue;
+
+    int32_t    numOfTombs = 0;
+    STsdbTomb *pTombs = tsdbGetTableTombs(pdh->aTombs, TABLE_UID(pTable), &numOfTombs);
+    if (tsdbTombsOverlap(pTombs, numOfTombs, minKey, maxKey)) return true;
+  }
+
+  return false;
+}
+
+static void tsdbDropRewriteTombs(SDeleteH *pdh, int fid, int32_t nRewrite) {
+  STsdbRepo *pRepo = TSDB_DELETE_REPO(pdh);
+  STsdbCfg * pCfg = REPO_CFG(pRepo);
+  TSKEY      minKey, maxKey;
+
+  tsdbGetFidKeyRange(pCfg->daysPerFile, pCfg->precision, fid, &minKey, &maxKey);
+
+  for (int32_t i = 0; i < nRewrite; i++) {
+    STable *pTable = tsdbGetDelTable(pdh, pdh->pCtlInfo->tids[i]);
+    if (pTable == NULL) continue;
+
+    tsdbDropTableTombs(REPO_FS(pRepo)->nstatus->tombs, TABLE_UID(pTable), minKey, maxKey);
+  }
+}
+
+// Count the rows deleted from each table behind nRewrite in tids and add a tombstone in the file set for it. The data
+// files are kept, the rows are filtered by the queries and removed by the next commit or compaction of the file set.
+static int tsdbFSetAddTombs(SDeleteH *pdh, SDFileSet *pSet, int32_t nRewrite) {
+  STsdbRepo *       pRepo = TSDB_DELETE_REPO(pdh);
+  STsdbCfg *        pCfg = REPO_CFG(pRepo);
+  SReadH *          pReadh = &(pdh->readh);
+  SControlDataInfo *pCtlInfo = pdh->pCtlInfo;
+  int16_t           colId = PRIMARYKEY_TIMESTAMP_COL_INDEX;
+  TSKEY             minKey, maxKey;
+
+  tsdbGetFidKeyRange(pCfg->daysPerFile, pCfg->precision, pSet->fid, &minKey, &maxKey);
+
+  STsdbTomb tomb = {0};
+  tomb.skey = MAX(pCtlInfo->win.skey, minKey);
+  tomb.ekey = MIN(pCtlInfo->win.ekey, maxKey);
+  tomb.version = FS_TXN_VERSION(REPO_FS(pRepo));
+
+  if (tsdbSetAndOpenReadFSet(pReadh, pSet) < 0) {
+    return -1;
+  }
+
+  if (tsdbLoadBlockIdx(pReadh) < 0) {
+    tsdbCloseAndUnsetFSet(pReadh);
+    return -1;
+  }
+
+  for (int32_t i = nRewrite; i < pCtlInfo->tnum; i++) {
+    int32_t        tid = pCtlInfo->tids[i];
+    STableDeleteH *pItem = (STableDeleteH *)taosArrayGet(pdh->tblArray, tid);
+    int32_t        delRows = 0;
+
+    if (tsdbSetReadTable(pReadh, pItem->pTable) < 0) {
+      tsdbCloseAndUnsetFSet(pReadh);
+      return -1;
+    }
+    if (pReadh->pBlkIdx == NULL) continue;
+
+    if (tsdbLoadBlockInfo(pReadh, NULL, NULL) < 0) {
+      tsdbCloseAndUnsetFSet(pReadh);
+      return -1;
+    }
+
+    int32_t    numOfTombs = 0;
+    STsdbTomb *pTombs = tsdbGetTableTombs(pdh->aTombs, TABLE_UID(pItem->pTable), &numOfTombs);
+
+    for (int32_t j = 0; j < pReadh->pBlkIdx->numOfBlocks; j++) {
+      SBlock *pBlock = pReadh->pBlkInfo->blocks + j;
+      if (pBlock->keyFirst > tomb.ekey || pBlock->keyLast < tomb.skey) continue;
+      if (tsdbTombsCover(pTombs, numOfTombs, pBlock->keyFirst, pBlock->keyLast)) continue;
+
+      if (pBlock->keyFirst >= tomb.skey && pBlock->keyLast <= tomb.ekey &&
+          !tsdbTombsOverlap(pTombs, numOfTombs, pBlock->keyFirst, pBlock->keyLast)) {
+        delRows += pBlock->numOfRows;
+        continue;
+      }
+
+      // border block, count the rows by the keys
+      if (tsdbLoadBlockDataCols(pReadh, pBlock, NULL, &colId, 1) < 0) {
+        tsdbCloseAndUnsetFSet(pReadh);
+        return -1;
+      }
+
+      SDataCols *pCols = pReadh->pDCols[0];
+      for (int32_t r = 0; r < pCols->numOfRows; r++) {
+        TSKEY key = dataColsKeyAt(pCols, r);
+        if (key >= tomb.skey && key <= tomb.ekey && !tsdbTombsCover(pTombs, numOfTombs, key, key)) delRows++;
+      }
+    }
+
+    if (delRows == 0) continue;
+
+    tomb.uid = TABLE_UID(pItem->pTable);
+    if (tsdbAddTomb(REPO_FS(pRepo)->nstatus->tombs, &tomb) < 0) {
+      tsdbCloseAndUnsetFSet(pReadh);
+      return -1;
+    }
+
+    pCtlInfo->affectedRows += delRows;
+    tsdbAddAffectTables(pdh->aAffectTables, tid);
+
+    // the last columns may be deleted, restore them skipping the tombstones
+    if (CACHE_LAST_NULL_COLUMN(pCfg)) {
+      tsdbAddUpdates(pdh->aUpdates, pItem->pTable);
+    }
+  }
+
+  tsdbCloseAndUnsetFSet(pReadh);
+  return 0;
+}
@@ -90,7 +90,7 @@ static int tsdbEncodeDFileSetArray(void **buf, SArray *pArray) {
   return tlen;
 }
 
-static int tsdbDecodeDFileSetArray(void **originBuf, void *buf, SArray *pArray, SFSHeader *pSFSHeader) {
+static void *tsdbDecodeDFileSetArray(void **originBuf, void *buf, SArray *pArray, SFSHeader *pSFSHeader) {
   uint64_t  nset = 0;
   
   taosArrayClear(pArray);
@@ -104,7 +104,7 @@ static int tsdbDecodeDFileSetArray(void **originBuf, void *buf, SArray *pArray,
       size_t ptrDistance = POINTER_DISTANCE(buf, *originBuf);
       if (tsdbMakeRoom(originBuf, (size_t)extendedSize) < 0) {
         terrno = TSDB_CODE_FS_OUT_OF_MEMORY;
-        return -1;
+        return NULL;
       }
       buf = POINTER_SHIFT(*originBuf, ptrDistance);
     }
@@ -115,7 +115,7 @@ static int tsdbDecodeDFileSetArray(void **originBuf, void *buf, SArray *pArray,
     buf = tsdbDecodeDFileSet(buf, &dset, pSFSHeader->version);
     taosArrayPush(pArray, (void *)(&dset));
   }
-  return TSDB_CODE_SUCCESS;
+  return buf;
 }
 
 static int tsdbEncodeFSStatus(void **buf, SFSStatus *pStatus) {
@@ -125,6 +125,7 @@ static int tsdbEncodeFSStatus(void **buf, SFSStatus *pStatus) {
 
   tlen += tsdbEncodeSMFile(buf, pStatus->pmf);
   tlen += tsdbEncodeDFileSetArray(buf, pStatus->df);
+  tlen += tsdbEncodeTombArray(buf, pStatus->tombs);
 
   return tlen;
 }
@@ -134,7 +135,14 @@ static int tsdbDecodeFSStatus(void **originBuf, void *buf, SFSStatus *pStatus, S
   pStatus->pmf = &(pStatus->mf);
 
   buf = tsdbDecodeSMFile(buf, pStatus->pmf);
-  return tsdbDecodeDFileSetArray(originBuf, buf, pStatus->df, pSFSHeader);
+  buf = tsdbDecodeDFileSetArray(originBuf, buf, pStatus->df, pSFSHeader);
+  if (buf == NULL) return -1;
+
+  if (pSFSHeader->version >= TSDB_FS_VER_2 && tsdbDecodeTombArray(buf, pStatus->tombs) == NULL) {
+    return -1;
+  }
+
+  return TSDB_CODE_SUCCESS;
 }
 
 static SFSStatus *tsdbNewFSStatus(int maxFSet) {
@@ -153,12 +161,21 @@ static SFSStatus *tsdbNewFSStatus(int maxFSet) {
     return NULL;
   }
 
+  pStatus->tombs = taosArrayInit(16, sizeof(STsdbTomb));
+  if (pStatus->tombs == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    taosArrayDestroy(&pStatus->df);
+    free(pStatus);
+    return NULL;
+  }
+
   return pStatus;
 }
 
 static SFSStatus *tsdbFreeFSStatus(SFSStatus *pStatus) {
   if (pStatus) {
     pStatus->df = taosArrayDestroy(&pStatus->df);
+    pStatus->tombs = taosArrayDestroy(&pStatus->tombs);
     free(pStatus);
   }
 
@@ -174,6 +191,7 @@ static void tsdbResetFSStatus(SFSStatus *pStatus) {
 
   pStatus->pmf = NULL;
   taosArrayClear(pStatus->df);
+  taosArrayClear(pStatus->tombs);
 }
 
 static void tsdbSetStatusMFile(SFSStatus *pStatus, const SMFile *pMFile) {
@@ -367,6 +385,9 @@ void tsdbStartFSTxn(STsdbRepo *pRepo, int64_t pointsAdd, int64_t storageAdd) {
   } else {
     pfs->nstatus->meta.version = pfs->cstatus->meta.version + 1;
   }
+  // The tombstones are carried over unless the transaction drops them
+  taosArrayAddBatch(pfs->nstatus->tombs, TARRAY_GET_START(pfs->cstatus->tombs),
+                    (int32_t)taosArrayGetSize(pfs->cstatus->tombs));
   pfs->nstatus->meta.totalPoints = pfs->cstatus->meta.totalPoints + pointsAdd;
   pfs->nstatus->meta.totalStorage = pfs->cstatus->meta.totalStorage += storageAdd;
 }
@@ -389,8 +410,12 @@ int tsdbEndFSTxn(STsdbRepo *pRepo) {
   pStatus = pfs->cstatus;
   pfs->cstatus = pfs->nstatus;
   pfs->nstatus = pStatus;
+  pfs->version += 1;
   tsdbUnLockFS(pfs);
 
+  // The partial aggregates of the blocks are cached per file system version
+  tsdbResetAggCache(pRepo->pAggCache, pfs->version);
+
   // Apply actual change to each file and SDFileSet
   tsdbApplyFSTxnOnDisk(pfs->nstatus, pfs->cstatus);
 
@@ -409,6 +434,17 @@ void tsdbUpdateMFile(STsdbFS *pfs, const SMFile *pMFile) { tsdbSetStatusMFile(pf
 
 int tsdbUpdateDFileSet(STsdbFS *pfs, const SDFileSet *pSet) { return tsdbAddDFileSetToStatus(pfs->nstatus, pSet); }
 
+// Take the file set of fid out of the transaction, so that its files are not removed if the transaction fails
+void tsdbExcludeDFileSet(STsdbFS *pfs, int fid) {
+  for (size_t i = 0; i < taosArrayGetSize(pfs->nstatus->df); i++) {
+    SDFileSet *pSet = taosArrayGet(pfs->nstatus->df, i);
+    if (pSet->fid == fid) {
+      taosArrayRemove(pfs->nstatus->df, i);
+      return;
+    }
+  }
+}
+
 static int tsdbSaveFSStatus(SFSStatus *pStatus, int vid) {
   SFSHeader fsheader;
   void *    pBuf = NULL;
@@ -429,6 +465,7 @@ static int tsdbSaveFSStatus(SFSStatus *pStatus, int vid) {
   fsheader.version = TSDB_LATEST_SFS_VER;
   if (pStatus->pmf == NULL) {
     ASSERT(taosArrayGetSize(pStatus->df) == 0);
+    taosArrayClear(pStatus->tombs);
     fsheader.len = 0;
   } else {
     fsheader.len = tsdbEncodeFSStatus(NULL, pStatus) + sizeof(TSCKSUM);
@@ -559,7 +596,7 @@ void tsdbFSIterInit(SFSIter *pIter, STsdbFS *pfs, int direction) {
 
   size_t size = taosArrayGetSize(pfs->cstatus->df);
 
-  pIter->version = pfs->cstatus->meta.version;
+  pIter->version = pfs->version;
 
   if (size == 0) {
     pIter->index = -1;
@@ -607,8 +644,8 @@ SDFileSet *tsdbFSIterNext(SFSIter *pIter) {
 
   ASSERT(pIter->fid != TSDB_IVLD_FID);
 
-  if (pIter->version != pfs->cstatus->meta.version) {
-    pIter->version = pfs->cstatus->meta.version;
+  if (pIter->version != pfs->version) {
+    pIter->version = pfs->version;
     tsdbFSIterSeek(pIter, pIter->fid);
   }
 
@@ -95,4 +95,19 @@ bool tsdbNoProblem(STsdbRepo* pRepo) {
   if(listNEles(pRepo->pPool->bufBlockList) == 0) 
      return false;
   return true;
-}
\ No newline at end of file
+}
+
+// the mem table is due to be committed or the pool has lent elastic blocks, so a commit is to wait for the background
+// compaction holding the repo
+bool tsdbMemPressure(STsdbRepo* pRepo) {
+  bool pressure = false;
+
+  if (tsdbLockRepo(pRepo) < 0) return true;
+  if (pRepo->pPool->nElasticBlocks > 0 ||
+      (pRepo->mem != NULL && listNEles(pRepo->mem->bufBlockList) >= pRepo->config.totalBlocks / 3)) {
+    pressure = true;
+  }
+  tsdbUnlockRepo(pRepo);
+
+  return pressure;
+}
@@ -15,6 +15,7 @@
 
 // no test file errors here
 #include "taosdef.h"
+#include "tglobal.h"
 #include "tsdbint.h"
 #include "ttimer.h"
 #include "tthread.h"
@@ -628,11 +629,23 @@ static STsdbRepo *tsdbNewRepo(STsdbCfg *pCfg, STsdbAppH *pAppH) {
     return NULL;
   }
 
+  if (tsBlockAggCacheSize > 0) {
+    pRepo->pAggCache = tsdbNewAggCache((int64_t)tsBlockAggCacheSize * 1024 * 1024);
+    if (pRepo->pAggCache == NULL) {
+      tsdbError("vgId:%d failed to create agg cache since %s", REPO_ID(pRepo), tstrerror(terrno));
+      tsdbFreeRepo(pRepo);
+      return NULL;
+    }
+  }
+
   return pRepo;
 }
 
 static void tsdbFreeRepo(STsdbRepo *pRepo) {
   if (pRepo) {
+    tsdbFreeAggCache(pRepo->pAggCache);
+    tsdbFreeSyncFSets(pRepo->syncFSets);
+    taosArrayDestroy(&pRepo->compactScores);
     tsdbFreeFS(pRepo->fs);
     tsdbFreeBufPool(pRepo->pPool);
     tsdbFreeMeta(pRepo->tsdbMeta);
@@ -725,6 +738,10 @@ static int tsdbRestoreLastColumns(STsdbRepo *pRepo, STable *pTable, SReadH* pRea
     pBlockStatis[i].colId = pCol->colId;
   }
 
+  // the rows under tombstones are deleted
+  int32_t    numOfTombs = 0;
+  STsdbTomb *pTombs = tsdbGetTableTombs(REPO_FS(pRepo)->cstatus->tombs, TABLE_UID(pTable), &numOfTombs);
+
   // load block from backward
   SBlockIdx *pIdx = pReadh->pBlkIdx;
   blockIdx = (int32_t)(pIdx->numOfBlocks - 1);
@@ -734,6 +751,10 @@ static int tsdbRestoreLastColumns(STsdbRepo *pRepo, STable *pTable, SReadH* pRea
     pBlock = pReadh->pBlkInfo->blocks + blockIdx;
     blockIdx -= 1;
 
+    if (tsdbTombsCover(pTombs, numOfTombs, pBlock->keyFirst, pBlock->keyLast)) {
+      continue;
+    }
+
     // load block data
     if (tsdbLoadBlockData(pReadh, pBlock, NULL) < 0) {
       err = -1;
@@ -773,6 +794,11 @@ static int tsdbRestoreLastColumns(STsdbRepo *pRepo, STable *pTable, SReadH* pRea
           continue;
         }
 
+        if (numOfTombs > 0) {
+          TSKEY key = dataColsKeyAt(pReadh->pDCols[0], rowId);
+          if (tsdbTombsCover(pTombs, numOfTombs, key, key)) continue;
+        }
+
         int16_t idx = tsdbGetLastColumnsIndexByColId(pTable, pCol->colId);
         if (idx == -1) {
           tsdbError("tsdbRestoreLastColumns restore vgId:%d,table:%s cache column %d fail", REPO_ID(pRepo), pTable->name->data, pCol->colId);
@@ -475,7 +475,8 @@ STsdbMeta *tsdbNewMeta(STsdbCfg *pCfg) {
     goto _err;
   }
 
-  pMeta->uidMap = taosHashInit((size_t)(TSDB_INIT_NTABLES * 1.1), taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT), true, false);
+  pMeta->uidMap = taosShardHashInit(TSDB_INIT_NTABLES, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT),
+                                    sizeof(uint64_t), sizeof(STable *), TSDB_UID_MAP_SHARDS);
   if (pMeta->uidMap == NULL) {
     terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
     goto _err;
@@ -490,7 +491,7 @@ _err:
 
 void tsdbFreeMeta(STsdbMeta *pMeta) {
   if (pMeta) {
-    taosHashCleanup(pMeta->uidMap);
+    taosShardHashCleanup(pMeta->uidMap);
     tdListFree(pMeta->superList);
     tfree(pMeta->tables);
     pthread_rwlock_destroy(&pMeta->rwLock);
@@ -549,11 +550,10 @@ int tsdbCloseMeta(STsdbRepo *pRepo) {
 }
 
 STable *tsdbGetTableByUid(STsdbMeta *pMeta, uint64_t uid) {
-  void *ptr = taosHashGet(pMeta->uidMap, (char *)(&uid), sizeof(uid));
-
-  if (ptr == NULL) return NULL;
+  STable *pTable = NULL;
+  if (taosShardHashGet(pMeta->uidMap, &uid, sizeof(uid), &pTable) < 0) return NULL;
 
-  return *(STable **)ptr;
+  return pTable;
 }
 
 STSchema *tsdbGetTableSchemaByVersion(STable *pTable, int16_t _version, int8_t rowType) {
@@ -987,8 +987,7 @@ static int tsdbAddTableToMeta(STsdbRepo *pRepo, STable *pTable, bool addIdx, boo
     pMeta->nTables++;
   }
 
-  if (taosHashPut(pMeta->uidMap, (char *)(&pTable->tableId.uid), sizeof(pTable->tableId.uid), (void *)(&pTable),
-                  sizeof(pTable)) < 0) {
+  if (taosShardHashPut(pMeta->uidMap, &pTable->tableId.uid, sizeof(pTable->tableId.uid), &pTable) < 0) {
     terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
     tsdbError("vgId:%d failed to add table %s to meta while put into uid map since %s", REPO_ID(pRepo),
               TABLE_CHAR_NAME(pTable), tstrerror(terrno));
@@ -1049,7 +1048,7 @@ static void tsdbRemoveTableFromMeta(STsdbRepo *pRepo, STable *pTable, bool rmFro
     pMeta->nTables--;
   }
 
-  taosHashRemove(pMeta->uidMap, (char *)(&(TABLE_UID(pTable))), sizeof(TABLE_UID(pTable)));
+  taosShardHashRemove(pMeta->uidMap, &TABLE_UID(pTable), sizeof(TABLE_UID(pTable)));
 
   if (maxCols == pMeta->maxCols || maxRowBytes == pMeta->maxRowBytes) {
     maxCols = 0;
@@ -24,6 +24,7 @@
 #include "taosdef.h"
 #include "tlosertree.h"
 #include "tsdbint.h"
+#include "tglobal.h"
 #include "texpr.h"
 #include "qFilter.h"
 #include "cJSON.h"
@@ -97,6 +98,8 @@ typedef struct STableCheckInfo {
   bool          initBuf;        // whether to initialize the in-memory skip list iterator or not
   SSkipListIterator* iter;      // mem buffer skip list iterator
   SSkipListIterator* iiter;     // imem buffer skip list iterator
+  STsdbTomb*    pTombs;         // tombstones of the table in the snapshot of the query handle
+  int32_t       numOfTombs;
 } STableCheckInfo;
 
 typedef struct STableBlockInfo {
@@ -114,6 +117,7 @@ typedef struct SBlockOrderSupporter {
 typedef struct SIOCostSummary {
   int64_t blockLoadTime;
   int64_t statisInfoLoadTime;
+  int64_t bloomInfoLoadTime;
   int64_t checkForNextTime;
   int64_t headFileLoad;
   int64_t headFileLoadTime;
@@ -128,6 +132,7 @@ typedef struct STsdbQueryHandle {
   int64_t        frows;            // forbid skip offset rows
   STimeWindow    window;           // the primary query time window that applies to all queries
   SDataStatis*   statis;           // query level statistics, only one table block statistics info exists at any time
+  SDataBloom*    bloom;            // query level bloom filters, share the life cycle with statis
   int32_t        numOfBlocks;
   SArray*        pColumns;         // column list, SColumnInfoData array list
   bool           locateStart;
@@ -156,6 +161,7 @@ typedef struct STsdbQueryHandle {
   SArray        *prev;             // previous row which is before than time window
   SArray        *next;             // next row which is after the query time window
   SIOCostSummary cost;
+  SArray        *pTombs;           // snapshot of the tombstones, SArray<STsdbTomb>
   
   // callback
   readover_callback readover_cb;
@@ -454,6 +460,17 @@ static STsdbQueryHandle* tsdbQueryTablesImpl(STsdbRepo* tsdb, STsdbQueryCond* pC
     goto _end;
   }
 
+  // the blocks are loaded synchronously if the read-ahead is disabled
+  pQueryHandle->rhelper.pReadAhead = tsdbNewReadAhead((int64_t)tsReadAheadBufferSize * 1024 * 1024);
+
+  // the rows deleted after the query starts are still visible to it
+  tsdbRLockFS(REPO_FS(tsdb));
+  pQueryHandle->pTombs = taosArrayDup(REPO_FS(tsdb)->cstatus->tombs);
+  tsdbUnLockFS(REPO_FS(tsdb));
+  if (pQueryHandle->pTombs == NULL) {
+    goto _end;
+  }
+
   assert(pCond != NULL && pMemRef != NULL);
   setQueryTimewindow(pQueryHandle, pCond);
 
@@ -464,6 +481,11 @@ static STsdbQueryHandle* tsdbQueryTablesImpl(STsdbRepo* tsdb, STsdbQueryCond* pC
       goto _end;
     }
 
+    pQueryHandle->bloom = calloc(pCond->numOfCols, sizeof(SDataBloom));
+    if (pQueryHandle->bloom == NULL) {
+      goto _end;
+    }
+
     // todo: use list instead of array?
     pQueryHandle->pColumns = taosArrayInit(pCond->numOfCols, sizeof(SColumnInfoData));
     if (pQueryHandle->pColumns == NULL) {
@@ -481,6 +503,7 @@ static STsdbQueryHandle* tsdbQueryTablesImpl(STsdbRepo* tsdb, STsdbQueryCond* pC
 
       taosArrayPush(pQueryHandle->pColumns, &colInfo);
       pQueryHandle->statis[i].colId = colInfo.info.colId;
+      pQueryHandle->bloom[i].colId = colInfo.info.colId;
     }
 
     pQueryHandle->defaultLoadColumn = getDefaultLoadColumns(pQueryHandle, true);
@@ -1376,10 +1399,10 @@ static void shrinkBlocksByQuery(STsdbQueryHandle *pQueryHandle, STableCheckInfo
     end += 1;
   }
 
-  // calc offset can skip blocks number
+  // calc offset can skip blocks number, not for the blocks with deleted rows
   int32_t nSkip = 0;
   SArray *pArray = NULL;
-  if(pQueryHandle->offset > 0) {
+  if(pQueryHandle->offset > 0 && pCheckInfo->numOfTombs == 0) {
      nSkip = offsetSkipBlock(pQueryHandle, pCompInfo, s, e, start, end, &pArray, order);
   }
 
@@ -1395,6 +1418,34 @@ static void shrinkBlocksByQuery(STsdbQueryHandle *pQueryHandle, STableCheckInfo
     taosArrayDestroy(&pArray);
 }
 
+// a file block with rows under the tombstones is loaded and filtered, its statistics cover the deleted rows
+static bool isTombBlock(STableCheckInfo *pCheckInfo, SBlock *pBlock) {
+  return pCheckInfo->numOfTombs > 0 &&
+         tsdbTombsOverlap(pCheckInfo->pTombs, pCheckInfo->numOfTombs, pBlock->keyFirst, pBlock->keyLast);
+}
+
+// discard the blocks deleted as a whole by the tombstones
+static void dropBlocksUnderTombs(STableCheckInfo *pCheckInfo) {
+  if (pCheckInfo->numOfTombs == 0) {
+    return;
+  }
+
+  SBlock *blocks = pCheckInfo->pCompInfo->blocks;
+  int32_t num = 0;
+  for (int32_t i = 0; i < pCheckInfo->numOfBlocks; ++i) {
+    if (tsdbTombsCover(pCheckInfo->pTombs, pCheckInfo->numOfTombs, blocks[i].keyFirst, blocks[i].keyLast)) {
+      continue;
+    }
+
+    if (num != i) {
+      blocks[num] = blocks[i];
+    }
+    num++;
+  }
+
+  pCheckInfo->numOfBlocks = num;
+}
+
 // load one table (tsd_index point to) need load blocks info and put into pCheckInfo->pCompInfo->blocks
 static int32_t loadBlockInfo(STsdbQueryHandle * pQueryHandle, int32_t tsd_index, int32_t* numOfBlocks) {
   //
@@ -1403,6 +1454,7 @@ static int32_t loadBlockInfo(STsdbQueryHandle * pQueryHandle, int32_t tsd_index,
   int32_t code = 0;
   STableCheckInfo* pCheckInfo = taosArrayGet(pQueryHandle->pTableCheckInfo, tsd_index);
   pCheckInfo->numOfBlocks = 0;
+  pCheckInfo->pTombs = tsdbGetTableTombs(pQueryHandle->pTombs, pCheckInfo->tableId.uid, &pCheckInfo->numOfTombs);
   if (tsdbSetReadTable(&pQueryHandle->rhelper, pCheckInfo->pTableObj) != TSDB_CODE_SUCCESS) {
     code = terrno;
     return code;
@@ -1436,6 +1488,7 @@ static int32_t loadBlockInfo(STsdbQueryHandle * pQueryHandle, int32_t tsd_index,
   // TWO PART. shrink no need blocks from all blocks by condition of query
   //
   shrinkBlocksByQuery(pQueryHandle, pCheckInfo);
+  dropBlocksUnderTombs(pCheckInfo);
   (*numOfBlocks) += pCheckInfo->numOfBlocks;
 
   return 0;
@@ -1473,6 +1526,50 @@ static int32_t getFileCompInfo(STsdbQueryHandle* pQueryHandle, int32_t* numOfBlo
   return code;
 }
 
+static bool readAheadFileBlock(STsdbQueryHandle* pQueryHandle, STableBlockInfo* pBlockInfo) {
+  SReadH* pReadh = &pQueryHandle->rhelper;
+  SBlock* pBlock = pBlockInfo->compBlock;
+
+  // the sub blocks are put one by one, as they are read one by one
+  SBlock* pSubBlock = pBlock;
+  if (pBlock->numOfSubBlocks > 1) {
+    pSubBlock = POINTER_SHIFT(pBlockInfo->pTableCheckInfo->pCompInfo, pBlock->offset);
+  }
+
+  // only the columns loaded by the query are read
+  int16_t* colIds = pQueryHandle->defaultLoadColumn->pData;
+  int32_t  numOfCols = (int32_t)QH_GET_NUM_OF_COLS(pQueryHandle);
+
+  for (int32_t i = 0; i < MAX(pBlock->numOfSubBlocks, 1); ++i, ++pSubBlock) {
+    SDFile* pDFile = (pSubBlock->last) ? TSDB_READ_LAST_FILE(pReadh) : TSDB_READ_DATA_FILE(pReadh);
+    if (!tsdbPutReadAhead(pReadh->pReadAhead, pDFile, pSubBlock, colIds, numOfCols)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+ * Read the next blocks in the order of pDataBlockInfo ahead before loading the current one, so that the reads of them
+ * overlap with loading and processing the current one. A block that the query does not load at last is a waste of the
+ * read-ahead, which is bounded by the number of blocks and the buffer size.
+ */
+static void readAheadFileBlocks(STsdbQueryHandle* pQueryHandle, SBlock* pBlock, int32_t slot) {
+  if (pQueryHandle->rhelper.pReadAhead == NULL || slot < 0 || slot >= pQueryHandle->numOfBlocks ||
+      pQueryHandle->pDataBlockInfo[slot].compBlock != pBlock) {
+    return;
+  }
+
+  int32_t step = ASCENDING_TRAVERSE(pQueryHandle->order) ? 1 : -1;
+  for (int32_t i = 1; i <= tsReadAheadBlocks; ++i) {
+    int32_t s = slot + i * step;
+    if (s < 0 || s >= pQueryHandle->numOfBlocks || !readAheadFileBlock(pQueryHandle, &pQueryHandle->pDataBlockInfo[s])) {
+      break;
+    }
+  }
+}
+
 static int32_t doLoadFileDataBlock(STsdbQueryHandle* pQueryHandle, SBlock* pBlock, STableCheckInfo* pCheckInfo, int32_t slotIndex) {
   int64_t st = taosGetTimestampUs();
 
@@ -1500,6 +1597,8 @@ static int32_t doLoadFileDataBlock(STsdbQueryHandle* pQueryHandle, SBlock* pBloc
 
   int16_t* colIds = pQueryHandle->defaultLoadColumn->pData;
 
+  readAheadFileBlocks(pQueryHandle, pBlock, slotIndex);
+
   int32_t ret = tsdbLoadBlockDataCols(&(pQueryHandle->rhelper), pBlock, pCheckInfo->pCompInfo, colIds, (int)(QH_GET_NUM_OF_COLS(pQueryHandle)));
   if (ret != TSDB_CODE_SUCCESS) {
     int32_t c = terrno;
@@ -1513,6 +1612,17 @@ static int32_t doLoadFileDataBlock(STsdbQueryHandle* pQueryHandle, SBlock* pBloc
   pBlockLoadInfo->slot = pQueryHandle->cur.slot;
   pBlockLoadInfo->tid = pCheckInfo->pTableObj->tableId.tid;
 
+  // the keys of the block are kept, so that it is still known to overlap the tombstones
+  if (isTombBlock(pCheckInfo, pBlock)) {
+    tsdbFilterTombRows(pCheckInfo->pTombs, pCheckInfo->numOfTombs, &pQueryHandle->rhelper.pDCols[0],
+                       &pQueryHandle->rhelper.pDCols[1]);
+    if (pQueryHandle->rhelper.pDCols[0]->numOfRows == 0) {
+      pBlock->numOfRows = 0;
+      pQueryHandle->cost.blockLoadTime += (taosGetTimestampUs() - st);
+      return TSDB_CODE_SUCCESS;
+    }
+  }
+
   SDataCols* pCols = pQueryHandle->rhelper.pDCols[0];
   assert(pCols->numOfRows != 0 && pCols->numOfRows <= pBlock->numOfRows);
 
@@ -1641,15 +1751,47 @@ static int32_t handleDataMergeIfNeeded(STsdbQueryHandle* pQueryHandle, SBlock* p
   return code;
 }
 
+// whether any row of the block filtered by the tombstones is left in the range to scan
+static bool hasRowsAfterTombs(STsdbQueryHandle* pQueryHandle, STableCheckInfo* pCheckInfo) {
+  SDataCols* pCols = pQueryHandle->rhelper.pDCols[0];
+  TSKEY*     keys = pCols->cols[0].pData;
+  TSKEY      s = MIN(pCheckInfo->lastKey, pQueryHandle->window.ekey);
+  TSKEY      e = MAX(pCheckInfo->lastKey, pQueryHandle->window.ekey);
+
+  for (int32_t i = 0; i < pCols->numOfRows; ++i) {
+    if (keys[i] >= s && keys[i] <= e) return true;
+  }
+
+  return false;
+}
+
 static int32_t loadFileDataBlock(STsdbQueryHandle* pQueryHandle, SBlock* pBlock, STableCheckInfo* pCheckInfo, bool* exists) {
   SQueryFilePos* cur = &pQueryHandle->cur;
   int32_t code = TSDB_CODE_SUCCESS;
   bool asc = ASCENDING_TRAVERSE(pQueryHandle->order);
+  bool tomb = isTombBlock(pCheckInfo, pBlock);
+
+  // the block with deleted rows is always loaded and merged, skip it if no row is left
+  if (tomb) {
+    if ((code = doLoadFileDataBlock(pQueryHandle, pBlock, pCheckInfo, cur->slot)) != TSDB_CODE_SUCCESS) {
+      *exists = false;
+      return code;
+    }
+
+    if (!hasRowsAfterTombs(pQueryHandle, pCheckInfo)) {
+      pQueryHandle->realNumOfRows = 0;
+      cur->rows = 0;
+      cur->mixBlock = true;
+      cur->blockCompleted = true;
+      *exists = false;
+      return code;
+    }
+  }
 
   if (asc) {
     // query ended in/started from current block
-    if (pQueryHandle->window.ekey < pBlock->keyLast || pCheckInfo->lastKey > pBlock->keyFirst) {
-      if ((code = doLoadFileDataBlock(pQueryHandle, pBlock, pCheckInfo, cur->slot)) != TSDB_CODE_SUCCESS) {
+    if (tomb || pQueryHandle->window.ekey < pBlock->keyLast || pCheckInfo->lastKey > pBlock->keyFirst) {
+      if (!tomb && (code = doLoadFileDataBlock(pQueryHandle, pBlock, pCheckInfo, cur->slot)) != TSDB_CODE_SUCCESS) {
         *exists = false;
         return code;
       }
@@ -1671,8 +1813,8 @@ static int32_t loadFileDataBlock(STsdbQueryHandle* pQueryHandle, SBlock* pBlock,
       code = handleDataMergeIfNeeded(pQueryHandle, pBlock, pCheckInfo);
     }
   } else {  //desc order, query ended in current block
-    if (pQueryHandle->window.ekey > pBlock->keyFirst || pCheckInfo->lastKey < pBlock->keyLast) {
-      if ((code = doLoadFileDataBlock(pQueryHandle, pBlock, pCheckInfo, cur->slot)) != TSDB_CODE_SUCCESS) {
+    if (tomb || pQueryHandle->window.ekey > pBlock->keyFirst || pCheckInfo->lastKey < pBlock->keyLast) {
+      if (!tomb && (code = doLoadFileDataBlock(pQueryHandle, pBlock, pCheckInfo, cur->slot)) != TSDB_CODE_SUCCESS) {
         *exists = false;
         return code;
       }
@@ -2196,7 +2338,10 @@ static void doMergeTwoLevelData(STsdbQueryHandle* pQueryHandle, STableCheckInfo*
 
   // key read from file
   TSKEY* keyFile = pCols->cols[0].pData;
-  assert(pCols->numOfRows == pBlock->numOfRows && keyFile[0] == pBlock->keyFirst && keyFile[pBlock->numOfRows-1] == pBlock->keyLast);
+  // the keys of a block with deleted rows are kept, the first and last rows may be gone
+  assert(pCols->numOfRows == pBlock->numOfRows &&
+         (isTombBlock(pCheckInfo, pBlock) ||
+          (keyFile[0] == pBlock->keyFirst && keyFile[pBlock->numOfRows - 1] == pBlock->keyLast)));
 
   int32_t step = ASCENDING_TRAVERSE(pQueryHandle->order)? 1:-1;
   int32_t numOfCols = (int32_t)(QH_GET_NUM_OF_COLS(pQueryHandle));
@@ -3744,8 +3889,8 @@ int32_t tsdbRetrieveDataBlockStatisInfo(TsdbQueryHandleT* pQueryHandle, SDataSta
   STableBlockInfo* pBlockInfo = &pHandle->pDataBlockInfo[c->slot];
   assert((c->slot >= 0 && c->slot < pHandle->numOfBlocks) || ((c->slot == pHandle->numOfBlocks) && (c->slot == 0)));
 
-  // file block with sub-blocks has no statistics data
-  if (pBlockInfo->compBlock->numOfSubBlocks > 1) {
+  // file block with sub-blocks has no statistics data, nor the one with deleted rows
+  if (pBlockInfo->compBlock->numOfSubBlocks > 1 || isTombBlock(pBlockInfo->pTableCheckInfo, pBlockInfo->compBlock)) {
     *pBlockStatis = NULL;
     return TSDB_CODE_SUCCESS;
   }
@@ -3791,6 +3936,131 @@ int32_t tsdbRetrieveDataBlockStatisInfo(TsdbQueryHandleT* pQueryHandle, SDataSta
   return TSDB_CODE_SUCCESS;
 }
 
+int32_t tsdbRetrieveDataBlockBloomInfo(TsdbQueryHandleT* pQueryHandle, SDataBloom** pBlockBloom) {
+  STsdbQueryHandle* pHandle = (STsdbQueryHandle*) pQueryHandle;
+  *pBlockBloom = NULL;
+
+  SQueryFilePos* c = &pHandle->cur;
+  if (c->mixBlock || pHandle->bloom == NULL) {
+    return TSDB_CODE_SUCCESS;
+  }
+
+  STableBlockInfo* pBlockInfo = &pHandle->pDataBlockInfo[c->slot];
+  assert((c->slot >= 0 && c->slot < pHandle->numOfBlocks) || ((c->slot == pHandle->numOfBlocks) && (c->slot == 0)));
+
+  // file block with sub-blocks has no bloom filter, the same as statistics data
+  if (pBlockInfo->compBlock->numOfSubBlocks > 1) {
+    return TSDB_CODE_SUCCESS;
+  }
+
+  int64_t stime = taosGetTimestampUs();
+  int     bloomStatus = tsdbLoadBlockBloom(&pHandle->rhelper, pBlockInfo->compBlock);
+  if (bloomStatus < TSDB_STATIS_OK) {
+    return terrno;
+  } else if (bloomStatus > TSDB_STATIS_OK) {
+    return TSDB_CODE_SUCCESS;
+  }
+
+  int16_t* colIds = pHandle->defaultLoadColumn->pData;
+
+  size_t numOfCols = QH_GET_NUM_OF_COLS(pHandle);
+  memset(pHandle->bloom, 0, numOfCols * sizeof(SDataBloom));
+  for(int32_t i = 0; i < numOfCols; ++i) {
+    pHandle->bloom[i].colId = colIds[i];
+  }
+
+  tsdbGetBlockBloom(&pHandle->rhelper, pHandle->bloom, (int)numOfCols);
+
+  pHandle->cost.bloomInfoLoadTime += (taosGetTimestampUs() - stime);
+
+  *pBlockBloom = pHandle->bloom;
+  return TSDB_CODE_SUCCESS;
+}
+
+// identity of a file block in the file system version that the query handle reads, followed by the signature
+typedef struct SBlockAggCacheKey {
+  uint64_t uid;
+  int64_t  offset;
+  TSKEY    keyFirst;
+  TSKEY    keyLast;
+  int32_t  fid;
+  int32_t  last;
+  int32_t  numOfRows;
+  int32_t  numOfSubBlocks;
+} SBlockAggCacheKey;
+
+bool tsdbIsDataBlockAggCacheable(TsdbQueryHandleT* pQueryHandle) {
+  STsdbQueryHandle* pHandle = (STsdbQueryHandle*) pQueryHandle;
+
+  // only the completed file blocks, the other ones are merged with the data in the mem tables
+  if (pHandle->pTsdb->pAggCache == NULL || !pHandle->checkFiles || pHandle->cur.fid == INT32_MIN ||
+      pHandle->cur.mixBlock || pHandle->cur.slot < 0 || pHandle->cur.slot >= pHandle->numOfBlocks) {
+    return false;
+  }
+
+  STableBlockInfo* pBlockInfo = &pHandle->pDataBlockInfo[pHandle->cur.slot];
+  return !isTombBlock(pBlockInfo->pTableCheckInfo, pBlockInfo->compBlock);
+}
+
+static void* tsdbGetDataBlockAggCacheKey(STsdbQueryHandle* pHandle, const void* sig, int32_t sigLen, int32_t* keyLen) {
+  STableBlockInfo* pBlockInfo = &pHandle->pDataBlockInfo[pHandle->cur.slot];
+  SBlock*          pBlock = pBlockInfo->compBlock;
+
+  char* key = calloc(1, sizeof(SBlockAggCacheKey) + sigLen);
+  if (key == NULL) {
+    return NULL;
+  }
+
+  SBlockAggCacheKey* pKey = (SBlockAggCacheKey*)key;
+  pKey->uid = pBlockInfo->pTableCheckInfo->tableId.uid;
+  pKey->offset = pBlock->offset;
+  pKey->keyFirst = pBlock->keyFirst;
+  pKey->keyLast = pBlock->keyLast;
+  pKey->fid = pHandle->cur.fid;
+  pKey->last = pBlock->last;
+  pKey->numOfRows = pBlock->numOfRows;
+  pKey->numOfSubBlocks = pBlock->numOfSubBlocks;
+  memcpy(key + sizeof(SBlockAggCacheKey), sig, sigLen);
+
+  *keyLen = (int32_t)sizeof(SBlockAggCacheKey) + sigLen;
+  return key;
+}
+
+void* tsdbGetDataBlockAggCache(TsdbQueryHandleT* pQueryHandle, const void* sig, int32_t sigLen, int32_t* len) {
+  STsdbQueryHandle* pHandle = (STsdbQueryHandle*) pQueryHandle;
+  if (!tsdbIsDataBlockAggCacheable(pQueryHandle)) {
+    return NULL;
+  }
+
+  int32_t keyLen = 0;
+  void*   key = tsdbGetDataBlockAggCacheKey(pHandle, sig, sigLen, &keyLen);
+  if (key == NULL) {
+    return NULL;
+  }
+
+  void* pAgg = tsdbGetAggCache(pHandle->pTsdb->pAggCache, pHandle->fileIter.version, key, keyLen, len);
+  free(key);
+
+  return pAgg;
+}
+
+void tsdbPutDataBlockAggCache(TsdbQueryHandleT* pQueryHandle, const void* sig, int32_t sigLen, const void* pAgg,
+                              int32_t len) {
+  STsdbQueryHandle* pHandle = (STsdbQueryHandle*) pQueryHandle;
+  if (!tsdbIsDataBlockAggCacheable(pQueryHandle)) {
+    return;
+  }
+
+  int32_t keyLen = 0;
+  void*   key = tsdbGetDataBlockAggCacheKey(pHandle, sig, sigLen, &keyLen);
+  if (key == NULL) {
+    return;
+  }
+
+  tsdbPutAggCache(pHandle->pTsdb->pAggCache, pHandle->fileIter.version, key, keyLen, pAgg, len);
+  free(key);
+}
+
 SArray* tsdbRetrieveDataBlock(TsdbQueryHandleT* pQueryHandle, SArray* pIdList) {
   /**
    * In the following two cases, the data has been loaded to SColumnInfoData.
@@ -4267,6 +4537,7 @@ void tsdbCleanupQueryHandle(TsdbQueryHandleT queryHandle) {
   taosArrayDestroy(&pQueryHandle->defaultLoadColumn);
   tfree(pQueryHandle->pDataBlockInfo);
   tfree(pQueryHandle->statis);
+  tfree(pQueryHandle->bloom);
 
   if (!emptyQueryTimewindow(pQueryHandle)) {
     tsdbMayUnTakeMemSnapshot(pQueryHandle);
@@ -4282,14 +4553,15 @@ void tsdbCleanupQueryHandle(TsdbQueryHandleT queryHandle) {
 
   tdFreeDataCols(pQueryHandle->pDataCols);
   pQueryHandle->pDataCols = NULL;
+  taosArrayDestroy(&pQueryHandle->pTombs);
 
   pQueryHandle->prev = doFreeColumnInfoData(pQueryHandle->prev);
   pQueryHandle->next = doFreeColumnInfoData(pQueryHandle->next);
 
   SIOCostSummary* pCost = &pQueryHandle->cost;
 
-  tsdbDebug("%p :io-cost summary: head-file read cnt:%"PRIu64", head-file time:%"PRIu64" us, statis-info:%"PRId64" us, datablock:%" PRId64" us, check data:%"PRId64" us, 0x%"PRIx64,
-      pQueryHandle, pCost->headFileLoad, pCost->headFileLoadTime, pCost->statisInfoLoadTime, pCost->blockLoadTime, pCost->checkForNextTime, pQueryHandle->qId);
+  tsdbDebug("%p :io-cost summary: head-file read cnt:%"PRIu64", head-file time:%"PRIu64" us, statis-info:%"PRId64" us, bloom-info:%"PRId64" us, datablock:%" PRId64" us, check data:%"PRId64" us, 0x%"PRIx64,
+      pQueryHandle, pCost->headFileLoad, pCost->headFileLoadTime, pCost->statisInfoLoadTime, pCost->bloomInfoLoadTime, pCost->blockLoadTime, pCost->checkForNextTime, pQueryHandle->qId);
 
   tfree(pQueryHandle);
 }
@@ -4684,6 +4956,20 @@ int64_t tsdbSkipOffset(TsdbQueryHandleT queryHandle) {
   return 0;
 }
 
+void tsdbGetReadAheadStat(TsdbQueryHandleT queryHandle, int64_t* hits, int64_t* misses, int64_t* wastes) {
+  STsdbQueryHandle* pQueryHandle = (STsdbQueryHandle*)queryHandle;
+  STsdbReadAhead*   pReadAhead = (pQueryHandle != NULL) ? pQueryHandle->rhelper.pReadAhead : NULL;
+
+  *hits = *misses = *wastes = 0;
+  if (pReadAhead == NULL) return;
+
+  pthread_mutex_lock(&pReadAhead->mutex);
+  *hits = pReadAhead->hits;
+  *misses = pReadAhead->misses;
+  *wastes = pReadAhead->wastes;
+  pthread_mutex_unlock(&pReadAhead->mutex);
+}
+
 // add scan table need callback 
 void tsdbAddScanCallback(TsdbQueryHandleT* queryHandle, readover_callback callback, void* param) {
   STsdbQueryHandle* pQueryHandle = (STsdbQueryHandle*)queryHandle;
@@ -0,0 +1,360 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tsdbint.h"
+#include "tglobal.h"
+#include "tsched.h"
+
+#define TSDB_READ_AHEAD_QUEUE_SIZE 1024
+
+typedef enum { TSDB_READ_AHEAD_BUSY = 0, TSDB_READ_AHEAD_DONE, TSDB_READ_AHEAD_FAILED } TSDB_READ_AHEAD_STATE;
+
+// the part [start, end) of the block read, relative to the offset of the block
+typedef struct {
+  int32_t start;
+  int32_t end;
+} SReadAheadRange;
+
+typedef struct {
+  STsdbReadAhead * pReadAhead;
+  SDFile *         pDFile;  // only to match the reads of the query, the fd is used by the worker
+  FileFd           fd;
+  SBlock           block;
+  int64_t          offset;
+  int32_t          len;
+  int16_t *        colIds;  // the columns loaded by the query, the ones of the block are located by its statis part
+  int32_t          numOfColIds;
+  SReadAheadRange *ranges;  // the parts read, the statis part and the columns loaded
+  int32_t          numOfRanges;
+  int8_t           state;
+  bool             dropped;  // freed by the worker once the read is done
+  bool             used;
+  char             data[];
+} SReadAheadBlock;
+
+static void *   tsReadAheadPool = NULL;
+static int32_t  tsReadAheadQueued = 0;  // blocks scheduled but not taken by the workers yet
+
+static void tsdbDoReadAhead(SSchedMsg *pMsg);
+static bool tsdbReadAheadCols(SReadAheadBlock *pBlock);
+static void tsdbAddReadAheadRange(SReadAheadBlock *pBlock, int32_t start, int32_t end);
+static bool tsdbReadAheadRangeOf(SReadAheadBlock *pBlock, int32_t start, int32_t end);
+static void tsdbDropReadAheadBlock(STsdbReadAhead *pReadAhead, SReadAheadBlock *pBlock);
+
+int tsdbInitReadAhead() {
+  if (tsReadAheadThreads <= 0) return 0;
+
+  // the queries read the blocks by themselves if the pool fails to start
+  tsReadAheadPool = taosInitScheduler(TSDB_READ_AHEAD_QUEUE_SIZE, tsReadAheadThreads, "tsdbReadAhead");
+  if (tsReadAheadPool == NULL) {
+    tsdbWarn("failed to start %d threads to read ahead the file blocks", tsReadAheadThreads);
+  }
+
+  return 0;
+}
+
+void tsdbDestroyReadAhead() {
+  if (tsReadAheadPool != NULL) {
+    taosCleanUpScheduler(tsReadAheadPool);
+    tsReadAheadPool = NULL;
+  }
+}
+
+// Return NULL if the read-ahead is disabled.
+STsdbReadAhead *tsdbNewReadAhead(int64_t budget) {
+  if (tsReadAheadPool == NULL || budget <= 0) return NULL;
+
+  STsdbReadAhead *pReadAhead = (STsdbReadAhead *)calloc(1, sizeof(*pReadAhead));
+  if (pReadAhead == NULL) return NULL;
+
+  pReadAhead->blocks = taosArrayInit(8, POINTER_BYTES);
+  if (pReadAhead->blocks == NULL) {
+    free(pReadAhead);
+    return NULL;
+  }
+
+  pthread_mutex_init(&pReadAhead->mutex, NULL);
+  pthread_cond_init(&pReadAhead->notBusy, NULL);
+  pReadAhead->budget = budget;
+
+  return pReadAhead;
+}
+
+void tsdbFreeReadAhead(STsdbReadAhead *pReadAhead) {
+  if (pReadAhead == NULL) return;
+
+  tsdbResetReadAhead(pReadAhead);
+
+  taosArrayDestroy(&pReadAhead->blocks);
+  pthread_cond_destroy(&pReadAhead->notBusy);
+  pthread_mutex_destroy(&pReadAhead->mutex);
+  free(pReadAhead);
+}
+
+// Wait for the reads in progress and drop all blocks, it must be called before the files are closed.
+void tsdbResetReadAhead(STsdbReadAhead *pReadAhead) {
+  if (pReadAhead == NULL) return;
+
+  pthread_mutex_lock(&pReadAhead->mutex);
+
+  while (pReadAhead->nBusy > 0) {
+    pthread_cond_wait(&pReadAhead->notBusy, &pReadAhead->mutex);
+  }
+
+  for (size_t i = 0; i < taosArrayGetSize(pReadAhead->blocks); ++i) {
+    tsdbDropReadAheadBlock(pReadAhead, taosArrayGetP(pReadAhead->blocks, i));
+  }
+  taosArrayClear(pReadAhead->blocks);
+
+  pthread_mutex_unlock(&pReadAhead->mutex);
+}
+
+/*
+ * Read the statis part of the block and the columns colIds of it in the background, instead of the whole block. Return
+ * false if the budget is used up or the pool is too busy, so that the blocks after it should not be put either. A block
+ * put already is not read again.
+ */
+bool tsdbPutReadAhead(STsdbReadAhead *pReadAhead, SDFile *pDFile, SBlock *pSBlock, int16_t *colIds, int32_t numOfColIds) {
+  if (pReadAhead == NULL) return false;
+
+  int64_t offset = pSBlock->offset;
+  int32_t len = pSBlock->len;
+
+  pthread_mutex_lock(&pReadAhead->mutex);
+
+  for (size_t i = 0; i < taosArrayGetSize(pReadAhead->blocks); ++i) {
+    SReadAheadBlock *pBlock = taosArrayGetP(pReadAhead->blocks, i);
+    if (pBlock->pDFile == pDFile && pBlock->offset == offset) {
+      pthread_mutex_unlock(&pReadAhead->mutex);
+      return true;
+    }
+  }
+
+  if (pReadAhead->size + len > pReadAhead->budget) {
+    pthread_mutex_unlock(&pReadAhead->mutex);
+    return false;
+  }
+
+  // the read-ahead is dropped rather than blocking the query on a full queue of the pool
+  if (atomic_add_fetch_32(&tsReadAheadQueued, 1) > TSDB_READ_AHEAD_QUEUE_SIZE) {
+    atomic_sub_fetch_32(&tsReadAheadQueued, 1);
+    pthread_mutex_unlock(&pReadAhead->mutex);
+    return false;
+  }
+
+  size_t           colSize = sizeof(int16_t) * numOfColIds;
+  size_t           rangeSize = sizeof(SReadAheadRange) * (numOfColIds + 1);
+  SReadAheadBlock *pBlock = (SReadAheadBlock *)malloc(sizeof(*pBlock) + ALIGN8(len) + rangeSize + colSize);
+  if (pBlock == NULL || taosArrayPush(pReadAhead->blocks, &pBlock) == NULL) {
+    atomic_sub_fetch_32(&tsReadAheadQueued, 1);
+    pthread_mutex_unlock(&pReadAhead->mutex);
+    tfree(pBlock);
+    return false;
+  }
+
+  pBlock->pReadAhead = pReadAhead;
+  pBlock->pDFile = pDFile;
+  pBlock->fd = TSDB_FILE_FD(pDFile);
+  pBlock->block = *pSBlock;
+  pBlock->offset = offset;
+  pBlock->len = len;
+  pBlock->ranges = (SReadAheadRange *)POINTER_SHIFT(pBlock->data, ALIGN8(len));
+  pBlock->numOfRanges = 0;
+  pBlock->colIds = (int16_t *)POINTER_SHIFT(pBlock->ranges, rangeSize);
+  pBlock->numOfColIds = numOfColIds;
+  memcpy(pBlock->colIds, colIds, colSize);
+  pBlock->state = TSDB_READ_AHEAD_BUSY;
+  pBlock->dropped = false;
+  pBlock->used = false;
+
+  pReadAhead->size += len;
+  pReadAhead->nBusy += 1;
+
+  pthread_mutex_unlock(&pReadAhead->mutex);
+
+  SSchedMsg msg = {0};
+  msg.fp = tsdbDoReadAhead;
+  msg.ahandle = pBlock;
+  taosScheduleTask(tsReadAheadPool, &msg);
+
+  return true;
+}
+
+/*
+ * Copy the part [offset, offset + size) of the file to buf if it is in a block read ahead, the blocks put before that
+ * block are dropped. Return false if the part should be read from the file.
+ */
+bool tsdbGetReadAhead(STsdbReadAhead *pReadAhead, SDFile *pDFile, int64_t offset, void *buf, int64_t size) {
+  if (pReadAhead == NULL) return false;
+
+  pthread_mutex_lock(&pReadAhead->mutex);
+
+  SReadAheadBlock *pBlock = NULL;
+  size_t           idx = 0;
+  for (; idx < taosArrayGetSize(pReadAhead->blocks); ++idx) {
+    SReadAheadBlock *p = taosArrayGetP(pReadAhead->blocks, idx);
+    if (p->pDFile == pDFile && offset >= p->offset && offset < p->offset + p->len) {
+      pBlock = p;
+      break;
+    }
+  }
+
+  if (pBlock == NULL) {
+    pReadAhead->misses += 1;
+    pthread_mutex_unlock(&pReadAhead->mutex);
+    return false;
+  }
+
+  for (size_t i = 0; i < idx; ++i) {
+    tsdbDropReadAheadBlock(pReadAhead, taosArrayGetP(pReadAhead->blocks, 0));
+    taosArrayRemove(pReadAhead->blocks, 0);
+  }
+
+  while (pBlock->state == TSDB_READ_AHEAD_BUSY) {
+    pthread_cond_wait(&pReadAhead->notBusy, &pReadAhead->mutex);
+  }
+
+  // a column the query does not load in the end is read from the file
+  if (pBlock->state == TSDB_READ_AHEAD_FAILED ||
+      !tsdbReadAheadRangeOf(pBlock, (int32_t)(offset - pBlock->offset), (int32_t)(offset + size - pBlock->offset))) {
+    pReadAhead->misses += 1;
+    pthread_mutex_unlock(&pReadAhead->mutex);
+    return false;
+  }
+
+  pBlock->used = true;
+  pReadAhead->hits += 1;
+
+  pthread_mutex_unlock(&pReadAhead->mutex);
+
+  // only the query drops the blocks which are read already
+  memcpy(buf, pBlock->data + (offset - pBlock->offset), size);
+  return true;
+}
+
+static void tsdbDoReadAhead(SSchedMsg *pMsg) {
+  SReadAheadBlock *pBlock = (SReadAheadBlock *)pMsg->ahandle;
+  STsdbReadAhead * pReadAhead = pBlock->pReadAhead;
+
+  atomic_sub_fetch_32(&tsReadAheadQueued, 1);
+
+  bool read = tsdbReadAheadCols(pBlock);
+
+  pthread_mutex_lock(&pReadAhead->mutex);
+
+  // the query reads the block from the file again, which reports the error if any
+  pBlock->state = read ? TSDB_READ_AHEAD_DONE : TSDB_READ_AHEAD_FAILED;
+  pReadAhead->nBusy -= 1;
+
+  if (pBlock->dropped) {
+    pReadAhead->size -= pBlock->len;
+    free(pBlock);
+  }
+
+  pthread_cond_broadcast(&pReadAhead->notBusy);
+  pthread_mutex_unlock(&pReadAhead->mutex);
+}
+
+/*
+ * Read the statis part with the key column following it, then the other columns of colIds located by the statis part
+ * as tsdbLoadBlockDataCols does. The columns adjacent in the file are read at once. The checksums are verified by the
+ * query when it takes the parts.
+ */
+static bool tsdbReadAheadCols(SReadAheadBlock *pBlock) {
+  SBlock *pSBlock = &pBlock->block;
+  int32_t ssize = (int32_t)tsdbBlockStatisSize(pSBlock->numOfCols, (uint32_t)pSBlock->blkVer);
+
+  tsdbAddReadAheadRange(pBlock, 0, ssize + pSBlock->keyLen);
+
+  // the key column follows the statis part, which is only needed to locate the other columns
+  int32_t nread = 0;  // of the first range
+  if (pBlock->numOfColIds > 1) {
+    nread = pBlock->ranges[0].end;
+    if (nread > pBlock->len || taosPRead(pBlock->fd, pBlock->data, nread, pBlock->offset) != nread) {
+      return false;
+    }
+  }
+
+  SBlockData *pBlkData = (SBlockData *)pBlock->data;
+  SBlockCol   blockCol = {0};
+  SBlockCol * pBlockCol = NULL;
+  int         ccol = 0;
+  for (int32_t i = 0; i < pBlock->numOfColIds; ++i) {
+    int16_t colId = pBlock->colIds[i];
+    if (colId == 0) continue;
+
+    for (pBlockCol = NULL; ccol < pSBlock->numOfCols; ++ccol) {
+      pBlockCol = &blockCol;
+      tsdbGetSBlockCol(pSBlock, &pBlockCol, pBlkData->cols, ccol);
+      if (pBlockCol->colId >= colId) break;
+    }
+
+    if (ccol >= pSBlock->numOfCols || pBlockCol->colId != colId) continue;
+
+    int32_t start = ssize + (int32_t)tsdbGetBlockColOffset(pBlockCol);
+    tsdbAddReadAheadRange(pBlock, start, start + pBlockCol->len);
+    ++ccol;
+  }
+
+  // the first range may be extended by the columns adjacent to the key column
+  for (int32_t i = 0; i < pBlock->numOfRanges; ++i) {
+    int32_t start = (i == 0) ? nread : pBlock->ranges[i].start;
+    int32_t size = pBlock->ranges[i].end - start;
+    if (size <= 0) continue;
+    if (start < 0 || pBlock->ranges[i].end > pBlock->len ||
+        taosPRead(pBlock->fd, pBlock->data + start, size, pBlock->offset + start) != size) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// the columns are mostly in the order of the offsets, a range is merged into the last one if they are adjacent
+static void tsdbAddReadAheadRange(SReadAheadBlock *pBlock, int32_t start, int32_t end) {
+  if (pBlock->numOfRanges > 0) {
+    SReadAheadRange *pLast = &pBlock->ranges[pBlock->numOfRanges - 1];
+    if (start >= pLast->start && start <= pLast->end) {
+      pLast->end = MAX(pLast->end, end);
+      return;
+    }
+  }
+
+  pBlock->ranges[pBlock->numOfRanges].start = start;
+  pBlock->ranges[pBlock->numOfRanges].end = end;
+  pBlock->numOfRanges += 1;
+}
+
+static bool tsdbReadAheadRangeOf(SReadAheadBlock *pBlock, int32_t start, int32_t end) {
+  for (int32_t i = 0; i < pBlock->numOfRanges; ++i) {
+    if (start >= pBlock->ranges[i].start && end <= pBlock->ranges[i].end) return true;
+  }
+
+  return false;
+}
+
+// the mutex is held, the block being read is freed by the worker
+static void tsdbDropReadAheadBlock(STsdbReadAhead *pReadAhead, SReadAheadBlock *pBlock) {
+  if (!pBlock->used) {
+    pReadAhead->wastes += 1;
+  }
+
+  if (pBlock->state == TSDB_READ_AHEAD_BUSY) {
+    pBlock->dropped = true;
+  } else {
+    pReadAhead->size -= pBlock->len;
+    free(pBlock);
+  }
+}
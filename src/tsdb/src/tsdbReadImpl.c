@@ -69,12 +69,15 @@ void tsdbDestroyReadH(SReadH *pReadh) {
   pReadh->pDCols[0] = tdFreeDataCols(pReadh->pDCols[0]);
   pReadh->pDCols[1] = tdFreeDataCols(pReadh->pDCols[1]);
   pReadh->pAggrBlkData = taosTZfree(pReadh->pAggrBlkData);
+  pReadh->pBloomBlkData = taosTZfree(pReadh->pBloomBlkData);
   pReadh->pBlkData = taosTZfree(pReadh->pBlkData);
   pReadh->pBlkInfo = taosTZfree(pReadh->pBlkInfo);
   pReadh->cidx = 0;
   pReadh->pBlkIdx = NULL;
   pReadh->pTable = NULL;
   pReadh->aBlkIdx = taosArrayDestroy(&pReadh->aBlkIdx);
+  tsdbFreeReadAhead(pReadh->pReadAhead);
+  pReadh->pReadAhead = NULL;
   tsdbCloseDFileSet(TSDB_READ_FSET(pReadh));
   pReadh->pRepo = NULL;
 }
@@ -425,20 +428,25 @@ int tsdbLoadBlockDataCols(SReadH *pReadh, SBlock *pBlock, SBlockInfo *pBlkInfo,
 
 static int tsdbLoadBlockStatisFromDFile(SReadH *pReadh, SBlock *pBlock) {
   SDFile *pDFile = (pBlock->last) ? TSDB_READ_LAST_FILE(pReadh) : TSDB_READ_DATA_FILE(pReadh);
-  if (tsdbSeekDFile(pDFile, pBlock->offset, SEEK_SET) < 0) {
-    tsdbError("vgId:%d failed to load block statis part while seek file %s to offset %" PRId64 " since %s",
-              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), (int64_t)pBlock->offset, tstrerror(terrno));
-    return -1;
-  }
-
-  size_t size = tsdbBlockStatisSize(pBlock->numOfCols, (uint32_t)pBlock->blkVer);
+  size_t  size = tsdbBlockStatisSize(pBlock->numOfCols, (uint32_t)pBlock->blkVer);
   if (tsdbMakeRoom((void **)(&(pReadh->pBlkData)), size) < 0) return -1;
 
-  int64_t nread = tsdbReadDFile(pDFile, (void *)(pReadh->pBlkData), size);
-  if (nread < 0) {
-    tsdbError("vgId:%d failed to load block statis part while read file %s since %s, offset:%" PRId64 " len :%" PRIzu,
-              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), tstrerror(terrno), (int64_t)pBlock->offset, size);
-    return -1;
+  int64_t nread = size;
+  if (!tsdbGetReadAhead(pReadh->pReadAhead, pDFile, pBlock->offset, pReadh->pBlkData, size)) {
+    if (tsdbSeekDFile(pDFile, pBlock->offset, SEEK_SET) < 0) {
+      tsdbError("vgId:%d failed to load block statis part while seek file %s to offset %" PRId64 " since %s",
+                TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), (int64_t)pBlock->offset, tstrerror(terrno));
+      return -1;
+    }
+
+    nread = tsdbReadDFile(pDFile, (void *)(pReadh->pBlkData), size);
+    if (nread < 0) {
+      tsdbError("vgId:%d failed to load block statis part while read file %s since %s, offset:%" PRId64
+                " len :%" PRIzu,
+                TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), tstrerror(terrno), (int64_t)pBlock->offset,
+                size);
+      return -1;
+    }
   }
 
   if (nread < size) {
@@ -510,6 +518,72 @@ int tsdbLoadBlockStatis(SReadH *pReadh, SBlock *pBlock) {
   return tsdbLoadBlockStatisFromDFile(pReadh, pBlock);
 }
 
+/**
+ * Load the bloom filter part of a block, which is right behind the aggr part in .smad/.smal.
+ * Return TSDB_STATIS_NONE if the block has no bloom filter.
+ */
+int tsdbLoadBlockBloom(SReadH *pReadh, SBlock *pBlock) {
+  ASSERT(pBlock->numOfSubBlocks <= 1);
+
+  if (pBlock->blkVer < TSDB_SBLK_VER_2 || !pBlock->aggrStat) {
+    return TSDB_STATIS_NONE;
+  }
+
+  SDFile *pDFileAggr = pBlock->last ? TSDB_READ_SMAL_FILE(pReadh) : TSDB_READ_SMAD_FILE(pReadh);
+  int64_t offset = (int64_t)pBlock->aggrOffset + tsdbBlockAggrSize(pBlock->numOfCols, (uint32_t)pBlock->blkVer);
+
+  if (tsdbSeekDFile(pDFileAggr, offset, SEEK_SET) < 0) {
+    tsdbError("vgId:%d failed to load block bloom part while seek file %s to offset %" PRId64 " since %s",
+              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFileAggr), offset, tstrerror(terrno));
+    return -1;
+  }
+
+  size_t size = sizeof(SBloomBlkData);
+  if (tsdbMakeRoom((void **)(&(pReadh->pBloomBlkData)), size) < 0) return -1;
+
+  int64_t nread = tsdbReadDFile(pDFileAggr, (void *)(pReadh->pBloomBlkData), size);
+  if (nread < 0) {
+    tsdbError("vgId:%d failed to load block bloom part while read file %s since %s, offset:%" PRId64 " len :%" PRIzu,
+              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFileAggr), tstrerror(terrno), offset, size);
+    return -1;
+  }
+
+  size_t sizeBloom = pReadh->pBloomBlkData->len;
+  if (nread < size || sizeBloom < size + sizeof(TSCKSUM) || pReadh->pBloomBlkData->numOfCols > pBlock->numOfCols) {
+    terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
+    tsdbError("vgId:%d block bloom part in file %s is corrupted, offset:%" PRId64 " read bytes: %" PRId64
+              " len:%" PRIzu,
+              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFileAggr), offset, nread, sizeBloom);
+    return -1;
+  }
+
+  if (tsdbMakeRoom((void **)(&(pReadh->pBloomBlkData)), sizeBloom) < 0) return -1;
+
+  nread = tsdbReadDFile(pDFileAggr, POINTER_SHIFT(pReadh->pBloomBlkData, size), sizeBloom - size);
+  if (nread < 0) {
+    tsdbError("vgId:%d failed to load block bloom part while read file %s since %s, offset:%" PRId64 " len :%" PRIzu,
+              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFileAggr), tstrerror(terrno), offset, sizeBloom);
+    return -1;
+  }
+
+  if (nread < sizeBloom - size) {
+    terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
+    tsdbError("vgId:%d block bloom part in file %s is corrupted, offset:%" PRId64 " expected bytes:%" PRIzu
+              " read bytes: %" PRId64,
+              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFileAggr), offset, sizeBloom - size, nread);
+    return -1;
+  }
+
+  if (!taosCheckChecksumWhole((uint8_t *)(pReadh->pBloomBlkData), (uint32_t)sizeBloom)) {
+    terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
+    tsdbError("vgId:%d block bloom part in file %s is corrupted since wrong checksum, offset:%" PRId64 " len :%" PRIzu,
+              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFileAggr), offset, sizeBloom);
+    return -1;
+  }
+
+  return TSDB_STATIS_OK;
+}
+
 int tsdbLoadBlockOffset(SReadH *pReadh, SBlock *pBlock) {
   ASSERT(pBlock->numOfSubBlocks <= 1);
   return tsdbLoadBlockStatisFromDFile(pReadh, pBlock);
@@ -605,6 +679,35 @@ void tsdbGetBlockStatis(SReadH *pReadh, SDataStatis *pStatis, int numOfCols, SBl
   }
 }
 
+void tsdbGetBlockBloom(SReadH *pReadh, SDataBloom *pBloom, int numOfCols) {
+  SBloomBlkData *pBloomBlkData = pReadh->pBloomBlkData;
+  uint8_t *      bits = (uint8_t *)POINTER_SHIFT(pBloomBlkData, sizeof(SBloomBlkData) +
+                                                                    sizeof(SBloomBlkCol) * pBloomBlkData->numOfCols);
+
+  for (int i = 0, j = 0; i < numOfCols;) {
+    if (j >= pBloomBlkData->numOfCols) {
+      pBloom[i].len = 0;
+      i++;
+      continue;
+    }
+    SBloomBlkCol *pBloomBlkCol = pBloomBlkData->cols + j;
+    if (pBloom[i].colId == pBloomBlkCol->colId) {
+      pBloom[i].nHash = pBloomBlkCol->nHash;
+      pBloom[i].len = pBloomBlkCol->len;
+      pBloom[i].bits = bits;
+      bits += pBloomBlkCol->len;
+      i++;
+      j++;
+    } else if (pBloom[i].colId < pBloomBlkCol->colId) {
+      pBloom[i].len = 0;
+      i++;
+    } else {
+      bits += pBloomBlkCol->len;
+      j++;
+    }
+  }
+}
+
 static void tsdbResetReadTable(SReadH *pReadh) {
   tdResetDataCols(pReadh->pDCols[0]);
   tdResetDataCols(pReadh->pDCols[1]);
@@ -616,6 +719,7 @@ static void tsdbResetReadTable(SReadH *pReadh) {
 static void tsdbResetReadFile(SReadH *pReadh) {
   tsdbResetReadTable(pReadh);
   taosArrayClear(pReadh->aBlkIdx);
+  tsdbResetReadAhead(pReadh->pReadAhead);
   tsdbCloseDFileSet(TSDB_READ_FSET(pReadh));
 }
 
@@ -845,17 +949,20 @@ static int tsdbLoadColData(SReadH *pReadh, SDFile *pDFile, SBlock *pBlock, SBloc
 
   int64_t offset = pBlock->offset + tsdbBlockStatisSize(pBlock->numOfCols, (uint32_t)pBlock->blkVer) +
                    tsdbGetBlockColOffset(pBlockCol);
-  if (tsdbSeekDFile(pDFile, offset, SEEK_SET) < 0) {
-    tsdbError("vgId:%d failed to load block column data while seek file %s to offset %" PRId64 " since %s",
-              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), offset, tstrerror(terrno));
-    return -1;
-  }
+  int64_t nread = pBlockCol->len;
+  if (!tsdbGetReadAhead(pReadh->pReadAhead, pDFile, offset, TSDB_READ_BUF(pReadh), pBlockCol->len)) {
+    if (tsdbSeekDFile(pDFile, offset, SEEK_SET) < 0) {
+      tsdbError("vgId:%d failed to load block column data while seek file %s to offset %" PRId64 " since %s",
+                TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), offset, tstrerror(terrno));
+      return -1;
+    }
 
-  int64_t nread = tsdbReadDFile(pDFile, TSDB_READ_BUF(pReadh), pBlockCol->len);
-  if (nread < 0) {
-    tsdbError("vgId:%d failed to load block column data while read file %s since %s, offset:%" PRId64 " len :%d",
-              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), tstrerror(terrno), offset, pBlockCol->len);
-    return -1;
+    nread = tsdbReadDFile(pDFile, TSDB_READ_BUF(pReadh), pBlockCol->len);
+    if (nread < 0) {
+      tsdbError("vgId:%d failed to load block column data while read file %s since %s, offset:%" PRId64 " len :%d",
+                TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), tstrerror(terrno), offset, pBlockCol->len);
+      return -1;
+    }
   }
 
   if (nread < pBlockCol->len) {
@@ -17,6 +17,7 @@
 #include "os.h"
 #include "taoserror.h"
 #include "tsdbint.h"
+#include "tmd5.h"
 
 // Sync handle
 typedef struct {
@@ -24,6 +25,10 @@ typedef struct {
   SRtn       rtn;
   SOCKET     socketFd;
   void *     pBuf;
+  void *     pChunk;     // the chunk of file being transferred
+  void *     pDigests;   // the digests of the blocks of the local file of the receiver
+  int64_t    bytes;      // bytes of the files transferred
+  int64_t    sameBytes;  // bytes of the files taken from the local files of the receiver
   bool       mfChanged;
   SMFile *   pmf;
   SMFile     mf;
@@ -32,6 +37,7 @@ typedef struct {
 } SSyncH;
 
 #define SYNC_BUFFER(sh) ((sh)->pBuf)
+#define TSDB_SYNC_TOMB_LEN (sizeof(uint64_t) + sizeof(TSKEY) * 2 + sizeof(uint32_t))  // encoded size of a tombstone
 
 static void    tsdbInitSyncH(SSyncH *pSyncH, STsdbRepo *pRepo, SOCKET socketFd);
 static void    tsdbDestroySyncH(SSyncH *pSyncH);
@@ -39,6 +45,8 @@ static int32_t tsdbSyncSendMeta(SSyncH *pSynch);
 static int32_t tsdbSyncRecvMeta(SSyncH *pSynch);
 static int32_t tsdbSendMetaInfo(SSyncH *pSynch);
 static int32_t tsdbRecvMetaInfo(SSyncH *pSynch);
+static int32_t tsdbSendTombs(SSyncH *pSynch);
+static int32_t tsdbRecvTombs(SSyncH *pSynch);
 static int32_t tsdbSendDecision(SSyncH *pSynch, bool toSend);
 static int32_t tsdbRecvDecision(SSyncH *pSynch, bool *toSend);
 static int32_t tsdbSyncSendDFileSetArray(SSyncH *pSynch);
@@ -48,8 +56,23 @@ static int32_t tsdbSyncSendDFileSet(SSyncH *pSynch, SDFileSet *pSet);
 static int32_t tsdbSendDFileSetInfo(SSyncH *pSynch, SDFileSet *pSet);
 static int32_t tsdbRecvDFileSetInfo(SSyncH *pSynch);
 static int     tsdbReload(STsdbRepo *pRepo, bool isMfChanged);
-
-int32_t tsdbSyncSend(void *tsdb, SOCKET socketFd) {
+static int32_t tsdbSyncSendFile(SSyncH *pSynch, FileFd fd, const char *fname, int64_t offset, int64_t size,
+                                int32_t nDigests);
+static int32_t tsdbSyncRecvFile(SSyncH *pSynch, FileFd fd, const char *fname, int64_t *offset, int64_t size,
+                                FileFd baseFd, int64_t baseLen);
+static int32_t tsdbSyncSendChunk(SSyncH *pSynch, FileFd fd, const char *fname, int64_t offset, int32_t len);
+static int32_t tsdbIsSameBlock(SSyncH *pSynch, FileFd fd, const char *fname, int64_t offset);
+static int32_t tsdbSyncCopyBlocks(SSyncH *pSynch, FileFd fd, const char *fname, FileFd baseFd, int64_t *offset,
+                                  int64_t end);
+static int32_t tsdbSendDigests(SSyncH *pSynch, SDFile *pBase, int64_t size, int64_t *baseLen);
+static int32_t tsdbRecvDigests(SSyncH *pSynch, int64_t size, int32_t *nDigests);
+static int32_t tsdbSendOffsets(SSyncH *pSynch, int64_t *offset, int32_t num);
+static int32_t tsdbRecvOffsets(SSyncH *pSynch, int64_t *offset, int32_t num);
+static STsdbSyncFSet *tsdbAcquireSyncFSet(SSyncH *pSynch, SDFileSet *pRSet, int fidLevel);
+static void    tsdbKeepSyncFSets(STsdbRepo *pRepo);
+static void    tsdbClearSyncFSets(STsdbRepo *pRepo);
+
+int32_t tsdbSyncSend(void *tsdb, SOCKET socketFd, int64_t *bytes) {
   STsdbRepo *pRepo = (STsdbRepo *)tsdb;
   SSyncH     synch = {0};
 
@@ -67,18 +90,25 @@ int32_t tsdbSyncSend(void *tsdb, SOCKET socketFd) {
     goto _err;
   }
 
+  if (tsdbSendTombs(&synch) < 0) {
+    tsdbError("vgId:%d, failed to send tombstones since %s", REPO_ID(pRepo), tstrerror(terrno));
+    goto _err;
+  }
+
   // Enable TSDB commit
   tsem_post(&(pRepo->readyToCommit));
   tsdbDestroySyncH(&synch);
+  *bytes = synch.bytes;
   return 0;
 
 _err:
   tsem_post(&(pRepo->readyToCommit));
   tsdbDestroySyncH(&synch);
+  *bytes = synch.bytes;
   return -1;
 }
 
-int32_t tsdbSyncRecv(void *tsdb, SOCKET socketFd) {
+int32_t tsdbSyncRecv(void *tsdb, SOCKET socketFd, int64_t *bytes) {
   STsdbRepo *pRepo = (STsdbRepo *)tsdb;
   SSyncH synch = {0};
 
@@ -98,9 +128,16 @@ int32_t tsdbSyncRecv(void *tsdb, SOCKET socketFd) {
     goto _err;
   }
 
+  if (tsdbRecvTombs(&synch) < 0) {
+    tsdbError("vgId:%d, failed to recv tombstones since %s", REPO_ID(pRepo), tstrerror(terrno));
+    goto _err;
+  }
+
   tsdbEndFSTxn(pRepo);
+  tsdbClearSyncFSets(pRepo);
   tsem_post(&(pRepo->readyToCommit));
   tsdbDestroySyncH(&synch);
+  *bytes = synch.bytes;
 
   // Reload file change
   tsdbReload(pRepo, synch.mfChanged);
@@ -108,19 +145,27 @@ int32_t tsdbSyncRecv(void *tsdb, SOCKET socketFd) {
   return 0;
 
 _err:
+  tsdbKeepSyncFSets(pRepo);
   tsdbEndFSTxnWithError(REPO_FS(pRepo));
   tsem_post(&(pRepo->readyToCommit));
   tsdbDestroySyncH(&synch);
+  *bytes = synch.bytes;
   return -1;
 }
 
+void tsdbFreeSyncFSets(SArray *pSyncFSets) { taosArrayDestroy(&pSyncFSets); }
+
 static void tsdbInitSyncH(SSyncH *pSyncH, STsdbRepo *pRepo, SOCKET socketFd) {
   pSyncH->pRepo = pRepo;
   pSyncH->socketFd = socketFd;
   tsdbGetRtnSnap(pRepo, &(pSyncH->rtn));
 }
 
-static void tsdbDestroySyncH(SSyncH *pSyncH) { taosTZfree(pSyncH->pBuf); }
+static void tsdbDestroySyncH(SSyncH *pSyncH) {
+  taosTZfree(pSyncH->pBuf);
+  taosTZfree(pSyncH->pChunk);
+  taosTZfree(pSyncH->pDigests);
+}
 
 static int32_t tsdbSyncSendMeta(SSyncH *pSynch) {
   STsdbRepo *pRepo = pSynch->pRepo;
@@ -155,11 +200,8 @@ static int32_t tsdbSyncSendMeta(SSyncH *pSynch) {
     int64_t writeLen = mf.info.size;
     tsdbInfo("vgId:%d, metafile:%s will be sent, size:%" PRId64, REPO_ID(pRepo), mf.f.aname, writeLen);
 
-    int64_t ret = taosSendFile(pSynch->socketFd, TSDB_FILE_FD(&mf), 0, writeLen);
-    if (ret != writeLen) {
-      terrno = TAOS_SYSTEM_ERROR(errno);
-      tsdbError("vgId:%d, failed to send metafile since %s, ret:%" PRId64 " writeLen:%" PRId64, REPO_ID(pRepo),
-                tstrerror(terrno), ret, writeLen);
+    if (tsdbSyncSendFile(pSynch, TSDB_FILE_FD(&mf), mf.f.aname, 0, writeLen, 0) < 0) {
+      tsdbError("vgId:%d, failed to send metafile since %s", REPO_ID(pRepo), tstrerror(terrno));
       tsdbCloseMFile(&mf);
       return -1;
     }
@@ -218,11 +260,9 @@ static int32_t tsdbSyncRecvMeta(SSyncH *pSynch) {
     tsdbInfo("vgId:%d, metafile:%s is created", REPO_ID(pRepo), mf.f.aname);
 
     int64_t readLen = pSynch->pmf->info.size;
-    int64_t ret = taosCopyFds(pSynch->socketFd, TSDB_FILE_FD(&mf), readLen);
-    if (ret != readLen) {
-      terrno = TAOS_SYSTEM_ERROR(errno);
-      tsdbError("vgId:%d, failed to recv metafile since %s, ret:%" PRId64 " readLen:%" PRId64, REPO_ID(pRepo),
-                tstrerror(terrno), ret, readLen);
+    int64_t offset = 0;
+    if (tsdbSyncRecvFile(pSynch, TSDB_FILE_FD(&mf), mf.f.aname, &offset, readLen, -1, 0) < 0) {
+      tsdbError("vgId:%d, failed to recv metafile since %s", REPO_ID(pRepo), tstrerror(terrno));
       tsdbCloseMFile(&mf);
       tsdbRemoveMFile(&mf);
       return -1;
@@ -327,6 +367,94 @@ static int32_t tsdbRecvMetaInfo(SSyncH *pSynch) {
   return 0;
 }
 
+// The rows deleted but still in the files sent are dropped by the tombstones, so they are sent along with the files
+static int32_t tsdbSendTombs(SSyncH *pSynch) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  SArray *   pTombs = pRepo->fs->cstatus->tombs;
+  uint32_t   tlen = tsdbEncodeTombArray(NULL, pTombs) + sizeof(TSCKSUM);
+
+  if (tsdbMakeRoom((void **)(&SYNC_BUFFER(pSynch)), tlen + sizeof(tlen)) < 0) {
+    tsdbError("vgId:%d, failed to makeroom while send tombstones since %s", REPO_ID(pRepo), tstrerror(terrno));
+    return -1;
+  }
+
+  void *ptr = SYNC_BUFFER(pSynch);
+  taosEncodeFixedU32(&ptr, tlen);
+  void *tptr = ptr;
+  tsdbEncodeTombArray(&ptr, pTombs);
+  taosCalcChecksumAppend(0, (uint8_t *)tptr, tlen);
+
+  int32_t writeLen = tlen + sizeof(uint32_t);
+  int32_t ret = taosWriteMsg(pSynch->socketFd, SYNC_BUFFER(pSynch), writeLen);
+  if (ret != writeLen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to send tombstones since %s, ret:%d writeLen:%d", REPO_ID(pRepo), tstrerror(terrno),
+              ret, writeLen);
+    return -1;
+  }
+
+  tsdbInfo("vgId:%d, %d tombstones are sent, writeLen:%d", REPO_ID(pRepo), (int32_t)taosArrayGetSize(pTombs),
+           writeLen);
+  return 0;
+}
+
+// The tombstones received replace the local ones, as the files are the ones of the sender now
+static int32_t tsdbRecvTombs(SSyncH *pSynch) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  uint32_t   tlen = 0;
+  uint64_t   size = 0;
+  char       buf[64] = {0};
+
+  int32_t readLen = sizeof(uint32_t);
+  int32_t ret = taosReadMsg(pSynch->socketFd, buf, readLen);
+  if (ret != readLen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to recv tombstones len, ret:%d readLen:%d", REPO_ID(pRepo), ret, readLen);
+    return -1;
+  }
+
+  taosDecodeFixedU32(buf, &tlen);
+  if (tlen < sizeof(uint64_t) + sizeof(TSCKSUM)) {
+    terrno = TSDB_CODE_TDB_MESSED_MSG;
+    tsdbError("vgId:%d, invalid tombstones len:%u", REPO_ID(pRepo), tlen);
+    return -1;
+  }
+
+  if (tsdbMakeRoom((void **)(&SYNC_BUFFER(pSynch)), tlen) < 0) {
+    tsdbError("vgId:%d, failed to makeroom while recv tombstones since %s", REPO_ID(pRepo), tstrerror(terrno));
+    return -1;
+  }
+
+  ret = taosReadMsg(pSynch->socketFd, SYNC_BUFFER(pSynch), tlen);
+  if (ret != tlen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to recv tombstones, ret:%d tlen:%u", REPO_ID(pRepo), ret, tlen);
+    return -1;
+  }
+
+  if (!taosCheckChecksumWhole((uint8_t *)SYNC_BUFFER(pSynch), tlen)) {
+    terrno = TSDB_CODE_TDB_MESSED_MSG;
+    tsdbError("vgId:%d, failed to checksum while recv tombstones since %s", REPO_ID(pRepo), tstrerror(terrno));
+    return -1;
+  }
+
+  // the count decoded has to match the message, each tombstone is a uid, two keys and a version
+  taosDecodeFixedU64(SYNC_BUFFER(pSynch), &size);
+  if (size > tlen || sizeof(uint64_t) + size * TSDB_SYNC_TOMB_LEN + sizeof(TSCKSUM) != tlen) {
+    terrno = TSDB_CODE_TDB_MESSED_MSG;
+    tsdbError("vgId:%d, invalid number of tombstones:%" PRIu64 ", tlen:%u", REPO_ID(pRepo), size, tlen);
+    return -1;
+  }
+
+  if (tsdbDecodeTombArray(SYNC_BUFFER(pSynch), pRepo->fs->nstatus->tombs) == NULL) {
+    tsdbError("vgId:%d, failed to decode tombstones since %s", REPO_ID(pRepo), tstrerror(terrno));
+    return -1;
+  }
+
+  tsdbInfo("vgId:%d, %" PRIu64 " tombstones are received, tlen:%u", REPO_ID(pRepo), size, tlen);
+  return 0;
+}
+
 static int32_t tsdbSendDecision(SSyncH *pSynch, bool toSend) {
   STsdbRepo *pRepo = pSynch->pRepo;
   uint8_t    decision = toSend;
@@ -446,62 +574,93 @@ static int32_t tsdbSyncRecvDFileSetArray(SSyncH *pSynch) {
           }
           // Next loop
           continue;
+        }
+
+        STsdbSyncFSet *pSyncFSet = tsdbAcquireSyncFSet(pSynch, pSynch->pdf, fidLevel);
+        if (pSyncFSet == NULL) {
+          tsdbError("vgId:%d, failed to acquire fileset:%d since %s", REPO_ID(pRepo), pSynch->pdf->fid,
+                    tstrerror(terrno));
+          return -1;
+        }
+
+        SDFileSet *pSet = &(pSyncFSet->lset);
+        bool       toRecv = false;
+        for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSynch->pdf); ftype++) {
+          if (pSyncFSet->offset[ftype] < TSDB_DFILE_IN_SET(pSynch->pdf, ftype)->info.size) toRecv = true;
+        }
+
+        if (!toRecv) {
+          // All received by the last sync
+          tsdbInfo("vgId:%d, fileset:%d is received by the last sync", REPO_ID(pRepo), pSynch->pdf->fid);
+          if (tsdbSendDecision(pSynch, false) < 0) {
+            tsdbError("vgId:%d, failed to send decision since %s", REPO_ID(pRepo), tstrerror(terrno));
+            return -1;
+          }
         } else {
           tsdbInfo("vgId:%d, fileset:%d will be received", REPO_ID(pRepo), pSynch->pdf->fid);
-          // Notify remote to send there file here
-          if (tsdbSendDecision(pSynch, true) < 0) {
+          // Notify remote to send there file here, from the offsets received already
+          if (tsdbSendDecision(pSynch, true) < 0 ||
+              tsdbSendOffsets(pSynch, pSyncFSet->offset, tsdbGetNFiles(pSynch->pdf)) < 0) {
             tsdbError("vgId:%d, failed to send decision since %s", REPO_ID(pRepo), tstrerror(terrno));
             return -1;
           }
-        }
-
-        // Create local files and copy from remote
-        SDiskID   did;
-        SDFileSet fset = {0};
 
-        tfsAllocDisk(fidLevel, &(did.level), &(did.id));
-        if (did.level == TFS_UNDECIDED_LEVEL) {
-          terrno = TSDB_CODE_TDB_NO_AVAIL_DISK;
-          tsdbError("vgId:%d, failed allc disk since %s", REPO_ID(pRepo), tstrerror(terrno));
-          return -1;
-        }
+          if (tsdbOpenDFileSet(pSet, O_WRONLY) < 0) {
+            tsdbError("vgId:%d, failed to open fileset:%d since %s", REPO_ID(pRepo), pSet->fid, tstrerror(terrno));
+            return -1;
+          }
 
-        tsdbInitDFileSet(&fset, did, REPO_ID(pRepo), pSynch->pdf->fid, FS_TXN_VERSION(pfs), pSynch->pdf->ver);
+          for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSynch->pdf); ftype++) {
+            SDFile *pDFile = TSDB_DFILE_IN_SET(pSet, ftype);          // local file
+            SDFile *pRDFile = TSDB_DFILE_IN_SET(pSynch->pdf, ftype);  // remote file
+
+            tsdbInfo("vgId:%d, file:%s will be received, offset:%" PRId64 " rsize:%" PRIu64, REPO_ID(pRepo),
+                     pDFile->f.aname, pSyncFSet->offset[ftype], pRDFile->info.size);
+
+            // The local file of the same fid is the base of the remote one, the blocks same in both are not sent
+            SDFile  base;
+            SDFile *pBase = NULL;
+            int64_t baseLen = 0;
+            if (pLSet && pLSet->fid == pSet->fid && ftype < tsdbGetNFiles(pLSet) && tsdbFSetIsOk(pLSet)) {
+              base = *TSDB_DFILE_IN_SET(pLSet, ftype);
+              if (tsdbOpenDFile(&base, O_RDONLY) == 0) {
+                pBase = &base;
+              } else {
+                tsdbWarn("vgId:%d, failed to open file:%s as the base since %s", REPO_ID(pRepo), base.f.aname,
+                         tstrerror(terrno));
+              }
+            }
+
+            int64_t sameBytes = pSynch->sameBytes;
+            if (tsdbSendDigests(pSynch, pBase, pRDFile->info.size, &baseLen) < 0 ||
+                tsdbSyncRecvFile(pSynch, TSDB_FILE_FD(pDFile), pDFile->f.aname, &(pSyncFSet->offset[ftype]),
+                                 pRDFile->info.size, pBase ? TSDB_FILE_FD(pBase) : -1, baseLen) < 0) {
+              // The received chunks are kept for the next sync
+              tsdbError("vgId:%d, failed to recv file:%s since %s, offset:%" PRId64, REPO_ID(pRepo), pDFile->f.aname,
+                        tstrerror(terrno), pSyncFSet->offset[ftype]);
+              if (pBase) tsdbCloseDFile(pBase);
+              tsdbCloseDFileSet(pSet);
+              return -1;
+            }
+
+            if (pBase) tsdbCloseDFile(pBase);
+            tsdbInfo("vgId:%d, file:%s is received, size:%" PRIu64 " same as local:%" PRId64, REPO_ID(pRepo),
+                     pDFile->f.aname, pRDFile->info.size, pSynch->sameBytes - sameBytes);
+          }
 
-        // Create new FSET
-        if (tsdbCreateDFileSet(&fset, false) < 0) {
-          tsdbError("vgId:%d, failed to create fileset since %s", REPO_ID(pRepo), tstrerror(terrno));
-          return -1;
+          tsdbCloseDFileSet(pSet);
         }
 
+        // Update new file info
         for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSynch->pdf); ftype++) {
-          SDFile *pDFile = TSDB_DFILE_IN_SET(&fset, ftype);         // local file
-          SDFile *pRDFile = TSDB_DFILE_IN_SET(pSynch->pdf, ftype);  // remote file
-
-          tsdbInfo("vgId:%d, file:%s will be received, osize:%" PRIu64 " rsize:%" PRIu64, REPO_ID(pRepo),
-                   pDFile->f.aname, pDFile->info.size, pRDFile->info.size);
-
-          int64_t writeLen = pRDFile->info.size;
-          int64_t ret = taosCopyFds(pSynch->socketFd, pDFile->fd, writeLen);
-          if (ret != writeLen) {
-            terrno = TAOS_SYSTEM_ERROR(errno);
-            tsdbError("vgId:%d, failed to recv file:%s since %s, ret:%" PRId64 " writeLen:%" PRId64, REPO_ID(pRepo),
-                      pDFile->f.aname, tstrerror(terrno), ret, writeLen);
-            tsdbCloseDFileSet(&fset);
-            tsdbRemoveDFileSet(&fset);
-            return -1;
-          }
-
-          // Update new file info
-          pDFile->info = pRDFile->info;
-          tsdbInfo("vgId:%d, file:%s is received, size:%" PRId64, REPO_ID(pRepo), pDFile->f.aname, writeLen);
+          TSDB_DFILE_IN_SET(pSet, ftype)->info = TSDB_DFILE_IN_SET(pSynch->pdf, ftype)->info;
         }
 
-        tsdbCloseDFileSet(&fset);
-        if (tsdbUpdateDFileSet(pfs, &fset) < 0) {
-          tsdbInfo("vgId:%d, fileset:%d failed to update since %s", REPO_ID(pRepo), fset.fid, tstrerror(terrno));
+        if (tsdbUpdateDFileSet(pfs, pSet) < 0) {
+          tsdbInfo("vgId:%d, fileset:%d failed to update since %s", REPO_ID(pRepo), pSet->fid, tstrerror(terrno));
           return -1;
         }
+        pSyncFSet->used = true;
 
         tsdbInfo("vgId:%d, fileset:%d is received", REPO_ID(pRepo), pSynch->pdf->fid);
       }
@@ -593,6 +752,13 @@ static int32_t tsdbSyncSendDFileSet(SSyncH *pSynch, SDFileSet *pSet) {
   }
 
   if (toSend) {
+    int64_t offset[TSDB_FILE_MAX] = {0};
+    if (tsdbRecvOffsets(pSynch, offset, tsdbGetNFiles(pSet)) < 0) {
+      tsdbError("vgId:%d, failed to recv offsets while send fileset:%d since %s", REPO_ID(pRepo), pSet->fid,
+                tstrerror(terrno));
+      return -1;
+    }
+
     tsdbInfo("vgId:%d, fileset:%d will be sent", REPO_ID(pRepo), pSet->fid);
 
     for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSet); ftype++) {
@@ -604,13 +770,18 @@ static int32_t tsdbSyncSendDFileSet(SSyncH *pSynch, SDFileSet *pSet) {
       }
 
       int64_t writeLen = df.info.size;
-      tsdbInfo("vgId:%d, file:%s will be sent, size:%" PRId64, REPO_ID(pRepo), df.f.aname, writeLen);
+      tsdbInfo("vgId:%d, file:%s will be sent, size:%" PRId64 " offset:%" PRId64, REPO_ID(pRepo), df.f.aname, writeLen,
+               offset[ftype]);
+
+      int32_t nDigests = 0;
+      if (tsdbRecvDigests(pSynch, writeLen, &nDigests) < 0) {
+        tsdbError("vgId:%d, failed to recv digests of file:%s since %s", REPO_ID(pRepo), df.f.aname, tstrerror(terrno));
+        tsdbCloseDFile(&df);
+        return -1;
+      }
 
-      int64_t ret = taosSendFile(pSynch->socketFd, TSDB_FILE_FD(&df), 0, writeLen);
-      if (ret != writeLen) {
-        terrno = TAOS_SYSTEM_ERROR(errno);
-        tsdbError("vgId:%d, failed to send file:%s since %s, ret:%" PRId64 " writeLen:%" PRId64, REPO_ID(pRepo),
-                  df.f.aname, tstrerror(terrno), ret, writeLen);
+      if (tsdbSyncSendFile(pSynch, TSDB_FILE_FD(&df), df.f.aname, offset[ftype], writeLen, nDigests) < 0) {
+        tsdbError("vgId:%d, failed to send file:%s since %s", REPO_ID(pRepo), df.f.aname, tstrerror(terrno));
         tsdbCloseDFile(&df);
         return -1;
       }
@@ -724,4 +895,459 @@ static int tsdbReload(STsdbRepo *pRepo, bool isMfChanged) {
   }
 
   return 0;
-}
\ No newline at end of file
+}
+
+/*
+ * Send the part [offset, size) of the file in chunks. Each chunk is checksummed and sent with its head, the data is
+ * sent from the page cache by sendfile. The blocks same as the ones of the local file of the receiver, given by the
+ * digests, are skipped, the head of the next chunk tells the receiver where to go on.
+ */
+static int32_t tsdbSyncSendFile(SSyncH *pSynch, FileFd fd, const char *fname, int64_t offset, int64_t size,
+                                int32_t nDigests) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  int64_t    digestEnd = (int64_t)nDigests * TSDB_SYNC_BLOCK_SIZE;
+  bool       skipped = false;
+
+  if (offset < 0 || offset > size) {
+    terrno = TSDB_CODE_TDB_MESSED_MSG;
+    tsdbError("vgId:%d, invalid offset:%" PRId64 " of file:%s, size:%" PRId64, REPO_ID(pRepo), offset, fname, size);
+    return -1;
+  }
+
+  while (offset < size) {
+    int64_t end = MIN(size, offset + TSDB_SYNC_CHUNK_SIZE);
+
+    if (offset < digestEnd) {
+      if (offset % TSDB_SYNC_BLOCK_SIZE == 0 && offset + TSDB_SYNC_BLOCK_SIZE <= size) {
+        int32_t same = tsdbIsSameBlock(pSynch, fd, fname, offset);
+        if (same < 0) return -1;
+        if (same) {
+          offset += TSDB_SYNC_BLOCK_SIZE;
+          skipped = true;
+          continue;
+        }
+      }
+
+      // The chunk ends before the next block same as the receiver
+      end = (offset / TSDB_SYNC_BLOCK_SIZE + 1) * TSDB_SYNC_BLOCK_SIZE;
+      while (end < size && end < digestEnd && end - offset < TSDB_SYNC_CHUNK_SIZE) {
+        if (end + TSDB_SYNC_BLOCK_SIZE <= size) {
+          int32_t same = tsdbIsSameBlock(pSynch, fd, fname, end);
+          if (same < 0) return -1;
+          if (same) break;
+        }
+        end += TSDB_SYNC_BLOCK_SIZE;
+      }
+      end = MIN(end, size);
+    }
+
+    if (tsdbSyncSendChunk(pSynch, fd, fname, offset, (int32_t)(end - offset)) < 0) return -1;
+
+    offset = end;
+    skipped = false;
+  }
+
+  // The blocks at the end are skipped, an empty chunk tells the receiver to take them
+  if (skipped && tsdbSyncSendChunk(pSynch, fd, fname, size, 0) < 0) return -1;
+
+  return 0;
+}
+
+static int32_t tsdbSyncSendChunk(SSyncH *pSynch, FileFd fd, const char *fname, int64_t offset, int32_t len) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  TSCKSUM    cksum = 0;
+
+  if (len > 0) {
+    if (tsdbMakeRoom(&(pSynch->pChunk), len) < 0) return -1;
+
+    int64_t nread = taosPRead(fd, pSynch->pChunk, len, offset);
+    if (nread != len) {
+      terrno = (nread < 0) ? TAOS_SYSTEM_ERROR(errno) : TSDB_CODE_TDB_FILE_CORRUPTED;
+      tsdbError("vgId:%d, failed to read file:%s since %s, offset:%" PRId64 " len:%d nread:%" PRId64, REPO_ID(pRepo),
+                fname, tstrerror(terrno), offset, len, nread);
+      return -1;
+    }
+
+    cksum = taosCalcChecksum(0, (uint8_t *)pSynch->pChunk, len);
+  }
+
+  char  head[TSDB_SYNC_CHUNK_HEAD_SIZE];
+  void *ptr = head;
+  taosEncodeFixedI64(&ptr, offset);
+  taosEncodeFixedI32(&ptr, len);
+  taosEncodeFixedU32(&ptr, cksum);
+
+  if (taosWriteMsg(pSynch->socketFd, head, sizeof(head)) != sizeof(head)) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to send chunk head of file:%s since %s", REPO_ID(pRepo), fname, tstrerror(terrno));
+    return -1;
+  }
+
+  if (len == 0) return 0;
+
+  // The chunk is in the page cache after being checksummed
+  int64_t toffset = offset;
+  int64_t ret = taosSendFile(pSynch->socketFd, fd, &toffset, len);
+  if (ret != len) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to send file:%s since %s, offset:%" PRId64 " ret:%" PRId64 " len:%d", REPO_ID(pRepo),
+              fname, tstrerror(terrno), offset, ret, len);
+    return -1;
+  }
+
+  pSynch->bytes += len;
+  return 0;
+}
+
+// Return 1 if the block at offset is same as the one of the receiver, 0 if not, -1 if failed to read
+static int32_t tsdbIsSameBlock(SSyncH *pSynch, FileFd fd, const char *fname, int64_t offset) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  T_MD5_CTX  context;
+
+  if (tsdbMakeRoom(&(pSynch->pChunk), TSDB_SYNC_BLOCK_SIZE) < 0) return -1;
+
+  int64_t nread = taosPRead(fd, pSynch->pChunk, TSDB_SYNC_BLOCK_SIZE, offset);
+  if (nread != TSDB_SYNC_BLOCK_SIZE) {
+    terrno = (nread < 0) ? TAOS_SYSTEM_ERROR(errno) : TSDB_CODE_TDB_FILE_CORRUPTED;
+    tsdbError("vgId:%d, failed to read file:%s since %s, offset:%" PRId64 " nread:%" PRId64, REPO_ID(pRepo), fname,
+              tstrerror(terrno), offset, nread);
+    return -1;
+  }
+
+  tMD5Init(&context);
+  tMD5Update(&context, (uint8_t *)pSynch->pChunk, TSDB_SYNC_BLOCK_SIZE);
+  tMD5Final(&context);
+
+  char *digest = POINTER_SHIFT(pSynch->pDigests, (offset / TSDB_SYNC_BLOCK_SIZE) * TSDB_SYNC_DIGEST_SIZE);
+  return memcmp(context.digest, digest, TSDB_SYNC_DIGEST_SIZE) == 0;
+}
+
+/*
+ * Receive the part [*offset, size) of the file in chunks. A chunk is written only if its checksum is right, and *offset
+ * is moved forward once it is written, so a failed transfer can go on from *offset. The blocks skipped by the sender
+ * are copied from the part [0, baseLen) of the base file.
+ */
+static int32_t tsdbSyncRecvFile(SSyncH *pSynch, FileFd fd, const char *fname, int64_t *offset, int64_t size,
+                                FileFd baseFd, int64_t baseLen) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+
+  if (*offset < size && taosLSeek(fd, *offset, SEEK_SET) < 0) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to seek file:%s since %s", REPO_ID(pRepo), fname, tstrerror(terrno));
+    return -1;
+  }
+
+  while (*offset < size) {
+    char    head[TSDB_SYNC_CHUNK_HEAD_SIZE];
+    int64_t coffset = 0;
+    int32_t len = 0;
+    TSCKSUM cksum = 0;
+
+    if (taosReadMsg(pSynch->socketFd, head, sizeof(head)) != sizeof(head)) {
+      terrno = TAOS_SYSTEM_ERROR(errno);
+      tsdbError("vgId:%d, failed to recv chunk head of file:%s since %s", REPO_ID(pRepo), fname, tstrerror(terrno));
+      return -1;
+    }
+
+    void *ptr = head;
+    ptr = taosDecodeFixedI64(ptr, &coffset);
+    ptr = taosDecodeFixedI32(ptr, &len);
+    taosDecodeFixedU32(ptr, &cksum);
+
+    if (coffset < *offset || len < 0 || len > TSDB_SYNC_CHUNK_SIZE || coffset + len > size ||
+        (len == 0 && coffset != size)) {
+      terrno = TSDB_CODE_TDB_MESSED_MSG;
+      tsdbError("vgId:%d, invalid chunk of file:%s, offset:%" PRId64 " len:%d expected offset:%" PRId64
+                " size:%" PRId64, REPO_ID(pRepo), fname, coffset, len, *offset, size);
+      return -1;
+    }
+
+    // The blocks skipped are same as the base file
+    if (coffset > *offset) {
+      if (*offset % TSDB_SYNC_BLOCK_SIZE != 0 || coffset % TSDB_SYNC_BLOCK_SIZE != 0 || coffset > baseLen) {
+        terrno = TSDB_CODE_TDB_MESSED_MSG;
+        tsdbError("vgId:%d, invalid blocks skipped of file:%s, from:%" PRId64 " to:%" PRId64 " base:%" PRId64,
+                  REPO_ID(pRepo), fname, *offset, coffset, baseLen);
+        return -1;
+      }
+
+      if (tsdbSyncCopyBlocks(pSynch, fd, fname, baseFd, offset, coffset) < 0) return -1;
+    }
+
+    if (len == 0) break;
+
+    if (tsdbMakeRoom(&(pSynch->pChunk), len) < 0) return -1;
+
+    if (taosReadMsg(pSynch->socketFd, pSynch->pChunk, len) != len) {
+      terrno = TAOS_SYSTEM_ERROR(errno);
+      tsdbError("vgId:%d, failed to recv chunk of file:%s since %s, offset:%" PRId64 " len:%d", REPO_ID(pRepo), fname,
+                tstrerror(terrno), coffset, len);
+      return -1;
+    }
+
+    if (taosCalcChecksum(0, (uint8_t *)pSynch->pChunk, len) != cksum) {
+      terrno = TSDB_CODE_TDB_MESSED_MSG;
+      tsdbError("vgId:%d, failed to checksum chunk of file:%s, offset:%" PRId64 " len:%d", REPO_ID(pRepo), fname,
+                coffset, len);
+      return -1;
+    }
+
+    if (taosWrite(fd, pSynch->pChunk, len) != len) {
+      terrno = TAOS_SYSTEM_ERROR(errno);
+      tsdbError("vgId:%d, failed to write file:%s since %s, offset:%" PRId64 " len:%d", REPO_ID(pRepo), fname,
+                tstrerror(terrno), coffset, len);
+      return -1;
+    }
+
+    *offset += len;
+    pSynch->bytes += len;
+  }
+
+  return 0;
+}
+
+// Copy the part [*offset, end) of the base file to the file, *offset is moved forward as the copy goes
+static int32_t tsdbSyncCopyBlocks(SSyncH *pSynch, FileFd fd, const char *fname, FileFd baseFd, int64_t *offset,
+                                  int64_t end) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+
+  while (*offset < end) {
+    int32_t len = (int32_t)MIN(end - *offset, TSDB_SYNC_CHUNK_SIZE);
+    if (tsdbMakeRoom(&(pSynch->pChunk), len) < 0) return -1;
+
+    int64_t nread = taosPRead(baseFd, pSynch->pChunk, len, *offset);
+    if (nread != len) {
+      terrno = (nread < 0) ? TAOS_SYSTEM_ERROR(errno) : TSDB_CODE_TDB_FILE_CORRUPTED;
+      tsdbError("vgId:%d, failed to read the base of file:%s since %s, offset:%" PRId64 " len:%d", REPO_ID(pRepo),
+                fname, tstrerror(terrno), *offset, len);
+      return -1;
+    }
+
+    if (taosWrite(fd, pSynch->pChunk, len) != len) {
+      terrno = TAOS_SYSTEM_ERROR(errno);
+      tsdbError("vgId:%d, failed to write file:%s since %s, offset:%" PRId64 " len:%d", REPO_ID(pRepo), fname,
+                tstrerror(terrno), *offset, len);
+      return -1;
+    }
+
+    *offset += len;
+    pSynch->sameBytes += len;
+  }
+
+  return 0;
+}
+
+// Send the digests of the whole blocks of the base file within the size of the remote file, none if there is no base
+static int32_t tsdbSendDigests(SSyncH *pSynch, SDFile *pBase, int64_t size, int64_t *baseLen) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  int32_t    nDigests = (pBase == NULL) ? 0 : (int32_t)(MIN(pBase->info.size, size) / TSDB_SYNC_BLOCK_SIZE);
+  int64_t    end = (int64_t)nDigests * TSDB_SYNC_BLOCK_SIZE;
+  int32_t    tlen = sizeof(int32_t) + nDigests * TSDB_SYNC_DIGEST_SIZE;
+
+  if (tsdbMakeRoom(&(pSynch->pDigests), tlen) < 0) return -1;
+
+  void *ptr = pSynch->pDigests;
+  taosEncodeFixedI32(&ptr, nDigests);
+
+  for (int64_t offset = 0; offset < end; offset += TSDB_SYNC_BLOCK_SIZE) {
+    if (offset % TSDB_SYNC_CHUNK_SIZE == 0) {
+      int32_t len = (int32_t)MIN(end - offset, TSDB_SYNC_CHUNK_SIZE);
+      if (tsdbMakeRoom(&(pSynch->pChunk), len) < 0) return -1;
+
+      int64_t nread = taosPRead(TSDB_FILE_FD(pBase), pSynch->pChunk, len, offset);
+      if (nread != len) {
+        terrno = (nread < 0) ? TAOS_SYSTEM_ERROR(errno) : TSDB_CODE_TDB_FILE_CORRUPTED;
+        tsdbError("vgId:%d, failed to read file:%s since %s, offset:%" PRId64 " len:%d", REPO_ID(pRepo),
+                  pBase->f.aname, tstrerror(terrno), offset, len);
+        return -1;
+      }
+    }
+
+    T_MD5_CTX context;
+    tMD5Init(&context);
+    tMD5Update(&context, (uint8_t *)POINTER_SHIFT(pSynch->pChunk, offset % TSDB_SYNC_CHUNK_SIZE),
+               TSDB_SYNC_BLOCK_SIZE);
+    tMD5Final(&context);
+
+    memcpy(ptr, context.digest, TSDB_SYNC_DIGEST_SIZE);
+    ptr = POINTER_SHIFT(ptr, TSDB_SYNC_DIGEST_SIZE);
+  }
+
+  if (taosWriteMsg(pSynch->socketFd, pSynch->pDigests, tlen) != tlen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to send %d digests since %s", REPO_ID(pRepo), nDigests, tstrerror(terrno));
+    return -1;
+  }
+
+  *baseLen = end;
+  return 0;
+}
+
+// Receive the digests of the blocks of the base file of the remote, no more than the blocks of the file of the size
+static int32_t tsdbRecvDigests(SSyncH *pSynch, int64_t size, int32_t *nDigests) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  char       buf[sizeof(int32_t)];
+
+  if (taosReadMsg(pSynch->socketFd, buf, sizeof(buf)) != sizeof(buf)) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to recv the number of digests since %s", REPO_ID(pRepo), tstrerror(terrno));
+    return -1;
+  }
+
+  taosDecodeFixedI32(buf, nDigests);
+  if (*nDigests < 0 || (int64_t)(*nDigests) > size / TSDB_SYNC_BLOCK_SIZE) {
+    terrno = TSDB_CODE_TDB_MESSED_MSG;
+    tsdbError("vgId:%d, invalid number of digests:%d, file size:%" PRId64, REPO_ID(pRepo), *nDigests, size);
+    return -1;
+  }
+
+  int32_t tlen = *nDigests * TSDB_SYNC_DIGEST_SIZE;
+  if (tlen > 0 && tsdbMakeRoom(&(pSynch->pDigests), tlen) < 0) return -1;
+
+  if (taosReadMsg(pSynch->socketFd, pSynch->pDigests, tlen) != tlen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to recv %d digests since %s", REPO_ID(pRepo), *nDigests, tstrerror(terrno));
+    return -1;
+  }
+
+  return 0;
+}
+
+static int32_t tsdbSendOffsets(SSyncH *pSynch, int64_t *offset, int32_t num) {
+  char  buf[sizeof(int64_t) * TSDB_FILE_MAX];
+  void *ptr = buf;
+
+  for (int32_t i = 0; i < num; i++) {
+    taosEncodeFixedI64(&ptr, offset[i]);
+  }
+
+  int32_t writeLen = (int32_t)sizeof(int64_t) * num;
+  int32_t ret = taosWriteMsg(pSynch->socketFd, buf, writeLen);
+  if (ret != writeLen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to send offsets, ret:%d writeLen:%d", REPO_ID(pSynch->pRepo), ret, writeLen);
+    return -1;
+  }
+
+  return 0;
+}
+
+static int32_t tsdbRecvOffsets(SSyncH *pSynch, int64_t *offset, int32_t num) {
+  char  buf[sizeof(int64_t) * TSDB_FILE_MAX];
+  void *ptr = buf;
+
+  int32_t readLen = (int32_t)sizeof(int64_t) * num;
+  int32_t ret = taosReadMsg(pSynch->socketFd, buf, readLen);
+  if (ret != readLen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to recv offsets, ret:%d readLen:%d", REPO_ID(pSynch->pRepo), ret, readLen);
+    return -1;
+  }
+
+  for (int32_t i = 0; i < num; i++) {
+    ptr = taosDecodeFixedI64(ptr, &offset[i]);
+  }
+
+  return 0;
+}
+
+/*
+ * Get the local copy of the remote file set. The one received by the last failed sync is returned if the remote file
+ * set is not changed since then, otherwise a new one is created.
+ */
+static STsdbSyncFSet *tsdbAcquireSyncFSet(SSyncH *pSynch, SDFileSet *pRSet, int fidLevel) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  STsdbFS *  pfs = REPO_FS(pRepo);
+
+  if (pRepo->syncFSets == NULL) {
+    pRepo->syncFSets = taosArrayInit(4, sizeof(STsdbSyncFSet));
+    if (pRepo->syncFSets == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return NULL;
+    }
+  }
+
+  for (size_t i = 0; i < taosArrayGetSize(pRepo->syncFSets); i++) {
+    STsdbSyncFSet *pSyncFSet = taosArrayGet(pRepo->syncFSets, i);
+    if (pSyncFSet->rset.fid != pRSet->fid) continue;
+
+    if (pSyncFSet->fsVer == FS_VERSION(pfs) && tsdbIsTowFSetSame(&(pSyncFSet->rset), pRSet)) {
+      tsdbInfo("vgId:%d, fileset:%d received by the last sync is not changed in remote, go on with it", REPO_ID(pRepo), pRSet->fid);
+      return pSyncFSet;
+    }
+
+    // the files of an older version may be taken by a commit since then
+    tsdbInfo("vgId:%d, fileset:%d received by the last sync is out of date, drop it", REPO_ID(pRepo), pRSet->fid);
+    if (pSyncFSet->fsVer == FS_VERSION(pfs)) tsdbRemoveDFileSet(&(pSyncFSet->lset));
+    taosArrayRemove(pRepo->syncFSets, i);
+    break;
+  }
+
+  // Create local files and copy from remote
+  STsdbSyncFSet syncFSet = {0};
+  SDiskID       did;
+
+  tfsAllocDisk(fidLevel, &(did.level), &(did.id));
+  if (did.level == TFS_UNDECIDED_LEVEL) {
+    terrno = TSDB_CODE_TDB_NO_AVAIL_DISK;
+    tsdbError("vgId:%d, failed allc disk since %s", REPO_ID(pRepo), tstrerror(terrno));
+    return NULL;
+  }
+
+  syncFSet.fsVer = FS_VERSION(pfs);
+  syncFSet.rset = *pRSet;
+  tsdbInitDFileSet(&(syncFSet.lset), did, REPO_ID(pRepo), pRSet->fid, FS_TXN_VERSION(pfs), pRSet->ver);
+
+  // Create new FSET
+  if (tsdbCreateDFileSet(&(syncFSet.lset), false) < 0) {
+    tsdbError("vgId:%d, failed to create fileset since %s", REPO_ID(pRepo), tstrerror(terrno));
+    return NULL;
+  }
+  tsdbCloseDFileSet(&(syncFSet.lset));
+
+  STsdbSyncFSet *pSyncFSet = taosArrayPush(pRepo->syncFSets, &syncFSet);
+  if (pSyncFSet == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    tsdbRemoveDFileSet(&(syncFSet.lset));
+    return NULL;
+  }
+
+  return pSyncFSet;
+}
+
+// Keep the files received by the failed sync out of the transaction, so that the next sync goes on with them
+static void tsdbKeepSyncFSets(STsdbRepo *pRepo) {
+  if (pRepo->syncFSets == NULL) return;
+
+  STsdbFS *pfs = REPO_FS(pRepo);
+  size_t   nSets = taosArrayGetSize(pRepo->syncFSets);
+
+  for (size_t i = 0; i < nSets; i++) {
+    STsdbSyncFSet *pSyncFSet = taosArrayGet(pRepo->syncFSets, i);
+    if (pSyncFSet->used) {
+      tsdbExcludeDFileSet(pfs, pSyncFSet->lset.fid);
+      pSyncFSet->used = false;
+    }
+  }
+
+  if (nSets > 0) {
+    tsdbInfo("vgId:%d, %d filesets received are kept for the next sync", REPO_ID(pRepo), (int)nSets);
+  }
+}
+
+// The sync is done, the files received but not used any more are removed
+static void tsdbClearSyncFSets(STsdbRepo *pRepo) {
+  if (pRepo->syncFSets == NULL) return;
+
+  STsdbFS *pfs = REPO_FS(pRepo);
+
+  for (size_t i = 0; i < taosArrayGetSize(pRepo->syncFSets); i++) {
+    STsdbSyncFSet *pSyncFSet = taosArrayGet(pRepo->syncFSets, i);
+    // the files named after an older version may be taken by a commit since then
+    if (!pSyncFSet->used && pSyncFSet->fsVer + 1 == FS_VERSION(pfs)) {
+      tsdbRemoveDFileSet(&(pSyncFSet->lset));
+    }
+  }
+
+  taosArrayClear(pRepo->syncFSets);
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "tsdbint.h"
+
+static int tsdbCompareTomb(const STsdbTomb *pTomb1, const STsdbTomb *pTomb2) {
+  if (pTomb1->uid != pTomb2->uid) return (pTomb1->uid < pTomb2->uid) ? -1 : 1;
+  if (pTomb1->skey != pTomb2->skey) return (pTomb1->skey < pTomb2->skey) ? -1 : 1;
+  return 0;
+}
+
+// index of the first tombstone not less than (uid, skey)
+static size_t tsdbTombLowerBound(SArray *pArray, uint64_t uid, TSKEY skey) {
+  STsdbTomb key = {.uid = uid, .skey = skey};
+  size_t    lo = 0;
+  size_t    hi = taosArrayGetSize(pArray);
+
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (tsdbCompareTomb(taosArrayGet(pArray, mid), &key) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+int tsdbEncodeTombArray(void **buf, SArray *pArray) {
+  int      tlen = 0;
+  uint64_t size = (uint64_t)taosArrayGetSize(pArray);
+
+  tlen += taosEncodeFixedU64(buf, size);
+  for (size_t i = 0; i < size; i++) {
+    STsdbTomb *pTomb = taosArrayGet(pArray, i);
+
+    tlen += taosEncodeFixedU64(buf, pTomb->uid);
+    tlen += taosEncodeFixedI64(buf, pTomb->skey);
+    tlen += taosEncodeFixedI64(buf, pTomb->ekey);
+    tlen += taosEncodeFixedU32(buf, pTomb->version);
+  }
+
+  return tlen;
+}
+
+void *tsdbDecodeTombArray(void *buf, SArray *pArray) {
+  uint64_t  size;
+  STsdbTomb tomb;
+
+  taosArrayClear(pArray);
+  buf = taosDecodeFixedU64(buf, &size);
+  for (uint64_t i = 0; i < size; i++) {
+    buf = taosDecodeFixedU64(buf, &(tomb.uid));
+    buf = taosDecodeFixedI64(buf, &(tomb.skey));
+    buf = taosDecodeFixedI64(buf, &(tomb.ekey));
+    buf = taosDecodeFixedU32(buf, &(tomb.version));
+
+    if (taosArrayPush(pArray, &tomb) == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return NULL;
+    }
+  }
+
+  return buf;
+}
+
+int tsdbAddTomb(SArray *pArray, const STsdbTomb *pTomb) {
+  size_t idx = tsdbTombLowerBound(pArray, pTomb->uid, pTomb->skey);
+
+  if (taosArrayInsert(pArray, idx, (void *)pTomb) == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  return 0;
+}
+
+STsdbTomb *tsdbGetTableTombs(SArray *pArray, uint64_t uid, int32_t *num) {
+  size_t size = taosArrayGetSize(pArray);
+  size_t from = tsdbTombLowerBound(pArray, uid, INT64_MIN);
+  size_t to = from;
+
+  while (to < size && ((STsdbTomb *)taosArrayGet(pArray, to))->uid == uid) to++;
+
+  *num = (int32_t)(to - from);
+  return (to > from) ? taosArrayGet(pArray, from) : NULL;
+}
+
+void tsdbDropTableTombs(SArray *pArray, uint64_t uid, TSKEY minKey, TSKEY maxKey) {
+  size_t from = tsdbTombLowerBound(pArray, uid, minKey);
+  size_t to = from;
+
+  while (to < taosArrayGetSize(pArray)) {
+    STsdbTomb *pTomb = taosArrayGet(pArray, to);
+    if (pTomb->uid != uid || pTomb->skey > maxKey) break;
+    to++;
+  }
+
+  if (to == from) return;
+
+  size_t size = taosArrayGetSize(pArray);
+  if (to < size) {
+    memmove(taosArrayGet(pArray, from), taosArrayGet(pArray, to), (size - to) * sizeof(STsdbTomb));
+  }
+  taosArraySetSize(pArray, size - (to - from));
+}
+
+void tsdbDropTombs(SArray *pArray, TSKEY minKey, TSKEY maxKey) {
+  size_t size = taosArrayGetSize(pArray);
+  size_t n = 0;
+
+  for (size_t i = 0; i < size; i++) {
+    STsdbTomb *pTomb = taosArrayGet(pArray, i);
+    if (pTomb->skey >= minKey && pTomb->skey <= maxKey) continue;
+    if (n != i) memcpy(taosArrayGet(pArray, n), pTomb, sizeof(STsdbTomb));
+    n++;
+  }
+
+  taosArraySetSize(pArray, n);
+}
+
+bool tsdbTombsOverlap(const STsdbTomb *pTombs, int32_t num, TSKEY skey, TSKEY ekey) {
+  for (int32_t i = 0; i < num; i++) {
+    if (pTombs[i].skey <= ekey && pTombs[i].ekey >= skey) return true;
+  }
+
+  return false;
+}
+
+bool tsdbTombsCover(const STsdbTomb *pTombs, int32_t num, TSKEY skey, TSKEY ekey) {
+  for (int32_t i = 0; i < num; i++) {
+    if (pTombs[i].skey <= skey && pTombs[i].ekey >= ekey) return true;
+  }
+
+  return false;
+}
+
+int tsdbFilterTombRows(const STsdbTomb *pTombs, int32_t num, SDataCols **ppCols, SDataCols **ppBuf) {
+  SDataCols *pSrc = *ppCols;
+  SDataCols *pDst = *ppBuf;
+  int        delRows = 0;
+
+  if (pSrc->numOfRows <= 0 ||
+      !tsdbTombsOverlap(pTombs, num, dataColsKeyFirst(pSrc), dataColsKeyAt(pSrc, pSrc->numOfRows - 1))) {
+    return 0;
+  }
+
+  tdResetDataCols(pDst);
+  pDst->sversion = pSrc->sversion;
+
+  for (int i = 0; i < pSrc->numOfRows; ++i) {
+    TSKEY key = dataColsKeyAt(pSrc, i);
+    if (tsdbTombsCover(pTombs, num, key, key)) {
+      delRows++;
+      continue;
+    }
+
+    for (int j = 0; j < pSrc->numOfCols; ++j) {
+      if (pSrc->cols[j].len > 0 || pDst->cols[j].len > 0) {
+        dataColAppendVal(pDst->cols + j, tdGetColDataOfRow(pSrc->cols + j, i), pDst->numOfRows, pDst->maxPoints, 0);
+      }
+    }
+    ++pDst->numOfRows;
+  }
+
+  if (delRows > 0) {
+    *ppCols = pDst;
+    *ppBuf = pSrc;
+  }
+
+  return delRows;
+}
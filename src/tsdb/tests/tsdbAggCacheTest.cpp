@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <iostream>
+
+#include "tglobal.h"
+#include "tsdbTestUtil.h"
+
+extern "C" {
+#include "hash.h"
+#include "tlist.h"
+#include "tsdbAggCache.h"
+}
+
+namespace {
+
+const char *aggCacheTestDir = "/tmp/tsdbAggCacheTest";
+
+class TsdbAggCacheTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() {
+    tsBlockAggCacheSize = 16;
+    ASSERT_EQ(tsdbTestInitEnv(aggCacheTestDir), 0);
+  }
+
+  static void TearDownTestCase() {
+    tsdbTestCleanupEnv(aggCacheTestDir);
+    tsBlockAggCacheSize = 0;
+  }
+};
+
+const int32_t  tid = 1;
+const uint64_t uid = 1000001;
+const int32_t  numOfRows = 100000;
+
+int32_t getInt(STsdbAggCache *pCache, uint64_t version, const char *key) {
+  int32_t len = 0;
+  void   *pData = tsdbGetAggCache(pCache, version, key, (int32_t)strlen(key), &len);
+  if (pData == NULL) return -1;
+
+  int32_t val = (len == sizeof(int32_t)) ? *(int32_t *)pData : -2;
+  free(pData);
+  return val;
+}
+
+void putInt(STsdbAggCache *pCache, uint64_t version, const char *key, int32_t val) {
+  tsdbPutAggCache(pCache, version, key, (int32_t)strlen(key), &val, sizeof(val));
+}
+
+}  // namespace
+
+// the entries are found in the same version only, the ones of an older version are not put
+TEST_F(TsdbAggCacheTest, versionedEntries) {
+  STsdbAggCache *pCache = tsdbNewAggCache(1024 * 1024);
+  ASSERT_NE(pCache, nullptr);
+
+  putInt(pCache, 1, "a", 1);
+  putInt(pCache, 1, "b", 2);
+  ASSERT_EQ(getInt(pCache, 1, "a"), 1);
+  ASSERT_EQ(getInt(pCache, 1, "b"), 2);
+  ASSERT_EQ(getInt(pCache, 1, "c"), -1);
+  ASSERT_EQ(pCache->hits, 2);
+  ASSERT_EQ(pCache->misses, 1);
+
+  // a newer version drops all entries
+  tsdbResetAggCache(pCache, 2);
+  ASSERT_EQ(getInt(pCache, 2, "a"), -1);
+  ASSERT_EQ(pCache->size, 0);
+
+  putInt(pCache, 1, "a", 1);
+  ASSERT_EQ(getInt(pCache, 1, "a"), -1);
+  ASSERT_EQ(getInt(pCache, 2, "a"), -1);
+
+  putInt(pCache, 2, "a", 3);
+  ASSERT_EQ(getInt(pCache, 2, "a"), 3);
+  ASSERT_EQ(getInt(pCache, 3, "a"), -1);
+
+  tsdbFreeAggCache(pCache);
+}
+
+// the least recently used entries are evicted for the new ones
+TEST_F(TsdbAggCacheTest, evictLru) {
+  STsdbAggCache *pCache = tsdbNewAggCache(1024);
+  ASSERT_NE(pCache, nullptr);
+
+  char key[16] = {0};
+  for (int32_t i = 0; i < 100; ++i) {
+    snprintf(key, sizeof(key), "key%d", i);
+    putInt(pCache, 0, key, i);
+    ASSERT_EQ(getInt(pCache, 0, "key0"), 0);
+  }
+
+  ASSERT_GT(pCache->evicts, 0);
+  ASSERT_LE(pCache->size, pCache->capacity);
+  ASSERT_EQ(getInt(pCache, 0, "key0"), 0);
+  ASSERT_EQ(getInt(pCache, 0, "key1"), -1);
+  ASSERT_EQ(getInt(pCache, 0, "key99"), 99);
+
+  tsdbFreeAggCache(pCache);
+}
+
+// the blocks are found in the cache by the next query, until the files are changed by a commit or a delete
+TEST_F(TsdbAggCacheTest, invalidateOnNewVersion) {
+  TSKEY      skey = 0;
+  STsdbRepo *pRepo = tsdbTestOpenRepoWithRows(1, tid, uid, numOfRows, 1, &skey);
+  ASSERT_NE(pRepo, nullptr);
+
+  int64_t numOfBlocks = 0;
+  ASSERT_EQ(tsdbTestCacheBlockAggs(pRepo, uid, skey, INT64_MAX, &numOfBlocks), 0);
+  ASSERT_GT(numOfBlocks, 0);
+  ASSERT_EQ(tsdbTestCacheBlockAggs(pRepo, uid, skey, INT64_MAX, &numOfBlocks), numOfBlocks);
+
+  // the blocks of the table are not changed, but the version is
+  ASSERT_EQ(tsdbTestCreateTable(pRepo, tid + 1, uid + 1), 0);
+  ASSERT_EQ(tsdbTestInsertRows(pRepo, tid + 1, uid + 1, skey, 1, 100), 0);
+  ASSERT_EQ(tsdbSyncCommit(pRepo), 0);
+  ASSERT_EQ(tsdbTestCacheBlockAggs(pRepo, uid, skey, INT64_MAX, &numOfBlocks), 0);
+  ASSERT_EQ(tsdbTestCacheBlockAggs(pRepo, uid, skey, INT64_MAX, &numOfBlocks), numOfBlocks);
+
+  ASSERT_EQ(tsdbTestDeleteRows(pRepo, tid + 1, uid + 1, skey, skey + 9), 10);
+  ASSERT_EQ(tsdbTestCacheBlockAggs(pRepo, uid, skey, INT64_MAX, &numOfBlocks), 0);
+
+  tsdbTestCloseRepo(pRepo);
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <iostream>
+
+#include "tglobal.h"
+#include "tsdbTestUtil.h"
+
+namespace {
+
+const char *compactTestDir = "/tmp/tsdbCompactTest";
+
+class TsdbCompactTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() { ASSERT_EQ(tsdbTestInitEnv(compactTestDir), 0); }
+
+  static void TearDownTestCase() { tsdbTestCleanupEnv(compactTestDir); }
+
+  void SetUp() override { compactMBps = tsCompactMBps; }
+
+  void TearDown() override { tsCompactMBps = compactMBps; }
+
+  int32_t compactMBps;
+};
+
+const int32_t  tid = 1;
+const uint64_t uid = 1000001;
+const int32_t  numOfRows = 200000;
+
+// The odd keys are committed in small commits all over the file set, which leaves it with sub-blocks
+int fragment(STsdbRepo *pRepo, TSKEY skey, int32_t round) {
+  for (int32_t i = 0; i < 20; ++i) {
+    TSKEY key = skey + 1 + 2 * ((int64_t)i * (numOfRows / 20) + round * 100);
+    if (tsdbTestInsertRows(pRepo, tid, uid, key, 2, 100) != 0 || tsdbSyncCommit(pRepo) != 0) return -1;
+  }
+  return 0;
+}
+
+STsdbCompactStat compactStat(STsdbRepo *pRepo) {
+  STsdbCompactStat stat;
+  tsdbGetCompactStat(pRepo, &stat);
+  return stat;
+}
+
+}  // namespace
+
+// the fragmented file set is scored to compact and compacted once, the one committed at once is not
+TEST_F(TsdbCompactTest, score) {
+  tsCompactMBps = 0;
+
+  TSKEY      skey = 0;
+  STsdbRepo *pRepo = tsdbTestOpenRepoWithRows(1, tid, uid, numOfRows, 2, &skey);
+  ASSERT_NE(pRepo, nullptr);
+
+  ASSERT_EQ(tsdbTestAutoCompact(pRepo), 0);
+  STsdbCompactStat stat = compactStat(pRepo);
+  ASSERT_EQ(stat.numOfFSets, 1);
+  ASSERT_EQ(stat.numOfDebtFSets, 0);
+  ASSERT_LT(stat.maxScore, 1.0);
+  ASSERT_EQ(stat.compactedFSets, 0);
+
+  ASSERT_EQ(fragment(pRepo, skey, 0), 0);
+  ASSERT_EQ(tsdbTestAutoCompact(pRepo), 0);
+  stat = compactStat(pRepo);
+  ASSERT_EQ(stat.numOfDebtFSets, 1);
+  ASSERT_GE(stat.maxScore, 1.0);
+  ASSERT_GT(stat.debtBytes, 0);
+  ASSERT_EQ(stat.compactedFSets, 1);
+  ASSERT_GT(stat.compactedBytes, 0);
+  ASSERT_EQ(tsdbTestCountRows(pRepo, uid, skey, INT64_MAX), numOfRows + 20 * 100);
+
+  // it is not compacted again until a commit changes it
+  ASSERT_EQ(tsdbTestAutoCompact(pRepo), 0);
+  stat = compactStat(pRepo);
+  ASSERT_EQ(stat.numOfDebtFSets, 0);
+  ASSERT_EQ(stat.compactedFSets, 1);
+
+  tsdbTestCloseRepo(pRepo);
+}
+
+// the next compaction is put off until the bytes read by the last one fit in the read budget
+TEST_F(TsdbCompactTest, throttle) {
+  tsCompactMBps = 1;
+
+  TSKEY      skey = 0;
+  STsdbRepo *pRepo = tsdbTestOpenRepoWithRows(2, tid, uid, numOfRows, 2, &skey);
+  ASSERT_NE(pRepo, nullptr);
+  ASSERT_EQ(fragment(pRepo, skey, 0), 0);
+
+  int64_t start = taosGetTimestampUs();
+  ASSERT_EQ(tsdbTestAutoCompact(pRepo), 0);
+  int64_t end = taosGetTimestampUs();
+  STsdbCompactStat stat = compactStat(pRepo);
+  ASSERT_EQ(stat.compactedFSets, 1);
+
+  // the next one is put off from the start of this one by as many us as the bytes read take at 1MB/s
+  ASSERT_GT(stat.compactedBytes, 1024 * 1024);
+  int64_t budget = stat.compactedBytes * 1000000 / (1024 * 1024);
+  int64_t nextTime = tsdbTestCompactNextTime(pRepo);
+  ASSERT_GE(nextTime, start + budget);
+  ASSERT_LE(nextTime, end + budget);
+
+  // the file set changed is scored to compact, but not compacted before the next time
+  ASSERT_EQ(fragment(pRepo, skey, 1), 0);
+  bool putOff = (taosGetTimestampUs() + 100000 < nextTime);
+  ASSERT_EQ(tsdbTestAutoCompact(pRepo), 0);
+  stat = compactStat(pRepo);
+  if (putOff) {
+    ASSERT_EQ(stat.numOfDebtFSets, 1);
+    ASSERT_EQ(stat.compactedFSets, 1);
+  }
+
+  tsCompactMBps = 0;
+  ASSERT_EQ(tsdbTestAutoCompact(pRepo), 0);
+  stat = compactStat(pRepo);
+  ASSERT_EQ(stat.compactedFSets, 2);
+  ASSERT_EQ(tsdbTestCountRows(pRepo, uid, skey, INT64_MAX), numOfRows + 2 * 20 * 100);
+
+  tsdbTestCloseRepo(pRepo);
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <iostream>
+
+#include "tglobal.h"
+#include "tsdbTestUtil.h"
+
+namespace {
+
+const char *readAheadTestDir = "/tmp/tsdbReadAheadTest";
+
+class TsdbReadAheadTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() {
+    tsReadAheadThreads = 2;
+    tsReadAheadBlocks = 4;
+    tsReadAheadBufferSize = 16;
+    ASSERT_EQ(tsdbTestInitEnv(readAheadTestDir), 0);
+  }
+
+  static void TearDownTestCase() {
+    tsdbTestCleanupEnv(readAheadTestDir);
+    tsReadAheadThreads = 0;
+  }
+};
+
+const int32_t  tid = 1;
+const uint64_t uid = 1000001;
+const int32_t  numOfRows = 400000;
+
+}  // namespace
+
+// the blocks after the first one are loaded from the read-ahead, with the values in the files
+TEST_F(TsdbReadAheadTest, readAllCols) {
+  TSKEY      skey = 0;
+  STsdbRepo *pRepo = tsdbTestOpenRepoWithRows(1, tid, uid, numOfRows, 1, &skey);
+  ASSERT_NE(pRepo, nullptr);
+
+  int64_t hits = 0, misses = 0;
+  ASSERT_EQ(tsdbTestReadRows(pRepo, uid, skey, INT64_MAX, TSDB_TEST_NUM_OF_COLS, &hits, &misses), numOfRows);
+  ASSERT_GT(hits, 0);
+  ASSERT_GT(hits, misses);
+
+  tsdbTestCloseRepo(pRepo);
+}
+
+// only the columns loaded by the query are read ahead, they are all served by it
+TEST_F(TsdbReadAheadTest, readSomeCols) {
+  TSKEY      skey = 0;
+  STsdbRepo *pRepo = tsdbTestOpenRepoWithRows(2, tid, uid, numOfRows, 1, &skey);
+  ASSERT_NE(pRepo, nullptr);
+
+  int64_t hits = 0, misses = 0;
+  ASSERT_EQ(tsdbTestReadRows(pRepo, uid, skey, INT64_MAX, 2, &hits, &misses), numOfRows);
+  ASSERT_GT(hits, misses);
+
+  ASSERT_EQ(tsdbTestReadRows(pRepo, uid, skey, INT64_MAX, 1, &hits, &misses), numOfRows);
+  ASSERT_GT(hits, misses);
+
+  tsdbTestCloseRepo(pRepo);
+}
+
+// the sub blocks of the rows appended in the last file are read ahead one by one
+TEST_F(TsdbReadAheadTest, readSubBlocks) {
+  TSKEY      skey = 0;
+  STsdbRepo *pRepo = tsdbTestOpenRepoWithRows(3, tid, uid, numOfRows, 1, &skey);
+  ASSERT_NE(pRepo, nullptr);
+
+  ASSERT_EQ(tsdbTestInsertRows(pRepo, tid, uid, skey + numOfRows, 1, 100), 0);
+  ASSERT_EQ(tsdbSyncCommit(pRepo), 0);
+
+  int64_t hits = 0, misses = 0;
+  ASSERT_EQ(tsdbTestReadRows(pRepo, uid, skey, INT64_MAX, TSDB_TEST_NUM_OF_COLS, &hits, &misses), numOfRows + 100);
+  ASSERT_GT(hits, misses);
+
+  tsdbTestCloseRepo(pRepo);
+}
@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <algorithm>
+#include <iostream>
+
+#include "tsdbTestUtil.h"
+#include "tsocket.h"
+
+namespace {
+
+const char *syncTestDir = "/tmp/tsdbSyncTest";
+
+struct SSyncPeer {
+  STsdbRepo *pRepo;
+  SOCKET     fd;
+  int32_t    code;
+  int64_t    bytes;
+};
+
+void *syncSendFp(void *param) {
+  SSyncPeer *pPeer = (SSyncPeer *)param;
+  pPeer->code = tsdbSyncSend(pPeer->pRepo, pPeer->fd, &pPeer->bytes);
+  // the connection is closed once the sync ends as the sync module does, the receiver does not wait if it fails
+  shutdown(pPeer->fd, SHUT_RDWR);
+  return NULL;
+}
+
+// Forward the bytes between the peers, the connection is cut once limit bytes are forwarded from the sender
+struct SSyncRelay {
+  SOCKET  sendFd;
+  SOCKET  recvFd;
+  int64_t limit;
+};
+
+void *syncRelayFp(void *param) {
+  SSyncRelay *pRelay = (SSyncRelay *)param;
+  char        buf[65536];
+  int64_t     forwarded = 0;
+
+  while (forwarded < pRelay->limit) {
+    struct pollfd fds[2] = {{pRelay->sendFd, POLLIN, 0}, {pRelay->recvFd, POLLIN, 0}};
+    if (poll(fds, 2, -1) <= 0) break;
+
+    if (fds[0].revents) {
+      int64_t n = read(pRelay->sendFd, buf, (size_t)std::min((int64_t)sizeof(buf), pRelay->limit - forwarded));
+      if (n <= 0 || taosWriteMsg(pRelay->recvFd, buf, (int32_t)n) != n) break;
+      forwarded += n;
+    }
+
+    if (fds[1].revents) {
+      int64_t n = read(pRelay->recvFd, buf, sizeof(buf));
+      if (n <= 0 || taosWriteMsg(pRelay->sendFd, buf, (int32_t)n) != n) break;
+    }
+  }
+
+  shutdown(pRelay->sendFd, SHUT_RDWR);
+  shutdown(pRelay->recvFd, SHUT_RDWR);
+  return NULL;
+}
+
+// Sync from the master to the slave, through a relay cutting the connection after limit bytes if limit > 0
+int32_t syncRepo(STsdbRepo *pMaster, STsdbRepo *pSlave, int64_t limit, int64_t *bytes) {
+  int         sendFds[2], recvFds[2];
+  SSyncPeer   sender = {pMaster, -1, -1, 0};
+  SSyncRelay  relay = {-1, -1, limit};
+  pthread_t   sendThread, relayThread;
+  int64_t     recvBytes = 0;
+
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sendFds) != 0) return -1;
+  if (limit > 0) {
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, recvFds) != 0) return -1;
+    relay.sendFd = sendFds[1];
+    relay.recvFd = recvFds[0];
+    pthread_create(&relayThread, NULL, syncRelayFp, &relay);
+  } else {
+    recvFds[1] = sendFds[1];
+  }
+
+  sender.fd = sendFds[0];
+  pthread_create(&sendThread, NULL, syncSendFp, &sender);
+
+  int32_t code = tsdbSyncRecv(pSlave, recvFds[1], &recvBytes);
+  if (limit > 0) {
+    shutdown(recvFds[1], SHUT_RDWR);
+    pthread_join(relayThread, NULL);
+    close(recvFds[0]);
+    close(recvFds[1]);
+  }
+  pthread_join(sendThread, NULL);
+  close(sendFds[0]);
+  close(sendFds[1]);
+
+  *bytes = sender.bytes;
+  if (code != 0 || sender.code != 0) return -1;
+  return 0;
+}
+
+class TsdbSyncTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() {
+    signal(SIGPIPE, SIG_IGN);
+    ASSERT_EQ(tsdbTestInitEnv(syncTestDir), 0);
+  }
+
+  static void TearDownTestCase() { tsdbTestCleanupEnv(syncTestDir); }
+};
+
+const int32_t  tid = 1;
+const uint64_t uid = 1000001;
+
+}  // namespace
+
+// the files larger than a chunk are sent in several chunks, then the appended part only
+TEST_F(TsdbSyncTest, chunkedSendRecv) {
+  STsdbRepo *pMaster = tsdbTestOpenRepo(1);
+  STsdbRepo *pSlave = tsdbTestOpenRepo(2);
+  ASSERT_NE(pMaster, nullptr);
+  ASSERT_NE(pSlave, nullptr);
+
+  TSKEY   skey = tsdbTestFSetKey(pMaster);
+  int32_t numOfRows = 400000;
+  ASSERT_EQ(tsdbTestCreateTable(pMaster, tid, uid), 0);
+  ASSERT_EQ(tsdbTestInsertRows(pMaster, tid, uid, skey, 1, numOfRows), 0);
+  ASSERT_EQ(tsdbSyncCommit(pMaster), 0);
+  ASSERT_GT(tsdbTestFSetSize(pMaster), 2 * tsdbTestSyncChunkSize());
+
+  int64_t bytes = 0;
+  ASSERT_EQ(syncRepo(pMaster, pSlave, 0, &bytes), 0);
+  ASSERT_GE(bytes, tsdbTestFSetSize(pMaster));
+  ASSERT_EQ(tsdbTestFSetSize(pSlave), tsdbTestFSetSize(pMaster));
+  ASSERT_EQ(tsdbTestCountRows(pSlave, uid, skey, INT64_MAX), numOfRows);
+
+  // the blocks the slave has are not sent again
+  int64_t oldSize = tsdbTestFSetSize(pMaster);
+  ASSERT_EQ(tsdbTestInsertRows(pMaster, tid, uid, skey + numOfRows, 1, 10000), 0);
+  ASSERT_EQ(tsdbSyncCommit(pMaster), 0);
+
+  ASSERT_EQ(syncRepo(pMaster, pSlave, 0, &bytes), 0);
+  ASSERT_LT(bytes, tsdbTestFSetSize(pMaster) - oldSize + tsdbTestSyncChunkSize());
+  ASSERT_EQ(tsdbTestFSetSize(pSlave), tsdbTestFSetSize(pMaster));
+  ASSERT_EQ(tsdbTestCountRows(pSlave, uid, skey, INT64_MAX), numOfRows + 10000);
+
+  tsdbTestCloseRepo(pMaster);
+  tsdbTestCloseRepo(pSlave);
+}
+
+// a sync cut in the middle goes on from the offsets received by the next one
+TEST_F(TsdbSyncTest, resumeFromOffsets) {
+  STsdbRepo *pMaster = tsdbTestOpenRepo(3);
+  STsdbRepo *pSlave = tsdbTestOpenRepo(4);
+  ASSERT_NE(pMaster, nullptr);
+  ASSERT_NE(pSlave, nullptr);
+
+  TSKEY   skey = tsdbTestFSetKey(pMaster);
+  int32_t numOfRows = 400000;
+  ASSERT_EQ(tsdbTestCreateTable(pMaster, tid, uid), 0);
+  ASSERT_EQ(tsdbTestInsertRows(pMaster, tid, uid, skey, 1, numOfRows), 0);
+  ASSERT_EQ(tsdbSyncCommit(pMaster), 0);
+
+  int64_t size = tsdbTestFSetSize(pMaster);
+  int64_t bytes = 0;
+  ASSERT_NE(syncRepo(pMaster, pSlave, size / 2, &bytes), 0);
+  ASSERT_EQ(tsdbTestFSetSize(pSlave), 0);
+
+  ASSERT_EQ(syncRepo(pMaster, pSlave, 0, &bytes), 0);
+  ASSERT_LT(bytes, size - size / 4);
+  ASSERT_EQ(tsdbTestFSetSize(pSlave), size);
+  ASSERT_EQ(tsdbTestCountRows(pSlave, uid, skey, INT64_MAX), numOfRows);
+
+  tsdbTestCloseRepo(pMaster);
+  tsdbTestCloseRepo(pSlave);
+}
+
+// the local file of the receiver larger than the one sent is taken as the base within the size of the one sent
+TEST_F(TsdbSyncTest, largerLocalFile) {
+  STsdbRepo *pMaster = tsdbTestOpenRepo(5);
+  STsdbRepo *pSlave = tsdbTestOpenRepo(6);
+  ASSERT_NE(pMaster, nullptr);
+  ASSERT_NE(pSlave, nullptr);
+
+  TSKEY skey = tsdbTestFSetKey(pMaster);
+  ASSERT_EQ(tsdbTestCreateTable(pMaster, tid, uid), 0);
+  ASSERT_EQ(tsdbTestInsertRows(pMaster, tid, uid, skey, 1, 100000), 0);
+  ASSERT_EQ(tsdbSyncCommit(pMaster), 0);
+
+  ASSERT_EQ(tsdbTestCreateTable(pSlave, tid, uid), 0);
+  ASSERT_EQ(tsdbTestInsertRows(pSlave, tid, uid, skey, 1, 400000), 0);
+  ASSERT_EQ(tsdbSyncCommit(pSlave), 0);
+  ASSERT_GT(tsdbTestFSetSize(pSlave), tsdbTestFSetSize(pMaster));
+
+  int64_t bytes = 0;
+  ASSERT_EQ(syncRepo(pMaster, pSlave, 0, &bytes), 0);
+  ASSERT_EQ(tsdbTestFSetSize(pSlave), tsdbTestFSetSize(pMaster));
+  ASSERT_EQ(tsdbTestCountRows(pSlave, uid, skey, INT64_MAX), 100000);
+
+  tsdbTestCloseRepo(pMaster);
+  tsdbTestCloseRepo(pSlave);
+}
+
+// the rows deleted but still in the files are not back on the slave, the tombstones of the master replace its own
+TEST_F(TsdbSyncTest, syncTombs) {
+  STsdbRepo *pMaster = tsdbTestOpenRepo(7);
+  STsdbRepo *pSlave = tsdbTestOpenRepo(8);
+  ASSERT_NE(pMaster, nullptr);
+  ASSERT_NE(pSlave, nullptr);
+
+  TSKEY skey = tsdbTestFSetKey(pMaster);
+  ASSERT_EQ(tsdbTestCreateTable(pMaster, tid, uid), 0);
+  ASSERT_EQ(tsdbTestInsertRows(pMaster, tid, uid, skey, 1, 100000), 0);
+  ASSERT_EQ(tsdbSyncCommit(pMaster), 0);
+
+  int64_t bytes = 0;
+  ASSERT_EQ(syncRepo(pMaster, pSlave, 0, &bytes), 0);
+  ASSERT_EQ(tsdbTestCountRows(pSlave, uid, skey, INT64_MAX), 100000);
+
+  // the slave has a tombstone the master does not
+  ASSERT_EQ(tsdbTestDeleteRows(pSlave, tid, uid, skey + 5000, skey + 5999), 1000);
+  ASSERT_EQ(tsdbTestNumOfTombs(pSlave), 1);
+
+  ASSERT_EQ(tsdbTestDeleteRows(pMaster, tid, uid, skey + 1000, skey + 2999), 2000);
+  ASSERT_EQ(tsdbTestNumOfTombs(pMaster), 1);
+
+  ASSERT_EQ(syncRepo(pMaster, pSlave, 0, &bytes), 0);
+  ASSERT_EQ(tsdbTestNumOfTombs(pSlave), 1);
+  ASSERT_EQ(tsdbTestCountRows(pSlave, uid, skey, INT64_MAX), 100000 - 2000);
+  ASSERT_EQ(tsdbTestCountRows(pSlave, uid, skey + 1000, skey + 2999), 0);
+  ASSERT_EQ(tsdbTestCountRows(pSlave, uid, skey + 5000, skey + 5999), 1000);
+
+  tsdbTestCloseRepo(pMaster);
+  tsdbTestCloseRepo(pSlave);
+}
@@ -0,0 +1,507 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tsdbint.h"
+#include "tfs.h"
+#include "tglobal.h"
+#include "tname.h"
+#include "tsdbTestUtil.h"
+
+#define TSDB_TEST_ROWS_PER_SUBMIT 1000
+
+int tsdbTestInitEnv(const char *dir) {
+  SDiskCfg diskCfg = {0};
+
+  taosRemoveDir((char *)dir);
+  if (taosMkDir(dir, 0755) != 0) return -1;
+
+  tstrncpy(diskCfg.dir, dir, sizeof(diskCfg.dir));
+  diskCfg.level = 0;
+  diskCfg.primary = 1;
+  if (tfsInit(&diskCfg, 1) < 0) return -1;
+  if (tfsMkdir("vnode") < 0) return -1;
+
+  if (tsdbInitCommitQueue() < 0) return -1;
+  return tsdbInitReadAhead();
+}
+
+void tsdbTestCleanupEnv(const char *dir) {
+  tsdbDestroyReadAhead();
+  tsdbDestroyCommitQueue();
+  tfsDestroy();
+  taosRemoveDir((char *)dir);
+}
+
+STsdbRepo *tsdbTestOpenRepo(int32_t vgId) {
+  STsdbCfg cfg = {0};
+  char     dir[TSDB_FILENAME_LEN] = {0};
+
+  cfg.tsdbId = vgId;
+  cfg.cacheBlockSize = 16;
+  cfg.totalBlocks = 6;
+  cfg.daysPerFile = -1;
+  cfg.keep = TSDB_DEFAULT_KEEP;
+  cfg.keep1 = TSDB_DEFAULT_KEEP;
+  cfg.keep2 = TSDB_DEFAULT_KEEP;
+  cfg.minRowsPerFileBlock = -1;
+  cfg.maxRowsPerFileBlock = -1;
+  cfg.precision = -1;
+  cfg.compression = 0;  // the files are as large as the data, so they are transferred in several chunks
+  cfg.update = 0;
+  cfg.cacheLastRow = 0;
+
+  snprintf(dir, sizeof(dir), "vnode/vnode%d", vgId);
+  if (tfsMkdir(dir) < 0 || tsdbCreateRepo(vgId) < 0) return NULL;
+  return tsdbOpenRepo(&cfg, NULL);
+}
+
+void tsdbTestCloseRepo(STsdbRepo *pRepo) { tsdbCloseRepo(pRepo, 1); }
+
+STsdbRepo *tsdbTestOpenRepoWithRows(int32_t vgId, int32_t tid, uint64_t uid, int32_t numOfRows, int64_t step,
+                                    TSKEY *skey) {
+  STsdbRepo *pRepo = tsdbTestOpenRepo(vgId);
+  if (pRepo == NULL) return NULL;
+
+  *skey = tsdbTestFSetKey(pRepo);
+  if (tsdbTestCreateTable(pRepo, tid, uid) != 0 || tsdbTestInsertRows(pRepo, tid, uid, *skey, step, numOfRows) != 0 ||
+      tsdbSyncCommit(pRepo) != 0) {
+    tsdbTestCloseRepo(pRepo);
+    return NULL;
+  }
+
+  return pRepo;
+}
+
+static STableCfg *tsdbTestNewTableCfg(int8_t type, int32_t tid, uint64_t uid) {
+  STableCfg *     pCfg = calloc(1, sizeof(STableCfg));
+  STSchemaBuilder schemaBuilder = {0};
+  char            name[32] = {0};
+
+  if (pCfg == NULL) return NULL;
+
+  snprintf(name, sizeof(name), "t%d", tid);
+  pCfg->type = type;
+  pCfg->superUid = TSDB_INVALID_SUPER_TABLE_ID;
+  pCfg->tableId.tid = tid;
+  pCfg->tableId.uid = uid;
+  pCfg->name = strdup(name);
+
+  tdInitTSchemaBuilder(&schemaBuilder, 0);
+  for (int16_t colId = 0; colId < TSDB_TEST_NUM_OF_COLS; colId++) {
+    int8_t colType = (colId == 0) ? TSDB_DATA_TYPE_TIMESTAMP : TSDB_DATA_TYPE_INT;
+    tdAddColToSchema(&schemaBuilder, colType, colId, tDataTypes[colType].bytes);
+  }
+  pCfg->schema = tdGetSchemaFromBuilder(&schemaBuilder);
+  tdDestroyTSchemaBuilder(&schemaBuilder);
+
+  return pCfg;
+}
+
+int tsdbTestCreateTable(STsdbRepo *pRepo, int32_t tid, uint64_t uid) {
+  STableCfg *pCfg = tsdbTestNewTableCfg(TSDB_NORMAL_TABLE, tid, uid);
+  if (pCfg == NULL) return -1;
+
+  int code = tsdbCreateTable(pRepo, pCfg);
+  tsdbClearTableCfg(pCfg);
+  return code;
+}
+
+int tsdbTestCreateChildTable(STsdbRepo *pRepo, uint64_t suid, int32_t tid, uint64_t uid, int32_t tagVal) {
+  STableCfg *pCfg = tsdbTestNewTableCfg(TSDB_CHILD_TABLE, tid, uid);
+  if (pCfg == NULL) return -1;
+
+  STSchemaBuilder schemaBuilder = {0};
+  SKVRowBuilder   kvRowBuilder = {0};
+  char            sname[32] = {0};
+
+  snprintf(sname, sizeof(sname), "st%" PRIu64, suid);
+  pCfg->superUid = suid;
+  pCfg->sname = strdup(sname);
+
+  tdInitTSchemaBuilder(&schemaBuilder, 0);
+  tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_INT, TSDB_TEST_NUM_OF_COLS, tDataTypes[TSDB_DATA_TYPE_INT].bytes);
+  pCfg->tagSchema = tdGetSchemaFromBuilder(&schemaBuilder);
+  tdDestroyTSchemaBuilder(&schemaBuilder);
+
+  if (tdInitKVRowBuilder(&kvRowBuilder) < 0) {
+    tsdbClearTableCfg(pCfg);
+    return -1;
+  }
+  tdAddColToKVRow(&kvRowBuilder, TSDB_TEST_NUM_OF_COLS, TSDB_DATA_TYPE_INT, &tagVal, false);
+  pCfg->tagValues = tdGetKVRowFromBuilder(&kvRowBuilder);
+  tdDestroyKVRowBuilder(&kvRowBuilder);
+
+  int code = tsdbCreateTable(pRepo, pCfg);
+  tsdbClearTableCfg(pCfg);
+  return code;
+}
+
+int32_t tsdbTestColVal(TSKEY key, int32_t colId) { return (int32_t)(key * 2654435761u + colId * 40503u); }
+
+int tsdbTestInsertRows(STsdbRepo *pRepo, int32_t tid, uint64_t uid, TSKEY skey, int64_t step, int32_t numOfRows) {
+  STSchema *pSchema = tsdbGetTableSchema(tsdbGetTableByUid(tsdbGetMeta(pRepo), uid));
+  if (pSchema == NULL) return -1;
+
+  int32_t     rowLen = TD_MEM_ROW_TYPE_SIZE + dataRowMaxBytesFromSchema(pSchema);
+  SSubmitMsg *pMsg = malloc(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + rowLen * TSDB_TEST_ROWS_PER_SUBMIT);
+  if (pMsg == NULL) return -1;
+
+  TSKEY key = skey;
+  for (int32_t nrows = 0; nrows < numOfRows; nrows += TSDB_TEST_ROWS_PER_SUBMIT) {
+    SSubmitBlk *pBlock = (SSubmitBlk *)pMsg->blocks;
+    int32_t     dataLen = 0;
+    int32_t     nrowsInBlock = MIN(numOfRows - nrows, TSDB_TEST_ROWS_PER_SUBMIT);
+
+    memset(pMsg, 0, sizeof(SSubmitMsg) + sizeof(SSubmitBlk));
+    for (int32_t i = 0; i < nrowsInBlock; i++, key += step) {
+      SMemRow row = (SMemRow)(pBlock->data + dataLen);
+      memRowSetType(row, SMEM_ROW_DATA);
+      tdInitDataRow(memRowDataBody(row), pSchema);
+
+      for (int32_t j = 0; j < schemaNCols(pSchema); j++) {
+        STColumn *pCol = schemaColAt(pSchema, j);
+        if (j == 0) {
+          tdAppendColVal(memRowDataBody(row), &key, pCol->type, pCol->offset);
+        } else {
+          int32_t val = tsdbTestColVal(key, pCol->colId);
+          tdAppendColVal(memRowDataBody(row), &val, pCol->type, pCol->offset);
+        }
+      }
+      dataLen += memRowTLen(row);
+    }
+
+    pBlock->uid = htobe64(uid);
+    pBlock->tid = htonl(tid);
+    pBlock->sversion = htonl(schemaVersion(pSchema));
+    pBlock->dataLen = htonl(dataLen);
+    pBlock->schemaLen = 0;
+    pBlock->numOfRows = htons((int16_t)nrowsInBlock);
+    pMsg->length = htonl(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + dataLen);
+    pMsg->numOfBlocks = htonl(1);
+
+    if (tsdbInsertData(pRepo, pMsg, NULL, NULL) < 0) {
+      free(pMsg);
+      return -1;
+    }
+  }
+
+  free(pMsg);
+  return 0;
+}
+
+int64_t tsdbTestCountRows(STsdbRepo *pRepo, uint64_t uid, TSKEY skey, TSKEY ekey) {
+  int64_t hits = 0, misses = 0;
+  return tsdbTestReadRows(pRepo, uid, skey, ekey, TSDB_TEST_NUM_OF_COLS, &hits, &misses);
+}
+
+// The query of the first numOfCols columns of the rows of a table, the columns and the mem snapshot are kept by the
+// query handle
+typedef struct {
+  STableGroupInfo  groupInfo;
+  SColumnInfo      colInfo[TSDB_TEST_NUM_OF_COLS];
+  SMemRef          memRef;
+  TsdbQueryHandleT pHandle;
+} STsdbTestQuery;
+
+static int tsdbTestOpenQuery(STsdbTestQuery *pQuery, STsdbRepo *pRepo, uint64_t uid, TSKEY skey, TSKEY ekey,
+                             int32_t numOfCols) {
+  STsdbQueryCond cond = {0};
+
+  memset(pQuery, 0, sizeof(*pQuery));
+  if (tsdbGetOneTableGroup(pRepo, uid, skey, &pQuery->groupInfo) != TSDB_CODE_SUCCESS) return -1;
+
+  for (int32_t i = 0; i < TSDB_TEST_NUM_OF_COLS; i++) {
+    pQuery->colInfo[i].colId = PRIMARYKEY_TIMESTAMP_COL_INDEX + i;
+    pQuery->colInfo[i].type = (i == 0) ? TSDB_DATA_TYPE_TIMESTAMP : TSDB_DATA_TYPE_INT;
+    pQuery->colInfo[i].bytes = tDataTypes[pQuery->colInfo[i].type].bytes;
+  }
+
+  cond.twindow.skey = skey;
+  cond.twindow.ekey = ekey;
+  cond.order = TSDB_ORDER_ASC;
+  cond.numOfCols = numOfCols;
+  cond.colList = pQuery->colInfo;
+  cond.type = BLOCK_LOAD_OFFSET_SEQ_ORDER;
+
+  pQuery->pHandle = tsdbQueryTables(pRepo, &cond, &pQuery->groupInfo, 0, &pQuery->memRef);
+  if (pQuery->pHandle == NULL) {
+    tsdbDestroyTableGroup(&pQuery->groupInfo);
+    return -1;
+  }
+
+  return 0;
+}
+
+static void tsdbTestCloseQuery(STsdbTestQuery *pQuery) {
+  tsdbCleanupQueryHandle(pQuery->pHandle);
+  tsdbDestroyTableGroup(&pQuery->groupInfo);
+}
+
+int64_t tsdbTestReadRows(STsdbRepo *pRepo, uint64_t uid, TSKEY skey, TSKEY ekey, int32_t numOfCols, int64_t *hits,
+                         int64_t *misses) {
+  STsdbTestQuery query;
+  int64_t        numOfRows = 0;
+
+  if (tsdbTestOpenQuery(&query, pRepo, uid, skey, ekey, numOfCols) != 0) return -1;
+
+  TsdbQueryHandleT pHandle = query.pHandle;
+
+  while (numOfRows >= 0 && tsdbNextDataBlock(pHandle)) {
+    SDataBlockInfo blockInfo = {{0}};
+    tsdbRetrieveDataBlockInfo((TsdbQueryHandleT *)pHandle, &blockInfo);
+
+    SArray *pCols = tsdbRetrieveDataBlock((TsdbQueryHandleT *)pHandle, NULL);
+    if (pCols == NULL) {
+      numOfRows = -1;
+      break;
+    }
+
+    SColumnInfoData *pTsCol = taosArrayGet(pCols, 0);
+    for (int32_t i = 0; i < blockInfo.rows && numOfRows >= 0; i++) {
+      TSKEY key = ((TSKEY *)pTsCol->pData)[i];
+      for (int32_t j = 1; j < numOfCols; j++) {
+        SColumnInfoData *pCol = taosArrayGet(pCols, j);
+        if (((int32_t *)pCol->pData)[i] != tsdbTestColVal(key, pCol->info.colId)) {
+          numOfRows = -1;
+          break;
+        }
+      }
+      if (numOfRows >= 0) numOfRows++;
+    }
+  }
+
+  int64_t wastes = 0;
+  tsdbGetReadAheadStat(pHandle, hits, misses, &wastes);
+
+  tsdbTestCloseQuery(&query);
+  return numOfRows;
+}
+
+int64_t tsdbTestCacheBlockAggs(STsdbRepo *pRepo, uint64_t uid, TSKEY skey, TSKEY ekey, int64_t *numOfBlocks) {
+  STsdbTestQuery query;
+  int64_t        hits = 0;
+  const char     sig[] = "rows";
+
+  *numOfBlocks = 0;
+  if (tsdbTestOpenQuery(&query, pRepo, uid, skey, ekey, 1) != 0) return -1;
+
+  TsdbQueryHandleT pHandle = query.pHandle;
+
+  while (hits >= 0 && tsdbNextDataBlock(pHandle)) {
+    if (!tsdbIsDataBlockAggCacheable(pHandle)) continue;
+
+    SDataBlockInfo blockInfo = {{0}};
+    tsdbRetrieveDataBlockInfo((TsdbQueryHandleT *)pHandle, &blockInfo);
+    *numOfBlocks += 1;
+
+    int32_t  len = 0;
+    int32_t *pRows = tsdbGetDataBlockAggCache(pHandle, sig, sizeof(sig), &len);
+    if (pRows == NULL) {
+      tsdbPutDataBlockAggCache(pHandle, sig, sizeof(sig), &blockInfo.rows, sizeof(blockInfo.rows));
+    } else if (len == sizeof(int32_t) && *pRows == blockInfo.rows) {
+      hits++;
+    } else {
+      hits = -1;
+    }
+
+    tfree(pRows);
+  }
+
+  tsdbTestCloseQuery(&query);
+  return hits;
+}
+
+int64_t tsdbTestDeleteRows(STsdbRepo *pRepo, int32_t tid, uint64_t uid, TSKEY skey, TSKEY ekey) {
+  STSchema *pSchema = tsdbGetTableSchema(tsdbGetTableByUid(tsdbGetMeta(pRepo), uid));
+  if (pSchema == NULL) return -1;
+
+  int32_t     dataLen = sizeof(SControlData);
+  SSubmitMsg *pMsg = calloc(1, sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + dataLen);
+  if (pMsg == NULL) return -1;
+
+  SSubmitBlk *  pBlock = (SSubmitBlk *)pMsg->blocks;
+  SControlData *pCtlData = (SControlData *)pBlock->data;
+  pCtlData->command = htonl(CMD_DELETE_DATA);
+  pCtlData->win.skey = htobe64(skey);
+  pCtlData->win.ekey = htobe64(ekey);
+  pCtlData->tagCondLen = 0;
+
+  pBlock->flag = FLAG_BLK_CONTROL;
+  pBlock->uid = htobe64(uid);
+  pBlock->tid = htonl(tid);
+  pBlock->sversion = htonl(schemaVersion(pSchema));
+  pBlock->dataLen = htonl(dataLen);
+  pBlock->numOfRows = htons(1);
+  pMsg->length = htonl(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + dataLen);
+  pMsg->numOfBlocks = htonl(1);
+
+  // the delete is done by the commit thread, which posts the semaphore then
+  SShellSubmitRspMsg rsp = {0};
+  tsem_t *           pSem = NULL;
+  if (tsdbInsertData(pRepo, pMsg, &rsp, &pSem) != TSDB_CODE_SUCCESS || pSem == NULL) {
+    free(pMsg);
+    return -1;
+  }
+
+  tsem_wait(pSem);
+  tsem_destroy(pSem);
+  free(pSem);
+  free(pMsg);
+
+  // the FS is updated before the commit slot is released
+  tsem_wait(&(pRepo->readyToCommit));
+  tsem_post(&(pRepo->readyToCommit));
+
+  if (rsp.code != TSDB_CODE_SUCCESS) return -1;
+  return (int32_t)ntohl(rsp.affectedRows);
+}
+
+int tsdbTestCompact(STsdbRepo *pRepo) {
+  if (tsdbCompact(pRepo) < 0) return -1;
+
+  tsem_wait(&(pRepo->readyToCommit));
+  tsem_post(&(pRepo->readyToCommit));
+  return (pRepo->code == TSDB_CODE_SUCCESS) ? 0 : -1;
+}
+
+int tsdbTestAutoCompact(STsdbRepo *pRepo) {
+  if (tsdbAutoCompact(pRepo) < 0) return -1;
+
+  tsem_wait(&(pRepo->readyToCommit));
+  tsem_post(&(pRepo->readyToCommit));
+  return (pRepo->code == TSDB_CODE_SUCCESS) ? 0 : -1;
+}
+
+int64_t tsdbTestCompactNextTime(STsdbRepo *pRepo) { return pRepo->compactNextTime; }
+
+int32_t tsdbTestNumOfTombs(STsdbRepo *pRepo) { return (int32_t)taosArrayGetSize(REPO_FS(pRepo)->cstatus->tombs); }
+
+static void tsdbTestCurrentFname(int32_t vgId, char *fname) {
+  snprintf(fname, TSDB_FILENAME_LEN, "%s/vnode/vnode%d/tsdb/current", TFS_PRIMARY_PATH(), vgId);
+}
+
+int32_t tsdbTestCurrentVersion(int32_t vgId) {
+  char     fname[TSDB_FILENAME_LEN] = {0};
+  char     hbuf[TSDB_FILE_HEAD_SIZE] = {0};
+  uint32_t fsVer = 0;
+
+  tsdbTestCurrentFname(vgId, fname);
+  FILE *fp = fopen(fname, "rb");
+  if (fp == NULL) return -1;
+  size_t nread = fread(hbuf, 1, sizeof(hbuf), fp);
+  fclose(fp);
+  if (nread != sizeof(hbuf)) return -1;
+
+  taosDecodeFixedU32(hbuf, &fsVer);
+  return (int32_t)fsVer;
+}
+
+int tsdbTestDowngradeCurrent(int32_t vgId) {
+  char     fname[TSDB_FILENAME_LEN] = {0};
+  uint32_t fsVer = 0, len = 0;
+  uint64_t numOfTombs = 0;
+  void *   ptr;
+
+  tsdbTestCurrentFname(vgId, fname);
+  FILE *fp = fopen(fname, "rb");
+  if (fp == NULL) return -1;
+  fseek(fp, 0, SEEK_END);
+  long  size = ftell(fp);
+  char *buf = malloc(size);
+  fseek(fp, 0, SEEK_SET);
+  size_t nread = (buf == NULL) ? 0 : fread(buf, 1, size, fp);
+  fclose(fp);
+
+  // the header of the version and length, then the status ended by the tombstone array and the checksum
+  ptr = taosDecodeFixedU32(buf, &fsVer);
+  taosDecodeFixedU32(ptr, &len);
+  if (nread != size || fsVer != TSDB_FS_VER_2 || len < sizeof(uint64_t) + sizeof(TSCKSUM) ||
+      size != TSDB_FILE_HEAD_SIZE + len) {
+    free(buf);
+    return -1;
+  }
+
+  char *pStatus = buf + TSDB_FILE_HEAD_SIZE;
+  taosDecodeFixedU64(pStatus + len - sizeof(TSCKSUM) - sizeof(uint64_t), &numOfTombs);
+  if (numOfTombs != 0) {
+    free(buf);
+    return -1;
+  }
+
+  len -= sizeof(uint64_t);
+  taosCalcChecksumAppend(0, (uint8_t *)pStatus, len);
+
+  ptr = buf;
+  taosEncodeFixedU32(&ptr, TSDB_FS_VER_1);
+  taosEncodeFixedU32(&ptr, len);
+  taosCalcChecksumAppend(0, (uint8_t *)buf, TSDB_FILE_HEAD_SIZE);
+
+  fp = fopen(fname, "wb");
+  if (fp == NULL) {
+    free(buf);
+    return -1;
+  }
+  size_t nwrite = fwrite(buf, 1, TSDB_FILE_HEAD_SIZE + len, fp);
+  fclose(fp);
+  free(buf);
+  return (nwrite == TSDB_FILE_HEAD_SIZE + len) ? 0 : -1;
+}
+
+TSKEY tsdbTestFSetKey(STsdbRepo *pRepo) {
+  STsdbCfg *pCfg = tsdbGetCfg(pRepo);
+  int64_t   interval = tsTickPerDay[pCfg->precision] * pCfg->daysPerFile;
+
+  return (taosGetTimestamp(pCfg->precision) / interval) * interval;
+}
+
+int64_t tsdbTestFSetSize(STsdbRepo *pRepo) {
+  SFSIter fsiter;
+  int64_t size = 0;
+
+  tsdbFSIterInit(&fsiter, REPO_FS(pRepo), TSDB_FS_ITER_FORWARD);
+  for (SDFileSet *pSet = tsdbFSIterNext(&fsiter); pSet != NULL; pSet = tsdbFSIterNext(&fsiter)) {
+    for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSet); ftype++) {
+      size += TSDB_DFILE_IN_SET(pSet, ftype)->info.size;
+    }
+  }
+
+  return size;
+}
+
+int tsdbTestCorruptData(STsdbRepo *pRepo) {
+  SFSIter fsiter;
+  char    buf[4096] = {0};
+
+  tsdbFSIterInit(&fsiter, REPO_FS(pRepo), TSDB_FS_ITER_FORWARD);
+  for (SDFileSet *pSet = tsdbFSIterNext(&fsiter); pSet != NULL; pSet = tsdbFSIterNext(&fsiter)) {
+    SDFile *pDFile = TSDB_DFILE_IN_SET(pSet, TSDB_FILE_DATA);
+    int     fd = open(TSDB_FILE_FULL_NAME(pDFile), O_WRONLY | O_BINARY);
+    if (fd < 0) return -1;
+
+    for (int64_t offset = TSDB_FILE_HEAD_SIZE; offset < pDFile->info.size; offset += sizeof(buf)) {
+      size_t len = (size_t)MIN((int64_t)sizeof(buf), pDFile->info.size - offset);
+      if (pwrite(fd, buf, len, offset) != len) {
+        close(fd);
+        return -1;
+      }
+    }
+
+    close(fd);
+  }
+
+  return 0;
+}
+
+int64_t tsdbTestSyncChunkSize() { return TSDB_SYNC_CHUNK_SIZE; }
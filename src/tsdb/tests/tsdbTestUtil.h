@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_TEST_UTIL_H_
+#define _TD_TSDB_TEST_UTIL_H_
+
+#include "os.h"
+#include "tsdb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TSDB_TEST_NUM_OF_COLS 5  // a timestamp and four int columns
+
+// The repositories are created in a tfs of one disk at dir, named vnode/vnode<vgId>/tsdb as the vnode does
+int  tsdbTestInitEnv(const char *dir);
+void tsdbTestCleanupEnv(const char *dir);
+
+STsdbRepo *tsdbTestOpenRepo(int32_t vgId);
+void       tsdbTestCloseRepo(STsdbRepo *pRepo);
+
+// Open the repository with a table of numOfRows rows of the keys skey, skey + step, ... committed, skey is the first
+// key of the file set
+STsdbRepo *tsdbTestOpenRepoWithRows(int32_t vgId, int32_t tid, uint64_t uid, int32_t numOfRows, int64_t step,
+                                    TSKEY *skey);
+
+// The table has the schema of TSDB_TEST_NUM_OF_COLS columns
+int tsdbTestCreateTable(STsdbRepo *pRepo, int32_t tid, uint64_t uid);
+
+// The child table of the super table suid, created with it if not yet, the super table has an int tag of the colId
+// TSDB_TEST_NUM_OF_COLS
+int tsdbTestCreateChildTable(STsdbRepo *pRepo, uint64_t suid, int32_t tid, uint64_t uid, int32_t tagVal);
+
+// Insert rows of the keys skey, skey + step, ..., the values are given by tsdbTestColVal, so they can be checked
+int     tsdbTestInsertRows(STsdbRepo *pRepo, int32_t tid, uint64_t uid, TSKEY skey, int64_t step, int32_t numOfRows);
+int32_t tsdbTestColVal(TSKEY key, int32_t colId);
+
+// Read the rows of the table in [skey, ekey], return the number of rows or -1 if a value is not the one inserted
+int64_t tsdbTestCountRows(STsdbRepo *pRepo, uint64_t uid, TSKEY skey, TSKEY ekey);
+
+// Read the first numOfCols columns of the rows as tsdbTestCountRows does, with the reads of the file blocks served by
+// the read-ahead and the ones from the files
+int64_t tsdbTestReadRows(STsdbRepo *pRepo, uint64_t uid, TSKEY skey, TSKEY ekey, int32_t numOfCols, int64_t *hits,
+                         int64_t *misses);
+
+// Cache the number of rows of each file block of the table in [skey, ekey] as its partial aggregate if absent, return the number of
+// the blocks found in the cache or -1 if a cached one is not the number of rows, numOfBlocks is the blocks cacheable
+int64_t tsdbTestCacheBlockAggs(STsdbRepo *pRepo, uint64_t uid, TSKEY skey, TSKEY ekey, int64_t *numOfBlocks);
+
+// Delete the rows of the table in [skey, ekey] as the delete statement does, return the number of rows deleted or -1
+int64_t tsdbTestDeleteRows(STsdbRepo *pRepo, int32_t tid, uint64_t uid, TSKEY skey, TSKEY ekey);
+
+// Compact the file sets and wait until it is over
+int tsdbTestCompact(STsdbRepo *pRepo);
+
+// Compact the file set picked by the background compaction if any, and wait until it is over
+int tsdbTestAutoCompact(STsdbRepo *pRepo);
+
+// The time in us the next background compaction is put off until for the read budget
+int64_t tsdbTestCompactNextTime(STsdbRepo *pRepo);
+
+// The number of the tombstones in the FS status
+int32_t tsdbTestNumOfTombs(STsdbRepo *pRepo);
+
+// The version of the 'current' file of the closed repository, and rewriting it in TSDB_FS_VER_1 with no tombstone as
+// the old versions did, which fails if it has tombstones
+int32_t tsdbTestCurrentVersion(int32_t vgId);
+int     tsdbTestDowngradeCurrent(int32_t vgId);
+
+// The first key of the file set of the current time, the data inserted from it is in one file set
+TSKEY tsdbTestFSetKey(STsdbRepo *pRepo);
+
+// The total size of the files of the file sets
+int64_t tsdbTestFSetSize(STsdbRepo *pRepo);
+int64_t tsdbTestSyncChunkSize();
+
+// Overwrite the blocks in the data files with zeros, so that loading them fails for the checksum
+int tsdbTestCorruptData(STsdbRepo *pRepo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TD_TSDB_TEST_UTIL_H_ */
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <iostream>
+
+#include "tglobal.h"
+#include "tsdbTestUtil.h"
+
+namespace {
+
+const char *tombTestDir = "/tmp/tsdbTombTest";
+
+class TsdbTombTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() {
+    tsdbDeleteTombstone = 1;
+    ASSERT_EQ(tsdbTestInitEnv(tombTestDir), 0);
+  }
+
+  static void TearDownTestCase() { tsdbTestCleanupEnv(tombTestDir); }
+};
+
+const int32_t  tid = 1;
+const uint64_t uid = 1000001;
+const int32_t  numOfRows = 100000;
+
+}  // namespace
+
+// the rows deleted are kept in the files and filtered by the queries
+TEST_F(TsdbTombTest, readFilter) {
+  TSKEY      skey = 0;
+  STsdbRepo *pRepo = tsdbTestOpenRepoWithRows(11, tid, uid, numOfRows, 1, &skey);
+  ASSERT_NE(pRepo, nullptr);
+
+  int64_t size = tsdbTestFSetSize(pRepo);
+  ASSERT_EQ(tsdbTestDeleteRows(pRepo, tid, uid, skey + 1000, skey + 2999), 2000);
+  ASSERT_EQ(tsdbTestNumOfTombs(pRepo), 1);
+  ASSERT_EQ(tsdbTestFSetSize(pRepo), size);
+
+  ASSERT_EQ(tsdbTestCountRows(pRepo, uid, skey, INT64_MAX), numOfRows - 2000);
+  ASSERT_EQ(tsdbTestCountRows(pRepo, uid, skey + 1000, skey + 2999), 0);
+  ASSERT_EQ(tsdbTestCountRows(pRepo, uid, skey + 500, skey + 3499), 1000);
+
+  // the rows inserted again into the range deleted are not filtered
+  ASSERT_EQ(tsdbTestInsertRows(pRepo, tid, uid, skey + 1000, 1, 100), 0);
+  ASSERT_EQ(tsdbTestCountRows(pRepo, uid, skey, INT64_MAX), numOfRows - 1900);
+
+  tsdbTestCloseRepo(pRepo);
+}
+
+// a commit into the file set rewrites the rows of the table without the rows deleted and drops the tombstones
+TEST_F(TsdbTombTest, commitApply) {
+  TSKEY      skey = 0;
+  STsdbRepo *pRepo = tsdbTestOpenRepoWithRows(12, tid, uid, numOfRows, 1, &skey);
+  ASSERT_NE(pRepo, nullptr);
+
+  ASSERT_EQ(tsdbTestDeleteRows(pRepo, tid, uid, skey + 1000, skey + 2999), 2000);
+  ASSERT_EQ(tsdbTestNumOfTombs(pRepo), 1);
+
+  ASSERT_EQ(tsdbTestInsertRows(pRepo, tid, uid, skey + numOfRows, 1, 1000), 0);
+  ASSERT_EQ(tsdbSyncCommit(pRepo), 0);
+  ASSERT_EQ(tsdbTestNumOfTombs(pRepo), 0);
+  ASSERT_EQ(tsdbTestCountRows(pRepo, uid, skey, INT64_MAX), numOfRows - 2000 + 1000);
+  ASSERT_EQ(tsdbTestCountRows(pRepo, uid, skey + 1000, skey + 2999), 0);
+
+  tsdbTestCloseRepo(pRepo);
+}
+
+// the compaction removes the rows deleted from the files and drops the tombstones
+TEST_F(TsdbTombTest, compactApply) {
+  TSKEY      skey = 0;
+  STsdbRepo *pRepo = tsdbTestOpenRepoWithRows(13, tid, uid, numOfRows, 1, &skey);
+  ASSERT_NE(pRepo, nullptr);
+
+  int64_t size = tsdbTestFSetSize(pRepo);
+  ASSERT_EQ(tsdbTestDeleteRows(pRepo, tid, uid, skey + 1000, skey + 50999), 50000);
+  ASSERT_EQ(tsdbTestNumOfTombs(pRepo), 1);
+
+  ASSERT_EQ(tsdbTestCompact(pRepo), 0);
+  ASSERT_EQ(tsdbTestNumOfTombs(pRepo), 0);
+  ASSERT_LT(tsdbTestFSetSize(pRepo), size);
+  ASSERT_EQ(tsdbTestCountRows(pRepo, uid, skey, INT64_MAX), numOfRows - 50000);
+  ASSERT_EQ(tsdbTestCountRows(pRepo, uid, skey + 1000, skey + 50999), 0);
+
+  tsdbTestCloseRepo(pRepo);
+}
+
+// a 'current' file of version 1 has no tombstone, it is saved in version 2 with them
+TEST_F(TsdbTombTest, currentUpgrade) {
+  TSKEY      skey = 0;
+  STsdbRepo *pRepo = tsdbTestOpenRepoWithRows(14, tid, uid, numOfRows, 1, &skey);
+  ASSERT_NE(pRepo, nullptr);
+  tsdbTestCloseRepo(pRepo);
+
+  ASSERT_EQ(tsdbTestCurrentVersion(14), 2);
+  ASSERT_EQ(tsdbTestDowngradeCurrent(14), 0);
+  ASSERT_EQ(tsdbTestCurrentVersion(14), 1);
+
+  pRepo = tsdbTestOpenRepo(14);
+  ASSERT_NE(pRepo, nullptr);
+  ASSERT_EQ(tsdbTestNumOfTombs(pRepo), 0);
+  ASSERT_EQ(tsdbTestCountRows(pRepo, uid, skey, INT64_MAX), numOfRows);
+
+  ASSERT_EQ(tsdbTestDeleteRows(pRepo, tid, uid, skey + 1000, skey + 2999), 2000);
+  ASSERT_EQ(tsdbTestNumOfTombs(pRepo), 1);
+  tsdbTestCloseRepo(pRepo);
+
+  ASSERT_EQ(tsdbTestCurrentVersion(14), 2);
+  pRepo = tsdbTestOpenRepo(14);
+  ASSERT_NE(pRepo, nullptr);
+  ASSERT_EQ(tsdbTestNumOfTombs(pRepo), 1);
+  ASSERT_EQ(tsdbTestCountRows(pRepo, uid, skey, INT64_MAX), numOfRows - 2000);
+
+  tsdbTestCloseRepo(pRepo);
+}
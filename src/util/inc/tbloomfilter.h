@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_TBLOOMFILTER_H
+#define TDENGINE_TBLOOMFILTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TSDB_BLOOM_FILTER_MAX_HASH  8
+#define TSDB_BLOOM_FILTER_MAX_BYTES (1u << 20)
+
+/**
+ * The bloom filter is a plain bitmap of nBytes bytes, the bit positions of a key are generated by double hashing
+ * the 64-bit murmur hash of the key, so the bitmap could be persisted and probed without any extra meta data.
+ */
+uint32_t taosBloomFilterBytes(int32_t numOfElems, int32_t bitsPerElem);
+uint8_t  taosBloomFilterNumOfHash(int32_t bitsPerElem);
+void     taosBloomFilterPut(uint8_t *bits, uint32_t nBytes, uint8_t nHash, const void *key, uint32_t len);
+bool     taosBloomFilterMayContain(const uint8_t *bits, uint32_t nBytes, uint8_t nHash, const void *key, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_TBLOOMFILTER_H
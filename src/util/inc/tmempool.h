@@ -29,6 +29,29 @@ void taosMemPoolFree(mpool_h handle, char *p);
 
 void taosMemPoolCleanUp(mpool_h handle);
 
+/*
+ * An arena the memory of one owner, e.g. a query, is allocated from piece by piece and released all together when the
+ * owner is destroyed. The pieces are carved out of large blocks, and freeing a piece does nothing. With useMalloc, each
+ * piece is malloc'ed on its own and freed by taosArenaFree instead, so that memory debuggers can check the accesses,
+ * the pieces not freed are still released with the arena.
+ *
+ * A piece knows the arena it comes from, so taosArenaFree needs no arena. The pieces allocated from a NULL arena are
+ * malloc'ed on their own and must be freed by taosArenaFree.
+ */
+typedef struct SMemArena SMemArena;
+
+SMemArena *taosArenaInit(int32_t blockSize, bool useMalloc);
+
+void *taosArenaMalloc(SMemArena *pArena, size_t size);
+
+void *taosArenaCalloc(SMemArena *pArena, size_t num, size_t size);
+
+void taosArenaFree(void *p);
+
+size_t taosArenaGetMemSize(const SMemArena *pArena);
+
+void taosArenaDestroy(SMemArena *pArena);
+
 #ifdef __cplusplus
 }
 #endif
@@ -32,6 +32,11 @@ Notes:
 2: after taosCloseQueue/taosCloseQset is called, read/write operation APIs are not safe.
 3: read/write operation APIs are multi-thread safe
 
+The worker queue set(taosOpenWorkerQset) is read by a fixed number of workers, each with its own ID. A queue with
+items is put into the ready list of a worker, the worker takes its own ready queues first and steals the ones of 
+the other workers if it has none. taosReadAllQitemsFromWorkerQset hands a queue to one worker at a time, so the 
+items of a queue are processed in order. The queue is kept by the worker until it reads again.
+
 To remove the limitation and make this set of queue APIs multi-thread safe, REF(tref.c)
 shall be used to set up the protection. 
 
@@ -41,6 +46,12 @@ typedef void* taos_queue;
 typedef void* taos_qset;
 typedef void* taos_qall;
 
+typedef struct {
+  int64_t numOfReads;
+  int64_t numOfSteals;        // ready queues taken from the other workers
+  int64_t numOfContentions;   // locks not taken at once
+} SQsetStat;
+
 taos_queue taosOpenQueue();
 void       taosCloseQueue(taos_queue);
 void      *taosAllocateQitem(int size);
@@ -55,7 +66,7 @@ int        taosGetQitem(taos_qall, int *type, void **pitem);
 void       taosResetQitems(taos_qall);
 
 taos_qset  taosOpenQset();
-void       taosCloseQset();
+void       taosCloseQset(taos_qset);
 void       taosQsetThreadResume(taos_qset param);
 int        taosAddIntoQset(taos_qset, taos_queue, void *ahandle);
 void       taosRemoveFromQset(taos_qset, taos_queue);
@@ -64,6 +75,11 @@ int        taosGetQueueNumber(taos_qset);
 int        taosReadQitemFromQset(taos_qset, int *type, void **pitem, void **handle);
 int        taosReadAllQitemsFromQset(taos_qset, taos_qall, void **handle);
 
+taos_qset  taosOpenWorkerQset(int32_t numOfWorkers);
+int        taosReadQitemFromWorkerQset(taos_qset, int32_t workerId, int *type, void **pitem, void **handle);
+int        taosReadAllQitemsFromWorkerQset(taos_qset, int32_t workerId, taos_qall, void **handle);
+void       taosGetQsetStat(taos_qset, SQsetStat *pStat);
+
 int        taosGetQueueItemsNumber(taos_queue param);
 int        taosGetQsetItemsNumber(taos_qset param);
 
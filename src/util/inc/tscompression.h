@@ -50,6 +50,9 @@ extern "C" {
 #define HEAD_MODE(x)  x%2
 #define HEAD_ALGO(x)  x/2
 
+// use the SIMD decompression kernels if supported by the CPU, the scalar ones are used if it is false
+extern bool tsDecompressSimd;
+
 extern int tsCompressINTImp(const char *const input, const int nelements, char *const output, const char type);
 extern int tsDecompressINTImp(const char *const input, const int nelements, char *const output, const char type);
 extern int tsCompressBoolImp(const char *const input, const int nelements, char *const output);
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_TSHARDHASH_H
+#define TDENGINE_TSHARDHASH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hashfunc.h"
+
+/*
+ * A hash table for hot lookups of small fixed-size entries, e.g. uid -> STable*.
+ *
+ * The keys are split into shards, each an open-addressing table with linear probing, with the keys and data stored
+ * inline in the slots and the hash values of the slots in an array of their own, so that a probe scans one or two
+ * cache lines. The writers of a shard are serialized by a latch, while the readers take no lock: they read under the
+ * sequence number of the shard and retry if a writer has changed it meanwhile. The slots of a shard outgrown are
+ * kept until the hash table is cleaned up since readers may still be on them, their size is less than the current
+ * slots of the shard.
+ *
+ * Unlike SHashObj, the data is copied out on lookup and no pointer into the hash table is handed out.
+ */
+typedef struct SShardHash SShardHash;
+
+/**
+ * initialize a sharded hash table
+ *
+ * @param capacity     initial number of entries of the hash table
+ * @param fn           hash function
+ * @param keySize      maximum length of the keys
+ * @param dataSize     size of the data of an entry
+ * @param numOfShards  number of shards, rounded up to a power of 2
+ * @return             hash table object
+ */
+SShardHash *taosShardHashInit(size_t capacity, _hash_fn_t fn, uint32_t keySize, uint32_t dataSize, int32_t numOfShards);
+
+/**
+ * put an entry into the hash table, the data of the entry with the same key is updated in place
+ *
+ * @param pHash      hash table object
+ * @param key        key
+ * @param keyLen     length of key, no more than the key size of the hash table
+ * @param data       data of the data size of the hash table
+ * @return           0 if success, -1 otherwise
+ */
+int32_t taosShardHashPut(SShardHash *pHash, const void *key, size_t keyLen, const void *data);
+
+/**
+ * copy the data of the entry with the specified key. The buffer may be written more than once, so it should not be
+ * shared with other threads.
+ *
+ * @param pHash      hash table object
+ * @param key        key
+ * @param keyLen     length of key
+ * @param data       buffer of the data size of the hash table, or NULL to check the key only
+ * @return           0 if found, -1 otherwise
+ */
+int32_t taosShardHashGet(SShardHash *pHash, const void *key, size_t keyLen, void *data);
+
+/**
+ * remove the entry with the specified key
+ *
+ * @param pHash      hash table object
+ * @param key        key
+ * @param keyLen     length of key
+ * @return           0 if success, -1 if not found
+ */
+int32_t taosShardHashRemove(SShardHash *pHash, const void *key, size_t keyLen);
+
+/**
+ * return the number of entries in the hash table
+ */
+int32_t taosShardHashGetSize(const SShardHash *pHash);
+
+/**
+ * return the memory consumed by the hash table, including the slots outgrown
+ */
+size_t taosShardHashGetMemSize(const SShardHash *pHash);
+
+/**
+ * clean up the hash table, no reader or writer should be on it
+ */
+void taosShardHashCleanup(SShardHash *pHash);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_TSHARDHASH_H
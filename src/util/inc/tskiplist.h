@@ -119,6 +119,7 @@ typedef struct SSkipList {
   uint32_t          size;
   SSkipListNode *   pHead;  // point to the first element
   SSkipListNode *   pTail;  // point to the last element
+  void *            pNodeChunk;  // memory chunks of the nodes, if the nodes are never removed one by one
 #if SKIP_LIST_RECORD_PERFORMANCE
   tSkipListState state;  // skiplist state
 #endif
@@ -34,6 +34,7 @@ int32_t taosSetNonblocking(SOCKET sock, int32_t on);
 SOCKET  taosOpenUdpSocket(uint32_t localIp, uint16_t localPort);
 SOCKET  taosOpenTcpClientSocket(uint32_t ip, uint16_t port, uint32_t localIp);
 SOCKET  taosOpenTcpServerSocket(uint32_t ip, uint16_t port);
+SOCKET  taosOpenTcpReusePortSocket(uint32_t ip, uint16_t port);
 int32_t taosKeepTcpAlive(SOCKET sockFd);
 
 int32_t  taosGetFqdn(char *);
@@ -33,6 +33,7 @@ typedef struct SWorkerPool {
   int32_t  max;  // max number of workers
   int32_t  min;  // min number of workers
   int32_t  num;  // current number of workers
+  int8_t   stealing;  // the workers read a worker queue set
   void *   qset;
   char *   name;
   SWorker *worker;
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "hashfunc.h"
+#include "tbloomfilter.h"
+
+uint32_t taosBloomFilterBytes(int32_t numOfElems, int32_t bitsPerElem) {
+  if (numOfElems <= 0 || bitsPerElem <= 0) {
+    return 0;
+  }
+
+  uint64_t nBits = (uint64_t)numOfElems * bitsPerElem;
+  uint64_t nBytes = (nBits + 7) / 8;
+
+  // keep the bitmap 8 bytes aligned
+  nBytes = (nBytes + 7) & ~((uint64_t)7);
+  if (nBytes > TSDB_BLOOM_FILTER_MAX_BYTES) {
+    nBytes = TSDB_BLOOM_FILTER_MAX_BYTES;
+  }
+
+  return (uint32_t)nBytes;
+}
+
+// the optimal number of hash functions is ln2 * bitsPerElem
+uint8_t taosBloomFilterNumOfHash(int32_t bitsPerElem) {
+  int32_t nHash = bitsPerElem * 69 / 100;
+  if (nHash < 1) {
+    nHash = 1;
+  } else if (nHash > TSDB_BLOOM_FILTER_MAX_HASH) {
+    nHash = TSDB_BLOOM_FILTER_MAX_HASH;
+  }
+
+  return (uint8_t)nHash;
+}
+
+void taosBloomFilterPut(uint8_t *bits, uint32_t nBytes, uint8_t nHash, const void *key, uint32_t len) {
+  if (nBytes == 0) {
+    return;
+  }
+
+  uint64_t hash = MurmurHash3_64(key, len);
+  uint32_t h1 = (uint32_t)hash;
+  uint32_t h2 = (uint32_t)(hash >> 32);
+  uint64_t nBits = (uint64_t)nBytes * 8;
+
+  for (uint8_t i = 0; i < nHash; ++i) {
+    uint64_t pos = (h1 + (uint64_t)i * h2) % nBits;
+    bits[pos >> 3] |= (uint8_t)(1u << (pos & 7));
+  }
+}
+
+bool taosBloomFilterMayContain(const uint8_t *bits, uint32_t nBytes, uint8_t nHash, const void *key, uint32_t len) {
+  if (nBytes == 0) {
+    return true;
+  }
+
+  uint64_t hash = MurmurHash3_64(key, len);
+  uint32_t h1 = (uint32_t)hash;
+  uint32_t h2 = (uint32_t)(hash >> 32);
+  uint64_t nBits = (uint64_t)nBytes * 8;
+
+  for (uint8_t i = 0; i < nHash; ++i) {
+    uint64_t pos = (h1 + (uint64_t)i * h2) % nBits;
+    if ((bits[pos >> 3] & (1u << (pos & 7))) == 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -45,6 +45,12 @@
  *   of leading zeros are larger than the trailing zeros, then record the last serveral bytes
  *   of the XORed value with informations. If not, record the first corresponding bytes.
  *
+ * SIMD Decompression:
+ *   On x86_64 CPUs supporting AVX2, the simple 8B integer decoder extracts 4 values of a word at
+ *   a time with variable shifts, and does the zigzag decoding and the prefix sum in registers.
+ *   The kernel is selected at runtime and produces the same output as the scalar one. The
+ *   timestamp and float/double decoders work on variable length bytes, so they stay scalar.
+ *
  */
 
 #include "os.h"
@@ -57,6 +63,10 @@
 #include "tulog.h"
 #include "tglobal.h"
 
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(WINDOWS)
+  #define TD_COMPRESS_AVX2
+  #include <immintrin.h>
+#endif
 
 static const int TEST_NUMBER = 1;
 #define is_bigendian() ((*(char *)&TEST_NUMBER) == 0)
@@ -66,6 +76,8 @@ static const int TEST_NUMBER = 1;
 #define ZIGZAG_ENCODE(T, v) ((u##T)((v) >> (sizeof(T) * 8 - 1))) ^ (((u##T)(v)) << 1)  // zigzag encode
 #define ZIGZAG_DECODE(T, v) ((v) >> 1) ^ -((T)((v)&1))                                 // zigzag decode
 
+bool tsDecompressSimd = true;
+
 #ifdef TD_TSZ
 bool lossyFloat  = false;
 bool lossyDouble = false;
@@ -232,6 +244,124 @@ int tsCompressINTImp(const char *const input, const int nelements, char *const o
   return opos;
 }
 
+#ifdef TD_COMPRESS_AVX2
+static int8_t tsCpuHasAVX2 = -1;
+
+static FORCE_INLINE bool tsDecompressUseAVX2() {
+  if (tsCpuHasAVX2 < 0) {
+    tsCpuHasAVX2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+  }
+
+  return tsDecompressSimd && tsCpuHasAVX2;
+}
+
+/*
+ * Decode the elems values of a simple 8B word into out, prev is the last value decoded before this word.
+ */
+__attribute__((target("avx2"))) static FORCE_INLINE int64_t tsDecodeSimple8bWordAVX2(uint64_t w, int bit, int elems,
+                                                                                      int64_t prev, int64_t *out) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi64x(1);
+  const __m256i mask = _mm256_set1_epi64x((int64_t)INT64MASK(bit));
+  const __m256i step = _mm256_set1_epi64x(4 * bit);
+  const __m256i word = _mm256_set1_epi64x((int64_t)w);
+
+  __m256i shift = _mm256_set_epi64x(4 + 3 * bit, 4 + 2 * bit, 4 + bit, 4);
+  __m256i base = _mm256_set1_epi64x(prev);
+
+  for (int i = 0; i < elems; i += 4) {
+    __m256i zigzag = _mm256_and_si256(_mm256_srlv_epi64(word, shift), mask);
+    __m256i diff = _mm256_xor_si256(_mm256_srli_epi64(zigzag, 1), _mm256_sub_epi64(zero, _mm256_and_si256(zigzag, one)));
+
+    // prefix sum of the 4 lanes
+    diff = _mm256_add_epi64(diff, _mm256_blend_epi32(_mm256_permute4x64_epi64(diff, 0x90), zero, 0x03));
+    diff = _mm256_add_epi64(diff, _mm256_blend_epi32(_mm256_permute4x64_epi64(diff, 0x40), zero, 0x0F));
+    diff = _mm256_add_epi64(diff, base);
+
+    _mm256_storeu_si256((__m256i *)(out + i), diff);
+
+    base = _mm256_permute4x64_epi64(diff, 0xFF);
+    shift = _mm256_add_epi64(shift, step);
+  }
+
+  return out[elems - 1];
+}
+
+__attribute__((target("avx2"))) static int tsDecompressINTImpAVX2(const char *const input, const int nelements,
+                                                                   char *const output, const char type) {
+  char bit_per_integer[] = {0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 15, 20, 30, 60};
+  int  selector_to_elems[] = {240, 120, 60, 30, 20, 15, 12, 10, 8, 7, 6, 5, 4, 3, 2, 1};
+
+  // 3 more slots since the kernel always writes 4 values at a time
+  int64_t     buf[240 + 3];
+  const char *ip = input + 1;
+  int         count = 0;
+  int64_t     prev_value = 0;
+
+  while (count < nelements) {
+    uint64_t w = 0;
+    memcpy(&w, ip, LONG_BYTES);
+    ip += LONG_BYTES;
+
+    int selector = (int)(w & INT64MASK(4));
+    int elems = selector_to_elems[selector];
+    int nvalues = MIN(elems, nelements - count);
+
+    if (selector == 0 || selector == 1) {
+      for (int i = 0; i < nvalues; i++) {
+        buf[i] = prev_value;
+      }
+    } else if (elems < 8) {
+      // too few values in the word to pay off the vector setup
+      int bit = bit_per_integer[selector];
+      if (type == TSDB_DATA_TYPE_BIGINT) {
+        for (int i = 0; i < nvalues; i++) {
+          uint64_t zigzag_value = ((w >> (4 + bit * i)) & INT64MASK(bit));
+          prev_value += ZIGZAG_DECODE(int64_t, zigzag_value);
+          *((int64_t *)output + count + i) = prev_value;
+        }
+        count += nvalues;
+        continue;
+      }
+
+      for (int i = 0; i < nvalues; i++) {
+        uint64_t zigzag_value = ((w >> (4 + bit * i)) & INT64MASK(bit));
+        prev_value += ZIGZAG_DECODE(int64_t, zigzag_value);
+        buf[i] = prev_value;
+      }
+    } else if (type == TSDB_DATA_TYPE_BIGINT && count + ((elems + 3) & ~3) <= nelements) {
+      // there is enough room left in the output, decode into it directly
+      prev_value = tsDecodeSimple8bWordAVX2(w, bit_per_integer[selector], elems, prev_value, (int64_t *)output + count);
+      count += nvalues;
+      continue;
+    } else {
+      prev_value = tsDecodeSimple8bWordAVX2(w, bit_per_integer[selector], elems, prev_value, buf);
+    }
+
+    switch (type) {
+      case TSDB_DATA_TYPE_BIGINT:
+        memcpy((int64_t *)output + count, buf, nvalues * sizeof(int64_t));
+        break;
+      case TSDB_DATA_TYPE_INT:
+        for (int i = 0; i < nvalues; i++) *((int32_t *)output + count + i) = (int32_t)buf[i];
+        break;
+      case TSDB_DATA_TYPE_SMALLINT:
+        for (int i = 0; i < nvalues; i++) *((int16_t *)output + count + i) = (int16_t)buf[i];
+        break;
+      case TSDB_DATA_TYPE_TINYINT:
+        for (int i = 0; i < nvalues; i++) *((int8_t *)output + count + i) = (int8_t)buf[i];
+        break;
+      default:
+        return -1;
+    }
+
+    count += nvalues;
+  }
+
+  return 0;
+}
+#endif
+
 int tsDecompressINTImp(const char *const input, const int nelements, char *const output, const char type) {
   int word_length = 0;
   switch (type) {
@@ -258,6 +388,13 @@ int tsDecompressINTImp(const char *const input, const int nelements, char *const
     return nelements * word_length;
   }
 
+#ifdef TD_COMPRESS_AVX2
+  if (tsDecompressUseAVX2()) {
+    if (tsDecompressINTImpAVX2(input, nelements, output, type) < 0) return -1;
+    return nelements * word_length;
+  }
+#endif
+
   // Selector value:              0    1   2   3   4   5   6   7   8  9  10  11
   // 12  13  14  15
   char bit_per_integer[] = {0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 15, 20, 30, 60};
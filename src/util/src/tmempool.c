@@ -125,3 +125,163 @@ void taosMemPoolCleanUp(mpool_h handle) {
   memset(pool_p, 0, sizeof(*pool_p));
   free(pool_p);
 }
+
+// the arena a piece comes from is kept right before it
+#define ARENA_OF_PIECE(_p) (*(SMemArena **)((char *)(_p) - sizeof(SMemArena *)))
+
+typedef struct SArenaBlock {
+  struct SArenaBlock *next;
+  size_t              size;
+  size_t              used;
+  char                data[];
+} SArenaBlock;
+
+// the header of a piece malloc'ed on its own
+typedef struct SArenaChunk {
+  struct SArenaChunk *prev;
+  struct SArenaChunk *next;
+  size_t              size;
+  SMemArena          *pArena;
+} SArenaChunk;
+
+struct SMemArena {
+  int32_t      blockSize;
+  bool         useMalloc;
+  SArenaBlock *pBlock;   // the block the pieces are carved out of, followed by the ones used up
+  SArenaChunk  chunks;   // the pieces malloc'ed on their own
+  size_t       memSize;
+};
+
+SMemArena *taosArenaInit(int32_t blockSize, bool useMalloc) {
+  if (blockSize <= 0) {
+    uError("invalid block size:%d of arena", blockSize);
+    return NULL;
+  }
+
+  SMemArena *pArena = calloc(1, sizeof(SMemArena));
+  if (pArena == NULL) {
+    uError("failed to allocate arena, reason:%s", strerror(errno));
+    return NULL;
+  }
+
+  pArena->blockSize = blockSize;
+  pArena->useMalloc = useMalloc;
+  pArena->chunks.prev = &pArena->chunks;
+  pArena->chunks.next = &pArena->chunks;
+  return pArena;
+}
+
+static void *taosArenaMallocChunk(SMemArena *pArena, size_t size) {
+  SArenaChunk *pChunk = malloc(sizeof(SArenaChunk) + size);
+  if (pChunk == NULL) {
+    return NULL;
+  }
+
+  pChunk->size = size;
+  pChunk->pArena = pArena;
+  if (pArena != NULL) {
+    pChunk->next = &pArena->chunks;
+    pChunk->prev = pArena->chunks.prev;
+    pChunk->prev->next = pChunk;
+    pArena->chunks.prev = pChunk;
+    pArena->memSize += sizeof(SArenaChunk) + size;
+  } else {
+    pChunk->prev = pChunk->next = NULL;
+  }
+
+  return pChunk + 1;
+}
+
+void *taosArenaMalloc(SMemArena *pArena, size_t size) {
+  if (pArena == NULL || pArena->useMalloc) {
+    return taosArenaMallocChunk(pArena, size);
+  }
+
+  size_t       len = ALIGN8(sizeof(SMemArena *) + size);
+  SArenaBlock *pBlock = pArena->pBlock;
+
+  if (pBlock == NULL || pBlock->used + len > pBlock->size) {
+    // a large piece takes a block of its own behind the current one, which is still carved for the small ones
+    size_t blockSize = (len > (size_t)pArena->blockSize / 4) ? len : (size_t)pArena->blockSize;
+
+    SArenaBlock *pNew = malloc(sizeof(SArenaBlock) + blockSize);
+    if (pNew == NULL) {
+      return NULL;
+    }
+
+    pNew->size = blockSize;
+    pNew->used = 0;
+    pArena->memSize += sizeof(SArenaBlock) + blockSize;
+
+    if (blockSize == len && pBlock != NULL) {
+      pNew->next = pBlock->next;
+      pBlock->next = pNew;
+    } else {
+      pNew->next = pBlock;
+      pArena->pBlock = pNew;
+    }
+
+    pBlock = pNew;
+  }
+
+  char *p = pBlock->data + pBlock->used + sizeof(SMemArena *);
+  pBlock->used += len;
+
+  ARENA_OF_PIECE(p) = pArena;
+  return p;
+}
+
+void *taosArenaCalloc(SMemArena *pArena, size_t num, size_t size) {
+  void *p = taosArenaMalloc(pArena, num * size);
+  if (p != NULL) {
+    memset(p, 0, num * size);
+  }
+
+  return p;
+}
+
+void taosArenaFree(void *p) {
+  if (p == NULL) {
+    return;
+  }
+
+  SMemArena *pArena = ARENA_OF_PIECE(p);
+  if (pArena != NULL && !pArena->useMalloc) {
+    return;
+  }
+
+  SArenaChunk *pChunk = (SArenaChunk *)p - 1;
+  if (pArena != NULL) {
+    pChunk->prev->next = pChunk->next;
+    pChunk->next->prev = pChunk->prev;
+    pArena->memSize -= sizeof(SArenaChunk) + pChunk->size;
+  }
+
+  free(pChunk);
+}
+
+size_t taosArenaGetMemSize(const SMemArena *pArena) {
+  return (pArena == NULL) ? 0 : pArena->memSize;
+}
+
+void taosArenaDestroy(SMemArena *pArena) {
+  if (pArena == NULL) {
+    return;
+  }
+
+  SArenaBlock *pBlock = pArena->pBlock;
+  while (pBlock != NULL) {
+    SArenaBlock *pNext = pBlock->next;
+    free(pBlock);
+    pBlock = pNext;
+  }
+
+  SArenaChunk *pChunk = pArena->chunks.next;
+  while (pChunk != &pArena->chunks) {
+    SArenaChunk *pNext = pChunk->next;
+    free(pChunk);
+    pChunk = pNext;
+  }
+
+  free(pArena);
+}
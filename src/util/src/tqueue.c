@@ -20,10 +20,18 @@
 
 typedef struct STaosQnode {
   int                 type;
+#ifdef TAOS_LOCKFREE_QUEUE
+  int32_t             pool;    // size class in the node pool, -1 if it is not pooled
+#endif
   struct STaosQnode  *next;
   char                item[];
 } STaosQnode;
 
+// state of a queue in the worker queue set
+#define TAOS_QUEUE_IDLE  0  // no items, or not in the queue set
+#define TAOS_QUEUE_READY 1  // in the ready list of a worker
+#define TAOS_QUEUE_BUSY  2  // drained by a worker, it is not handed to others until the worker reads again
+
 typedef struct STaosQueue {
   int32_t             itemSize;
   int32_t             numOfItems;
@@ -32,9 +40,23 @@ typedef struct STaosQueue {
   struct STaosQueue  *next;    // for queue set
   struct STaosQset   *qset;    // for queue set
   void               *ahandle; // for queue set
-  pthread_mutex_t     mutex;  
+  struct STaosQueue  *rnext;   // for the ready list of worker queue set
+  int32_t             home;    // worker the queue is handed to when it gets items
+  int8_t              state;
+  int8_t              closed;  // closed while it is held by a worker, the worker frees it
+#ifdef TAOS_LOCKFREE_QUEUE
+  struct STaosQnode  *stub;
+#endif
+  pthread_mutex_t     mutex;   // taken by the consumers, and by the producers if it is not lock-free
 } STaosQueue;
 
+typedef struct {
+  STaosQueue        *head;     // ready queues, taken from the head by the worker itself and the others
+  STaosQueue        *tail;
+  STaosQueue        *current;  // queue drained by the worker
+  pthread_mutex_t    mutex;
+} STaosQsetWorker;
+
 typedef struct STaosQset {
   STaosQueue        *head;
   STaosQueue        *current;
@@ -42,6 +64,13 @@ typedef struct STaosQset {
   int32_t            numOfQueues;
   int32_t            numOfItems;
   tsem_t             sem;
+  int32_t            numOfWorkers;  // only for the worker queue set
+  int32_t            nextHome;
+  int8_t             quit;
+  STaosQsetWorker   *workers;
+  int64_t            numOfReads;
+  int64_t            numOfSteals;
+  int64_t            numOfContentions;
 } STaosQset;
 
 typedef struct STaosQall {
@@ -50,6 +79,333 @@ typedef struct STaosQall {
   int32_t       itemSize;
   int32_t       numOfItems;
 } STaosQall; 
+
+static bool taosDetachFromQset(STaosQset *qset, STaosQueue *queue, bool close);
+
+#ifdef TAOS_LOCKFREE_QUEUE
+
+/*
+ * Intrusive multi-producer single-consumer queue. A producer swaps the tail with its node and then links the previous
+ * tail to it, no lock is taken. The consumers are serialized by the queue mutex. The stub node is put back when the
+ * last node is taken out, so that the tail never becomes NULL.
+ */
+static void taosQueuePush(STaosQueue *queue, STaosQnode *pNode) {
+  pNode->next = NULL;
+  STaosQnode *prev = atomic_exchange_ptr(&queue->tail, pNode);
+  atomic_store_ptr(&prev->next, pNode);
+}
+
+static bool taosQueueEmpty(STaosQueue *queue) { return atomic_load_ptr(&queue->tail) == queue->stub; }
+
+// a producer may have swapped the tail but not linked its node yet, the consumer waits for it
+static STaosQnode *taosQueuePop(STaosQueue *queue) {
+  while (1) {
+    STaosQnode *head = queue->head;
+    STaosQnode *next = atomic_load_ptr(&head->next);
+
+    if (head == queue->stub) {
+      if (next == NULL) {
+        if (taosQueueEmpty(queue)) return NULL;
+        sched_yield();
+        continue;
+      }
+
+      queue->head = next;
+      head = next;
+      next = atomic_load_ptr(&head->next);
+    }
+
+    if (next == NULL && atomic_load_ptr(&queue->tail) == head) {
+      taosQueuePush(queue, queue->stub);
+      next = atomic_load_ptr(&head->next);
+    }
+
+    if (next != NULL) {
+      queue->head = next;
+      return head;
+    }
+
+    sched_yield();
+  }
+}
+
+// the items put after it starts are left in the queue. The count is raised after an item is put, so one item at
+// least is taken if the queue is not empty
+static STaosQnode *taosQueuePopAll(STaosQueue *queue, int32_t *num) {
+  int32_t     total = atomic_load_32(&queue->numOfItems);
+  STaosQnode *first = NULL;
+  STaosQnode *last = NULL;
+
+  *num = 0;
+  while (*num == 0 || *num < total) {
+    STaosQnode *pNode = taosQueuePop(queue);
+    if (pNode == NULL) break;
+
+    pNode->next = NULL;
+    if (last) {
+      last->next = pNode;
+    } else {
+      first = pNode;
+    }
+    last = pNode;
+    (*num)++;
+  }
+
+  return first;
+}
+
+/*
+ * Node pool. The nodes of small items are kept by the thread freeing them, and moved between the threads in batches
+ * through the depot of their size class, so that the threads writing the queues get the nodes freed by the ones
+ * reading them.
+ */
+#define TAOS_QNODE_MIN_SIZE    64
+#define TAOS_QNODE_CLASSES     7     // the item sizes of the classes are 64, 128 ... 4096
+#define TAOS_QNODE_BATCH       32
+#define TAOS_QNODE_MAX_BATCHES 64    // batches kept in the depot of a class, the others are freed
+
+typedef struct {
+  STaosQnode *nodes;
+  int32_t     num;
+} SQnodeCache;
+
+typedef struct {
+  STaosQnode     *batches;  // a batch is linked by next, the batches by the first pointer in the item of their heads
+  int32_t         num;
+  pthread_mutex_t mutex;
+} SQnodeDepot;
+
+static __thread SQnodeCache tsQnodeCache[TAOS_QNODE_CLASSES];
+static __thread bool        tsQnodeCacheUsed = false;
+static SQnodeDepot          tsQnodeDepot[TAOS_QNODE_CLASSES];
+static pthread_key_t        tsQnodeKey;
+static pthread_once_t       tsQnodePoolInit = PTHREAD_ONCE_INIT;
+
+// the nodes cached by the exiting thread are freed
+static void taosCleanupQnodeCache(void *param) {
+  for (int32_t i = 0; i < TAOS_QNODE_CLASSES; ++i) {
+    STaosQnode *pNode = tsQnodeCache[i].nodes;
+    while (pNode) {
+      STaosQnode *next = pNode->next;
+      free(pNode);
+      pNode = next;
+    }
+    tsQnodeCache[i].nodes = NULL;
+    tsQnodeCache[i].num = 0;
+  }
+}
+
+static void taosInitQnodePool() {
+  for (int32_t i = 0; i < TAOS_QNODE_CLASSES; ++i) {
+    pthread_mutex_init(&tsQnodeDepot[i].mutex, NULL);
+  }
+  pthread_key_create(&tsQnodeKey, taosCleanupQnodeCache);
+}
+
+static SQnodeCache *taosGetQnodeCache() {
+  if (!tsQnodeCacheUsed) {
+    pthread_once(&tsQnodePoolInit, taosInitQnodePool);
+    pthread_setspecific(tsQnodeKey, tsQnodeCache);
+    tsQnodeCacheUsed = true;
+  }
+
+  return tsQnodeCache;
+}
+
+static int32_t taosGetQnodeClass(int size) {
+  int32_t cls = 0;
+  while (cls < TAOS_QNODE_CLASSES && (TAOS_QNODE_MIN_SIZE << cls) < size) cls++;
+  return (cls < TAOS_QNODE_CLASSES) ? cls : -1;
+}
+
+static void taosFillQnodeCache(SQnodeCache *pCache, int32_t cls) {
+  SQnodeDepot *pDepot = tsQnodeDepot + cls;
+
+  pthread_mutex_lock(&pDepot->mutex);
+  STaosQnode *batch = pDepot->batches;
+  if (batch) {
+    pDepot->batches = *(STaosQnode **)batch->item;
+    pDepot->num--;
+  }
+  pthread_mutex_unlock(&pDepot->mutex);
+
+  pCache->nodes = batch;
+  pCache->num = (batch != NULL) ? TAOS_QNODE_BATCH : 0;
+}
+
+static void taosFlushQnodeCache(SQnodeCache *pCache, int32_t cls) {
+  SQnodeDepot *pDepot = tsQnodeDepot + cls;
+  STaosQnode  *batch = pCache->nodes;
+  STaosQnode  *last = batch;
+  for (int32_t i = 1; i < TAOS_QNODE_BATCH; ++i) last = last->next;
+
+  pCache->nodes = last->next;
+  pCache->num -= TAOS_QNODE_BATCH;
+  last->next = NULL;
+
+  pthread_mutex_lock(&pDepot->mutex);
+  bool kept = pDepot->num < TAOS_QNODE_MAX_BATCHES;
+  if (kept) {
+    *(STaosQnode **)batch->item = pDepot->batches;
+    pDepot->batches = batch;
+    pDepot->num++;
+  }
+  pthread_mutex_unlock(&pDepot->mutex);
+
+  while (!kept && batch) {
+    STaosQnode *next = batch->next;
+    free(batch);
+    batch = next;
+  }
+}
+
+static STaosQnode *taosAllocQnode(int size) {
+  int32_t cls = taosGetQnodeClass(size);
+  if (cls < 0) {
+    STaosQnode *pNode = (STaosQnode *)calloc(sizeof(STaosQnode) + size, 1);
+    if (pNode) pNode->pool = -1;
+    return pNode;
+  }
+
+  SQnodeCache *pCache = taosGetQnodeCache() + cls;
+  if (pCache->nodes == NULL) taosFillQnodeCache(pCache, cls);
+
+  STaosQnode *pNode = pCache->nodes;
+  if (pNode) {
+    pCache->nodes = pNode->next;
+    pCache->num--;
+    memset(pNode, 0, sizeof(STaosQnode) + size);
+  } else {
+    pNode = (STaosQnode *)calloc(sizeof(STaosQnode) + (TAOS_QNODE_MIN_SIZE << cls), 1);
+    if (pNode == NULL) return NULL;
+  }
+
+  pNode->pool = cls;
+  return pNode;
+}
+
+static void taosFreeQnode(STaosQnode *pNode) {
+  if (pNode->pool < 0) {
+    free(pNode);
+    return;
+  }
+
+  SQnodeCache *pCache = taosGetQnodeCache() + pNode->pool;
+  pNode->next = pCache->nodes;
+  pCache->nodes = pNode;
+  if (++pCache->num >= TAOS_QNODE_BATCH * 2) taosFlushQnodeCache(pCache, pNode->pool);
+}
+
+#else
+
+static void taosQueuePush(STaosQueue *queue, STaosQnode *pNode) {
+  pNode->next = NULL;
+  if (queue->tail) {
+    queue->tail->next = pNode;
+    queue->tail = pNode;
+  } else {
+    queue->head = pNode;
+    queue->tail = pNode; 
+  }
+}
+
+static bool taosQueueEmpty(STaosQueue *queue) { return queue->head == NULL; }
+
+static STaosQnode *taosQueuePop(STaosQueue *queue) {
+  STaosQnode *pNode = queue->head;
+  if (pNode) {
+    queue->head = pNode->next;
+    if (queue->head == NULL) queue->tail = NULL;
+  }
+
+  return pNode;
+}
+
+static STaosQnode *taosQueuePopAll(STaosQueue *queue, int32_t *num) {
+  STaosQnode *pNode = queue->head;
+  *num = queue->numOfItems;
+  queue->head = NULL;
+  queue->tail = NULL;
+  return pNode;
+}
+
+static STaosQnode *taosAllocQnode(int size) { return (STaosQnode *)calloc(sizeof(STaosQnode) + size, 1); }
+
+static void taosFreeQnode(STaosQnode *pNode) { free(pNode); }
+
+#endif
+
+// the lock is counted as contended if it can not be taken at once
+static void taosLockQset(pthread_mutex_t *mutex, STaosQset *qset) {
+  if (pthread_mutex_trylock(mutex) != 0) {
+    atomic_add_fetch_64(&qset->numOfContentions, 1);
+    pthread_mutex_lock(mutex);
+  }
+}
+
+static void taosFreeQueue(STaosQueue *queue) {
+  pthread_mutex_destroy(&queue->mutex);
+#ifdef TAOS_LOCKFREE_QUEUE
+  free(queue->stub);
+#endif
+  free(queue);
+}
+
+// the queue shall be made ready by the caller, no one else puts it into a ready list
+static void taosPushReadyQueue(STaosQset *qset, int32_t workerId, STaosQueue *queue) {
+  STaosQsetWorker *pWorker = qset->workers + workerId;
+  queue->rnext = NULL;
+
+  taosLockQset(&pWorker->mutex, qset);
+  if (pWorker->tail) {
+    pWorker->tail->rnext = queue;
+  } else {
+    pWorker->head = queue;
+  }
+  pWorker->tail = queue;
+  pthread_mutex_unlock(&pWorker->mutex);
+}
+
+// the producers and the worker holding the queue may make it ready at the same time, only one of them wins
+static bool taosSetQueueReady(STaosQset *qset, int32_t workerId, STaosQueue *queue) {
+  if (atomic_val_compare_exchange_8(&queue->state, TAOS_QUEUE_IDLE, TAOS_QUEUE_READY) != TAOS_QUEUE_IDLE) return false;
+
+  taosPushReadyQueue(qset, workerId, queue);
+  return true;
+}
+
+/*
+ * Called by the worker holding the queue with its mutex. For the lock-free queue, a producer may have put its item
+ * after the queue is found empty but before it is idle, so the queue is checked again. Return true if it is ready.
+ */
+static bool taosSetQueueIdle(STaosQset *qset, int32_t workerId, STaosQueue *queue) {
+  // a full barrier, the state shall be seen by the producers before the queue is checked
+  atomic_exchange_8(&queue->state, TAOS_QUEUE_IDLE);
+
+#ifdef TAOS_LOCKFREE_QUEUE
+  if (!taosQueueEmpty(queue) && taosSetQueueReady(qset, workerId, queue)) {
+    tsem_post(&qset->sem);
+    return true;
+  }
+#endif
+
+  return false;
+}
+
+static STaosQueue *taosPopReadyQueue(STaosQset *qset, STaosQsetWorker *pWorker) {
+  if (atomic_load_ptr(&pWorker->head) == NULL) return NULL;
+
+  taosLockQset(&pWorker->mutex, qset);
+  STaosQueue *queue = pWorker->head;
+  if (queue) {
+    pWorker->head = queue->rnext;
+    if (pWorker->head == NULL) pWorker->tail = NULL;
+    queue->rnext = NULL;
+  }
+  pthread_mutex_unlock(&pWorker->mutex);
+
+  return queue;
+}
   
 taos_queue taosOpenQueue() {
   
@@ -59,6 +415,18 @@ taos_queue taosOpenQueue() {
     return NULL;
   }
 
+#ifdef TAOS_LOCKFREE_QUEUE
+  queue->stub = (STaosQnode *)calloc(sizeof(STaosQnode), 1);
+  if (queue->stub == NULL) {
+    free(queue);
+    terrno = TSDB_CODE_COM_OUT_OF_MEMORY;
+    return NULL;
+  }
+  queue->stub->pool = -1;
+  queue->head = queue->stub;
+  queue->tail = queue->stub;
+#endif
+
   pthread_mutex_init(&queue->mutex, NULL);
 
   uTrace("queue:%p is opened", queue);
@@ -71,28 +439,29 @@ void taosCloseQueue(taos_queue param) {
   STaosQnode *pTemp;
   STaosQset  *qset;
 
+  int32_t num = 0;
   pthread_mutex_lock(&queue->mutex);
-  STaosQnode *pNode = queue->head;  
-  queue->head = NULL;
+  STaosQnode *pNode = taosQueuePopAll(queue, &num);
   qset = queue->qset;
   pthread_mutex_unlock(&queue->mutex);
 
-  if (queue->qset) taosRemoveFromQset(qset, queue); 
+  // the queue held by a worker of the worker queue set is freed by the worker
+  bool held = false;
+  if (qset) held = taosDetachFromQset(qset, queue, true);
 
   while (pNode) {
     pTemp = pNode;
     pNode = pNode->next;
-    free (pTemp);
+    taosFreeQnode(pTemp);
   }
 
-  pthread_mutex_destroy(&queue->mutex);
-  free(queue);
+  if (!held) taosFreeQueue(queue);
 
   uTrace("queue:%p is closed", queue);
 }
 
 void *taosAllocateQitem(int size) {
-  STaosQnode *pNode = (STaosQnode *)calloc(sizeof(STaosQnode) + size, 1);
+  STaosQnode *pNode = taosAllocQnode(size);
   
   if (pNode == NULL) return NULL;
   uTrace("item:%p, node:%p is allocated", pNode->item, pNode);
@@ -105,32 +474,36 @@ void taosFreeQitem(void *param) {
   char *temp = (char *)param;
   temp -= sizeof(STaosQnode);
   uTrace("item:%p, node:%p is freed", param, temp);
-  free(temp);
+  taosFreeQnode((STaosQnode *)temp);
 }
 
 int taosWriteQitem(taos_queue param, int type, void *item) {
   STaosQueue *queue = (STaosQueue *)param;
   STaosQnode *pNode = (STaosQnode *)(((char *)item) - sizeof(STaosQnode));
   pNode->type = type;
-  pNode->next = NULL;
 
+#ifndef TAOS_LOCKFREE_QUEUE
   pthread_mutex_lock(&queue->mutex);
+#endif
 
-  if (queue->tail) {
-    queue->tail->next = pNode;
-    queue->tail = pNode;
-  } else {
-    queue->head = pNode;
-    queue->tail = pNode; 
-  }
+  taosQueuePush(queue, pNode);
+
+  int32_t    num = atomic_add_fetch_32(&queue->numOfItems, 1);
+  STaosQset *qset = atomic_load_ptr(&queue->qset);
+  bool       notify = (qset != NULL);
+  if (qset) atomic_add_fetch_32(&qset->numOfItems, 1);
+  uTrace("item:%p is put into queue:%p, type:%d items:%d", item, queue, type, num);
 
-  queue->numOfItems++;
-  if (queue->qset) atomic_add_fetch_32(&queue->qset->numOfItems, 1);
-  uTrace("item:%p is put into queue:%p, type:%d items:%d", item, queue, type, queue->numOfItems);
+  // the worker queue set is notified once for a queue, no matter how many items it has
+  if (qset && qset->workers) {
+    notify = taosSetQueueReady(qset, queue->home, queue);
+  }
 
+#ifndef TAOS_LOCKFREE_QUEUE
   pthread_mutex_unlock(&queue->mutex);
+#endif
 
-  if (queue->qset) tsem_post(&queue->qset->sem);
+  if (notify) tsem_post(&qset->sem);
 
   return 0;
 }
@@ -142,17 +515,14 @@ int taosReadQitem(taos_queue param, int *type, void **pitem) {
 
   pthread_mutex_lock(&queue->mutex);
 
-  if (queue->head) {
-      pNode = queue->head;
+  pNode = taosQueuePop(queue);
+  if (pNode) {
       *pitem = pNode->item;
       *type = pNode->type;
-      queue->head = pNode->next;
-      if (queue->head == NULL) 
-        queue->tail = NULL;
-      queue->numOfItems--;
+      int32_t num = atomic_sub_fetch_32(&queue->numOfItems, 1);
       if (queue->qset) atomic_sub_fetch_32(&queue->qset->numOfItems, 1);
       code = 1;
-      uDebug("item:%p is read out from queue:%p, type:%d items:%d", *pitem, queue, *type, queue->numOfItems);
+      uDebug("item:%p is read out from queue:%p, type:%d items:%d", *pitem, queue, *type, num);
   } 
 
   pthread_mutex_unlock(&queue->mutex);
@@ -177,18 +547,15 @@ int taosReadAllQitems(taos_queue param, taos_qall p2) {
 
   pthread_mutex_lock(&queue->mutex);
 
-  empty = queue->head == NULL;
+  empty = taosQueueEmpty(queue);
   if (!empty) {
     memset(qall, 0, sizeof(STaosQall));
-    qall->current = queue->head;
-    qall->start = queue->head;
-    qall->numOfItems = queue->numOfItems;
+    qall->start = taosQueuePopAll(queue, &qall->numOfItems);
+    qall->current = qall->start;
     qall->itemSize = queue->itemSize;
     code = qall->numOfItems;
 
-    queue->head = NULL;
-    queue->tail = NULL;
-    queue->numOfItems = 0;
+    atomic_sub_fetch_32(&queue->numOfItems, qall->numOfItems);
     if (queue->qset) atomic_sub_fetch_32(&queue->qset->numOfItems, qall->numOfItems);
   }
 
@@ -242,6 +609,52 @@ taos_qset taosOpenQset() {
   return qset;
 }
 
+taos_qset taosOpenWorkerQset(int32_t numOfWorkers) {
+  STaosQset *qset = taosOpenQset();
+  if (qset == NULL) return NULL;
+
+  qset->workers = calloc(numOfWorkers, sizeof(STaosQsetWorker));
+  if (qset->workers == NULL) {
+    taosCloseQset(qset);
+    terrno = TSDB_CODE_COM_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  qset->numOfWorkers = numOfWorkers;
+  for (int32_t i = 0; i < numOfWorkers; ++i) {
+    pthread_mutex_init(&qset->workers[i].mutex, NULL);
+  }
+
+  uTrace("qset:%p is opened for %d workers", qset, numOfWorkers);
+  return qset;
+}
+
+// the queue closed while it is held by the worker is freed here
+static void taosDropHeldQueue(STaosQueue *queue) {
+  pthread_mutex_lock(&queue->mutex);
+  if (queue->closed) {
+    pthread_mutex_unlock(&queue->mutex);
+    taosFreeQueue(queue);
+    return;
+  }
+
+  atomic_store_8(&queue->state, TAOS_QUEUE_IDLE);
+  queue->rnext = NULL;
+  pthread_mutex_unlock(&queue->mutex);
+}
+
+static void taosCloseQsetWorker(STaosQsetWorker *pWorker) {
+  STaosQueue *queue = pWorker->head;
+  while (queue) {
+    STaosQueue *next = queue->rnext;
+    taosDropHeldQueue(queue);
+    queue = next;
+  }
+
+  if (pWorker->current) taosDropHeldQueue(pWorker->current);
+  pthread_mutex_destroy(&pWorker->mutex);
+}
+
 void taosCloseQset(taos_qset param) {
   if (param == NULL) return;
   STaosQset *qset = (STaosQset *)param;
@@ -257,6 +670,11 @@ void taosCloseQset(taos_qset param) {
   }
   pthread_mutex_unlock(&qset->mutex);
 
+  for (int32_t i = 0; i < qset->numOfWorkers; ++i) {
+    taosCloseQsetWorker(qset->workers + i);
+  }
+  tfree(qset->workers);
+
   pthread_mutex_destroy(&qset->mutex);
   uTrace("qset:%p is closed", qset);
   tsem_destroy(&qset->sem);
@@ -269,6 +687,7 @@ void taosCloseQset(taos_qset param) {
 void taosQsetThreadResume(taos_qset param) {
   STaosQset *qset = (STaosQset *)param;
   uDebug("qset:%p, it will exit", qset);
+  if (qset->workers) atomic_store_8(&qset->quit, 1);
   tsem_post(&qset->sem);
 }
 
@@ -285,22 +704,35 @@ int taosAddIntoQset(taos_qset p1, taos_queue p2, void *ahandle) {
   qset->head = queue;
   qset->numOfQueues++;
 
+  bool notify = false;
   pthread_mutex_lock(&queue->mutex);
   atomic_add_fetch_32(&qset->numOfItems, queue->numOfItems);
   queue->qset = qset;
+  if (qset->workers) {
+    queue->home = (qset->nextHome++) % qset->numOfWorkers;
+    notify = !taosQueueEmpty(queue) && taosSetQueueReady(qset, queue->home, queue);
+  }
   pthread_mutex_unlock(&queue->mutex);
 
   pthread_mutex_unlock(&qset->mutex);
 
+  if (notify) tsem_post(&qset->sem);
+
   uTrace("queue:%p is added into qset:%p", queue, qset);
   return 0;
 }
 
 void taosRemoveFromQset(taos_qset p1, taos_queue p2) {
-  STaosQueue *queue = (STaosQueue *)p2;
-  STaosQset  *qset = (STaosQset *)p1;
- 
+  taosDetachFromQset((STaosQset *)p1, (STaosQueue *)p2, false);
+}
+
+/*
+ * A queue of the worker queue set may be still in the ready list of a worker or drained by a worker, it is left
+ * there and skipped by the worker. If the queue is to be closed, the worker frees it and true is returned.
+ */
+static bool taosDetachFromQset(STaosQset *qset, STaosQueue *queue, bool close) {
   STaosQueue *tqueue = NULL;
+  bool        held = false;
 
   pthread_mutex_lock(&qset->mutex);
 
@@ -331,6 +763,10 @@ void taosRemoveFromQset(taos_qset p1, taos_queue p2) {
       atomic_sub_fetch_32(&qset->numOfItems, queue->numOfItems);
       queue->qset = NULL;
       queue->next = NULL;
+      if (close && queue->state != TAOS_QUEUE_IDLE) {
+        queue->closed = 1;
+        held = true;
+      }
       pthread_mutex_unlock(&queue->mutex);
     }
   } 
@@ -338,6 +774,7 @@ void taosRemoveFromQset(taos_qset p1, taos_queue p2) {
   pthread_mutex_unlock(&qset->mutex);
 
   uTrace("queue:%p is removed from qset:%p", queue, qset);
+  return held;
 }
 
 int taosGetQueueNumber(taos_qset param) {
@@ -351,7 +788,7 @@ int taosReadQitemFromQset(taos_qset param, int *type, void **pitem, void **phand
    
   tsem_wait(&qset->sem);
 
-  pthread_mutex_lock(&qset->mutex);
+  taosLockQset(&qset->mutex, qset);
 
   for(int i=0; i<qset->numOfQueues; ++i) {
     if (qset->current == NULL) 
@@ -359,22 +796,20 @@ int taosReadQitemFromQset(taos_qset param, int *type, void **pitem, void **phand
     STaosQueue *queue = qset->current;
     if (queue) qset->current = queue->next;
     if (queue == NULL) break;
-    if (queue->head == NULL) continue;
+    if (taosQueueEmpty(queue)) continue;
 
     pthread_mutex_lock(&queue->mutex);
 
-    if (queue->head) {
-        pNode = queue->head;
+    pNode = taosQueuePop(queue);
+    if (pNode) {
         *pitem = pNode->item;
         if (type) *type = pNode->type;
         if (phandle) *phandle = queue->ahandle;
-        queue->head = pNode->next;
-        if (queue->head == NULL) 
-          queue->tail = NULL;
-        queue->numOfItems--;
+        int32_t num = atomic_sub_fetch_32(&queue->numOfItems, 1);
         atomic_sub_fetch_32(&qset->numOfItems, 1);
+        atomic_add_fetch_64(&qset->numOfReads, 1);
         code = 1;
-        uTrace("item:%p is read out from queue:%p, type:%d items:%d", *pitem, queue, pNode->type, queue->numOfItems);
+        uTrace("item:%p is read out from queue:%p, type:%d items:%d", *pitem, queue, pNode->type, num);
     } 
 
     pthread_mutex_unlock(&queue->mutex);
@@ -393,7 +828,7 @@ int taosReadAllQitemsFromQset(taos_qset param, taos_qall p2, void **phandle) {
   int         code = 0;
 
   tsem_wait(&qset->sem);
-  pthread_mutex_lock(&qset->mutex);
+  taosLockQset(&qset->mutex, qset);
 
   for(int i=0; i<qset->numOfQueues; ++i) {
     if (qset->current == NULL) 
@@ -401,22 +836,20 @@ int taosReadAllQitemsFromQset(taos_qset param, taos_qall p2, void **phandle) {
     queue = qset->current;
     if (queue) qset->current = queue->next;
     if (queue == NULL) break;
-    if (queue->head == NULL) continue;
+    if (taosQueueEmpty(queue)) continue;
 
     pthread_mutex_lock(&queue->mutex);
 
-    if (queue->head) {
-      qall->current = queue->head;
-      qall->start = queue->head;
-      qall->numOfItems = queue->numOfItems;
+    if (!taosQueueEmpty(queue)) {
+      qall->start = taosQueuePopAll(queue, &qall->numOfItems);
+      qall->current = qall->start;
       qall->itemSize = queue->itemSize;
       code = qall->numOfItems;
       *phandle = queue->ahandle;
           
-      queue->head = NULL;
-      queue->tail = NULL;
-      queue->numOfItems = 0;
+      atomic_sub_fetch_32(&queue->numOfItems, qall->numOfItems);
       atomic_sub_fetch_32(&qset->numOfItems, qall->numOfItems);
+      atomic_add_fetch_64(&qset->numOfReads, 1);
       for (int j=1; j<qall->numOfItems; ++j) tsem_wait(&qset->sem);
     } 
 
@@ -429,15 +862,140 @@ int taosReadAllQitemsFromQset(taos_qset param, taos_qall p2, void **phandle) {
   return code;
 }
 
+// the queue mutex shall be held, it is released if the queue is not to be read
+static bool taosCheckReadyQueue(STaosQset *qset, STaosQueue *queue) {
+  if (queue->closed) {
+    pthread_mutex_unlock(&queue->mutex);
+    taosFreeQueue(queue);
+    return false;
+  }
+
+  if (queue->qset != qset) {
+    atomic_store_8(&queue->state, TAOS_QUEUE_IDLE);
+    pthread_mutex_unlock(&queue->mutex);
+    return false;
+  }
+
+  if (taosQueueEmpty(queue)) {
+    taosSetQueueIdle(qset, queue->home, queue);
+    pthread_mutex_unlock(&queue->mutex);
+    return false;
+  }
+
+  return true;
+}
+
+// the ready queue of the worker is taken first, then the ones of the others. It is returned with its mutex held
+static STaosQueue *taosGetReadyQueue(STaosQset *qset, int32_t workerId) {
+  while (1) {
+    tsem_wait(&qset->sem);
+
+    // there is a ready queue for each notification, but it may be pushed into a list already passed over while the
+    // one in a later list is taken by another worker, so the lists are scanned again instead of waiting
+    STaosQueue *queue = NULL;
+    while (queue == NULL) {
+      for (int32_t i = 0; i < qset->numOfWorkers && queue == NULL; ++i) {
+        queue = taosPopReadyQueue(qset, qset->workers + (workerId + i) % qset->numOfWorkers);
+        if (queue && i > 0) atomic_add_fetch_64(&qset->numOfSteals, 1);
+      }
+
+      if (queue == NULL) {
+        if (atomic_load_8(&qset->quit)) return NULL;
+        sched_yield();
+      }
+    }
+
+    pthread_mutex_lock(&queue->mutex);
+    if (taosCheckReadyQueue(qset, queue)) return queue;
+  }
+}
+
+// the queue drained by the worker last time is handed out again if it has got new items
+static void taosReleaseWorkerQueue(STaosQset *qset, int32_t workerId) {
+  STaosQsetWorker *pWorker = qset->workers + workerId;
+  STaosQueue      *queue = pWorker->current;
+  if (queue == NULL) return;
+
+  pWorker->current = NULL;
+  pthread_mutex_lock(&queue->mutex);
+  if (!taosCheckReadyQueue(qset, queue)) return;
+
+  atomic_store_8(&queue->state, TAOS_QUEUE_READY);
+  taosPushReadyQueue(qset, workerId, queue);
+  pthread_mutex_unlock(&queue->mutex);
+  tsem_post(&qset->sem);
+}
+
+int taosReadQitemFromWorkerQset(taos_qset param, int32_t workerId, int *type, void **pitem, void **phandle) {
+  STaosQset *qset = (STaosQset *)param;
+  if (qset->workers == NULL) return taosReadQitemFromQset(param, type, pitem, phandle);
+
+  workerId = workerId % qset->numOfWorkers;
+  STaosQueue *queue = taosGetReadyQueue(qset, workerId);
+  if (queue == NULL) return 0;
+
+  STaosQnode *pNode = taosQueuePop(queue);
+  *pitem = pNode->item;
+  if (type) *type = pNode->type;
+  if (phandle) *phandle = queue->ahandle;
+  int32_t num = atomic_sub_fetch_32(&queue->numOfItems, 1);
+  atomic_sub_fetch_32(&qset->numOfItems, 1);
+  atomic_add_fetch_64(&qset->numOfReads, 1);
+  uTrace("item:%p is read out from queue:%p, type:%d items:%d", *pitem, queue, pNode->type, num);
+
+  // the rest items can be read by the other workers at the same time
+  bool notify = !taosQueueEmpty(queue);
+  if (notify) {
+    atomic_store_8(&queue->state, TAOS_QUEUE_READY);
+    taosPushReadyQueue(qset, workerId, queue);
+  } else {
+    taosSetQueueIdle(qset, workerId, queue);
+  }
+  pthread_mutex_unlock(&queue->mutex);
+
+  if (notify) tsem_post(&qset->sem);
+  return 1;
+}
+
+int taosReadAllQitemsFromWorkerQset(taos_qset param, int32_t workerId, taos_qall p2, void **phandle) {
+  STaosQset *qset = (STaosQset *)param;
+  STaosQall *qall = (STaosQall *)p2;
+  if (qset->workers == NULL) return taosReadAllQitemsFromQset(param, p2, phandle);
+
+  // the items of a queue are processed by one worker at a time, in the order they are written
+  workerId = workerId % qset->numOfWorkers;
+  taosReleaseWorkerQueue(qset, workerId);
+
+  STaosQueue *queue = taosGetReadyQueue(qset, workerId);
+  if (queue == NULL) return 0;
+
+  qall->start = taosQueuePopAll(queue, &qall->numOfItems);
+  qall->current = qall->start;
+  qall->itemSize = queue->itemSize;
+  *phandle = queue->ahandle;
+
+  atomic_sub_fetch_32(&queue->numOfItems, qall->numOfItems);
+  atomic_store_8(&queue->state, TAOS_QUEUE_BUSY);
+  qset->workers[workerId].current = queue;
+  atomic_sub_fetch_32(&qset->numOfItems, qall->numOfItems);
+  atomic_add_fetch_64(&qset->numOfReads, 1);
+  pthread_mutex_unlock(&queue->mutex);
+
+  return qall->numOfItems;
+}
+
+void taosGetQsetStat(taos_qset param, SQsetStat *pStat) {
+  STaosQset *qset = (STaosQset *)param;
+  pStat->numOfReads = atomic_load_64(&qset->numOfReads);
+  pStat->numOfSteals = atomic_load_64(&qset->numOfSteals);
+  pStat->numOfContentions = atomic_load_64(&qset->numOfContentions);
+}
+
 int taosGetQueueItemsNumber(taos_queue param) {
   STaosQueue *queue = (STaosQueue *)param;
   if (!queue) return 0;
 
-  int num;
-  pthread_mutex_lock(&queue->mutex);
-  num = queue->numOfItems;
-  pthread_mutex_unlock(&queue->mutex);
-  return num;
+  return atomic_load_32(&queue->numOfItems);
 }
 
 int taosGetQsetItemsNumber(taos_qset param) {
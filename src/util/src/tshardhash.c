@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "tshardhash.h"
+#include "tlockfree.h"
+#include "tulog.h"
+#include "taosdef.h"
+
+#define SHARD_HASH_MAX_SHARDS     256
+#define SHARD_HASH_MIN_CAPACITY   8
+#define SHARD_HASH_MAX_CAPACITY   (1u << 30u)
+#define SHARD_HASH_CACHE_LINE     64
+
+// grow a shard when 3/4 of its slots are used
+#define SHARD_NEED_GROW(_s) (((_s)->size + 1) * 4 > ((_s)->pTable->mask + 1) * 3)
+
+#define GET_SHARD_SLOT(_h, _t, _p)  ((_t)->slots + (size_t)(_p) * (_h)->slotSize)
+#define GET_SLOT_KEY(_s)            ((_s) + sizeof(uint32_t))
+#define GET_SLOT_DATA(_h, _s)       ((_s) + sizeof(uint32_t) + (_h)->keySize)
+
+typedef struct SShardTable {
+  uint32_t            mask;     // number of slots - 1
+  uint32_t           *hashes;   // hash value of each slot, 0 for an empty one
+  char               *slots;    // key length, key and data of each slot
+  struct SShardTable *retired;  // the slots outgrown before this one
+} SShardTable;
+
+typedef struct SHashShard {
+  int32_t      seq;     // odd while a writer is changing the slots
+  SRWLatch     latch;   // serializes the writers
+  int32_t      size;
+  SShardTable *pTable;
+} SHashShard;
+
+// a shard per cache line, so that the readers of a shard are not disturbed by the writers of the others
+typedef union {
+  SHashShard shard;
+  char       padding[SHARD_HASH_CACHE_LINE];
+} SHashShardLine;
+
+typedef struct SShardHash {
+  _hash_fn_t      hashFp;
+  uint32_t        keySize;
+  uint32_t        dataSize;
+  uint32_t        slotSize;
+  int32_t         numOfShards;
+  SHashShardLine *shards;
+  void           *pMem;  // the memory the shards are aligned in
+} SShardHash;
+
+static FORCE_INLINE uint32_t shardHashVal(const SShardHash *pHash, const void *key, size_t keyLen) {
+  // the hash values are mixed, since the integer hash functions leave the higher bits choosing the shard unchanged
+  uint32_t h = (*pHash->hashFp)(key, (uint32_t)keyLen);
+  h ^= h >> 16u;
+  h *= 0x85ebca6b;
+  h ^= h >> 13u;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16u;
+
+  return (h == 0) ? 1 : h;
+}
+
+static FORCE_INLINE SHashShard *shardOfHashVal(SShardHash *pHash, uint32_t hashVal) {
+  // the higher bits choose the shard, and the lower ones the slot in it
+  int32_t index = (int32_t)(((uint64_t)hashVal * (uint32_t)pHash->numOfShards) >> 32u);
+  return &pHash->shards[index].shard;
+}
+
+static FORCE_INLINE uint32_t shardCapacity(size_t capacity) {
+  uint32_t i = SHARD_HASH_MIN_CAPACITY;
+  while (i < capacity && i < SHARD_HASH_MAX_CAPACITY) i = (i << 1u);
+  return i;
+}
+
+static SShardTable *shardTableCreate(const SShardHash *pHash, uint32_t capacity) {
+  SShardTable *pTable = calloc(1, sizeof(SShardTable) + capacity * sizeof(uint32_t) + (size_t)capacity * pHash->slotSize);
+  if (pTable == NULL) {
+    return NULL;
+  }
+
+  pTable->mask = capacity - 1;
+  pTable->hashes = (uint32_t *)(pTable + 1);
+  pTable->slots = (char *)(pTable->hashes + capacity);
+  return pTable;
+}
+
+static FORCE_INLINE size_t shardTableMemSize(const SShardHash *pHash, const SShardTable *pTable) {
+  return sizeof(SShardTable) + (pTable->mask + 1) * (sizeof(uint32_t) + (size_t)pHash->slotSize);
+}
+
+static FORCE_INLINE int32_t shardTableFind(const SShardHash *pHash, const SShardTable *pTable, uint32_t hashVal,
+                                          const void *key, uint32_t keyLen) {
+  uint32_t pos = hashVal & pTable->mask;
+  for (uint32_t i = 0; i <= pTable->mask; ++i) {
+    uint32_t h = pTable->hashes[pos];
+    if (h == 0) {
+      return -1;
+    }
+
+    if (h == hashVal) {
+      // the key length read by a reader may be torn, it is checked before the key is compared
+      const char *pSlot = GET_SHARD_SLOT(pHash, pTable, pos);
+      if (*(uint32_t *)pSlot == keyLen && memcmp(GET_SLOT_KEY(pSlot), key, keyLen) == 0) {
+        return (int32_t)pos;
+      }
+    }
+
+    pos = (pos + 1) & pTable->mask;
+  }
+
+  return -1;
+}
+
+static FORCE_INLINE uint32_t shardTableFindEmpty(const SShardTable *pTable, uint32_t hashVal) {
+  uint32_t pos = hashVal & pTable->mask;
+  while (pTable->hashes[pos] != 0) {
+    pos = (pos + 1) & pTable->mask;
+  }
+
+  return pos;
+}
+
+/**
+ * move the entries of the shard to slots twice as many. The new slots are not seen by any reader until they are
+ * filled, and the old ones are not changed anymore, so the readers need not retry for the growth itself.
+ */
+static int32_t shardGrow(const SShardHash *pHash, SHashShard *pShard) {
+  SShardTable *pOld = pShard->pTable;
+  if (pOld->mask + 1 >= SHARD_HASH_MAX_CAPACITY) {
+    uError("sharded hash table reaches the max capacity:%u of a shard", SHARD_HASH_MAX_CAPACITY);
+    return -1;
+  }
+
+  SShardTable *pNew = shardTableCreate(pHash, (pOld->mask + 1) << 1u);
+  if (pNew == NULL) {
+    uError("failed to grow the sharded hash table, reason:%s", strerror(errno));
+    return -1;
+  }
+
+  for (uint32_t i = 0; i <= pOld->mask; ++i) {
+    uint32_t h = pOld->hashes[i];
+    if (h == 0) continue;
+
+    uint32_t pos = shardTableFindEmpty(pNew, h);
+    pNew->hashes[pos] = h;
+    memcpy(GET_SHARD_SLOT(pHash, pNew, pos), GET_SHARD_SLOT(pHash, pOld, i), pHash->slotSize);
+  }
+
+  pNew->retired = pOld;
+  atomic_store_ptr(&pShard->pTable, pNew);
+  return 0;
+}
+
+/**
+ * empty the slot and shift the entries after it back, so that no tombstone is left and a probe always stops at the
+ * first empty slot
+ */
+static void shardTableRemove(const SShardHash *pHash, SShardTable *pTable, uint32_t pos) {
+  uint32_t i = pos;
+  uint32_t j = pos;
+
+  while (1) {
+    j = (j + 1) & pTable->mask;
+
+    uint32_t h = pTable->hashes[j];
+    if (h == 0) {
+      break;
+    }
+
+    // the entry stays if its home slot is cyclically in (i, j]
+    uint32_t k = h & pTable->mask;
+    if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j)) {
+      continue;
+    }
+
+    pTable->hashes[i] = h;
+    memcpy(GET_SHARD_SLOT(pHash, pTable, i), GET_SHARD_SLOT(pHash, pTable, j), pHash->slotSize);
+    i = j;
+  }
+
+  pTable->hashes[i] = 0;
+}
+
+SShardHash *taosShardHashInit(size_t capacity, _hash_fn_t fn, uint32_t keySize, uint32_t dataSize, int32_t numOfShards) {
+  if (fn == NULL || keySize == 0) {
+    uError("sharded hash table must have a valid hash function and key size");
+    return NULL;
+  }
+
+  int32_t n = 1;
+  while (n < numOfShards && n < SHARD_HASH_MAX_SHARDS) n = (n << 1u);
+
+  SShardHash *pHash = calloc(1, sizeof(SShardHash));
+  if (pHash == NULL) {
+    uError("failed to allocate memory, reason:%s", strerror(errno));
+    return NULL;
+  }
+
+  pHash->hashFp = fn;
+  pHash->keySize = keySize;
+  pHash->dataSize = dataSize;
+  pHash->slotSize = ALIGN8(sizeof(uint32_t) + keySize + dataSize);
+  pHash->numOfShards = n;
+
+  pHash->pMem = calloc(n + 1, sizeof(SHashShardLine));
+  if (pHash->pMem == NULL) {
+    uError("failed to allocate memory, reason:%s", strerror(errno));
+    free(pHash);
+    return NULL;
+  }
+
+  pHash->shards = (SHashShardLine *)ALIGN_NUM((uintptr_t)pHash->pMem, SHARD_HASH_CACHE_LINE);
+
+  // the initial capacity is given in entries, the slots are kept no more than 3/4 used
+  uint32_t slots = shardCapacity(capacity * 4 / 3 / n + 1);
+  for (int32_t i = 0; i < n; ++i) {
+    SHashShard *pShard = &pHash->shards[i].shard;
+    taosInitRWLatch(&pShard->latch);
+
+    pShard->pTable = shardTableCreate(pHash, slots);
+    if (pShard->pTable == NULL) {
+      uError("failed to allocate memory, reason:%s", strerror(errno));
+      taosShardHashCleanup(pHash);
+      return NULL;
+    }
+  }
+
+  return pHash;
+}
+
+int32_t taosShardHashPut(SShardHash *pHash, const void *key, size_t keyLen, const void *data) {
+  if (pHash == NULL || key == NULL || keyLen == 0 || keyLen > pHash->keySize) {
+    return -1;
+  }
+
+  uint32_t    hashVal = shardHashVal(pHash, key, keyLen);
+  SHashShard *pShard = shardOfHashVal(pHash, hashVal);
+
+  taosWLockLatch(&pShard->latch);
+
+  int32_t pos = shardTableFind(pHash, pShard->pTable, hashVal, key, (uint32_t)keyLen);
+  if (pos < 0 && SHARD_NEED_GROW(pShard) && shardGrow(pHash, pShard) != 0) {
+    taosWUnLockLatch(&pShard->latch);
+    return -1;
+  }
+
+  SShardTable *pTable = pShard->pTable;
+
+  atomic_add_fetch_32(&pShard->seq, 1);
+
+  if (pos < 0) {
+    pos = (int32_t)shardTableFindEmpty(pTable, hashVal);
+
+    char *pSlot = GET_SHARD_SLOT(pHash, pTable, pos);
+    *(uint32_t *)pSlot = (uint32_t)keyLen;
+    memcpy(GET_SLOT_KEY(pSlot), key, keyLen);
+    pTable->hashes[pos] = hashVal;
+    pShard->size++;
+  }
+
+  memcpy(GET_SLOT_DATA(pHash, GET_SHARD_SLOT(pHash, pTable, pos)), data, pHash->dataSize);
+
+  atomic_add_fetch_32(&pShard->seq, 1);
+
+  taosWUnLockLatch(&pShard->latch);
+  return 0;
+}
+
+int32_t taosShardHashGet(SShardHash *pHash, const void *key, size_t keyLen, void *data) {
+  if (pHash == NULL || key == NULL || keyLen == 0 || keyLen > pHash->keySize) {
+    return -1;
+  }
+
+  uint32_t    hashVal = shardHashVal(pHash, key, keyLen);
+  SHashShard *pShard = shardOfHashVal(pHash, hashVal);
+  int32_t     nLoops = 0;
+
+  while (1) {
+    int32_t seq = atomic_load_32(&pShard->seq);
+    if (seq & 1) {
+      if (++nLoops > 1000) {
+        sched_yield();
+        nLoops = 0;
+      }
+      continue;
+    }
+
+    SShardTable *pTable = atomic_load_ptr(&pShard->pTable);
+
+    int32_t pos = shardTableFind(pHash, pTable, hashVal, key, (uint32_t)keyLen);
+    if (pos >= 0 && data != NULL) {
+      memcpy(data, GET_SLOT_DATA(pHash, GET_SHARD_SLOT(pHash, pTable, pos)), pHash->dataSize);
+    }
+
+    // what is read above may be changed by a writer meanwhile, then it is read again
+    atomic_load_barrier();
+    if (atomic_load_32(&pShard->seq) == seq) {
+      return (pos >= 0) ? 0 : -1;
+    }
+  }
+}
+
+int32_t taosShardHashRemove(SShardHash *pHash, const void *key, size_t keyLen) {
+  if (pHash == NULL || key == NULL || keyLen == 0 || keyLen > pHash->keySize) {
+    return -1;
+  }
+
+  uint32_t    hashVal = shardHashVal(pHash, key, keyLen);
+  SHashShard *pShard = shardOfHashVal(pHash, hashVal);
+
+  taosWLockLatch(&pShard->latch);
+
+  int32_t pos = shardTableFind(pHash, pShard->pTable, hashVal, key, (uint32_t)keyLen);
+  if (pos >= 0) {
+    atomic_add_fetch_32(&pShard->seq, 1);
+    shardTableRemove(pHash, pShard->pTable, pos);
+    pShard->size--;
+    atomic_add_fetch_32(&pShard->seq, 1);
+  }
+
+  taosWUnLockLatch(&pShard->latch);
+  return (pos >= 0) ? 0 : -1;
+}
+
+int32_t taosShardHashGetSize(const SShardHash *pHash) {
+  if (pHash == NULL) {
+    return 0;
+  }
+
+  int32_t size = 0;
+  for (int32_t i = 0; i < pHash->numOfShards; ++i) {
+    size += atomic_load_32(&pHash->shards[i].shard.size);
+  }
+
+  return size;
+}
+
+size_t taosShardHashGetMemSize(const SShardHash *pHash) {
+  if (pHash == NULL) {
+    return 0;
+  }
+
+  size_t size = sizeof(SShardHash) + (pHash->numOfShards + 1) * sizeof(SHashShardLine);
+  for (int32_t i = 0; i < pHash->numOfShards; ++i) {
+    for (SShardTable *pTable = pHash->shards[i].shard.pTable; pTable != NULL; pTable = pTable->retired) {
+      size += shardTableMemSize(pHash, pTable);
+    }
+  }
+
+  return size;
+}
+
+void taosShardHashCleanup(SShardHash *pHash) {
+  if (pHash == NULL) {
+    return;
+  }
+
+  for (int32_t i = 0; i < pHash->numOfShards; ++i) {
+    SShardTable *pTable = pHash->shards[i].shard.pTable;
+    while (pTable != NULL) {
+      SShardTable *pRetired = pTable->retired;
+      free(pTable);
+      pTable = pRetired;
+    }
+  }
+
+  free(pHash->pMem);
+  free(pHash);
+}
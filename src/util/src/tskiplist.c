@@ -20,6 +20,18 @@
 #include "tulog.h"
 #include "tutil.h"
 
+// the nodes are allocated from memory chunks, if they are only freed along with the skip list
+#define SL_NODES_IN_CHUNK(s)    (SL_DUP_MODE(s) != SL_ALLOW_DUP_KEY)
+#define SL_NODE_CHUNK_MIN_SIZE  512
+#define SL_NODE_CHUNK_MAX_SIZE  (64 * 1024)
+
+typedef struct SSkipListNodeChunk {
+  struct SSkipListNodeChunk *prev;
+  int32_t                    size;
+  int32_t                    used;
+  char                       data[];
+} SSkipListNodeChunk;
+
 static int                initForwardBackwardPtr(SSkipList *pSkipList);
 static SSkipListNode *    getPriorNode(SSkipList *pSkipList, const char *val, int32_t order, SSkipListNode **pCur);
 static void               tSkipListRemoveNodeImpl(SSkipList *pSkipList, SSkipListNode *pNode);
@@ -28,9 +40,11 @@ static SSkipListIterator *doCreateSkipListIterator(SSkipList *pSkipList, int32_t
 static void tSkipListDoInsert(SSkipList *pSkipList, SSkipListNode **direction, SSkipListNode *pNode, bool isForward);
 static bool tSkipListGetPosToPut(SSkipList *pSkipList, SSkipListNode **backward, void *pData);
 static SSkipListNode *tSkipListNewNode(uint8_t level);
+static SSkipListNode *tSkipListAllocNode(SSkipList *pSkipList, uint8_t level);
 #define tSkipListFreeNode(n) tfree((n))
 static SSkipListNode *tSkipListPutImpl(SSkipList *pSkipList, void *pData, SSkipListNode **direction, bool isForward,
                                        bool hasDup);
+static void tSkipListAppendBatch(SSkipList *pSkipList, void *pData, void *iter, iter_next_fn_t iterate);
 
 
 static FORCE_INLINE int     tSkipListWLock(SSkipList *pSkipList);
@@ -92,12 +106,21 @@ void tSkipListDestroy(SSkipList *pSkipList) {
 
   tSkipListWLock(pSkipList);
 
-  SSkipListNode *pNode = SL_NODE_GET_FORWARD_POINTER(pSkipList->pHead, 0);
+  if (SL_NODES_IN_CHUNK(pSkipList)) {
+    SSkipListNodeChunk *pChunk = pSkipList->pNodeChunk;
+    while (pChunk != NULL) {
+      SSkipListNodeChunk *pTemp = pChunk;
+      pChunk = pChunk->prev;
+      free(pTemp);
+    }
+  } else {
+    SSkipListNode *pNode = SL_NODE_GET_FORWARD_POINTER(pSkipList->pHead, 0);
 
-  while (pNode != pSkipList->pTail) {
-    SSkipListNode *pTemp = pNode;
-    pNode = SL_NODE_GET_FORWARD_POINTER(pNode, 0);
-    tSkipListFreeNode(pTemp);
+    while (pNode != pSkipList->pTail) {
+      SSkipListNode *pTemp = pNode;
+      pNode = SL_NODE_GET_FORWARD_POINTER(pNode, 0);
+      tSkipListFreeNode(pTemp);
+    }
   }
 
   tfree(pSkipList->insertHandleFn);
@@ -140,7 +163,17 @@ void tSkipListPutBatchByIter(SSkipList *pSkipList, void *iter, iter_next_fn_t it
   tSkipListWLock(pSkipList);
 
   void* pData = iterate(iter);
-  if(pData == NULL) return;
+  if(pData == NULL) {
+    tSkipListUnlock(pSkipList);
+    return;
+  }
+
+  // the most common case: the whole batch is newer than the data in skip list
+  if (pSkipList->size == 0 || pSkipList->comparFn(pSkipList->keyFn(pData), SL_GET_MAX_KEY(pSkipList)) > 0) {
+    tSkipListAppendBatch(pSkipList, pData, iter, iterate);
+    tSkipListUnlock(pSkipList);
+    return;
+  }
 
   // backward to put the first data
   hasDup = tSkipListGetPosToPut(pSkipList, backward, pData);
@@ -159,9 +192,9 @@ void tSkipListPutBatchByIter(SSkipList *pSkipList, void *iter, iter_next_fn_t it
     pKey = SL_GET_MAX_KEY(pSkipList);
     compare = pSkipList->comparFn(pDataKey, pKey);
     if (compare > 0) {
-      for (int i = 0; i < pSkipList->maxLevel; i++) {
-        forward[i] = SL_NODE_GET_BACKWARD_POINTER(pSkipList->pTail, i);
-      }
+      // the rest of the batch is beyond the max key
+      tSkipListAppendBatch(pSkipList, pData, iter, iterate);
+      break;
     } else if(compare == 0) {
       // same need special deal
       forward[0] = SL_NODE_GET_BACKWARD_POINTER(SL_NODE_GET_BACKWARD_POINTER(pSkipList->pTail,0),0);
@@ -426,6 +459,42 @@ static void tSkipListDoInsert(SSkipList *pSkipList, SSkipListNode **direction, S
   pSkipList->size += 1;
 }
 
+/*
+ * The data of a batch are in ascending order, so once the key of a data is beyond the max key, the rest of the batch
+ * are linked after the last node of each level one by one, without searching the position from the tail again.
+ * A data not beyond the previous one is still put in the normal way.
+ */
+static void tSkipListAppendBatch(SSkipList *pSkipList, void *pData, void *iter, iter_next_fn_t iterate) {
+  SSkipListNode *last[MAX_SKIP_LIST_LEVEL] = {0};
+  SSkipListNode *backward[MAX_SKIP_LIST_LEVEL] = {0};
+  char *         pMaxKey = NULL;
+
+  for (int32_t i = 0; i < pSkipList->maxLevel; ++i) {
+    last[i] = SL_NODE_GET_BACKWARD_POINTER(pSkipList->pTail, i);
+  }
+
+  do {
+    if (pMaxKey != NULL && pSkipList->comparFn(pSkipList->keyFn(pData), pMaxKey) <= 0) {
+      bool hasDup = tSkipListGetPosToPut(pSkipList, backward, pData);
+      tSkipListPutImpl(pSkipList, pData, backward, false, hasDup);
+
+      for (int32_t i = 0; i < pSkipList->maxLevel; ++i) {
+        last[i] = SL_NODE_GET_BACKWARD_POINTER(pSkipList->pTail, i);
+      }
+      pMaxKey = SL_GET_MAX_KEY(pSkipList);
+      continue;
+    }
+
+    SSkipListNode *pNode = tSkipListPutImpl(pSkipList, pData, last, true, false);
+    if (pNode != NULL) {
+      for (int32_t i = 0; i < pNode->level; ++i) {
+        last[i] = pNode;
+      }
+      pMaxKey = SL_GET_NODE_KEY(pSkipList, pNode);
+    }
+  } while ((pData = iterate(iter)) != NULL);
+}
+
 static SSkipListIterator *doCreateSkipListIterator(SSkipList *pSkipList, int32_t order) {
   SSkipListIterator *iter = calloc(1, sizeof(SSkipListIterator));
 
@@ -535,7 +604,9 @@ static void tSkipListRemoveNodeImpl(SSkipList *pSkipList, SSkipListNode *pNode)
     SL_NODE_GET_BACKWARD_POINTER(next, j) = prev;
   }
 
-  tSkipListFreeNode(pNode);
+  if (!SL_NODES_IN_CHUNK(pSkipList)) {
+    tSkipListFreeNode(pNode);
+  }
   pSkipList->size--;
 }
 
@@ -677,6 +748,35 @@ static SSkipListNode *tSkipListNewNode(uint8_t level) {
   return pNode;
 }
 
+static SSkipListNode *tSkipListAllocNode(SSkipList *pSkipList, uint8_t level) {
+  if (!SL_NODES_IN_CHUNK(pSkipList)) {
+    return tSkipListNewNode(level);
+  }
+
+  int32_t             tsize = sizeof(SSkipListNode) + sizeof(SSkipListNode *) * level * 2;
+  SSkipListNodeChunk *pChunk = pSkipList->pNodeChunk;
+
+  // the chunk grows with the skip list, so that a small table does not take a large chunk
+  if (pChunk == NULL || pChunk->used + tsize > pChunk->size) {
+    int32_t size = (pChunk == NULL) ? SL_NODE_CHUNK_MIN_SIZE : MIN(pChunk->size * 2, SL_NODE_CHUNK_MAX_SIZE);
+
+    SSkipListNodeChunk *pNew = malloc(sizeof(SSkipListNodeChunk) + MAX(size, tsize));
+    if (pNew == NULL) return NULL;
+
+    pNew->prev = pChunk;
+    pNew->size = MAX(size, tsize);
+    pNew->used = 0;
+    pSkipList->pNodeChunk = pChunk = pNew;
+  }
+
+  SSkipListNode *pNode = (SSkipListNode *)(pChunk->data + pChunk->used);
+  pChunk->used += tsize;
+
+  pNode->level = level;
+  pNode->pData = NULL;
+  return pNode;
+}
+
 static SSkipListNode *tSkipListPutImpl(SSkipList *pSkipList, void *pData, SSkipListNode **direction, bool isForward,
                                        bool hasDup) {
   uint8_t        dupMode = SL_DUP_MODE(pSkipList);
@@ -706,7 +806,7 @@ static SSkipListNode *tSkipListPutImpl(SSkipList *pSkipList, void *pData, SSkipL
       }
     }
   } else {
-    pNode = tSkipListNewNode(getSkipListRandLevel(pSkipList));
+    pNode = tSkipListAllocNode(pSkipList, getSkipListRandLevel(pSkipList));
     if (pNode != NULL) {
       // insertHandleFn will be assigned only for timeseries data,
       // in which case, pData is pointed to an memory to be freed later;
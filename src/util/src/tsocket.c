@@ -450,7 +450,7 @@ int32_t taosKeepTcpAlive(SOCKET sockFd) {
   return 0;
 }
 
-SOCKET taosOpenTcpServerSocket(uint32_t ip, uint16_t port) {
+static SOCKET taosOpenTcpListenSocket(uint32_t ip, uint16_t port, bool reusePort) {
   struct sockaddr_in serverAdd;
   SOCKET             sockFd;
   int32_t            reuse;
@@ -476,6 +476,21 @@ SOCKET taosOpenTcpServerSocket(uint32_t ip, uint16_t port) {
     return -1;
   }
 
+  if (reusePort) {
+#ifdef SO_REUSEPORT
+    /* several sockets listen on the same port, the kernel spreads the connections among them */
+    if (taosSetSockOpt(sockFd, SOL_SOCKET, SO_REUSEPORT, (void *)&reuse, sizeof(reuse)) < 0) {
+      uError("setsockopt SO_REUSEPORT failed: %d (%s)", errno, strerror(errno));
+      taosCloseSocket(sockFd);
+      return -1;
+    }
+#else
+    uError("SO_REUSEPORT is not supported");
+    taosCloseSocket(sockFd);
+    return -1;
+#endif
+  }
+
   /* bind socket to server address */
   if (bind(sockFd, (struct sockaddr *)&serverAdd, sizeof(serverAdd)) < 0) {
     uError("bind tcp server socket failed, 0x%x:%hu(%s)", ip, port, strerror(errno));
@@ -498,6 +513,10 @@ SOCKET taosOpenTcpServerSocket(uint32_t ip, uint16_t port) {
   return sockFd;
 }
 
+SOCKET taosOpenTcpServerSocket(uint32_t ip, uint16_t port) { return taosOpenTcpListenSocket(ip, port, false); }
+
+SOCKET taosOpenTcpReusePortSocket(uint32_t ip, uint16_t port) { return taosOpenTcpListenSocket(ip, port, true); }
+
 void tinet_ntoa(char *ipstr, uint32_t ip) {
   sprintf(ipstr, "%d.%d.%d.%d", ip & 0xFF, (ip >> 8) & 0xFF, (ip >> 16) & 0xFF, ip >> 24);
 }
@@ -20,7 +20,7 @@
 #include "tworker.h"
 
 int32_t tWorkerInit(SWorkerPool *pPool) {
-  pPool->qset = taosOpenQset();
+  pPool->qset = pPool->stealing ? taosOpenWorkerQset(pPool->max) : taosOpenQset();
   pPool->worker = calloc(sizeof(SWorker), pPool->max);
   pthread_mutex_init(&pPool->mutex, NULL);
   for (int i = 0; i < pPool->max; ++i) {
@@ -48,11 +48,15 @@ void tWorkerCleanup(SWorkerPool *pPool) {
     }
   }
 
+  SQsetStat stat;
+  taosGetQsetStat(pPool->qset, &stat);
+
   free(pPool->worker);
   taosCloseQset(pPool->qset);
   pthread_mutex_destroy(&pPool->mutex);
 
-  uInfo("worker:%s is closed", pPool->name);
+  uInfo("worker:%s is closed, reads:%" PRId64 " steals:%" PRId64 " contentions:%" PRId64, pPool->name, stat.numOfReads,
+        stat.numOfSteals, stat.numOfContentions);
 }
 
 void *tWorkerAllocQueue(SWorkerPool *pPool, void *ahandle) {
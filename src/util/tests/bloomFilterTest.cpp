@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "tbloomfilter.h"
+
+TEST(testCase, bloom_filter_size) {
+  ASSERT_EQ(taosBloomFilterBytes(0, 10), 0);
+  ASSERT_EQ(taosBloomFilterBytes(4096, 0), 0);
+  ASSERT_EQ(taosBloomFilterBytes(1, 1), 8);
+  ASSERT_EQ(taosBloomFilterBytes(4096, 10), 5120);
+  ASSERT_EQ(taosBloomFilterBytes(INT32_MAX, 32), TSDB_BLOOM_FILTER_MAX_BYTES);
+
+  ASSERT_EQ(taosBloomFilterNumOfHash(0), 1);
+  ASSERT_EQ(taosBloomFilterNumOfHash(10), 6);
+  ASSERT_EQ(taosBloomFilterNumOfHash(32), TSDB_BLOOM_FILTER_MAX_HASH);
+}
+
+TEST(testCase, bloom_filter_int_test) {
+  const int32_t numOfElems = 4096;
+  uint32_t      nBytes = taosBloomFilterBytes(numOfElems, 10);
+  uint8_t       nHash = taosBloomFilterNumOfHash(10);
+
+  std::vector<uint8_t> bits(nBytes, 0);
+  for (int64_t i = 0; i < numOfElems; ++i) {
+    int64_t key = i * 7 + 1;
+    taosBloomFilterPut(bits.data(), nBytes, nHash, &key, sizeof(key));
+  }
+
+  // no false negative
+  for (int64_t i = 0; i < numOfElems; ++i) {
+    int64_t key = i * 7 + 1;
+    ASSERT_TRUE(taosBloomFilterMayContain(bits.data(), nBytes, nHash, &key, sizeof(key)));
+  }
+
+  // false positive rate of 10 bits per element should be around 1%
+  int32_t numOfFalsePositive = 0;
+  for (int64_t i = 0; i < numOfElems * 10; ++i) {
+    int64_t key = -i - 1;
+    if (taosBloomFilterMayContain(bits.data(), nBytes, nHash, &key, sizeof(key))) {
+      numOfFalsePositive++;
+    }
+  }
+  ASSERT_LT(numOfFalsePositive, numOfElems * 10 / 20);
+}
+
+TEST(testCase, bloom_filter_str_test) {
+  const char *keys[] = {"d1001", "d1002", "beijing", "shanghai", ""};
+  uint32_t    nBytes = taosBloomFilterBytes(5, 16);
+  uint8_t     nHash = taosBloomFilterNumOfHash(16);
+
+  std::vector<uint8_t> bits(nBytes, 0);
+  for (auto key : keys) {
+    taosBloomFilterPut(bits.data(), nBytes, nHash, key, (uint32_t)strlen(key));
+  }
+
+  for (auto key : keys) {
+    ASSERT_TRUE(taosBloomFilterMayContain(bits.data(), nBytes, nHash, key, (uint32_t)strlen(key)));
+  }
+
+  // an empty bitmap always returns true
+  ASSERT_TRUE(taosBloomFilterMayContain(NULL, 0, nHash, "d1003", 5));
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "taosdef.h"
+#include "tscompression.h"
+
+/*
+ * Report the decompression throughput (GB/s of decompressed data) of each column type, the SIMD and the scalar
+ * kernels are both measured for the integer types.
+ */
+
+#define BENCH_ROWS   4096
+#define BENCH_BLOCKS 256
+
+typedef int (*decomp_fn_t)(const char *const input, const int nelements, char *const output, const char type);
+
+static int benchDecompressTimestamp(const char *const input, const int nelements, char *const output, const char type) {
+  return tsDecompressTimestampImp(input, nelements, output);
+}
+
+static int benchDecompressFloat(const char *const input, const int nelements, char *const output, const char type) {
+  return tsDecompressFloatImp(input, nelements, output);
+}
+
+static int benchDecompressDouble(const char *const input, const int nelements, char *const output, const char type) {
+  return tsDecompressDoubleImp(input, nelements, output);
+}
+
+static void genData(char type, char *data) {
+  int64_t ts = 1600000000000L;
+  int64_t v = 0;
+
+  // slowly changing values, like the most of the metrics collected
+  for (int i = 0; i < BENCH_ROWS; ++i) {
+    v += rand() % 7 - 3;
+    switch (type) {
+      case TSDB_DATA_TYPE_TINYINT:   ((int8_t *)data)[i] = (int8_t)v; break;
+      case TSDB_DATA_TYPE_SMALLINT:  ((int16_t *)data)[i] = (int16_t)(v * 100); break;
+      case TSDB_DATA_TYPE_INT:       ((int32_t *)data)[i] = (int32_t)(v * 10000); break;
+      case TSDB_DATA_TYPE_BIGINT:    ((int64_t *)data)[i] = v * 1000000; break;
+      case TSDB_DATA_TYPE_TIMESTAMP: ((int64_t *)data)[i] = ts + i * 1000 + rand() % 3; break;
+      case TSDB_DATA_TYPE_FLOAT:     ((float *)data)[i] = 20.0f + (float)v / 10; break;
+      case TSDB_DATA_TYPE_DOUBLE:    ((double *)data)[i] = 220.0 + (double)v / 100; break;
+      default: break;
+    }
+  }
+}
+
+static int compressData(char type, const char *data, char *output) {
+  switch (type) {
+    case TSDB_DATA_TYPE_TIMESTAMP: return tsCompressTimestampImp(data, BENCH_ROWS, output);
+    case TSDB_DATA_TYPE_FLOAT:     return tsCompressFloatImp(data, BENCH_ROWS, output);
+    case TSDB_DATA_TYPE_DOUBLE:    return tsCompressDoubleImp(data, BENCH_ROWS, output);
+    default:                       return tsCompressINTImp(data, BENCH_ROWS, output, type);
+  }
+}
+
+static int typeBytes(char type) {
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT:  return sizeof(int8_t);
+    case TSDB_DATA_TYPE_SMALLINT: return sizeof(int16_t);
+    case TSDB_DATA_TYPE_INT:
+    case TSDB_DATA_TYPE_FLOAT:    return sizeof(int32_t);
+    default:                      return sizeof(int64_t);
+  }
+}
+
+static void doBench(const char *name, char type, decomp_fn_t fp, bool simd) {
+  int   bytes = BENCH_ROWS * typeBytes(type);
+  char *data = malloc(bytes);
+  char *output = malloc(bytes);
+  char *compressed = malloc((bytes + COMP_OVERFLOW_BYTES) * BENCH_BLOCKS);
+
+  for (int i = 0; i < BENCH_BLOCKS; ++i) {
+    genData(type, data);
+    compressData(type, data, compressed + (bytes + COMP_OVERFLOW_BYTES) * i);
+  }
+
+  tsDecompressSimd = simd;
+
+  // take the best of several runs to reduce the noise
+  int     rounds = 20;
+  int64_t el = INT64_MAX;
+  for (int t = 0; t < 5; ++t) {
+    int64_t st = taosGetTimestampUs();
+    for (int r = 0; r < rounds; ++r) {
+      for (int i = 0; i < BENCH_BLOCKS; ++i) {
+        (*fp)(compressed + (bytes + COMP_OVERFLOW_BYTES) * i, BENCH_ROWS, output, type);
+      }
+    }
+    el = MIN(el, taosGetTimestampUs() - st);
+  }
+
+  double gb = (double)bytes * BENCH_BLOCKS * rounds / (1024.0 * 1024 * 1024);
+  printf("%-10s %-6s %8.3f GB/s\n", name, simd ? "simd" : "scalar", gb / (el / 1000000.0));
+
+  free(data);
+  free(output);
+  free(compressed);
+}
+
+int main(int argc, char *argv[]) {
+  srand(0);
+
+  doBench("tinyint", TSDB_DATA_TYPE_TINYINT, tsDecompressINTImp, false);
+  doBench("tinyint", TSDB_DATA_TYPE_TINYINT, tsDecompressINTImp, true);
+  doBench("smallint", TSDB_DATA_TYPE_SMALLINT, tsDecompressINTImp, false);
+  doBench("smallint", TSDB_DATA_TYPE_SMALLINT, tsDecompressINTImp, true);
+  doBench("int", TSDB_DATA_TYPE_INT, tsDecompressINTImp, false);
+  doBench("int", TSDB_DATA_TYPE_INT, tsDecompressINTImp, true);
+  doBench("bigint", TSDB_DATA_TYPE_BIGINT, tsDecompressINTImp, false);
+  doBench("bigint", TSDB_DATA_TYPE_BIGINT, tsDecompressINTImp, true);
+  doBench("timestamp", TSDB_DATA_TYPE_TIMESTAMP, benchDecompressTimestamp, false);
+  doBench("float", TSDB_DATA_TYPE_FLOAT, benchDecompressFloat, false);
+  doBench("double", TSDB_DATA_TYPE_DOUBLE, benchDecompressDouble, false);
+
+  return 0;
+}
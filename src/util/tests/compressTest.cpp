@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <random>
+#include <vector>
+
+#include "taosdef.h"
+#include "tscompression.h"
+
+namespace {
+
+template <typename T>
+void doIntegerTest(char type, int64_t range) {
+  const int nelements = 4096 + 17;
+
+  std::mt19937_64                        gen(type);
+  std::uniform_int_distribution<int64_t> dist(-range, range);
+
+  std::vector<T> input(nelements);
+  int64_t        v = 0;
+  for (int i = 0; i < nelements; ++i) {
+    // mixes runs of equal values, small deltas and big jumps to cover all the selectors
+    if (i % 512 < 300) {
+      v += (i % 7 == 0) ? dist(gen) : 0;
+    } else {
+      v = dist(gen);
+    }
+    input[i] = (T)v;
+  }
+
+  int              size = nelements * sizeof(T);
+  std::vector<char> compressed(size + COMP_OVERFLOW_BYTES);
+  std::vector<T>    scalar(nelements), simd(nelements);
+
+  int clen = tsCompressINTImp((const char *)input.data(), nelements, compressed.data(), type);
+  ASSERT_GT(clen, 0);
+
+  tsDecompressSimd = false;
+  ASSERT_EQ(tsDecompressINTImp(compressed.data(), nelements, (char *)scalar.data(), type), size);
+
+  tsDecompressSimd = true;
+  ASSERT_EQ(tsDecompressINTImp(compressed.data(), nelements, (char *)simd.data(), type), size);
+
+  ASSERT_EQ(memcmp(input.data(), scalar.data(), size), 0);
+  ASSERT_EQ(memcmp(scalar.data(), simd.data(), size), 0);
+}
+
+}  // namespace
+
+TEST(testCase, compress_integer_simd_test) {
+  doIntegerTest<int8_t>(TSDB_DATA_TYPE_TINYINT, 100);
+  doIntegerTest<int16_t>(TSDB_DATA_TYPE_SMALLINT, 30000);
+  doIntegerTest<int32_t>(TSDB_DATA_TYPE_INT, 1 << 20);
+  doIntegerTest<int32_t>(TSDB_DATA_TYPE_INT, INT32_MAX);
+  doIntegerTest<int64_t>(TSDB_DATA_TYPE_BIGINT, 1000);
+  doIntegerTest<int64_t>(TSDB_DATA_TYPE_BIGINT, (int64_t)1 << 50);
+}
+
+TEST(testCase, compress_integer_few_elements_test) {
+  for (int n = 1; n < 10; ++n) {
+    std::vector<int64_t> input(n), output(n);
+    for (int i = 0; i < n; ++i) input[i] = i * 3 - 5;
+
+    std::vector<char> compressed(n * sizeof(int64_t) + COMP_OVERFLOW_BYTES);
+    tsCompressINTImp((const char *)input.data(), n, compressed.data(), TSDB_DATA_TYPE_BIGINT);
+    tsDecompressINTImp(compressed.data(), n, (char *)output.data(), TSDB_DATA_TYPE_BIGINT);
+    ASSERT_EQ(input, output);
+  }
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "taosdef.h"
+#include "hash.h"
+#include "tshardhash.h"
+
+/*
+ * Report the lookups/sec and the memory per entry of SHashObj with entry lock and SShardHash, with uint64_t keys and
+ * data as the uid map of tsdb. Several threads look the keys up, while one more thread puts and removes the keys
+ * beyond them.
+ *
+ * usage: hashBench [keys] [lookups per thread] [max threads]
+ */
+
+#define BENCH_MAX_THREADS 64
+
+typedef struct {
+  SHashObj   *pHashObj;
+  SShardHash *pShardHash;
+  int64_t     numOfKeys;
+  int64_t     numOfLookups;
+  int64_t     missed;
+  int32_t     seed;
+  bool        writer;  // the writer puts and removes the keys beyond the ones looked up
+  int32_t    *stop;
+} SBenchCtx;
+
+static void *benchLookupFp(void *param) {
+  SBenchCtx *pCtx = (SBenchCtx *)param;
+  uint64_t   x = pCtx->seed;
+
+  if (pCtx->writer) {
+    for (int64_t i = 0; atomic_load_32(pCtx->stop) == 0; ++i) {
+      uint64_t key = pCtx->numOfKeys + (i % 1024);
+      if (pCtx->pShardHash != NULL) {
+        taosShardHashPut(pCtx->pShardHash, &key, sizeof(key), &key);
+        taosShardHashRemove(pCtx->pShardHash, &key, sizeof(key));
+      } else {
+        taosHashPut(pCtx->pHashObj, &key, sizeof(key), &key, sizeof(key));
+        taosHashRemove(pCtx->pHashObj, &key, sizeof(key));
+      }
+    }
+
+    return NULL;
+  }
+
+  for (int64_t i = 0; i < pCtx->numOfLookups; ++i) {
+    x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    uint64_t key = (x >> 16u) % pCtx->numOfKeys;
+    uint64_t v = 0;
+
+    if (pCtx->pShardHash != NULL) {
+      if (taosShardHashGet(pCtx->pShardHash, &key, sizeof(key), &v) != 0 || v != key) pCtx->missed++;
+    } else {
+      uint64_t *p = (uint64_t *)taosHashGet(pCtx->pHashObj, &key, sizeof(key));
+      if (p == NULL || *p != key) pCtx->missed++;
+    }
+  }
+
+  return NULL;
+}
+
+static double doBench(SHashObj *pHashObj, SShardHash *pShardHash, int64_t numOfKeys, int32_t numOfThreads,
+                      int64_t numOfLookups, int64_t *missed) {
+  int32_t   stop = 0;
+  SBenchCtx ctx[BENCH_MAX_THREADS + 1] = {{0}};
+  pthread_t threads[BENCH_MAX_THREADS + 1];
+
+  for (int32_t i = 0; i <= numOfThreads; ++i) {
+    ctx[i].pHashObj = pHashObj;
+    ctx[i].pShardHash = pShardHash;
+    ctx[i].numOfKeys = numOfKeys;
+    ctx[i].numOfLookups = numOfLookups;
+    ctx[i].seed = i + 1;
+    ctx[i].writer = (i == numOfThreads);
+    ctx[i].stop = &stop;
+  }
+
+  pthread_create(&threads[numOfThreads], NULL, benchLookupFp, &ctx[numOfThreads]);
+
+  int64_t st = taosGetTimestampUs();
+  for (int32_t i = 0; i < numOfThreads; ++i) {
+    pthread_create(&threads[i], NULL, benchLookupFp, &ctx[i]);
+  }
+
+  for (int32_t i = 0; i < numOfThreads; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  int64_t et = taosGetTimestampUs();
+  atomic_store_32(&stop, 1);
+  pthread_join(threads[numOfThreads], NULL);
+
+  for (int32_t i = 0; i < numOfThreads; ++i) {
+    *missed += ctx[i].missed;
+  }
+
+  return numOfLookups * numOfThreads / ((et - st) / 1000000.0);
+}
+
+int main(int argc, char *argv[]) {
+  int64_t numOfKeys = (argc > 1) ? atoll(argv[1]) : 1000000;
+  int64_t numOfLookups = (argc > 2) ? atoll(argv[2]) : 1000000;
+  int32_t maxThreads = (argc > 3) ? atoi(argv[3]) : 8;
+
+  if (numOfKeys <= 0 || numOfLookups <= 0 || maxThreads <= 0 || maxThreads > BENCH_MAX_THREADS) {
+    printf("usage: %s [keys] [lookups per thread] [max threads, up to %d]\n", argv[0], BENCH_MAX_THREADS);
+    return 1;
+  }
+
+  SHashObj   *pHashObj = taosHashInit(numOfKeys, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT), true, HASH_ENTRY_LOCK);
+  SShardHash *pShardHash = taosShardHashInit(numOfKeys, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT),
+                                             sizeof(uint64_t), sizeof(uint64_t), 16);
+
+  for (uint64_t i = 0; i < (uint64_t)numOfKeys; ++i) {
+    taosHashPut(pHashObj, &i, sizeof(i), &i, sizeof(i));
+    taosShardHashPut(pShardHash, &i, sizeof(i), &i);
+  }
+
+  if (taosHashGetSize(pHashObj) != numOfKeys || taosShardHashGetSize(pShardHash) != numOfKeys) {
+    printf("failed to put %" PRId64 " keys\n", numOfKeys);
+    return 1;
+  }
+
+  // the nodes of SHashObj are counted without their key and data
+  printf("keys:%" PRId64 ", lookups per thread:%" PRId64 "\n", numOfKeys, numOfLookups);
+  printf("memory per entry, hash:%.1f bytes, shard hash:%.1f bytes\n", taosHashGetMemSize(pHashObj) / (double)numOfKeys,
+         taosShardHashGetMemSize(pShardHash) / (double)numOfKeys);
+
+  for (int32_t n = 1; n <= maxThreads; n *= 2) {
+    int64_t missed = 0;
+    double  v1 = doBench(pHashObj, NULL, numOfKeys, n, numOfLookups, &missed);
+    double  v2 = doBench(NULL, pShardHash, numOfKeys, n, numOfLookups, &missed);
+    if (missed > 0) {
+      printf("threads:%d, %" PRId64 " keys are not found\n", n, missed);
+      return 1;
+    }
+
+    printf("threads:%d, lookups/sec, hash:%.0f, shard hash:%.0f\n", n, v1, v2);
+  }
+
+  taosHashCleanup(pHashObj);
+  taosShardHashCleanup(pShardHash);
+  return 0;
+}
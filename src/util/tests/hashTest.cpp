@@ -5,6 +5,7 @@
 #include <iostream>
 
 #include "hash.h"
+#include "tshardhash.h"
 #include "taos.h"
 
 namespace {
@@ -132,8 +133,74 @@ void noLockPerformanceTest() {
   taosHashCleanup(hashTable);
 }
 
-void multithreadsTest() {
-  //todo
+void shardHashTest() {
+  SShardHash* hashTable = taosShardHashInit(4, taosGetDefaultHashFunction(TSDB_DATA_TYPE_INT), sizeof(int32_t), sizeof(int64_t), 4);
+  ASSERT_EQ(taosShardHashGetSize(hashTable), 0);
+
+  // the shards grow from 8 slots
+  for(int32_t i = -2000; i < 2000; ++i) {
+    int64_t v = i * 10;
+    ASSERT_EQ(taosShardHashPut(hashTable, &i, sizeof(int32_t), &v), 0);
+  }
+
+  ASSERT_EQ(taosShardHashGetSize(hashTable), 4000);
+
+  // update in place
+  for(int32_t i = 0; i < 2000; ++i) {
+    int64_t v = i;
+    ASSERT_EQ(taosShardHashPut(hashTable, &i, sizeof(int32_t), &v), 0);
+  }
+
+  ASSERT_EQ(taosShardHashGetSize(hashTable), 4000);
+
+  for(int32_t i = -2000; i < 2000; ++i) {
+    int64_t v = 0;
+    ASSERT_EQ(taosShardHashGet(hashTable, &i, sizeof(int32_t), &v), 0);
+    ASSERT_EQ(v, (i < 0)? i * 10 : i);
+  }
+
+  // the entries after the removed ones are still found
+  for(int32_t i = -2000; i < 2000; i += 3) {
+    ASSERT_EQ(taosShardHashRemove(hashTable, &i, sizeof(int32_t)), 0);
+    ASSERT_EQ(taosShardHashRemove(hashTable, &i, sizeof(int32_t)), -1);
+  }
+
+  for(int32_t i = -2000; i < 2000; ++i) {
+    int32_t code = taosShardHashGet(hashTable, &i, sizeof(int32_t), NULL);
+    ASSERT_EQ(code, ((i + 2000) % 3 == 0)? -1 : 0);
+  }
+
+  ASSERT_EQ(taosShardHashGetSize(hashTable), 2666);
+  taosShardHashCleanup(hashTable);
+}
+
+void shardHashStringKeyTest() {
+  SShardHash* hashTable = taosShardHashInit(64, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), 32, sizeof(int32_t), 1);
+
+  char key[128] = {0};
+  for(int32_t i = 0; i < 1000; ++i) {
+    int32_t len = sprintf(key, "%d_1_%dabcefg_", i, i + 10);
+    ASSERT_EQ(taosShardHashPut(hashTable, key, len, &i), 0);
+  }
+
+  // keys being the prefix of others are not mixed up
+  ASSERT_EQ(taosShardHashGet(hashTable, "1_1_11abcefg", 12, NULL), -1);
+
+  for(int32_t i = 0; i < 1000; ++i) {
+    int32_t len = sprintf(key, "%d_1_%dabcefg_", i, i + 10);
+    int32_t v = -1;
+    ASSERT_EQ(taosShardHashGet(hashTable, key, len, &v), 0);
+    ASSERT_EQ(v, i);
+  }
+
+  // the key longer than the key size is rejected
+  memset(key, 'a', 33);
+  int32_t v = 0;
+  ASSERT_EQ(taosShardHashPut(hashTable, key, 33, &v), -1);
+  ASSERT_EQ(taosShardHashGet(hashTable, key, 33, &v), -1);
+
+  ASSERT_EQ(taosShardHashGetSize(hashTable), 1000);
+  taosShardHashCleanup(hashTable);
 }
 
 // check the function robustness
@@ -152,5 +219,9 @@ TEST(testCase, hashTest) {
   simpleTest();
   stringKeyTest();
   noLockPerformanceTest();
-  multithreadsTest();
+}
+
+TEST(testCase, shardHashTest) {
+  shardHashTest();
+  shardHashStringKeyTest();
 }
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "os.h"
+#include "tmempool.h"
+
+namespace {
+
+static void arena_alloc_test(bool useMalloc) {
+  SMemArena* pArena = taosArenaInit(1024, useMalloc);
+  ASSERT_TRUE(pArena != NULL);
+  EXPECT_EQ(taosArenaGetMemSize(pArena), 0);
+
+  char* pieces[100] = {0};
+  for (int32_t i = 0; i < 100; ++i) {
+    pieces[i] = (char*)taosArenaMalloc(pArena, i + 1);
+    ASSERT_TRUE(pieces[i] != NULL);
+    EXPECT_EQ((uintptr_t)pieces[i] % 8, 0);
+    memset(pieces[i], i, i + 1);
+  }
+
+  // the pieces do not overlap
+  for (int32_t i = 0; i < 100; ++i) {
+    for (int32_t j = 0; j <= i; ++j) {
+      EXPECT_EQ(pieces[i][j], (char)i);
+    }
+  }
+
+  int64_t* p = (int64_t*)taosArenaCalloc(pArena, 16, sizeof(int64_t));
+  ASSERT_TRUE(p != NULL);
+  for (int32_t i = 0; i < 16; ++i) {
+    EXPECT_EQ(p[i], 0);
+  }
+
+  size_t size = taosArenaGetMemSize(pArena);
+  EXPECT_GT(size, 100 * 101 / 2 + 16 * sizeof(int64_t));
+
+  for (int32_t i = 0; i < 100; i += 2) {
+    taosArenaFree(pieces[i]);
+  }
+  taosArenaFree(NULL);
+
+  // the pieces freed go back to the heap only if malloc'ed on their own
+  if (useMalloc) {
+    EXPECT_LT(taosArenaGetMemSize(pArena), size);
+  } else {
+    EXPECT_EQ(taosArenaGetMemSize(pArena), size);
+  }
+
+  // the remaining pieces are released with the arena
+  taosArenaDestroy(pArena);
+}
+
+}  // namespace
+
+TEST(testCase, arenaAllocTest) {
+  arena_alloc_test(false);
+  arena_alloc_test(true);
+}
+
+TEST(testCase, arenaLargePieceTest) {
+  SMemArena* pArena = taosArenaInit(1024, false);
+  ASSERT_TRUE(pArena != NULL);
+
+  char* small1 = (char*)taosArenaMalloc(pArena, 16);
+  size_t size = taosArenaGetMemSize(pArena);
+
+  // a piece larger than a quarter of the block has a block of its own, and the current block is still carved
+  char* large = (char*)taosArenaMalloc(pArena, 4096);
+  ASSERT_TRUE(large != NULL);
+  memset(large, 1, 4096);
+  EXPECT_GE(taosArenaGetMemSize(pArena), size + 4096);
+
+  size = taosArenaGetMemSize(pArena);
+  char* small2 = (char*)taosArenaMalloc(pArena, 16);
+  EXPECT_EQ(taosArenaGetMemSize(pArena), size);
+  EXPECT_GT(small2, small1);
+  EXPECT_LT(small2 - small1, 1024);
+
+  taosArenaDestroy(pArena);
+}
+
+TEST(testCase, arenaNullTest) {
+  // no arena, the pieces are malloc'ed on their own
+  char* p = (char*)taosArenaCalloc(NULL, 4, 32);
+  ASSERT_TRUE(p != NULL);
+  for (int32_t i = 0; i < 128; ++i) {
+    EXPECT_EQ(p[i], 0);
+  }
+
+  taosArenaFree(p);
+  EXPECT_EQ(taosArenaGetMemSize(NULL), 0);
+  taosArenaDestroy(NULL);
+}
@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "tqueue.h"
+
+/*
+ * Report the items/sec of the worker pools reading the vnode queues under a skewed load: half of the items go to
+ * 1/16 of the queues. The pools are set up the way the dnode does:
+ *   bound:    each queue is bound to the qset of one worker, the worker drains a queue at a time, as vwrite did
+ *   shared:   all workers read one item at a time from a shared qset, as vquery/vfetch did
+ *   steal:    the worker qset, the worker drains a queue at a time, as vwrite does
+ *   steal-1:  the worker qset, the workers read one item at a time, as vquery/vfetch do
+ *
+ * usage: queueBench [queues] [workers] [items] [loops per item]
+ */
+
+#define BENCH_PRODUCERS 2
+
+typedef enum { BENCH_BOUND, BENCH_SHARED, BENCH_STEAL, BENCH_STEAL_ONE, BENCH_MAX } EBenchMode;
+
+static const char *benchModeName[BENCH_MAX] = {"bound", "shared", "steal", "steal-1"};
+
+typedef struct {
+  int32_t queue;
+  int64_t seq;
+} SBenchItem;
+
+typedef struct {
+  taos_queue queue;
+  int64_t    written;   // sequence of the next item written
+  int64_t    expected;  // sequence of the next item processed, only checked if the queue is drained by one worker
+  int32_t    disorder;
+} SBenchQueue;
+
+typedef struct {
+  EBenchMode   mode;
+  int32_t      numOfQueues;
+  int32_t      numOfWorkers;
+  int64_t      numOfItems;
+  int32_t      loops;
+  SBenchQueue *queues;
+  taos_qset   *qsets;  // one for each worker in the bound mode
+  int64_t      processed;
+  pthread_mutex_t mutex;  // for writing the queues in order
+} SBenchPool;
+
+typedef struct {
+  SBenchPool *pPool;
+  int32_t     id;
+  pthread_t   thread;
+} SBenchThread;
+
+static int64_t benchWork(int32_t loops) {
+  volatile int64_t sum = 0;
+  for (int32_t i = 0; i < loops; ++i) sum += i;
+  return sum;
+}
+
+static void benchProcess(SBenchPool *pPool, SBenchQueue *pQueue, SBenchItem *pItem, bool ordered) {
+  benchWork(pPool->loops);
+
+  if (ordered) {
+    if (pItem->seq != pQueue->expected) pQueue->disorder++;
+    pQueue->expected = pItem->seq + 1;
+  }
+
+  taosFreeQitem(pItem);
+  atomic_add_fetch_64(&pPool->processed, 1);
+}
+
+static void *benchWorkerFp(void *param) {
+  SBenchThread *pThread = param;
+  SBenchPool   *pPool = pThread->pPool;
+  taos_qall     qall = taosAllocateQall();
+  SBenchItem   *pItem = NULL;
+  SBenchQueue  *pQueue = NULL;
+  int32_t       type;
+
+  while (1) {
+    int32_t num = 0;
+    switch (pPool->mode) {
+      case BENCH_BOUND:
+        num = taosReadAllQitemsFromQset(pPool->qsets[pThread->id], qall, (void **)&pQueue);
+        break;
+      case BENCH_SHARED:
+        num = taosReadQitemFromQset(pPool->qsets[0], &type, (void **)&pItem, (void **)&pQueue);
+        break;
+      case BENCH_STEAL:
+        num = taosReadAllQitemsFromWorkerQset(pPool->qsets[0], pThread->id, qall, (void **)&pQueue);
+        break;
+      default:
+        num = taosReadQitemFromWorkerQset(pPool->qsets[0], pThread->id, &type, (void **)&pItem, (void **)&pQueue);
+        break;
+    }
+
+    if (num == 0) break;
+
+    if (pPool->mode == BENCH_SHARED || pPool->mode == BENCH_STEAL_ONE) {
+      benchProcess(pPool, pQueue, pItem, false);
+      continue;
+    }
+
+    for (int32_t i = 0; i < num; ++i) {
+      taosGetQitem(qall, &type, (void **)&pItem);
+      benchProcess(pPool, pQueue, pItem, true);
+    }
+  }
+
+  taosFreeQall(qall);
+  return NULL;
+}
+
+static void *benchProducerFp(void *param) {
+  SBenchThread *pThread = param;
+  SBenchPool   *pPool = pThread->pPool;
+  uint32_t      seed = (uint32_t)pThread->id + 1;
+  int32_t       numOfHot = MAX(pPool->numOfQueues / 16, 1);
+
+  for (int64_t i = pThread->id; i < pPool->numOfItems; i += BENCH_PRODUCERS) {
+    int32_t r = rand_r(&seed);
+    int32_t q = (r & 1) ? (r >> 1) % numOfHot : (r >> 1) % pPool->numOfQueues;
+
+    SBenchItem *pItem = taosAllocateQitem(sizeof(SBenchItem));
+    pItem->queue = q;
+
+    // the sequence and the position in the queue shall be the same
+    pthread_mutex_lock(&pPool->mutex);
+    pItem->seq = pPool->queues[q].written++;
+    taosWriteQitem(pPool->queues[q].queue, 0, pItem);
+    pthread_mutex_unlock(&pPool->mutex);
+  }
+
+  return NULL;
+}
+
+static double doBench(EBenchMode mode, int32_t numOfQueues, int32_t numOfWorkers, int64_t numOfItems, int32_t loops,
+                      SQsetStat *pStat, int32_t *disorder) {
+  SBenchPool pool = {.mode = mode, .numOfQueues = numOfQueues, .numOfWorkers = numOfWorkers, .numOfItems = numOfItems,
+                     .loops = loops};
+  pthread_mutex_init(&pool.mutex, NULL);
+
+  int32_t numOfQsets = (mode == BENCH_BOUND) ? numOfWorkers : 1;
+  pool.qsets = calloc(numOfQsets, sizeof(taos_qset));
+  for (int32_t i = 0; i < numOfQsets; ++i) {
+    pool.qsets[i] = (mode == BENCH_STEAL || mode == BENCH_STEAL_ONE) ? taosOpenWorkerQset(numOfWorkers) : taosOpenQset();
+  }
+
+  pool.queues = calloc(numOfQueues, sizeof(SBenchQueue));
+  for (int32_t i = 0; i < numOfQueues; ++i) {
+    pool.queues[i].queue = taosOpenQueue();
+    taosAddIntoQset(pool.qsets[i % numOfQsets], pool.queues[i].queue, &pool.queues[i]);
+  }
+
+  SBenchThread *workers = calloc(numOfWorkers, sizeof(SBenchThread));
+  SBenchThread  producers[BENCH_PRODUCERS];
+
+  int64_t st = taosGetTimestampUs();
+  for (int32_t i = 0; i < numOfWorkers; ++i) {
+    workers[i].pPool = &pool;
+    workers[i].id = i;
+    pthread_create(&workers[i].thread, NULL, benchWorkerFp, workers + i);
+  }
+
+  for (int32_t i = 0; i < BENCH_PRODUCERS; ++i) {
+    producers[i].pPool = &pool;
+    producers[i].id = i;
+    pthread_create(&producers[i].thread, NULL, benchProducerFp, producers + i);
+  }
+
+  for (int32_t i = 0; i < BENCH_PRODUCERS; ++i) {
+    pthread_join(producers[i].thread, NULL);
+  }
+
+  while (atomic_load_64(&pool.processed) < numOfItems) {
+    taosMsleep(1);
+  }
+  int64_t el = taosGetTimestampUs() - st;
+
+  for (int32_t i = 0; i < numOfWorkers; ++i) {
+    taosQsetThreadResume(pool.qsets[(mode == BENCH_BOUND) ? i : 0]);
+  }
+
+  for (int32_t i = 0; i < numOfWorkers; ++i) {
+    pthread_join(workers[i].thread, NULL);
+  }
+
+  memset(pStat, 0, sizeof(SQsetStat));
+  *disorder = 0;
+  for (int32_t i = 0; i < numOfQsets; ++i) {
+    SQsetStat stat;
+    taosGetQsetStat(pool.qsets[i], &stat);
+    pStat->numOfReads += stat.numOfReads;
+    pStat->numOfSteals += stat.numOfSteals;
+    pStat->numOfContentions += stat.numOfContentions;
+  }
+
+  for (int32_t i = 0; i < numOfQueues; ++i) {
+    *disorder += pool.queues[i].disorder;
+    taosCloseQueue(pool.queues[i].queue);
+  }
+
+  for (int32_t i = 0; i < numOfQsets; ++i) {
+    taosCloseQset(pool.qsets[i]);
+  }
+
+  free(workers);
+  free(pool.queues);
+  free(pool.qsets);
+  pthread_mutex_destroy(&pool.mutex);
+
+  return numOfItems / (el / 1000000.0);
+}
+
+int main(int argc, char *argv[]) {
+  int32_t numOfQueues = (argc > 1) ? atoi(argv[1]) : 1000;
+  int32_t numOfWorkers = (argc > 2) ? atoi(argv[2]) : 8;
+  int64_t numOfItems = (argc > 3) ? atoll(argv[3]) : 1000000;
+  int32_t loops = (argc > 4) ? atoi(argv[4]) : 1000;
+
+  if (numOfQueues <= 0 || numOfWorkers <= 0 || numOfItems <= 0 || loops < 0) {
+    printf("usage: %s [queues] [workers] [items] [loops per item]\n", argv[0]);
+    return 1;
+  }
+
+  printf("queues:%d, workers:%d, items:%" PRId64 ", loops per item:%d\n", numOfQueues, numOfWorkers, numOfItems,
+         loops);
+
+  for (int32_t m = 0; m < BENCH_MAX; ++m) {
+    SQsetStat stat;
+    int32_t   disorder = 0;
+    double    v = doBench(m, numOfQueues, numOfWorkers, numOfItems, loops, &stat, &disorder);
+    if (disorder > 0) {
+      printf("%s: %d items are processed out of order\n", benchModeName[m], disorder);
+      return 1;
+    }
+
+    printf("%-8s %12.0f items/sec, reads:%" PRId64 " steals:%" PRId64 " contentions:%" PRId64 "\n", benchModeName[m], v,
+           stat.numOfReads, stat.numOfSteals, stat.numOfContentions);
+  }
+
+  return 0;
+}
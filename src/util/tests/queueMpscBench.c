@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "tqueue.h"
+
+/*
+ * Report the items/sec of several producers writing one queue drained by one consumer, with the items allocated and
+ * freed by taosAllocateQitem/taosFreeQitem. The items of each producer are checked to be read in the order written.
+ *   queue:  the consumer polls the queue with taosReadAllQitems
+ *   qset:   the consumer waits on a qset with taosReadAllQitemsFromQset, as the vwrite worker does
+ *
+ * Build with LOCKFREE_QUEUE=true to compare the lock-free queue with the default one.
+ *
+ * usage: queueMpscBench [max producers] [items per producer] [item size]
+ */
+
+typedef enum { BENCH_QUEUE, BENCH_QSET, BENCH_MAX } EBenchMode;
+
+static const char *benchModeName[BENCH_MAX] = {"queue", "qset"};
+
+typedef struct {
+  int32_t producer;
+  int64_t seq;
+} SBenchItem;
+
+typedef struct {
+  EBenchMode mode;
+  int32_t    numOfProducers;
+  int64_t    numOfItems;  // per producer
+  int32_t    itemSize;
+  taos_queue queue;
+  taos_qset  qset;
+  int64_t   *expected;  // sequence of the next item of each producer
+  int64_t    disorder;
+} SBenchCtx;
+
+typedef struct {
+  SBenchCtx *pCtx;
+  int32_t    id;
+  pthread_t  thread;
+} SBenchProducer;
+
+static void *benchProducerFp(void *param) {
+  SBenchProducer *pProducer = param;
+  SBenchCtx      *pCtx = pProducer->pCtx;
+
+  for (int64_t i = 0; i < pCtx->numOfItems; ++i) {
+    SBenchItem *pItem = taosAllocateQitem(pCtx->itemSize);
+    pItem->producer = pProducer->id;
+    pItem->seq = i;
+    taosWriteQitem(pCtx->queue, 0, pItem);
+  }
+
+  return NULL;
+}
+
+static void benchConsume(SBenchCtx *pCtx) {
+  taos_qall   qall = taosAllocateQall();
+  int64_t     total = pCtx->numOfItems * pCtx->numOfProducers;
+  int64_t     consumed = 0;
+  SBenchItem *pItem = NULL;
+  void       *ahandle = NULL;
+  int32_t     type;
+
+  while (consumed < total) {
+    int32_t num = 0;
+    if (pCtx->mode == BENCH_QUEUE) {
+      num = taosReadAllQitems(pCtx->queue, qall);
+      if (num == 0) {
+        sched_yield();
+        continue;
+      }
+    } else {
+      num = taosReadAllQitemsFromQset(pCtx->qset, qall, &ahandle);
+    }
+
+    for (int32_t i = 0; i < num; ++i) {
+      taosGetQitem(qall, &type, (void **)&pItem);
+      if (pItem->seq != pCtx->expected[pItem->producer]) pCtx->disorder++;
+      pCtx->expected[pItem->producer] = pItem->seq + 1;
+      taosFreeQitem(pItem);
+    }
+
+    consumed += num;
+  }
+
+  taosFreeQall(qall);
+}
+
+static double doBench(EBenchMode mode, int32_t numOfProducers, int64_t numOfItems, int32_t itemSize,
+                      int64_t *disorder) {
+  SBenchCtx ctx = {.mode = mode, .numOfProducers = numOfProducers, .numOfItems = numOfItems, .itemSize = itemSize};
+  ctx.queue = taosOpenQueue();
+  ctx.expected = calloc(numOfProducers, sizeof(int64_t));
+  if (mode == BENCH_QSET) {
+    ctx.qset = taosOpenQset();
+    taosAddIntoQset(ctx.qset, ctx.queue, &ctx);
+  }
+
+  SBenchProducer *producers = calloc(numOfProducers, sizeof(SBenchProducer));
+
+  int64_t st = taosGetTimestampUs();
+  for (int32_t i = 0; i < numOfProducers; ++i) {
+    producers[i].pCtx = &ctx;
+    producers[i].id = i;
+    pthread_create(&producers[i].thread, NULL, benchProducerFp, producers + i);
+  }
+
+  benchConsume(&ctx);
+  int64_t el = taosGetTimestampUs() - st;
+
+  for (int32_t i = 0; i < numOfProducers; ++i) {
+    pthread_join(producers[i].thread, NULL);
+  }
+
+  *disorder = ctx.disorder;
+  for (int32_t i = 0; i < numOfProducers; ++i) {
+    if (ctx.expected[i] != numOfItems) (*disorder)++;
+  }
+
+  if (mode == BENCH_QSET) {
+    taosRemoveFromQset(ctx.qset, ctx.queue);
+    taosCloseQset(ctx.qset);
+  }
+  taosCloseQueue(ctx.queue);
+  free(ctx.expected);
+  free(producers);
+
+  return numOfItems * numOfProducers / (el / 1000000.0);
+}
+
+int main(int argc, char *argv[]) {
+  int32_t maxProducers = (argc > 1) ? atoi(argv[1]) : 8;
+  int64_t numOfItems = (argc > 2) ? atoll(argv[2]) : 1000000;
+  int32_t itemSize = (argc > 3) ? atoi(argv[3]) : 64;
+
+  if (maxProducers <= 0 || numOfItems <= 0 || itemSize < (int32_t)sizeof(SBenchItem)) {
+    printf("usage: %s [max producers] [items per producer] [item size]\n", argv[0]);
+    return 1;
+  }
+
+#ifdef TAOS_LOCKFREE_QUEUE
+  printf("lock-free queue, ");
+#else
+  printf("mutex queue, ");
+#endif
+  printf("items per producer:%" PRId64 ", item size:%d\n", numOfItems, itemSize);
+
+  for (int32_t m = 0; m < BENCH_MAX; ++m) {
+    for (int32_t n = 1; n <= maxProducers; n *= 2) {
+      int64_t disorder = 0;
+      double  v = doBench(m, n, numOfItems, itemSize, &disorder);
+      if (disorder > 0) {
+        printf("%s, producers:%d, %" PRId64 " items are lost or out of order\n", benchModeName[m], n, disorder);
+        return 1;
+      }
+
+      printf("%-6s producers:%-3d %12.0f items/sec\n", benchModeName[m], n, v);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+#include "os.h"
+#include "tqueue.h"
+
+namespace {
+void writeItems(taos_queue queue, int32_t start, int32_t num) {
+  for (int32_t i = start; i < start + num; ++i) {
+    int32_t *pItem = (int32_t *)taosAllocateQitem(sizeof(int32_t));
+    *pItem = i;
+    taosWriteQitem(queue, 0, pItem);
+  }
+}
+
+// the items are checked to be in order and freed
+int32_t readAll(taos_qall qall, int32_t num, int32_t start) {
+  int32_t  type;
+  int32_t *pItem;
+  int32_t  next = start;
+  for (int32_t i = 0; i < num; ++i) {
+    taosGetQitem(qall, &type, (void **)&pItem);
+    if (*pItem == next) next++;
+    taosFreeQitem(pItem);
+  }
+
+  return next - start;
+}
+}  // namespace
+
+TEST(testCase, worker_qset_steal) {
+  taos_qset  qset = taosOpenWorkerQset(2);
+  taos_qall  qall = taosAllocateQall();
+  taos_queue queues[4];
+  int64_t    handles[4] = {0, 1, 2, 3};
+
+  // the queues are handed to worker 0 and 1 in turn
+  for (int32_t i = 0; i < 4; ++i) {
+    queues[i] = taosOpenQueue();
+    taosAddIntoQset(qset, queues[i], &handles[i]);
+    writeItems(queues[i], 0, 10);
+  }
+
+  // worker 1 takes its own queues first, then the ones of worker 0
+  int32_t expected[4] = {1, 3, 0, 2};
+  for (int32_t i = 0; i < 4; ++i) {
+    int64_t *pHandle = NULL;
+    int32_t  num = taosReadAllQitemsFromWorkerQset(qset, 1, qall, (void **)&pHandle);
+    ASSERT_EQ(num, 10);
+    ASSERT_EQ(*pHandle, expected[i]);
+    ASSERT_EQ(readAll(qall, num, 0), 10);
+  }
+
+  SQsetStat stat;
+  taosGetQsetStat(qset, &stat);
+  ASSERT_EQ(stat.numOfReads, 4);
+  ASSERT_EQ(stat.numOfSteals, 2);
+  ASSERT_EQ(taosGetQsetItemsNumber(qset), 0);
+
+  for (int32_t i = 0; i < 4; ++i) taosCloseQueue(queues[i]);
+  taosFreeQall(qall);
+  taosCloseQset(qset);
+}
+
+TEST(testCase, worker_qset_drain_in_order) {
+  taos_qset  qset = taosOpenWorkerQset(2);
+  taos_qall  qall = taosAllocateQall();
+  taos_queue q1 = taosOpenQueue();
+  taos_queue q2 = taosOpenQueue();
+  int64_t    h1 = 1, h2 = 2;
+  int64_t   *pHandle = NULL;
+
+  taosAddIntoQset(qset, q1, &h1);
+  taosAddIntoQset(qset, q2, &h2);
+
+  writeItems(q1, 0, 5);
+  ASSERT_EQ(taosReadAllQitemsFromWorkerQset(qset, 0, qall, (void **)&pHandle), 5);
+  ASSERT_EQ(*pHandle, 1);
+  ASSERT_EQ(readAll(qall, 5, 0), 5);
+
+  // q1 is held by worker 0, the new items of it are not handed to worker 1
+  writeItems(q1, 5, 5);
+  writeItems(q2, 0, 3);
+  ASSERT_EQ(taosReadAllQitemsFromWorkerQset(qset, 1, qall, (void **)&pHandle), 3);
+  ASSERT_EQ(*pHandle, 2);
+  ASSERT_EQ(readAll(qall, 3, 0), 3);
+
+  ASSERT_EQ(taosReadAllQitemsFromWorkerQset(qset, 0, qall, (void **)&pHandle), 5);
+  ASSERT_EQ(*pHandle, 1);
+  ASSERT_EQ(readAll(qall, 5, 5), 5);
+
+  // q2 is still held by worker 1, and it goes on with the new items
+  writeItems(q2, 3, 2);
+  ASSERT_EQ(taosReadAllQitemsFromWorkerQset(qset, 1, qall, (void **)&pHandle), 2);
+  ASSERT_EQ(*pHandle, 2);
+  ASSERT_EQ(readAll(qall, 2, 3), 2);
+
+  // the queue closed while it is held is freed with the qset
+  taosCloseQueue(q1);
+
+  taosCloseQueue(q2);
+  taosFreeQall(qall);
+  taosCloseQset(qset);
+}
+
+TEST(testCase, worker_qset_read_one) {
+  taos_qset  qset = taosOpenWorkerQset(4);
+  taos_queue queue = taosOpenQueue();
+  int64_t    handle = 7;
+
+  taosAddIntoQset(qset, queue, &handle);
+  writeItems(queue, 0, 3);
+
+  // the items of a queue are read one by one by any worker
+  for (int32_t i = 0; i < 3; ++i) {
+    int32_t  type = -1;
+    int32_t *pItem = NULL;
+    int64_t *pHandle = NULL;
+    ASSERT_EQ(taosReadQitemFromWorkerQset(qset, i, &type, (void **)&pItem, (void **)&pHandle), 1);
+    ASSERT_EQ(*pItem, i);
+    ASSERT_EQ(*pHandle, 7);
+    taosFreeQitem(pItem);
+  }
+
+  // it exits with nothing to read
+  taosQsetThreadResume(qset);
+  int32_t *pItem = NULL;
+  ASSERT_EQ(taosReadQitemFromWorkerQset(qset, 0, NULL, (void **)&pItem, NULL), 0);
+
+  taosCloseQueue(queue);
+  taosCloseQset(qset);
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "taosdef.h"
+#include "tcompare.h"
+#include "tskiplist.h"
+
+/*
+ * Report the rows/sec of inserting the rows of a vnode into the skip lists of its tables, the way the write thread of
+ * a vnode puts the rows of the submit blocks into the mem table: row by row, or batch by batch.
+ *
+ * usage: skiplistBench [tables] [rows per table] [rows per batch]
+ */
+
+#define BENCH_SL_LEVEL 5
+
+typedef struct {
+  int64_t *keys;
+  int32_t  pos;
+  int32_t  num;
+} SBenchIter;
+
+static char *benchGetKey(const void *pData) { return (char *)pData; }
+
+static void *benchIterNext(void *iter) {
+  SBenchIter *pIter = (SBenchIter *)iter;
+  return (pIter->pos < pIter->num) ? &pIter->keys[pIter->pos++] : NULL;
+}
+
+static SSkipList **createTables(int32_t numOfTables) {
+  SSkipList **pTables = calloc(numOfTables, POINTER_BYTES);
+  for (int32_t i = 0; i < numOfTables; ++i) {
+    pTables[i] = tSkipListCreate(BENCH_SL_LEVEL, TSDB_DATA_TYPE_TIMESTAMP, sizeof(int64_t),
+                                 getKeyComparFunc(TSDB_DATA_TYPE_TIMESTAMP, TSDB_ORDER_ASC), SL_DISCARD_DUP_KEY,
+                                 benchGetKey);
+  }
+
+  return pTables;
+}
+
+static void destroyTables(SSkipList **pTables, int32_t numOfTables) {
+  for (int32_t i = 0; i < numOfTables; ++i) {
+    tSkipListDestroy(pTables[i]);
+  }
+
+  free(pTables);
+}
+
+/*
+ * keys: the keys of each table, in the order of the submit blocks
+ * return the rows/sec, or -1 if the skip lists do not have the expected content
+ */
+static double doBench(int64_t *keys, int32_t numOfTables, int32_t rows, int32_t batch, bool batchPut) {
+  SSkipList **pTables = createTables(numOfTables);
+
+  int64_t st = taosGetTimestampUs();
+  for (int32_t start = 0; start < rows; start += batch) {
+    int32_t num = MIN(batch, rows - start);
+
+    for (int32_t t = 0; t < numOfTables; ++t) {
+      int64_t *pKeys = keys + (int64_t)t * rows + start;
+
+      if (batchPut) {
+        SBenchIter iter = {.keys = pKeys, .pos = 0, .num = num};
+        tSkipListPutBatchByIter(pTables[t], &iter, benchIterNext);
+      } else {
+        for (int32_t i = 0; i < num; ++i) {
+          tSkipListPut(pTables[t], &pKeys[i]);
+        }
+      }
+    }
+  }
+  int64_t el = taosGetTimestampUs() - st;
+
+  // all tables must be in order and complete
+  bool valid = true;
+  for (int32_t t = 0; t < numOfTables && valid; ++t) {
+    valid = (SL_SIZE(pTables[t]) == (uint32_t)rows);
+
+    SSkipListIterator *pIter = tSkipListCreateIter(pTables[t]);
+    int64_t            prev = INT64_MIN;
+    while (valid && tSkipListIterNext(pIter)) {
+      int64_t key = *(int64_t *)SL_GET_NODE_DATA(tSkipListIterGet(pIter));
+      valid = (key > prev);
+      prev = key;
+    }
+    tSkipListDestroyIter(pIter);
+  }
+
+  destroyTables(pTables, numOfTables);
+  return valid ? (double)numOfTables * rows / (el / 1000000.0) : -1;
+}
+
+// keys of the latter half batches are older than the existing ones, to measure the out of order inserts
+static void genKeys(int64_t *keys, int32_t numOfTables, int32_t rows, int32_t batch, bool disorder) {
+  int64_t ts = 1600000000000L;
+
+  for (int32_t t = 0; t < numOfTables; ++t) {
+    int64_t *pKeys = keys + (int64_t)t * rows;
+    for (int32_t i = 0; i < rows; ++i) {
+      pKeys[i] = ts + i * 1000L;
+    }
+
+    if (!disorder) continue;
+
+    // swap the batches of the latter half with the ones of the first half, in an interleaved way
+    int32_t numOfBatches = rows / batch;
+    for (int32_t b = 1; b < numOfBatches / 2; b += 2) {
+      int32_t other = numOfBatches - b;
+      for (int32_t i = 0; i < batch; ++i) {
+        int64_t k = pKeys[b * batch + i];
+        pKeys[b * batch + i] = pKeys[other * batch + i];
+        pKeys[other * batch + i] = k;
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int32_t numOfTables = (argc > 1) ? atoi(argv[1]) : 1000;
+  int32_t rows = (argc > 2) ? atoi(argv[2]) : 10000;
+  int32_t batch = (argc > 3) ? atoi(argv[3]) : 100;
+
+  if (numOfTables <= 0 || rows <= 0 || batch <= 0) {
+    printf("usage: %s [tables] [rows per table] [rows per batch]\n", argv[0]);
+    return 1;
+  }
+
+  int64_t *keys = malloc(sizeof(int64_t) * numOfTables * rows);
+
+  printf("tables:%d, rows per table:%d, rows per batch:%d\n", numOfTables, rows, batch);
+  for (int32_t d = 0; d < 2; ++d) {
+    genKeys(keys, numOfTables, rows, batch, d == 1);
+
+    for (int32_t m = 0; m < 2; ++m) {
+      // take the best of several runs to reduce the noise
+      double best = 0;
+      for (int32_t r = 0; r < 3; ++r) {
+        double v = doBench(keys, numOfTables, rows, batch, m == 1);
+        if (v < 0) {
+          printf("invalid skip list content\n");
+          free(keys);
+          return 1;
+        }
+        best = MAX(best, v);
+      }
+
+      printf("%-10s %-6s %12.0f rows/sec\n", (d == 0) ? "append" : "disorder", (m == 0) ? "row" : "batch", best);
+    }
+  }
+
+  free(keys);
+  return 0;
+}
@@ -3,6 +3,8 @@
 #include <taosdef.h>
 #include <tcompare.h>
 #include <iostream>
+#include <set>
+#include <vector>
 
 #include "os.h"
 #include "taosmsg.h"
@@ -377,4 +379,86 @@ TEST(testCase, skiplist_test) {
       free(pKeys);*/
 }
 
-#endif
\ No newline at end of file
+#endif
+namespace {
+
+char* getInt64Key(const void* data) { return (char*)(data); }
+
+struct SKeyIter {
+  int64_t* keys;
+  int32_t  pos;
+  int32_t  num;
+};
+
+void* keyIterNext(void* iter) {
+  SKeyIter* p = (SKeyIter*)iter;
+  return (p->pos < p->num) ? &p->keys[p->pos++] : NULL;
+}
+
+void putBatch(SSkipList* pSkipList, int64_t* keys, int32_t num) {
+  SKeyIter iter = {keys, 0, num};
+  tSkipListPutBatchByIter(pSkipList, &iter, keyIterNext);
+}
+
+void checkSkipList(SSkipList* pSkipList, const std::vector<int64_t>& expect) {
+  ASSERT_EQ(SL_SIZE(pSkipList), expect.size());
+
+  SSkipListIterator* pIter = tSkipListCreateIter(pSkipList);
+  for (size_t i = 0; i < expect.size(); ++i) {
+    ASSERT_TRUE(tSkipListIterNext(pIter));
+    ASSERT_EQ(*(int64_t*)SL_GET_NODE_DATA(tSkipListIterGet(pIter)), expect[i]);
+  }
+  ASSERT_FALSE(tSkipListIterNext(pIter));
+  tSkipListDestroyIter(pIter);
+
+  // the backward links must be consistent with the forward ones
+  SSkipListIterator* pRIter = tSkipListCreateIterFromVal(pSkipList, NULL, TSDB_DATA_TYPE_TIMESTAMP, TSDB_ORDER_DESC);
+  for (size_t i = expect.size(); i > 0; --i) {
+    ASSERT_TRUE(tSkipListIterNext(pRIter));
+    ASSERT_EQ(*(int64_t*)SL_GET_NODE_DATA(tSkipListIterGet(pRIter)), expect[i - 1]);
+  }
+  tSkipListDestroyIter(pRIter);
+}
+
+}  // namespace
+
+TEST(testCase, skiplist_batch_put_test) {
+  SSkipList* pSkipList = tSkipListCreate(5, TSDB_DATA_TYPE_TIMESTAMP, sizeof(int64_t),
+                                         getKeyComparFunc(TSDB_DATA_TYPE_TIMESTAMP, TSDB_ORDER_ASC),
+                                         SL_DISCARD_DUP_KEY, getInt64Key);
+
+  std::vector<int64_t> expect;
+  int64_t*             keys = (int64_t*)malloc(sizeof(int64_t) * 20000);
+
+  // empty batch
+  putBatch(pSkipList, keys, 0);
+  checkSkipList(pSkipList, expect);
+
+  // batches appended to the tail
+  for (int32_t i = 0; i < 10000; ++i) {
+    keys[i] = i * 10;
+    expect.push_back(keys[i]);
+  }
+  putBatch(pSkipList, keys, 5000);
+  putBatch(pSkipList, keys + 5000, 5000);
+  checkSkipList(pSkipList, expect);
+
+  // a batch partly in the middle, partly duplicated with the max key, and partly beyond the tail
+  int64_t* pKeys = keys + 10000;
+  int32_t  num = 0;
+  for (int32_t i = 0; i < 100; ++i) {
+    pKeys[num++] = 99000 + i * 5;
+  }
+  for (int32_t i = 0; i < 100; ++i) {
+    pKeys[num++] = 99990 + i * 5;
+  }
+
+  std::set<int64_t> s(expect.begin(), expect.end());
+  s.insert(pKeys, pKeys + num);
+  expect.assign(s.begin(), s.end());
+  putBatch(pSkipList, pKeys, num);
+  checkSkipList(pSkipList, expect);
+
+  tSkipListDestroy(pSkipList);
+  free(keys);
+}
@@ -56,6 +56,7 @@ typedef struct {
   uint64_t version;   // current version
   uint64_t cversion;  // version while commit start
   uint64_t fversion;  // version on saved data file
+  uint64_t wversion;  // version written into wal, ahead of version while a write batch is applied
   uint32_t tblMsgVer; // create table msg version
   void *   wqueue;    // write queue
   void *   qqueue;    // read query queue
@@ -27,6 +27,10 @@ void    vnodeCleanupWrite(void);
 int32_t vnodeWriteToWQueue(void *pVnode, void *pHead, int32_t qtype, void *pRpcMsg);
 void    vnodeFreeFromWQueue(void *pVnode, SVWriteMsg *pWrite);
 int32_t vnodeProcessWrite(void *pVnode, void *pHead, int32_t qtype, void *pRspRet);
+void    vnodeBeginWriteBatch(void *pVnode);
+int32_t vnodeEndWriteBatch(void *pVnode);
+int32_t vnodeWriteToWal(void *pVnode, void *pHead, int32_t qtype, void *pRspRet);
+int32_t vnodeApplyWrite(void *pVnode, void *pHead, int32_t qtype, void *pRspRet, int32_t syncCode);
 void    vnodeWaitWriteCompleted(SVnodeObj *pVnode);
 
 #ifdef __cplusplus
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE
+#include "os.h"
+#include "taoserror.h"
+#include "tglobal.h"
+#include "vnodeStatus.h"
+#include "vnodeCompact.h"
+
+/*
+ * The background compaction: every compactInterval seconds, each vnode in ready status is asked to compact its most
+ * fragmented file set. The compaction runs in the tsdb commit threads one file set at a time, so that the commits of
+ * the vnode are held for no longer than a file set takes. It is not slowed down while it holds the commits, a vnode
+ * is skipped instead until the bytes read by its last compaction fit in compactMBps.
+ */
+typedef struct {
+  bool            stop;
+  pthread_t       thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+} SVCompactCtrl;
+
+static SVCompactCtrl tsVCompact;
+
+static void vnodeAutoCompact() {
+  int32_t *vgIds = calloc(TSDB_MAX_VNODES, sizeof(int32_t));
+  int32_t  numOfVnodes = 0;
+  if (vgIds == NULL) return;
+
+  vnodeGetVnodeList(vgIds, &numOfVnodes);
+  numOfVnodes = MIN(numOfVnodes, TSDB_MAX_VNODES);
+
+  for (int32_t i = 0; i < numOfVnodes && !tsVCompact.stop; ++i) {
+    SVnodeObj *pVnode = vnodeAcquire(vgIds[i]);
+    if (pVnode == NULL) continue;
+
+    if (pVnode->tsdb != NULL && vnodeInReadyStatus(pVnode)) {
+      vTrace("vgId:%d, check the background compaction", pVnode->vgId);
+      tsdbAutoCompact(pVnode->tsdb);
+    }
+
+    vnodeRelease(pVnode);
+  }
+
+  free(vgIds);
+}
+
+static void *vnodeCompactFunc(void *param) {
+  setThreadName("vnodeCompact");
+
+  pthread_mutex_lock(&tsVCompact.mutex);
+  while (!tsVCompact.stop) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += tsCompactInterval;
+    pthread_cond_timedwait(&tsVCompact.cond, &tsVCompact.mutex, &ts);
+    if (tsVCompact.stop) break;
+
+    pthread_mutex_unlock(&tsVCompact.mutex);
+    vnodeAutoCompact();
+    pthread_mutex_lock(&tsVCompact.mutex);
+  }
+  pthread_mutex_unlock(&tsVCompact.mutex);
+
+  return NULL;
+}
+
+int32_t vnodeInitCompact() {
+  if (tsCompactInterval <= 0) {
+    vDebug("vcompact is disabled");
+    return TSDB_CODE_SUCCESS;
+  }
+
+  tsVCompact.stop = false;
+  pthread_mutex_init(&tsVCompact.mutex, NULL);
+  pthread_cond_init(&tsVCompact.cond, NULL);
+
+  pthread_attr_t thAttr;
+  pthread_attr_init(&thAttr);
+  pthread_attr_setdetachstate(&thAttr, PTHREAD_CREATE_JOINABLE);
+
+  if (pthread_create(&tsVCompact.thread, &thAttr, vnodeCompactFunc, NULL) != 0) {
+    vError("failed to create thread to compact vnodes, reason:%s", strerror(errno));
+    pthread_attr_destroy(&thAttr);
+    pthread_cond_destroy(&tsVCompact.cond);
+    pthread_mutex_destroy(&tsVCompact.mutex);
+    return TAOS_SYSTEM_ERROR(errno);
+  }
+
+  pthread_attr_destroy(&thAttr);
+  vInfo("vcompact is launched, interval:%ds, budget:%dMB/s", tsCompactInterval, tsCompactMBps);
+
+  return TSDB_CODE_SUCCESS;
+}
+
+void vnodeCleanupCompact() {
+  if (tsCompactInterval <= 0 || taosCheckPthreadValid(tsVCompact.thread) == false) return;
+
+  pthread_mutex_lock(&tsVCompact.mutex);
+  tsVCompact.stop = true;
+  pthread_cond_signal(&tsVCompact.cond);
+  pthread_mutex_unlock(&tsVCompact.mutex);
+
+  pthread_join(tsVCompact.thread, NULL);
+  taosResetPthread(&tsVCompact.thread);
+  pthread_cond_destroy(&tsVCompact.cond);
+  pthread_mutex_destroy(&tsVCompact.mutex);
+
+  vDebug("vcompact is closed");
+}
+
+int32_t vnodeGetCompactStat(int32_t vgId, STsdbCompactStat *pStat) {
+  SVnodeObj *pVnode = vnodeAcquire(vgId);
+  if (pVnode == NULL) return TSDB_CODE_VND_INVALID_VGROUP_ID;
+
+  int32_t code = TSDB_CODE_SUCCESS;
+  if (pVnode->tsdb != NULL) {
+    tsdbGetCompactStat(pVnode->tsdb, pStat);
+  } else {
+    code = TSDB_CODE_VND_INVALID_VGROUP_ID;
+  }
+
+  vnodeRelease(pVnode);
+  return code;
+}
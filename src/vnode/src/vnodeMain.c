@@ -366,12 +366,20 @@ int32_t vnodeOpen(int32_t vgId) {
     return terrno;
   }
 
-  walRestore(pVnode->wal, pVnode, vnodeProcessWrite);
+  int64_t st = taosGetTimestampMs();
+  code = walRestore(pVnode->wal, pVnode, vnodeProcessWrite);
+  if (code != TSDB_CODE_SUCCESS) {
+    vError("vgId:%d, failed to restore wal since %s", pVnode->vgId, tstrerror(code));
+    vnodeCleanUp(pVnode);
+    return code;
+  }
+
   if (pVnode->version == 0) {
     pVnode->fversion = 0;
     pVnode->version = walGetVersion(pVnode->wal);
   }
 
+  int64_t restoreTime = taosGetTimestampMs() - st;
   code = tsdbSyncCommit(pVnode->tsdb);
   if (code != 0) {
     vError("vgId:%d, failed to commit after restore from wal since %s", pVnode->vgId, tstrerror(code));
@@ -379,6 +387,9 @@ int32_t vnodeOpen(int32_t vgId) {
     return code;
   }
 
+  vInfo("vgId:%d, wal is restored in %" PRId64 " ms and committed in %" PRId64 " ms, fver:%" PRIu64 " vver:%" PRIu64,
+        pVnode->vgId, restoreTime, taosGetTimestampMs() - st - restoreTime, pVnode->fversion, pVnode->version);
+
   walRemoveAllOldFiles(pVnode->wal);
   walRenew(pVnode->wal);
 
@@ -18,6 +18,7 @@
 #include "dnode.h"
 #include "vnodeStatus.h"
 #include "vnodeBackup.h"
+#include "vnodeCompact.h"
 #include "vnodeWorker.h"
 #include "vnodeRead.h"
 #include "vnodeWrite.h"
@@ -35,7 +36,9 @@ static SStep tsVnodeSteps[] = {
   {"vnode-write",  vnodeInitWrite,      vnodeCleanupWrite},
   {"vnode-read",   vnodeInitRead,       vnodeCleanupRead},
   {"vnode-hash",   vnodeInitHash,       vnodeCleanupHash},
-  {"tsdb-queue",   tsdbInitCommitQueue, tsdbDestroyCommitQueue}
+  {"tsdb-queue",   tsdbInitCommitQueue, tsdbDestroyCommitQueue},
+  {"tsdb-read",    tsdbInitReadAhead,   tsdbDestroyReadAhead},
+  {"vnode-compact", vnodeInitCompact,   vnodeCleanupCompact}
 };
 
 int32_t vnodeInitMgmt() {
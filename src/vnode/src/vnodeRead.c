@@ -169,6 +169,23 @@ static int32_t vnodePutItemIntoReadQueue(SVnodeObj *pVnode, void **qhandle, void
   return code;
 }
 
+// a slot of the query scheduler is reserved for the query, put it back into the vquery queue
+static void vnodeResumeQuery(void *param, void **qhandle) {
+  SVnodeObj *pVnode = param;
+
+  int32_t code = vnodePutItemIntoReadQueue(pVnode, qhandle, NULL);
+  if (code != TSDB_CODE_SUCCESS) {
+    int32_t remain = atomic_sub_fetch_32(&vNumOfExistedQHandle, 1);
+    vError("vgId:%d, QInfo:%p, failed to resume query since %s, remain qhandle:%d", pVnode->vgId, *qhandle,
+           tstrerror(code), remain);
+
+    qReleaseExecSlot(*qhandle);
+    qReleaseQInfo(pVnode->qMgmt, (void **)&qhandle, true);
+  }
+
+  vnodeRelease(pVnode);
+}
+
 /**
  *
  * @param pRet         response message object
@@ -241,6 +258,11 @@ static int32_t vnodeProcessQueryMsg(SVnodeObj *pVnode, SVReadMsg *pRead) {
     uint64_t qId = genQueryId();
     code = qCreateQueryInfo(pVnode->tsdb, pVnode->vgId, pQueryTableMsg, &pQInfo, qId);
 
+    SRpcConnInfo connInfo = {0};
+    if (code == TSDB_CODE_SUCCESS && pRead->rpcHandle != NULL && rpcGetConnInfo(pRead->rpcHandle, &connInfo) == 0) {
+      qSetQueryUser(pQInfo, connInfo.user);
+    }
+
     SQueryTableRsp *pRsp = (SQueryTableRsp *)rpcMallocCont(sizeof(SQueryTableRsp));
     pRsp->code = code;
     pRsp->qId  = 0;
@@ -298,13 +320,22 @@ static int32_t vnodeProcessQueryMsg(SVnodeObj *pVnode, SVReadMsg *pRead) {
 
     vTrace("vgId:%d, QInfo:%p, dnode continues to exec query", pVnode->vgId, *qhandle);
 
+    // no slot of the query scheduler, it keeps the qhandle and the vnode until it is resumed
+    atomic_add_fetch_32(&pVnode->refCount, 1);
+    if (!qAcquireExecSlot(qhandle, vnodeResumeQuery, pVnode)) {
+      return TSDB_CODE_SUCCESS;
+    }
+    vnodeRelease(pVnode);
+
     // In the retrieve blocking model, only 50% CPU will be used in query processing
     if (tsRetrieveBlockingModel) {
       qTableQuery(*qhandle, &qId);  // do execute query
+      qReleaseExecSlot(*qhandle);
       qReleaseQInfo(pVnode->qMgmt, (void **)&qhandle, false);
     } else {
       bool freehandle = false;
       bool buildRes = qTableQuery(*qhandle, &qId);  // do execute query
+      qReleaseExecSlot(*qhandle);
 
       // build query rsp, the retrieve request has reached here already
       if (buildRes) {
@@ -56,26 +56,53 @@ int32_t vnodeInitWrite(void) {
 void vnodeCleanupWrite() {}
 
 int32_t vnodeProcessWrite(void *vparam, void *wparam, int32_t qtype, void *rparam) {
+  SVnodeObj *pVnode = vparam;
+
+  pVnode->wversion = pVnode->version;
+  int32_t syncCode = vnodeWriteToWal(vparam, wparam, qtype, rparam);
+  if (syncCode < 0) return syncCode;
+
+  return vnodeApplyWrite(vparam, wparam, qtype, rparam, syncCode);
+}
+
+void vnodeBeginWriteBatch(void *vparam) {
+  SVnodeObj *pVnode = vparam;
+
+  pVnode->wversion = pVnode->version;
+  walBeginBatch(pVnode->wal);
+}
+
+int32_t vnodeEndWriteBatch(void *vparam) {
+  SVnodeObj *pVnode = vparam;
+
+  int32_t code = walEndBatch(pVnode->wal);
+  if (code != 0) {
+    vError("vgId:%d, failed to write wal of batch since %s, wver:%" PRIu64 " vver:%" PRIu64, pVnode->vgId,
+           tstrerror(code), pVnode->wversion, pVnode->version);
+    pVnode->wversion = pVnode->version;
+  }
+
+  return code;
+}
+
+/*
+ * The msg is checked, given a version, forwarded to the peers and written into the wal. It is applied by
+ * vnodeApplyWrite, after its wal record is in the file if the vwrite worker writes the records of a batch together.
+ */
+int32_t vnodeWriteToWal(void *vparam, void *wparam, int32_t qtype, void *rparam) {
   int32_t    code = 0;
   SVnodeObj *pVnode = vparam;
   SWalHead * pHead = wparam;
   SVWriteMsg*pWrite = rparam;
 
-  SRspRet *pRspRet = NULL;
-  if (pWrite != NULL) pRspRet = &pWrite->rspRet;
-  // if wal and forward write , no need response
-  if( qtype == TAOS_QTYPE_WAL || qtype == TAOS_QTYPE_FWD) {
-    pRspRet = NULL;
-  }   
-
   if (vnodeProcessWriteMsgFp[pHead->msgType] == NULL) {
     vError("vgId:%d, msg:%s not processed since no handle, qtype:%s hver:%" PRIu64, pVnode->vgId,
            taosMsg[pHead->msgType], qtypeStr[qtype], pHead->version);
     return TSDB_CODE_VND_MSG_NOT_PROCESSED;
   }
 
-  vTrace("vgId:%d, msg:%s will be processed in vnode, qtype:%s hver:%" PRIu64 " vver:%" PRIu64, pVnode->vgId,
-         taosMsg[pHead->msgType], qtypeStr[qtype], pHead->version, pVnode->version);
+  vTrace("vgId:%d, msg:%s will be processed in vnode, qtype:%s hver:%" PRIu64 " vver:%" PRIu64 " wver:%" PRIu64,
+         pVnode->vgId, taosMsg[pHead->msgType], qtypeStr[qtype], pHead->version, pVnode->version, pVnode->wversion);
 
   if (pHead->version == 0) {  // from client or CQ
     if (!vnodeInReadyStatus(pVnode)) {
@@ -90,11 +117,11 @@ int32_t vnodeProcessWrite(void *vparam, void *wparam, int32_t qtype, void *rpara
       return TSDB_CODE_APP_NOT_READY;
     }
 
-    // assign version
-    pHead->version = pVnode->version + 1;
+    // assign version, the msgs written before in the batch are not applied yet
+    pHead->version = pVnode->wversion + 1;
   } else {  // from wal or forward
     // for data from WAL or forward, version may be smaller
-    if (pHead->version <= pVnode->version) return 0;
+    if (pHead->version <= pVnode->wversion) return 0;
   }
 
   // forward to peers, even it is WAL/FWD, it shall be called to update version in sync
@@ -117,6 +144,27 @@ int32_t vnodeProcessWrite(void *vparam, void *wparam, int32_t qtype, void *rpara
     return code;
   }
 
+  pVnode->wversion = pHead->version;
+  return syncCode;
+}
+
+// syncCode is what vnodeWriteToWal returned for the msg
+int32_t vnodeApplyWrite(void *vparam, void *wparam, int32_t qtype, void *rparam, int32_t syncCode) {
+  int32_t    code = 0;
+  SVnodeObj *pVnode = vparam;
+  SWalHead * pHead = wparam;
+  SVWriteMsg*pWrite = rparam;
+
+  SRspRet *pRspRet = NULL;
+  if (pWrite != NULL) pRspRet = &pWrite->rspRet;
+  // if wal and forward write , no need response
+  if( qtype == TAOS_QTYPE_WAL || qtype == TAOS_QTYPE_FWD) {
+    pRspRet = NULL;
+  }
+
+  // skipped by vnodeWriteToWal, or applied before in the batch
+  if (pHead->version <= pVnode->version) return syncCode;
+
   pVnode->version = pHead->version;
 
   // write data locally
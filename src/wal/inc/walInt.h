@@ -39,6 +39,7 @@ extern int32_t wDebugFlag;
 #define WAL_PATH_LEN   (TSDB_FILENAME_LEN + 12)
 #define WAL_FILE_LEN   (WAL_PATH_LEN + 32)
 #define WAL_FILE_NUM   1 // 3
+#define WAL_BATCH_SIZE (1024 * 1024)
 
 typedef struct {
   uint64_t version;
@@ -51,7 +52,13 @@ typedef struct {
   int32_t  fsyncPeriod;
   int32_t  fsyncSeq;
   int8_t   stop;
-  int8_t   reserved[3];
+  int8_t   batch;     // the records are kept in buf until the batch ends
+  int8_t   reserved[2];
+  int32_t  bufLen;    // bytes of the records kept
+  int32_t  bufSize;
+  int32_t  bufWritten;// bytes of the records kept that are in the file
+  uint64_t bufVer;    // version of the last record written into the file
+  char *   buf;       // the records of the last batch, kept until the next one begins
   char     path[WAL_PATH_LEN];
   char     name[WAL_FILE_LEN];
   pthread_mutex_t mutex;
@@ -60,6 +67,7 @@ typedef struct {
 int32_t walGetNextFile(SWal *pWal, int64_t *nextFileId);
 int32_t walGetOldFile(SWal *pWal, int64_t curFileId, int32_t minDiff, int64_t *oldFileId);
 int32_t walGetNewFile(SWal *pWal, int64_t *newFileId);
+int32_t walWriteBatch(SWal *pWal);
 
 #ifdef __cplusplus
 }
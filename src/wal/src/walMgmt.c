@@ -133,6 +133,7 @@ void walClose(void *handle) {
 
   SWal *pWal = handle;
   pthread_mutex_lock(&pWal->mutex);
+  walWriteBatch(pWal);
   tfClose(pWal->tfd);
   pthread_mutex_unlock(&pWal->mutex);
   taosRemoveRef(tsWal.refId, pWal->rid);
@@ -154,6 +155,7 @@ static void walFreeObj(void *wal) {
 
   tfClose(pWal->tfd);
   pthread_mutex_destroy(&pWal->mutex);
+  tfree(pWal->buf);
   tfree(pWal);
 }
 
@@ -58,6 +58,16 @@ int32_t walRenew(void *handle) {
     wError("vgId:%d, file:%s, failed to open since %s", pWal->vgId, pWal->name, strerror(errno));
   } else {
     wDebug("vgId:%d, file:%s, it is created and open while renew", pWal->vgId, pWal->name);
+
+    // the msgs of the last batch may be applied after the commit starts, so their records go into the new file too,
+    // the ones already in the old file are skipped by version while restoring
+    if (pWal->bufWritten > 0) {
+      if (tfWrite(pWal->tfd, pWal->buf, pWal->bufWritten) != pWal->bufWritten) {
+        code = TAOS_SYSTEM_ERROR(errno);
+        wError("vgId:%d, file:%s, failed to write %d bytes of batch while renew since %s", pWal->vgId, pWal->name,
+               pWal->bufWritten, strerror(errno));
+      }
+    }
   }
 
   pthread_mutex_unlock(&pWal->mutex);
@@ -96,7 +106,9 @@ void walRemoveAllOldFiles(void *handle) {
   int64_t fileId = -1;
 
   pthread_mutex_lock(&pWal->mutex);
-  
+
+  pWal->bufLen = 0;
+  pWal->bufWritten = 0;
   tfClose(pWal->tfd);
   wDebug("vgId:%d, file:%s, it is closed before remove all wals", pWal->vgId, pWal->name);
 
@@ -157,6 +169,31 @@ int32_t walWrite(void *handle, SWalHead *pHead) {
 
   pthread_mutex_lock(&pWal->mutex);
 
+  // the record is copied, since the msg may be converted in place while it is applied
+  if (pWal->batch) {
+    if (pWal->bufLen + contLen > pWal->bufSize) {
+      int32_t size = MAX(pWal->bufSize, WAL_BATCH_SIZE);
+      while (size < pWal->bufLen + contLen) size *= 2;
+
+      char *buf = realloc(pWal->buf, size);
+      if (buf == NULL) {
+        pthread_mutex_unlock(&pWal->mutex);
+        return TSDB_CODE_COM_OUT_OF_MEMORY;
+      }
+      pWal->buf = buf;
+      pWal->bufSize = size;
+    }
+
+    memcpy(pWal->buf + pWal->bufLen, pHead, contLen);
+    pWal->bufLen += contLen;
+    wTrace("vgId:%d, buffer wal, fileId:%" PRId64 " tfd:%" PRId64 " hver:%" PRId64 " wver:%" PRIu64 " len:%d",
+           pWal->vgId, pWal->fileId, pWal->tfd, pHead->version, pWal->version, pHead->len);
+    pWal->version = pHead->version;
+
+    pthread_mutex_unlock(&pWal->mutex);
+    return code;
+  }
+
   if (tfWrite(pWal->tfd, pHead, contLen) != contLen) {
     code = TAOS_SYSTEM_ERROR(errno);
     wError("vgId:%d, file:%s, failed to write since %s", pWal->vgId, pWal->name, strerror(errno));
@@ -173,6 +210,68 @@ int32_t walWrite(void *handle, SWalHead *pHead) {
   return code;
 }
 
+/*
+ * The records written between walBeginBatch and walEndBatch are kept in memory and written into the file with one
+ * write when the batch ends, so the msgs of a batch are applied only after walEndBatch succeeds. The records stay in
+ * memory until the next batch begins, and are written into the new file as well if the file is renewed meanwhile.
+ * If walEndBatch fails, none of the records is in the file and the version of the wal goes back to the one before.
+ */
+void walBeginBatch(void *handle) {
+  SWal *pWal = handle;
+  if (pWal == NULL) return;
+
+  pthread_mutex_lock(&pWal->mutex);
+  if (pWal->bufSize > WAL_BATCH_SIZE) {
+    // do not hold the memory of an unusually large batch
+    tfree(pWal->buf);
+    pWal->bufSize = 0;
+  }
+  pWal->batch = 1;
+  pWal->bufLen = 0;
+  pWal->bufWritten = 0;
+  pWal->bufVer = pWal->version;
+  pthread_mutex_unlock(&pWal->mutex);
+}
+
+int32_t walEndBatch(void *handle) {
+  SWal *pWal = handle;
+  if (pWal == NULL) return 0;
+
+  pthread_mutex_lock(&pWal->mutex);
+  int32_t code = walWriteBatch(pWal);
+  pWal->batch = 0;
+  pthread_mutex_unlock(&pWal->mutex);
+
+  return code;
+}
+
+// the mutex is held
+int32_t walWriteBatch(SWal *pWal) {
+  int32_t code = 0;
+  int32_t len = pWal->bufLen - pWal->bufWritten;
+  if (len <= 0) return 0;
+
+  if (!tfValid(pWal->tfd)) {
+    code = TSDB_CODE_WAL_APP_ERROR;
+  } else if (tfWrite(pWal->tfd, pWal->buf + pWal->bufWritten, len) != len) {
+    code = TAOS_SYSTEM_ERROR(errno);
+    wError("vgId:%d, file:%s, failed to write %d bytes of batch since %s", pWal->vgId, pWal->name, len,
+           strerror(errno));
+  }
+
+  if (code != 0) {
+    pWal->bufLen = pWal->bufWritten;
+    pWal->version = pWal->bufVer;
+    return code;
+  }
+
+  wTrace("vgId:%d, write wal batch, fileId:%" PRId64 " tfd:%" PRId64 " wver:%" PRIu64 " len:%d", pWal->vgId,
+         pWal->fileId, pWal->tfd, pWal->version, len);
+  pWal->bufWritten = pWal->bufLen;
+  pWal->bufVer = pWal->version;
+  return 0;
+}
+
 void walFsync(void *handle, bool forceFsync) {
   SWal *pWal = handle;
   if (pWal == NULL || !tfValid(pWal->tfd)) return;
@@ -203,6 +302,8 @@ int32_t walRestore(void *handle, void *pVnode, FWalWrite writeFp) {
     code = walRestoreWalFile(pWal, pVnode, writeFp, walName, fileId);
     if (code != TSDB_CODE_SUCCESS) {
       wError("vgId:%d, file:%s, failed to restore since %s", pWal->vgId, walName, tstrerror(code));
+      // the records after the one that could not be replayed are still in the file, the restore fails
+      if (code == TSDB_CODE_COM_OUT_OF_MEMORY) return code;
       continue;
     }
 
@@ -417,7 +518,97 @@ static int walSMemRowCheck(SWalHead *pHead) {
   return 0;
 }
 
-static int32_t walRestoreWalFile(SWal *pWal, void *pVnode, FWalWrite writeFp, char *name, int64_t fileId) {
+#define WAL_REPLAY_QUEUE_SIZE  1024
+#define WAL_REPLAY_BUFFER_SIZE (16 * 1024 * 1024)
+
+/*
+ * The records of a wal file are read and validated by a reader thread, and applied by the thread restoring the vnode.
+ * At most WAL_REPLAY_QUEUE_SIZE records or WAL_REPLAY_BUFFER_SIZE bytes are read ahead of the one being applied.
+ */
+typedef struct {
+  SWal *          pWal;
+  void *          pVnode;
+  FWalWrite *     writeFp;
+  char *          name;
+  int64_t         fileId;
+  int64_t         tfd;
+  bool            direct;  // the records are applied by the reader if the thread fails to start
+  bool            done;
+  int32_t         code;
+  int32_t         first;
+  int32_t         num;
+  int64_t         size;
+  SWalHead *      records[WAL_REPLAY_QUEUE_SIZE];
+  pthread_mutex_t mutex;
+  pthread_cond_t  notEmpty;
+  pthread_cond_t  notFull;
+} SWalReplay;
+
+static void walApplyReplay(SWalReplay *pReplay, SWalHead *pHead) {
+  pReplay->pWal->version = pHead->version;
+  (*pReplay->writeFp)(pReplay->pVnode, pHead, TAOS_QTYPE_WAL, NULL);
+}
+
+static int32_t walPutReplay(SWalReplay *pReplay, SWalHead *pHead) {
+  if (pReplay->direct) {
+    walApplyReplay(pReplay, pHead);
+    return TSDB_CODE_SUCCESS;
+  }
+
+  int32_t   contLen = sizeof(SWalHead) + pHead->len;
+  SWalHead *pRecord = malloc(contLen);
+  if (pRecord == NULL) {
+    wError("vgId:%d, file:%s, failed to replay hver:%" PRIu64 " since no memory", pReplay->pWal->vgId, pReplay->name,
+           pHead->version);
+    return TSDB_CODE_COM_OUT_OF_MEMORY;
+  }
+  memcpy(pRecord, pHead, contLen);
+
+  pthread_mutex_lock(&pReplay->mutex);
+
+  while (pReplay->num >= WAL_REPLAY_QUEUE_SIZE ||
+         (pReplay->num > 0 && pReplay->size + contLen > WAL_REPLAY_BUFFER_SIZE)) {
+    pthread_cond_wait(&pReplay->notFull, &pReplay->mutex);
+  }
+
+  pReplay->records[(pReplay->first + pReplay->num) % WAL_REPLAY_QUEUE_SIZE] = pRecord;
+  pReplay->num++;
+  pReplay->size += contLen;
+
+  pthread_cond_signal(&pReplay->notEmpty);
+  pthread_mutex_unlock(&pReplay->mutex);
+
+  return TSDB_CODE_SUCCESS;
+}
+
+// return NULL once all records of the file are taken
+static SWalHead *walGetReplay(SWalReplay *pReplay) {
+  pthread_mutex_lock(&pReplay->mutex);
+
+  while (pReplay->num == 0 && !pReplay->done) {
+    pthread_cond_wait(&pReplay->notEmpty, &pReplay->mutex);
+  }
+
+  SWalHead *pRecord = NULL;
+  if (pReplay->num > 0) {
+    pRecord = pReplay->records[pReplay->first];
+    pReplay->first = (pReplay->first + 1) % WAL_REPLAY_QUEUE_SIZE;
+    pReplay->num--;
+    pReplay->size -= sizeof(SWalHead) + pRecord->len;
+    pthread_cond_signal(&pReplay->notFull);
+  }
+
+  pthread_mutex_unlock(&pReplay->mutex);
+
+  return pRecord;
+}
+
+static int32_t walReadWalFile(SWalReplay *pReplay) {
+  SWal *  pWal = pReplay->pWal;
+  char *  name = pReplay->name;
+  int64_t fileId = pReplay->fileId;
+  int64_t tfd = pReplay->tfd;
+
   int32_t size = WAL_MAX_SIZE;
   void *  buffer = tmalloc(size);
   if (buffer == NULL) {
@@ -425,15 +616,6 @@ static int32_t walRestoreWalFile(SWal *pWal, void *pVnode, FWalWrite writeFp, ch
     return TAOS_SYSTEM_ERROR(errno);
   }
 
-  int64_t tfd = tfOpen(name, O_RDWR);
-  if (!tfValid(tfd)) {
-    wError("vgId:%d, file:%s, failed to open for restore since %s", pWal->vgId, name, strerror(errno));
-    tfree(buffer);
-    return TAOS_SYSTEM_ERROR(errno);
-  } else {
-    wDebug("vgId:%d, file:%s, open for restore", pWal->vgId, name);
-  }
-
   int32_t   code = TSDB_CODE_SUCCESS;
   int64_t   offset = 0;
   SWalHead *pHead = buffer;
@@ -538,21 +720,85 @@ static int32_t walRestoreWalFile(SWal *pWal, void *pVnode, FWalWrite writeFp, ch
     wTrace("vgId:%d, restore wal, fileId:%" PRId64 " hver:%" PRIu64 " wver:%" PRIu64 " len:%d offset:%" PRId64,
            pWal->vgId, fileId, pHead->version, pWal->version, pHead->len, offset);
 
-    pWal->version = pHead->version;
-
     // wInfo("writeFp: %ld", offset);
     if (0 != walSMemRowCheck(pHead)) {
       wError("vgId:%d, restore wal, fileId:%" PRId64 " hver:%" PRIu64 " wver:%" PRIu64 " len:%d offset:%" PRId64,
              pWal->vgId, fileId, pHead->version, pWal->version, pHead->len, offset);
-      tfClose(tfd);
-      tfree(buffer);
-      return TAOS_SYSTEM_ERROR(errno);
+      code = TAOS_SYSTEM_ERROR(errno);
+      break;
     }
-    (*writeFp)(pVnode, pHead, TAOS_QTYPE_WAL, NULL);
+
+    code = walPutReplay(pReplay, pHead);
+    if (code != TSDB_CODE_SUCCESS) break;
   }
 
-  tfClose(tfd);
   tfree(buffer);
+  return code;
+}
+
+static void *walReadWalFileFunc(void *param) {
+  SWalReplay *pReplay = param;
+  setThreadName("walReplay");
+
+  int32_t code = walReadWalFile(pReplay);
+
+  pthread_mutex_lock(&pReplay->mutex);
+  pReplay->code = code;
+  pReplay->done = true;
+  pthread_cond_signal(&pReplay->notEmpty);
+  pthread_mutex_unlock(&pReplay->mutex);
+
+  return NULL;
+}
+
+static int32_t walRestoreWalFile(SWal *pWal, void *pVnode, FWalWrite writeFp, char *name, int64_t fileId) {
+  int64_t tfd = tfOpen(name, O_RDWR);
+  if (!tfValid(tfd)) {
+    wError("vgId:%d, file:%s, failed to open for restore since %s", pWal->vgId, name, strerror(errno));
+    return TAOS_SYSTEM_ERROR(errno);
+  } else {
+    wDebug("vgId:%d, file:%s, open for restore", pWal->vgId, name);
+  }
+
+  SWalReplay *pReplay = calloc(1, sizeof(SWalReplay));
+  if (pReplay == NULL) {
+    tfClose(tfd);
+    return TAOS_SYSTEM_ERROR(errno);
+  }
+
+  pReplay->pWal = pWal;
+  pReplay->pVnode = pVnode;
+  pReplay->writeFp = writeFp;
+  pReplay->name = name;
+  pReplay->fileId = fileId;
+  pReplay->tfd = tfd;
+  pthread_mutex_init(&pReplay->mutex, NULL);
+  pthread_cond_init(&pReplay->notEmpty, NULL);
+  pthread_cond_init(&pReplay->notFull, NULL);
+
+  int32_t   code = TSDB_CODE_SUCCESS;
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, walReadWalFileFunc, pReplay) != 0) {
+    wWarn("vgId:%d, file:%s, failed to create replay thread since %s, restore it directly", pWal->vgId, name,
+          strerror(errno));
+    pReplay->direct = true;
+    code = walReadWalFile(pReplay);
+  } else {
+    SWalHead *pRecord = NULL;
+    while ((pRecord = walGetReplay(pReplay)) != NULL) {
+      walApplyReplay(pReplay, pRecord);
+      free(pRecord);
+    }
+
+    pthread_join(thread, NULL);
+    code = pReplay->code;
+  }
+
+  pthread_cond_destroy(&pReplay->notFull);
+  pthread_cond_destroy(&pReplay->notEmpty);
+  pthread_mutex_destroy(&pReplay->mutex);
+  free(pReplay);
+  tfClose(tfd);
 
   wDebug("vgId:%d, file:%s, it is closed after restore", pWal->vgId, name);
   return code;
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "taosmsg.h"
+#include "tutil.h"
+#include "tlog.h"
+#include "twal.h"
+#include "tfile.h"
+
+/*
+ * Report the records/sec of appending to the wal at walLevel 1 and 2, the way the vwrite worker does: the records of
+ * a batch are written one by one or kept and written together, then the wal is fsynced once if walLevel is 2.
+ *
+ * usage: walBench [records] [record size] [records per batch] [path]
+ *
+ * The log is written into [path].log, /tmp/walBench.log by default.
+ */
+
+static uint64_t ver = 0;
+
+static double runBench(char *path, int32_t level, bool batch, int32_t records, int32_t size, int32_t batchSize) {
+  SWalCfg walCfg = {0};
+  walCfg.walLevel = level;
+  walCfg.fsyncPeriod = 0;
+  walCfg.keep = TAOS_WAL_NOT_KEEP;
+
+  void *pWal = walOpen(path, &walCfg);
+  if (pWal == NULL || walRenew(pWal) != 0) {
+    printf("failed to open wal at %s\n", path);
+    exit(-1);
+  }
+
+  int32_t   contLen = sizeof(SWalHead) + size;
+  SWalHead *pHead = calloc(1, contLen);
+  pHead->msgType = TSDB_MSG_TYPE_SUBMIT;
+  pHead->len = size;
+
+  int64_t st = taosGetTimestampUs();
+
+  for (int32_t i = 0; i < records; i += batchSize) {
+    if (batch) walBeginBatch(pWal);
+
+    for (int32_t k = i; k < records && k < i + batchSize; ++k) {
+      memset(pHead->cont, k, size);
+      pHead->version = ++ver;
+      if (walWrite(pWal, pHead) != 0) {
+        printf("failed to write wal\n");
+        exit(-1);
+      }
+    }
+
+    if (batch && walEndBatch(pWal) != 0) {
+      printf("failed to write wal batch\n");
+      exit(-1);
+    }
+
+    walFsync(pWal, false);
+  }
+
+  int64_t el = taosGetTimestampUs() - st;
+
+  free(pHead);
+  walRemoveAllOldFiles(pWal);
+  walClose(pWal);
+
+  return records * 1000000.0 / MAX(el, 1);
+}
+
+int main(int argc, char *argv[]) {
+  int32_t records = (argc > 1) ? atoi(argv[1]) : 200000;
+  int32_t size = (argc > 2) ? atoi(argv[2]) : 256;
+  int32_t batchSize = (argc > 3) ? atoi(argv[3]) : 64;
+  char *  path = (argc > 4) ? argv[4] : "/tmp/walBench";
+
+  if (records <= 0 || size <= 0 || batchSize <= 0) {
+    printf("usage: %s [records] [record size] [records per batch] [path]\n", argv[0]);
+    return -1;
+  }
+
+  // the log goes next to the wal directory instead of the working directory
+  char logName[PATH_MAX] = {0};
+  snprintf(logName, sizeof(logName), "%s.log", path);
+  taosInitLog(logName, 100000, 10);
+  tfInit();
+  walInit();
+
+  printf("%d records of %d bytes, %d records per batch\n", records, size, batchSize);
+
+  for (int32_t level = TAOS_WAL_WRITE; level <= TAOS_WAL_FSYNC; ++level) {
+    // fsync is much slower, so fewer records are written
+    int32_t num = (level == TAOS_WAL_FSYNC) ? MAX(records / 20, batchSize) : records;
+
+    for (int32_t m = 0; m < 2; ++m) {
+      // take the best of several runs to reduce the noise
+      double best = 0;
+      for (int32_t r = 0; r < 3; ++r) {
+        best = MAX(best, runBench(path, level, m == 1, num, size, batchSize));
+      }
+
+      printf("walLevel:%d %-6s %12.0f records/sec\n", level, (m == 0) ? "single" : "batch", best);
+    }
+  }
+
+  walCleanUp();
+  tfCleanup();
+
+  return 0;
+}
@@ -0,0 +1,193 @@
+#include "os.h"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <vector>
+
+#include "taosmsg.h"
+#include "tfile.h"
+#include "tlog.h"
+#include "twal.h"
+
+namespace {
+
+const char *walTestPath = "/tmp/walTest";
+
+// applied the way the vnode does: the records whose version is not newer are skipped
+struct SReplayed {
+  uint64_t              version;
+  std::vector<uint64_t> versions;
+  bool                  corrupted;
+};
+
+int32_t replayRecord(void *ahandle, void *param, int32_t qtype, void *pMsg) {
+  SReplayed *pReplayed = (SReplayed *)ahandle;
+  SWalHead * pHead = (SWalHead *)param;
+
+  if (pHead->version <= pReplayed->version) return 0;
+
+  for (int32_t i = 0; i < pHead->len; ++i) {
+    if (pHead->cont[i] != (char)(pHead->version + i)) pReplayed->corrupted = true;
+  }
+
+  pReplayed->version = pHead->version;
+  pReplayed->versions.push_back(pHead->version);
+  return 0;
+}
+
+SWalHead *newRecord(int32_t maxLen) {
+  SWalHead *pHead = (SWalHead *)calloc(1, sizeof(SWalHead) + maxLen);
+  pHead->msgType = TSDB_MSG_TYPE_MD_CREATE_TABLE;
+  return pHead;
+}
+
+int32_t writeRecord(void *pWal, SWalHead *pHead, uint64_t version, int32_t len) {
+  pHead->version = version;
+  pHead->len = len;
+  for (int32_t i = 0; i < len; ++i) pHead->cont[i] = (char)(version + i);
+  return walWrite(pWal, pHead);
+}
+
+void *openWal() {
+  SWalCfg walCfg = {0};
+  walCfg.walLevel = TAOS_WAL_WRITE;
+  walCfg.keep = TAOS_WAL_NOT_KEEP;
+  return walOpen((char *)walTestPath, &walCfg);
+}
+
+void restoreWal(SReplayed *pReplayed) {
+  void *pWal = openWal();
+  ASSERT_NE(pWal, nullptr);
+
+  pReplayed->version = 0;
+  pReplayed->versions.clear();
+  pReplayed->corrupted = false;
+  ASSERT_EQ(walRestore(pWal, pReplayed, replayRecord), 0);
+
+  walRemoveAllOldFiles(pWal);
+  walClose(pWal);
+}
+
+class WalTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() {
+    taosRemoveDir((char *)walTestPath);
+    tfInit();
+    walInit();
+  }
+
+  static void TearDownTestCase() {
+    walCleanUp();
+    tfCleanup();
+    taosRemoveDir((char *)walTestPath);
+  }
+};
+
+}  // namespace
+
+// more records and bytes than the reader thread keeps ahead, of varied size
+TEST_F(WalTest, replayInOrder) {
+  void *pWal = openWal();
+  ASSERT_NE(pWal, nullptr);
+  ASSERT_EQ(walRenew(pWal), 0);
+
+  const int32_t numOfRecords = 3000;
+  SWalHead *    pHead = newRecord(16384);
+  for (int32_t i = 1; i <= numOfRecords; ++i) {
+    ASSERT_EQ(writeRecord(pWal, pHead, i, (i * 37) % 16384), 0);
+  }
+  free(pHead);
+  walClose(pWal);
+
+  SReplayed replayed;
+  restoreWal(&replayed);
+
+  ASSERT_FALSE(replayed.corrupted);
+  ASSERT_EQ(replayed.versions.size(), numOfRecords);
+  for (int32_t i = 0; i < numOfRecords; ++i) {
+    ASSERT_EQ(replayed.versions[i], i + 1);
+  }
+}
+
+// a tail cut in the middle of a record is truncated, the records before it are replayed
+TEST_F(WalTest, replayTruncatedTail) {
+  void *pWal = openWal();
+  ASSERT_NE(pWal, nullptr);
+  ASSERT_EQ(walRenew(pWal), 0);
+
+  SWalHead *pHead = newRecord(1024);
+  for (int32_t i = 1; i <= 100; ++i) {
+    ASSERT_EQ(writeRecord(pWal, pHead, i, 1024), 0);
+  }
+  free(pHead);
+
+  char    name[TSDB_FILENAME_LEN] = {0};
+  int64_t fileId = 0;
+  ASSERT_EQ(walGetWalFile(pWal, name, &fileId), 0);
+  walClose(pWal);
+
+  char path[TSDB_FILENAME_LEN * 2] = {0};
+  snprintf(path, sizeof(path), "%s/wal%" PRId64, walTestPath, fileId);
+  ASSERT_EQ(truncate(path, 99 * (sizeof(SWalHead) + 1024) + 100), 0);
+
+  SReplayed replayed;
+  restoreWal(&replayed);
+
+  ASSERT_FALSE(replayed.corrupted);
+  ASSERT_EQ(replayed.versions.size(), 99);
+  ASSERT_EQ(replayed.versions.back(), 99);
+}
+
+// the records of a batch are in the new file as well if the wal is renewed while the batch is applied
+TEST_F(WalTest, batchRenew) {
+  void *pWal = openWal();
+  ASSERT_NE(pWal, nullptr);
+  ASSERT_EQ(walRenew(pWal), 0);
+
+  SWalHead *pHead = newRecord(512);
+  walBeginBatch(pWal);
+  for (int32_t i = 1; i <= 10; ++i) {
+    ASSERT_EQ(writeRecord(pWal, pHead, i, 512), 0);
+  }
+  ASSERT_EQ(walEndBatch(pWal), 0);
+
+  // a commit starts, then finishes and removes the old file
+  ASSERT_EQ(walRenew(pWal), 0);
+  walRemoveOneOldFile(pWal);
+
+  ASSERT_EQ(writeRecord(pWal, pHead, 11, 512), 0);
+  free(pHead);
+  walClose(pWal);
+
+  SReplayed replayed;
+  restoreWal(&replayed);
+
+  ASSERT_FALSE(replayed.corrupted);
+  ASSERT_EQ(replayed.versions.size(), 11);
+  for (int32_t i = 0; i < 11; ++i) {
+    ASSERT_EQ(replayed.versions[i], i + 1);
+  }
+}
+
+// a batch is in the file only after it ends
+TEST_F(WalTest, batchWrittenOnEnd) {
+  void *pWal = openWal();
+  ASSERT_NE(pWal, nullptr);
+  ASSERT_EQ(walRenew(pWal), 0);
+
+  SWalHead *pHead = newRecord(128);
+  walBeginBatch(pWal);
+  for (int32_t i = 1; i <= 5; ++i) {
+    ASSERT_EQ(writeRecord(pWal, pHead, i, 128), 0);
+  }
+  ASSERT_EQ(walGetVersion(pWal), 5);
+  ASSERT_EQ(walGetFSize(pWal), 0);
+
+  ASSERT_EQ(walEndBatch(pWal), 0);
+  ASSERT_EQ(walGetFSize(pWal), 5 * (sizeof(SWalHead) + 128));
+  free(pHead);
+  walClose(pWal);
+
+  SReplayed replayed;
+  restoreWal(&replayed);
+  ASSERT_EQ(replayed.versions.size(), 5);
+}